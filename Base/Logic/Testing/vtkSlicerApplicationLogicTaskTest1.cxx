@@ -0,0 +1,224 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// Slicer includes
+#include "vtkSlicerApplicationLogic.h"
+#include "vtkSlicerTask.h"
+
+// MRML includes
+#include <vtkMRMLAbstractLogic.h>
+
+// VTK includes
+#include <vtkNew.h>
+#include <vtkObjectFactory.h>
+
+// ITK includes
+#include <itkMutexLock.h>
+
+// ITKSYS includes
+#include <itksys/SystemTools.hxx>
+
+// STD includes
+#include <vector>
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+class vtkTaskTestLogic : public vtkMRMLAbstractLogic
+{
+public:
+  static vtkTaskTestLogic *New();
+  vtkTypeMacro(vtkTaskTestLogic, vtkMRMLAbstractLogic);
+
+  /// Record the id of the task. Task 0 blocks until Released is set.
+  void RunTask(void* clientData)
+  {
+    int taskId = static_cast<int>(reinterpret_cast<size_t>(clientData));
+    if (taskId == 0)
+      {
+      this->Lock->Lock();
+      this->Started = true;
+      this->Lock->Unlock();
+      while (!this->IsReleased())
+        {
+        itksys::SystemTools::Delay(1);
+        }
+      }
+    this->Lock->Lock();
+    this->ExecutedTasks.push_back(taskId);
+    this->Lock->Unlock();
+  }
+
+  bool IsReleased()
+  {
+    this->Lock->Lock();
+    bool released = this->Released;
+    this->Lock->Unlock();
+    return released;
+  }
+
+  itk::MutexLock::Pointer Lock;
+  std::vector<int> ExecutedTasks;
+  bool Started;
+  bool Released;
+
+protected:
+  vtkTaskTestLogic()
+  {
+    this->Lock = itk::MutexLock::New();
+    this->Started = false;
+    this->Released = false;
+  }
+  ~vtkTaskTestLogic() {}
+};
+
+vtkStandardNewMacro(vtkTaskTestLogic);
+
+//----------------------------------------------------------------------------
+vtkSmartPointer<vtkSlicerTask> CreateTask(vtkTaskTestLogic* logic, int taskId,
+                                          int type, int priority)
+{
+  vtkSmartPointer<vtkSlicerTask> task = vtkSmartPointer<vtkSlicerTask>::New();
+  task->SetType(type);
+  task->SetPriority(priority);
+  task->SetTaskFunction(logic, (vtkSlicerTask::TaskFunctionPointer)
+                        &vtkTaskTestLogic::RunTask,
+                        reinterpret_cast<void*>(static_cast<size_t>(taskId)));
+  return task;
+}
+
+//----------------------------------------------------------------------------
+// Wait up to 10 seconds for the logic to have executed numberOfTasks tasks.
+bool WaitForTasks(vtkTaskTestLogic* logic, size_t numberOfTasks)
+{
+  for (int i = 0; i < 10000; ++i)
+    {
+    logic->Lock->Lock();
+    size_t executed = logic->ExecutedTasks.size();
+    logic->Lock->Unlock();
+    if (executed >= numberOfTasks)
+      {
+      return true;
+      }
+    itksys::SystemTools::Delay(1);
+    }
+  return false;
+}
+
+}
+
+//----------------------------------------------------------------------------
+int vtkSlicerApplicationLogicTaskTest1(int vtkNotUsed(argc), char * vtkNotUsed(argv)[])
+{
+  vtkNew<vtkSlicerApplicationLogic> appLogic;
+  vtkNew<vtkTaskTestLogic> logic;
+
+  // Tasks can't be scheduled before the threads are created
+  vtkSmartPointer<vtkSlicerTask> task =
+    CreateTask(logic.GetPointer(), 1, vtkSlicerTask::Processing, 0);
+  if (appLogic->ScheduleTask(task))
+    {
+    std::cerr << "Line " << __LINE__ << " - ScheduleTask should fail when "
+              << "the processing thread is not created" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  appLogic->CreateProcessingThread();
+
+  // Block the processing thread with task 0
+  if (!appLogic->ScheduleTask(
+        CreateTask(logic.GetPointer(), 0, vtkSlicerTask::Processing, 0)))
+    {
+    std::cerr << "Line " << __LINE__ << " - ScheduleTask failed" << std::endl;
+    return EXIT_FAILURE;
+    }
+  bool started = false;
+  for (int i = 0; i < 10000 && !started; ++i)
+    {
+    logic->Lock->Lock();
+    started = logic->Started;
+    logic->Lock->Unlock();
+    itksys::SystemTools::Delay(1);
+    }
+  if (!started)
+    {
+    std::cerr << "Line " << __LINE__ << " - Task 0 did not start" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Queue tasks with different priorities while the processing thread is busy
+  vtkSmartPointer<vtkSlicerTask> canceledTask =
+    CreateTask(logic.GetPointer(), 4, vtkSlicerTask::Processing, 5);
+  appLogic->ScheduleTask(CreateTask(logic.GetPointer(), 1, vtkSlicerTask::Processing, 0));
+  appLogic->ScheduleTask(CreateTask(logic.GetPointer(), 2, vtkSlicerTask::Processing, 10));
+  appLogic->ScheduleTask(canceledTask);
+  appLogic->ScheduleTask(CreateTask(logic.GetPointer(), 3, vtkSlicerTask::Processing, 0));
+  if (appLogic->GetNumberOfScheduledTasks(vtkSlicerTask::Processing) != 4)
+    {
+    std::cerr << "Line " << __LINE__ << " - Wrong number of scheduled tasks: "
+              << appLogic->GetNumberOfScheduledTasks(vtkSlicerTask::Processing)
+              << std::endl;
+    return EXIT_FAILURE;
+    }
+  if (!appLogic->CancelTask(canceledTask) ||
+      appLogic->CancelTask(canceledTask))
+    {
+    std::cerr << "Line " << __LINE__ << " - CancelTask failed" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // A networking task must not wait for the busy processing thread
+  appLogic->ScheduleTask(CreateTask(logic.GetPointer(), 5, vtkSlicerTask::Networking, 0));
+  if (!WaitForTasks(logic.GetPointer(), 1))
+    {
+    std::cerr << "Line " << __LINE__ << " - Networking task not executed" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  logic->Lock->Lock();
+  logic->Released = true;
+  logic->Lock->Unlock();
+  if (!WaitForTasks(logic.GetPointer(), 5))
+    {
+    std::cerr << "Line " << __LINE__ << " - Processing tasks not executed" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  appLogic->TerminateProcessingThread();
+
+  int expectedTasks[] = {5, 0, 2, 1, 3};
+  std::vector<int> expected(expectedTasks, expectedTasks + 5);
+  if (logic->ExecutedTasks != expected)
+    {
+    std::cerr << "Line " << __LINE__ << " - Tasks not executed in the expected order:";
+    for (size_t i = 0; i < logic->ExecutedTasks.size(); ++i)
+      {
+      std::cerr << " " << logic->ExecutedTasks[i];
+      }
+    std::cerr << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Tasks can't be scheduled after the threads are terminated
+  if (appLogic->ScheduleTask(task))
+    {
+    std::cerr << "Line " << __LINE__ << " - ScheduleTask should fail when "
+              << "the processing thread is terminated" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  return EXIT_SUCCESS;
+}
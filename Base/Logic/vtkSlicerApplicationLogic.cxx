@@ -35,6 +35,9 @@
 #include <vtkPointData.h>
 #include <vtkPolyData.h>
 
+// ITK includes
+#include <itkConditionVariable.h>
+
 // ITKSYS includes
 #include <itksys/SystemTools.hxx>
 
@@ -47,10 +50,75 @@
 # include <sys/resource.h>
 #endif
 
+#include <deque>
 #include <queue>
 
 //----------------------------------------------------------------------------
-class ProcessingTaskQueue : public std::queue<vtkSmartPointer<vtkSlicerTask> > {};
+// Tasks waiting to be run by the worker threads. There is one queue per
+// worker type so that a networking task never waits behind a processing task
+// (and vice versa). Within a queue, tasks are sorted by decreasing priority
+// and tasks of same priority are run in the order they were scheduled.
+// The mutex protects the queues and the "active" state of the workers, the
+// condition variables are used to wake up the idle workers.
+class ProcessingTaskQueue
+{
+public:
+  typedef std::deque<vtkSmartPointer<vtkSlicerTask> > TaskListType;
+  enum
+    {
+    ProcessingQueue = 0,
+    NetworkingQueue,
+    NumberOfQueues
+    };
+
+  ProcessingTaskQueue()
+  {
+    for (int i = 0; i < NumberOfQueues; ++i)
+      {
+      this->TaskAvailable[i] = itk::ConditionVariable::New();
+      }
+  }
+
+  /// Tasks of undefined type are run by the processing threads.
+  static int GetQueueIndex(int taskType)
+  {
+    return taskType == vtkSlicerTask::Networking ? NetworkingQueue : ProcessingQueue;
+  }
+
+  /// Insert the task after all the tasks of higher or same priority.
+  /// The mutex must be locked.
+  void Push(vtkSlicerTask* task)
+  {
+    TaskListType& tasks = this->Tasks[GetQueueIndex(task->GetType())];
+    TaskListType::iterator it = tasks.begin();
+    while (it != tasks.end() && (*it)->GetPriority() >= task->GetPriority())
+      {
+      ++it;
+      }
+    tasks.insert(it, task);
+  }
+
+  /// Remove the task from its queue. Return false if the task is not queued.
+  /// The mutex must be locked.
+  bool Remove(vtkSlicerTask* task)
+  {
+    for (int i = 0; i < NumberOfQueues; ++i)
+      {
+      TaskListType::iterator it =
+        std::find(this->Tasks[i].begin(), this->Tasks[i].end(), task);
+      if (it != this->Tasks[i].end())
+        {
+        this->Tasks[i].erase(it);
+        return true;
+        }
+      }
+    return false;
+  }
+
+  TaskListType Tasks[NumberOfQueues];
+  itk::ConditionVariable::Pointer TaskAvailable[NumberOfQueues];
+  itk::SimpleMutexLock Mutex;
+};
 class ModifiedQueue : public std::queue<vtkSmartPointer<vtkObject> > {};
 
 //----------------------------------------------------------------------------
@@ -200,10 +268,9 @@ vtkStandardNewMacro(vtkSlicerApplicationLogic);
 vtkSlicerApplicationLogic::vtkSlicerApplicationLogic()
 {
   this->ProcessingThreader = itk::MultiThreader::New();
-  this->ProcessingThreadId = -1;
   this->ProcessingThreadActive = false;
-  this->ProcessingThreadActiveLock = itk::MutexLock::New();
-  this->ProcessingTaskQueueLock = itk::MutexLock::New();
+  this->NumberOfProcessingThreads = 1;
+  this->NumberOfNetworkingThreads = 1;
 
   this->ModifiedQueueActive = false;
   this->ModifiedQueueActiveLock = itk::MutexLock::New();
@@ -227,21 +294,9 @@ vtkSlicerApplicationLogic::vtkSlicerApplicationLogic()
 //----------------------------------------------------------------------------
 vtkSlicerApplicationLogic::~vtkSlicerApplicationLogic()
 {
-  // Note that TerminateThread does not kill a thread, it only waits
-  // for the thread to finish.  We need to signal the thread that we
-  // want to terminate
-  if (this->ProcessingThreadId != -1 && this->ProcessingThreader)
-    {
-    // Signal the processingThread that we are terminating.
-    this->ProcessingThreadActiveLock->Lock();
-    this->ProcessingThreadActive = false;
-    this->ProcessingThreadActiveLock->Unlock();
-
-    // Wait for the thread to finish and clean up the state of the threader
-    this->ProcessingThreader->TerminateThread( this->ProcessingThreadId );
-
-    this->ProcessingThreadId = -1;
-    }
+  // Signal the worker threads that we are terminating and wait for them
+  // to finish.
+  this->TerminateWorkerThreads();
 
   delete this->InternalTaskQueue;
 
@@ -317,41 +372,34 @@ void vtkSlicerApplicationLogic::PrintSelf(ostream& os, vtkIndent indent)
   this->vtkObject::PrintSelf(os, indent);
 
   os << indent << "SlicerApplicationLogic:             " << this->GetClassName() << "\n";
+  os << indent << "NumberOfProcessingThreads: " << this->NumberOfProcessingThreads << "\n";
+  os << indent << "NumberOfNetworkingThreads: " << this->NumberOfNetworkingThreads << "\n";
 }
 
 //----------------------------------------------------------------------------
 void vtkSlicerApplicationLogic::CreateProcessingThread()
 {
-  if (this->ProcessingThreadId == -1)
+  if (this->ProcessingThreadIDs.empty())
     {
-    this->ProcessingThreadActiveLock->Lock();
+    this->InternalTaskQueue->Mutex.Lock();
     this->ProcessingThreadActive = true;
-    this->ProcessingThreadActiveLock->Unlock();
-
-    this->ProcessingThreadId
-      = this->ProcessingThreader
-      ->SpawnThread(vtkSlicerApplicationLogic::ProcessingThreaderCallback,
-                    this);
-
-    // Start four network threads (TODO: make the number of threads a setting)
-    this->NetworkingThreadIDs.push_back ( this->ProcessingThreader
-          ->SpawnThread(vtkSlicerApplicationLogic::NetworkingThreaderCallback,
-                    this) );
-    /*
-     * TODO: it looks like curl is not thread safe by default
-     * - maybe there's a setting that cmcurl can have
-     *   similar to the --enable-threading of the standard curl build
-     *
-    this->NetworkingThreadIDs.push_back ( this->ProcessingThreader
-          ->SpawnThread(vtkSlicerApplicationLogic::NetworkingThreaderCallback,
-                    this) );
-    this->NetworkingThreadIDs.push_back ( this->ProcessingThreader
-          ->SpawnThread(vtkSlicerApplicationLogic::NetworkingThreaderCallback,
-                    this) );
-    this->NetworkingThreadIDs.push_back ( this->ProcessingThreader
-          ->SpawnThread(vtkSlicerApplicationLogic::NetworkingThreaderCallback,
-                    this) );
-    */
+    this->InternalTaskQueue->Mutex.Unlock();
+
+    for (int i = 0; i < this->NumberOfProcessingThreads; ++i)
+      {
+      this->ProcessingThreadIDs.push_back( this->ProcessingThreader
+        ->SpawnThread(vtkSlicerApplicationLogic::ProcessingThreaderCallback,
+                      this) );
+      }
+
+    // Note: it looks like curl is not thread safe by default, this is why
+    // only one networking thread is started by default.
+    for (int i = 0; i < this->NumberOfNetworkingThreads; ++i)
+      {
+      this->NetworkingThreadIDs.push_back( this->ProcessingThreader
+        ->SpawnThread(vtkSlicerApplicationLogic::NetworkingThreaderCallback,
+                      this) );
+      }
 
     // Setup the communication channel back to the main thread
     this->ModifiedQueueActiveLock->Lock();
@@ -374,7 +422,7 @@ void vtkSlicerApplicationLogic::CreateProcessingThread()
 //----------------------------------------------------------------------------
 void vtkSlicerApplicationLogic::TerminateProcessingThread()
 {
-  if (this->ProcessingThreadId != -1)
+  if (!this->ProcessingThreadIDs.empty())
     {
     this->ModifiedQueueActiveLock->Lock();
     this->ModifiedQueueActive = false;
@@ -388,23 +436,37 @@ void vtkSlicerApplicationLogic::TerminateProcessingThread()
     this->WriteDataQueueActive = false;
     this->WriteDataQueueActiveLock->Unlock();
 
-    this->ProcessingThreadActiveLock->Lock();
-    this->ProcessingThreadActive = false;
-    this->ProcessingThreadActiveLock->Unlock();
-
-    this->ProcessingThreader->TerminateThread( this->ProcessingThreadId );
-    this->ProcessingThreadId = -1;
+    this->TerminateWorkerThreads();
+    }
+}
 
-    std::vector<int>::const_iterator idIterator;
-    idIterator = this->NetworkingThreadIDs.begin();
-    while (idIterator != this->NetworkingThreadIDs.end())
-      {
-      this->ProcessingThreader->TerminateThread( *idIterator );
-      ++idIterator;
-      }
-    this->NetworkingThreadIDs.clear();
+//----------------------------------------------------------------------------
+void vtkSlicerApplicationLogic::TerminateWorkerThreads()
+{
+  // Note that TerminateThread does not kill a thread, it only waits
+  // for the thread to finish. Idle threads must be woken up to notice that
+  // they should terminate. Running tasks are not interrupted.
+  this->InternalTaskQueue->Mutex.Lock();
+  this->ProcessingThreadActive = false;
+  for (int i = 0; i < ProcessingTaskQueue::NumberOfQueues; ++i)
+    {
+    this->InternalTaskQueue->TaskAvailable[i]->Broadcast();
+    }
+  this->InternalTaskQueue->Mutex.Unlock();
 
+  std::vector<int>::const_iterator idIterator;
+  for (idIterator = this->ProcessingThreadIDs.begin();
+       idIterator != this->ProcessingThreadIDs.end(); ++idIterator)
+    {
+    this->ProcessingThreader->TerminateThread( *idIterator );
+    }
+  this->ProcessingThreadIDs.clear();
+  for (idIterator = this->NetworkingThreadIDs.begin();
+       idIterator != this->NetworkingThreadIDs.end(); ++idIterator)
+    {
+    this->ProcessingThreader->TerminateThread( *idIterator );
     }
+  this->NetworkingThreadIDs.clear();
 }
 
 //----------------------------------------------------------------------------
@@ -446,48 +508,40 @@ vtkSlicerApplicationLogic
 //----------------------------------------------------------------------------
 void vtkSlicerApplicationLogic::ProcessProcessingTasks()
 {
-  int active = true;
-  vtkSmartPointer<vtkSlicerTask> task = 0;
+  this->ProcessTasks(ProcessingTaskQueue::ProcessingQueue);
+}
 
-  while (active)
+//----------------------------------------------------------------------------
+void vtkSlicerApplicationLogic::ProcessTasks(int queueIndex)
+{
+  ProcessingTaskQueue::TaskListType& tasks =
+    this->InternalTaskQueue->Tasks[queueIndex];
+  itk::ConditionVariable* taskAvailable =
+    this->InternalTaskQueue->TaskAvailable[queueIndex];
+  vtkSmartPointer<vtkSlicerTask> task;
+
+  this->InternalTaskQueue->Mutex.Lock();
+  while (true)
     {
-    // Check to see if we should be shutting down
-    this->ProcessingThreadActiveLock->Lock();
-    active = this->ProcessingThreadActive;
-    this->ProcessingThreadActiveLock->Unlock();
-
-    if (active)
+    // Sleep until a task is scheduled or the thread is terminated
+    while (this->ProcessingThreadActive && tasks.empty())
       {
-      // pull a task off the queue
-      this->ProcessingTaskQueueLock->Lock();
-      if ((*this->InternalTaskQueue).size() > 0)
-        {
-        // std::cout << "Number of queued tasks: " << (*this->InternalTaskQueue).size() << std::endl;
-
-        // only handle processing tasks in this thread
-        task = (*this->InternalTaskQueue).front();
-        if ( task->GetType() == vtkSlicerTask::Processing )
-          {
-          (*this->InternalTaskQueue).pop();
-          }
-        else
-          {
-          task = NULL;
-          }
-        }
-      this->ProcessingTaskQueueLock->Unlock();
-
-      // process the task (should this be in a separate thread?)
-      if (task)
-        {
-        task->Execute();
-        task = 0;
-        }
+      taskAvailable->Wait(&this->InternalTaskQueue->Mutex);
       }
+    if (!this->ProcessingThreadActive)
+      {
+      break;
+      }
+    task = tasks.front();
+    tasks.pop_front();
+    this->InternalTaskQueue->Mutex.Unlock();
+
+    task->Execute();
+    task = 0;
 
-    // busy wait
-    itksys::SystemTools::Delay(100);
+    this->InternalTaskQueue->Mutex.Lock();
     }
+  this->InternalTaskQueue->Mutex.Unlock();
 }
 
 ITK_THREAD_RETURN_TYPE
@@ -528,72 +582,53 @@ vtkSlicerApplicationLogic
 //----------------------------------------------------------------------------
 void vtkSlicerApplicationLogic::ProcessNetworkingTasks()
 {
-  int active = true;
-  vtkSmartPointer<vtkSlicerTask> task = 0;
-
-  while (active)
-    {
-    // Check to see if we should be shutting down
-    this->ProcessingThreadActiveLock->Lock();
-    active = this->ProcessingThreadActive;
-    this->ProcessingThreadActiveLock->Unlock();
-
-    if (active)
-      {
-      // pull a task off the queue
-      this->ProcessingTaskQueueLock->Lock();
-      if ((*this->InternalTaskQueue).size() > 0)
-        {
-        // std::cout << "Number of queued tasks: " << (*this->InternalTaskQueue).size() << std::endl;
-        task = (*this->InternalTaskQueue).front();
-        if ( task->GetType() == vtkSlicerTask::Networking )
-          {
-          (*this->InternalTaskQueue).pop();
-          }
-        else
-          {
-          task = NULL;
-          }
-        }
-      this->ProcessingTaskQueueLock->Unlock();
-
-      // process the task (should this be in a separate thread?)
-      if (task)
-        {
-        task->Execute();
-        task = 0;
-        }
-      }
-
-    // busy wait
-    itksys::SystemTools::Delay(100);
-    }
+  this->ProcessTasks(ProcessingTaskQueue::NetworkingQueue);
 }
 
 //----------------------------------------------------------------------------
 int vtkSlicerApplicationLogic::ScheduleTask( vtkSlicerTask *task )
 {
-  int active;
+  if (!task)
+    {
+    return false;
+    }
 
-  // std::cout << "Scheduling a task ";
+  // only schedule a task if the processing threads are up
+  bool scheduled = false;
+  this->InternalTaskQueue->Mutex.Lock();
+  if (this->ProcessingThreadActive)
+    {
+    this->InternalTaskQueue->Push(task);
+    this->InternalTaskQueue->TaskAvailable[
+      ProcessingTaskQueue::GetQueueIndex(task->GetType())]->Signal();
+    scheduled = true;
+    }
+  this->InternalTaskQueue->Mutex.Unlock();
 
-  // only schedule a task if the processing task is up
-  this->ProcessingThreadActiveLock->Lock();
-  active = this->ProcessingThreadActive;
-  this->ProcessingThreadActiveLock->Unlock();
+  return scheduled;
+}
 
-  if (active)
+//----------------------------------------------------------------------------
+bool vtkSlicerApplicationLogic::CancelTask( vtkSlicerTask *task )
+{
+  if (!task)
     {
-    this->ProcessingTaskQueueLock->Lock();
-    (*this->InternalTaskQueue).push( task );
-    //std::cout << (*this->InternalTaskQueue).size() << std::endl;
-    this->ProcessingTaskQueueLock->Unlock();
-
-    return true;
+    return false;
     }
+  this->InternalTaskQueue->Mutex.Lock();
+  bool removed = this->InternalTaskQueue->Remove(task);
+  this->InternalTaskQueue->Mutex.Unlock();
+  return removed;
+}
 
-  // could not schedule the task
-  return false;
+//----------------------------------------------------------------------------
+int vtkSlicerApplicationLogic::GetNumberOfScheduledTasks(int taskType)
+{
+  this->InternalTaskQueue->Mutex.Lock();
+  int numberOfTasks = static_cast<int>(this->InternalTaskQueue->Tasks[
+    ProcessingTaskQueue::GetQueueIndex(taskType)].size());
+  this->InternalTaskQueue->Mutex.Unlock();
+  return numberOfTasks;
 }
 
 //----------------------------------------------------------------------------
@@ -70,11 +70,25 @@ class VTK_SLICER_BASE_LOGIC_EXPORT vtkSlicerApplicationLogic
   /// (display it in the Fiducials GUI)
   void PropagateFiducialListSelection();
 
-  /// Create a thread for processing
+  /// Create the threads for processing and networking tasks.
+  /// \sa SetNumberOfProcessingThreads(), SetNumberOfNetworkingThreads()
   void CreateProcessingThread();
 
-  /// Shutdown the processing thread
+  /// Shutdown the processing and networking threads. Tasks that are running
+  /// are not interrupted, the threads terminate when their task is done.
   void TerminateProcessingThread();
+
+  /// Number of threads running the tasks of type vtkSlicerTask::Processing
+  /// (and vtkSlicerTask::Undefined). Must be set before calling
+  /// CreateProcessingThread(). 1 by default.
+  vtkSetClampMacro(NumberOfProcessingThreads, int, 1, ITK_MAX_THREADS / 2);
+  vtkGetMacro(NumberOfProcessingThreads, int);
+
+  /// Number of threads running the tasks of type vtkSlicerTask::Networking.
+  /// Must be set before calling CreateProcessingThread(). 1 by default
+  /// because curl may not be built thread safe.
+  vtkSetClampMacro(NumberOfNetworkingThreads, int, 1, ITK_MAX_THREADS / 2);
+  vtkGetMacro(NumberOfNetworkingThreads, int);
   /// List of events potentially fired by the application logic
   enum RequestEvents
     {
@@ -91,8 +105,21 @@ class VTK_SLICER_BASE_LOGIC_EXPORT vtkSlicerApplicationLogic
   /// Schedule a task to run in the processing thread. Returns true if
   /// task was successfully scheduled. ScheduleTask() is called from the
   /// main thread to run something in the processing thread.
+  /// Networking tasks are run by the networking threads, all the other
+  /// tasks by the processing threads. Scheduled tasks are run by order of
+  /// decreasing priority then by order of scheduling.
+  /// An idle thread is woken up as soon as a task is scheduled.
+  /// \sa vtkSlicerTask::SetPriority(), CancelTask()
   int ScheduleTask( vtkSlicerTask* );
 
+  /// Remove a scheduled task that is not running yet.
+  /// Return true if the task was found and removed.
+  bool CancelTask( vtkSlicerTask* );
+
+  /// Return the number of tasks of the given type waiting to be run.
+  /// Tasks that are running are not counted.
+  int GetNumberOfScheduledTasks(int taskType);
+
   /// Request a Modified call on an object.  This method allows a
   /// processing thread to request a Modified call on an object to be
   /// performed in the main thread.  This allows the call to Modified
@@ -211,6 +238,14 @@ protected:
   /// Networking Task processing loop that is run in a networking thread
   void ProcessNetworkingTasks();
 
+  /// Wait for tasks on the given queue and run them until the threads are
+  /// terminated.
+  void ProcessTasks(int queueIndex);
+
+  /// Wake up the processing and networking threads and wait for them to
+  /// terminate.
+  void TerminateWorkerThreads();
+
   /// Process a request to read data into a node.  This method is
   /// called by ProcessReadData() in the application main thread
   /// because calls to load data will cause a Modified() on a node
@@ -230,8 +265,6 @@ private:
   void operator=(const vtkSlicerApplicationLogic&);
 
   itk::MultiThreader::Pointer ProcessingThreader;
-  itk::MutexLock::Pointer ProcessingThreadActiveLock;
-  itk::MutexLock::Pointer ProcessingTaskQueueLock;
   itk::MutexLock::Pointer ModifiedQueueActiveLock;
   itk::MutexLock::Pointer ModifiedQueueLock;
   itk::MutexLock::Pointer ReadDataQueueActiveLock;
@@ -239,8 +272,11 @@ private:
   itk::MutexLock::Pointer WriteDataQueueActiveLock;
   itk::MutexLock::Pointer WriteDataQueueLock;
   vtkTimeStamp RequestTimeStamp;
-  int ProcessingThreadId;
+  std::vector<int> ProcessingThreadIDs;
   std::vector<int> NetworkingThreadIDs;
+  int NumberOfProcessingThreads;
+  int NumberOfNetworkingThreads;
+  /// Protected by the mutex of InternalTaskQueue.
   int ProcessingThreadActive;
   int ModifiedQueueActive;
   int ReadDataQueueActive;
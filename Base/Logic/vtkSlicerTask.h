@@ -38,6 +38,13 @@ public:
   void SetTypeToProcessing() {this->SetType(vtkSlicerTask::Processing);};
   void SetTypeToNetworking() {this->SetType(vtkSlicerTask::Networking);};
 
+  ///
+  /// Tasks with a higher priority are run first. Tasks with the same
+  /// priority are run in the order they were scheduled. 0 by default.
+  /// The priority must be set before the task is scheduled.
+  vtkSetMacro (Priority, int);
+  vtkGetMacro (Priority, int);
+
   const char* GetTypeAsString( ) {
     switch (this->Type)
       {
@@ -60,6 +67,7 @@ private:
   void *TaskClientData;
 
   int Type;
+  int Priority;
 
 };
 #endif
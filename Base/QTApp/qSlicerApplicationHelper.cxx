@@ -21,6 +21,8 @@
 #include "qSlicerApplicationHelper.h"
 
 // Qt includes
+#include <QDir>
+#include <QFileInfo>
 #include <QSettings>
 
 // Slicer includes
@@ -130,6 +132,12 @@ void qSlicerApplicationHelper::setupModuleFactoryManager(qSlicerModuleFactoryMan
 
     qSlicerCLIExecutableModuleFactory* cliExecutableFactory = new qSlicerCLIExecutableModuleFactory();
     cliExecutableFactory->setTempDirectory(tempDirectory);
+    // Descriptions extracted from the executables are cached next to the
+    // revision specific settings, e.g. Slicer-12345-CLIModuleDescriptions/
+    QFileInfo revisionUserSettingsFileInfo(app->slicerRevisionUserSettingsFilePath());
+    cliExecutableFactory->setXmlDescriptionCacheDirectory(
+      revisionUserSettingsFileInfo.dir().filePath(
+        revisionUserSettingsFileInfo.completeBaseName() + "-CLIModuleDescriptions"));
     moduleFactoryManager->registerFactory(cliExecutableFactory, preferExecutableCLIs ? 1 : 0);
 
     if (!options->disableBuiltInModules() &&
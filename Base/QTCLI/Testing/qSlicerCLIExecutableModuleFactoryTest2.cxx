@@ -0,0 +1,226 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  Copyright (c) Kitware Inc.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  This file was originally developed by Jean-Christophe Fillion-Robin, Kitware Inc.
+  and was partially funded by NIH grant 3P41RR013218-12S1
+
+==============================================================================*/
+
+// Qt includes
+#include <QCoreApplication>
+#include <QDir>
+#include <QFile>
+#include <QStringList>
+#include <QTextStream>
+
+// SlicerQt includes
+#include <qSlicerCLIExecutableModuleFactory.h>
+#include <qSlicerCLIModule.h>
+
+// STD includes
+#include <cstdlib>
+#include <iostream>
+
+namespace
+{
+
+//-----------------------------------------------------------------------------
+// Write a shell script that creates \a markerPath each time it is run and
+// prints a module description titled \a title.
+bool writeExecutable(const QString& executablePath, const QString& markerPath,
+                     const QString& title)
+{
+  QFile executable(executablePath);
+  if (!executable.open(QIODevice::WriteOnly | QIODevice::Truncate))
+    {
+    return false;
+    }
+  QTextStream stream(&executable);
+  stream << "#!/bin/sh\n"
+         << "touch \"" << markerPath << "\"\n"
+         << "cat << EOF\n"
+         << "<?xml version=\"1.0\" encoding=\"utf-8\"?>\n"
+         << "<executable>\n"
+         << "  <category>Testing</category>\n"
+         << "  <title>" << title << "</title>\n"
+         << "  <description>Fake command line module</description>\n"
+         << "</executable>\n"
+         << "EOF\n";
+  stream.flush();
+  executable.close();
+  return executable.setPermissions(executable.permissions() |
+                                   QFile::ExeOwner | QFile::ExeUser);
+}
+
+//-----------------------------------------------------------------------------
+// Write a shell script that creates \a overlapPath if another instance is
+// running at the same time and prints a module description titled \a title.
+bool writeSlowExecutable(const QString& executablePath, const QString& runningPath,
+                         const QString& overlapPath, const QString& title)
+{
+  QFile executable(executablePath);
+  if (!executable.open(QIODevice::WriteOnly | QIODevice::Truncate))
+    {
+    return false;
+    }
+  QTextStream stream(&executable);
+  stream << "#!/bin/sh\n"
+         << "mkdir \"" << runningPath << "\" 2> /dev/null || touch \"" << overlapPath << "\"\n"
+         << "sleep 1\n"
+         << "rmdir \"" << runningPath << "\" 2> /dev/null\n"
+         << "cat << EOF\n"
+         << "<?xml version=\"1.0\" encoding=\"utf-8\"?>\n"
+         << "<executable>\n"
+         << "  <category>Testing</category>\n"
+         << "  <title>" << title << "</title>\n"
+         << "  <description>Fake command line module</description>\n"
+         << "</executable>\n"
+         << "EOF\n";
+  stream.flush();
+  executable.close();
+  return executable.setPermissions(executable.permissions() |
+                                   QFile::ExeOwner | QFile::ExeUser);
+}
+
+//-----------------------------------------------------------------------------
+// Instantiate the module of \a executablePath with a new factory and return
+// its title.
+QString instantiatedModuleTitle(const QString& executablePath,
+                                const QString& cacheDirectory)
+{
+  qSlicerCLIExecutableModuleFactory factory;
+  factory.setXmlDescriptionCacheDirectory(cacheDirectory);
+  QString moduleName = factory.registerFileItem(QFileInfo(executablePath));
+  qSlicerCLIModule* module =
+    dynamic_cast<qSlicerCLIModule*>(factory.instantiate(moduleName));
+  return module ? module->title() : QString();
+}
+
+} // end anonymous namespace
+
+//-----------------------------------------------------------------------------
+int qSlicerCLIExecutableModuleFactoryTest2(int argc, char * argv[] )
+{
+#ifdef Q_OS_WIN
+  Q_UNUSED(argc);
+  Q_UNUSED(argv);
+  // The fake executable is a shell script.
+  return EXIT_SUCCESS;
+#else
+  QCoreApplication app(argc, argv);
+
+  QDir testDirectory(QDir::tempPath());
+  QString testDirectoryName = QString("qSlicerCLIExecutableModuleFactoryTest2-%1")
+    .arg(QCoreApplication::applicationPid());
+  if (!testDirectory.mkpath(testDirectoryName) || !testDirectory.cd(testDirectoryName))
+    {
+    std::cerr << "Line " << __LINE__ << " - Failed to create directory" << std::endl;
+    return EXIT_FAILURE;
+    }
+  QString executablePath = testDirectory.filePath("FakeCLI");
+  QString markerPath = testDirectory.filePath("FakeCLIRun");
+  QString cacheDirectory = testDirectory.filePath("Cache");
+
+  // The description is extracted by running the executable
+  if (!writeExecutable(executablePath, markerPath, "Fake CLI") ||
+      instantiatedModuleTitle(executablePath, cacheDirectory) != "Fake CLI" ||
+      !QFile::remove(markerPath))
+    {
+    std::cerr << "Line " << __LINE__ << " - Failed to run executable" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Then it is read from the cache
+  if (instantiatedModuleTitle(executablePath, cacheDirectory) != "Fake CLI" ||
+      QFile::exists(markerPath))
+    {
+    std::cerr << "Line " << __LINE__ << " - Description not cached" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Until the executable is modified
+  if (!writeExecutable(executablePath, markerPath, "Modified Fake CLI") ||
+      instantiatedModuleTitle(executablePath, cacheDirectory) != "Modified Fake CLI" ||
+      !QFile::exists(markerPath))
+    {
+    std::cerr << "Line " << __LINE__ << " - Cached description not updated" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Without cache directory, the executable is always run
+  QFile::remove(markerPath);
+  if (instantiatedModuleTitle(executablePath, QString()) != "Modified Fake CLI" ||
+      !QFile::exists(markerPath))
+    {
+    std::cerr << "Line " << __LINE__ << " - Failed to run executable" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // The number of executables run at the same time is limited
+  QString runningPath = testDirectory.filePath("SlowCLIRunning");
+  QString overlapPath = testDirectory.filePath("SlowCLIOverlap");
+  QStringList slowExecutableNames;
+  slowExecutableNames << "SlowCLIA" << "SlowCLIB" << "SlowCLIC";
+  {
+  qSlicerCLIExecutableModuleFactory factory;
+  factory.setMaximumNumberOfXmlProcesses(1);
+  QStringList moduleNames;
+  foreach(const QString& executableName, slowExecutableNames)
+    {
+    if (!writeSlowExecutable(testDirectory.filePath(executableName),
+                             runningPath, overlapPath, executableName))
+      {
+      std::cerr << "Line " << __LINE__ << " - Failed to write executable" << std::endl;
+      return EXIT_FAILURE;
+      }
+    moduleNames << factory.registerFileItem(
+      QFileInfo(testDirectory.filePath(executableName)));
+    }
+  for (int i = 0; i < moduleNames.count(); ++i)
+    {
+    qSlicerCLIModule* module =
+      dynamic_cast<qSlicerCLIModule*>(factory.instantiate(moduleNames[i]));
+    if (!module || module->title() != slowExecutableNames[i])
+      {
+      std::cerr << "Line " << __LINE__ << " - Failed to instantiate "
+                << qPrintable(slowExecutableNames[i]) << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+  }
+  if (QFile::exists(overlapPath))
+    {
+    std::cerr << "Line " << __LINE__ << " - Too many executables run at the same time"
+              << std::endl;
+    return EXIT_FAILURE;
+    }
+  foreach(const QString& executableName, slowExecutableNames)
+    {
+    testDirectory.remove(executableName);
+    }
+
+  QDir cache(cacheDirectory);
+  foreach(const QString& fileName, cache.entryList(QDir::Files))
+    {
+    cache.remove(fileName);
+    }
+  testDirectory.rmdir("Cache");
+  testDirectory.remove("FakeCLI");
+  testDirectory.remove("FakeCLIRun");
+  QDir::temp().rmdir(testDirectoryName);
+
+  return EXIT_SUCCESS;
+#endif
+}
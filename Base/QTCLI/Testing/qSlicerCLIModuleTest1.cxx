@@ -77,6 +77,17 @@ void runCli(void * data)
   // Execute synchronously so that we can check the content of the file after the module execution
   CLIModule->cliModuleLogic()->ApplyAndWait(cliModuleNode);
 
+  // Loadable modules run in the process space of Slicer, their memory usage
+  // can't be reported.
+  if (cliModuleNode->GetLastRunDuration() < 0. ||
+      cliModuleNode->GetLastRunPeakMemoryUsage() != 0)
+    {
+    ErrorString = QString("Wrong run statistics: duration %1, peak memory %2")
+      .arg(cliModuleNode->GetLastRunDuration())
+      .arg(cliModuleNode->GetLastRunPeakMemoryUsage());
+    return;
+    }
+
   // Read outputFile
   QTextStream stream(&outputFile);
   QString operationResult = stream.readAll().trimmed();
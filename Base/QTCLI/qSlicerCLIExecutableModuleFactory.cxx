@@ -19,7 +19,11 @@
 ==============================================================================*/
 
 // Qt includes
+#include <QCoreApplication>
+#include <QCryptographicHash>
+#include <QDateTime>
 #include <QProcess>
+#include <QThread>
 
 // SlicerQt includes
 #include "qSlicerCLIExecutableModuleFactory.h"
@@ -28,15 +32,110 @@
 #include "qSlicerUtils.h"
 #include <vtkSlicerCLIModuleLogic.h>
 
+//-----------------------------------------------------------------------------
+// qSlicerCLIExecutableModuleFactoryXmlQueue
+
+//-----------------------------------------------------------------------------
+qSlicerCLIExecutableModuleFactoryXmlQueue::qSlicerCLIExecutableModuleFactoryXmlQueue()
+  : MaximumNumberOfRunningItems(qMax(1, QThread::idealThreadCount()))
+{
+}
+
+//-----------------------------------------------------------------------------
+void qSlicerCLIExecutableModuleFactoryXmlQueue::setMaximumNumberOfRunningItems(
+  int maximumNumberOfRunningItems)
+{
+  this->MaximumNumberOfRunningItems = qMax(1, maximumNumberOfRunningItems);
+  this->startPendingItems();
+}
+
+//-----------------------------------------------------------------------------
+int qSlicerCLIExecutableModuleFactoryXmlQueue::maximumNumberOfRunningItems()const
+{
+  return this->MaximumNumberOfRunningItems;
+}
+
+//-----------------------------------------------------------------------------
+void qSlicerCLIExecutableModuleFactoryXmlQueue::enqueue(Item* item)
+{
+  if (this->PendingItems.contains(item) || this->RunningItems.contains(item))
+    {
+    return;
+    }
+  this->PendingItems.append(item);
+  this->startPendingItems();
+}
+
+//-----------------------------------------------------------------------------
+void qSlicerCLIExecutableModuleFactoryXmlQueue::remove(Item* item)
+{
+  this->PendingItems.removeAll(item);
+  if (this->RunningItems.removeAll(item))
+    {
+    this->startPendingItems();
+    }
+}
+
+//-----------------------------------------------------------------------------
+void qSlicerCLIExecutableModuleFactoryXmlQueue::clearPendingItems()
+{
+  this->PendingItems.clear();
+}
+
+//-----------------------------------------------------------------------------
+void qSlicerCLIExecutableModuleFactoryXmlQueue::startPendingItems()
+{
+  while (!this->PendingItems.isEmpty() &&
+         this->RunningItems.count() < this->MaximumNumberOfRunningItems)
+    {
+    Item* item = this->PendingItems.takeFirst();
+    this->RunningItems.append(item);
+    item->startCLIWithXmlArgument();
+    }
+}
+
+//-----------------------------------------------------------------------------
+// qSlicerCLIExecutableModuleFactoryItem
+
 //-----------------------------------------------------------------------------
 qSlicerCLIExecutableModuleFactoryItem::qSlicerCLIExecutableModuleFactoryItem(
-  const QString& newTempDirectory) : TempDirectory(newTempDirectory)
+  const QString& newTempDirectory, const QString& newXmlDescriptionCacheDirectory,
+  const QSharedPointer<XmlQueue>& newXmlQueue)
+  : TempDirectory(newTempDirectory)
+  , XmlDescriptionCacheDirectory(newXmlDescriptionCacheDirectory)
+  , XmlDescriptionQueue(newXmlQueue)
+  , XmlProcess(0)
+  , CLIModule(0)
 {
 }
 
+//-----------------------------------------------------------------------------
+qSlicerCLIExecutableModuleFactoryItem::~qSlicerCLIExecutableModuleFactoryItem()
+{
+  if (this->XmlDescriptionQueue)
+    {
+    this->XmlDescriptionQueue->remove(this);
+    }
+  if (this->XmlProcess)
+    {
+    this->XmlProcess->kill();
+    this->XmlProcess->waitForFinished(1000);
+    delete this->XmlProcess;
+    }
+}
+
 //-----------------------------------------------------------------------------
 bool qSlicerCLIExecutableModuleFactoryItem::load()
 {
+  if (QFile::exists(this->xmlModuleDescriptionFilePath()))
+    {
+    return true;
+    }
+  this->CachedXmlDescription = this->readCachedXmlDescription();
+  if (this->CachedXmlDescription.isEmpty() && this->XmlDescriptionQueue)
+    {
+    this->XmlDescriptionQueue->enqueue(this);
+    }
   return true;
 }
 
@@ -47,6 +146,82 @@ QString qSlicerCLIExecutableModuleFactoryItem::xmlModuleDescriptionFilePath()
   return QDir(info.path()).filePath(info.baseName() + ".xml");
 }
 
+//-----------------------------------------------------------------------------
+QString qSlicerCLIExecutableModuleFactoryItem::xmlDescriptionCacheFilePath()const
+{
+  if (this->XmlDescriptionCacheDirectory.isEmpty())
+    {
+    return QString();
+    }
+  // Executables of different directories can have the same name.
+  QByteArray pathHash = QCryptographicHash::hash(
+    QFileInfo(this->path()).absoluteFilePath().toUtf8(), QCryptographicHash::Md5);
+  return QDir(this->XmlDescriptionCacheDirectory).filePath(
+    QFileInfo(this->path()).baseName() + "-" + pathHash.toHex() + ".xml");
+}
+
+//-----------------------------------------------------------------------------
+QString qSlicerCLIExecutableModuleFactoryItem::xmlDescriptionCacheKey()const
+{
+  QFileInfo info(this->path());
+  return QString("%1|%2|%3").arg(info.absoluteFilePath())
+    .arg(info.lastModified().toMSecsSinceEpoch())
+    .arg(info.size());
+}
+
+//-----------------------------------------------------------------------------
+QString qSlicerCLIExecutableModuleFactoryItem::readCachedXmlDescription()const
+{
+  QString cacheFilePath = this->xmlDescriptionCacheFilePath();
+  if (cacheFilePath.isEmpty() || !QFile::exists(cacheFilePath))
+    {
+    return QString();
+    }
+  QFile cacheFile(cacheFilePath);
+  if (!cacheFile.open(QIODevice::ReadOnly))
+    {
+    return QString();
+    }
+  // The first line is the key of the executable the description was
+  // extracted from.
+  QTextStream stream(&cacheFile);
+  if (stream.readLine() != this->xmlDescriptionCacheKey())
+    {
+    return QString();
+    }
+  return stream.readAll();
+}
+
+//-----------------------------------------------------------------------------
+void qSlicerCLIExecutableModuleFactoryItem::writeCachedXmlDescription(
+  const QString& xmlDescription)const
+{
+  QString cacheFilePath = this->xmlDescriptionCacheFilePath();
+  if (cacheFilePath.isEmpty() ||
+      !QDir().mkpath(this->XmlDescriptionCacheDirectory))
+    {
+    return;
+    }
+  // Write into a temporary file first so that a concurrent session never
+  // reads a partially written description.
+  QString tempCacheFilePath = cacheFilePath + "."
+    + QString::number(QCoreApplication::applicationPid()) + ".tmp";
+  QFile tempCacheFile(tempCacheFilePath);
+  if (!tempCacheFile.open(QIODevice::WriteOnly | QIODevice::Truncate))
+    {
+    return;
+    }
+  QTextStream stream(&tempCacheFile);
+  stream << this->xmlDescriptionCacheKey() << "\n" << xmlDescription;
+  stream.flush();
+  tempCacheFile.close();
+  QFile::remove(cacheFilePath);
+  if (!QFile::rename(tempCacheFilePath, cacheFilePath))
+    {
+    QFile::remove(tempCacheFilePath);
+    }
+}
+
 //-----------------------------------------------------------------------------
 qSlicerAbstractCoreModule* qSlicerCLIExecutableModuleFactoryItem::instanciator()
 {
@@ -60,7 +235,8 @@ qSlicerAbstractCoreModule* qSlicerCLIExecutableModuleFactoryItem::instanciator()
 
   //
   // If the xml file exists, read it and associate it with the module
-  // description. If not, run the CLI executable with "--xml".
+  // description. If not, use the cached description or run the CLI
+  // executable with "--xml".
   //
   QString xmlDescription;
   if (QFile::exists(xmlFilePath))
@@ -76,9 +252,17 @@ qSlicerAbstractCoreModule* qSlicerCLIExecutableModuleFactoryItem::instanciator()
       this->appendInstantiateErrorString("Failed to read Xml Description");
       }
     }
+  else if (!this->CachedXmlDescription.isEmpty())
+    {
+    xmlDescription = this->CachedXmlDescription;
+    }
   else
     {
     xmlDescription = this->runCLIWithXmlArgument();
+    if (!xmlDescription.isEmpty())
+      {
+      this->writeCachedXmlDescription(xmlDescription);
+      }
     }
   if (xmlDescription.isEmpty())
     {
@@ -96,18 +280,39 @@ qSlicerAbstractCoreModule* qSlicerCLIExecutableModuleFactoryItem::instanciator()
   return module.take();
 }
 
+//-----------------------------------------------------------------------------
+void qSlicerCLIExecutableModuleFactoryItem::startCLIWithXmlArgument()
+{
+  if (this->XmlProcess)
+    {
+    return;
+    }
+  this->XmlProcess = new QProcess;
+  QProcessEnvironment env = QProcessEnvironment::systemEnvironment();
+  env.insert("ITK_AUTOLOAD_PATH", "");
+  this->XmlProcess->setProcessEnvironment(env);
+  this->XmlProcess->setWorkingDirectory(QFileInfo(this->path()).path());
+  this->XmlProcess->start(this->path(), QStringList(QString("--xml")));
+}
+
 //-----------------------------------------------------------------------------
 QString qSlicerCLIExecutableModuleFactoryItem::runCLIWithXmlArgument()
 {
-  ctkScopedCurrentDir scopedCurrentDir(QFileInfo(this->path()).path());
+  this->startCLIWithXmlArgument();
+  // The process is not needed anymore once it has finished.
+  QScopedPointer<QProcess> cliPointer(this->XmlProcess);
+  this->XmlProcess = 0;
+  QProcess& cli = *cliPointer;
 
   int cliProcessTimeoutInMs = 5000;
-  QProcess cli;
-  QProcessEnvironment env = QProcessEnvironment::systemEnvironment();
-  env.insert("ITK_AUTOLOAD_PATH", "");
-  cli.setProcessEnvironment(env);
-  cli.start(this->path(), QStringList(QString("--xml")));
-  bool res = cli.waitForFinished(cliProcessTimeoutInMs);
+  bool res = cli.state() == QProcess::NotRunning ?
+    cli.exitStatus() == QProcess::NormalExit && cli.error() == QProcess::UnknownError :
+    cli.waitForFinished(cliProcessTimeoutInMs);
+  // Let the next queued executables run
+  if (this->XmlDescriptionQueue)
+    {
+    this->XmlDescriptionQueue->remove(this);
+    }
   if (!res)
     {
     this->appendInstantiateErrorString(QString("CLI executable: %1").arg(this->path()));
@@ -178,7 +383,11 @@ QString qSlicerCLIExecutableModuleFactoryItem::runCLIWithXmlArgument()
 //-----------------------------------------------------------------------------
 void qSlicerCLIExecutableModuleFactoryItem::uninstantiate()
 {
-  this->CLIModule->cliModuleLogic()->KillProcesses();
+  if (this->CLIModule && this->CLIModule->cliModuleLogic())
+    {
+    this->CLIModule->cliModuleLogic()->KillProcesses();
+    }
+  this->CLIModule = 0;
   this->ctkAbstractFactoryFileBasedItem<qSlicerAbstractCoreModule>::uninstantiate();
 }
 
@@ -197,6 +406,8 @@ public:
 
 private:
   QString TempDirectory;
+  QString XmlDescriptionCacheDirectory;
+  QSharedPointer<qSlicerCLIExecutableModuleFactoryXmlQueue> XmlQueue;
 };
 
 //-----------------------------------------------------------------------------
@@ -204,6 +415,8 @@ qSlicerCLIExecutableModuleFactoryPrivate::qSlicerCLIExecutableModuleFactoryPriva
 :q_ptr(&object)
 {
   this->TempDirectory = QDir::tempPath();
+  this->XmlQueue = QSharedPointer<qSlicerCLIExecutableModuleFactoryXmlQueue>(
+    new qSlicerCLIExecutableModuleFactoryXmlQueue);
 }
 
 //-----------------------------------------------------------------------------
@@ -218,6 +431,9 @@ qSlicerCLIExecutableModuleFactory::qSlicerCLIExecutableModuleFactory()
 //-----------------------------------------------------------------------------
 qSlicerCLIExecutableModuleFactory::~qSlicerCLIExecutableModuleFactory()
 {
+  Q_D(qSlicerCLIExecutableModuleFactory);
+  // Don't start the queued executables while the items are deleted
+  d->XmlQueue->clearPendingItems();
 }
 
 //-----------------------------------------------------------------------------
@@ -246,7 +462,8 @@ ctkAbstractFactoryItem<qSlicerAbstractCoreModule>* qSlicerCLIExecutableModuleFac
 ::createFactoryFileBasedItem()
 {
   Q_D(qSlicerCLIExecutableModuleFactory);
-  return new qSlicerCLIExecutableModuleFactoryItem(d->TempDirectory);
+  return new qSlicerCLIExecutableModuleFactoryItem(
+    d->TempDirectory, d->XmlDescriptionCacheDirectory, d->XmlQueue);
 }
 
 //-----------------------------------------------------------------------------
@@ -261,3 +478,31 @@ void qSlicerCLIExecutableModuleFactory::setTempDirectory(const QString& newTempD
   Q_D(qSlicerCLIExecutableModuleFactory);
   d->TempDirectory = newTempDirectory;
 }
+
+//-----------------------------------------------------------------------------
+void qSlicerCLIExecutableModuleFactory::setXmlDescriptionCacheDirectory(const QString& newCacheDirectory)
+{
+  Q_D(qSlicerCLIExecutableModuleFactory);
+  d->XmlDescriptionCacheDirectory = newCacheDirectory;
+}
+
+//-----------------------------------------------------------------------------
+QString qSlicerCLIExecutableModuleFactory::xmlDescriptionCacheDirectory()const
+{
+  Q_D(const qSlicerCLIExecutableModuleFactory);
+  return d->XmlDescriptionCacheDirectory;
+}
+
+//-----------------------------------------------------------------------------
+void qSlicerCLIExecutableModuleFactory::setMaximumNumberOfXmlProcesses(int maximumNumberOfProcesses)
+{
+  Q_D(qSlicerCLIExecutableModuleFactory);
+  d->XmlQueue->setMaximumNumberOfRunningItems(maximumNumberOfProcesses);
+}
+
+//-----------------------------------------------------------------------------
+int qSlicerCLIExecutableModuleFactory::maximumNumberOfXmlProcesses()const
+{
+  Q_D(const qSlicerCLIExecutableModuleFactory);
+  return d->XmlQueue->maximumNumberOfRunningItems();
+}
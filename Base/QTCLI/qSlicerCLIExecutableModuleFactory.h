@@ -26,26 +26,95 @@
 #include "qSlicerBaseQTCLIExport.h"
 class qSlicerCLIModule;
 
+// Qt includes
+#include <QList>
+#include <QSharedPointer>
+class QProcess;
+
 // CTK includes
 #include <ctkPimpl.h>
 #include <ctkAbstractPluginFactory.h>
 
+class qSlicerCLIExecutableModuleFactoryItem;
+
+//-----------------------------------------------------------------------------
+/// Queue of the executables to start with "--xml". At most
+/// maximumNumberOfRunningItems() executables run at the same time, the next
+/// ones are started when the descriptions of the running ones are collected.
+class qSlicerCLIExecutableModuleFactoryXmlQueue
+{
+public:
+  typedef qSlicerCLIExecutableModuleFactoryItem Item;
+  qSlicerCLIExecutableModuleFactoryXmlQueue();
+
+  /// QThread::idealThreadCount() by default.
+  void setMaximumNumberOfRunningItems(int maximumNumberOfRunningItems);
+  int maximumNumberOfRunningItems()const;
+
+  /// Start the executable of \a item now if the maximum number of running
+  /// executables is not reached, queue it otherwise.
+  void enqueue(Item* item);
+  /// Remove \a item from the queue. If its executable was running, the next
+  /// queued executables are started.
+  void remove(Item* item);
+  /// Remove all the queued items that are not running.
+  void clearPendingItems();
+
+protected:
+  void startPendingItems();
+
+  QList<Item*> PendingItems;
+  QList<Item*> RunningItems;
+  int MaximumNumberOfRunningItems;
+};
+
 //-----------------------------------------------------------------------------
 class qSlicerCLIExecutableModuleFactoryItem
   : public ctkAbstractFactoryFileBasedItem<qSlicerAbstractCoreModule>
 {
+  friend class qSlicerCLIExecutableModuleFactoryXmlQueue;
 public:
-  qSlicerCLIExecutableModuleFactoryItem(const QString& newTempDirectory);
+  typedef qSlicerCLIExecutableModuleFactoryXmlQueue XmlQueue;
+  qSlicerCLIExecutableModuleFactoryItem(const QString& newTempDirectory,
+                                        const QString& newXmlDescriptionCacheDirectory = QString(),
+                                        const QSharedPointer<XmlQueue>& newXmlQueue = QSharedPointer<XmlQueue>());
+  virtual ~qSlicerCLIExecutableModuleFactoryItem();
+
+  /// Called at registration time. If there is no XML file next to the
+  /// executable and no up-to-date description in the cache, the executable
+  /// is queued to be started with "--xml" without waiting for it to finish.
+  /// This way, the descriptions of the registered executables are extracted
+  /// in parallel and collected at instantiation time.
+  /// Without queue, the executable is only run at instantiation time.
   virtual bool load();
   virtual void uninstantiate();
 protected:
   /// Return path of the expected XML file.
   QString xmlModuleDescriptionFilePath();
 
+  /// Return the path of the file caching the XML description of the
+  /// executable or an empty string if there is no cache directory.
+  QString xmlDescriptionCacheFilePath()const;
+  /// Return the key identifying the current version of the executable:
+  /// its path, last modification time and size.
+  QString xmlDescriptionCacheKey()const;
+  /// Return the cached XML description if it is up-to-date with the
+  /// executable, an empty string otherwise.
+  QString readCachedXmlDescription()const;
+  void writeCachedXmlDescription(const QString& xmlDescription)const;
+
   virtual qSlicerAbstractCoreModule* instanciator();
+  /// Start the executable with "--xml" if it is not already running.
+  void startCLIWithXmlArgument();
+  /// Wait for the executable started with "--xml" to finish and return its
+  /// output.
   QString runCLIWithXmlArgument();
 private:
   QString TempDirectory;
+  QString XmlDescriptionCacheDirectory;
+  QString CachedXmlDescription;
+  QSharedPointer<XmlQueue> XmlDescriptionQueue;
+  QProcess* XmlProcess;
   qSlicerCLIModule* CLIModule;
 };
 
@@ -71,6 +140,18 @@ public:
 
   void setTempDirectory(const QString& newTempDirectory);
 
+  /// Directory where the XML descriptions extracted from the executables
+  /// are cached between sessions. A cached description is reused as long as
+  /// the path, last modification time and size of the executable are
+  /// unchanged. An empty directory (default) disables the cache.
+  void setXmlDescriptionCacheDirectory(const QString& newCacheDirectory);
+  QString xmlDescriptionCacheDirectory()const;
+
+  /// Maximum number of executables run with "--xml" at the same time to
+  /// extract their descriptions. QThread::idealThreadCount() by default.
+  void setMaximumNumberOfXmlProcesses(int maximumNumberOfProcesses);
+  int maximumNumberOfXmlProcesses()const;
+
 protected:
   virtual bool isValidFile(const QFileInfo& file)const;
 
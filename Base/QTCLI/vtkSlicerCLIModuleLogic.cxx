@@ -39,8 +39,16 @@
 #include <vtkNew.h>
 #include <vtkObjectFactory.h>
 #include <vtkStringArray.h>
+#include <vtkTimeStamp.h>
 #include <vtksys/SystemTools.hxx>
 
+// ITK includes
+#include <itkMutexLock.h>
+
+// MRMLIDImageIO includes
+#include <itkMRMLIDImageIO.h>
+#include <itkSharedMemoryImageIO.h>
+
 // ITKSYS includes
 #include <itksys/Process.h>
 #include <itksys/SystemTools.hxx>
@@ -57,6 +65,7 @@
 #include <algorithm>
 #include <cassert>
 #include <ctime>
+#include <fstream>
 #include <set>
 
 #ifdef _WIN32
@@ -64,6 +73,54 @@
 #include <sys/types.h>
 #include <unistd.h>
 #endif
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif
+
+namespace
+{
+
+// The environment is shared by all the threads running CLIs. It is
+// temporarily modified when an executable is started.
+itk::SimpleMutexLock EnvironmentLock;
+
+// Shared object modules run in the process space of Slicer and redirect its
+// standard streams, only one of them can run at a time.
+itk::SimpleMutexLock SharedObjectModuleLock;
+
+//----------------------------------------------------------------------------
+// Return the peak resident memory in kB of the processes started by the
+// calling thread, or 0 if it can't be determined (only supported on Linux).
+unsigned long GetChildProcessesPeakMemoryUsage()
+{
+  unsigned long peakMemoryUsage = 0;
+#ifdef __linux__
+  std::ostringstream childrenFileName;
+  childrenFileName << "/proc/self/task/" << syscall(SYS_gettid) << "/children";
+  std::ifstream childrenFile(childrenFileName.str().c_str());
+  long childPid = 0;
+  while (childrenFile >> childPid)
+    {
+    std::ostringstream statusFileName;
+    statusFileName << "/proc/" << childPid << "/status";
+    std::ifstream statusFile(statusFileName.str().c_str());
+    std::string line;
+    while (std::getline(statusFile, line))
+      {
+      // VmHWM is the peak resident set size of the process
+      if (line.compare(0, 6, "VmHWM:") == 0)
+        {
+        peakMemoryUsage = std::max(peakMemoryUsage,
+                                   strtoul(line.c_str() + 6, 0, 10));
+        break;
+        }
+      }
+    }
+#endif
+  return peakMemoryUsage;
+}
+
+}
 
 //----------------------------------------------------------------------------
 struct DigitsToCharacters
@@ -326,6 +383,8 @@ public:
 
   int RedirectModuleStreams;
 
+  int SharedMemoryImageTransfer;
+
   itk::MutexLock::Pointer ProcessesKillLock;
   std::vector<itksysProcess*> Processes;
 
@@ -353,6 +412,7 @@ public:
 
   void SetLastRequest(vtkMRMLCommandLineModuleNode* node, int requestUID)
   {
+    this->LastRequestsLock.Lock();
     RequestType::iterator it = std::find_if(
       this->LastRequests.begin(), this->LastRequests.end(), FindRequest(node));
     if (it == this->LastRequests.end())
@@ -364,12 +424,32 @@ public:
       assert( it->first < requestUID );
       it->first = requestUID;
       }
+    this->LastRequestsLock.Unlock();
   }
   int GetLastRequest(vtkMRMLCommandLineModuleNode* node)
   {
+    this->LastRequestsLock.Lock();
     RequestType::iterator it = std::find_if(
       this->LastRequests.begin(), this->LastRequests.end(), FindRequest(node));
-    return (it != this->LastRequests.end())? it->first : 0;
+    int requestUID = (it != this->LastRequests.end())? it->first : 0;
+    this->LastRequestsLock.Unlock();
+    return requestUID;
+  }
+  /// Remove the request and return the node that made it, 0 if the request
+  /// is not a last request.
+  vtkMRMLCommandLineModuleNode* TakeLastRequest(int requestUID)
+  {
+    this->LastRequestsLock.Lock();
+    vtkMRMLCommandLineModuleNode* node = 0;
+    RequestType::iterator it = std::find_if(
+      this->LastRequests.begin(), this->LastRequests.end(), FindRequest(requestUID));
+    if (it != this->LastRequests.end())
+      {
+      node = it->second;
+      this->LastRequests.erase(it);
+      }
+    this->LastRequestsLock.Unlock();
+    return node;
   }
 
   /// Install the reschedule callback on a node and its references
@@ -408,7 +488,10 @@ public:
 
   /// List of read data/scene requests of the CLI nodes
   /// being executed with their.
+  /// Several CLIs can run at the same time, access is protected by
+  /// LastRequestsLock.
   RequestType LastRequests;
+  itk::SimpleMutexLock LastRequestsLock;
 
   vtkSmartPointer<vtkSlicerCLIRescheduleCallback> RescheduleCallback;
   vtkSmartPointer<vtkSlicerCLIOneShotCallbackCallback>OneShotCallbackCallback;
@@ -425,6 +508,7 @@ vtkSlicerCLIModuleLogic::vtkSlicerCLIModuleLogic()
   this->Internal->ProcessesKillLock = itk::MutexLock::New();
   this->Internal->DeleteTemporaryFiles = 1;
   this->Internal->RedirectModuleStreams = 1;
+  this->Internal->SharedMemoryImageTransfer = 0;
   this->Internal->RescheduleCallback =
     vtkSmartPointer<vtkSlicerCLIRescheduleCallback>::New();
   this->Internal->RescheduleCallback->SetCLIModuleLogic(this);
@@ -540,6 +624,35 @@ int vtkSlicerCLIModuleLogic::GetRedirectModuleStreams() const
   return this->Internal->RedirectModuleStreams;
 }
 
+//----------------------------------------------------------------------------
+void vtkSlicerCLIModuleLogic::SharedMemoryImageTransferOn()
+{
+  this->SetSharedMemoryImageTransfer(static_cast<int>(1));
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerCLIModuleLogic::SharedMemoryImageTransferOff()
+{
+  this->SetSharedMemoryImageTransfer(static_cast<int>(0));
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerCLIModuleLogic::SetSharedMemoryImageTransfer(int value)
+{
+  vtkDebugMacro(<< this->GetClassName() << " (" << this << "): setting SharedMemoryImageTransfer to " << value);
+  if (this->Internal->SharedMemoryImageTransfer != value)
+    {
+    this->Internal->SharedMemoryImageTransfer = value;
+    this->Modified();
+    }
+}
+
+//----------------------------------------------------------------------------
+int vtkSlicerCLIModuleLogic::GetSharedMemoryImageTransfer() const
+{
+  return this->Internal->SharedMemoryImageTransfer;
+}
+
 //----------------------------------------------------------------------------
 std::string
 vtkSlicerCLIModuleLogic
@@ -587,14 +700,56 @@ vtkSlicerCLIModuleLogic
   return fname;
 }
 
+//----------------------------------------------------------------------------
+bool vtkSlicerCLIModuleLogic
+::WriteSharedMemoryImage(vtkMRMLNode* node, const std::string& fileName)
+{
+  if (!node || !node->GetScene())
+    {
+    return false;
+    }
+  // MRMLIDImageIO describes the image data of the node without copying it
+  char nodeURI[256];
+  sprintf(nodeURI, "slicer:%p#", node->GetScene());
+  std::string nodeFileName = std::string(nodeURI) + node->GetID();
+
+  itk::MRMLIDImageIO::Pointer nodeIO = itk::MRMLIDImageIO::New();
+  itk::SharedMemoryImageIO::Pointer sharedMemoryIO = itk::SharedMemoryImageIO::New();
+  if (!nodeIO->CanReadFile(nodeFileName.c_str()) ||
+      !sharedMemoryIO->CanWriteFile(fileName.c_str()))
+    {
+    return false;
+    }
+  try
+    {
+    nodeIO->SetFileName(nodeFileName.c_str());
+    nodeIO->ReadImageInformation();
+    sharedMemoryIO->CopyImageInformation(nodeIO);
+    sharedMemoryIO->SetFileName(fileName.c_str());
+    sharedMemoryIO->Write(nodeIO->GetOwnBuffer());
+    }
+  catch (itk::ExceptionObject& exception)
+    {
+    vtkErrorMacro("WriteSharedMemoryImage: " << exception.GetDescription());
+    return false;
+    }
+  catch (...)
+    {
+    return false;
+    }
+  return true;
+}
+
 //----------------------------------------------------------------------------
 std::string
 vtkSlicerCLIModuleLogic
 ::ConstructTemporaryFileName(const std::string& tag,
                              const std::string& type,
                              const std::string& name,
+                             const std::string& channel,
                              const std::vector<std::string>& extensions,
-                             CommandLineModuleType commandType)
+                             CommandLineModuleType commandType,
+                             const std::string& runID)
 {
   std::string fname = name;
   std::string pid;
@@ -611,19 +766,23 @@ vtkSlicerCLIModuleLogic
   // in the process space of Slicer.  The Python module can be given
   // MRML node ID's directly.
   //
-  // 3. If the consumer of the file cannot communicate directly with
+  // 3. If the consumer of the file is an executable, the node is an
+  // input scalar, label map or vector volume and SharedMemoryImageTransfer
+  // is enabled, then the image is encoded as slicer:shm#<segment name>
+  // and is passed through a shared memory segment
+  // (see itkSharedMemoryImageIO). Output volumes are always read back
+  // from files by vtkSlicerApplicationLogic.
+  //
+  // 4. If the consumer of the file cannot communicate directly with
   // the MRML scene, then a real temporary filename is constructed.
   // The filename will point to the Temporary directory defined for
   // Slicer. The filename will be unique to the process (multiple
   // running instances of slicer will not collide).  The filename
-  // will be unique to the node in the process (the same node will be
-  // encoded to the same filename every time within that running
-  // instance of Slicer).  This last point is an optimization to
-  // minimize the number of times a file is written when running a
-  // module.  However, if we change the execution model such that more
-  // than one module can run at the same time within the same Slicer
-  // process, then this encoding will need to be changed to be unique
-  // per module execution.
+  // will be unique to the module execution (runID) and to the node
+  // within that execution. Several modules can run at the same time
+  // within the same Slicer process (see
+  // vtkSlicerApplicationLogic::SetNumberOfProcessingThreads()), even on
+  // the same nodes, without sharing temporary files.
   //
 
   // Encode process id into a string.  To avoid confusing the
@@ -656,11 +815,33 @@ vtkSlicerCLIModuleLogic
     {
     temporaryDirectory = appLogic->GetTemporaryPath();
     }
-  fname = temporaryDirectory + "/" + pid + "_" + fname;
+  fname = temporaryDirectory + "/" + pid + "_" + runID + "_" + fname;
 
   if (tag == "image")
     {
-    if ( commandType == CommandLineModule || type == "dynamic-contrast-enhanced")
+    vtkMRMLNode* imageNode = this->GetMRMLScene() ?
+      this->GetMRMLScene()->GetNodeByID(name.c_str()) : 0;
+    if ( commandType == CommandLineModule && type != "dynamic-contrast-enhanced" &&
+         channel == "input" && this->GetSharedMemoryImageTransfer() &&
+         itk::SharedMemoryImageIO::IsSupported() && imageNode &&
+         (!strcmp(imageNode->GetClassName(), "vtkMRMLScalarVolumeNode") ||
+          !strcmp(imageNode->GetClassName(), "vtkMRMLLabelMapVolumeNode") ||
+          !strcmp(imageNode->GetClassName(), "vtkMRMLVectorVolumeNode")))
+      {
+      // Segment names must be short (31 characters on Mac OS X), use a
+      // process wide counter instead of the node ID to make them unique.
+      vtkTimeStamp segmentStamp;
+      segmentStamp.Modified();
+      std::ostringstream segmentName;
+#ifdef _WIN32
+      segmentName << "Slicer" << GetCurrentProcessId();
+#else
+      segmentName << "Slicer" << getpid();
+#endif
+      segmentName << "_" << segmentStamp.GetMTime();
+      fname = itk::SharedMemoryImageIO::GetSharedMemoryFileName(segmentName.str());
+      }
+    else if ( commandType == CommandLineModule || type == "dynamic-contrast-enhanced")
       {
       // If running an executable
 
@@ -822,6 +1003,10 @@ void vtkSlicerCLIModuleLogic::Apply ( vtkMRMLCommandLineModuleNode* node, bool u
   node->Register(this);
   node->SetAttribute("UpdateDisplay", updateDisplay ? "true" : "false");
 
+  // Number of runs that will start before this one
+  node->SetQueueDepth(this->GetApplicationLogic()->GetNumberOfScheduledTasks(
+    vtkSlicerTask::Processing));
+
   // Schedule the task
   ret = this->GetApplicationLogic()->ScheduleTask( task.GetPointer() );
 
@@ -1018,6 +1203,19 @@ void vtkSlicerCLIModuleLogic::ApplyTask(void *clientdata)
   // vector of files to delete
   std::set<std::string> filesToDelete;
 
+  // Identifier of this execution, used to make the temporary files unique
+  // when several modules run at the same time. To avoid confusing the
+  // Archetype readers, the numbers are converted to characters [0-9]->[A-J]
+  vtkTimeStamp runStamp;
+  runStamp.Modified();
+  std::ostringstream runIDString;
+  runIDString << runStamp.GetMTime();
+  std::string runID = runIDString.str();
+  std::transform(runID.begin(), runID.end(), runID.begin(), DigitsToCharacters());
+
+  // No memory usage is reported for modules that are not run as executables
+  node0->SetLastRunPeakMemoryUsage(0);
+
   // iterators for parameter groups
   std::vector<ModuleParameterGroup>::iterator pgbeginit
     = node0->GetModuleDescription().GetParameterGroups().begin();
@@ -1064,8 +1262,9 @@ void vtkSlicerCLIModuleLogic::ApplyTask(void *clientdata)
           = this->ConstructTemporaryFileName((*pit).GetTag(),
                                              (*pit).GetType(),
                                              id,
+                                             (*pit).GetChannel(),
                                              (*pit).GetFileExtensions(),
-                                             commandType);
+                                             commandType, runID);
 
         filesToDelete.insert(fname);
         if ((*pit).GetChannel() == "input")
@@ -1189,7 +1388,7 @@ void vtkSlicerCLIModuleLogic::ApplyTask(void *clientdata)
     vtkMRMLModelHierarchyNode *mhnd = vtkMRMLModelHierarchyNode::SafeDownCast(nd);
     if (mhnd)
       {
-      this->AddCompleteModelHierarchyToMiniScene(miniscene.GetPointer(), mhnd, &sceneToMiniSceneMap, filesToDelete);
+      this->AddCompleteModelHierarchyToMiniScene(miniscene.GetPointer(), mhnd, &sceneToMiniSceneMap, filesToDelete, runID);
       }
 
     // check for a point file that may need to set a coordinate system flag
@@ -1215,6 +1414,18 @@ void vtkSlicerCLIModuleLogic::ApplyTask(void *clientdata)
         }
       }
 
+    // images exchanged through shared memory are copied directly from
+    // the node to the segment
+    if (commandType == CommandLineModule &&
+        itk::SharedMemoryImageIO::IsSharedMemoryFileName((*id2fn0).second))
+      {
+      out = 0;
+      if (!this->WriteSharedMemoryImage(nd, (*id2fn0).second))
+        {
+        vtkErrorMacro("ERROR writing shared memory image " << (*id2fn0).second);
+        }
+      }
+
     // if the file is to be written, then write it
     if (out)
       {
@@ -1374,7 +1585,7 @@ void vtkSlicerCLIModuleLogic::ApplyTask(void *clientdata)
       code << alphanum[rand() % (sizeof(alphanum)-1)];
       }
     std::string returnFile = temporaryDirectory + "/" + pidString.str()
-      + "_" + code.str() + ".params";
+      + "_" + runID + "_" + code.str() + ".params";
 
     commandLineAsString.push_back( returnFile );
 
@@ -1929,9 +2140,43 @@ void vtkSlicerCLIModuleLogic::ApplyTask(void *clientdata)
     // statically linked to the executable.
     // Historically, there was an nvidia driver bug that causes the module
     // to fail on exit with undefined symbol.
+    // If images are exchanged through shared memory, only the ITK-only
+    // MRMLSharedMemoryIOPlugin located in the "SharedMemory" subdirectory
+    // of the factory directories is loaded.
+     EnvironmentLock.Lock();
      std::string saveITKAutoLoadPath;
      itksys::SystemTools::GetEnv("ITK_AUTOLOAD_PATH", saveITKAutoLoadPath);
      std::string emptyString("ITK_AUTOLOAD_PATH=");
+     bool usesSharedMemory = false;
+     for (std::set<std::string>::const_iterator fit = filesToDelete.begin();
+          fit != filesToDelete.end() && !usesSharedMemory; ++fit)
+       {
+       usesSharedMemory = itk::SharedMemoryImageIO::IsSharedMemoryFileName(*fit);
+       }
+     if (usesSharedMemory)
+       {
+#ifdef _WIN32
+       const char pathSeparator = ';';
+#else
+       const char pathSeparator = ':';
+#endif
+       std::vector<std::string> factoryDirectories;
+       itksys::SystemTools::Split(saveITKAutoLoadPath.c_str(), factoryDirectories, pathSeparator);
+       std::string sharedMemoryFactoryDirectories;
+       for (std::vector<std::string>::size_type i = 0; i < factoryDirectories.size(); ++i)
+         {
+         if (factoryDirectories[i].empty())
+           {
+           continue;
+           }
+         if (!sharedMemoryFactoryDirectories.empty())
+           {
+           sharedMemoryFactoryDirectories += pathSeparator;
+           }
+         sharedMemoryFactoryDirectories += factoryDirectories[i] + "/SharedMemory";
+         }
+       emptyString += sharedMemoryFactoryDirectories;
+       }
      int putSuccess =
        itksys::SystemTools::PutEnv(const_cast <char *> (emptyString.c_str()));
      if (!putSuccess)
@@ -1943,7 +2188,9 @@ void vtkSlicerCLIModuleLogic::ApplyTask(void *clientdata)
     //
     itksysProcess *process = itksysProcess_New();
 
+    this->Internal->ProcessesKillLock->Lock();
     this->Internal->Processes.push_back(process);
+    this->Internal->ProcessesKillLock->Unlock();
 
     // setup the command
     itksysProcess_SetCommand(process, command);
@@ -1965,6 +2212,7 @@ void vtkSlicerCLIModuleLogic::ApplyTask(void *clientdata)
       {
       vtkErrorMacro( "Unable to restore ITK_AUTOLOAD_PATH. ");
       }
+    EnvironmentLock.Unlock();
 
     // Wait for the command to finish
     char *tbuffer;
@@ -1976,12 +2224,17 @@ void vtkSlicerCLIModuleLogic::ApplyTask(void *clientdata)
     std::string stderrbuffer;
     std::string::size_type tagend;
     std::string::size_type tagstart;
+    // The executable is the only process started by this thread
+    unsigned long peakMemoryUsage = 0;
     while ((pipe = itksysProcess_WaitForData(process ,&tbuffer,
                                              &length, &timeout)) != 0)
       {
       // increment the elapsed time
       node0->GetModuleDescription().GetProcessInformation()->ElapsedTime
         += (timeoutlimit - timeout);
+      peakMemoryUsage =
+        std::max(peakMemoryUsage, GetChildProcessesPeakMemoryUsage());
+      node0->SetLastRunPeakMemoryUsage(peakMemoryUsage);
       this->GetApplicationLogic()->RequestModified( node0 );
 
       // reset the timeout value
@@ -1990,9 +2243,11 @@ void vtkSlicerCLIModuleLogic::ApplyTask(void *clientdata)
       // Check to see if the plugin was cancelled
       if (node0->GetModuleDescription().GetProcessInformation()->Abort)
         {
+        this->Internal->ProcessesKillLock->Lock();
         itksysProcess_Kill(process);
         this->Internal->Processes.erase(
               std::find(this->Internal->Processes.begin(), this->Internal->Processes.end(), process));
+        this->Internal->ProcessesKillLock->Unlock();
         node0->GetModuleDescription().GetProcessInformation()->Progress = 0;
         node0->GetModuleDescription().GetProcessInformation()->StageProgress =0;
         this->GetApplicationLogic()->RequestModified( node0 );
@@ -2246,6 +2501,7 @@ void vtkSlicerCLIModuleLogic::ApplyTask(void *clientdata)
     //
     //
 
+    SharedObjectModuleLock.Lock();
     std::ostringstream coutstringstream;
     std::ostringstream cerrstringstream;
     std::streambuf* origcoutrdbuf = std::cout.rdbuf();
@@ -2323,6 +2579,7 @@ void vtkSlicerCLIModuleLogic::ApplyTask(void *clientdata)
       std::cout.rdbuf( origcoutrdbuf );
       std::cerr.rdbuf( origcerrrdbuf );
       }
+    SharedObjectModuleLock.Unlock();
     if (node0->GetStatus() == vtkMRMLCommandLineModuleNode::Cancelling)
       {
       node0->SetStatus(vtkMRMLCommandLineModuleNode::Cancelled, false);
@@ -2649,7 +2906,12 @@ void vtkSlicerCLIModuleLogic::ApplyTask(void *clientdata)
     std::set<std::string>::iterator fit;
     for (fit = filesToDelete.begin(); fit != filesToDelete.end(); ++fit)
       {
-      if (itksys::SystemTools::FileExists((*fit).c_str()))
+      if (itk::SharedMemoryImageIO::IsSharedMemoryFileName(*fit))
+        {
+        // the segment does not exist if the module failed to write its output
+        itk::SharedMemoryImageIO::RemoveSharedMemory(*fit);
+        }
+      else if (itksys::SystemTools::FileExists((*fit).c_str()))
         {
         removed = itksys::SystemTools::RemoveFile((*fit).c_str());
         if (!removed)
@@ -2821,16 +3083,13 @@ void vtkSlicerCLIModuleLogic::ProcessMRMLLogicsEvents(vtkObject* caller,
       event == vtkSlicerApplicationLogic::RequestProcessedEvent)
     {
     unsigned long uid = reinterpret_cast<unsigned long>(callData);
-    vtkInternal::RequestType::iterator it =
-      std::find_if(this->Internal->LastRequests.begin(),
-      this->Internal->LastRequests.end(), vtkInternal::FindRequest(uid));
-    if (it != this->Internal->LastRequests.end())
+    vtkMRMLCommandLineModuleNode* node =
+      this->Internal->TakeLastRequest(static_cast<int>(uid));
+    if (node)
       {
-      vtkMRMLCommandLineModuleNode* node = it->second;
       // If the status is not Completing, then there should be no request made
       // on the application logic.
       assert(node->GetStatus() == vtkMRMLCommandLineModuleNode::Completing);
-      this->Internal->LastRequests.erase(it);
       // we are not interested in any request anymore because the cli node is
       // Completed.
 
@@ -2945,7 +3204,8 @@ void vtkSlicerCLIModuleLogic
 }
 
 void vtkSlicerCLIModuleLogic::AddCompleteModelHierarchyToMiniScene(vtkMRMLScene *miniscene, vtkMRMLModelHierarchyNode *mhnd,
-                                                                   MRMLIDMap *sceneToMiniSceneMap, std::set<std::string> &filesToDelete)
+                                                                   MRMLIDMap *sceneToMiniSceneMap, std::set<std::string> &filesToDelete,
+                                                                   const std::string& runID)
 {
     if (mhnd)
       {
@@ -3031,8 +3291,8 @@ void vtkSlicerCLIModuleLogic::AddCompleteModelHierarchyToMiniScene(vtkMRMLScene
 
                 vtkMRMLModelStorageNode *s = vtkMRMLModelStorageNode::SafeDownCast(mscp);
                 std::string fname
-                    = this->ConstructTemporaryFileName("geometry", "", tmcp->GetID(), std::vector<std::string>(),
-                                                                                  CommandLineModule);
+                    = this->ConstructTemporaryFileName("geometry", "", tmcp->GetID(), "", std::vector<std::string>(),
+                                                                                  CommandLineModule, runID);
 
                 s->SetFileName(fname.c_str());
                 filesToDelete.insert(fname);
@@ -82,9 +82,25 @@ public:
   void SetRedirectModuleStreams(int value);
   int GetRedirectModuleStreams() const;
 
+  /// Control whether input scalar, label map and vector volumes are passed
+  /// to executable CLIs through shared memory instead of temporary files.
+  /// Output volumes are always written to temporary files.
+  /// If shared memory is not supported on the platform, files are used.
+  /// Off by default.
+  /// \sa itk::SharedMemoryImageIO
+  virtual void SharedMemoryImageTransferOn();
+  virtual void SharedMemoryImageTransferOff();
+  void SetSharedMemoryImageTransfer(int value);
+  int GetSharedMemoryImageTransfer() const;
+
   /// Schedules the command line module to run.
   /// The CLI is scheduled to be run in a separate thread. This methods
   /// is non blocking and returns immediately.
+  /// Up to vtkSlicerApplicationLogic::GetNumberOfProcessingThreads() CLIs
+  /// run at the same time, the others wait in the queue. Each execution
+  /// uses its own temporary files. Shared object modules are run one at
+  /// a time because they share the process standard streams.
+  /// \sa vtkMRMLCommandLineModuleNode::GetQueueDepth()
   /// If \a updateDisplay is 'true' the selection node will be updated with the
   /// the created nodes, which would automatically select the created nodes
   /// in the node selectors.
@@ -119,12 +135,20 @@ protected:
   void ProcessMRMLLogicsEvents(vtkObject*, long unsigned int, void*);
 
 
+  /// Return the name of the file used to pass the node \a name to the
+  /// module. \a channel is the channel ("input" or "output") of the
+  /// parameter. \a runID is unique to the module execution.
   std::string ConstructTemporaryFileName(const std::string& tag,
                                          const std::string& type,
                                          const std::string& name,
+                                         const std::string& channel,
                                      const std::vector<std::string>& extensions,
-                                     CommandLineModuleType commandType);
+                                     CommandLineModuleType commandType,
+                                     const std::string& runID);
   std::string ConstructTemporarySceneFileName(vtkMRMLScene *scene);
+  /// Copy the image of a volume node into the shared memory segment
+  /// designated by \a fileName. Returns false on failure.
+  bool WriteSharedMemoryImage(vtkMRMLNode* node, const std::string& fileName);
   std::string FindHiddenNodeID(const ModuleDescription& d,
                                const ModuleParameter& p);
 
@@ -150,7 +174,7 @@ protected:
   // Add a model hierarchy node and all its descendents to a scene (miniscene to sent to a CLI).
   // The mapping of ids from the original scene to the mini scene is put in (added to) sceneToMiniSceneMap.
   // Any files that will be created by writing out the miniscene are added to filesToDelete (i.e. models)
-  void AddCompleteModelHierarchyToMiniScene(vtkMRMLScene*, vtkMRMLModelHierarchyNode*, MRMLIDMap* sceneToMiniSceneMap, std::set<std::string> &filesToDelete);
+  void AddCompleteModelHierarchyToMiniScene(vtkMRMLScene*, vtkMRMLModelHierarchyNode*, MRMLIDMap* sceneToMiniSceneMap, std::set<std::string> &filesToDelete, const std::string& runID);
 
 private:
   vtkSlicerCLIModuleLogic();
@@ -20,6 +20,7 @@
 
 // Qt includes
 #include <QDir>
+#include <QTime>
 
 // SlicerQt includes
 #include "qSlicerCoreApplication.h"
@@ -40,6 +41,7 @@ public:
   qSlicerAbstractModuleFactoryManagerPrivate(qSlicerAbstractModuleFactoryManager& object);
 
   void printAdditionalInfo();
+  void printTimingReport()const;
 
   typedef qSlicerAbstractModuleFactoryManager::qSlicerModuleFactory
     qSlicerModuleFactory;
@@ -56,6 +58,19 @@ public:
   QMap<QString, qSlicerModuleFactory*> RegisteredModules;
   QMap<QString, QStringList> ModuleDependees;
 
+  /// Time spent (in ms) and number of modules registered and instantiated
+  /// by each factory.
+  struct FactoryTiming
+  {
+    FactoryTiming() : RegisteredModules(0), RegistrationTime(0),
+      InstantiatedModules(0), InstantiationTime(0) {}
+    int RegisteredModules;
+    int RegistrationTime;
+    int InstantiatedModules;
+    int InstantiationTime;
+  };
+  QMap<qSlicerModuleFactory*, FactoryTiming> FactoryTimings;
+
   bool Verbose;
 };
 
@@ -83,6 +98,23 @@ void qSlicerAbstractModuleFactoryManagerPrivate::printAdditionalInfo()
   qDebug() << "Registered modules:" << q->registeredModuleNames();
   qDebug() << "Ignored modules:" << q->ignoredModuleNames();
   qDebug() << "Instantiated modules:" << q->instantiatedModuleNames();
+  this->printTimingReport();
+}
+
+//-----------------------------------------------------------------------------
+void qSlicerAbstractModuleFactoryManagerPrivate::printTimingReport()const
+{
+  qDebug() << "Module factory timings:";
+  foreach(qSlicerModuleFactory* factory, this->FactoryTimings.keys())
+    {
+    const FactoryTiming& timing = this->FactoryTimings[factory];
+    qDebug() << "\t" << typeid(*factory).name() << ":"
+             << qPrintable(QString("%1 modules registered in %2s, %3 modules instantiated in %4s")
+                           .arg(timing.RegisteredModules)
+                           .arg(QString::number(timing.RegistrationTime / 1000.0, 'f', 2))
+                           .arg(timing.InstantiatedModules)
+                           .arg(QString::number(timing.InstantiationTime / 1000.0, 'f', 2)));
+    }
 }
 
 //-----------------------------------------------------------------------------
@@ -155,6 +187,7 @@ void qSlicerAbstractModuleFactoryManager::unregisterFactory(qSlicerModuleFactory
   Q_D(qSlicerAbstractModuleFactoryManager);
   Q_ASSERT(d->Factories.contains(factory));
   d->Factories.remove(factory);
+  d->FactoryTimings.remove(factory);
   delete factory;
 }
 
@@ -237,7 +270,11 @@ void qSlicerAbstractModuleFactoryManager::registerModules()
   // \todo: don't support factories other than filebased factories
   foreach(qSlicerModuleFactory* factory, d->notFileBasedFactories())
     {
+    QTime timeProbe;
+    timeProbe.start();
     factory->registerItems();
+    d->FactoryTimings[factory].RegistrationTime += timeProbe.elapsed();
+    d->FactoryTimings[factory].RegisteredModules += factory->itemKeys().count();
     foreach(const QString& moduleName, factory->itemKeys())
       {
       if (d->Verbose)
@@ -331,7 +368,12 @@ void qSlicerAbstractModuleFactoryManager::registerModule(const QFileInfo& file)
     emit moduleIgnored(moduleName);
     return;
     }
+  // Registering a file can be expensive (e.g. loading a library), it is
+  // accounted in the timing report of the factory.
+  QTime timeProbe;
+  timeProbe.start();
   QString registeredModuleName = moduleFactory->registerFileItem(file);
+  d->FactoryTimings[moduleFactory].RegistrationTime += timeProbe.elapsed();
   if (registeredModuleName != moduleName)
     {
     //qDebug() << "Ignore module" << moduleName;
@@ -344,6 +386,7 @@ void qSlicerAbstractModuleFactoryManager::registerModule(const QFileInfo& file)
     return;
     }
   d->RegisteredModules[moduleName] = moduleFactory;
+  ++d->FactoryTimings[moduleFactory].RegisteredModules;
   if (!dontEmitSignal)
     {
     emit moduleRegistered(moduleName);
@@ -369,6 +412,11 @@ void qSlicerAbstractModuleFactoryManager::instantiateModules()
   signal(SIGINT, SIG_DFL);
   #endif
 
+  if (d->Verbose)
+    {
+    d->printTimingReport();
+    }
+
   emit this->modulesInstantiated(this->instantiatedModuleNames());
 }
 
@@ -379,9 +427,13 @@ qSlicerAbstractCoreModule* qSlicerAbstractModuleFactoryManager
   Q_D(qSlicerAbstractModuleFactoryManager);
   Q_ASSERT(d->RegisteredModules.contains(moduleName));
   qSlicerModuleFactory* factory = d->RegisteredModules[moduleName];
+  QTime timeProbe;
+  timeProbe.start();
   qSlicerAbstractCoreModule* module = factory->instantiate(moduleName);
+  d->FactoryTimings[factory].InstantiationTime += timeProbe.elapsed();
   if (module)
     {
+    ++d->FactoryTimings[factory].InstantiatedModules;
     module->setName(moduleName);
     module->setObjectName(QString("%1Module").arg(moduleName));
     foreach(const QString& associatedNodeType, module->associatedNodeTypes())
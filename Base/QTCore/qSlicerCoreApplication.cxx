@@ -31,6 +31,7 @@
 #include <QNetworkProxyFactory>
 #include <QResource>
 #include <QSettings>
+#include <QThread>
 #include <QTranslator>
 
 // For:
@@ -273,6 +274,12 @@ void qSlicerCoreApplicationPrivate::init()
   // in MRMLApplicationLogic.
   //this->AppLogic->ProcessMRMLEvents(scene, vtkCommand::ModifiedEvent, NULL);
   //this->AppLogic->SetAndObserveMRMLScene(scene);
+  // CLI modules are run by the processing threads. Running more of them
+  // at the same time than there are cores would only slow them all down.
+  int numberOfConcurrentCLIs =
+    q->userSettings()->value("Modules/NumberOfConcurrentCLIs", 1).toInt();
+  this->AppLogic->SetNumberOfProcessingThreads(
+    qBound(1, numberOfConcurrentCLIs, qMax(1, QThread::idealThreadCount())));
   this->AppLogic->CreateProcessingThread();
 
   // Set up Slicer to use the system proxy
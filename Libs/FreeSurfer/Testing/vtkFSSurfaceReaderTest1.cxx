@@ -0,0 +1,398 @@
+/*=auto=========================================================================
+
+  Portions (c) Copyright 2005 Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Program:   3D Slicer
+
+=========================================================================auto=*/
+
+// FreeSurfer includes
+#include "vtkFSIO.h"
+#include "vtkFSSurfaceReader.h"
+#include "vtkFSSurfaceScalarReader.h"
+
+// VTK includes
+#include <vtkCellArray.h>
+#include <vtkFloatArray.h>
+#include <vtkNew.h>
+#include <vtkPoints.h>
+#include <vtkPolyData.h>
+#include <vtkTimerLog.h>
+
+// STD includes
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+// Vertices on a noisy sphere, faces connecting consecutive vertices.
+void CreateSurface(int numVertices, int numVerticesPerFace, int numFaces,
+                   std::vector<float>& coordinates, std::vector<int>& indices)
+{
+  coordinates.resize(3 * static_cast<size_t>(numVertices));
+  unsigned int random = 1;
+  for (size_t i = 0; i < coordinates.size(); ++i)
+    {
+    random = random * 1103515245u + 12345u;
+    coordinates[i] = static_cast<float>((random >> 8) % 200000) / 1000.f - 100.f;
+    }
+  indices.resize(static_cast<size_t>(numVerticesPerFace) * numFaces);
+  for (size_t i = 0; i < indices.size(); ++i)
+    {
+    indices[i] = static_cast<int>((i / numVerticesPerFace + i % numVerticesPerFace) % numVertices);
+    }
+}
+
+//----------------------------------------------------------------------------
+bool WriteTriangleSurface(const std::string& fileName,
+                          const std::vector<float>& coordinates,
+                          const std::vector<int>& indices)
+{
+  FILE* file = fopen(fileName.c_str(), "wb");
+  if (!file)
+    {
+    return false;
+    }
+  vtkFSIO::WriteInt3(file, vtkFSSurfaceReader::FS_TRIANGLE_FILE_MAGIC_NUMBER);
+  fputs("created by vtkFSSurfaceReaderTest1\n\n", file);
+  vtkFSIO::WriteInt(file, static_cast<int>(coordinates.size() / 3));
+  vtkFSIO::WriteInt(file, static_cast<int>(indices.size() / 3));
+  for (size_t i = 0; i < coordinates.size(); ++i)
+    {
+    vtkFSIO::WriteFloat(file, coordinates[i]);
+    }
+  for (size_t i = 0; i < indices.size(); ++i)
+    {
+    vtkFSIO::WriteInt(file, indices[i]);
+    }
+  fclose(file);
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool WriteQuadSurface(const std::string& fileName,
+                      const std::vector<float>& coordinates,
+                      const std::vector<int>& indices)
+{
+  FILE* file = fopen(fileName.c_str(), "wb");
+  if (!file)
+    {
+    return false;
+    }
+  vtkFSIO::WriteInt3(file, vtkFSSurfaceReader::FS_NEW_QUAD_FILE_MAGIC_NUMBER);
+  vtkFSIO::WriteInt3(file, static_cast<int>(coordinates.size() / 3));
+  vtkFSIO::WriteInt3(file, static_cast<int>(indices.size() / 4));
+  for (size_t i = 0; i < coordinates.size(); ++i)
+    {
+    vtkFSIO::WriteFloat(file, coordinates[i]);
+    }
+  for (size_t i = 0; i < indices.size(); ++i)
+    {
+    vtkFSIO::WriteInt3(file, indices[i]);
+    }
+  fclose(file);
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool WriteCurv(const std::string& fileName, const std::vector<float>& values,
+               int numFaces)
+{
+  FILE* file = fopen(fileName.c_str(), "wb");
+  if (!file)
+    {
+    return false;
+    }
+  vtkFSIO::WriteInt3(file, vtkFSSurfaceScalarReader::FS_NEW_SCALAR_MAGIC_NUMBER);
+  vtkFSIO::WriteInt(file, static_cast<int>(values.size()));
+  vtkFSIO::WriteInt(file, numFaces);
+  vtkFSIO::WriteInt(file, 1);
+  for (size_t i = 0; i < values.size(); ++i)
+    {
+    vtkFSIO::WriteFloat(file, values[i]);
+    }
+  fclose(file);
+  return true;
+}
+
+//----------------------------------------------------------------------------
+// Read a triangle surface the way vtkFSSurfaceReader used to: one read and
+// one byte swap per coordinate and index, inserted one by one.
+bool ReadTriangleSurfaceElementWise(const std::string& fileName,
+                                    vtkPolyData* output)
+{
+  FILE* file = fopen(fileName.c_str(), "rb");
+  if (!file)
+    {
+    return false;
+    }
+  int magicNumber = 0;
+  vtkFSIO::ReadInt3(file, magicNumber);
+  // The header comment line is followed by an empty line
+  char line[256];
+  if (magicNumber != vtkFSSurfaceReader::FS_TRIANGLE_FILE_MAGIC_NUMBER ||
+      fgets(line, sizeof(line), file) == NULL || fgetc(file) != '\n')
+    {
+    fclose(file);
+    return false;
+    }
+  int numVertices = 0;
+  int numFaces = 0;
+  vtkFSIO::ReadInt(file, numVertices);
+  vtkFSIO::ReadInt(file, numFaces);
+  vtkNew<vtkPoints> points;
+  points->Allocate(numVertices);
+  for (int i = 0; i < numVertices; ++i)
+    {
+    float location[3];
+    vtkFSIO::ReadFloat(file, location[0]);
+    vtkFSIO::ReadFloat(file, location[1]);
+    vtkFSIO::ReadFloat(file, location[2]);
+    points->InsertNextPoint(location);
+    }
+  vtkNew<vtkCellArray> cells;
+  cells->Allocate(cells->EstimateSize(numFaces, 3));
+  for (int i = 0; i < numFaces; ++i)
+    {
+    vtkIdType faceIndices[3];
+    for (int j = 0; j < 3; ++j)
+      {
+      int index = 0;
+      vtkFSIO::ReadInt(file, index);
+      faceIndices[j] = index;
+      }
+    cells->InsertNextCell(3, faceIndices);
+    }
+  fclose(file);
+  output->SetPoints(points.GetPointer());
+  output->SetPolys(cells.GetPointer());
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool CheckSurface(int line, vtkPolyData* surface,
+                  const std::vector<float>& coordinates,
+                  const std::vector<int>& indices, int numVerticesPerFace)
+{
+  const vtkIdType numVertices = static_cast<vtkIdType>(coordinates.size() / 3);
+  const vtkIdType numFaces =
+    static_cast<vtkIdType>(indices.size() / numVerticesPerFace);
+  if (!surface->GetPoints() || !surface->GetPolys() ||
+      surface->GetNumberOfPoints() != numVertices ||
+      surface->GetPolys()->GetNumberOfCells() != numFaces)
+    {
+    std::cerr << "Line " << line << " - Wrong number of points or cells: "
+              << surface->GetNumberOfPoints() << " " << surface->GetNumberOfPolys()
+              << " instead of " << numVertices << " " << numFaces << std::endl;
+    return false;
+    }
+  for (vtkIdType i = 0; i < numVertices; ++i)
+    {
+    double point[3];
+    surface->GetPoint(i, point);
+    for (int j = 0; j < 3; ++j)
+      {
+      if (point[j] != coordinates[3 * i + j])
+        {
+        std::cerr << "Line " << line << " - Wrong coordinate " << j
+                  << " of point " << i << ": " << point[j] << " instead of "
+                  << coordinates[3 * i + j] << std::endl;
+        return false;
+        }
+      }
+    }
+  vtkIdType npts = 0;
+  vtkIdType* pts = 0;
+  vtkCellArray* polys = surface->GetPolys();
+  polys->InitTraversal();
+  for (vtkIdType i = 0; polys->GetNextCell(npts, pts); ++i)
+    {
+    if (npts != numVerticesPerFace)
+      {
+      std::cerr << "Line " << line << " - Wrong number of points in cell "
+                << i << ": " << npts << std::endl;
+      return false;
+      }
+    for (int j = 0; j < numVerticesPerFace; ++j)
+      {
+      if (pts[j] != indices[numVerticesPerFace * i + j])
+        {
+        std::cerr << "Line " << line << " - Wrong point " << j << " of cell "
+                  << i << ": " << pts[j] << " instead of "
+                  << indices[numVerticesPerFace * i + j] << std::endl;
+        return false;
+        }
+      }
+    }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool Truncate(const std::string& fileName, const std::string& truncatedFileName,
+              long size)
+{
+  FILE* file = fopen(fileName.c_str(), "rb");
+  FILE* truncatedFile = fopen(truncatedFileName.c_str(), "wb");
+  if (!file || !truncatedFile)
+    {
+    return false;
+    }
+  std::vector<char> buffer(size);
+  const bool success =
+    fread(&buffer[0], 1, size, file) == static_cast<size_t>(size) &&
+    fwrite(&buffer[0], 1, size, truncatedFile) == static_cast<size_t>(size);
+  fclose(file);
+  fclose(truncatedFile);
+  return success;
+}
+
+}
+
+//----------------------------------------------------------------------------
+// Usage: vtkFSSurfaceReaderTest1 <temporary directory> [number of vertices]
+// If a number of vertices is given, the read times are printed to compare
+// the readers with the element-wise reference.
+int vtkFSSurfaceReaderTest1(int argc, char * argv[] )
+{
+  if (argc < 2)
+    {
+    std::cerr << "Usage: " << argv[0] << " <temporary directory>"
+              << " [number of vertices]" << std::endl;
+    return EXIT_FAILURE;
+    }
+  const std::string tempDir = argv[1];
+  // Enough vertices and faces to be read in several blocks
+  const bool printTimings = (argc > 2);
+  const int numVertices = (printTimings ? atoi(argv[2]) : 70000);
+  const int numTriangles = 2 * numVertices - 4;
+
+  std::vector<float> coordinates;
+  std::vector<int> indices;
+  CreateSurface(numVertices, 3, numTriangles, coordinates, indices);
+  const std::string triangleFileName = tempDir + "/vtkFSSurfaceReaderTest1.pial";
+  if (!WriteTriangleSurface(triangleFileName, coordinates, indices))
+    {
+    std::cerr << "Line " << __LINE__ << " - Can't write " << triangleFileName << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Reference: read the values one by one
+  vtkNew<vtkTimerLog> timer;
+  vtkNew<vtkPolyData> elementWiseSurface;
+  timer->StartTimer();
+  const bool elementWiseRead =
+    ReadTriangleSurfaceElementWise(triangleFileName, elementWiseSurface.GetPointer());
+  timer->StopTimer();
+  const double elementWiseTime = timer->GetElapsedTime();
+  if (!elementWiseRead ||
+      !CheckSurface(__LINE__, elementWiseSurface.GetPointer(), coordinates, indices, 3))
+    {
+    std::cerr << "Line " << __LINE__ << " - Wrong reference surface" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Triangle surface
+  vtkNew<vtkFSSurfaceReader> reader;
+  reader->SetFileName(triangleFileName.c_str());
+  timer->StartTimer();
+  reader->Update();
+  timer->StopTimer();
+  const double bulkTime = timer->GetElapsedTime();
+  if (!CheckSurface(__LINE__, reader->GetOutput(), coordinates, indices, 3))
+    {
+    return EXIT_FAILURE;
+    }
+  if (printTimings)
+    {
+    std::cout << numVertices << " vertices, " << numTriangles << " triangles: "
+              << "element-wise read: " << elementWiseTime << "s, "
+              << "vtkFSSurfaceReader: " << bulkTime << "s" << std::endl;
+    }
+
+  // New quad surface, with three byte indices
+  const int numQuads = numVertices - 2;
+  std::vector<int> quadIndices;
+  CreateSurface(numVertices, 4, numQuads, coordinates, quadIndices);
+  const std::string quadFileName = tempDir + "/vtkFSSurfaceReaderTest1.quad";
+  if (!WriteQuadSurface(quadFileName, coordinates, quadIndices))
+    {
+    std::cerr << "Line " << __LINE__ << " - Can't write " << quadFileName << std::endl;
+    return EXIT_FAILURE;
+    }
+  vtkNew<vtkFSSurfaceReader> quadReader;
+  quadReader->SetFileName(quadFileName.c_str());
+  quadReader->Update();
+  if (!CheckSurface(__LINE__, quadReader->GetOutput(), coordinates, quadIndices, 4))
+    {
+    return EXIT_FAILURE;
+    }
+
+  // Truncated surface: no partial output
+  const std::string truncatedFileName = tempDir + "/vtkFSSurfaceReaderTest1.truncated";
+  if (!Truncate(triangleFileName, truncatedFileName, 1000))
+    {
+    std::cerr << "Line " << __LINE__ << " - Can't write " << truncatedFileName << std::endl;
+    return EXIT_FAILURE;
+    }
+  vtkNew<vtkFSSurfaceReader> truncatedReader;
+  truncatedReader->SetFileName(truncatedFileName.c_str());
+  vtkObject::GlobalWarningDisplayOff();
+  truncatedReader->Update();
+  vtkObject::GlobalWarningDisplayOn();
+  if (truncatedReader->GetOutput()->GetNumberOfPoints() != 0 ||
+      truncatedReader->GetOutput()->GetNumberOfCells() != 0)
+    {
+    std::cerr << "Line " << __LINE__ << " - Truncated surface read" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Curvature overlay
+  std::vector<float> values(coordinates.begin(), coordinates.begin() + numVertices);
+  const std::string curvFileName = tempDir + "/vtkFSSurfaceReaderTest1.curv";
+  if (!WriteCurv(curvFileName, values, numTriangles))
+    {
+    std::cerr << "Line " << __LINE__ << " - Can't write " << curvFileName << std::endl;
+    return EXIT_FAILURE;
+    }
+  vtkNew<vtkFloatArray> scalars;
+  vtkNew<vtkFSSurfaceScalarReader> scalarReader;
+  scalarReader->SetFileName(curvFileName.c_str());
+  scalarReader->SetOutput(scalars.GetPointer());
+  timer->StartTimer();
+  const int scalarsRead = scalarReader->ReadFSScalars();
+  timer->StopTimer();
+  if (!scalarsRead || scalars->GetNumberOfTuples() != numVertices)
+    {
+    std::cerr << "Line " << __LINE__ << " - Failed to read " << curvFileName << std::endl;
+    return EXIT_FAILURE;
+    }
+  if (printTimings)
+    {
+    std::cout << numVertices << " values: vtkFSSurfaceScalarReader: "
+              << timer->GetElapsedTime() << "s" << std::endl;
+    }
+  for (int i = 0; i < numVertices; ++i)
+    {
+    if (scalars->GetValue(i) != values[i])
+      {
+      std::cerr << "Line " << __LINE__ << " - Wrong value " << i << ": "
+                << scalars->GetValue(i) << " instead of " << values[i] << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+
+  remove(triangleFileName.c_str());
+  remove(quadFileName.c_str());
+  remove(truncatedFileName.c_str());
+  remove(curvFileName.c_str());
+
+  return EXIT_SUCCESS;
+}
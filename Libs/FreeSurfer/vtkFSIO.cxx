@@ -17,6 +17,69 @@
 
 // VTK includes
 #include <vtkByteSwap.h>
+#include <vtkType.h>
+
+namespace
+{
+
+/// Number of values read at once by the buffered bulk readers.
+const size_t ChunkSize = 16384;
+
+//------------------------------------------------------------------------------
+// Swap big endian 4 byte words in place if needed. Written with shifts on
+// unsigned ints rather than byte copies so that compilers vectorize it.
+void SwapWordsBE(void* words, size_t count)
+{
+#ifndef VTK_WORDS_BIGENDIAN
+  vtkTypeUInt32* w = static_cast<vtkTypeUInt32*>(words);
+  for (size_t i = 0; i < count; ++i)
+    {
+    const vtkTypeUInt32 v = w[i];
+    w[i] = (v >> 24) | ((v >> 8) & 0xff00) | ((v << 8) & 0xff0000) | (v << 24);
+    }
+#else
+  (void)words;
+  (void)count;
+#endif
+}
+
+//------------------------------------------------------------------------------
+// Convert big endian three byte ints.
+void ConvertInt3s(const unsigned char* bytes, int* oInts, size_t count)
+{
+  for (size_t i = 0; i < count; ++i, bytes += 3)
+    {
+    oInts[i] = (bytes[0] << 16) | (bytes[1] << 8) | bytes[2];
+    }
+}
+
+//------------------------------------------------------------------------------
+// gzread takes and returns int sizes, read large blocks in chunks.
+size_t ReadWordsZ(gzFile iFile, void* oWords, size_t count)
+{
+  char* words = static_cast<char*>(oWords);
+  size_t read = 0;
+  while (read < count)
+    {
+    const size_t toRead = (count - read < ChunkSize * 64 ?
+                           count - read : ChunkSize * 64);
+    const int result = gzread(iFile, words + 4 * read,
+                              static_cast<unsigned int>(4 * toRead));
+    if (result <= 0)
+      {
+      break;
+      }
+    read += static_cast<size_t>(result) / 4;
+    if (static_cast<size_t>(result) != 4 * toRead)
+      {
+      break;
+      }
+    }
+  SwapWordsBE(oWords, read);
+  return read;
+}
+
+}
 
 //------------------------------------------------------------------------------
 int vtkFSIO::ReadShort (FILE* iFile, short& oShort) {
@@ -94,7 +157,7 @@ int vtkFSIO::ReadInt3Z (gzFile iFile, int& oInt) {
 
   // Read three bytes. Swap if we need to. Stuff into a full sized int
   // and return.
-  result = gzread (iFile, &i, 3*sizeof(int));
+  result = gzread (iFile, &i, 3);
   vtkByteSwap::Swap4BE (&i);
   oInt = ((i>>8) & 0xffffff);
 
@@ -122,7 +185,7 @@ int vtkFSIO::ReadInt2Z (gzFile iFile, int& oInt) {
   int result ;
 
   // Read two bytes. Swap if we need to. Return the value
-  result = gzread (iFile, &i, 2*sizeof(int));
+  result = gzread (iFile, &i, 2);
   vtkByteSwap::Swap4BE (&i);
   oInt = i;
 
@@ -157,6 +220,83 @@ int vtkFSIO::ReadFloatZ (gzFile iFile, float& oFloat) {
   return result;
 }
 
+//------------------------------------------------------------------------------
+size_t vtkFSIO::ReadInts (FILE* iFile, int* oInts, size_t count) {
+
+  // Read the whole block at once, then swap it if we need to.
+  size_t result = fread (oInts, sizeof(int), count, iFile);
+  SwapWordsBE (oInts, result);
+
+  return result;
+}
+
+//------------------------------------------------------------------------------
+size_t vtkFSIO::ReadIntsZ (gzFile iFile, int* oInts, size_t count) {
+
+  return ReadWordsZ (iFile, oInts, count);
+}
+
+//------------------------------------------------------------------------------
+size_t vtkFSIO::ReadInt3s (FILE* iFile, int* oInts, size_t count) {
+
+  // Read the three byte ints by chunks and expand them to full sized ints.
+  unsigned char bytes[3 * ChunkSize];
+  size_t result = 0;
+  while (result < count)
+    {
+    size_t toRead = (count - result < ChunkSize ? count - result : ChunkSize);
+    size_t read = fread (bytes, 3, toRead, iFile);
+    ConvertInt3s (bytes, oInts + result, read);
+    result += read;
+    if (read != toRead)
+      {
+      break;
+      }
+    }
+
+  return result;
+}
+
+//------------------------------------------------------------------------------
+size_t vtkFSIO::ReadInt3sZ (gzFile iFile, int* oInts, size_t count) {
+
+  unsigned char bytes[3 * ChunkSize];
+  size_t result = 0;
+  while (result < count)
+    {
+    size_t toRead = (count - result < ChunkSize ? count - result : ChunkSize);
+    int read = gzread (iFile, bytes, static_cast<unsigned int>(3 * toRead));
+    if (read <= 0)
+      {
+      break;
+      }
+    ConvertInt3s (bytes, oInts + result, static_cast<size_t>(read) / 3);
+    result += static_cast<size_t>(read) / 3;
+    if (static_cast<size_t>(read) != 3 * toRead)
+      {
+      break;
+      }
+    }
+
+  return result;
+}
+
+//------------------------------------------------------------------------------
+size_t vtkFSIO::ReadFloats (FILE* iFile, float* oFloats, size_t count) {
+
+  // Read the whole block at once, then swap it if we need to.
+  size_t result = fread (oFloats, sizeof(float), count, iFile);
+  SwapWordsBE (oFloats, result);
+
+  return result;
+}
+
+//------------------------------------------------------------------------------
+size_t vtkFSIO::ReadFloatsZ (gzFile iFile, float* oFloats, size_t count) {
+
+  return ReadWordsZ (iFile, oFloats, count);
+}
+
 //------------------------------------------------------------------------------
 // Utility methods for writing test files
 
@@ -180,7 +320,7 @@ int vtkFSIO::WriteInt3 (FILE* oFile, int iInt)
     int i = iInt;
     int result;
 
-    i = ((i>>8) & 0xffffff);
+    i = ((i & 0xffffff) << 8);
     vtkByteSwap::Swap4BE(&i);
 
     result = fwrite(&i, 3, 1, oFile);
@@ -197,7 +337,20 @@ int vtkFSIO::WriteInt2 (FILE* oFile, int iInt)
     // swap if we need to, write two bytes, return the result
     i = iInt;
     vtkByteSwap::Swap4BE(&i);
-    result = fread(&i, 2, 1, oFile);
+    result = fwrite(&i, 2, 1, oFile);
+
+    return result;
+}
+
+//------------------------------------------------------------------------------
+int vtkFSIO::WriteFloat (FILE* oFile, float iFloat)
+{
+    float f = iFloat;
+    int result;
+
+    // swap if we need to, write a float, return the result
+    vtkByteSwap::Swap4BE(&f);
+    result = fwrite(&f, sizeof(float), 1, oFile);
 
     return result;
 }
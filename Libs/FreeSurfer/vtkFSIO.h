@@ -43,10 +43,23 @@ namespace vtkFSIO {
   int VTK_FreeSurfer_EXPORT ReadInt2Z (gzFile iFile, int& oInt);
   int VTK_FreeSurfer_EXPORT ReadFloatZ (gzFile iFile, float& oFloat);
 
+  /// Read \a count big endian values with a single read and swap them in
+  /// place if needed. Much faster than reading the values one by one for
+  /// large blocks such as vertex coordinates or face indices.
+  /// Return the number of values read, lower than \a count on error/EOF.
+  size_t VTK_FreeSurfer_EXPORT ReadInts (FILE* iFile, int* oInts, size_t count);
+  size_t VTK_FreeSurfer_EXPORT ReadInt3s (FILE* iFile, int* oInts, size_t count);
+  size_t VTK_FreeSurfer_EXPORT ReadFloats (FILE* iFile, float* oFloats, size_t count);
+
+  size_t VTK_FreeSurfer_EXPORT ReadIntsZ (gzFile iFile, int* oInts, size_t count);
+  size_t VTK_FreeSurfer_EXPORT ReadInt3sZ (gzFile iFile, int* oInts, size_t count);
+  size_t VTK_FreeSurfer_EXPORT ReadFloatsZ (gzFile iFile, float* oFloats, size_t count);
+
   /// For testing purposes
   int VTK_FreeSurfer_EXPORT WriteInt (FILE* iFile, int iInt);
   int VTK_FreeSurfer_EXPORT WriteInt3 (FILE* iFile, int iInt);
   int VTK_FreeSurfer_EXPORT WriteInt2 (FILE* iFile, int iInt);
+  int VTK_FreeSurfer_EXPORT WriteFloat (FILE* iFile, float iFloat);
 }
 
 #endif
@@ -21,6 +21,15 @@
 #include <vtkLookupTable.h>
 #include <vtkObjectFactory.h>
 
+// STD includes
+#include <algorithm>
+
+namespace
+{
+/// Number of labels read at once.
+const int ChunkSize = 65536;
+}
+
 //-------------------------------------------------------------------------
 vtkStandardNewMacro(vtkFSSurfaceAnnotationReader);
 
@@ -145,59 +154,46 @@ int vtkFSSurfaceAnnotationReader::ReadFSAnnotation()
   // table stuff.
   totalSteps = numLabels*2;
 
-  for (labelIndex = 0; labelIndex < numLabels; labelIndex ++ )
+  // Read the (vertex index, rgb value) pairs by chunks and set the
+  // appropriate values in the rgb array.
+  int* pairs = new int[2 * ChunkSize];
+  for (labelIndex = 0; labelIndex < numLabels; labelIndex += ChunkSize)
   {
-      if (feof (annotFile) )
+      const int numChunkLabels = std::min(ChunkSize, numLabels - labelIndex);
+      const size_t numRead =
+        vtkFSIO::ReadInts (annotFile, pairs, 2 * numChunkLabels);
+      if (numRead != static_cast<size_t>(2 * numChunkLabels))
       {
           vtkErrorMacro (<< "\nReadFSAnnotation: unexpected EOF after\n "
-                         << numLabels << " values read.");
+                         << labelIndex + numRead / 2 << " values read.");
+          delete [] pairs;
           fclose (annotFile);
           free (rgbs);
           free (labels);
           return vtkFSSurfaceAnnotationReader::FS_ERROR_PARSING_ANNOTATION;
       }
 
-      // Read a vertex index and an rgb value. Set the appropriate
-      // value in the rgb array.
-      read = vtkFSIO::ReadInt (annotFile, vertexIndex);
-      if (read != 1)
+      for (int i = 0; i < numChunkLabels; ++i)
       {
-          vtkErrorMacro (<< "\nReadFSAnnotation: error reading vertex index at\n"
-                         << labelIndex);
-          fclose (annotFile);
-          free (rgbs);
-          free (labels);
-          return vtkFSSurfaceAnnotationReader::FS_ERROR_PARSING_ANNOTATION;
-      }
-      read = vtkFSIO::ReadInt (annotFile, rgb);
-      if (read != 1)
-      {
-          vtkErrorMacro (<< "\nReadFSAnnotation: error reading rgb value at\n"
-                         << labelIndex);
-          fclose (annotFile);
-          free (rgbs);
-          free (labels);
-          return vtkFSSurfaceAnnotationReader::FS_ERROR_PARSING_ANNOTATION;
-      }
-      if (labelIndex < 100)
-      {
-          vtkDebugMacro(<< "ReadFSAnnotation: Read vertex # " << vertexIndex << " rgb = " << rgb << endl);
+          vertexIndex = pairs[2 * i];
+          rgb = pairs[2 * i + 1];
+          if (labelIndex + i < 100)
+          {
+              vtkDebugMacro(<< "ReadFSAnnotation: Read vertex # " << vertexIndex << " rgb = " << rgb << endl);
+          }
+          if (vertexIndex < 0 || vertexIndex >= numLabels)
+            {
+            vtkErrorMacro("ReadFSAnnotation: Read vertex # " << vertexIndex << " is out of bounds! Not in 0 to " << numLabels << " -1, rgb = " << rgb << endl);
+            }
+          else
+            {
+            rgbs[vertexIndex] = rgb;
+            }
       }
-      if (vertexIndex >= numLabels)
-        {
-        vtkErrorMacro("ReadFSAnnotation: Read vertex # " << vertexIndex << " is out of bounds! Not in 0 to " << numLabels << " -1, rgb = " << rgb << endl);
-        }
-      else
-        {
-        rgbs[vertexIndex] = rgb;
-        }
-    thisStep++;
-    if (thisStep % 1000 == 0)
-    {
-        this->UpdateProgress(1.0*thisStep/totalSteps);
-    }
+      thisStep += numChunkLabels;
+      this->UpdateProgress(1.0*thisStep/totalSteps);
   }
-
+  delete [] pairs;
 
   // Are we using an embedded or an external color table?
   vtkDebugMacro( << "ReadFSAnnotation: Are we using an external color table?\n\t" << this->UseExternalColorTableFile << endl);
@@ -21,6 +21,15 @@
 #include <vtkFloatArray.h>
 #include <vtkObjectFactory.h>
 
+// STD includes
+#include <algorithm>
+
+namespace
+{
+/// Number of values read at once.
+const int ChunkSize = 65536;
+}
+
 //-------------------------------------------------------------------------
 vtkStandardNewMacro(vtkFSSurfaceScalarReader);
 
@@ -57,7 +66,6 @@ int vtkFSSurfaceScalarReader::ReadFSScalars()
   int numValuesPerPoint = 0;
   int vIndex;
   int ivalue;
-  float fvalue;
   float *FSscalars;
   vtkFloatArray *output = this->Scalars;
 
@@ -137,41 +145,46 @@ int vtkFSSurfaceScalarReader::ReadFSScalars()
 
   // Make our float array.
   FSscalars = (float*) calloc (numValues, sizeof(float));
+  if (FSscalars == NULL) {
+    vtkErrorMacro (<< "vtkFSSurfaceScalarReader.cxx Execute: error allocating " << numValues << " floats.");
+    fclose (scalarFile);
+    return 0;
+  }
 
-  // For each value, if it's a new style file read a float, otherwise
-  // read a two byte int and divide it by 100. Add this value to the
-  // array.
-  for (vIndex = 0; vIndex < numValues; vIndex ++ ) {
-
-    if (feof(scalarFile)) {
-      vtkErrorMacro (<< "vtkFSSurfaceScalarReader.cxx Execute: Unexpected EOF after " << vIndex << " values read.");
-      return 0;
+  // If it's a new style file read all the floats at once, otherwise
+  // read two byte ints and divide them by 100.
+  if (this->FS_NEW_SCALAR_MAGIC_NUMBER == magicNumber) {
+    for (vIndex = 0; vIndex < numValues; vIndex += ChunkSize) {
+      const int numChunkValues = std::min(ChunkSize, numValues - vIndex);
+      if (vtkFSIO::ReadFloats (scalarFile, FSscalars + vIndex, numChunkValues)
+          != static_cast<size_t>(numChunkValues)) {
+        vtkErrorMacro (<< "vtkFSSurfaceScalarReader.cxx Execute: Unexpected EOF after " << vIndex << " values read.");
+        fclose (scalarFile);
+        free (FSscalars);
+        return 0;
+      }
+      this->UpdateProgress(1.0*(vIndex + numChunkValues)/numValues);
     }
 
-    if (this->FS_NEW_SCALAR_MAGIC_NUMBER == magicNumber) {
-      size_t retval = fread (&fvalue, sizeof(float), 1, scalarFile);
-      if (retval == 1)
-        {
-        vtkByteSwap::Swap4BE (&fvalue);
-        }
-      else
-        {
-        vtkErrorMacro("Error reading fvalue from file " << this->FileName);
-        }
-
-    } else {
-      vtkFSIO::ReadInt2 (scalarFile, ivalue);
-      fvalue = ivalue / 100.0;
-    }
+  } else {
+    for (vIndex = 0; vIndex < numValues; vIndex ++ ) {
 
-    FSscalars[vIndex] = fvalue;
+      if (feof(scalarFile)) {
+        vtkErrorMacro (<< "vtkFSSurfaceScalarReader.cxx Execute: Unexpected EOF after " << vIndex << " values read.");
+        fclose (scalarFile);
+        free (FSscalars);
+        return 0;
+      }
 
-    if (numValues < 10000 ||
-        (vIndex % 100) == 0)
-    {
-        this->UpdateProgress(1.0*vIndex/numValues);
-    }
+      vtkFSIO::ReadInt2 (scalarFile, ivalue);
+      FSscalars[vIndex] = ivalue / 100.0;
 
+      if (numValues < 10000 ||
+          (vIndex % 100) == 0)
+      {
+          this->UpdateProgress(1.0*vIndex/numValues);
+      }
+    }
   }
 
   this->SetProgressText("");
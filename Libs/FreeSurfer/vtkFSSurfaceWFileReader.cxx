@@ -19,6 +19,19 @@
 // VTK includes
 #include <vtkFloatArray.h>
 #include <vtkObjectFactory.h>
+#include <vtkType.h>
+
+// STD includes
+#include <algorithm>
+#include <cstring>
+
+namespace
+{
+/// Size of an index (three byte int) and value (float) pair.
+const int RecordSize = 7;
+/// Number of pairs read at once.
+const int ChunkSize = 65536;
+}
 
 //-------------------------------------------------------------------------
 vtkStandardNewMacro(vtkFSSurfaceWFileReader);
@@ -123,49 +136,68 @@ int vtkFSSurfaceWFileReader::ReadWFile()
     return this->FS_ERROR_W_ALLOC;
     }
 
-  // For each value in the wfile...
-  for (vIndex = 0; vIndex < numValues; vIndex ++ )
+  // For each value in the wfile... The index/value pairs are read by
+  // chunks and decoded from the buffer.
+  unsigned char* records = new unsigned char[RecordSize * ChunkSize];
+  for (vIndex = 0; vIndex < numValues; vIndex += ChunkSize)
     {
+    const int numChunkValues = std::min(ChunkSize, numValues - vIndex);
 
     // Check for eof.
-    if (feof(wFile))
+    if (fread (records, RecordSize, numChunkValues, wFile) !=
+        static_cast<size_t>(numChunkValues))
       {
-      vtkErrorMacro (<< "vtkFSSurfaceWFileReader.cxx Execute: Unexpected EOF after " << vIndex << " values read. Tried to read " << numValues);
+      vtkErrorMacro (<< "vtkFSSurfaceWFileReader.cxx Execute: Unexpected EOF after less than " << vIndex + numChunkValues << " values read. Tried to read " << numValues);
+      delete [] records;
+      fclose (wFile);
+      free (FSscalars);
       return this->FS_ERROR_W_EOF;
       }
 
-    // Read the 3 byte int index and float value. The wfile is weird
-    // in that there is an index/value pair for every value. I guess
-    // this means that the wfile could have fewer values than the
-    // number of vertices in the surface, but I've never seen this
-    // happen in practice. Additionally, these are usually written
-    // with indices from 0->nvertices, so this index value isn't even
-    // really needed.
-    vtkFSIO::ReadInt3 (wFile, vIndexFromFile);
-    vtkFSIO::ReadFloat (wFile, fvalue);
-
-    // Make sure the index is in bounds. If not, print a warning and
-    // try to do the next value. If this happens, there is probably a
-    // mismatch between the wfile and the surface, but I think there
-    // is a reason for being able to load a mismatched file. But this
-    // should raise some kind of message to the user like, "This wfile
-    // appears to be for a different surface; continue loading?"
-    if (vIndexFromFile < 0 || vIndexFromFile >= this->NumberOfVertices)
+    bool outOfBounds = false;
+    const unsigned char* record = records;
+    for (int i = 0; i < numChunkValues; ++i, record += RecordSize)
       {
-      vtkErrorMacro (<< "vtkFSSurfaceWFileReader.cxx Execute: Read an index that is out of bounds (" << vIndexFromFile << " not in 0-" << this->NumberOfVertices << ", breaking.");
-      break;
+      // Decode the 3 byte int index and float value. The wfile is weird
+      // in that there is an index/value pair for every value. I guess
+      // this means that the wfile could have fewer values than the
+      // number of vertices in the surface, but I've never seen this
+      // happen in practice. Additionally, these are usually written
+      // with indices from 0->nvertices, so this index value isn't even
+      // really needed.
+      vIndexFromFile = (record[0] << 16) | (record[1] << 8) | record[2];
+      const vtkTypeUInt32 bits =
+        (static_cast<vtkTypeUInt32>(record[3]) << 24) |
+        (static_cast<vtkTypeUInt32>(record[4]) << 16) |
+        (static_cast<vtkTypeUInt32>(record[5]) << 8) |
+        static_cast<vtkTypeUInt32>(record[6]);
+      memcpy (&fvalue, &bits, sizeof(float));
+
+      // Make sure the index is in bounds. If not, print a warning and
+      // try to do the next value. If this happens, there is probably a
+      // mismatch between the wfile and the surface, but I think there
+      // is a reason for being able to load a mismatched file. But this
+      // should raise some kind of message to the user like, "This wfile
+      // appears to be for a different surface; continue loading?"
+      if (vIndexFromFile >= this->NumberOfVertices)
+        {
+        vtkErrorMacro (<< "vtkFSSurfaceWFileReader.cxx Execute: Read an index that is out of bounds (" << vIndexFromFile << " not in 0-" << this->NumberOfVertices << ", breaking.");
+        outOfBounds = true;
+        break;
+        }
+
+      // Set the value in the scalars array based on the index we read
+      // in, not the index in our for loop.
+      FSscalars[vIndexFromFile] = fvalue;
       }
-
-    // Set the value in the scalars array based on the index we read
-    // in, not the index in our for loop.
-    FSscalars[vIndexFromFile] = fvalue;
-
-    if (numValues < 10000 ||
-        (vIndex % 100) == 0)
+    if (outOfBounds)
       {
-      this->UpdateProgress(1.0*vIndex/numValues);
+      break;
       }
+
+    this->UpdateProgress(1.0*(vIndex + numChunkValues)/numValues);
     }
+  delete [] records;
 
   this->SetProgressText("");
   this->UpdateProgress(0.0);
@@ -26,6 +26,7 @@ Version:   $Revision: 1.2 $
 #include <vtkIntArray.h>
 #include <vtkNew.h>
 #include <vtkObjectFactory.h>
+#include <vtkTimerLog.h>
 
 // STD includes
 #include <sstream>
@@ -55,6 +56,14 @@ public:
 
   /// Last time the module was started.
   vtkTimeStamp LastRunTime;
+  /// Wall clock time in seconds when the module was last started.
+  double LastRunStartTime;
+  /// Duration in seconds of the last execution.
+  double LastRunDuration;
+  /// Peak resident memory in kB of the last execution.
+  unsigned long LastRunPeakMemoryUsage;
+  /// Number of runs waiting when the module was last scheduled.
+  int QueueDepth;
   /// Last time a parameter was modified.
   vtkTimeStamp ParameterMTime;
   /// Last time an input parameter was modified.
@@ -86,6 +95,10 @@ vtkMRMLCommandLineModuleNode::vtkMRMLCommandLineModuleNode()
     vtkMRMLCommandLineModuleNode::AutoRunOnChangedParameter
     | vtkMRMLCommandLineModuleNode::AutoRunCancelsRunningProcess;
   this->Internal->AutoRunDelay = 1000;
+  this->Internal->LastRunStartTime = 0.;
+  this->Internal->LastRunDuration = 0.;
+  this->Internal->LastRunPeakMemoryUsage = 0;
+  this->Internal->QueueDepth = 0;
 }
 
 //----------------------------------------------------------------------------
@@ -272,6 +285,9 @@ void vtkMRMLCommandLineModuleNode::PrintSelf(ostream& os, vtkIndent indent)
   os << indent << "Status: " << this->GetStatusString() << "\n";
   os << indent << "AutoRun:" << this->GetAutoRun() << "\n";
   os << indent << "AutoRunMode:" << this->GetAutoRunMode() << "\n";
+  os << indent << "QueueDepth:" << this->GetQueueDepth() << "\n";
+  os << indent << "LastRunDuration:" << this->GetLastRunDuration() << "\n";
+  os << indent << "LastRunPeakMemoryUsage:" << this->GetLastRunPeakMemoryUsage() << "\n";
 
   os << indent << "Parameter values:\n";
   std::vector<ModuleParameterGroup>::const_iterator pgbeginit = this->GetModuleDescription().GetParameterGroups().begin();
@@ -524,11 +540,17 @@ void vtkMRMLCommandLineModuleNode::SetStatus(int status, bool modify)
 {
   if (this->Internal->Status != status)
     {
+    if (this->Internal->Status == vtkMRMLCommandLineModuleNode::Running)
+      {
+      this->Internal->LastRunDuration =
+        vtkTimerLog::GetUniversalTime() - this->Internal->LastRunStartTime;
+      }
     this->Internal->Status = status;
     switch (this->Internal->Status)
       {
       case vtkMRMLCommandLineModuleNode::Running:
         this->Internal->LastRunTime.Modified();
+        this->Internal->LastRunStartTime = vtkTimerLog::GetUniversalTime();
         break;
       case vtkMRMLCommandLineModuleNode::Cancelling:
         this->AbortProcess();
@@ -615,6 +637,36 @@ unsigned long vtkMRMLCommandLineModuleNode::GetLastRunTime() const
   return this->Internal->LastRunTime.GetMTime();
 }
 
+//----------------------------------------------------------------------------
+double vtkMRMLCommandLineModuleNode::GetLastRunDuration() const
+{
+  return this->Internal->LastRunDuration;
+}
+
+//----------------------------------------------------------------------------
+void vtkMRMLCommandLineModuleNode::SetLastRunPeakMemoryUsage(unsigned long memoryInKB)
+{
+  this->Internal->LastRunPeakMemoryUsage = memoryInKB;
+}
+
+//----------------------------------------------------------------------------
+unsigned long vtkMRMLCommandLineModuleNode::GetLastRunPeakMemoryUsage() const
+{
+  return this->Internal->LastRunPeakMemoryUsage;
+}
+
+//----------------------------------------------------------------------------
+void vtkMRMLCommandLineModuleNode::SetQueueDepth(int queueDepth)
+{
+  this->Internal->QueueDepth = queueDepth;
+}
+
+//----------------------------------------------------------------------------
+int vtkMRMLCommandLineModuleNode::GetQueueDepth() const
+{
+  return this->Internal->QueueDepth;
+}
+
 //----------------------------------------------------------------------------
 unsigned long vtkMRMLCommandLineModuleNode::GetParameterMTime() const
 {
@@ -191,6 +191,28 @@ public:
   /// \sa GetParameterMTime(), GetInputMTime(), GetMTime()
   unsigned long GetLastRunTime()const;
 
+  /// Return the duration in seconds of the last execution of the module,
+  /// from the time the status became Running until it changed again
+  /// (Completing, Cancelled...). 0 if the module has never run.
+  /// \sa GetLastRunTime(), GetLastRunPeakMemoryUsage()
+  double GetLastRunDuration()const;
+
+  /// Set the peak resident memory used by the last execution of the module,
+  /// in kilobytes. 0 if it is unknown.
+  /// Do not call manually, only the logic should set it.
+  /// \sa GetLastRunPeakMemoryUsage()
+  void SetLastRunPeakMemoryUsage(unsigned long memoryInKB);
+  /// \sa SetLastRunPeakMemoryUsage(), GetLastRunDuration()
+  unsigned long GetLastRunPeakMemoryUsage()const;
+
+  /// Set the number of CLI runs that were waiting to be executed when the
+  /// module was last scheduled.
+  /// Do not call manually, only the logic should set it.
+  /// \sa GetQueueDepth()
+  void SetQueueDepth(int queueDepth);
+  /// \sa SetQueueDepth()
+  int GetQueueDepth()const;
+
   /// Return the last time a parameter was modified
   /// \sa GetInputMTime(), GetMTime()
   unsigned long GetParameterMTime()const;
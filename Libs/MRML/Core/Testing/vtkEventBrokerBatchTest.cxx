@@ -0,0 +1,216 @@
+/*=auto=========================================================================
+
+  Portions (c) Copyright 2005 Brigham and Women's Hospital (BWH)
+  All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Program:   3D Slicer
+
+=========================================================================auto=*/
+
+// MRML includes
+#include "vtkEventBroker.h"
+
+// VTK includes
+#include <vtkCallbackCommand.h>
+#include <vtkNew.h>
+
+// STD includes
+#include <iostream>
+#include <vector>
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+struct InvocationType
+{
+  vtkObject* Caller;
+  unsigned long Event;
+  void* CallData;
+};
+
+std::vector<InvocationType> Invocations;
+
+//----------------------------------------------------------------------------
+void RecordCallback(vtkObject* caller, unsigned long eid,
+                    void* vtkNotUsed(clientData), void* callData)
+{
+  InvocationType invocation;
+  invocation.Caller = caller;
+  invocation.Event = eid;
+  invocation.CallData = callData;
+  Invocations.push_back(invocation);
+}
+
+//----------------------------------------------------------------------------
+// Modify the object passed as client data.
+void CascadeCallback(vtkObject* vtkNotUsed(caller), unsigned long vtkNotUsed(eid),
+                     void* clientData, void* vtkNotUsed(callData))
+{
+  reinterpret_cast<vtkObject*>(clientData)->Modified();
+}
+
+//----------------------------------------------------------------------------
+bool CheckInvocation(int line, size_t index, vtkObject* caller, void* callData)
+{
+  if (index >= Invocations.size() ||
+      Invocations[index].Caller != caller ||
+      Invocations[index].Event != vtkCommand::ModifiedEvent ||
+      Invocations[index].CallData != callData)
+    {
+    std::cerr << "Line " << line << " - Unexpected invocation #" << index
+              << " (" << Invocations.size() << " invocations)" << std::endl;
+    return false;
+    }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+int TestCollapse(vtkEventBroker* broker)
+{
+  vtkNew<vtkObject> subject1;
+  vtkNew<vtkObject> subject2;
+  vtkNew<vtkObject> observer;
+  vtkNew<vtkCallbackCommand> callback;
+  callback->SetCallback(RecordCallback);
+  broker->AddObservation(subject1.GetPointer(), vtkCommand::ModifiedEvent,
+                         observer.GetPointer(), callback.GetPointer());
+  broker->AddObservation(subject2.GetPointer(), vtkCommand::ModifiedEvent,
+                         observer.GetPointer(), callback.GetPointer());
+  Invocations.clear();
+  broker->SetNumberOfCollapsedInvocations(0);
+
+  int callData = 0;
+  {
+  vtkEventBrokerScopedBatch batch(broker);
+  subject2->Modified();
+  subject1->Modified();
+  subject1->Modified();
+  {
+  // nested batches are part of the outermost batch
+  vtkEventBrokerScopedBatch nestedBatch(broker);
+  subject2->Modified();
+  }
+  subject1->InvokeEvent(vtkCommand::ModifiedEvent, &callData);
+  if (!Invocations.empty() ||
+      broker->GetNumberOfBatchedObservations() != 2 ||
+      broker->GetNumberOfCollapsedInvocations() != 3)
+    {
+    std::cerr << "Line " << __LINE__ << " - Events not batched: "
+              << Invocations.size() << " invocations, "
+              << broker->GetNumberOfBatchedObservations() << " batched, "
+              << broker->GetNumberOfCollapsedInvocations() << " collapsed" << std::endl;
+    return EXIT_FAILURE;
+    }
+  }
+
+  // Invoked in the order of first occurrence with the most recent call data
+  if (Invocations.size() != 2 ||
+      !CheckInvocation(__LINE__, 0, subject2.GetPointer(), 0) ||
+      !CheckInvocation(__LINE__, 1, subject1.GetPointer(), &callData) ||
+      broker->IsBatching())
+    {
+    return EXIT_FAILURE;
+    }
+
+  // Out of a batch, events are invoked synchronously
+  Invocations.clear();
+  subject1->Modified();
+  if (Invocations.size() != 1)
+    {
+    std::cerr << "Line " << __LINE__ << " - Event not invoked" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  broker->RemoveObservations(observer.GetPointer());
+  return EXIT_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+int TestCascade(vtkEventBroker* broker)
+{
+  vtkNew<vtkObject> subject1;
+  vtkNew<vtkObject> subject2;
+  vtkNew<vtkObject> observer;
+  vtkNew<vtkCallbackCommand> recordCallback;
+  recordCallback->SetCallback(RecordCallback);
+  vtkNew<vtkCallbackCommand> cascadeCallback;
+  cascadeCallback->SetCallback(CascadeCallback);
+  cascadeCallback->SetClientData(subject2.GetPointer());
+  // subject1 modifies subject2
+  broker->AddObservation(subject1.GetPointer(), vtkCommand::ModifiedEvent,
+                         observer.GetPointer(), cascadeCallback.GetPointer());
+  broker->AddObservation(subject1.GetPointer(), vtkCommand::ModifiedEvent,
+                         observer.GetPointer(), recordCallback.GetPointer());
+  broker->AddObservation(subject2.GetPointer(), vtkCommand::ModifiedEvent,
+                         observer.GetPointer(), recordCallback.GetPointer());
+  Invocations.clear();
+
+  broker->StartBatch();
+  subject1->Modified();
+  subject2->Modified();
+  subject1->Modified();
+  broker->EndBatch();
+
+  // subject2 is invoked again after subject1 because subject1 modified it
+  if (Invocations.size() != 3 ||
+      !CheckInvocation(__LINE__, 0, subject1.GetPointer(), 0) ||
+      !CheckInvocation(__LINE__, 1, subject2.GetPointer(), 0) ||
+      !CheckInvocation(__LINE__, 2, subject2.GetPointer(), 0))
+    {
+    return EXIT_FAILURE;
+    }
+
+  broker->RemoveObservations(observer.GetPointer());
+  return EXIT_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+int TestRemoveDuringBatch(vtkEventBroker* broker)
+{
+  vtkNew<vtkObject> observer;
+  vtkNew<vtkCallbackCommand> callback;
+  callback->SetCallback(RecordCallback);
+  Invocations.clear();
+
+  broker->StartBatch();
+  {
+  vtkNew<vtkObject> subject;
+  broker->AddObservation(subject.GetPointer(), vtkCommand::ModifiedEvent,
+                         observer.GetPointer(), callback.GetPointer());
+  subject->Modified();
+  }
+  // The observations of the deleted subject are forgotten
+  if (broker->GetNumberOfBatchedObservations() != 0)
+    {
+    std::cerr << "Line " << __LINE__ << " - Observation of deleted subject "
+              << "still batched" << std::endl;
+    return EXIT_FAILURE;
+    }
+  broker->EndBatch();
+
+  if (!Invocations.empty())
+    {
+    std::cerr << "Line " << __LINE__ << " - Removed observation invoked" << std::endl;
+    return EXIT_FAILURE;
+    }
+  return EXIT_SUCCESS;
+}
+
+}
+
+//----------------------------------------------------------------------------
+int vtkEventBrokerBatchTest(int vtkNotUsed(argc), char * vtkNotUsed(argv)[])
+{
+  vtkEventBroker* broker = vtkEventBroker::GetInstance();
+  if (TestCollapse(broker) != EXIT_SUCCESS ||
+      TestCascade(broker) != EXIT_SUCCESS ||
+      TestRemoveDuringBatch(broker) != EXIT_SUCCESS)
+    {
+    return EXIT_FAILURE;
+    }
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,192 @@
+/*=auto=========================================================================
+
+  Portions (c) Copyright 2005 Brigham and Women's Hospital (BWH)
+  All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Program:   3D Slicer
+
+=========================================================================auto=*/
+
+// MRML includes
+#include "vtkEventBroker.h"
+
+// VTK includes
+#include <vtkCallbackCommand.h>
+#include <vtkCollection.h>
+#include <vtkNew.h>
+
+// STD includes
+#include <iostream>
+#include <sstream>
+#include <string>
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+void NoOpCallback(vtkObject* vtkNotUsed(caller), unsigned long vtkNotUsed(eid),
+                  void* vtkNotUsed(clientData), void* vtkNotUsed(callData))
+{
+}
+
+//----------------------------------------------------------------------------
+// Modify the object passed as client data.
+void CascadeCallback(vtkObject* vtkNotUsed(caller), unsigned long vtkNotUsed(eid),
+                     void* clientData, void* vtkNotUsed(callData))
+{
+  reinterpret_cast<vtkObject*>(clientData)->Modified();
+}
+
+//----------------------------------------------------------------------------
+int CountOccurrences(const std::string& text, const std::string& pattern)
+{
+  int count = 0;
+  for (size_t pos = text.find(pattern); pos != std::string::npos;
+       pos = text.find(pattern, pos + pattern.size()))
+    {
+    ++count;
+    }
+  return count;
+}
+
+//----------------------------------------------------------------------------
+// Return the first line starting with prefix
+std::string GetLine(const std::string& text, const std::string& prefix)
+{
+  std::stringstream ss(text);
+  std::string line;
+  while (std::getline(ss, line))
+    {
+    if (line.find(prefix) == 0)
+      {
+      return line;
+      }
+    }
+  return std::string();
+}
+
+//----------------------------------------------------------------------------
+std::string GetProfile(vtkEventBroker* broker, int format)
+{
+  std::stringstream ss;
+  broker->WriteEventProfile(ss, format);
+  return ss.str();
+}
+
+}
+
+//----------------------------------------------------------------------------
+int vtkEventBrokerProfilingTest(int vtkNotUsed(argc), char * vtkNotUsed(argv)[])
+{
+  vtkEventBroker* broker = vtkEventBroker::GetInstance();
+
+  // subject1 (vtkObject) modifies subject2 (vtkCollection)
+  vtkNew<vtkObject> subject1;
+  vtkNew<vtkCollection> subject2;
+  vtkNew<vtkObject> observer;
+  vtkNew<vtkCallbackCommand> cascadeCallback;
+  cascadeCallback->SetCallback(CascadeCallback);
+  cascadeCallback->SetClientData(subject2.GetPointer());
+  vtkNew<vtkCallbackCommand> noOpCallback;
+  noOpCallback->SetCallback(NoOpCallback);
+  broker->AddObservation(subject1.GetPointer(), vtkCommand::ModifiedEvent,
+                         observer.GetPointer(), cascadeCallback.GetPointer());
+  broker->AddObservation(subject2.GetPointer(), vtkCommand::ModifiedEvent,
+                         observer.GetPointer(), noOpCallback.GetPointer());
+
+  // Nothing is recorded when profiling is off
+  subject1->Modified();
+  if (broker->GetNumberOfEventProfileEntries() != 0)
+    {
+    std::cerr << "Line " << __LINE__ << " - Invocations profiled while "
+              << "profiling is off" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  broker->EventProfilingOn();
+  for (int i = 0; i < 3; ++i)
+    {
+    subject1->Modified();
+    }
+  broker->EventProfilingOff();
+  subject1->Modified();
+
+  if (broker->GetNumberOfEventProfileEntries() != 2)
+    {
+    std::cerr << "Line " << __LINE__ << " - Wrong number of profile entries: "
+              << broker->GetNumberOfEventProfileEntries() << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  std::string csv = GetProfile(broker, vtkEventBroker::ProfileCSV);
+  std::string outerEntry = GetLine(csv, "vtkObject,ModifiedEvent,vtkObject,");
+  std::string nestedEntry = GetLine(csv, "vtkCollection,ModifiedEvent,vtkObject,");
+  if (csv.find("SubjectClass,Event,ObserverClass,Count,") != 0 ||
+      CountOccurrences(csv, "\n") != 3 ||
+      outerEntry.find(",vtkObject,3,") == std::string::npos ||
+      nestedEntry.find(",vtkObject,3,") == std::string::npos)
+    {
+    std::cerr << "Line " << __LINE__ << " - Wrong CSV profile:\n" << csv << std::endl;
+    return EXIT_FAILURE;
+    }
+  // mean and maximum nesting levels are the last columns
+  if (outerEntry.size() < 4 || nestedEntry.size() < 4 ||
+      outerEntry.substr(outerEntry.size() - 4) != ",1,1" ||
+      nestedEntry.substr(nestedEntry.size() - 4) != ",2,2")
+    {
+    std::cerr << "Line " << __LINE__ << " - Wrong nesting levels:\n" << csv << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  std::string json = GetProfile(broker, vtkEventBroker::ProfileJSON);
+  if (CountOccurrences(json, "\"count\":3") != 2 ||
+      CountOccurrences(json, "\"maximumNestingLevel\":2") != 1 ||
+      CountOccurrences(json, "\"subjectClass\":\"vtkCollection\"") != 1)
+    {
+    std::cerr << "Line " << __LINE__ << " - Wrong JSON profile:\n" << json << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  std::string trace = GetProfile(broker, vtkEventBroker::ProfileChromeTrace);
+  if (trace.find("{\"traceEvents\":[") != 0 ||
+      CountOccurrences(trace, "\"ph\":\"X\"") != 6 ||
+      CountOccurrences(trace, "\"nesting\":2") != 3)
+    {
+    std::cerr << "Line " << __LINE__ << " - Wrong Chrome trace:\n" << trace << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Invocations past the limit are aggregated but not traced
+  broker->ResetEventProfile();
+  broker->SetMaximumNumberOfTracedInvocations(2);
+  broker->EventProfilingOn();
+  for (int i = 0; i < 3; ++i)
+    {
+    subject1->Modified();
+    }
+  broker->EventProfilingOff();
+  trace = GetProfile(broker, vtkEventBroker::ProfileChromeTrace);
+  csv = GetProfile(broker, vtkEventBroker::ProfileCSV);
+  if (CountOccurrences(trace, "\"ph\":\"X\"") != 2 ||
+      CountOccurrences(csv, ",ModifiedEvent,vtkObject,3,") != 2)
+    {
+    std::cerr << "Line " << __LINE__ << " - Trace limit not respected:\n"
+              << trace << "\n" << csv << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  broker->ResetEventProfile();
+  if (broker->GetNumberOfEventProfileEntries() != 0 ||
+      CountOccurrences(GetProfile(broker, vtkEventBroker::ProfileChromeTrace),
+                       "\"ph\"") != 0)
+    {
+    std::cerr << "Line " << __LINE__ << " - Profile not reset" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  broker->RemoveObservations(observer.GetPointer());
+  return EXIT_SUCCESS;
+}
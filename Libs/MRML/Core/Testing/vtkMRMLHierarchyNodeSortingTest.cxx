@@ -0,0 +1,192 @@
+/*=auto=========================================================================
+
+  Portions (c) Copyright 2005 Brigham and Women's Hospital (BWH)
+  All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Program:   3D Slicer
+
+=========================================================================auto=*/
+
+// MRML includes
+#include "vtkMRMLHierarchyNode.h"
+#include "vtkMRMLScene.h"
+
+// VTK includes
+#include <vtkNew.h>
+#include <vtkSmartPointer.h>
+
+// STD includes
+#include <iostream>
+#include <vector>
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+// Check that the children of the parent are the hierarchy nodes of the scene
+// whose parent is the parent, sorted by sorting value, and that the
+// accessors are consistent.
+bool CheckChildren(int line, vtkMRMLScene* scene, vtkMRMLHierarchyNode* parent)
+{
+  const std::vector< vtkMRMLHierarchyNode *>& children =
+    parent->GetChildrenNodesReference();
+
+  int expectedNumberOfChildren = 0;
+  std::vector<vtkMRMLNode *> nodes;
+  scene->GetNodesByClass("vtkMRMLHierarchyNode", nodes);
+  for (unsigned int i = 0; i < nodes.size(); ++i)
+    {
+    vtkMRMLHierarchyNode* node = vtkMRMLHierarchyNode::SafeDownCast(nodes[i]);
+    if (node->GetParentNode() == parent)
+      {
+      ++expectedNumberOfChildren;
+      }
+    }
+  if (static_cast<int>(children.size()) != expectedNumberOfChildren ||
+      parent->GetNumberOfChildrenNodes() != expectedNumberOfChildren)
+    {
+    std::cerr << "Line " << line << " - Wrong number of children: "
+              << children.size() << " instead of " << expectedNumberOfChildren
+              << std::endl;
+    return false;
+    }
+  for (int i = 0; i < expectedNumberOfChildren; ++i)
+    {
+    if (children[i]->GetParentNode() != parent ||
+        (i > 0 && children[i - 1]->GetSortingValue() >= children[i]->GetSortingValue()) ||
+        parent->GetNthChildNode(i) != children[i] ||
+        children[i]->GetIndexInParent() != i)
+      {
+      std::cerr << "Line " << line << " - Child " << i << " is not sorted"
+                << std::endl;
+      return false;
+      }
+    }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+// Check that the children are the same once the children map is rebuilt
+bool CheckChildrenAfterRebuild(int line, vtkMRMLScene* scene,
+                               vtkMRMLHierarchyNode* parent)
+{
+  std::vector< vtkMRMLHierarchyNode *> children = parent->GetChildrenNodes();
+  // adding a node to the scene invalidates the children map
+  vtkNew<vtkMRMLHierarchyNode> node;
+  scene->AddNode(node.GetPointer());
+  if (parent->GetChildrenNodes() != children)
+    {
+    std::cerr << "Line " << line << " - Children differ after rebuild" << std::endl;
+    return false;
+    }
+  return CheckChildren(line, scene, parent);
+}
+
+}
+
+//----------------------------------------------------------------------------
+int vtkMRMLHierarchyNodeSortingTest(int vtkNotUsed(argc), char * vtkNotUsed(argv)[])
+{
+  vtkNew<vtkMRMLScene> scene;
+  vtkNew<vtkMRMLHierarchyNode> parent1;
+  scene->AddNode(parent1.GetPointer());
+  vtkNew<vtkMRMLHierarchyNode> parent2;
+  scene->AddNode(parent2.GetPointer());
+
+  const int numberOfChildren = 200;
+  std::vector<vtkSmartPointer<vtkMRMLHierarchyNode> > children;
+  for (int i = 0; i < numberOfChildren; ++i)
+    {
+    children.push_back(vtkSmartPointer<vtkMRMLHierarchyNode>::New());
+    scene->AddNode(children[i]);
+    children[i]->SetParentNodeID(parent1->GetID());
+    }
+
+  // children are in the order they were added
+  for (int i = 0; i < numberOfChildren; ++i)
+    {
+    if (parent1->GetNthChildNode(i) != children[i])
+      {
+      std::cerr << "Line " << __LINE__ << " - Child " << i
+                << " is not in the order it was added" << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+  if (!CheckChildren(__LINE__, scene.GetPointer(), parent1.GetPointer()))
+    {
+    return EXIT_FAILURE;
+    }
+
+  // sorting value change
+  children[150]->SetSortingValue(children[0]->GetSortingValue() - 1.);
+  if (parent1->GetNthChildNode(0) != children[150] ||
+      !CheckChildren(__LINE__, scene.GetPointer(), parent1.GetPointer()))
+    {
+    return EXIT_FAILURE;
+    }
+
+  // index change
+  children[10]->SetIndexInParent(100);
+  if (children[10]->GetIndexInParent() != 100 ||
+      !CheckChildren(__LINE__, scene.GetPointer(), parent1.GetPointer()))
+    {
+    return EXIT_FAILURE;
+    }
+  children[20]->SetIndexInParent(0);
+  if (children[20]->GetIndexInParent() != 0 ||
+      !CheckChildren(__LINE__, scene.GetPointer(), parent1.GetPointer()))
+    {
+    return EXIT_FAILURE;
+    }
+
+  // move
+  int index = children[30]->GetIndexInParent();
+  children[30]->MoveInParent(3);
+  if (children[30]->GetIndexInParent() != index + 3 ||
+      !CheckChildren(__LINE__, scene.GetPointer(), parent1.GetPointer()))
+    {
+    return EXIT_FAILURE;
+    }
+  children[30]->MoveInParent(-5);
+  if (children[30]->GetIndexInParent() != index - 2 ||
+      !CheckChildren(__LINE__, scene.GetPointer(), parent1.GetPointer()) ||
+      !CheckChildrenAfterRebuild(__LINE__, scene.GetPointer(), parent1.GetPointer()))
+    {
+    return EXIT_FAILURE;
+    }
+
+  // reparenting, the reparented children are appended to the new parent
+  for (int i = 0; i < numberOfChildren; i += 4)
+    {
+    children[i]->SetParentNodeID(parent2->GetID());
+    }
+  for (int i = 0; i < numberOfChildren / 4; ++i)
+    {
+    if (parent2->GetNthChildNode(i) != children[4 * i])
+      {
+      std::cerr << "Line " << __LINE__ << " - Child " << i
+                << " is not in the order it was reparented" << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+  if (!CheckChildren(__LINE__, scene.GetPointer(), parent1.GetPointer()) ||
+      !CheckChildren(__LINE__, scene.GetPointer(), parent2.GetPointer()))
+    {
+    return EXIT_FAILURE;
+    }
+
+  // unparenting and removal
+  children[1]->SetParentNodeID(0);
+  scene->RemoveNode(children[2]);
+  if (!CheckChildren(__LINE__, scene.GetPointer(), parent1.GetPointer()) ||
+      !CheckChildrenAfterRebuild(__LINE__, scene.GetPointer(), parent1.GetPointer()) ||
+      !CheckChildrenAfterRebuild(__LINE__, scene.GetPointer(), parent2.GetPointer()))
+    {
+    return EXIT_FAILURE;
+    }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,187 @@
+/*=auto=========================================================================
+
+  Portions (c) Copyright 2005 Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Program:   3D Slicer
+
+=========================================================================auto=*/
+
+// MRML includes
+#include "vtkImageBimodalAnalysis.h"
+#include "vtkMRMLScalarVolumeDisplayNode.h"
+#include "vtkMRMLScalarVolumeNode.h"
+#include "vtkMRMLScene.h"
+#include "vtkMRMLVolumeHistogram.h"
+
+// VTK includes
+#include <vtkIdTypeArray.h>
+#include <vtkImageAccumulate.h>
+#include <vtkImageData.h>
+#include <vtkNew.h>
+
+// STD includes
+#include <cmath>
+#include <iostream>
+
+namespace
+{
+
+const int Dimensions[3] = {100, 100, 50};
+
+//----------------------------------------------------------------------------
+// Half of the voxels are background noise in [0, 20[ (decreasing
+// distribution), the other half are uniformly distributed in [300, 700[.
+void CreateImage(vtkImageData* image)
+{
+  image->SetDimensions(Dimensions[0], Dimensions[1], Dimensions[2]);
+  image->AllocateScalars(VTK_SHORT, 1);
+  short* ptr = static_cast<short*>(image->GetScalarPointer());
+  const int numberOfVoxels = Dimensions[0] * Dimensions[1] * Dimensions[2];
+  unsigned int random = 1;
+  for (int i = 0; i < numberOfVoxels; ++i)
+    {
+    random = random * 1103515245u + 12345u;
+    const bool background = ((random >> 16) & 0x7fff) % 2 != 0;
+    random = random * 1103515245u + 12345u;
+    const int value = ((random >> 16) & 0x7fff);
+    if (background)
+      {
+      int noise = 0;
+      for (int cumulated = 0, r = value % 2870; noise < 20; ++noise)
+        {
+        cumulated += (20 - noise) * (20 - noise);
+        if (r < cumulated)
+          {
+          break;
+          }
+        }
+      ptr[i] = static_cast<short>(noise);
+      }
+    else
+      {
+      ptr[i] = static_cast<short>(300 + value % 400);
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+// Bimodal analysis of the full resolution histogram of all the voxels.
+void ComputeReferenceLevels(vtkImageData* image, double levels[4])
+{
+  vtkNew<vtkImageAccumulate> accumulate;
+  int extent[6] = {0, 65535, 0, 0, 0, 0};
+  accumulate->SetComponentExtent(extent);
+  double origin[3] = {-32768, 0, 0};
+  accumulate->SetComponentOrigin(origin);
+  accumulate->SetInputData(image);
+  vtkNew<vtkImageBimodalAnalysis> bimodal;
+  bimodal->SetInputConnection(accumulate->GetOutputPort());
+  bimodal->Update();
+  levels[0] = bimodal->GetWindow();
+  levels[1] = bimodal->GetLevel();
+  levels[2] = bimodal->GetThreshold();
+  levels[3] = bimodal->GetMax();
+}
+
+//----------------------------------------------------------------------------
+bool CheckLevels(int line, vtkMRMLScalarVolumeDisplayNode* displayNode,
+                 const double referenceLevels[4], double tolerance)
+{
+  const double levels[4] = {displayNode->GetWindow(), displayNode->GetLevel(),
+                            displayNode->GetLowerThreshold(),
+                            displayNode->GetUpperThreshold()};
+  for (int i = 0; i < 4; ++i)
+    {
+    if (fabs(levels[i] - referenceLevels[i]) > tolerance)
+      {
+      std::cerr << "Line " << line << " - Wrong auto levels: "
+                << levels[0] << " " << levels[1] << " "
+                << levels[2] << " " << levels[3] << " instead of "
+                << referenceLevels[0] << " " << referenceLevels[1] << " "
+                << referenceLevels[2] << " " << referenceLevels[3] << std::endl;
+      return false;
+      }
+    }
+  return true;
+}
+
+}
+
+//----------------------------------------------------------------------------
+int vtkMRMLScalarVolumeDisplayNodeAutoLevelsTest(int , char * [] )
+{
+  vtkNew<vtkImageData> image;
+  CreateImage(image.GetPointer());
+  double referenceLevels[4];
+  ComputeReferenceLevels(image.GetPointer(), referenceLevels);
+
+  vtkNew<vtkMRMLScene> scene;
+  vtkNew<vtkMRMLScalarVolumeNode> volumeNode;
+  scene->AddNode(volumeNode.GetPointer());
+  vtkNew<vtkMRMLScalarVolumeDisplayNode> displayNode;
+  scene->AddNode(displayNode.GetPointer());
+  volumeNode->SetAndObserveDisplayNodeID(displayNode->GetID());
+  volumeNode->SetAndObserveImageData(image.GetPointer());
+
+  // Without subsampling, the levels are the same as the full computation
+  displayNode->SetAutoWindowLevel(1);
+  displayNode->SetAutoThreshold(1);
+  if (!CheckLevels(__LINE__, displayNode.GetPointer(), referenceLevels, 0.))
+    {
+    return EXIT_FAILURE;
+    }
+
+  // The histogram is shared with the volume node and cached
+  vtkMRMLVolumeHistogram* histogram = volumeNode->GetHistogram();
+  const unsigned long histogramMTime = histogram->GetScalarHistogram()->GetMTime();
+  displayNode->Modified();
+  if (histogram->GetScalarHistogram()->GetMTime() != histogramMTime ||
+      !CheckLevels(__LINE__, displayNode.GetPointer(), referenceLevels, 0.))
+    {
+    std::cerr << "Line " << __LINE__ << " - Histogram recomputed" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // With subsampling, the levels are within 2% of the window
+  const vtkIdType numberOfVoxels = Dimensions[0] * Dimensions[1] * Dimensions[2];
+  histogram->SetMaximumNumberOfSamples(numberOfVoxels / 10);
+  displayNode->Modified();
+  if (histogram->GetNumberOfSamples() != numberOfVoxels / 10 ||
+      !CheckLevels(__LINE__, displayNode.GetPointer(), referenceLevels,
+                   0.02 * referenceLevels[0]))
+    {
+    std::cerr << "Line " << __LINE__ << " - Subsampling failed: "
+              << histogram->GetNumberOfSamples() << " samples" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // The ad hoc levels of floating point images span the exact range, even
+  // with a subsampled histogram.
+  vtkNew<vtkImageData> floatImage;
+  floatImage->SetDimensions(Dimensions[0], Dimensions[1], Dimensions[2]);
+  floatImage->AllocateScalars(VTK_FLOAT, 1);
+  float* floatPtr = static_cast<float*>(floatImage->GetScalarPointer());
+  for (vtkIdType i = 0; i < numberOfVoxels; ++i)
+    {
+    floatPtr[i] = 0.5f * static_cast<float>(i % 1000);
+    }
+  // Single outliers are unlikely to be sampled
+  floatPtr[numberOfVoxels / 3] = -1234.5f;
+  floatPtr[numberOfVoxels / 2 + 7] = 4321.5f;
+  volumeNode->SetAndObserveImageData(floatImage.GetPointer());
+  displayNode->Modified();
+  if (displayNode->GetWindow() != 4321.5 + 1234.5 ||
+      displayNode->GetLevel() != 0.5 * (4321.5 - 1234.5) ||
+      displayNode->GetUpperThreshold() != 4321.5)
+    {
+    std::cerr << "Line " << __LINE__ << " - Wrong ad hoc levels: "
+              << displayNode->GetWindow() << " " << displayNode->GetLevel()
+              << " " << displayNode->GetUpperThreshold() << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,187 @@
+/*=auto=========================================================================
+
+  Portions (c) Copyright 2005 Brigham and Women's Hospital (BWH)
+  All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Program:   3D Slicer
+
+=========================================================================auto=*/
+
+// MRML includes
+#include "vtkMRMLModelNode.h"
+#include "vtkMRMLScalarVolumeNode.h"
+#include "vtkMRMLLabelMapVolumeNode.h"
+#include "vtkMRMLScene.h"
+
+// VTK includes
+#include <vtkCollection.h>
+#include <vtkNew.h>
+#include <vtkSmartPointer.h>
+
+// STD includes
+#include <iostream>
+#include <vector>
+
+namespace
+{
+
+//---------------------------------------------------------------------------
+int CheckNodesByClass(int line, vtkMRMLScene* scene, const char* className,
+                      const std::vector<vtkMRMLNode*>& expectedNodes)
+{
+  std::vector<vtkMRMLNode*> nodes;
+  scene->GetNodesByClass(className, nodes);
+  if (nodes != expectedNodes ||
+      scene->GetNumberOfNodesByClass(className) != static_cast<int>(expectedNodes.size()))
+    {
+    std::cerr << "Line " << line << " - GetNodesByClass(" << className
+              << ") failed: " << nodes.size() << " nodes instead of "
+              << expectedNodes.size() << std::endl;
+    return EXIT_FAILURE;
+    }
+  for (size_t i = 0; i < expectedNodes.size(); ++i)
+    {
+    if (scene->GetNthNodeByClass(static_cast<int>(i), className) != expectedNodes[i])
+      {
+      std::cerr << "Line " << line << " - GetNthNodeByClass(" << i << ", "
+                << className << ") failed" << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+  return EXIT_SUCCESS;
+}
+
+//---------------------------------------------------------------------------
+int CheckNodesByName(int line, vtkMRMLScene* scene, const char* name,
+                     const std::vector<vtkMRMLNode*>& expectedNodes)
+{
+  vtkSmartPointer<vtkCollection> nodes;
+  nodes.TakeReference(scene->GetNodesByName(name));
+  bool same = (nodes->GetNumberOfItems() == static_cast<int>(expectedNodes.size()));
+  for (int i = 0; same && i < nodes->GetNumberOfItems(); ++i)
+    {
+    same = (nodes->GetItemAsObject(i) == expectedNodes[i]);
+    }
+  vtkMRMLNode* firstNode = expectedNodes.empty() ? 0 : expectedNodes[0];
+  if (!same ||
+      scene->GetFirstNodeByName(name) != firstNode ||
+      scene->GetFirstNode(name) != firstNode)
+    {
+    std::cerr << "Line " << line << " - GetNodesByName(" << name
+              << ") failed: " << nodes->GetNumberOfItems() << " nodes instead of "
+              << expectedNodes.size() << std::endl;
+    return EXIT_FAILURE;
+    }
+  return EXIT_SUCCESS;
+}
+
+}
+
+//---------------------------------------------------------------------------
+int vtkMRMLSceneNodeIndexTest(int vtkNotUsed(argc), char * vtkNotUsed(argv)[])
+{
+  vtkNew<vtkMRMLScene> scene;
+
+  vtkNew<vtkMRMLScalarVolumeNode> volume1;
+  volume1->SetName("Volume");
+  scene->AddNode(volume1.GetPointer());
+
+  vtkNew<vtkMRMLModelNode> model;
+  model->SetName("Model");
+  scene->AddNode(model.GetPointer());
+
+  // Request the class index before more nodes are added to make sure it is
+  // incrementally updated.
+  std::vector<vtkMRMLNode*> expected;
+  expected.push_back(volume1.GetPointer());
+  if (CheckNodesByClass(__LINE__, scene.GetPointer(), "vtkMRMLVolumeNode", expected) != EXIT_SUCCESS)
+    {
+    return EXIT_FAILURE;
+    }
+
+  vtkNew<vtkMRMLLabelMapVolumeNode> labelMap;
+  labelMap->SetName("Volume");
+  scene->AddNode(labelMap.GetPointer());
+
+  vtkNew<vtkMRMLScalarVolumeNode> volume2;
+  volume2->SetName("Volume2");
+  scene->AddNode(volume2.GetPointer());
+
+  expected.clear();
+  expected.push_back(volume1.GetPointer());
+  expected.push_back(labelMap.GetPointer());
+  expected.push_back(volume2.GetPointer());
+  if (CheckNodesByClass(__LINE__, scene.GetPointer(), "vtkMRMLVolumeNode", expected) != EXIT_SUCCESS ||
+      CheckNodesByClass(__LINE__, scene.GetPointer(), "vtkMRMLScalarVolumeNode", expected) != EXIT_SUCCESS)
+    {
+    return EXIT_FAILURE;
+    }
+  expected.clear();
+  expected.push_back(labelMap.GetPointer());
+  if (CheckNodesByClass(__LINE__, scene.GetPointer(), "vtkMRMLLabelMapVolumeNode", expected) != EXIT_SUCCESS)
+    {
+    return EXIT_FAILURE;
+    }
+  expected.clear();
+  expected.push_back(volume1.GetPointer());
+  expected.push_back(labelMap.GetPointer());
+  if (CheckNodesByName(__LINE__, scene.GetPointer(), "Volume", expected) != EXIT_SUCCESS)
+    {
+    return EXIT_FAILURE;
+    }
+
+  // Renaming a node must update the name index
+  volume1->SetName("Renamed");
+  expected.clear();
+  expected.push_back(labelMap.GetPointer());
+  if (CheckNodesByName(__LINE__, scene.GetPointer(), "Volume", expected) != EXIT_SUCCESS)
+    {
+    return EXIT_FAILURE;
+    }
+  expected.clear();
+  expected.push_back(volume1.GetPointer());
+  if (CheckNodesByName(__LINE__, scene.GetPointer(), "Renamed", expected) != EXIT_SUCCESS)
+    {
+    return EXIT_FAILURE;
+    }
+  if (scene->GetFirstNode("Volume", "vtkMRMLScalarVolumeNode") != labelMap.GetPointer() ||
+      scene->GetFirstNode("Vol", "vtkMRMLScalarVolumeNode", 0, false) != labelMap.GetPointer() ||
+      scene->GetFirstNode(0, "vtkMRMLModelNode") != model.GetPointer())
+    {
+    std::cerr << "Line " << __LINE__ << " - GetFirstNode failed" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Removing a node must update the indices
+  scene->RemoveNode(labelMap.GetPointer());
+  expected.clear();
+  if (CheckNodesByName(__LINE__, scene.GetPointer(), "Volume", expected) != EXIT_SUCCESS ||
+      CheckNodesByClass(__LINE__, scene.GetPointer(), "vtkMRMLLabelMapVolumeNode", expected) != EXIT_SUCCESS)
+    {
+    return EXIT_FAILURE;
+    }
+
+  // Inserting a node in the middle of the scene must keep the scene order
+  scene->InsertBeforeNode(volume2.GetPointer(), labelMap.GetPointer());
+  expected.clear();
+  expected.push_back(volume1.GetPointer());
+  expected.push_back(labelMap.GetPointer());
+  expected.push_back(volume2.GetPointer());
+  if (CheckNodesByClass(__LINE__, scene.GetPointer(), "vtkMRMLVolumeNode", expected) != EXIT_SUCCESS)
+    {
+    return EXIT_FAILURE;
+    }
+
+  scene->Clear(1);
+  expected.clear();
+  if (CheckNodesByClass(__LINE__, scene.GetPointer(), "vtkMRMLVolumeNode", expected) != EXIT_SUCCESS ||
+      CheckNodesByName(__LINE__, scene.GetPointer(), "Renamed", expected) != EXIT_SUCCESS)
+    {
+    return EXIT_FAILURE;
+    }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,247 @@
+/*=auto=========================================================================
+
+  Portions (c) Copyright 2005 Brigham and Women's Hospital (BWH)
+  All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Program:   3D Slicer
+
+=========================================================================auto=*/
+
+// MRML includes
+#include "vtkMRMLCoreTestingMacros.h"
+#include "vtkMRMLLinearTransformNode.h"
+#include "vtkMRMLModelNode.h"
+#include "vtkMRMLModelStorageNode.h"
+#include "vtkMRMLScalarVolumeNode.h"
+#include "vtkMRMLScene.h"
+#include "vtkMRMLTransformStorageNode.h"
+#include "vtkMRMLVolumeArchetypeStorageNode.h"
+
+// ITK includes
+#include <itkFactoryRegistration.h>
+
+// VTK includes
+#include <vtkImageData.h>
+#include <vtkMatrix4x4.h>
+#include <vtkNew.h>
+#include <vtkPoints.h>
+#include <vtkPolyData.h>
+
+// STD includes
+#include <sstream>
+#include <vector>
+
+using namespace vtkMRMLCoreTestingUtilities;
+
+namespace
+{
+
+const int NumberOfModels = 8;
+const int NumberOfVolumes = 4;
+const int NumberOfTransforms = 2;
+
+//---------------------------------------------------------------------------
+short VoxelValue(int volume, int voxel)
+{
+  return static_cast<short>(100 * volume + voxel);
+}
+
+//---------------------------------------------------------------------------
+// Import the scene file and check that the nodes have the data they were
+// saved with.
+int ImportScene(const std::string& sceneFileName,
+                const std::vector<std::string>& modelIDs,
+                const std::vector<std::string>& volumeIDs,
+                const std::vector<std::string>& transformIDs, bool parallel)
+{
+  vtkNew<vtkMRMLScene> scene;
+  scene->SetURL(sceneFileName.c_str());
+  scene->SetParallelReadData(parallel ? 1 : 0);
+  scene->SetNumberOfReadDataThreads(3);
+  CHECK_INT(scene->Connect(), 1);
+  CHECK_INT(scene->GetErrorCode(), 0);
+
+  for (int i = 0; i < NumberOfModels; ++i)
+    {
+    vtkMRMLModelNode* modelNode = vtkMRMLModelNode::SafeDownCast(
+      scene->GetNodeByID(modelIDs[i].c_str()));
+    CHECK_NOT_NULL(modelNode);
+    CHECK_NOT_NULL(modelNode->GetPolyData());
+    CHECK_INT(modelNode->GetPolyData()->GetNumberOfPoints(), 10 * (i + 1));
+    CHECK_NOT_NULL(modelNode->GetStorageNode());
+    // The data has just been read, there is nothing to save
+    CHECK_BOOL(modelNode->GetModifiedSinceRead(), false);
+    }
+
+  for (int i = 0; i < NumberOfVolumes; ++i)
+    {
+    vtkMRMLScalarVolumeNode* volumeNode = vtkMRMLScalarVolumeNode::SafeDownCast(
+      scene->GetNodeByID(volumeIDs[i].c_str()));
+    CHECK_NOT_NULL(volumeNode);
+    vtkImageData* imageData = volumeNode->GetImageData();
+    CHECK_NOT_NULL(imageData);
+    CHECK_INT(imageData->GetDimensions()[2], i + 2);
+    CHECK_INT(imageData->GetScalarType(), VTK_SHORT);
+    short* voxels = static_cast<short*>(imageData->GetScalarPointer());
+    for (vtkIdType voxel = 0; voxel < imageData->GetNumberOfPoints(); ++voxel)
+      {
+      CHECK_INT(voxels[voxel], VoxelValue(i, voxel));
+      }
+    CHECK_NOT_NULL(volumeNode->GetStorageNode());
+    CHECK_BOOL(volumeNode->GetModifiedSinceRead(), false);
+    }
+
+  // Transforms are not read in parallel but are read as usual
+  for (int i = 0; i < NumberOfTransforms; ++i)
+    {
+    vtkMRMLLinearTransformNode* transformNode = vtkMRMLLinearTransformNode::SafeDownCast(
+      scene->GetNodeByID(transformIDs[i].c_str()));
+    CHECK_NOT_NULL(transformNode);
+    vtkNew<vtkMatrix4x4> matrix;
+    CHECK_INT(transformNode->GetMatrixTransformToParent(matrix.GetPointer()), 1);
+    if (matrix->GetElement(0, 3) != 10. * (i + 1) ||
+        matrix->GetElement(2, 3) != -5.)
+      {
+      std::cerr << "Line " << __LINE__ << " - Wrong transform " << i << ": "
+                << matrix->GetElement(0, 3) << " "
+                << matrix->GetElement(2, 3) << std::endl;
+      return EXIT_FAILURE;
+      }
+    CHECK_NOT_NULL(transformNode->GetStorageNode());
+    CHECK_BOOL(transformNode->GetModifiedSinceRead(), false);
+    }
+
+  if (scene->GetImportParseTime() < 0. ||
+      scene->GetImportAddTime() < 0. ||
+      scene->GetImportUpdateTime() < 0. ||
+      (parallel ? scene->GetImportReadTime() < 0. : scene->GetImportReadTime() != 0.))
+    {
+    std::cerr << "Line " << __LINE__ << " - Wrong import times: "
+              << scene->GetImportParseTime() << " "
+              << scene->GetImportReadTime() << " "
+              << scene->GetImportAddTime() << " "
+              << scene->GetImportUpdateTime() << std::endl;
+    return EXIT_FAILURE;
+    }
+  return EXIT_SUCCESS;
+}
+
+}
+
+//---------------------------------------------------------------------------
+int vtkMRMLSceneParallelReadDataTest(int argc, char * argv[])
+{
+  if (argc != 2)
+    {
+    std::cerr << "Line " << __LINE__
+              << " - Missing parameters !\n"
+              << "Usage: " << argv[0] << " /path/to/temp"
+              << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  const char* tempDir = argv[1];
+  std::string sceneFileName = std::string(tempDir) + "/vtkMRMLSceneParallelReadDataTest.mrml";
+
+  // Only the readers that don't access the nodes can read in parallel
+  {
+    vtkNew<vtkMRMLModelStorageNode> modelStorageNode;
+    vtkNew<vtkMRMLVolumeArchetypeStorageNode> volumeStorageNode;
+    vtkNew<vtkMRMLTransformStorageNode> transformStorageNode;
+    CHECK_BOOL(modelStorageNode->CanReadInParallel(), true);
+    CHECK_BOOL(volumeStorageNode->CanReadInParallel(), true);
+    CHECK_BOOL(transformStorageNode->CanReadInParallel(), false);
+  }
+
+  itk::itkFactoryRegistration();
+
+  std::vector<std::string> modelIDs;
+  std::vector<std::string> volumeIDs;
+  std::vector<std::string> transformIDs;
+  {
+    vtkNew<vtkMRMLScene> scene;
+    scene->SetRootDirectory(tempDir);
+    for (int i = 0; i < NumberOfModels; ++i)
+      {
+      vtkNew<vtkPoints> points;
+      points->SetNumberOfPoints(10 * (i + 1));
+      for (vtkIdType pointId = 0; pointId < points->GetNumberOfPoints(); ++pointId)
+        {
+        points->SetPoint(pointId, pointId, i, 0.);
+        }
+      vtkNew<vtkPolyData> polyData;
+      polyData->SetPoints(points.GetPointer());
+
+      vtkNew<vtkMRMLModelNode> modelNode;
+      modelNode->SetAndObservePolyData(polyData.GetPointer());
+      CHECK_NOT_NULL(scene->AddNode(modelNode.GetPointer()));
+      modelIDs.push_back(modelNode->GetID());
+
+      vtkNew<vtkMRMLModelStorageNode> storageNode;
+      scene->AddNode(storageNode.GetPointer());
+      modelNode->SetAndObserveStorageNodeID(storageNode->GetID());
+      std::stringstream fileName;
+      fileName << tempDir << "/vtkMRMLSceneParallelReadDataTest" << i << ".vtk";
+      storageNode->SetFileName(fileName.str().c_str());
+      CHECK_INT(storageNode->WriteData(modelNode.GetPointer()), 1);
+      }
+
+    for (int i = 0; i < NumberOfVolumes; ++i)
+      {
+      vtkNew<vtkImageData> imageData;
+      imageData->SetDimensions(5, 6, i + 2);
+      imageData->AllocateScalars(VTK_SHORT, 1);
+      short* voxels = static_cast<short*>(imageData->GetScalarPointer());
+      for (vtkIdType voxel = 0; voxel < imageData->GetNumberOfPoints(); ++voxel)
+        {
+        voxels[voxel] = VoxelValue(i, voxel);
+        }
+
+      vtkNew<vtkMRMLScalarVolumeNode> volumeNode;
+      volumeNode->SetAndObserveImageData(imageData.GetPointer());
+      CHECK_NOT_NULL(scene->AddNode(volumeNode.GetPointer()));
+      volumeIDs.push_back(volumeNode->GetID());
+
+      vtkNew<vtkMRMLVolumeArchetypeStorageNode> storageNode;
+      scene->AddNode(storageNode.GetPointer());
+      volumeNode->SetAndObserveStorageNodeID(storageNode->GetID());
+      std::stringstream fileName;
+      fileName << tempDir << "/vtkMRMLSceneParallelReadDataTest" << i << ".nrrd";
+      storageNode->SetFileName(fileName.str().c_str());
+      CHECK_INT(storageNode->WriteData(volumeNode.GetPointer()), 1);
+      }
+
+    for (int i = 0; i < NumberOfTransforms; ++i)
+      {
+      vtkNew<vtkMatrix4x4> matrix;
+      matrix->SetElement(0, 3, 10. * (i + 1));
+      matrix->SetElement(2, 3, -5.);
+
+      vtkNew<vtkMRMLLinearTransformNode> transformNode;
+      transformNode->SetMatrixTransformToParent(matrix.GetPointer());
+      CHECK_NOT_NULL(scene->AddNode(transformNode.GetPointer()));
+      transformIDs.push_back(transformNode->GetID());
+
+      vtkNew<vtkMRMLTransformStorageNode> storageNode;
+      scene->AddNode(storageNode.GetPointer());
+      transformNode->SetAndObserveStorageNodeID(storageNode->GetID());
+      std::stringstream fileName;
+      fileName << tempDir << "/vtkMRMLSceneParallelReadDataTest" << i << ".tfm";
+      storageNode->SetFileName(fileName.str().c_str());
+      CHECK_INT(storageNode->WriteData(transformNode.GetPointer()), 1);
+      }
+
+    scene->SetURL(sceneFileName.c_str());
+    CHECK_INT(scene->Commit(), 1);
+  }
+
+  if (ImportScene(sceneFileName, modelIDs, volumeIDs, transformIDs, false) != EXIT_SUCCESS ||
+      ImportScene(sceneFileName, modelIDs, volumeIDs, transformIDs, true) != EXIT_SUCCESS)
+    {
+    return EXIT_FAILURE;
+    }
+  return EXIT_SUCCESS;
+}
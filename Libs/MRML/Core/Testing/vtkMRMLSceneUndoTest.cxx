@@ -0,0 +1,211 @@
+/*=auto=========================================================================
+
+  Portions (c) Copyright 2005 Brigham and Women's Hospital (BWH)
+  All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Program:   3D Slicer
+
+=========================================================================auto=*/
+
+// MRML includes
+#include "vtkMRMLModelNode.h"
+#include "vtkMRMLScene.h"
+
+// VTK includes
+#include <vtkNew.h>
+#include <vtkPoints.h>
+#include <vtkPolyData.h>
+
+// STD includes
+#include <iostream>
+#include <string>
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+bool CheckNode(int line, vtkMRMLScene* scene, vtkMRMLNode* node,
+               bool expectedPresent, const char* expectedName)
+{
+  bool present = (scene->GetNodeByID(node->GetID()) == node);
+  if (present != expectedPresent ||
+      (expectedName && std::string(node->GetName()) != expectedName))
+    {
+    std::cerr << "Line " << line << " - Unexpected state of node "
+              << node->GetID() << ": present=" << present
+              << " name=" << node->GetName() << std::endl;
+    return false;
+    }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+int TestUndoRedo()
+{
+  vtkNew<vtkMRMLScene> scene;
+  scene->SetUndoOn();
+  vtkNew<vtkMRMLModelNode> node1;
+  node1->SetName("Node1");
+  scene->AddNode(node1.GetPointer());
+  vtkNew<vtkMRMLModelNode> node2;
+  node2->SetName("Node2");
+  scene->AddNode(node2.GetPointer());
+
+  // Modify node1, add node3 and remove node2
+  scene->SaveStateForUndo();
+  node1->SetName("Node1Modified");
+  vtkNew<vtkMRMLModelNode> node3;
+  node3->SetName("Node3");
+  scene->AddNode(node3.GetPointer());
+  scene->RemoveNode(node2.GetPointer());
+
+  if (scene->GetNumberOfUndoLevels() != 1)
+    {
+    std::cerr << "Line " << __LINE__ << " - Wrong number of undo levels: "
+              << scene->GetNumberOfUndoLevels() << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  scene->Undo();
+  if (!CheckNode(__LINE__, scene.GetPointer(), node1.GetPointer(), true, "Node1") ||
+      !CheckNode(__LINE__, scene.GetPointer(), node2.GetPointer(), true, "Node2") ||
+      !CheckNode(__LINE__, scene.GetPointer(), node3.GetPointer(), false, 0) ||
+      scene->GetNumberOfUndoLevels() != 0 ||
+      scene->GetNumberOfRedoLevels() != 1)
+    {
+    return EXIT_FAILURE;
+    }
+
+  scene->Redo();
+  if (!CheckNode(__LINE__, scene.GetPointer(), node1.GetPointer(), true, "Node1Modified") ||
+      !CheckNode(__LINE__, scene.GetPointer(), node2.GetPointer(), false, 0) ||
+      !CheckNode(__LINE__, scene.GetPointer(), node3.GetPointer(), true, "Node3") ||
+      scene->GetNumberOfUndoLevels() != 1 ||
+      scene->GetNumberOfRedoLevels() != 0)
+    {
+    return EXIT_FAILURE;
+    }
+
+  // Undo the redo
+  scene->Undo();
+  if (!CheckNode(__LINE__, scene.GetPointer(), node1.GetPointer(), true, "Node1") ||
+      !CheckNode(__LINE__, scene.GetPointer(), node2.GetPointer(), true, "Node2") ||
+      !CheckNode(__LINE__, scene.GetPointer(), node3.GetPointer(), false, 0))
+    {
+    return EXIT_FAILURE;
+    }
+  return EXIT_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+int TestMultipleLevels()
+{
+  vtkNew<vtkMRMLScene> scene;
+  scene->SetUndoOn();
+  vtkNew<vtkMRMLModelNode> node;
+  node->SetName("State0");
+  scene->AddNode(node.GetPointer());
+
+  // Node saved individually
+  scene->SaveStateForUndo(node.GetPointer());
+  node->SetName("State1");
+  // Node unchanged between two saves: the copy is shared
+  scene->SaveStateForUndo();
+  scene->SaveStateForUndo();
+  node->SetName("State2");
+
+  // A node added then removed in the same step is not restored
+  vtkNew<vtkMRMLModelNode> temporaryNode;
+  scene->AddNode(temporaryNode.GetPointer());
+  scene->RemoveNode(temporaryNode.GetPointer());
+
+  scene->Undo();
+  if (!CheckNode(__LINE__, scene.GetPointer(), node.GetPointer(), true, "State1") ||
+      !CheckNode(__LINE__, scene.GetPointer(), temporaryNode.GetPointer(), false, 0))
+    {
+    return EXIT_FAILURE;
+    }
+  scene->Undo();
+  if (!CheckNode(__LINE__, scene.GetPointer(), node.GetPointer(), true, "State1"))
+    {
+    return EXIT_FAILURE;
+    }
+  scene->Undo();
+  if (!CheckNode(__LINE__, scene.GetPointer(), node.GetPointer(), true, "State0"))
+    {
+    return EXIT_FAILURE;
+    }
+  scene->Redo();
+  scene->Redo();
+  scene->Redo();
+  if (!CheckNode(__LINE__, scene.GetPointer(), node.GetPointer(), true, "State2"))
+    {
+    return EXIT_FAILURE;
+    }
+  return EXIT_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+int TestLimits()
+{
+  vtkNew<vtkMRMLScene> scene;
+  scene->SetUndoOn();
+  vtkNew<vtkMRMLModelNode> node;
+  scene->AddNode(node.GetPointer());
+
+  // Maximum number of levels
+  scene->SetUndoStackSize(3);
+  for (int i = 0; i < 5; ++i)
+    {
+    scene->SaveStateForUndo(node.GetPointer());
+    node->SetName("Modified");
+    }
+  if (scene->GetNumberOfUndoLevels() != 3)
+    {
+    std::cerr << "Line " << __LINE__ << " - Wrong number of undo levels: "
+              << scene->GetNumberOfUndoLevels() << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Maximum memory: a model whose polydata has been replaced keeps the
+  // old polydata alive in the undo stack.
+  scene->ClearUndoStack();
+  scene->SetUndoStackSize(100);
+  scene->SetMaximumUndoMemorySize(1024);
+  for (int i = 0; i < 5; ++i)
+    {
+    scene->SaveStateForUndo(node.GetPointer());
+    vtkNew<vtkPolyData> polyData;
+    vtkNew<vtkPoints> points;
+    points->SetNumberOfPoints(100000); // more than 1MB
+    polyData->SetPoints(points.GetPointer());
+    node->SetAndObservePolyData(polyData.GetPointer());
+    }
+  // push a last level to account for the data of the previous one
+  scene->SaveStateForUndo(node.GetPointer());
+  if (scene->GetNumberOfUndoLevels() != 1)
+    {
+    std::cerr << "Line " << __LINE__ << " - Memory limit not respected: "
+              << scene->GetNumberOfUndoLevels() << " levels, "
+              << scene->GetUndoMemorySize() << "kB" << std::endl;
+    return EXIT_FAILURE;
+    }
+  return EXIT_SUCCESS;
+}
+
+}
+
+//----------------------------------------------------------------------------
+int vtkMRMLSceneUndoTest(int vtkNotUsed(argc), char * vtkNotUsed(argv)[])
+{
+  if (TestUndoRedo() != EXIT_SUCCESS ||
+      TestMultipleLevels() != EXIT_SUCCESS ||
+      TestLimits() != EXIT_SUCCESS)
+    {
+    return EXIT_FAILURE;
+    }
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,179 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  Copyright (c) Laboratory for Percutaneous Surgery (PerkLab)
+  Queen's University, Kingston, ON, Canada. All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// MRML includes
+#include "vtkMRMLCoreTestingMacros.h"
+#include "vtkMRMLModelHierarchyNode.h"
+#include "vtkMRMLModelNode.h"
+#include "vtkMRMLScene.h"
+#include "vtkMRMLSubjectHierarchyNode.h"
+
+// VTK includes
+#include <vtkNew.h>
+#include <vtkSmartPointer.h>
+
+// STD includes
+#include <sstream>
+#include <vector>
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+int TestAssociatedNodeLookup()
+{
+  vtkNew<vtkMRMLScene> scene;
+
+  // Direct association
+  const int numberOfNodes = 500;
+  std::vector<vtkSmartPointer<vtkMRMLModelNode> > dataNodes;
+  std::vector<vtkSmartPointer<vtkMRMLSubjectHierarchyNode> > shNodes;
+  for (int i = 0; i < numberOfNodes; ++i)
+    {
+    dataNodes.push_back(vtkSmartPointer<vtkMRMLModelNode>::New());
+    scene->AddNode(dataNodes[i]);
+    shNodes.push_back(vtkSmartPointer<vtkMRMLSubjectHierarchyNode>::New());
+    scene->AddNode(shNodes[i]);
+    shNodes[i]->SetAssociatedNodeID(dataNodes[i]->GetID());
+    }
+  for (int i = 0; i < numberOfNodes; ++i)
+    {
+    if (vtkMRMLSubjectHierarchyNode::GetAssociatedSubjectHierarchyNode(dataNodes[i]) != shNodes[i])
+      {
+      std::cerr << "Line " << __LINE__ << " - Wrong subject hierarchy node for data node "
+                << dataNodes[i]->GetID() << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+
+  // A subject hierarchy node is associated to itself
+  if (vtkMRMLSubjectHierarchyNode::GetAssociatedSubjectHierarchyNode(shNodes[0]) != shNodes[0])
+    {
+    std::cerr << "Line " << __LINE__ << " - Wrong subject hierarchy node" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Association change
+  shNodes[1]->SetAssociatedNodeID(dataNodes[2]->GetID());
+  shNodes[2]->SetAssociatedNodeID(0);
+  if (vtkMRMLSubjectHierarchyNode::GetAssociatedSubjectHierarchyNode(dataNodes[1]) != NULL ||
+      vtkMRMLSubjectHierarchyNode::GetAssociatedSubjectHierarchyNode(dataNodes[2]) != shNodes[1])
+    {
+    std::cerr << "Line " << __LINE__ << " - Association change not indexed" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Removal
+  scene->RemoveNode(shNodes[3]);
+  if (vtkMRMLSubjectHierarchyNode::GetAssociatedSubjectHierarchyNode(dataNodes[3]) != NULL)
+    {
+    std::cerr << "Line " << __LINE__ << " - Removed node still indexed" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Nested association: subject hierarchy -> model hierarchy -> data node
+  vtkNew<vtkMRMLModelNode> nestedDataNode;
+  scene->AddNode(nestedDataNode.GetPointer());
+  vtkNew<vtkMRMLModelHierarchyNode> modelHierarchyNode;
+  scene->AddNode(modelHierarchyNode.GetPointer());
+  modelHierarchyNode->SetAssociatedNodeID(nestedDataNode->GetID());
+  vtkNew<vtkMRMLSubjectHierarchyNode> nestedSHNode;
+  scene->AddNode(nestedSHNode.GetPointer());
+  nestedSHNode->SetAssociatedNodeID(modelHierarchyNode->GetID());
+  if (vtkMRMLSubjectHierarchyNode::GetAssociatedSubjectHierarchyNode(nestedDataNode.GetPointer())
+      != nestedSHNode.GetPointer() ||
+      nestedSHNode->GetAssociatedNode() != nestedDataNode.GetPointer())
+    {
+    std::cerr << "Line " << __LINE__ << " - Nested association not found" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  return EXIT_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+int TestUIDLookup()
+{
+  vtkNew<vtkMRMLScene> scene;
+
+  const int numberOfNodes = 500;
+  std::vector<vtkSmartPointer<vtkMRMLSubjectHierarchyNode> > shNodes;
+  for (int i = 0; i < numberOfNodes; ++i)
+    {
+    shNodes.push_back(vtkSmartPointer<vtkMRMLSubjectHierarchyNode>::New());
+    std::stringstream uid;
+    uid << "1.2.840." << i;
+    shNodes[i]->AddUID("DICOM", uid.str());
+    scene->AddNode(shNodes[i]);
+    }
+  if (vtkMRMLSubjectHierarchyNode::GetSubjectHierarchyNodeByUID(scene.GetPointer(), "DICOM", "1.2.840.42") != shNodes[42] ||
+      vtkMRMLSubjectHierarchyNode::GetSubjectHierarchyNodeByUID(scene.GetPointer(), "DICOM", "1.2.840.") != NULL ||
+      vtkMRMLSubjectHierarchyNode::GetSubjectHierarchyNodeByUID(scene.GetPointer(), "MIDAS", "1.2.840.42") != NULL)
+    {
+    std::cerr << "Line " << __LINE__ << " - Wrong node found by UID" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // UID added after the node is in the scene
+  shNodes[10]->AddUID("MIDAS", "http://midas/item/10");
+  if (vtkMRMLSubjectHierarchyNode::GetSubjectHierarchyNodeByUID(scene.GetPointer(), "MIDAS", "http://midas/item/10") != shNodes[10])
+    {
+    std::cerr << "Line " << __LINE__ << " - Added UID not indexed" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // UID changed by copy
+  shNodes[11]->Copy(shNodes[12]);
+  if (vtkMRMLSubjectHierarchyNode::GetSubjectHierarchyNodeByUID(scene.GetPointer(), "DICOM", "1.2.840.11") != NULL ||
+      vtkMRMLSubjectHierarchyNode::GetSubjectHierarchyNodeByUID(scene.GetPointer(), "DICOM", "1.2.840.12") != shNodes[11])
+    {
+    std::cerr << "Line " << __LINE__ << " - Copied UIDs not indexed" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Nodes not in the scene are not found
+  vtkNew<vtkMRMLSubjectHierarchyNode> nodeNotInScene;
+  nodeNotInScene->AddUID("DICOM", "1.2.3");
+  nodeNotInScene->SetScene(scene.GetPointer());
+  scene->RemoveNode(shNodes[20]);
+  int res = EXIT_SUCCESS;
+  if (vtkMRMLSubjectHierarchyNode::GetSubjectHierarchyNodeByUID(scene.GetPointer(), "DICOM", "1.2.3") != NULL ||
+      vtkMRMLSubjectHierarchyNode::GetSubjectHierarchyNodeByUID(scene.GetPointer(), "DICOM", "1.2.840.20") != NULL)
+    {
+    std::cerr << "Line " << __LINE__ << " - Node not in the scene found by UID" << std::endl;
+    res = EXIT_FAILURE;
+    }
+  nodeNotInScene->SetScene(0);
+  return res;
+}
+
+}
+
+//----------------------------------------------------------------------------
+int vtkMRMLSubjectHierarchyNodeTest1(int , char * [] )
+{
+  vtkNew<vtkMRMLSubjectHierarchyNode> node1;
+  EXERCISE_BASIC_OBJECT_METHODS(node1.GetPointer());
+
+  if (TestAssociatedNodeLookup() != EXIT_SUCCESS ||
+      TestUIDLookup() != EXIT_SUCCESS)
+    {
+    return EXIT_FAILURE;
+    }
+  return EXIT_SUCCESS;
+}
@@ -24,13 +24,21 @@
 #include "vtkMRMLTableNode.h"
 #include "vtkMRMLTableSQLiteStorageNode.h"
 
+#include "vtkDoubleArray.h"
 #include "vtkFloatArray.h"
+#include "vtkIntArray.h"
+#include "vtkStringArray.h"
 #include "vtkTable.h"
 #include "vtkTestErrorObserver.h"
+#include "vtkTimerLog.h"
+#include "vtkTypeInt64Array.h"
 
 // ITKSYS includes
 #include <itksys/SystemTools.hxx>
 
+// STD includes
+#include <cstdlib>
+
 #include "vtkMRMLCoreTestingMacros.h"
 
 static int removeFile(char *fileName)
@@ -43,9 +51,119 @@ static int removeFile(char *fileName)
   return removed;
 }
 
-int vtkMRMLTableSQLiteStorageNodeTest(int , char * [] )
+//----------------------------------------------------------------------------
+// Round trip of a large table: values must be preserved exactly.
+// If printTimings is true, the write and read times are printed.
+static int TestLargeTable(int numberOfRows, bool printTimings)
 {
   vtkNew<vtkMRMLScene> scene;
+  vtkNew<vtkMRMLTableNode> tableNode;
+  scene->AddNode(tableNode.GetPointer());
+  vtkNew<vtkMRMLTableSQLiteStorageNode> storageNode;
+  scene->AddNode(storageNode.GetPointer());
+  tableNode->SetAndObserveStorageNodeID(storageNode->GetID());
+
+  vtkNew<vtkTable> table;
+  vtkNew<vtkDoubleArray> doubleColumn;
+  doubleColumn->SetName("Measurement");
+  doubleColumn->SetNumberOfValues(numberOfRows);
+  vtkNew<vtkIntArray> intColumn;
+  intColumn->SetName("Label");
+  intColumn->SetNumberOfValues(numberOfRows);
+  vtkNew<vtkTypeInt64Array> int64Column;
+  int64Column->SetName("Identifier");
+  int64Column->SetNumberOfValues(numberOfRows);
+  vtkNew<vtkStringArray> stringColumn;
+  stringColumn->SetName("Comment");
+  stringColumn->SetNumberOfValues(numberOfRows);
+  for (int i = 0; i < numberOfRows; ++i)
+    {
+    doubleColumn->SetValue(i, 1. / (i + 3));
+    intColumn->SetValue(i, i * 2000 - 1000000000);
+    // outside of the 32-bit range
+    int64Column->SetValue(i, (static_cast<vtkTypeInt64>(i) << 33) - 12345);
+    stringColumn->SetValue(i, (i % 2) ? "odd" : "even");
+    }
+  table->AddColumn(doubleColumn.GetPointer());
+  table->AddColumn(intColumn.GetPointer());
+  table->AddColumn(stringColumn.GetPointer());
+  table->AddColumn(int64Column.GetPointer());
+  tableNode->SetAndObserveTable(table.GetPointer());
+
+  storageNode->SetFileName("testSQLiteLarge.db");
+  storageNode->SetTableName("Measurements");
+  removeFile(storageNode->GetFileName());
+
+  vtkNew<vtkTimerLog> timer;
+  timer->StartTimer();
+  if (!storageNode->WriteData(tableNode.GetPointer()))
+    {
+    std::cerr << "Line " << __LINE__ << " - Unable to write the table" << std::endl;
+    removeFile(storageNode->GetFileName());
+    return EXIT_FAILURE;
+    }
+  timer->StopTimer();
+  if (printTimings)
+    {
+    std::cout << "Write " << numberOfRows << " rows: "
+              << timer->GetElapsedTime() << "s" << std::endl;
+    }
+
+  vtkNew<vtkMRMLTableNode> readTableNode;
+  scene->AddNode(readTableNode.GetPointer());
+  timer->StartTimer();
+  int readResult = storageNode->ReadData(readTableNode.GetPointer());
+  timer->StopTimer();
+  if (printTimings)
+    {
+    std::cout << "Read " << numberOfRows << " rows: "
+              << timer->GetElapsedTime() << "s" << std::endl;
+    }
+  removeFile(storageNode->GetFileName());
+
+  vtkTable* readTable = readTableNode->GetTable();
+  vtkDoubleArray* readDoubleColumn = vtkDoubleArray::SafeDownCast(readTable->GetColumn(0));
+  // SQLite integers are read as 64-bit integers
+  vtkTypeInt64Array* readIntColumn = vtkTypeInt64Array::SafeDownCast(readTable->GetColumn(1));
+  vtkStringArray* readStringColumn = vtkStringArray::SafeDownCast(readTable->GetColumn(2));
+  vtkTypeInt64Array* readInt64Column = vtkTypeInt64Array::SafeDownCast(readTable->GetColumn(3));
+  if (!readResult || readTable->GetNumberOfRows() != numberOfRows ||
+      !readDoubleColumn || !readIntColumn || !readStringColumn || !readInt64Column ||
+      std::string(readStringColumn->GetName()) != "Comment")
+    {
+    std::cerr << "Line " << __LINE__ << " - Unable to read the table" << std::endl;
+    return EXIT_FAILURE;
+    }
+  for (int i = 0; i < numberOfRows; ++i)
+    {
+    if (readDoubleColumn->GetValue(i) != doubleColumn->GetValue(i) ||
+        readIntColumn->GetValue(i) != intColumn->GetValue(i) ||
+        readStringColumn->GetValue(i) != stringColumn->GetValue(i) ||
+        readInt64Column->GetValue(i) != int64Column->GetValue(i))
+      {
+      std::cerr << "Line " << __LINE__ << " - Row " << i
+                << " is not preserved: " << readDoubleColumn->GetValue(i)
+                << " " << readIntColumn->GetValue(i) << " "
+                << readStringColumn->GetValue(i) << " "
+                << readInt64Column->GetValue(i) << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+  return EXIT_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+// Usage: vtkMRMLTableSQLiteStorageNodeTest [numberOfRows]
+// If a number of rows is given, only the large table round trip is run,
+// with that number of rows, and its timings are printed (benchmark).
+int vtkMRMLTableSQLiteStorageNodeTest(int argc, char * argv [] )
+{
+  if (argc > 1)
+    {
+    return TestLargeTable(atoi(argv[1]), true);
+    }
+
+  vtkNew<vtkMRMLScene> scene;
 
   vtkNew<vtkMRMLTableNode> tableNode;
   scene->AddNode(tableNode.GetPointer());
@@ -114,6 +232,11 @@ int vtkMRMLTableSQLiteStorageNodeTest(int , char * [] )
   // clean up
   removeFile(storageNode->GetFileName());
 
+  if (TestLargeTable(1000, false) != EXIT_SUCCESS)
+    {
+    return EXIT_FAILURE;
+    }
+
   std::cout << "vtkMRMLTableSQLiteStorageNodeTest completed successfully" << std::endl;
   return EXIT_SUCCESS;
 }
@@ -0,0 +1,198 @@
+/*=auto=========================================================================
+
+  Portions (c) Copyright 2005 Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Program:   3D Slicer
+
+=========================================================================auto=*/
+
+// MRML includes
+#include "vtkMRMLScalarVolumeNode.h"
+#include "vtkMRMLVolumeHistogram.h"
+
+// VTK includes
+#include <vtkIdTypeArray.h>
+#include <vtkImageData.h>
+#include <vtkNew.h>
+
+// STD includes
+#include <cmath>
+#include <iostream>
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+// value = slope * i, plus offset in the upper half (j >= 15)
+void CreateImage(vtkImageData* image, int slope, int offset)
+{
+  image->SetDimensions(40, 30, 20);
+  image->AllocateScalars(VTK_SHORT, 1);
+  short* ptr = static_cast<short*>(image->GetScalarPointer());
+  for (int k = 0; k < 20; ++k)
+    {
+    for (int j = 0; j < 30; ++j)
+      {
+      for (int i = 0; i < 40; ++i)
+        {
+        *ptr++ = static_cast<short>(slope * i + (j >= 15 ? offset : 0));
+        }
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+vtkIdType GetTotal(vtkIdTypeArray* histogram)
+{
+  vtkIdType total = 0;
+  for (vtkIdType i = 0; i < histogram->GetNumberOfTuples(); ++i)
+    {
+    total += histogram->GetValue(i);
+    }
+  return total;
+}
+
+}
+
+//----------------------------------------------------------------------------
+int vtkMRMLVolumeHistogramTest1(int , char * [] )
+{
+  vtkNew<vtkImageData> image;
+  CreateImage(image.GetPointer(), 2, 100);
+  const vtkIdType numberOfVoxels = 40 * 30 * 20;
+
+  vtkNew<vtkMRMLVolumeHistogram> histogram;
+  if (histogram->UpdateScalarHistogram() ||
+      histogram->GetScalarHistogram()->GetNumberOfTuples() != 0)
+    {
+    std::cerr << "Line " << __LINE__ << " - Histogram without image" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Integer image: one bin per value
+  histogram->SetImageData(image.GetPointer());
+  double range[2] = {0., 0.};
+  vtkIdTypeArray* scalarHistogram = histogram->GetScalarHistogram();
+  if (!histogram->GetScalarRange(range) ||
+      range[0] != 0. || range[1] != 178. ||
+      histogram->GetScalarBinOrigin() != 0. ||
+      histogram->GetScalarBinWidth() != 1. ||
+      histogram->GetNumberOfSamples() != numberOfVoxels ||
+      scalarHistogram->GetNumberOfTuples() != 179 ||
+      GetTotal(scalarHistogram) != numberOfVoxels ||
+      scalarHistogram->GetValue(0) != 15 * 20 ||
+      scalarHistogram->GetValue(1) != 0 ||
+      scalarHistogram->GetValue(100) != 15 * 20)
+    {
+    std::cerr << "Line " << __LINE__ << " - Wrong scalar histogram: "
+              << range[0] << " " << range[1] << " "
+              << scalarHistogram->GetNumberOfTuples() << " bins" << std::endl;
+    return EXIT_FAILURE;
+    }
+  const double median = histogram->GetScalarAtPercentile(50.);
+  if (histogram->GetScalarAtPercentile(0.) != 0. ||
+      histogram->GetScalarAtPercentile(100.) != 178. ||
+      median < 78. || median > 101.)
+    {
+    std::cerr << "Line " << __LINE__ << " - Wrong percentile: " << median << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // The histogram is cached until the image is modified
+  unsigned long histogramMTime = scalarHistogram->GetMTime();
+  histogram->GetScalarHistogram();
+  if (scalarHistogram->GetMTime() != histogramMTime)
+    {
+    std::cerr << "Line " << __LINE__ << " - Histogram not cached" << std::endl;
+    return EXIT_FAILURE;
+    }
+  CreateImage(image.GetPointer(), 2, 200);
+  histogram->GetScalarRange(range);
+  if (scalarHistogram->GetMTime() == histogramMTime || range[1] != 278.)
+    {
+    std::cerr << "Line " << __LINE__ << " - Histogram not updated" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Bins are wider than 1 when there are too many values
+  histogram->SetMaximumNumberOfScalarBins(100);
+  if (histogram->GetScalarBinWidth() != 3. ||
+      GetTotal(histogram->GetScalarHistogram()) != numberOfVoxels)
+    {
+    std::cerr << "Line " << __LINE__ << " - Wrong bin width: "
+              << histogram->GetScalarBinWidth() << std::endl;
+    return EXIT_FAILURE;
+    }
+  histogram->SetMaximumNumberOfScalarBins(65536);
+
+  // Subsampling
+  histogram->SetMaximumNumberOfSamples(1000);
+  const double subsampledMedian = histogram->GetScalarAtPercentile(50.);
+  if (histogram->GetNumberOfSamples() > 1000 ||
+      histogram->GetNumberOfSamples() < 900 ||
+      GetTotal(histogram->GetScalarHistogram()) != histogram->GetNumberOfSamples() ||
+      fabs(subsampledMedian - median) > 25.)
+    {
+    std::cerr << "Line " << __LINE__ << " - Wrong subsampling: "
+              << histogram->GetNumberOfSamples() << " samples, median: "
+              << subsampledMedian << std::endl;
+    return EXIT_FAILURE;
+    }
+  // The scalar range is computed from all the voxels
+  short* voxels = static_cast<short*>(image->GetScalarPointer());
+  voxels[1234] = -1000;
+  voxels[4321] = 1000;
+  image->Modified();
+  if (!histogram->GetScalarRange(range) ||
+      range[0] != -1000. || range[1] != 1000. ||
+      histogram->GetNumberOfSamples() > 1000)
+    {
+    std::cerr << "Line " << __LINE__ << " - Wrong subsampled range: "
+              << range[0] << " " << range[1] << std::endl;
+    return EXIT_FAILURE;
+    }
+  histogram->SetMaximumNumberOfSamples(0);
+
+  // Gradient magnitude of a ramp is constant, also on the boundaries
+  CreateImage(image.GetPointer(), 3, 0);
+  double gradientRange[2] = {0., 0.};
+  int jointDimensions[2] = {0, 0};
+  histogram->GetJointHistogramDimensions(jointDimensions);
+  if (!histogram->GetGradientMagnitudeRange(gradientRange) ||
+      gradientRange[0] != 3. || gradientRange[1] != 3. ||
+      GetTotal(histogram->GetGradientMagnitudeHistogram()) != numberOfVoxels ||
+      histogram->GetGradientMagnitudeHistogram()->GetValue(
+        histogram->GetNumberOfGradientMagnitudeBins() - 1) != numberOfVoxels ||
+      jointDimensions[0] != 118 || jointDimensions[1] != 256 ||
+      histogram->GetJointHistogram()->GetNumberOfTuples() != 118 * 256 ||
+      GetTotal(histogram->GetJointHistogram()) != numberOfVoxels)
+    {
+    std::cerr << "Line " << __LINE__ << " - Wrong gradient magnitude histogram: "
+              << gradientRange[0] << " " << gradientRange[1] << " "
+              << jointDimensions[0] << "x" << jointDimensions[1] << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // The volume node histogram follows the image data of the node
+  vtkNew<vtkMRMLScalarVolumeNode> volumeNode;
+  volumeNode->SetAndObserveImageData(image.GetPointer());
+  vtkMRMLVolumeHistogram* volumeHistogram = volumeNode->GetHistogram();
+  if (!volumeHistogram ||
+      volumeHistogram != volumeNode->GetHistogram() ||
+      volumeHistogram->GetImageData() != image.GetPointer())
+    {
+    std::cerr << "Line " << __LINE__ << " - Wrong volume histogram" << std::endl;
+    return EXIT_FAILURE;
+    }
+  volumeNode->SetAndObserveImageData(0);
+  if (volumeHistogram->GetImageData() != 0)
+    {
+    std::cerr << "Line " << __LINE__ << " - Image data still referenced" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  return EXIT_SUCCESS;
+}
@@ -22,8 +22,283 @@
 #include <vtkObjectFactory.h>
 #include <vtkTimerLog.h>
 
+// ITKSYS includes
+#include <itksys/hash_map.hxx>
+
+// STD includes
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <sstream>
+#include <string>
+#include <vector>
+
 vtkCxxSetObjectMacro(vtkEventBroker, TimerLog, vtkTimerLog);
 
+namespace
+{
+
+//----------------------------------------------------------------------------
+struct BatchedCall
+{
+  BatchedCall(vtkObservation* observation, unsigned long eventID, void* callData)
+    : Observation(observation)
+    , EventID(eventID)
+    , CallData(callData)
+  {
+  }
+  vtkObservation* Observation;
+  unsigned long EventID;
+  void* CallData;
+};
+
+//----------------------------------------------------------------------------
+typedef std::pair<vtkObservation*, unsigned long> BatchedCallKey;
+struct BatchedCallKeyHash
+{
+  size_t operator()(const BatchedCallKey& key) const
+  {
+    return (reinterpret_cast<size_t>(key.first) >> 3) ^
+      (static_cast<size_t>(key.second) * 2654435761u);
+  }
+};
+
+
+//----------------------------------------------------------------------------
+// Latencies are binned in a logarithmic histogram from 100ns to 1000s
+const int ProfileBinsPerDecade = 20;
+const int ProfileMinimumExponent = -7;
+const int ProfileNumberOfBins = 10 * ProfileBinsPerDecade;
+
+//----------------------------------------------------------------------------
+struct ProfileKey
+{
+  ProfileKey()
+    : Event(0)
+  {
+  }
+  std::string SubjectClass;
+  unsigned long Event;
+  std::string ObserverClass;
+  bool operator<(const ProfileKey& other) const
+  {
+    if (this->Event != other.Event)
+      {
+      return this->Event < other.Event;
+      }
+    if (this->SubjectClass != other.SubjectClass)
+      {
+      return this->SubjectClass < other.SubjectClass;
+      }
+    return this->ObserverClass < other.ObserverClass;
+  }
+};
+
+//----------------------------------------------------------------------------
+struct ProfileEntry
+{
+  ProfileEntry()
+    : Count(0)
+    , TotalTime(0.)
+    , SelfTime(0.)
+    , MaximumTime(0.)
+    , TotalNestingLevel(0)
+    , MaximumNestingLevel(0)
+    , Histogram(ProfileNumberOfBins, 0)
+  {
+  }
+  void Add(double elapsedTime, double selfTime, int nestingLevel)
+  {
+    ++this->Count;
+    this->TotalTime += elapsedTime;
+    this->SelfTime += selfTime;
+    this->MaximumTime = std::max(this->MaximumTime, elapsedTime);
+    this->TotalNestingLevel += nestingLevel;
+    this->MaximumNestingLevel = std::max(this->MaximumNestingLevel, nestingLevel);
+    int bin = 0;
+    if (elapsedTime > 0.)
+      {
+      double position = (log10(elapsedTime) - ProfileMinimumExponent) * ProfileBinsPerDecade;
+      bin = static_cast<int>(std::max(0., std::min(ProfileNumberOfBins - 1., floor(position))));
+      }
+    ++this->Histogram[bin];
+  }
+  /// Upper bound of the bin containing the percentile, clamped to the maximum
+  double GetPercentile(double percentile) const
+  {
+    unsigned long rank = static_cast<unsigned long>(ceil(percentile * this->Count));
+    unsigned long cumulatedCount = 0;
+    for (int bin = 0; bin < ProfileNumberOfBins; ++bin)
+      {
+      cumulatedCount += this->Histogram[bin];
+      if (cumulatedCount >= rank && cumulatedCount > 0)
+        {
+        double upperBound = pow(10., ProfileMinimumExponent +
+                                static_cast<double>(bin + 1) / ProfileBinsPerDecade);
+        return std::min(upperBound, this->MaximumTime);
+        }
+      }
+    return this->MaximumTime;
+  }
+  unsigned long Count;
+  double TotalTime;
+  double SelfTime;
+  double MaximumTime;
+  unsigned long TotalNestingLevel;
+  int MaximumNestingLevel;
+  std::vector<unsigned long> Histogram;
+};
+
+typedef std::map<ProfileKey, ProfileEntry> ProfileMap;
+
+//----------------------------------------------------------------------------
+struct TracedInvocation
+{
+  const ProfileKey* Key;
+  double StartTime;
+  double ElapsedTime;
+  int NestingLevel;
+};
+
+//----------------------------------------------------------------------------
+bool CompareTotalTime(ProfileMap::const_iterator a, ProfileMap::const_iterator b)
+{
+  return a->second.TotalTime > b->second.TotalTime;
+}
+
+//----------------------------------------------------------------------------
+std::string GetEventName(unsigned long event)
+{
+  const char* eventString = vtkCommand::GetStringFromEventId(event);
+  if (!strcmp(eventString, "NoEvent"))
+    {
+    std::stringstream ss;
+    ss << event;
+    return ss.str();
+    }
+  return eventString;
+}
+
+//----------------------------------------------------------------------------
+std::string EscapeCSV(const std::string& value)
+{
+  if (value.find_first_of(",\"\n\r") == std::string::npos)
+    {
+    return value;
+    }
+  std::string escaped = "\"";
+  for (std::string::const_iterator it = value.begin(); it != value.end(); ++it)
+    {
+    if (*it == '"')
+      {
+      escaped += '"';
+      }
+    escaped += *it;
+    }
+  return escaped + "\"";
+}
+
+//----------------------------------------------------------------------------
+std::string EscapeJSON(const std::string& value)
+{
+  std::string escaped = "\"";
+  for (std::string::const_iterator it = value.begin(); it != value.end(); ++it)
+    {
+    switch (*it)
+      {
+      case '"': escaped += "\\\""; break;
+      case '\\': escaped += "\\\\"; break;
+      case '\n': escaped += "\\n"; break;
+      case '\r': escaped += "\\r"; break;
+      case '\t': escaped += "\\t"; break;
+      default:
+        if (static_cast<unsigned char>(*it) < 0x20)
+          {
+          char code[8];
+          sprintf(code, "\\u%04x", static_cast<unsigned char>(*it));
+          escaped += code;
+          }
+        else
+          {
+          escaped += *it;
+          }
+      }
+    }
+  return escaped + "\"";
+}
+
+}
+
+//----------------------------------------------------------------------------
+class vtkEventBroker::vtkInternal
+{
+public:
+  typedef itksys::hash_map<BatchedCallKey, size_t, BatchedCallKeyHash> CallIndexMap;
+
+  /// Invocations of the current batch, in the order of their first occurrence
+  std::vector<BatchedCall> BatchedCalls;
+  /// Index in BatchedCalls of each (observation, event) pair
+  CallIndexMap BatchedCallIndices;
+  /// Invocations being performed by EndBatch()
+  std::vector<BatchedCall> FlushedCalls;
+
+  /// Aggregated invocations per (subject class, event, observer class)
+  ProfileMap Profile;
+  /// Invocations in the order they ended, for the Chrome trace
+  std::vector<TracedInvocation> TracedInvocations;
+  /// Time of the first profiled invocation, trace timestamps are relative to it
+  double ProfileStartTime;
+  /// Time spent in nested invocations, one entry per profiled invocation
+  /// being performed
+  std::vector<double> NestedTimes;
+
+  vtkInternal()
+    : ProfileStartTime(-1.)
+  {
+  }
+
+  /// Aggregate the invocation and trace it if the limit is not reached
+  void RecordInvocation(const ProfileKey& key, double startTime,
+                        double elapsedTime, double selfTime, int nestingLevel,
+                        int maximumNumberOfTracedInvocations)
+  {
+    ProfileMap::iterator it = this->Profile.insert(
+      ProfileMap::value_type(key, ProfileEntry())).first;
+    it->second.Add(elapsedTime, selfTime, nestingLevel);
+    if (static_cast<int>(this->TracedInvocations.size()) < maximumNumberOfTracedInvocations)
+      {
+      TracedInvocation invocation;
+      invocation.Key = &it->first;
+      invocation.StartTime = startTime - this->ProfileStartTime;
+      invocation.ElapsedTime = elapsedTime;
+      invocation.NestingLevel = nestingLevel;
+      this->TracedInvocations.push_back(invocation);
+      }
+  }
+
+  /// Forget the invocations of the removed observations
+  void RemoveObservations(const vtkEventBroker::ObservationVector& observations)
+  {
+    std::vector<BatchedCall>::iterator it;
+    for (it = this->BatchedCalls.begin(); it != this->BatchedCalls.end(); ++it)
+      {
+      if (it->Observation && observations.count(it->Observation))
+        {
+        this->BatchedCallIndices.erase(BatchedCallKey(it->Observation, it->EventID));
+        it->Observation = 0;
+        }
+      }
+    for (it = this->FlushedCalls.begin(); it != this->FlushedCalls.end(); ++it)
+      {
+      if (it->Observation && observations.count(it->Observation))
+        {
+        it->Observation = 0;
+        }
+      }
+  }
+};
+
 //----------------------------------------------------------------------------
 // The IO manager singleton.
 // This MUST be default initialized to zero by the compiler and is
@@ -95,10 +370,15 @@ vtkEventBroker::vtkEventBroker()
   this->EventLogging = 0;
   this->EventNestingLevel = 0;
   this->TimerLog = vtkTimerLog::New();
+  this->EventProfiling = 0;
+  this->MaximumNumberOfTracedInvocations = 100000;
   this->CompressCallData = 0;
   this->LogFileName = NULL;
   this->ScriptHandler = NULL;
   this->ScriptHandlerClientData = NULL;
+  this->Internal = new vtkInternal;
+  this->BatchLevel = 0;
+  this->NumberOfCollapsedInvocations = 0;
 }
 
 //----------------------------------------------------------------------------
@@ -118,6 +398,7 @@ vtkEventBroker::~vtkEventBroker()
     {
     this->TimerLog->Delete();
     }
+  delete this->Internal;
   //cout << "vtkEventBroker singleton Deleted" << endl;
 }
 
@@ -320,6 +601,9 @@ void vtkEventBroker::RemoveObservations (ObservationVector observations)
       }
     }
 
+  // remove from the current batch
+  this->Internal->RemoveObservations(observations);
+
   // detach and delete each of the observations
   for(ObservationVector::iterator removeIter=observations.begin(); removeIter != observations.end(); removeIter++)
     {
@@ -572,6 +856,141 @@ int vtkEventBroker::GenerateGraphFile ( const char *graphFile )
   return 0;
 }
 
+//----------------------------------------------------------------------------
+void vtkEventBroker::ResetEventProfile ()
+{
+  this->Internal->TracedInvocations.clear();
+  this->Internal->Profile.clear();
+  this->Internal->ProfileStartTime = -1.;
+}
+
+//----------------------------------------------------------------------------
+int vtkEventBroker::GetNumberOfEventProfileEntries ()
+{
+  return static_cast<int>( this->Internal->Profile.size() );
+}
+
+//----------------------------------------------------------------------------
+int vtkEventBroker::WriteEventProfile ( const char *fileName, int format )
+{
+  std::ofstream file;
+
+  file.open( fileName, std::ios::out );
+
+  if ( file.fail() )
+    {
+    vtkErrorMacro( "could not write to " << fileName );
+    return 1;
+    }
+
+  this->WriteEventProfile( file, format );
+  file.close();
+  return 0;
+}
+
+//----------------------------------------------------------------------------
+void vtkEventBroker::WriteEventProfile ( ostream& os, int format )
+{
+  if ( format == vtkEventBroker::ProfileChromeTrace )
+    {
+    // Complete events ("X") with timestamps and durations in microseconds,
+    // nesting is shown by the overlapping durations
+    std::ios::fmtflags flags = os.flags();
+    std::streamsize precision = os.precision(3);
+    os.setf(std::ios::fixed, std::ios::floatfield);
+    os << "{\"traceEvents\":[";
+    std::vector<TracedInvocation>::const_iterator it;
+    for (it = this->Internal->TracedInvocations.begin();
+         it != this->Internal->TracedInvocations.end(); ++it)
+      {
+      const ProfileKey* key = it->Key;
+      std::string eventName = GetEventName(key->Event);
+      os << (it == this->Internal->TracedInvocations.begin() ? "\n" : ",\n")
+         << "{\"name\":" << EscapeJSON(key->ObserverClass + " <- "
+                                       + key->SubjectClass + " " + eventName)
+         << ",\"cat\":" << EscapeJSON(eventName)
+         << ",\"ph\":\"X\",\"pid\":0,\"tid\":0"
+         << ",\"ts\":" << it->StartTime * 1e6
+         << ",\"dur\":" << it->ElapsedTime * 1e6
+         << ",\"args\":{\"subject\":" << EscapeJSON(key->SubjectClass)
+         << ",\"observer\":" << EscapeJSON(key->ObserverClass)
+         << ",\"nesting\":" << it->NestingLevel << "}}";
+      }
+    os << "\n],\"displayTimeUnit\":\"ms\"}\n";
+    os.flags(flags);
+    os.precision(precision);
+    return;
+    }
+
+  // Entries sorted by decreasing total time
+  std::vector<ProfileMap::const_iterator> entries;
+  for (ProfileMap::const_iterator it = this->Internal->Profile.begin();
+       it != this->Internal->Profile.end(); ++it)
+    {
+    entries.push_back(it);
+    }
+  std::stable_sort(entries.begin(), entries.end(), CompareTotalTime);
+
+  if ( format == vtkEventBroker::ProfileCSV )
+    {
+    os << "SubjectClass,Event,ObserverClass,Count,TotalTime,SelfTime,MeanTime,"
+       << "MaximumTime,50thPercentileTime,90thPercentileTime,99thPercentileTime,"
+       << "MeanNestingLevel,MaximumNestingLevel\n";
+    }
+  else if ( format == vtkEventBroker::ProfileJSON )
+    {
+    os << "{\"entries\":[";
+    }
+  else
+    {
+    vtkErrorMacro( "WriteEventProfile: unknown format " << format );
+    return;
+    }
+  for (size_t i = 0; i < entries.size(); ++i)
+    {
+    const ProfileKey& key = entries[i]->first;
+    const ProfileEntry& entry = entries[i]->second;
+    double count = static_cast<double>(entry.Count);
+    if ( format == vtkEventBroker::ProfileCSV )
+      {
+      os << EscapeCSV(key.SubjectClass) << ","
+         << EscapeCSV(GetEventName(key.Event)) << ","
+         << EscapeCSV(key.ObserverClass) << ","
+         << entry.Count << ","
+         << entry.TotalTime << ","
+         << entry.SelfTime << ","
+         << entry.TotalTime / count << ","
+         << entry.MaximumTime << ","
+         << entry.GetPercentile(0.5) << ","
+         << entry.GetPercentile(0.9) << ","
+         << entry.GetPercentile(0.99) << ","
+         << entry.TotalNestingLevel / count << ","
+         << entry.MaximumNestingLevel << "\n";
+      }
+    else
+      {
+      os << (i == 0 ? "\n" : ",\n")
+         << "{\"subjectClass\":" << EscapeJSON(key.SubjectClass)
+         << ",\"event\":" << EscapeJSON(GetEventName(key.Event))
+         << ",\"observerClass\":" << EscapeJSON(key.ObserverClass)
+         << ",\"count\":" << entry.Count
+         << ",\"totalTime\":" << entry.TotalTime
+         << ",\"selfTime\":" << entry.SelfTime
+         << ",\"meanTime\":" << entry.TotalTime / count
+         << ",\"maximumTime\":" << entry.MaximumTime
+         << ",\"50thPercentileTime\":" << entry.GetPercentile(0.5)
+         << ",\"90thPercentileTime\":" << entry.GetPercentile(0.9)
+         << ",\"99thPercentileTime\":" << entry.GetPercentile(0.99)
+         << ",\"meanNestingLevel\":" << entry.TotalNestingLevel / count
+         << ",\"maximumNestingLevel\":" << entry.MaximumNestingLevel << "}";
+      }
+    }
+  if ( format == vtkEventBroker::ProfileJSON )
+    {
+    os << "\n]}\n";
+    }
+}
+
 //----------------------------------------------------------------------------
 void vtkEventBroker::OpenLogFile ()
 {
@@ -682,7 +1101,11 @@ void vtkEventBroker::ProcessEvent ( vtkObservation *observation, vtkObject *call
   //
   if ( eid == observation->GetEvent() || observation->GetEvent() == vtkCommand::AnyEvent )
     {
-    if ( this->EventMode == vtkEventBroker::Synchronous || eid == vtkCommand::DeleteEvent )
+    if ( eid != vtkCommand::DeleteEvent && this->BatchLevel > 0 )
+      {
+      this->BatchObservation( observation, eid, callData );
+      }
+    else if ( this->EventMode == vtkEventBroker::Synchronous || eid == vtkCommand::DeleteEvent )
       {
       this->InvokeObservation( observation, eid, callData );
       }
@@ -815,6 +1238,30 @@ void vtkEventBroker::InvokeObservation ( vtkObservation *observation,
 
   double startTime = this->TimerLog->GetUniversalTime();
 
+  // The subject may not exist anymore after the callback is executed
+  bool profiling = (this->EventProfiling != 0);
+  ProfileKey profileKey;
+  size_t nestedTimeIndex = this->Internal->NestedTimes.size();
+  if (profiling)
+    {
+    profileKey.SubjectClass = observation->GetSubject()->GetClassName();
+    profileKey.Event = eid;
+    if ( observation->GetScript() != NULL )
+      {
+      profileKey.ObserverClass = observation->GetScript();
+      }
+    else
+      {
+      profileKey.ObserverClass = observation->GetObserver() ?
+        observation->GetObserver()->GetClassName() : "No observer class";
+      }
+    this->Internal->NestedTimes.push_back(0.);
+    if (this->Internal->ProfileStartTime < 0.)
+      {
+      this->Internal->ProfileStartTime = startTime;
+      }
+    }
+
   // Register so observation won't be deleted while callback is running
   observation->Register(this);
 
@@ -844,6 +1291,19 @@ void vtkEventBroker::InvokeObservation ( vtkObservation *observation,
   observation->SetLastElapsedTime (elapsedTime);
   this->LogEvent (observation);
 
+  if (profiling && this->Internal->NestedTimes.size() > nestedTimeIndex)
+    {
+    double nestedTime = this->Internal->NestedTimes[nestedTimeIndex];
+    this->Internal->NestedTimes.resize(nestedTimeIndex);
+    if (nestedTimeIndex > 0)
+      {
+      this->Internal->NestedTimes[nestedTimeIndex - 1] += elapsedTime;
+      }
+    this->Internal->RecordInvocation(profileKey, startTime, elapsedTime,
+                                     elapsedTime - nestedTime, this->EventNestingLevel,
+                                     this->MaximumNumberOfTracedInvocations);
+    }
+
   // clear reference to observation (may cause delete)
   observation->Delete();
   this->EventNestingLevel--;
@@ -883,6 +1343,70 @@ void vtkEventBroker::ProcessEventQueue ()
     }
 }
 
+//----------------------------------------------------------------------------
+void vtkEventBroker::BatchObservation ( vtkObservation *observation,
+                                        unsigned long eid,
+                                        void *callData )
+{
+  BatchedCallKey key(observation, eid);
+  vtkInternal::CallIndexMap::iterator it =
+    this->Internal->BatchedCallIndices.find(key);
+  if (it != this->Internal->BatchedCallIndices.end())
+    {
+    // only keep the most recent call data
+    this->Internal->BatchedCalls[it->second].CallData = callData;
+    ++this->NumberOfCollapsedInvocations;
+    return;
+    }
+  this->Internal->BatchedCallIndices[key] = this->Internal->BatchedCalls.size();
+  this->Internal->BatchedCalls.push_back(BatchedCall(observation, eid, callData));
+}
+
+//----------------------------------------------------------------------------
+void vtkEventBroker::StartBatch ()
+{
+  ++this->BatchLevel;
+}
+
+//----------------------------------------------------------------------------
+void vtkEventBroker::EndBatch ()
+{
+  if (this->BatchLevel <= 0)
+    {
+    vtkErrorMacro("EndBatch: StartBatch() has not been called");
+    return;
+    }
+  if (this->BatchLevel > 1)
+    {
+    --this->BatchLevel;
+    return;
+    }
+  // The batch is kept open while the observations are invoked so that the
+  // events they trigger are collapsed and invoked after them.
+  while (!this->Internal->BatchedCalls.empty())
+    {
+    this->Internal->FlushedCalls.swap(this->Internal->BatchedCalls);
+    this->Internal->BatchedCallIndices.clear();
+    for (size_t i = 0; i < this->Internal->FlushedCalls.size(); ++i)
+      {
+      BatchedCall call = this->Internal->FlushedCalls[i];
+      // the observation is reset if it has been removed in the meantime
+      if (call.Observation)
+        {
+        this->InvokeObservation(call.Observation, call.EventID, call.CallData);
+        }
+      }
+    this->Internal->FlushedCalls.clear();
+    }
+  this->BatchLevel = 0;
+}
+
+//----------------------------------------------------------------------------
+int vtkEventBroker::GetNumberOfBatchedObservations ()
+{
+  return static_cast<int>( this->Internal->BatchedCallIndices.size() );
+}
+
 //----------------------------------------------------------------------------
 void vtkEventBroker::PrintSelf(ostream& os, vtkIndent indent)
 {
@@ -891,8 +1415,14 @@ void vtkEventBroker::PrintSelf(ostream& os, vtkIndent indent)
   os << indent << "NumberOfObservations: " << this->GetNumberOfObservations() << "\n";
   os << indent << "NumberOfQueueObservations: " << this->GetNumberOfQueuedObservations() << "\n";
   os << indent << "EventMode: " << this->GetEventModeAsString() << "\n";
+  os << indent << "BatchLevel: " << this->BatchLevel << "\n";
+  os << indent << "NumberOfBatchedObservations: " << this->GetNumberOfBatchedObservations() << "\n";
+  os << indent << "NumberOfCollapsedInvocations: " << this->NumberOfCollapsedInvocations << "\n";
   os << indent << "EventLogging: " << this->EventLogging << "\n";
   os << indent << "EventNestingLevel: " << this->EventNestingLevel << "\n";
+  os << indent << "EventProfiling: " << this->EventProfiling << "\n";
+  os << indent << "NumberOfEventProfileEntries: " << this->GetNumberOfEventProfileEntries() << "\n";
+  os << indent << "MaximumNumberOfTracedInvocations: " << this->MaximumNumberOfTracedInvocations << "\n";
   os << indent << "LogFileName: " <<
     (this->LogFileName ? this->LogFileName : "(none)") << "\n";
 }
@@ -926,3 +1456,20 @@ void vtkEventBroker::classFinalize()
   vtkEventBrokerInstance->Delete();
   vtkEventBrokerInstance = 0;
 }
+
+//----------------------------------------------------------------------------
+// Implementation of vtkEventBrokerScopedBatch class.
+//----------------------------------------------------------------------------
+vtkEventBrokerScopedBatch::vtkEventBrokerScopedBatch(vtkEventBroker* broker)
+  : Broker(broker ? broker : vtkEventBroker::GetInstance())
+{
+  this->Broker->Register(NULL);
+  this->Broker->StartBatch();
+}
+
+//----------------------------------------------------------------------------
+vtkEventBrokerScopedBatch::~vtkEventBrokerScopedBatch()
+{
+  this->Broker->EndBatch();
+  this->Broker->UnRegister(NULL);
+}
@@ -173,6 +173,48 @@ public:
   /// Write out the current list of observations in graphviz format (.dot)
   int GenerateGraphFile ( const char *graphFile );
 
+  /// Event Profiling
+  ///
+  /// When EventProfiling is on, every invocation is aggregated per
+  /// (subject class, event, observer class) triplet: number of invocations,
+  /// total and self (excluding nested invocations) time, maximum and
+  /// percentile (50, 90 and 99) latencies, mean and maximum nesting level.
+  /// Percentiles are estimated from a logarithmic histogram (about 12%
+  /// precision). Individual invocations are also recorded (up to
+  /// MaximumNumberOfTracedInvocations) to be exported as a Chrome trace
+  /// (chrome://tracing). Profiling is off by default.
+  /// \sa WriteEventProfile(), ResetEventProfile()
+  vtkBooleanMacro (EventProfiling, int);
+  vtkSetMacro (EventProfiling, int);
+  vtkGetMacro (EventProfiling, int);
+
+  ///
+  /// Maximum number of invocations kept for the Chrome trace.
+  /// Invocations past the limit are still aggregated. 100000 by default.
+  vtkSetMacro (MaximumNumberOfTracedInvocations, int);
+  vtkGetMacro (MaximumNumberOfTracedInvocations, int);
+
+  ///
+  /// Forget all the profiled invocations.
+  void ResetEventProfile();
+
+  ///
+  /// Number of (subject class, event, observer class) triplets profiled
+  int GetNumberOfEventProfileEntries();
+
+  enum EventProfileFormat {
+    ProfileCSV,
+    ProfileJSON,
+    ProfileChromeTrace
+  };
+
+  ///
+  /// Write the profiled invocations. CSV and JSON contain one entry per
+  /// triplet sorted by decreasing total time, times are in seconds.
+  /// Return 0 on success, 1 if the file can't be written.
+  int WriteEventProfile ( const char *fileName, int format );
+  void WriteEventProfile ( ostream& os, int format );
+
 
   /// Event Queue processing modes
   ///
@@ -233,6 +275,29 @@ public:
   vtkGetMacro (CompressCallData, int);
   vtkSetMacro (CompressCallData, int);
 
+  /// Batch processing
+  ///
+  /// Between StartBatch() and EndBatch(), observations are not invoked when
+  /// the event takes place (except for DeleteEvent) but are stored until
+  /// the batch ends. Multiple invocations of the same observation for the
+  /// same event are collapsed into one that receives the most recent call
+  /// data. EndBatch() invokes the stored observations in the order they
+  /// were first triggered. Events triggered by the invoked observations are
+  /// collapsed the same way and invoked after them, until no event is left.
+  /// Batches can be nested, the observations are invoked when the outermost
+  /// batch ends. Batches are independent of the EventMode.
+  /// \sa vtkEventBrokerScopedBatch, GetNumberOfCollapsedInvocations()
+  void StartBatch();
+  void EndBatch();
+  bool IsBatching() {return this->BatchLevel > 0;};
+  int GetNumberOfBatchedObservations();
+
+  ///
+  /// Number of invocations that have been saved by collapsing them in
+  /// batches. Can be reset by setting it to 0.
+  vtkGetMacro (NumberOfCollapsedInvocations, unsigned long);
+  vtkSetMacro (NumberOfCollapsedInvocations, unsigned long);
+
   ///
   /// Sets the method pointer to be used for processing script observations
   void SetScriptHandler ( void (*scriptHandler) (const char* script, void *clientData), void *clientData )
@@ -275,6 +340,16 @@ protected:
   /// The event queue of triggered but not-yet-invoked observations
   std::deque< vtkObservation * > EventQueue;
 
+  /// Store an invocation of the observation for the current batch
+  void BatchObservation (vtkObservation *observation, unsigned long eid,
+                         void *callData);
+
+  /// Observations triggered during the current batch and event profile
+  class vtkInternal;
+  vtkInternal* Internal;
+  int BatchLevel;
+  unsigned long NumberOfCollapsedInvocations;
+
   void (*ScriptHandler) (const char* script, void* clientData);
   void *ScriptHandlerClientData;
 
@@ -283,6 +358,9 @@ protected:
   char *LogFileName;
   vtkTimerLog *TimerLog;
 
+  int EventProfiling;
+  int MaximumNumberOfTracedInvocations;
+
   int EventMode;
   int CompressCallData;
 
@@ -296,6 +374,28 @@ private:
   friend class vtkObservation;
 };
 
+/// \brief Utility class to batch the events of the event broker in a scope.
+///
+/// The batch starts when the object is created and ends (invoking the
+/// collapsed observations) when it goes out of scope:
+/// \code
+/// {
+/// vtkEventBrokerScopedBatch batch;
+/// // ... modify many nodes
+/// }
+/// \endcode
+/// \sa vtkEventBroker::StartBatch()
+class VTK_MRML_EXPORT vtkEventBrokerScopedBatch
+{
+public:
+  vtkEventBrokerScopedBatch(vtkEventBroker* broker = 0);
+  ~vtkEventBrokerScopedBatch();
+private:
+  vtkEventBrokerScopedBatch(const vtkEventBrokerScopedBatch&); // Not implemented
+  void operator=(const vtkEventBrokerScopedBatch&); // Not implemented
+  vtkEventBroker* Broker;
+};
+
 /// Utility class to make sure qSlicerModuleManager is initialized before it is used.
 class VTK_MRML_EXPORT vtkEventBrokerInitialize
 {
@@ -43,6 +43,9 @@ public:
   /// Return true if reference node can be written from
   virtual bool CanWriteFromReferenceNode(vtkMRMLNode *refNode);
 
+  /// The FreeSurfer readers are not read ahead
+  virtual bool CanReadInParallel() { return false; };
+
 protected:
   vtkMRMLFreeSurferModelOverlayStorageNode();
   ~vtkMRMLFreeSurferModelOverlayStorageNode();
@@ -58,6 +58,9 @@ class VTK_MRML_EXPORT vtkMRMLFreeSurferModelStorageNode : public vtkMRMLModelSto
   vtkGetMacro(UseStripper, int);
   vtkSetMacro(UseStripper, int);
 
+  /// The FreeSurfer readers are not read ahead
+  virtual bool CanReadInParallel() { return false; };
+
 protected:
   vtkMRMLFreeSurferModelStorageNode();
   ~vtkMRMLFreeSurferModelStorageNode();
@@ -48,6 +48,42 @@ bool vtkMRMLHierarchyNodeSortPredicate(vtkMRMLHierarchyNodePointer d1, vtkMRMLHi
   return d1->GetSortingValue() < d2->GetSortingValue();
 }
 
+namespace
+{
+
+//----------------------------------------------------------------------------
+bool SortingValueLessThan(vtkMRMLHierarchyNodePointer node, double value)
+{
+  return node->GetSortingValue() < value;
+}
+
+//----------------------------------------------------------------------------
+bool SortingValueGreaterThan(double value, vtkMRMLHierarchyNodePointer node)
+{
+  return value < node->GetSortingValue();
+}
+
+//----------------------------------------------------------------------------
+// Index of the node in children sorted by SortingValue, -1 if not found.
+int FindSortedChild(const std::vector< vtkMRMLHierarchyNode *>& children,
+                    vtkMRMLHierarchyNode* node)
+{
+  const double sortingValue = node->GetSortingValue();
+  std::vector< vtkMRMLHierarchyNode *>::const_iterator it =
+    std::lower_bound(children.begin(), children.end(), sortingValue,
+                     SortingValueLessThan);
+  for (; it != children.end() && (*it)->GetSortingValue() == sortingValue; ++it)
+    {
+    if (*it == node)
+      {
+      return static_cast<int>(it - children.begin());
+      }
+    }
+  return -1;
+}
+
+}
+
 //----------------------------------------------------------------------------
 vtkMRMLNodeNewMacro(vtkMRMLHierarchyNode);
 
@@ -143,6 +179,7 @@ void vtkMRMLHierarchyNode::ReadXMLAttributes(const char** atts)
       std::stringstream ss;
       ss << attValue;
       ss >> SortingValue;
+      this->HierarchyIsModified(this->GetScene());
       }
     else if (!strcmp(attName, "allowMultipleChildren"))
       {
@@ -174,6 +211,8 @@ void vtkMRMLHierarchyNode::Copy(vtkMRMLNode *anode)
   this->SetAssociatedNodeIDReference(node->AssociatedNodeIDReference);
   this->SortingValue = node->SortingValue;
   this->SetAllowMultipleChildren(node->AllowMultipleChildren);
+  // parent and sorting value are not set incrementally
+  this->HierarchyIsModified(this->GetScene());
 
   this->EndModify(disabledModify);
   this->InvokeHierarchyModifiedEvent();
@@ -261,10 +300,17 @@ void vtkMRMLHierarchyNode::SetParentNodeID(const char* ref)
 
   int disableModify = this->StartModify();
 
+  // Move the node from the children of its old parent to the children of its
+  // new parent instead of rebuilding the whole children map.
+  bool childrenMapUpdated = this->RemoveFromChildrenMap();
   this->SetParentNodeIDReference(ref);
-  this->SetSortingValue(++MaximumSortingValue);
-
-  this->HierarchyIsModified(this->GetScene());
+  this->SortingValue = ++MaximumSortingValue;
+  this->Modified();
+  childrenMapUpdated = childrenMapUpdated && this->InsertInChildrenMap();
+  if (!childrenMapUpdated)
+    {
+    this->HierarchyIsModified(this->GetScene());
+    }
   if (this->GetScene())
     {
     this->GetScene()->AddReferencedNodeID(ref, this);
@@ -309,36 +355,28 @@ vtkMRMLHierarchyNode* vtkMRMLHierarchyNode::GetTopParentNode()
 //----------------------------------------------------------------------------
 void vtkMRMLHierarchyNode::GetAllChildrenNodes(std::vector< vtkMRMLHierarchyNode *> &childrenNodes)
 {
-  if (this->GetScene() == NULL)
-    {
-    return;
-    }
-
-  this->UpdateChildrenMap();
-
-  std::map< vtkMRMLScene*, HierarchyChildrenNodesType>::iterator siter =
-        SceneHierarchyChildrenNodes.find(this->GetScene());
-
-  HierarchyChildrenNodesType::iterator iter =
-    siter->second.find(std::string(this->GetID()));
-  if (iter == siter->second.end())
-    {
-    return;
-    }
-  for (unsigned int i=0; i<iter->second.size(); i++)
+  const std::vector< vtkMRMLHierarchyNode *>& children =
+    this->GetChildrenNodesReference();
+  for (unsigned int i=0; i<children.size(); i++)
     {
-    childrenNodes.push_back(iter->second[i]);
-    iter->second[i]->GetAllChildrenNodes(childrenNodes);
+    childrenNodes.push_back(children[i]);
+    children[i]->GetAllChildrenNodes(childrenNodes);
     }
 }
 
 //----------------------------------------------------------------------------
 std::vector< vtkMRMLHierarchyNode *> vtkMRMLHierarchyNode::GetChildrenNodes()
 {
-  std::vector< vtkMRMLHierarchyNode *> childrenNodes;
-  if (this->GetScene() == NULL)
+  return this->GetChildrenNodesReference();
+}
+
+//----------------------------------------------------------------------------
+const std::vector< vtkMRMLHierarchyNode *>& vtkMRMLHierarchyNode::GetChildrenNodesReference()
+{
+  static const std::vector< vtkMRMLHierarchyNode *> noChildren;
+  if (this->GetScene() == NULL || this->GetID() == NULL)
     {
-    return childrenNodes;
+    return noChildren;
     }
 
   this->UpdateChildrenMap();
@@ -350,23 +388,18 @@ std::vector< vtkMRMLHierarchyNode *> vtkMRMLHierarchyNode::GetChildrenNodes()
     siter->second.find(std::string(this->GetID()));
   if (iter == siter->second.end())
     {
-    return childrenNodes;
-    }
-  for (unsigned int i=0; i<iter->second.size(); i++)
-    {
-    childrenNodes.push_back(iter->second[i]);
+    return noChildren;
     }
-
-  // Sort the vector using predicate and std::sort
-  std::sort(childrenNodes.begin(), childrenNodes.end(), vtkMRMLHierarchyNodeSortPredicate);
-
-  return childrenNodes;
+  // the children are kept sorted by UpdateChildrenMap(), SetSortingValue()
+  // and SetParentNodeID()
+  return iter->second;
 }
 
 //----------------------------------------------------------------------------
 vtkMRMLHierarchyNode* vtkMRMLHierarchyNode::GetNthChildNode(int index)
 {
-  std::vector< vtkMRMLHierarchyNode *> childrenNodes = this->GetChildrenNodes();
+  const std::vector< vtkMRMLHierarchyNode *>& childrenNodes =
+    this->GetChildrenNodesReference();
   if (index < 0 || index > (int)(childrenNodes.size()-1))
     {
     vtkErrorMacro("vtkMRMLHierarchyNode::GetNthChildNode() index " << index << " outside the range 0-" << childrenNodes.size()-1 );
@@ -390,15 +423,7 @@ int vtkMRMLHierarchyNode::GetIndexInParent()
     }
   else
     {
-    std::vector< vtkMRMLHierarchyNode *> childrenNodes = pnode->GetChildrenNodes();
-    for (unsigned int i=0; i<childrenNodes.size(); i++)
-      {
-      if (childrenNodes[i] == this)
-        {
-        return i;
-        }
-      }
-    return -1;
+    return FindSortedChild(pnode->GetChildrenNodesReference(), this);
     }
 }
 
@@ -414,7 +439,8 @@ void vtkMRMLHierarchyNode::SetIndexInParent(int index)
     }
   else
     {
-    std::vector< vtkMRMLHierarchyNode *> childrenNodes = pnode->GetChildrenNodes();
+    const std::vector< vtkMRMLHierarchyNode *>& childrenNodes =
+      pnode->GetChildrenNodesReference();
     if (index < 0 || index >= (int)childrenNodes.size())
       {
       vtkErrorMacro("vtkMRMLHierarchyNode::SetIndexInParent() index " << index << ", outside the range 0-" << childrenNodes.size()-1);
@@ -461,9 +487,13 @@ void vtkMRMLHierarchyNode::MoveInParent(int increment)
     }
   else
     {
-    std::vector< vtkMRMLHierarchyNode *> childrenNodes = pnode->GetChildrenNodes();
+    // the children are modified in place, they stay sorted because the
+    // nodes are swapped along with their sorting values
+    std::vector< vtkMRMLHierarchyNode *>& childrenNodes =
+      const_cast<std::vector< vtkMRMLHierarchyNode *>&>(pnode->GetChildrenNodesReference());
     int oldIndex = this->GetIndexInParent();
-    if (oldIndex + increment < 0 || oldIndex + increment >= (int)childrenNodes.size())
+    if (oldIndex < 0 ||
+        oldIndex + increment < 0 || oldIndex + increment >= (int)childrenNodes.size())
       {
       vtkErrorMacro("vtkMRMLHierarchyNode::MoveInParent() index " << oldIndex << ", outside the range 0-" << childrenNodes.size()-1);
       return;
@@ -474,14 +504,11 @@ void vtkMRMLHierarchyNode::MoveInParent(int increment)
     for (int i=0; i<incr1*increment; i++)
       {
       // swap pair of sort values
-      childrenNodes = pnode->GetChildrenNodes();
       double sortValue1 = childrenNodes[index1]->GetSortingValue();
       double sortValue2 = childrenNodes[index2]->GetSortingValue();
       childrenNodes[index1]->SortingValue = sortValue2;
       childrenNodes[index2]->SortingValue = sortValue1;
-
-      // update the cache
-      pnode->UpdateChildrenMap();
+      std::swap(childrenNodes[index1], childrenNodes[index2]);
       index1 += incr1;
       index2 += incr1;
       }
@@ -617,11 +644,102 @@ void vtkMRMLHierarchyNode::UpdateChildrenMap()
           }
         }
       }
+    for (iter  = siter->second.begin();
+         iter != siter->second.end();
+         iter++)
+      {
+      std::stable_sort(iter->second.begin(), iter->second.end(),
+                       vtkMRMLHierarchyNodeSortPredicate);
+      }
     titer->second = this->GetScene()->GetNodes()->GetMTime();
     this->MaximumSortingValue = maxSortingValue;
   }
 }
 
+//----------------------------------------------------------------------------
+vtkMRMLHierarchyNode::HierarchyChildrenNodesType*
+vtkMRMLHierarchyNode::GetUpToDateChildrenMap(vtkMRMLScene *scene)
+{
+  if (scene == NULL)
+    {
+    return NULL;
+    }
+  std::map< vtkMRMLScene*, unsigned long>::iterator titer =
+    SceneHierarchyChildrenNodesMTime.find(scene);
+  if (titer == SceneHierarchyChildrenNodesMTime.end() ||
+      titer->second == 0 ||
+      scene->GetNodes()->GetMTime() > titer->second)
+    {
+    return NULL;
+    }
+  return &SceneHierarchyChildrenNodes[scene];
+}
+
+//----------------------------------------------------------------------------
+bool vtkMRMLHierarchyNode::RemoveFromChildrenMap()
+{
+  vtkMRMLScene* scene = this->GetScene();
+  if (scene == NULL)
+    {
+    return true;
+    }
+  HierarchyChildrenNodesType* childrenMap = this->GetUpToDateChildrenMap(scene);
+  if (childrenMap == NULL)
+    {
+    return false;
+    }
+  vtkMRMLHierarchyNode* parentNode = this->GetParentNode();
+  if (parentNode == NULL || this->GetID() == NULL ||
+      scene->GetNodeByID(this->GetID()) != this)
+    {
+    // the node is not in the map
+    return true;
+    }
+  HierarchyChildrenNodesType::iterator iter =
+    childrenMap->find(std::string(parentNode->GetID()));
+  int index = (iter != childrenMap->end()) ?
+    FindSortedChild(iter->second, this) : -1;
+  if (index < 0)
+    {
+    return false;
+    }
+  iter->second.erase(iter->second.begin() + index);
+  if (iter->second.empty())
+    {
+    childrenMap->erase(iter);
+    }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool vtkMRMLHierarchyNode::InsertInChildrenMap()
+{
+  vtkMRMLScene* scene = this->GetScene();
+  if (scene == NULL)
+    {
+    return true;
+    }
+  HierarchyChildrenNodesType* childrenMap = this->GetUpToDateChildrenMap(scene);
+  if (childrenMap == NULL)
+    {
+    return false;
+    }
+  vtkMRMLHierarchyNode* parentNode = this->GetParentNode();
+  if (parentNode == NULL || this->GetID() == NULL ||
+      scene->GetNodeByID(this->GetID()) != this)
+    {
+    // the node does not belong to the map
+    return true;
+    }
+  std::vector< vtkMRMLHierarchyNode *>& children =
+    (*childrenMap)[std::string(parentNode->GetID())];
+  // after the children with the same sorting value, as std::stable_sort
+  children.insert(std::upper_bound(children.begin(), children.end(),
+                                   this->SortingValue, SortingValueGreaterThan),
+                  this);
+  return true;
+}
+
 void vtkMRMLHierarchyNode::HierarchyIsModified(vtkMRMLScene *scene)
 {
   if (scene == NULL)
@@ -810,7 +928,15 @@ void vtkMRMLHierarchyNode::SetSortingValue(double value)
   vtkDebugMacro(<< this->GetClassName() << " (" << this << "): setting SortingValue to " << value);
   if (this->SortingValue != value)
     {
+    // Move the node among the children of its parent instead of rebuilding
+    // the whole children map.
+    bool childrenMapUpdated = this->RemoveFromChildrenMap();
     this->SortingValue = value;
+    childrenMapUpdated = childrenMapUpdated && this->InsertInChildrenMap();
+    if (!childrenMapUpdated)
+      {
+      this->HierarchyIsModified(this->GetScene());
+      }
     this->Modified();
 
     this->InvokeHierarchyModifiedEvent();
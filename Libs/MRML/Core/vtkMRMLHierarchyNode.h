@@ -93,10 +93,18 @@ public:
   /// std::vector< vtkMRMLHierarchyNode* > children = this->GetChildrenNodes();
   std::vector< vtkMRMLHierarchyNode *> GetChildrenNodes();
 
+  ///
+  /// Same as GetChildrenNodes() but without copying the children.
+  /// The children are sorted in the order of their SortingValue.
+  /// The returned vector must not be kept: it is invalidated by any change
+  /// of the hierarchy (reparenting, sorting value change, node added to or
+  /// removed from the scene).
+  const std::vector< vtkMRMLHierarchyNode *>& GetChildrenNodesReference();
+
   /// Returns the number of immediate children in the hierarchy
   int GetNumberOfChildrenNodes()
   {
-    return static_cast<int>(this->GetChildrenNodes().size());
+    return static_cast<int>(this->GetChildrenNodesReference().size());
   }
 
   /// Get n-th child node sorted in the order of their SortingValue
@@ -215,8 +223,24 @@ protected:
 
   static double MaximumSortingValue;
 
+  /// Rebuild the children map of the scene if nodes have been added or
+  /// removed or if the hierarchy has been modified.
+  /// The children of each parent are sorted by SortingValue.
   void UpdateChildrenMap();
 
+  /// Return the children map of the scene if it is up to date, NULL if it
+  /// has to be rebuilt by UpdateChildrenMap().
+  static HierarchyChildrenNodesType* GetUpToDateChildrenMap(vtkMRMLScene *scene);
+
+  /// Remove this node from the children of its parent in the children map.
+  /// Return false if the map could not be updated and must be rebuilt.
+  bool RemoveFromChildrenMap();
+
+  /// Insert this node in the children of its parent in the children map at
+  /// the position given by its SortingValue.
+  /// Return false if the map could not be updated and must be rebuilt.
+  bool InsertInChildrenMap();
+
   /// is this a node that's only supposed to have one child?
   int AllowMultipleChildren;
 
@@ -26,13 +26,16 @@
 #include <vtkOBJReader.h>
 #include <vtkPLYReader.h>
 #include <vtkPLYWriter.h>
+#include <vtkPolyData.h>
 #include <vtkPolyDataReader.h>
 #include <vtkPolyDataWriter.h>
 #include <vtkSTLReader.h>
 #include <vtkSTLWriter.h>
+#include <vtkSmartPointer.h>
 #include <vtkStringArray.h>
 #include <vtksys/SystemTools.hxx>
 #include <vtkTriangleFilter.h>
+#include <vtkTrivialProducer.h>
 #include <vtkUnstructuredGrid.h>
 #include <vtkUnstructuredGridReader.h>
 #include <vtkXMLPolyDataReader.h>
@@ -103,18 +106,67 @@ int vtkMRMLModelStorageNode::ReadDataInternal(vtkMRMLNode *refNode)
 {
   vtkMRMLModelNode *modelNode = dynamic_cast <vtkMRMLModelNode *> (refNode);
 
+  vtkSmartPointer<vtkAlgorithm> source = vtkAlgorithm::SafeDownCast(this->PreReadObject);
+  if (!source)
+    {
+    source.TakeReference(this->ReadModel());
+    }
+  if (!source)
+    {
+    return 0;
+    }
+  vtkTrivialProducer* producer = vtkTrivialProducer::SafeDownCast(source);
+  if (producer)
+    {
+    modelNode->SetAndObservePolyData(
+      vtkPolyData::SafeDownCast(producer->GetOutputDataObject(0)));
+    }
+  else
+    {
+    modelNode->SetPolyDataConnection(source->GetOutputPort());
+    }
+
+  if (modelNode->GetPolyData() != NULL)
+    {
+    // is there an active scalar array?
+    if (modelNode->GetDisplayNode())
+      {
+      double *scalarRange =  modelNode->GetPolyData()->GetScalarRange();
+      if (scalarRange)
+        {
+        vtkDebugMacro("ReadDataInternal: setting scalar range " << scalarRange[0] << ", " << scalarRange[1]);
+        modelNode->GetDisplayNode()->SetScalarRange(scalarRange);
+        }
+      }
+    //modelNode->GetPolyData()->Modified();
+    }
+  return 1;
+}
+
+//----------------------------------------------------------------------------
+int vtkMRMLModelStorageNode::PreReadDataInternal(vtkMRMLNode *vtkNotUsed(refNode))
+{
+  // The readers don't access any node, the polydata is set into the model
+  // node by ReadDataInternal().
+  this->PreReadObject.TakeReference(this->ReadModel());
+  return this->PreReadObject.GetPointer() != NULL;
+}
+
+//----------------------------------------------------------------------------
+vtkAlgorithm* vtkMRMLModelStorageNode::ReadModel()
+{
   std::string fullName = this->GetFullNameFromFileName();
   if (fullName == std::string(""))
     {
     vtkErrorMacro("ReadDataInternal: File name not specified");
-    return 0;
+    return NULL;
     }
 
   // check that the file exists
   if (vtksys::SystemTools::FileExists(fullName.c_str()) == false)
     {
     vtkErrorMacro("ReadDataInternal: model file '" << fullName.c_str() << "' not found.");
-    return 0;
+    return NULL;
     }
 
   // compute file prefix
@@ -122,12 +174,12 @@ int vtkMRMLModelStorageNode::ReadDataInternal(vtkMRMLNode *refNode)
   if( extension.empty() )
     {
     vtkErrorMacro("ReadData: no file extension specified: " << fullName.c_str());
-    return 0;
+    return NULL;
     }
 
   vtkDebugMacro("ReadDataInternal: extension = " << extension.c_str());
 
-  int result = 1;
+  vtkSmartPointer<vtkAlgorithm> source;
   try
     {
     if ( extension == std::string(".g") || extension == std::string(".byu") )
@@ -135,7 +187,7 @@ int vtkMRMLModelStorageNode::ReadDataInternal(vtkMRMLNode *refNode)
       vtkNew<vtkBYUReader> reader;
       reader->SetGeometryFileName(fullName.c_str());
       reader->Update();
-      modelNode->SetPolyDataConnection(reader->GetOutputPort());
+      source = reader.GetPointer();
       }
     else if (extension == std::string(".vtk"))
       {
@@ -166,11 +218,10 @@ int vtkMRMLModelStorageNode::ReadDataInternal(vtkMRMLNode *refNode)
       if (output == 0)
         {
         vtkErrorMacro("Unable to read file " << fullName.c_str());
-        result = 0;
         }
       else
         {
-        modelNode->SetPolyDataConnection(reader->GetOutputPort());
+        source = reader.GetPointer();
         }
       }
     else if (extension == std::string(".vtp"))
@@ -178,28 +229,28 @@ int vtkMRMLModelStorageNode::ReadDataInternal(vtkMRMLNode *refNode)
       vtkNew<vtkXMLPolyDataReader> reader;
       reader->SetFileName(fullName.c_str());
       reader->Update();
-      modelNode->SetPolyDataConnection(reader->GetOutputPort());
+      source = reader.GetPointer();
       }
     else if (extension == std::string(".stl"))
       {
       vtkNew<vtkSTLReader> reader;
       reader->SetFileName(fullName.c_str());
       reader->Update();
-      modelNode->SetPolyDataConnection(reader->GetOutputPort());
+      source = reader.GetPointer();
       }
     else if (extension == std::string(".ply"))
       {
       vtkNew<vtkPLYReader> reader;
       reader->SetFileName(fullName.c_str());
       reader->Update();
-      modelNode->SetPolyDataConnection(reader->GetOutputPort());
+      source = reader.GetPointer();
       }
     else if (extension == std::string(".obj"))
       {
       vtkNew<vtkOBJReader> reader;
       reader->SetFileName(fullName.c_str());
       reader->Update();
-      modelNode->SetPolyDataConnection(reader->GetOutputPort());
+      source = reader.GetPointer();
       }
     else if (extension == std::string(".meta"))  // model in meta format
       {
@@ -220,7 +271,7 @@ int vtkMRMLModelStorageNode::ReadDataInternal(vtkMRMLNode *refNode)
       catch(itk::ExceptionObject ex)
         {
         std::cout<<ex.GetDescription()<<std::endl;
-        result = 0;
+        return NULL;
         }
       vtkNew<vtkPolyData> vtkMesh;
       // Get the number of points in the mesh
@@ -260,34 +311,26 @@ int vtkMRMLModelStorageNode::ReadDataInternal(vtkMRMLNode *refNode)
 
       vtkMesh->SetPolys(cells.GetPointer());
 
-      modelNode->SetAndObservePolyData(vtkMesh.GetPointer());
+      // the mesh is set with SetAndObservePolyData() by ReadDataInternal()
+      vtkNew<vtkTrivialProducer> producer;
+      producer->SetOutput(vtkMesh.GetPointer());
+      source = producer.GetPointer();
       }
     else
       {
       vtkDebugMacro("Cannot read model file '" << fullName.c_str() << "' (extension = " << extension.c_str() << ")");
-      return 0;
+      return NULL;
       }
     }
   catch (...)
     {
-    result = 0;
+    return NULL;
     }
-
-  if (modelNode->GetPolyData() != NULL)
+  if (source)
     {
-    // is there an active scalar array?
-    if (modelNode->GetDisplayNode())
-      {
-      double *scalarRange =  modelNode->GetPolyData()->GetScalarRange();
-      if (scalarRange)
-        {
-        vtkDebugMacro("ReadDataInternal: setting scalar range " << scalarRange[0] << ", " << scalarRange[1]);
-        modelNode->GetDisplayNode()->SetScalarRange(scalarRange);
-        }
-      }
-    //modelNode->GetPolyData()->Modified();
+    source->Register(0);
     }
-  return result;
+  return source;
 }
 
 //----------------------------------------------------------------------------
@@ -17,6 +17,8 @@
 
 #include "vtkMRMLStorageNode.h"
 
+class vtkAlgorithm;
+
 /// \brief MRML node for model storage on disk.
 ///
 /// Storage nodes has methods to read/write vtkPolyData to/from disk.
@@ -39,6 +41,10 @@ public:
   /// Return true if the reference node can be read in
   virtual bool CanReadInReferenceNode(vtkMRMLNode *refNode);
 
+  /// Models are read without accessing the model node, they can be read
+  /// in parallel.
+  virtual bool CanReadInParallel() { return true; };
+
 protected:
   vtkMRMLModelStorageNode();
   ~vtkMRMLModelStorageNode();
@@ -54,6 +60,13 @@ protected:
   /// Read data and set it in the referenced node
   virtual int ReadDataInternal(vtkMRMLNode *refNode);
 
+  /// Read the model file into PreReadObject
+  virtual int PreReadDataInternal(vtkMRMLNode *refNode);
+
+  /// Read the model file and return the algorithm that outputs the polydata,
+  /// NULL on failure. The caller is responsible for deleting the algorithm.
+  vtkAlgorithm* ReadModel();
+
   /// Write data from a  referenced node
   virtual int WriteDataInternal(vtkMRMLNode *refNode);
 
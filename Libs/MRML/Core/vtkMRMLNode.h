@@ -329,7 +329,9 @@ public:
   vtkGetStringMacro(Description);
 
   /// Name of this node, to be set by the user
-  vtkSetStringMacro(Name);
+  ///
+  /// If the node is in a scene, the scene name index is updated.
+  virtual void SetName(const char* name);
   vtkGetStringMacro(Name);
 
 
@@ -17,13 +17,14 @@ Version:   $Revision: 1.2 $
 #include "vtkMRMLScalarVolumeDisplayNode.h"
 #include "vtkMRMLScene.h"
 #include "vtkMRMLProceduralColorNode.h"
+#include "vtkMRMLVolumeHistogram.h"
 #include "vtkMRMLVolumeNode.h"
 
 // VTK includes
 #include <vtkAlgorithmOutput.h>
 #include <vtkCallbackCommand.h>
 #include <vtkColorTransferFunction.h>
-#include <vtkImageAccumulate.h>
+#include <vtkIdTypeArray.h>
 #include <vtkImageAppendComponents.h>
 #include <vtkImageExtractComponents.h>
 #include <vtkImageBimodalAnalysis.h>
@@ -35,11 +36,13 @@ Version:   $Revision: 1.2 $
 #include <vtkImageThreshold.h>
 #include <vtkObjectFactory.h>
 #include <vtkLookupTable.h>
+#include <vtkNew.h>
 #include <vtkPointData.h>
 #include <vtkVersion.h>
 
 
 // STD includes
+#include <algorithm>
 #include <cassert>
 
 //----------------------------------------------------------------------------
@@ -105,8 +108,13 @@ vtkMRMLScalarVolumeDisplayNode::vtkMRMLScalarVolumeDisplayNode()
   this->AppendComponents->AddInputConnection(0, this->AlphaLogic->GetOutputPort() );
 
 
+  this->Histogram = NULL;
   this->Bimodal = NULL;
-  this->Accumulate = NULL;
+  this->BimodalHistogramTime = 0;
+  for (int i = 0; i < 4; ++i)
+    {
+    this->BimodalLevels[i] = 0.;
+    }
   this->IsInCalculateAutoLevels = false;
 
   vtkEventBroker::GetInstance()->AddObservation(
@@ -133,10 +141,10 @@ vtkMRMLScalarVolumeDisplayNode::~vtkMRMLScalarVolumeDisplayNode()
     this->Bimodal->Delete();
     this->Bimodal = NULL;
     }
-  if (this->Accumulate)
+  if (this->Histogram)
     {
-    this->Accumulate->Delete();
-    this->Accumulate = NULL;
+    this->Histogram->Delete();
+    this->Histogram = NULL;
     }
 }
 
@@ -701,6 +709,79 @@ void vtkMRMLScalarVolumeDisplayNode::GetDisplayScalarRange(double range[2])
     }
 }
 
+//---------------------------------------------------------------------------
+vtkMRMLVolumeHistogram* vtkMRMLScalarVolumeDisplayNode::GetScalarImageDataHistogram()
+{
+  vtkImageData* imageData = this->GetScalarImageData();
+  vtkMRMLVolumeNode* volumeNode = this->GetVolumeNode();
+  if (imageData && volumeNode && volumeNode->GetImageData() == imageData)
+    {
+    return volumeNode->GetHistogram();
+    }
+  // The display node is not in the scene (e.g. cloned by the slice logic) or
+  // displays a filtered image.
+  if (this->Histogram == NULL)
+    {
+    this->Histogram = vtkMRMLVolumeHistogram::New();
+    }
+  this->Histogram->SetImageData(imageData);
+  return this->Histogram;
+}
+
+//---------------------------------------------------------------------------
+bool vtkMRMLScalarVolumeDisplayNode
+::CalculateBimodalLevels(vtkMRMLVolumeHistogram* histogram, double levels[4])
+{
+  vtkIdTypeArray* counts = histogram->GetScalarHistogram();
+  const vtkIdType numberOfBins = counts->GetNumberOfTuples();
+  if (numberOfBins == 0)
+    {
+    return false;
+    }
+  if (counts->GetMTime() != this->BimodalHistogramTime)
+    {
+    const double binOrigin = histogram->GetScalarBinOrigin();
+    const double binWidth = histogram->GetScalarBinWidth();
+    // vtkImageBimodalAnalysis ignores the first bin, designed for the
+    // -32768 padding value of CT images: the first bin is left empty unless
+    // it contains that value.
+    const int firstBin = (binWidth == 1. && binOrigin == VTK_SHORT_MIN) ? 0 : 1;
+    vtkNew<vtkImageData> histogramImage;
+    histogramImage->SetExtent(0, static_cast<int>(numberOfBins) - 1 + firstBin, 0, 0, 0, 0);
+    histogramImage->AllocateScalars(VTK_INT, 1);
+    int* histogramPtr = static_cast<int*>(histogramImage->GetScalarPointer());
+    histogramPtr[0] = 0;
+    for (vtkIdType bin = 0; bin < numberOfBins; ++bin)
+      {
+      histogramPtr[bin + firstBin] = static_cast<int>(
+        std::min(counts->GetValue(bin), static_cast<vtkIdType>(VTK_INT_MAX)));
+      }
+    if (this->Bimodal == NULL)
+      {
+      this->Bimodal = vtkImageBimodalAnalysis::New();
+      }
+    this->Bimodal->SetInputData(histogramImage.GetPointer());
+    this->Bimodal->Update();
+    this->Bimodal->SetInputData(0);
+
+    // Convert the bin indices into scalar values
+    const double origin = binOrigin - firstBin * binWidth;
+    this->BimodalLevels[0] = this->Bimodal->GetWindow() * binWidth;
+    this->BimodalLevels[1] = origin + this->Bimodal->GetLevel() * binWidth;
+    this->BimodalLevels[2] = origin + this->Bimodal->GetThreshold() * binWidth;
+    this->BimodalLevels[3] = origin + this->Bimodal->GetMax() * binWidth + binWidth - 1.;
+    this->BimodalHistogramTime = counts->GetMTime();
+    }
+  // Workaround for image data where all accumulate samples fall
+  // within the same histogram bin
+  if (this->BimodalLevels[0] == 0.0 && this->BimodalLevels[1] == 0.0)
+    {
+    return false;
+    }
+  std::copy(this->BimodalLevels, this->BimodalLevels + 4, levels);
+  return true;
+}
+
 //---------------------------------------------------------------------------
 void vtkMRMLScalarVolumeDisplayNode::CalculateAutoLevels()
 {
@@ -760,27 +841,15 @@ void vtkMRMLScalarVolumeDisplayNode::CalculateAutoLevels()
     {
     // data type is VTK_INT or similar, so calculate window/level
     // check the scalar type, bimodal analysis only works on int
-    if (this->Bimodal == NULL)
+    double levels[4];
+    if (this->CalculateBimodalLevels(this->GetScalarImageDataHistogram(), levels))
       {
-      this->Bimodal = vtkImageBimodalAnalysis::New();
+      window = levels[0];
+      level = levels[1];
+      lower = levels[2];
+      upper = levels[3];
       }
-    if (this->Accumulate == NULL)
-      {
-      this->Accumulate = vtkImageAccumulate::New();
-      }
-
-    // Setup filter to work with signed 16-bit integer.
-    int extent[6] = {0, 65535, 0, 0, 0, 0};
-    this->Accumulate->SetComponentExtent(extent);
-    double origin[3] = {-32768, 0, 0};
-    this->Accumulate->SetComponentOrigin(origin);
-    this->Accumulate->SetInputData(imageDataScalar);
-    this->Bimodal->SetInputConnection(this->Accumulate->GetOutputPort());
-    this->Bimodal->Update();
-    // Workaround for image data where all accumulate samples fall
-    // within the same histogram bin
-    if ( this->Bimodal->GetWindow() == 0.0 &&
-         this->Bimodal->GetLevel() == 0.0 )
+    else
       {
       needAdHoc = 1;
       }
@@ -791,7 +860,14 @@ void vtkMRMLScalarVolumeDisplayNode::CalculateAutoLevels()
     vtkDebugMacro("CalculateScalarAutoLevels: image data scalar type is not integer,"
                   " doing ad hoc calc of window/level.");
     double range[2];
-    this->GetDisplayScalarRange(range);
+    // The histogram caches the exact range (it is computed from all the
+    // voxels even if the histogram is subsampled), multi-component images
+    // use the range of the display.
+    if (imageDataScalar->GetNumberOfScalarComponents() >= 3 ||
+        !this->GetScalarImageDataHistogram()->GetScalarRange(range))
+      {
+      this->GetDisplayScalarRange(range);
+      }
 
     double min = range[0];
     double max = range[1];
@@ -801,13 +877,6 @@ void vtkMRMLScalarVolumeDisplayNode::CalculateAutoLevels()
     lower = this->GetLevel();
     upper = range[1];
     }
-  else
-    {
-    window = this->Bimodal->GetWindow();
-    level = this->Bimodal->GetLevel();
-    lower = this->Bimodal->GetThreshold();
-    upper = this->Bimodal->GetMax();
-    }
 
   this->IsInCalculateAutoLevels = true;
   int disabledModify = this->StartModify();
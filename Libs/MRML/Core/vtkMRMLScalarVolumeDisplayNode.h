@@ -17,10 +17,10 @@
 
 // MRML includes
 #include "vtkMRMLVolumeDisplayNode.h"
+class vtkMRMLVolumeHistogram;
 
 // VTK includes
 class vtkImageAlgorithm;
-class vtkImageAccumulate;
 class vtkImageAppendComponents;
 class vtkImageBimodalAnalysis;
 class vtkImageCast;
@@ -191,6 +191,15 @@ protected:
   void UpdateLookupTable(vtkMRMLColorNode* newColorNode);
   void CalculateAutoLevels();
 
+  /// Return the histogram of the scalar image data. It is the histogram of
+  /// the volume node if the scalar image data is the volume image data.
+  vtkMRMLVolumeHistogram* GetScalarImageDataHistogram();
+  /// Run the bimodal analysis on the histogram and return the window, level,
+  /// lower threshold and upper threshold in \a levels.
+  /// The results are cached until the histogram is modified.
+  /// Return false if the histogram can't be analyzed.
+  bool CalculateBimodalLevels(vtkMRMLVolumeHistogram* histogram, double levels[4]);
+
   /// Return the image data with scalar type, it can be in the middle of the
   /// pipeline, it's typically the input of the threshold/windowlevel filters
   vtkImageData* GetScalarImageData();
@@ -235,9 +244,12 @@ protected:
   std::vector<WindowLevelPreset> WindowLevelPresets;
 
   ///
-  /// Used internally in CalculateScalarAutoLevels and CalculateStatisticsAutoLevels
-  vtkImageAccumulate *Accumulate;
+  /// Used internally in CalculateAutoLevels
+  vtkMRMLVolumeHistogram *Histogram;
   vtkImageBimodalAnalysis *Bimodal;
+  /// MTime of the histogram BimodalLevels have been computed from
+  unsigned long BimodalHistogramTime;
+  double BimodalLevels[4];
   bool IsInCalculateAutoLevels;
 };
 
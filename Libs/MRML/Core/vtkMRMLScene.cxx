@@ -48,6 +48,8 @@ Version:   $Revision: 1.18 $
 #include "vtkMRMLSliceCompositeNode.h"
 #include "vtkMRMLSliceNode.h"
 #include "vtkMRMLSnapshotClipNode.h"
+#include "vtkMRMLStorableNode.h"
+#include "vtkMRMLStorageNode.h"
 #include "vtkMRMLTableNode.h"
 #include "vtkMRMLTableStorageNode.h"
 #include "vtkMRMLTableViewNode.h"
@@ -59,6 +61,7 @@ Version:   $Revision: 1.18 $
 #include "vtkMRMLVectorVolumeDisplayNode.h"
 #include "vtkMRMLViewNode.h"
 #include "vtkMRMLVolumeArchetypeStorageNode.h"
+#include "vtkMRMLVolumeNode.h"
 #include "vtkURIHandler.h"
 #include "vtkMRMLLayoutNode.h"
 
@@ -78,10 +81,16 @@ Version:   $Revision: 1.18 $
 // VTK includes
 #include <vtkCallbackCommand.h>
 #include <vtkCollection.h>
+#include <vtkCriticalSection.h>
 #include <vtkDebugLeaks.h>
 #include <vtkErrorCode.h>
+#include <vtkImageData.h>
+#include <vtkMultiThreader.h>
+#include <vtkNew.h>
 #include <vtkObjectFactory.h>
+#include <vtkPolyData.h>
 #include <vtkSmartPointer.h>
+#include <vtkTimerLog.h>
 
 // VTKSYS includes
 #include <vtksys/RegularExpression.hxx>
@@ -90,13 +99,10 @@ Version:   $Revision: 1.18 $
 // STD includes
 #include <algorithm>
 #include <numeric>
+#include <sstream>
 
 //#define MRMLSCENE_VERBOSE
 
-#ifdef MRMLSCENE_VERBOSE
-# include <vtkTimerLog.h>
-#endif
-
 vtkCxxSetObjectMacro(vtkMRMLScene, CacheManager, vtkCacheManager)
 vtkCxxSetObjectMacro(vtkMRMLScene, DataIOManager, vtkDataIOManager)
 vtkCxxSetObjectMacro(vtkMRMLScene, UserTagTable, vtkTagTable)
@@ -106,6 +112,8 @@ vtkCxxSetObjectMacro(vtkMRMLScene, URIHandlerCollection, vtkCollection)
 vtkMRMLScene::vtkMRMLScene()
 {
   this->NodeIDsMTime = 0;
+  this->NodeIndexNextPosition = 0;
+  this->NodeIndicesMTime = 0;
   this->SceneModifiedTime = 0;
 
   this->RegisteredNodeClasses.clear();
@@ -114,8 +122,10 @@ vtkMRMLScene::vtkMRMLScene()
 
   this->Nodes =  vtkCollection::New();
   this->UndoStackSize = 100;
+  this->MaximumUndoMemorySize = 1024 * 1024;
   this->UndoFlag = false;
   this->InUndo = false;
+  this->InverseUndoLevel = 0;
 
   this->NodeReferences.clear();
   this->ReferencedIDChanges.clear();
@@ -132,6 +142,12 @@ vtkMRMLScene::vtkMRMLScene()
   this->SaveToXMLString = 0;
 
   this->ReadDataOnLoad = 1;
+  this->ParallelReadData = 0;
+  this->NumberOfReadDataThreads = 0;
+  this->ImportParseTime = 0.;
+  this->ImportReadTime = 0.;
+  this->ImportAddTime = 0.;
+  this->ImportUpdateTime = 0.;
 
   this->LastLoadedVersion = NULL;
   this->Version = NULL;
@@ -728,12 +744,12 @@ int vtkMRMLScene::Connect()
 //------------------------------------------------------------------------------
 int vtkMRMLScene::Import()
 {
-#ifdef MRMLSCENE_VERBOSE
-  vtkTimerLog* addNodesTimer = vtkTimerLog::New();
-  vtkTimerLog* updateSceneTimer = vtkTimerLog::New();
-  vtkTimerLog* timer = vtkTimerLog::New();
-  timer->StartTimer();
-#endif
+  this->ImportParseTime = 0.;
+  this->ImportReadTime = 0.;
+  this->ImportAddTime = 0.;
+  this->ImportUpdateTime = 0.;
+  double startTime = vtkTimerLog::GetUniversalTime();
+
   this->SetErrorCode(0);
   this->SetErrorMessage(std::string(""));
 
@@ -747,9 +763,21 @@ int vtkMRMLScene::Import()
   vtkSmartPointer<vtkCollection> loadedNodes = vtkSmartPointer<vtkCollection>::New();
 
   int parsingSuccess = this->LoadIntoScene(loadedNodes);
+  double endTime = vtkTimerLog::GetUniversalTime();
+  this->ImportParseTime = endTime - startTime;
 
   if (parsingSuccess)
     {
+    // Read the bulk data ahead in worker threads, it is set into the nodes
+    // when they are updated.
+    if (this->ParallelReadData)
+      {
+      startTime = endTime;
+      this->PreReadData(loadedNodes);
+      endTime = vtkTimerLog::GetUniversalTime();
+      this->ImportReadTime = endTime - startTime;
+      }
+
     /// In case the scene needs to change the ID of some nodes to add, the new
     /// ID should not be one already existing in the scene nor one of the
     /// imported scene.
@@ -762,9 +790,7 @@ int vtkMRMLScene::Import()
       {
       this->AddReservedID(node->GetID());
       }
-#ifdef MRMLSCENE_VERBOSE
-    addNodesTimer->StartTimer();
-#endif
+    startTime = endTime;
     // Loaded node is not always the same the one that is actually added:
     // in case of singleton nodes the existing singleton node is kept
     // and only the contents is overwritten.
@@ -774,10 +800,9 @@ int vtkMRMLScene::Import()
       {
       addedNodes->AddItem(this->AddNode(node));
       }
-#ifdef MRMLSCENE_VERBOSE
-    addNodesTimer->StopTimer();
-    updateSceneTimer->StartTimer();
-#endif
+    endTime = vtkTimerLog::GetUniversalTime();
+    this->ImportAddTime = endTime - startTime;
+    startTime = endTime;
     // Update the node references to the changed node IDs
     // (that conflicted in the current scene and the imported scene)
     this->UpdateNodeReferences(addedNodes);
@@ -811,9 +836,7 @@ int vtkMRMLScene::Import()
 
     this->Modified();
     this->RemoveUnusedNodeReferences();
-#ifdef MRMLSCENE_VERBOSE
-    updateSceneTimer->StopTimer();
-#endif
+    this->ImportUpdateTime = vtkTimerLog::GetUniversalTime() - startTime;
     }
   else
     {
@@ -824,14 +847,7 @@ int vtkMRMLScene::Import()
 
   this->SetUndoFlag(undoFlag);
 
-#ifdef MRMLSCENE_VERBOSE
-  vtkTimerLog* importingTimer = vtkTimerLog::New();
-  importingTimer->StartTimer();
-#endif
   this->EndState(vtkMRMLScene::ImportState);
-#ifdef MRMLSCENE_VERBOSE
-  importingTimer->StopTimer();
-#endif
 
   int returnCode = parsingSuccess; // nonzero = success
   if (this->GetErrorCode() != 0)
@@ -839,21 +855,136 @@ int vtkMRMLScene::Import()
     // error was reported, return with 0 (failure)
     returnCode = 0;
     }
-#ifdef MRMLSCENE_VERBOSE
-  timer->StopTimer();
-  std::cerr<<"vtkMRMLScene::Import()::AddNodes:" << addNodesTimer->GetElapsedTime() << "\n";
-  std::cerr<< "vtkMRMLScene::Import()::UpdateScene" << updateSceneTimer->GetElapsedTime() << "\n";
-  std::cerr<<"vtkMRMLScene::Import()::SceneImported:" << importingTimer->GetElapsedTime() << "\n";
-  std::cerr<<"vtkMRMLScene::Import():" << timer->GetElapsedTime() << "\n";
-  addNodesTimer->Delete();
-  updateSceneTimer->Delete();
-  importingTimer->Delete();
-  timer->Delete();
-#endif
+  vtkDebugMacro("Import: parse " << this->ImportParseTime
+                << "s, read " << this->ImportReadTime
+                << "s, add " << this->ImportAddTime
+                << "s, update " << this->ImportUpdateTime << "s");
   this->StoredTime.Modified();
   return returnCode;
 }
 
+namespace
+{
+
+//------------------------------------------------------------------------------
+struct ReadDataJob
+{
+  vtkMRMLStorableNode* Node;
+  std::vector<vtkMRMLStorageNode*> StorageNodes;
+};
+
+//------------------------------------------------------------------------------
+struct ReadDataThreadStruct
+{
+  std::vector<ReadDataJob> Jobs;
+  size_t NextJob;
+  vtkSimpleCriticalSection Lock;
+};
+
+//------------------------------------------------------------------------------
+// Each thread reads the data of the next node not read yet until all the
+// nodes are read.
+VTK_THREAD_RETURN_TYPE ReadDataThreadedExecute(void* arg)
+{
+  vtkMultiThreader::ThreadInfo* info = static_cast<vtkMultiThreader::ThreadInfo*>(arg);
+  ReadDataThreadStruct* str = static_cast<ReadDataThreadStruct*>(info->UserData);
+  while (true)
+    {
+    str->Lock.Lock();
+    size_t jobIndex = str->NextJob++;
+    str->Lock.Unlock();
+    if (jobIndex >= str->Jobs.size())
+      {
+      break;
+      }
+    const ReadDataJob& job = str->Jobs[jobIndex];
+    for (size_t i = 0; i < job.StorageNodes.size(); ++i)
+      {
+      job.StorageNodes[i]->PreReadData(job.Node);
+      }
+    }
+  return VTK_THREAD_RETURN_VALUE;
+}
+
+}
+
+//------------------------------------------------------------------------------
+void vtkMRMLScene::PreReadData(vtkCollection* loadedNodes)
+{
+  if (!this->ReadDataOnLoad)
+    {
+    return;
+    }
+  std::map<std::string, vtkMRMLStorageNode*> storageNodes;
+  vtkMRMLNode* node = NULL;
+  vtkCollectionSimpleIterator it;
+  for (loadedNodes->InitTraversal(it);
+       (node = vtkMRMLNode::SafeDownCast(loadedNodes->GetNextItemAsObject(it))) ;)
+    {
+    vtkMRMLStorageNode* storageNode = vtkMRMLStorageNode::SafeDownCast(node);
+    if (storageNode && storageNode->GetID())
+      {
+      storageNodes[storageNode->GetID()] = storageNode;
+      }
+    }
+
+  // Only local files of the storage nodes that can read in parallel are read
+  // ahead, the other files are read by the storage nodes when the nodes are
+  // updated. A storage node shared by multiple nodes is read only once in
+  // parallel.
+  ReadDataThreadStruct str;
+  str.NextJob = 0;
+  std::set<vtkMRMLStorageNode*> usedStorageNodes;
+  for (loadedNodes->InitTraversal(it);
+       (node = vtkMRMLNode::SafeDownCast(loadedNodes->GetNextItemAsObject(it))) ;)
+    {
+    vtkMRMLStorableNode* storableNode = vtkMRMLStorableNode::SafeDownCast(node);
+    if (!storableNode || !storableNode->GetAddToScene() ||
+        storableNode->GetSingletonTag())
+      {
+      continue;
+      }
+    ReadDataJob job;
+    job.Node = storableNode;
+    for (int i = 0; i < storableNode->GetNumberOfStorageNodes(); ++i)
+      {
+      const char* storageNodeID = storableNode->GetNthStorageNodeID(i);
+      std::map<std::string, vtkMRMLStorageNode*>::iterator storageNodeIt =
+        storageNodeID ? storageNodes.find(storageNodeID) : storageNodes.end();
+      if (storageNodeIt == storageNodes.end())
+        {
+        continue;
+        }
+      vtkMRMLStorageNode* storageNode = storageNodeIt->second;
+      if (storageNode->CanReadInParallel() &&
+          storageNode->GetFileName() &&
+          (!storageNode->GetURI() || strcmp(storageNode->GetURI(), "") == 0) &&
+          usedStorageNodes.insert(storageNode).second)
+        {
+        job.StorageNodes.push_back(storageNode);
+        }
+      }
+    if (!job.StorageNodes.empty())
+      {
+      str.Jobs.push_back(job);
+      }
+    }
+  if (str.Jobs.empty())
+    {
+    return;
+    }
+
+  int numberOfThreads = this->NumberOfReadDataThreads > 0 ?
+    this->NumberOfReadDataThreads : vtkMultiThreader::GetGlobalDefaultNumberOfThreads();
+  numberOfThreads = std::max(1, std::min(numberOfThreads, static_cast<int>(str.Jobs.size())));
+  vtkDebugMacro("PreReadData: reading " << str.Jobs.size() << " nodes with "
+                << numberOfThreads << " threads");
+  vtkNew<vtkMultiThreader> threader;
+  threader->SetNumberOfThreads(numberOfThreads);
+  threader->SetSingleMethod(ReadDataThreadedExecute, &str);
+  threader->SingleMethodExecute();
+}
+
 //------------------------------------------------------------------------------
 int vtkMRMLScene::LoadIntoScene(vtkCollection* nodeCollection)
 {
@@ -1179,10 +1310,13 @@ vtkMRMLNode*  vtkMRMLScene::AddNodeNoNotify(vtkMRMLNode *n)
     n->SetName(this->GenerateUniqueName(n).c_str());
     }
   n->SetScene( this );
+  this->UpdateNodeIndices();
   this->Nodes->vtkCollection::AddItem((vtkObject *)n);
 
   // cache the node so the whole scene cache stays up-todate
   this->AddNodeID(n);
+  this->AddNodeToIndices(n);
+  this->RecordNodeAdditionForUndo(n);
 
   //n->OnNodeAddedToScene();
 
@@ -1312,10 +1446,13 @@ void vtkMRMLScene::RemoveNode(vtkMRMLNode *n)
     {
     n->SetScene(0);
     }
+  this->UpdateNodeIndices();
   this->Nodes->vtkCollection::RemoveItem((vtkObject *)n);
 
   std::string nid=n->GetID();
   this->RemoveNodeID(n->GetID());
+  this->RemoveNodeFromIndices(n);
+  this->RecordNodeRemovalForUndo(n);
 
   this->InvokeEvent(vtkMRMLScene::NodeRemovedEvent, n);
 
@@ -1491,18 +1628,7 @@ int vtkMRMLScene::GetNumberOfNodesByClass(const char *className)
     vtkErrorMacro("GetNumberOfNodesByClass: class name is null.");
     return 0;
     }
-  int num=0;
-  vtkMRMLNode *node;
-  vtkCollectionSimpleIterator it;
-  for (this->Nodes->InitTraversal(it);
-       (node = (vtkMRMLNode*)this->Nodes->GetNextItemAsObject(it)) ;)
-    {
-    if (node->IsA(className))
-      {
-      num++;
-      }
-    }
-  return num;
+  return static_cast<int>(this->GetNodeClassIndex(className).size());
 }
 
 //------------------------------------------------------------------------------
@@ -1513,15 +1639,11 @@ int vtkMRMLScene::GetNodesByClass(const char *className, std::vector<vtkMRMLNode
     vtkErrorMacro("GetNodesByClass: class name is null.");
     return 0;
     }
-  vtkMRMLNode *node;
-  vtkCollectionSimpleIterator it;
-  for (this->Nodes->InitTraversal(it);
-       (node = (vtkMRMLNode*)this->Nodes->GetNextItemAsObject(it)) ;)
+  NodeIndexType& classIndex = this->GetNodeClassIndex(className);
+  nodes.reserve(nodes.size() + classIndex.size());
+  for (NodeIndexType::iterator it = classIndex.begin(); it != classIndex.end(); ++it)
     {
-    if (node->IsA(className))
-      {
-      nodes.push_back(node);
-      }
+    nodes.push_back(it->second);
     }
   return static_cast<int>(nodes.size());
 }
@@ -1535,15 +1657,10 @@ vtkCollection* vtkMRMLScene::GetNodesByClass(const char *className)
     return 0;
     }
   vtkCollection* nodes = vtkCollection::New();
-  vtkMRMLNode *node;
-  vtkCollectionSimpleIterator it;
-  for (this->Nodes->InitTraversal(it);
-       (node = (vtkMRMLNode*)this->Nodes->GetNextItemAsObject(it)) ;)
+  NodeIndexType& classIndex = this->GetNodeClassIndex(className);
+  for (NodeIndexType::iterator it = classIndex.begin(); it != classIndex.end(); ++it)
     {
-    if (node->IsA(className))
-      {
-      nodes->AddItem(node);
-      }
+    nodes->AddItem(it->second);
     }
   return nodes;
 }
@@ -1603,13 +1720,11 @@ vtkMRMLNode* vtkMRMLScene::GetSingletonNode(const char* singletonTag, const char
     return NULL;
     }
 
-  vtkCollectionSimpleIterator it;
-  vtkMRMLNode* node = NULL;
-  for (this->Nodes->InitTraversal(it);
-       (node = (vtkMRMLNode*)this->Nodes->GetNextItemAsObject(it)) ;)
+  NodeIndexType& classIndex = this->GetNodeClassIndex(className);
+  for (NodeIndexType::iterator it = classIndex.begin(); it != classIndex.end(); ++it)
     {
-    if (node->IsA(className) &&
-        node->GetSingletonTag() != NULL &&
+    vtkMRMLNode* node = it->second;
+    if (node->GetSingletonTag() != NULL &&
         strcmp(node->GetSingletonTag(), singletonTag) == 0)
       {
       return node;
@@ -1679,22 +1794,14 @@ vtkMRMLNode* vtkMRMLScene::GetNthNodeByClass(int n, const char *className)
     return NULL;
     }
 
-  int num=0;
-  vtkMRMLNode *node;
-  vtkCollectionSimpleIterator it;
-  for (this->Nodes->InitTraversal(it);
-       (node = (vtkMRMLNode*)this->Nodes->GetNextItemAsObject(it)) ;)
+  NodeIndexType& classIndex = this->GetNodeClassIndex(className);
+  if (n >= static_cast<int>(classIndex.size()))
     {
-    if (node->IsA(className))
-      {
-      if (num == n)
-        {
-        return node;
-        }
-      num++;
-      }
+    return NULL;
     }
-  return NULL;
+  NodeIndexType::iterator it = classIndex.begin();
+  std::advance(it, n);
+  return it->second;
 }
 
 //------------------------------------------------------------------------------
@@ -1708,15 +1815,15 @@ vtkCollection* vtkMRMLScene::GetNodesByName(const char* name)
     return nodes;
     }
 
-  vtkMRMLNode *node;
-  vtkCollectionSimpleIterator it;
-  for (this->Nodes->InitTraversal(it);
-       (node = (vtkMRMLNode*)this->Nodes->GetNextItemAsObject(it)) ;)
+  this->UpdateNodeIndices();
+  std::map< std::string, NodeIndexType >::iterator nameIt = this->NodeNameIndices.find(name);
+  if (nameIt == this->NodeNameIndices.end())
     {
-    if (!strcmp(node->GetName(), name))
-      {
-      nodes->AddItem(node);
-      }
+    return nodes;
+    }
+  for (NodeIndexType::iterator it = nameIt->second.begin(); it != nameIt->second.end(); ++it)
+    {
+    nodes->AddItem(it->second);
     }
   return nodes;
 }
@@ -1727,19 +1834,38 @@ vtkMRMLNode* vtkMRMLScene::GetFirstNode(const char* byName,
                                         const int* byHideFromEditors,
                                         bool exactNameMatch)
 {
-  vtkCollectionSimpleIterator it;
-  vtkMRMLNode* node;
-  for (this->Nodes->InitTraversal(it);
-       (node= vtkMRMLNode::SafeDownCast(
-          this->Nodes->GetNextItemAsObject(it))) ;)
+  this->UpdateNodeIndices();
+  // Only visit the nodes that can match: the nodes with the exact name or
+  // the nodes of the requested class.
+  NodeIndexType* candidates = 0;
+  if (exactNameMatch && byName)
     {
-    if (exactNameMatch && byName &&
-        node->GetName() != 0 && strcmp(node->GetName(), byName) != 0)
+    std::map< std::string, NodeIndexType >::iterator nameIt = this->NodeNameIndices.find(byName);
+    if (nameIt == this->NodeNameIndices.end())
       {
-      continue;
+      return 0;
       }
+    candidates = &nameIt->second;
+    }
+  else if (byClass)
+    {
+    candidates = &this->GetNodeClassIndex(byClass);
+    }
+  else
+    {
+    candidates = &this->GetNodeClassIndex("vtkMRMLNode");
+    }
+  // Compile the regular expression only once
+  vtksys::RegularExpression nameRegExp;
+  if (!exactNameMatch && byName)
+    {
+    nameRegExp.compile(byName);
+    }
+  for (NodeIndexType::iterator it = candidates->begin(); it != candidates->end(); ++it)
+    {
+    vtkMRMLNode* node = it->second;
     if (!exactNameMatch && byName &&
-        node->GetName() != 0 && !vtksys::RegularExpression(byName).find(node->GetName()))
+        node->GetName() != 0 && !nameRegExp.find(node->GetName()))
       {
       continue;
       }
@@ -1766,16 +1892,13 @@ vtkMRMLNode* vtkMRMLScene::GetFirstNodeByName(const char* name)
     return node;
     }
 
-  vtkCollectionSimpleIterator it;
-  for (this->Nodes->InitTraversal(it);
-       (node = (vtkMRMLNode*)this->Nodes->GetNextItemAsObject(it)) ;)
+  this->UpdateNodeIndices();
+  std::map< std::string, NodeIndexType >::iterator nameIt = this->NodeNameIndices.find(name);
+  if (nameIt == this->NodeNameIndices.end() || nameIt->second.empty())
     {
-    if (node->GetName() != 0 && !strcmp(node->GetName(), name))
-      {
-      return node;
-      }
+    return 0;
     }
-  return 0;
+  return nameIt->second.begin()->second;
 }
 
 //------------------------------------------------------------------------------
@@ -1835,13 +1958,17 @@ vtkCollection* vtkMRMLScene::GetNodesByClassByName(const char* className, const
     return nodes;
     }
 
-  vtkMRMLNode *node;
-  for (int n=0; n < this->Nodes->GetNumberOfItems(); n++)
+  this->UpdateNodeIndices();
+  std::map< std::string, NodeIndexType >::iterator nameIt = this->NodeNameIndices.find(name);
+  if (nameIt == this->NodeNameIndices.end())
     {
-    node = (vtkMRMLNode*)this->Nodes->GetItemAsObject(n);
-    if (!strcmp(node->GetName(), name) && node->IsA(className))
+    return nodes;
+    }
+  for (NodeIndexType::iterator it = nameIt->second.begin(); it != nameIt->second.end(); ++it)
+    {
+    if (it->second->IsA(className))
       {
-      nodes->AddItem(node);
+      nodes->AddItem(it->second);
       }
     }
 
@@ -1921,6 +2048,7 @@ vtkMRMLNode* vtkMRMLScene::InsertAfterNode(vtkMRMLNode *item, vtkMRMLNode *n)
     }
   // cache the node so the whole scene cache stays up-todate
   this->AddNodeID(n);
+  this->RecordNodeAdditionForUndo(n);
 
   n->SetDisableModifiedEvent(modifyStatus);
 
@@ -2006,6 +2134,7 @@ vtkMRMLNode* vtkMRMLScene::InsertBeforeNode(vtkMRMLNode *item, vtkMRMLNode *n)
     }
   // cache the node so the whole scene cache stays up-todate
   this->AddNodeID(n);
+  this->RecordNodeAdditionForUndo(n);
 
   n->SetDisableModifiedEvent(modifyStatus);
 
@@ -2026,6 +2155,12 @@ void vtkMRMLScene::PrintSelf(ostream& os, vtkIndent indent)
   os << indent << "ErrorCode = " << this->ErrorCode << "\n";
   os << indent << "URL = " << this->GetURL() << "\n";
   os << indent << "Root Directory = " << this->GetRootDirectory() << "\n";
+  os << indent << "ParallelReadData = " << this->ParallelReadData << "\n";
+  os << indent << "NumberOfReadDataThreads = " << this->NumberOfReadDataThreads << "\n";
+  os << indent << "ImportParseTime = " << this->ImportParseTime << "\n";
+  os << indent << "ImportReadTime = " << this->ImportReadTime << "\n";
+  os << indent << "ImportAddTime = " << this->ImportAddTime << "\n";
+  os << indent << "ImportUpdateTime = " << this->ImportUpdateTime << "\n";
 
   this->Nodes->vtkCollection::PrintSelf(os,indent);
   std::list<std::string> classes = this->GetNodeClassesList();
@@ -2257,6 +2392,115 @@ void vtkMRMLScene::RemoveReservedIDs()
   this->ReservedIDs.clear();
 }
 
+namespace
+{
+
+//------------------------------------------------------------------------------
+// Return the bulk data that copies of the node share with the node
+vtkDataObject* GetNodeBulkData(vtkMRMLNode* node)
+{
+  vtkMRMLVolumeNode* volumeNode = vtkMRMLVolumeNode::SafeDownCast(node);
+  if (volumeNode)
+    {
+    return volumeNode->GetImageData();
+    }
+  vtkMRMLModelNode* modelNode = vtkMRMLModelNode::SafeDownCast(node);
+  if (modelNode)
+    {
+    return modelNode->GetPolyData();
+    }
+  return 0;
+}
+
+//------------------------------------------------------------------------------
+// Estimated size in kilobytes of the node without its bulk data
+double EstimateNodeMemorySize(vtkMRMLNode* node)
+{
+  std::stringstream ss;
+  node->WriteXML(ss, 0);
+  return static_cast<double>(ss.str().size()) / 1024.;
+}
+
+//------------------------------------------------------------------------------
+bool IsNodeModifiedSince(vtkMRMLNode* node, unsigned long mtime)
+{
+  // Modifications are not reflected in the MTime until EndModify() is called
+  return node->GetMTime() > mtime || node->GetModifiedEventPending() > 0;
+}
+
+}
+
+//------------------------------------------------------------------------------
+// An undo step records the nodes added and removed since the step was saved
+// and copies of the nodes saved with SaveStateForUndo().
+struct vtkMRMLScene::UndoLevel
+{
+  struct NodeState
+  {
+    /// Node in the scene (or removed from the scene)
+    vtkSmartPointer<vtkMRMLNode> Node;
+    /// Copy of the node when the state was saved
+    vtkSmartPointer<vtkMRMLNode> Copy;
+    /// MTime of the node when the copy was made
+    unsigned long MTime;
+    /// True if the copy is owned by the previous step
+    bool Shared;
+  };
+
+  UndoLevel()
+    : NodeMemorySize(0.)
+    , DataMemorySize(0.)
+  {
+  }
+
+  /// Return the saved state of the node or NULL if it is not saved
+  NodeState* GetNodeState(vtkMRMLNode* node)
+  {
+    std::map<vtkMRMLNode*, size_t>::iterator it = this->NodeStateIndices.find(node);
+    return it != this->NodeStateIndices.end() ? &this->NodeStates[it->second] : 0;
+  }
+
+  /// Save a copy of the node unless it is already saved. If the node has
+  /// not been modified since it was saved in \a previousLevel, the copy of
+  /// the previous step is shared.
+  void SaveNode(vtkMRMLNode* node, UndoLevel* previousLevel)
+  {
+    if (this->GetNodeState(node))
+      {
+      return;
+      }
+    NodeState state;
+    state.Node = node;
+    NodeState* previousState = previousLevel ? previousLevel->GetNodeState(node) : 0;
+    if (previousState && !IsNodeModifiedSince(node, previousState->MTime))
+      {
+      state.Copy = previousState->Copy;
+      state.MTime = previousState->MTime;
+      state.Shared = true;
+      }
+    else
+      {
+      state.MTime = node->GetMTime();
+      state.Copy.TakeReference(node->CreateNodeInstance());
+      state.Copy->CopyWithScene(node);
+      state.Shared = false;
+      this->NodeMemorySize += EstimateNodeMemorySize(state.Copy);
+      }
+    this->NodeStateIndices[node] = this->NodeStates.size();
+    this->NodeStates.push_back(state);
+  }
+
+  std::vector<NodeState> NodeStates;
+  std::map<vtkMRMLNode*, size_t> NodeStateIndices;
+  /// Nodes added and removed since the step was saved, in chronological order
+  std::vector<vtkSmartPointer<vtkMRMLNode> > AddedNodes;
+  std::vector<vtkSmartPointer<vtkMRMLNode> > RemovedNodes;
+  /// Estimated size in kilobytes of the copies owned by the step
+  double NodeMemorySize;
+  /// Estimated size in kilobytes of the bulk data only kept by the copies
+  double DataMemorySize;
+};
+
 //------------------------------------------------------------------------------
 // Pushes the current scene onto the undo stack, and makes a backup copy of the
 // passed node so that changes to the node are undoable; several signatures to handle
@@ -2377,64 +2621,40 @@ void vtkMRMLScene::SaveStateForUndo ()
 }
 
 //------------------------------------------------------------------------------
-// Make a new collection that has pointers to all the nodes in the current scene
+// Start a new undo step: the nodes added or removed from now on are recorded
+// in it
 void vtkMRMLScene::PushIntoUndoStack()
 {
-  if (this->Nodes == NULL)
-    {
-    return;
-    }
-
-  vtkCollection* newScene = vtkCollection::New();
-
-  vtkCollection* currentScene = this->Nodes;
-
-  int nnodes = currentScene->GetNumberOfItems();
-
-  for (int n=0; n<nnodes; n++)
+  if (!this->UndoStack.empty())
     {
-    vtkMRMLNode *node  = dynamic_cast < vtkMRMLNode *>(currentScene->GetItemAsObject(n));
-    if (node && !node->IsA("vtkMRMLSceneViewNode"))
+    // The nodes may have been given new bulk data since the previous step
+    // was saved, the copies of the step keep the old data alive.
+    UndoLevel* previousLevel = this->UndoStack.back();
+    previousLevel->DataMemorySize = 0.;
+    std::vector<UndoLevel::NodeState>::iterator it;
+    for (it = previousLevel->NodeStates.begin(); it != previousLevel->NodeStates.end(); ++it)
       {
-      newScene->AddItem(node);
+      vtkDataObject* data = GetNodeBulkData(it->Copy);
+      if (!it->Shared && data && data != GetNodeBulkData(it->Node))
+        {
+        previousLevel->DataMemorySize += data->GetActualMemorySize();
+        }
       }
     }
-
-  //TODO check max stack size
-  this->UndoStack.push_back(newScene);
+  this->UndoStack.push_back(new UndoLevel);
+  this->TrimUndoStack();
 }
 
 //------------------------------------------------------------------------------
-// Make a new collection that has pointers to the current scene nodes
+// Start a new redo step
 void vtkMRMLScene::PushIntoRedoStack()
 {
-  if (this->Nodes == NULL)
-    {
-    return;
-    }
-
-  vtkCollection* newScene = vtkCollection::New();
-
-  vtkCollection* currentScene = this->Nodes;
-
-  int nnodes = currentScene->GetNumberOfItems();
-
-  for (int n=0; n<nnodes; n++)
-    {
-    vtkMRMLNode *node  = dynamic_cast < vtkMRMLNode *>(currentScene->GetItemAsObject(n));
-    if (node && !node->IsA("vtkMRMLSceneViewNode"))
-      {
-      newScene->AddItem(node);
-      }
-    }
-
-  //TODO check max stack size
-  this->RedoStack.push_back(newScene);
+  this->RedoStack.push_back(new UndoLevel);
 }
 
 //------------------------------------------------------------------------------
-// Put a replacement node into the undoable copy of the scene so that the node
-// can be edited
+// Save a copy of the node in the current undo step so that the node
+// can be restored
 void vtkMRMLScene::CopyNodeInUndoStack(vtkMRMLNode *copyNode)
 {
   if (!copyNode)
@@ -2442,28 +2662,21 @@ void vtkMRMLScene::CopyNodeInUndoStack(vtkMRMLNode *copyNode)
     vtkErrorMacro("CopyNodeInUndoStack: node is null");
     return;
     }
-
-  vtkMRMLNode *snode = copyNode->CreateNodeInstance();
-  if (snode != NULL)
+  if (this->UndoStack.empty())
     {
-    snode->CopyWithScene(copyNode);
+    return;
     }
-  vtkCollection* undoScene = dynamic_cast < vtkCollection *>( this->UndoStack.back() );
-  int nnodes = undoScene->GetNumberOfItems();
-  for (int n=0; n<nnodes; n++)
+  // The copy is shared with the previous step if the node hasn't changed
+  UndoLevel* previousLevel = 0;
+  if (this->UndoStack.size() > 1)
     {
-    vtkMRMLNode *node  = dynamic_cast < vtkMRMLNode *>(undoScene->GetItemAsObject(n));
-    if (node == copyNode)
-      {
-      undoScene->ReplaceItem (n, snode);
-      break;
-      }
+    previousLevel = *(++this->UndoStack.rbegin());
     }
-  snode->Delete();
+  this->UndoStack.back()->SaveNode(copyNode, previousLevel);
 }
 
 //------------------------------------------------------------------------------
-// Put a replacement node into the redoable copy of the scene so that the node
+// Save a copy of the node in the current redo step so that the node
 // can be replaced by the Undo version
 void vtkMRMLScene::CopyNodeInRedoStack(vtkMRMLNode *copyNode)
 {
@@ -2472,150 +2685,81 @@ void vtkMRMLScene::CopyNodeInRedoStack(vtkMRMLNode *copyNode)
     vtkErrorMacro("CopyNodeInRedoStack: node is null");
     return;
     }
-  vtkMRMLNode *snode = copyNode->CreateNodeInstance();
-  if (snode != NULL)
-    {
-    snode->CopyWithSceneWithSingleModifiedEvent(copyNode);
-    }
-  vtkCollection* undoScene = dynamic_cast < vtkCollection *>( this->RedoStack.back() );
-  int nnodes = undoScene->GetNumberOfItems();
-  for (int n=0; n<nnodes; n++)
+  if (this->RedoStack.empty())
     {
-    vtkMRMLNode *node  = dynamic_cast < vtkMRMLNode *>(undoScene->GetItemAsObject(n));
-    if (node == copyNode)
-      {
-      undoScene->ReplaceItem (n, snode);
-      break;
-      }
+    return;
     }
-  snode->Delete();
+  this->RedoStack.back()->SaveNode(copyNode, 0);
 }
 
 //------------------------------------------------------------------------------
-// Replace the current scene by the top of the undo stack
-// -- move the current scene on the redo stack
-void vtkMRMLScene::Undo()
+void vtkMRMLScene::RestoreUndoLevel(UndoLevel* level, UndoLevel* inverseLevel)
 {
-  if (!this->UndoFlag)
-    {
-    return;
-    }
-
-  if (this->UndoStack.size() == 0)
-    {
-    return;
-    }
-
-  this->RemoveUnusedNodeReferences();
-
-  this->InUndo = true;
-
-  int nnodes;
-  int n;
-  unsigned int nn;
-
-  PushIntoRedoStack();
+  this->InverseUndoLevel = inverseLevel;
 
-  vtkCollection* currentScene = this->Nodes;
-  // We use 2 vectors instead of a map in order to keep the ordering of the
-  // nodes.
-  std::vector<std::string> currentIDs;
-  std::vector<vtkMRMLNode*> currentNodes;
-  nnodes = currentScene->GetNumberOfItems();
-  for (n=0; n<nnodes; n++)
+  // copy back the nodes that changed since the step was saved,
+  // but before create a copy in the inverse step from current
+  std::vector<UndoLevel::NodeState>::iterator stateIt;
+  for (stateIt = level->NodeStates.begin(); stateIt != level->NodeStates.end(); ++stateIt)
     {
-    vtkMRMLNode *node  = dynamic_cast < vtkMRMLNode *>(currentScene->GetItemAsObject(n));
-    if (node && !node->IsA("vtkMRMLSceneViewNode"))
+    if (!IsNodeModifiedSince(stateIt->Node, stateIt->MTime))
       {
-      currentIDs.push_back(node->GetID());
-      currentNodes.push_back(node);
+      continue;
       }
+    inverseLevel->SaveNode(stateIt->Node, 0);
+    stateIt->Node->CopyWithSceneWithSingleModifiedEvent(stateIt->Copy);
     }
 
-  vtkCollection* undoScene = NULL;
-  std::vector<std::string> undoIDs;
-  std::vector<vtkMRMLNode*> undoNodes;
-
-  if (!this->UndoStack.empty())
+  // add back the nodes removed since the step was saved
+  std::vector<vtkSmartPointer<vtkMRMLNode> >::reverse_iterator nodeIt;
+  for (nodeIt = level->RemovedNodes.rbegin(); nodeIt != level->RemovedNodes.rend(); ++nodeIt)
     {
-    undoScene = dynamic_cast < vtkCollection *>( this->UndoStack.back() );
-    nnodes = undoScene->GetNumberOfItems();
-    for (n=0; n<nnodes; n++)
-      {
-      vtkMRMLNode *node  = dynamic_cast < vtkMRMLNode *>(undoScene->GetItemAsObject(n));
-      if (node && !node->IsA("vtkMRMLSceneViewNode"))
-        {
-        undoIDs.push_back(node->GetID());
-        undoNodes.push_back(node);
-        }
-      }
+    this->AddNode(*nodeIt);
     }
 
-  std::vector<std::string>::iterator iterID;
-  std::vector<vtkMRMLNode*>::iterator iterNode;
-  std::vector<std::string>::iterator curIterID;
-  std::vector<vtkMRMLNode*>::iterator curIterNode;
-
-  // copy back changes and add deleted nodes to the current scene
-  std::vector<vtkMRMLNode*> addNodes;
-
-  for(iterID=undoIDs.begin(), iterNode = undoNodes.begin(); iterID != undoIDs.end(); iterID++, iterNode++)
+  // remove the nodes added since the step was saved
+  for (nodeIt = level->AddedNodes.rbegin(); nodeIt != level->AddedNodes.rend(); ++nodeIt)
     {
-    curIterID = std::find(currentIDs.begin(), currentIDs.end(), *iterID);
-    curIterNode = currentNodes.begin() + std::distance(currentIDs.begin(), curIterID);
-    if ( curIterID == currentIDs.end() )
-      {
-      // the node was deleted, add Node back to the curreent scene
-      addNodes.push_back(*iterNode);
-      }
-    else if (*iterNode != *curIterNode)
+    vtkMRMLNode* nodeToRemove = *nodeIt;
+    // Maybe the node has been removed already by a side effect of a previous
+    // node removal.
+    if (nodeToRemove->GetID() &&
+        this->GetNodeByID(nodeToRemove->GetID()) == nodeToRemove)
       {
-      // nodes differ, copy from undo to current scene
-      // but before create a copy in redo stack from current
-      this->CopyNodeInRedoStack(*curIterNode);
-      (*curIterNode)->CopyWithSceneWithSingleModifiedEvent(*iterNode);
+      this->RemoveNode(nodeToRemove);
       }
     }
 
-  // remove new nodes created before Undo
-  std::vector<vtkMRMLNode*> removeNodes;
-  for(curIterID=currentIDs.begin(), curIterNode = currentNodes.begin(); curIterID != currentIDs.end(); curIterID++, curIterNode++)
-    {
-    iterID = std::find(undoIDs.begin(),undoIDs.end(), *curIterID);
-    // Remove only if the node is not present in the previous state.
-    if ( iterID == undoIDs.end() )
-      {
-      removeNodes.push_back(*curIterNode);
-      }
-    }
+  this->InverseUndoLevel = 0;
+}
 
-  for (nn=0; nn<addNodes.size(); nn++)
-    {
-    this->AddNode(addNodes[nn]);
-    }
-  for (nn=0; nn<removeNodes.size(); nn++)
+//------------------------------------------------------------------------------
+// Revert the changes recorded in the top of the undo stack
+// -- the inverse changes are recorded on the redo stack
+void vtkMRMLScene::Undo()
+{
+  if (!this->UndoFlag)
     {
-    vtkMRMLNode* nodeToRemove = removeNodes[nn];
-    // Maybe the node has been removed already by a side effect of a previous
-    // node removal.
-    if (this->IsNodePresent(nodeToRemove))
-      {
-      this->RemoveNode(nodeToRemove);
-      }
+    return;
     }
 
-  if (undoScene)
+  if (this->UndoStack.size() == 0)
     {
-    undoScene->RemoveAllItems();
-    undoScene->Delete();
+    return;
     }
 
   this->RemoveUnusedNodeReferences();
 
-  if (!this->UndoStack.empty())
-   {
-   UndoStack.pop_back();
-   }
+  this->InUndo = true;
+
+  UndoLevel* undoLevel = this->UndoStack.back();
+  this->UndoStack.pop_back();
+  this->PushIntoRedoStack();
+  this->RestoreUndoLevel(undoLevel, this->RedoStack.back());
+  delete undoLevel;
+
+  this->RemoveUnusedNodeReferences();
+
   this->Modified();
 
   this->InUndo = false;
@@ -2634,124 +2778,140 @@ void vtkMRMLScene::Redo()
     return;
     }
 
-  int nnodes;
-  int n;
-  unsigned int nn;
-
   this->RemoveUnusedNodeReferences();
 
-  PushIntoUndoStack();
+  this->InUndo = true;
 
-  vtkCollection* currentScene = this->Nodes;
-  //std::hash_map<std::string, vtkMRMLNode*> currentMap;
-  std::map<std::string, vtkMRMLNode*> currentMap;
-  nnodes = currentScene->GetNumberOfItems();
-  for (n=0; n<nnodes; n++)
-    {
-    vtkMRMLNode *node  = dynamic_cast < vtkMRMLNode *>(currentScene->GetItemAsObject(n));
-    if (node && !node->IsA("vtkMRMLSceneViewNode"))
-      {
-      currentMap[node->GetID()] = node;
-      }
-    }
+  UndoLevel* redoLevel = this->RedoStack.back();
+  this->RedoStack.pop_back();
+  this->PushIntoUndoStack();
+  this->RestoreUndoLevel(redoLevel, this->UndoStack.back());
+  delete redoLevel;
 
-  //std::hash_map<std::string, vtkMRMLNode*> undoMap;
-  std::map<std::string, vtkMRMLNode*> undoMap;
+  this->Modified();
 
-  vtkCollection* undoScene = NULL;
+  this->InUndo = false;
+}
 
-  if (!this->RedoStack.empty())
+//------------------------------------------------------------------------------
+void vtkMRMLScene::ClearUndoStack()
+{
+  std::list< UndoLevel* >::iterator iter;
+  for(iter=this->UndoStack.begin(); iter != this->UndoStack.end(); iter++)
     {
-    undoScene = dynamic_cast < vtkCollection *>( this->RedoStack.back() );;
-    nnodes = undoScene->GetNumberOfItems();
-    for (n=0; n<nnodes; n++)
-      {
-      vtkMRMLNode *node  = dynamic_cast < vtkMRMLNode *>(undoScene->GetItemAsObject(n));
-      if (node && !node->IsA("vtkMRMLSceneViewNode"))
-        {
-        undoMap[node->GetID()] = node;
-        }
-      }
+    delete *iter;
     }
+  this->UndoStack.clear();
+}
 
-  //std::hash_map<std::string, vtkMRMLNode*>::iterator iter;
-  //std::hash_map<std::string, vtkMRMLNode*>::iterator curIter;
-  std::map<std::string, vtkMRMLNode*>::iterator iter;
-  std::map<std::string, vtkMRMLNode*>::iterator curIter;
-
-  // copy back changes and add deleted nodes to the current scene
-  std::vector<vtkMRMLNode*> addNodes;
-
-  for(iter=undoMap.begin(); iter != undoMap.end(); iter++)
+//------------------------------------------------------------------------------
+void vtkMRMLScene::ClearRedoStack()
+{
+  std::list< UndoLevel* >::iterator iter;
+  for(iter=this->RedoStack.begin(); iter != this->RedoStack.end(); iter++)
     {
-    curIter = currentMap.find(iter->first);
-    if ( curIter == currentMap.end() )
-      {
-      // the node was deleted, add Node back to the curreent scene
-      addNodes.push_back(iter->second);
-      }
-    else if (iter->second != curIter->second)
-      {
-      // nodes differ, copy from redo to current scene
-      // but before create a copy in undo stack from current
-      this->CopyNodeInUndoStack(curIter->second);
-      curIter->second->CopyWithSceneWithSingleModifiedEvent(iter->second);
-      }
+    delete *iter;
     }
+  this->RedoStack.clear();
+}
 
-  // remove new nodes created before Undo
-  std::vector<vtkMRMLNode*> removeNodes;
-  for(curIter=currentMap.begin(); curIter != currentMap.end(); curIter++)
+//------------------------------------------------------------------------------
+void vtkMRMLScene::TrimUndoStack()
+{
+  while (this->UndoStack.size() > 1 &&
+         (static_cast<int>(this->UndoStack.size()) > this->UndoStackSize ||
+          (this->MaximumUndoMemorySize > 0 &&
+           this->GetUndoMemorySize() > this->MaximumUndoMemorySize)))
     {
-    iter = undoMap.find(curIter->first);
-    if ( iter == undoMap.end() )
+    UndoLevel* oldestLevel = this->UndoStack.front();
+    this->UndoStack.pop_front();
+    // The copies shared with the discarded step are now owned by the next one
+    UndoLevel* nextLevel = this->UndoStack.front();
+    std::vector<UndoLevel::NodeState>::iterator it;
+    for (it = nextLevel->NodeStates.begin(); it != nextLevel->NodeStates.end(); ++it)
       {
-      removeNodes.push_back(curIter->second);
+      if (it->Shared)
+        {
+        it->Shared = false;
+        nextLevel->NodeMemorySize += EstimateNodeMemorySize(it->Copy);
+        }
       }
+    delete oldestLevel;
     }
+}
 
-  for (nn=0; nn<addNodes.size(); nn++)
+//------------------------------------------------------------------------------
+unsigned long vtkMRMLScene::GetUndoMemorySize()
+{
+  double memorySize = 0.;
+  std::list< UndoLevel* >::iterator iter;
+  for (iter = this->UndoStack.begin(); iter != this->UndoStack.end(); ++iter)
     {
-    this->AddNode(addNodes[nn]);
+    memorySize += (*iter)->NodeMemorySize + (*iter)->DataMemorySize;
     }
-  for (nn=0; nn<removeNodes.size(); nn++)
+  for (iter = this->RedoStack.begin(); iter != this->RedoStack.end(); ++iter)
     {
-    this->RemoveNode(removeNodes[nn]);
+    memorySize += (*iter)->NodeMemorySize + (*iter)->DataMemorySize;
     }
+  return static_cast<unsigned long>(memorySize);
+}
 
-  if (undoScene)
+//------------------------------------------------------------------------------
+vtkMRMLScene::UndoLevel* vtkMRMLScene::GetRecordingUndoLevel()
+{
+  if (!this->UndoFlag)
     {
-    undoScene->RemoveAllItems();
-    undoScene->Delete();
+    return 0;
     }
-
-  RedoStack.pop_back();
-
-  this->Modified();
+  if (this->InUndo)
+    {
+    return this->InverseUndoLevel;
+    }
+  return this->UndoStack.empty() ? 0 : this->UndoStack.back();
 }
 
 //------------------------------------------------------------------------------
-void vtkMRMLScene::ClearUndoStack()
+void vtkMRMLScene::RecordNodeAdditionForUndo(vtkMRMLNode *node)
 {
-  std::list< vtkCollection* >::iterator iter;
-  for(iter=this->UndoStack.begin(); iter != this->UndoStack.end(); iter++)
+  UndoLevel* level = this->GetRecordingUndoLevel();
+  if (!level || node->IsA("vtkMRMLSceneViewNode"))
     {
-    (*iter)->RemoveAllItems();
-    (*iter)->Delete();
+    return;
     }
-  this->UndoStack.clear();
+  std::vector<vtkSmartPointer<vtkMRMLNode> >::iterator it = level->RemovedNodes.begin();
+  while (it != level->RemovedNodes.end() && it->GetPointer() != node)
+    {
+    ++it;
+    }
+  if (it != level->RemovedNodes.end())
+    {
+    // the node is added back, nothing to undo
+    level->RemovedNodes.erase(it);
+    return;
+    }
+  level->AddedNodes.push_back(node);
 }
 
 //------------------------------------------------------------------------------
-void vtkMRMLScene::ClearRedoStack()
+void vtkMRMLScene::RecordNodeRemovalForUndo(vtkMRMLNode *node)
 {
-  std::list< vtkCollection* >::iterator iter;
-  for(iter=this->RedoStack.begin(); iter != this->RedoStack.end(); iter++)
+  UndoLevel* level = this->GetRecordingUndoLevel();
+  if (!level || node->IsA("vtkMRMLSceneViewNode"))
     {
-    (*iter)->RemoveAllItems();
-    (*iter)->Delete();
+    return;
     }
-  this->RedoStack.clear();
+  std::vector<vtkSmartPointer<vtkMRMLNode> >::iterator it = level->AddedNodes.begin();
+  while (it != level->AddedNodes.end() && it->GetPointer() != node)
+    {
+    ++it;
+    }
+  if (it != level->AddedNodes.end())
+    {
+    // the node had been added since the step was saved, nothing to undo
+    level->AddedNodes.erase(it);
+    return;
+    }
+  level->RemovedNodes.push_back(node);
 }
 
 //------------------------------------------------------------------------------
@@ -3076,6 +3236,161 @@ void vtkMRMLScene::ClearNodeIDs()
   }
 }
 
+//-----------------------------------------------------------------------------
+void vtkMRMLScene::UpdateNodeIndices()
+{
+  if (this->Nodes->GetMTime() <= this->NodeIndicesMTime)
+    {
+    return;
+    }
+#ifdef MRMLSCENE_VERBOSE
+  std::cerr << "Recompute node class and name indices..." << std::endl;
+#endif
+  this->ClearNodeIndices();
+  vtkMRMLNode *node;
+  vtkCollectionSimpleIterator it;
+  for (this->Nodes->InitTraversal(it);
+       (node = (vtkMRMLNode*)this->Nodes->GetNextItemAsObject(it)) ;)
+    {
+    this->AddNodeToIndices(node);
+    }
+  this->NodeIndicesMTime = this->Nodes->GetMTime();
+}
+
+//-----------------------------------------------------------------------------
+void vtkMRMLScene::AddNodeToIndices(vtkMRMLNode *node)
+{
+  if (!node)
+    {
+    return;
+    }
+  this->NodeIndicesMTime = this->Nodes->GetMTime();
+  if (this->NodeIndexPositions.find(node) != this->NodeIndexPositions.end())
+    {
+    // The same node is added twice in the collection, only the first
+    // occurrence is indexed.
+    return;
+    }
+  unsigned long position = this->NodeIndexNextPosition++;
+  this->NodeIndexPositions[node] = position;
+  if (node->GetName())
+    {
+    this->NodeNameIndices[node->GetName()][position] = node;
+    }
+  for (std::map< std::string, NodeIndexType >::iterator classIt = this->NodeClassIndices.begin();
+       classIt != this->NodeClassIndices.end(); ++classIt)
+    {
+    if (node->IsA(classIt->first.c_str()))
+      {
+      classIt->second[position] = node;
+      }
+    }
+}
+
+//-----------------------------------------------------------------------------
+void vtkMRMLScene::RemoveNodeFromIndices(vtkMRMLNode *node)
+{
+  this->NodeIndicesMTime = this->Nodes->GetMTime();
+  std::map< vtkMRMLNode*, unsigned long >::iterator positionIt =
+    this->NodeIndexPositions.find(node);
+  if (positionIt == this->NodeIndexPositions.end())
+    {
+    return;
+    }
+  unsigned long position = positionIt->second;
+  this->NodeIndexPositions.erase(positionIt);
+  if (node->GetName())
+    {
+    std::map< std::string, NodeIndexType >::iterator nameIt = this->NodeNameIndices.find(node->GetName());
+    if (nameIt != this->NodeNameIndices.end())
+      {
+      nameIt->second.erase(position);
+      if (nameIt->second.empty())
+        {
+        this->NodeNameIndices.erase(nameIt);
+        }
+      }
+    }
+  for (std::map< std::string, NodeIndexType >::iterator classIt = this->NodeClassIndices.begin();
+       classIt != this->NodeClassIndices.end(); ++classIt)
+    {
+    classIt->second.erase(position);
+    }
+}
+
+//-----------------------------------------------------------------------------
+void vtkMRMLScene::ClearNodeIndices()
+{
+  this->NodeIndexPositions.clear();
+  this->NodeIndexNextPosition = 0;
+  this->NodeNameIndices.clear();
+  // Class indices are lazily recreated by GetNodeClassIndex()
+  this->NodeClassIndices.clear();
+  if (this->Nodes)
+    {
+    this->NodeIndicesMTime = this->Nodes->GetMTime();
+    }
+}
+
+//-----------------------------------------------------------------------------
+vtkMRMLScene::NodeIndexType& vtkMRMLScene::GetNodeClassIndex(const char* className)
+{
+  this->UpdateNodeIndices();
+  std::map< std::string, NodeIndexType >::iterator classIt =
+    this->NodeClassIndices.find(className);
+  if (classIt != this->NodeClassIndices.end())
+    {
+    return classIt->second;
+    }
+  // First request for this class, index the nodes that are already in the
+  // scene. The index is then maintained by AddNodeToIndices() and
+  // RemoveNodeFromIndices().
+  NodeIndexType& classIndex = this->NodeClassIndices[className];
+  for (std::map< vtkMRMLNode*, unsigned long >::iterator positionIt = this->NodeIndexPositions.begin();
+       positionIt != this->NodeIndexPositions.end(); ++positionIt)
+    {
+    if (positionIt->first->IsA(className))
+      {
+      classIndex[positionIt->second] = positionIt->first;
+      }
+    }
+  return classIndex;
+}
+
+//-----------------------------------------------------------------------------
+void vtkMRMLScene::NodeNameChanged(vtkMRMLNode* node, const char* oldName)
+{
+  if (!this->Nodes || this->Nodes->GetMTime() > this->NodeIndicesMTime)
+    {
+    // Indices are out-of-date, they will be fully rebuilt on next access.
+    return;
+    }
+  std::map< vtkMRMLNode*, unsigned long >::iterator positionIt =
+    this->NodeIndexPositions.find(node);
+  if (positionIt == this->NodeIndexPositions.end())
+    {
+    // The node is not in the scene (e.g. copy of a node in the undo stack)
+    return;
+    }
+  unsigned long position = positionIt->second;
+  if (oldName)
+    {
+    std::map< std::string, NodeIndexType >::iterator nameIt = this->NodeNameIndices.find(oldName);
+    if (nameIt != this->NodeNameIndices.end())
+      {
+      nameIt->second.erase(position);
+      if (nameIt->second.empty())
+        {
+        this->NodeNameIndices.erase(nameIt);
+        }
+      }
+    }
+  if (node->GetName())
+    {
+    this->NodeNameIndices[node->GetName()][position] = node;
+    }
+}
+
 //------------------------------------------------------------------------------
 void vtkMRMLScene::AddURIHandler(vtkURIHandler *handler)
 {
@@ -59,6 +59,10 @@ class VTK_MRML_EXPORT vtkMRMLScene : public vtkObject
   /// but that's the only class that is allowed to do so
   friend class vtkMRMLSceneViewNode;
 
+  /// make the vtkMRMLNode a friend so that SetName() can keep the
+  /// node name index up-to-date by calling NodeNameChanged()
+  friend class vtkMRMLNode;
+
 public:
   static vtkMRMLScene *New();
   vtkTypeMacro(vtkMRMLScene, vtkObject);
@@ -291,7 +295,31 @@ public:
   /// returns number of redo steps in the history buffer
   int GetNumberOfRedoLevels() { return (int)this->RedoStack.size();};
 
+  /// Maximum number of undo steps in the history buffer. The oldest steps
+  /// are discarded when a new state is saved. 100 by default.
+  vtkSetMacro(UndoStackSize, int);
+  vtkGetMacro(UndoStackSize, int);
+
+  /// Maximum memory in kilobytes used by the undo steps, 0 for no limit.
+  /// The oldest steps are discarded when a new state is saved and the
+  /// estimated memory exceeds the limit, the most recent step is always
+  /// kept. 1GB by default.
+  /// \sa GetUndoMemorySize()
+  vtkSetMacro(MaximumUndoMemorySize, unsigned long);
+  vtkGetMacro(MaximumUndoMemorySize, unsigned long);
+
+  /// Estimated memory in kilobytes used by the undo steps.
+  /// It includes the node copies and the bulk data (images, polydata)
+  /// that the copies keep alive after the nodes have been given new data.
+  unsigned long GetUndoMemorySize();
+
   /// Save current state in the undo buffer
+  ///
+  /// The history buffer only stores the nodes that are saved and the
+  /// nodes that are added or removed after the state is saved. The copy of
+  /// a node is shared with the previous undo step if the node has not been
+  /// modified since, bulk data is shared with the nodes. Undo() and Redo()
+  /// only restore the nodes that have been modified.
   void SaveStateForUndo();
 
   /// Save current state of the node in the undo buffer
@@ -405,6 +433,40 @@ public:
   vtkSetMacro(ReadDataOnLoad,int);
   vtkGetMacro(ReadDataOnLoad,int);
 
+  /// \brief This property controls whether Import() reads the data files of
+  /// the imported nodes in parallel.
+  ///
+  /// If true, the local files of the storage nodes that can read in parallel
+  /// (e.g. models and volumes) are read by worker threads once the scene file
+  /// is parsed. The workers don't access the nodes nor the scene: the data
+  /// read ahead is set into the nodes when they are added and updated in the
+  /// calling thread in the order of the scene file. The other files and
+  /// the remote files (URI) are read in the calling thread as usual.
+  /// False by default.
+  /// \sa SetNumberOfReadDataThreads(), vtkMRMLStorageNode::PreReadData(),
+  /// vtkMRMLStorageNode::CanReadInParallel()
+  vtkSetMacro(ParallelReadData,int);
+  vtkGetMacro(ParallelReadData,int);
+  vtkBooleanMacro(ParallelReadData,int);
+
+  /// Number of threads used by Import() when ParallelReadData is true.
+  /// If 0 (default), vtkMultiThreader::GetGlobalDefaultNumberOfThreads()
+  /// threads are used.
+  vtkSetMacro(NumberOfReadDataThreads,int);
+  vtkGetMacro(NumberOfReadDataThreads,int);
+
+  /// \brief Time in seconds spent in the steps of the last Import().
+  ///
+  /// - parse: parsing of the scene file and creation of the nodes
+  /// - read: parallel reading of the data, 0 if ParallelReadData is false
+  /// - add: addition of the nodes into the scene
+  /// - update: update of the node references and of the nodes, including
+  /// the reading of the data not read in parallel.
+  vtkGetMacro(ImportParseTime,double);
+  vtkGetMacro(ImportReadTime,double);
+  vtkGetMacro(ImportAddTime,double);
+  vtkGetMacro(ImportUpdateTime,double);
+
   void SetErrorMessage(const std::string &error);
   std::string GetErrorMessage();
 
@@ -647,6 +709,27 @@ protected:
   void CopyNodeInUndoStack(vtkMRMLNode *node);
   void CopyNodeInRedoStack(vtkMRMLNode *node);
 
+  /// State of the scene saved for undo or redo
+  struct UndoLevel;
+
+  /// Revert the changes recorded in \a level. The inverse changes are
+  /// recorded in \a inverseLevel.
+  void RestoreUndoLevel(UndoLevel* level, UndoLevel* inverseLevel);
+
+  /// Discard the oldest undo steps exceeding UndoStackSize or
+  /// MaximumUndoMemorySize.
+  void TrimUndoStack();
+
+  /// Read the data of the storable nodes parsed by Import() in parallel.
+  /// \sa SetParallelReadData(), vtkMRMLStorageNode::PreReadData()
+  void PreReadData(vtkCollection* loadedNodes);
+
+  /// Record the nodes added to or removed from the scene since the last
+  /// saved state so that they can be removed or added back by Undo().
+  void RecordNodeAdditionForUndo(vtkMRMLNode *node);
+  void RecordNodeRemovalForUndo(vtkMRMLNode *node);
+  UndoLevel* GetRecordingUndoLevel();
+
   /// Add a node to the scene without invoking a vtkMRMLScene::NodeAddedEvent event.
   ///
   /// \warning Use with extreme caution as it might unsynchronize observer.
@@ -689,6 +772,39 @@ protected:
   /// Clear NodeIDs map used to speedup GetByID() method.
   void ClearNodeIDs();
 
+  /// Nodes of a class or name index, sorted by their position in the
+  /// \a Nodes collection.
+  typedef std::map< unsigned long, vtkMRMLNode* > NodeIndexType;
+
+  /// \brief Synchronize the class and name indices used to speedup
+  /// GetNodesByClass(), GetNodesByName() and similar methods with the
+  /// \a Nodes collection.
+  ///
+  /// The indices are rebuilt only if the collection was modified without
+  /// going through AddNodeNoNotify() or RemoveNode() (e.g. InsertAfterNode()).
+  void UpdateNodeIndices();
+
+  /// Add node to the class and name indices. UpdateNodeIndices() must be
+  /// called before the node is added into the \a Nodes collection.
+  void AddNodeToIndices(vtkMRMLNode *node);
+
+  /// Remove node from the class and name indices. UpdateNodeIndices() must
+  /// be called before the node is removed from the \a Nodes collection.
+  void RemoveNodeFromIndices(vtkMRMLNode *node);
+
+  /// Clear the class and name indices.
+  void ClearNodeIndices();
+
+  /// \brief Return the index of all the nodes that are of class
+  /// \a className or of a subclass of \a className.
+  ///
+  /// The index of a class is created the first time it is requested and is
+  /// then incrementally updated when nodes are added or removed.
+  NodeIndexType& GetNodeClassIndex(const char* className);
+
+  /// Called by vtkMRMLNode::SetName() to move the node in the name index.
+  void NodeNameChanged(vtkMRMLNode* node, const char* oldName);
+
   /// Get a NodeReferences iterator for a node reference.
   NodeReferencesType::iterator FindNodeReference(const char* referencedId, vtkMRMLNode* referencingNode);
 
@@ -704,11 +820,14 @@ protected:
   std::vector<unsigned long> States;
 
   int  UndoStackSize;
+  unsigned long MaximumUndoMemorySize;
   bool UndoFlag;
   bool InUndo;
 
-  std::list< vtkCollection* >  UndoStack;
-  std::list< vtkCollection* >  RedoStack;
+  std::list< UndoLevel* >  UndoStack;
+  std::list< UndoLevel* >  RedoStack;
+  /// Level recording the changes made by Undo() or Redo()
+  UndoLevel* InverseUndoLevel;
 
   std::string                 URL;
   std::string                 RootDirectory;
@@ -724,6 +843,16 @@ protected:
   std::map< std::string, std::string > ReferencedIDChanges;
   std::map< std::string, vtkSmartPointer<vtkMRMLNode> > NodeIDs;
 
+  /// Position of the nodes in the \a Nodes collection. Positions are
+  /// increasing but not contiguous.
+  std::map< vtkMRMLNode*, unsigned long > NodeIndexPositions;
+  unsigned long NodeIndexNextPosition;
+  /// Requested class names and the nodes that are of that class.
+  std::map< std::string, NodeIndexType > NodeClassIndices;
+  /// Node names and the nodes with that name.
+  std::map< std::string, NodeIndexType > NodeNameIndices;
+  unsigned long NodeIndicesMTime;
+
   // Stores default nodes. If a class is created or reset (using CreateNodeByClass or Clear) and
   // a default node is defined for it then the content of the default node will be used to initialize
   // the class. It is useful for overriding default values that are set in a node's constructor.
@@ -738,6 +867,13 @@ protected:
   int SaveToXMLString;
 
   int ReadDataOnLoad;
+  int ParallelReadData;
+  int NumberOfReadDataThreads;
+
+  double ImportParseTime;
+  double ImportReadTime;
+  double ImportAddTime;
+  double ImportUpdateTime;
 
   unsigned long NodeIDsMTime;
 
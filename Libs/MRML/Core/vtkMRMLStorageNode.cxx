@@ -1059,6 +1059,20 @@ int vtkMRMLStorageNode::ReadData(vtkMRMLNode* refNode, bool temporary)
     return 0;
     }
 
+  if (this->PreReadNode.GetPointer() == refNode &&
+      this->PreReadObject.GetPointer() == NULL)
+    {
+    // PreReadData() failed to read the file and reported the error
+    this->PreReadNode = 0;
+    return 0;
+    }
+  if (this->PreReadNode.GetPointer() != refNode)
+    {
+    // the data read ahead is not for this node
+    this->PreReadObject = 0;
+    }
+  this->PreReadNode = 0;
+
   this->StageReadData(refNode);
   if ( this->GetReadState() != this->TransferDone )
     {
@@ -1070,6 +1084,7 @@ int vtkMRMLStorageNode::ReadData(vtkMRMLNode* refNode, bool temporary)
     <<  "URI = " << (this->GetURI() == NULL ? "null" : this->GetURI()) << ", "
     << "filename = " << (this->GetFileName() == NULL ? "null" : this->GetFileName()));
   int res = this->ReadDataInternal(refNode);
+  this->PreReadObject = 0;
   if (res)
     {
     vtkMRMLStorableNode* storableNode = vtkMRMLStorableNode::SafeDownCast(refNode);
@@ -1086,6 +1101,40 @@ int vtkMRMLStorageNode::ReadData(vtkMRMLNode* refNode, bool temporary)
   return res;
 }
 
+//------------------------------------------------------------------------------
+int vtkMRMLStorageNode::PreReadData(vtkMRMLNode* refNode)
+{
+  this->PreReadNode = 0;
+  this->PreReadObject = 0;
+  if (refNode == NULL ||
+      !this->CanReadInParallel() ||
+      !this->CanReadInReferenceNode(refNode) ||
+      !refNode->GetAddToScene())
+    {
+    return 0;
+    }
+  if (this->GetFileName() == NULL ||
+      (this->GetURI() != NULL && strcmp(this->GetURI(), "") != 0))
+    {
+    // remote files are staged by ReadData()
+    return 0;
+    }
+  this->PreReadNode = refNode;
+  if (!this->PreReadDataInternal(refNode))
+    {
+    // the next ReadData() fails without reading the file again
+    this->PreReadObject = 0;
+    return 0;
+    }
+  return 1;
+}
+
+//------------------------------------------------------------------------------
+int vtkMRMLStorageNode::PreReadDataInternal(vtkMRMLNode* vtkNotUsed(refNode))
+{
+  return 0;
+}
+
 //------------------------------------------------------------------------------
 int vtkMRMLStorageNode::WriteData(vtkMRMLNode* refNode)
 {
@@ -20,6 +20,8 @@
 class vtkURIHandler;
 
 // VTK includes
+#include <vtkSmartPointer.h>
+#include <vtkWeakPointer.h>
 class vtkStringArray;
 
 // STD includes
@@ -51,6 +53,26 @@ public:
   /// \sa SetFileName(), ReadDataInternal(), GetStoredTime()
   virtual int ReadData(vtkMRMLNode *refNode, bool temporaryFile = false);
 
+  ///
+  /// Read the file \a FileName ahead of ReadData(\a refNode).
+  /// It is used by vtkMRMLScene::Import() to read the data in worker threads.
+  /// The data is kept by the storage node, neither \a refNode nor the scene
+  /// are modified and no event is invoked: the next call of ReadData() with \a refNode
+  /// sets the data read ahead into \a refNode instead of reading the file
+  /// again.
+  /// Return 1 if the data was read ahead, 0 otherwise (e.g. the storage node
+  /// can't read in parallel or the file is remote). If the file can't be
+  /// read, the next call of ReadData() with \a refNode returns 0.
+  /// \sa ReadData(), CanReadInParallel(), vtkMRMLScene::SetParallelReadData()
+  int PreReadData(vtkMRMLNode *refNode);
+
+  ///
+  /// Return true if PreReadData() can be called from a worker thread, false
+  /// by default. Subclasses reimplementing PreReadDataInternal() must read
+  /// into objects that nothing else references.
+  /// \sa PreReadData()
+  virtual bool CanReadInParallel() { return false; };
+
   ///
   /// Write data from a  referenced node
   /// Return 1 on success, 0 on failure.
@@ -286,6 +308,14 @@ protected:
   /// To be reimplemented in subclass.
   virtual int ReadDataInternal(vtkMRMLNode* refNode);
 
+  /// Reads the file into PreReadObject without modifying any node, called by
+  /// PreReadData() in a worker thread. ReadDataInternal() then uses
+  /// PreReadObject instead of reading the file.
+  /// Returns 1 on success, 0 otherwise.
+  /// Returns 0 by default (read ahead not supported).
+  /// \sa CanReadInParallel()
+  virtual int PreReadDataInternal(vtkMRMLNode* refNode);
+
   /// Does the actual writing. Returns 1 on success, 0 otherwise.
   /// Returns 0 by default (write not supported).
   /// To be reimplemented in subclass.
@@ -335,6 +365,11 @@ protected:
   /// Can be reset with InvalidateFile.
   /// \sa InvalidateFile
   vtkTimeStamp* StoredTime;
+
+  /// Node whose file has been read ahead by PreReadData() and data read.
+  /// The data is released by ReadData().
+  vtkWeakPointer<vtkMRMLNode> PreReadNode;
+  vtkSmartPointer<vtkObject> PreReadObject;
 };
 
 #endif
@@ -37,6 +37,7 @@
 #include <vtkSmartPointer.h>
 
 // STD includes
+#include <algorithm>
 #include <sstream>
 #include <set>
 
@@ -44,6 +45,37 @@
 const std::string vtkMRMLSubjectHierarchyNode::SUBJECTHIERARCHY_UID_ITEM_SEPARATOR = std::string(":");
 const std::string vtkMRMLSubjectHierarchyNode::SUBJECTHIERARCHY_UID_NAME_VALUE_SEPARATOR = std::string("; ");
 
+std::map<vtkMRMLScene*, vtkMRMLSubjectHierarchyNode::SubjectHierarchyNodesIndexType>
+  vtkMRMLSubjectHierarchyNode::SceneSubjectHierarchyNodesByAssociatedNodeID;
+std::map<vtkMRMLScene*, std::map<std::string, vtkMRMLSubjectHierarchyNode::SubjectHierarchyNodesIndexType> >
+  vtkMRMLSubjectHierarchyNode::SceneSubjectHierarchyNodesByUID;
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+void RemoveIndexedNode(std::map<std::string, std::vector<vtkMRMLSubjectHierarchyNode*> >& index,
+                       const std::string& key, vtkMRMLSubjectHierarchyNode* node)
+{
+  std::map<std::string, std::vector<vtkMRMLSubjectHierarchyNode*> >::iterator indexIt = index.find(key);
+  if (indexIt == index.end())
+    {
+    return;
+    }
+  std::vector<vtkMRMLSubjectHierarchyNode*>::iterator nodeIt =
+    std::find(indexIt->second.begin(), indexIt->second.end(), node);
+  if (nodeIt != indexIt->second.end())
+    {
+    indexIt->second.erase(nodeIt);
+    }
+  if (indexIt->second.empty())
+    {
+    index.erase(indexIt);
+    }
+}
+
+}
+
 //----------------------------------------------------------------------------
 //----------------------------------------------------------------------------
 vtkMRMLNodeNewMacro(vtkMRMLSubjectHierarchyNode);
@@ -53,6 +85,7 @@ vtkMRMLSubjectHierarchyNode::vtkMRMLSubjectHierarchyNode()
   : Level(NULL)
   , OwnerPluginName(NULL)
   , OwnerPluginAutoSearch(true)
+  , IndexedScene(NULL)
 {
   this->HideFromEditorsOn(); 
 
@@ -64,6 +97,7 @@ vtkMRMLSubjectHierarchyNode::vtkMRMLSubjectHierarchyNode()
 //----------------------------------------------------------------------------
 vtkMRMLSubjectHierarchyNode::~vtkMRMLSubjectHierarchyNode()
 {
+  this->RemoveFromIndex();
   this->UIDs.clear();
 
   this->SetLevel(0);
@@ -156,6 +190,8 @@ void vtkMRMLSubjectHierarchyNode::ReadXMLAttributes( const char** atts)
         }
       }
     }
+  // UIDs may have been removed
+  this->UpdateIndex();
 
   this->EndModify(disabledModify);
 }
@@ -198,10 +234,129 @@ void vtkMRMLSubjectHierarchyNode::Copy(vtkMRMLNode *anode)
   this->SetOwnerPluginAutoSearch(node->GetOwnerPluginAutoSearch());
 
   this->UIDs = node->GetUIDs();
+  // the associated node ID is copied without SetAssociatedNodeID()
+  this->UpdateIndex();
 
   this->EndModify(disabledModify);
 }
 
+//----------------------------------------------------------------------------
+void vtkMRMLSubjectHierarchyNode::SetScene(vtkMRMLScene* scene)
+{
+  this->Superclass::SetScene(scene);
+  this->UpdateIndex();
+}
+
+//----------------------------------------------------------------------------
+void vtkMRMLSubjectHierarchyNode::SetAssociatedNodeID(const char* ref)
+{
+  this->Superclass::SetAssociatedNodeID(ref);
+  this->UpdateIndex();
+}
+
+//----------------------------------------------------------------------------
+void vtkMRMLSubjectHierarchyNode::UpdateIndex()
+{
+  std::string associatedNodeID(this->GetAssociatedNodeID() ? this->GetAssociatedNodeID() : "");
+  if (this->IndexedScene == this->Scene &&
+      this->IndexedAssociatedNodeID == associatedNodeID &&
+      this->IndexedUIDs == this->UIDs)
+    {
+    return;
+    }
+  this->RemoveFromIndex();
+  if (!this->Scene)
+    {
+    return;
+    }
+
+  this->IndexedScene = this->Scene;
+  this->IndexedAssociatedNodeID = associatedNodeID;
+  this->IndexedUIDs = this->UIDs;
+  if (!associatedNodeID.empty())
+    {
+    SceneSubjectHierarchyNodesByAssociatedNodeID[this->Scene][associatedNodeID].push_back(this);
+    }
+  if (!this->UIDs.empty())
+    {
+    std::map<std::string, SubjectHierarchyNodesIndexType>& uidIndex =
+      SceneSubjectHierarchyNodesByUID[this->Scene];
+    for (std::map<std::string, std::string>::iterator uidsIt = this->UIDs.begin(); uidsIt != this->UIDs.end(); ++uidsIt)
+      {
+      uidIndex[uidsIt->first][uidsIt->second].push_back(this);
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+void vtkMRMLSubjectHierarchyNode::RemoveFromIndex()
+{
+  if (!this->IndexedScene)
+    {
+    return;
+    }
+
+  std::map<vtkMRMLScene*, SubjectHierarchyNodesIndexType>::iterator associatedIt =
+    SceneSubjectHierarchyNodesByAssociatedNodeID.find(this->IndexedScene);
+  if (associatedIt != SceneSubjectHierarchyNodesByAssociatedNodeID.end())
+    {
+    RemoveIndexedNode(associatedIt->second, this->IndexedAssociatedNodeID, this);
+    if (associatedIt->second.empty())
+      {
+      SceneSubjectHierarchyNodesByAssociatedNodeID.erase(associatedIt);
+      }
+    }
+
+  std::map<vtkMRMLScene*, std::map<std::string, SubjectHierarchyNodesIndexType> >::iterator uidSceneIt =
+    SceneSubjectHierarchyNodesByUID.find(this->IndexedScene);
+  if (uidSceneIt != SceneSubjectHierarchyNodesByUID.end())
+    {
+    for (std::map<std::string, std::string>::iterator uidsIt = this->IndexedUIDs.begin(); uidsIt != this->IndexedUIDs.end(); ++uidsIt)
+      {
+      std::map<std::string, SubjectHierarchyNodesIndexType>::iterator uidNameIt = uidSceneIt->second.find(uidsIt->first);
+      if (uidNameIt == uidSceneIt->second.end())
+        {
+        continue;
+        }
+      RemoveIndexedNode(uidNameIt->second, uidsIt->second, this);
+      if (uidNameIt->second.empty())
+        {
+        uidSceneIt->second.erase(uidNameIt);
+        }
+      }
+    if (uidSceneIt->second.empty())
+      {
+      SceneSubjectHierarchyNodesByUID.erase(uidSceneIt);
+      }
+    }
+
+  this->IndexedScene = NULL;
+  this->IndexedAssociatedNodeID.clear();
+  this->IndexedUIDs.clear();
+}
+
+//----------------------------------------------------------------------------
+vtkMRMLSubjectHierarchyNode* vtkMRMLSubjectHierarchyNode::FindIndexedNode(vtkMRMLScene* scene,
+  SubjectHierarchyNodesIndexType& index, const std::string& key)
+{
+  SubjectHierarchyNodesIndexType::iterator indexIt = index.find(key);
+  if (indexIt == index.end())
+    {
+    return NULL;
+    }
+  for (std::vector<vtkMRMLSubjectHierarchyNode*>::iterator nodeIt = indexIt->second.begin();
+       nodeIt != indexIt->second.end(); ++nodeIt)
+    {
+    // Nodes are indexed as soon as their scene is set, which may be before
+    // they are added to the scene (e.g. when importing a scene)
+    if ((*nodeIt)->GetID() && scene->GetNodeByID((*nodeIt)->GetID()) == *nodeIt)
+      {
+      return *nodeIt;
+      }
+    }
+  return NULL;
+}
+
 //----------------------------------------------------------------------------
 void vtkMRMLSubjectHierarchyNode::SetOwnerPluginName(const char* pluginName)
 {
@@ -256,6 +411,7 @@ void vtkMRMLSubjectHierarchyNode::AddUID(std::string uidName, std::string uidVal
       }
     }
   this->UIDs[uidName] = uidValue;
+  this->UpdateIndex();
   this->InvokeEvent(SubjectHierarchyUIDAddedEvent, this);
   this->Modified();
 }
@@ -286,23 +442,18 @@ vtkMRMLSubjectHierarchyNode* vtkMRMLSubjectHierarchyNode::GetSubjectHierarchyNod
     return NULL;
     }
 
-  std::vector<vtkMRMLNode*> subjectHierarchyNodes;
-  unsigned int numberOfNodes = scene->GetNodesByClass("vtkMRMLSubjectHierarchyNode", subjectHierarchyNodes);
-  for (unsigned int shNodeIndex=0; shNodeIndex<numberOfNodes; shNodeIndex++)
+  std::map<vtkMRMLScene*, std::map<std::string, SubjectHierarchyNodesIndexType> >::iterator uidSceneIt =
+    SceneSubjectHierarchyNodesByUID.find(scene);
+  if (uidSceneIt == SceneSubjectHierarchyNodesByUID.end())
     {
-    vtkMRMLSubjectHierarchyNode* node = vtkMRMLSubjectHierarchyNode::SafeDownCast(subjectHierarchyNodes[shNodeIndex]);
-    if (node)
-      {
-      std::string nodeUidValueStr = node->GetUID(uidName);
-      const char* nodeUidValue = nodeUidValueStr.c_str();
-      if (nodeUidValue && !strcmp(uidValue, nodeUidValue))
-        {
-        return node;
-        }
-      }
+    return NULL;
     }
-
-  return NULL;
+  std::map<std::string, SubjectHierarchyNodesIndexType>::iterator uidNameIt = uidSceneIt->second.find(uidName);
+  if (uidNameIt == uidSceneIt->second.end())
+    {
+    return NULL;
+    }
+  return vtkMRMLSubjectHierarchyNode::FindIndexedNode(scene, uidNameIt->second, uidValue);
 }
 
 //---------------------------------------------------------------------------
@@ -584,36 +735,45 @@ vtkMRMLSubjectHierarchyNode* vtkMRMLSubjectHierarchyNode::GetAssociatedSubjectHi
     return vtkMRMLSubjectHierarchyNode::SafeDownCast(associatedNode);
     }
 
-  vtkMRMLHierarchyNode::UpdateAssociatedToHierarchyMap(scene);
+  if (!associatedNode->GetID())
+    {
+    return NULL;
+    }
 
-  std::map<vtkMRMLScene*, AssociatedHierarchyNodesType>::iterator sceneIt =
-    vtkMRMLHierarchyNode::SceneAssociatedHierarchyNodes.find(scene);
-  if (sceneIt == vtkMRMLHierarchyNode::SceneAssociatedHierarchyNodes.end())
+  std::map<vtkMRMLScene*, SubjectHierarchyNodesIndexType>::iterator sceneIt =
+    SceneSubjectHierarchyNodesByAssociatedNodeID.find(scene);
+  if (sceneIt == SceneSubjectHierarchyNodesByAssociatedNodeID.end())
     {
-    vtkErrorWithObjectMacro(scene, "GetAssociatedSubjectHierarchyNode: Failed to find an associated hierarchy node type associated with the scene");
+    // No subject hierarchy node is associated to any node in the scene
     return NULL;
     }
 
-  AssociatedHierarchyNodesType sceneAssociations = sceneIt->second;
-  std::map<std::string, vtkMRMLHierarchyNode*>::iterator assocIt =
-    sceneAssociations.find(associatedNode->GetID());
-  if (assocIt != sceneAssociations.end())
+  vtkMRMLSubjectHierarchyNode* subjectHierarchyNode =
+    vtkMRMLSubjectHierarchyNode::FindIndexedNode(scene, sceneIt->second, associatedNode->GetID());
+  if (subjectHierarchyNode)
     {
-    vtkMRMLHierarchyNode* associatedHierarchyNode = assocIt->second;
-    if (associatedHierarchyNode->IsA("vtkMRMLSubjectHierarchyNode"))
+    return subjectHierarchyNode;
+    }
+
+  // Nested association: the subject hierarchy node is associated to a regular
+  // hierarchy node that is associated to the node. Such hierarchy nodes reference
+  // the node, so only the nodes referencing it need to be checked.
+  std::vector<vtkMRMLNode*> referencingNodes;
+  scene->GetReferencingNodes(associatedNode, referencingNodes);
+  for (std::vector<vtkMRMLNode*>::iterator nodeIt = referencingNodes.begin(); nodeIt != referencingNodes.end(); ++nodeIt)
+    {
+    vtkMRMLHierarchyNode* associatedHierarchyNode = vtkMRMLHierarchyNode::SafeDownCast(*nodeIt);
+    if ( !associatedHierarchyNode || associatedHierarchyNode->IsA("vtkMRMLSubjectHierarchyNode")
+      || !associatedHierarchyNode->GetAssociatedNodeID()
+      || strcmp(associatedHierarchyNode->GetAssociatedNodeID(), associatedNode->GetID()) )
       {
-      return vtkMRMLSubjectHierarchyNode::SafeDownCast(associatedHierarchyNode);
+      continue;
       }
-    // Associated node is a regular hierarchy node, because either nested association
-    // was used, or the node does not have an associated subject hierarchy node
-    else
+    subjectHierarchyNode = vtkMRMLSubjectHierarchyNode::FindIndexedNode(
+      scene, sceneIt->second, associatedHierarchyNode->GetID());
+    if (subjectHierarchyNode)
       {
-      std::map<std::string, vtkMRMLHierarchyNode*>::iterator nestedIt =
-        sceneAssociations.find(associatedHierarchyNode->GetID());
-      if (nestedIt != sceneAssociations.end())
-        {
-        return vtkMRMLSubjectHierarchyNode::SafeDownCast(nestedIt->second);
-        }
+      return subjectHierarchyNode;
       }
     }
 
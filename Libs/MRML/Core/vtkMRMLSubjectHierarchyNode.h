@@ -33,6 +33,7 @@
 
 // STD includes
 #include <map>
+#include <vector>
 
 class vtkMRMLTransformNode;
 
@@ -77,6 +78,12 @@ public:
   /// Get node XML tag name (like Volume, Contour)
   virtual const char* GetNodeTagName();
 
+  /// Reimplemented to index the node in the scene
+  virtual void SetScene(vtkMRMLScene* scene);
+
+  /// Reimplemented to index the node by its associated node
+  virtual void SetAssociatedNodeID(const char* ref);
+
 public:
   /// Find subject hierarchy node according to a UID (by exact match)
   /// \param scene MRML scene
@@ -230,6 +237,33 @@ protected:
   /// UIDs can be DICOM UIDs, MIDAS urls, etc.
   std::map<std::string, std::string> UIDs;
 
+protected:
+  /// Subject hierarchy nodes of a scene by associated node ID or by UID value.
+  /// If several nodes have the same key, they are in the order they were indexed.
+  typedef std::map<std::string, std::vector<vtkMRMLSubjectHierarchyNode*> > SubjectHierarchyNodesIndexType;
+
+  /// Subject hierarchy nodes of each scene by associated node ID
+  static std::map<vtkMRMLScene*, SubjectHierarchyNodesIndexType> SceneSubjectHierarchyNodesByAssociatedNodeID;
+  /// Subject hierarchy nodes of each scene by UID name and UID value
+  static std::map<vtkMRMLScene*, std::map<std::string, SubjectHierarchyNodesIndexType> > SceneSubjectHierarchyNodesByUID;
+
+  /// Update the index entries of this node when it is added to or removed
+  /// from a scene, or when its associated node or its UIDs change.
+  /// The index makes GetAssociatedSubjectHierarchyNode() and
+  /// GetSubjectHierarchyNodeByUID() logarithmic instead of linear in the
+  /// number of nodes of the scene.
+  void UpdateIndex();
+  void RemoveFromIndex();
+
+  /// Scene, associated node ID and UIDs this node is indexed with
+  vtkMRMLScene* IndexedScene;
+  std::string IndexedAssociatedNodeID;
+  std::map<std::string, std::string> IndexedUIDs;
+
+  /// Return the first node of the index entry that is in the scene
+  static vtkMRMLSubjectHierarchyNode* FindIndexedNode(vtkMRMLScene* scene,
+    SubjectHierarchyNodesIndexType& index, const std::string& key);
+
 protected:
   vtkMRMLSubjectHierarchyNode();
   ~vtkMRMLSubjectHierarchyNode();
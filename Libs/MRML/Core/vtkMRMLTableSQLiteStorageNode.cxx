@@ -30,16 +30,72 @@
 #include <vtkTable.h>
 #include <vtkStringArray.h>
 #include <vtkBitArray.h>
+#include <vtkDoubleArray.h>
 #include <vtkNew.h>
 #include <vtkSQLQuery.h>
-#include <vtkRowQueryToTable.h>
 #include <vtkSQLDatabase.h>
 #include <vtkSQLiteDatabase.h>
 #include <vtkSQLiteQuery.h>
 #include <vtkSmartPointer.h>
+#include <vtkTypeInt64Array.h>
 
 #include <vtksys/SystemTools.hxx>
 
+// STD includes
+#include <algorithm>
+#include <cctype>
+#include <vector>
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+// SQLite type of the values of a table column
+enum ColumnType
+{
+  TextColumn,
+  RealColumn,
+  IntegerColumn
+};
+
+//----------------------------------------------------------------------------
+ColumnType GetColumnType(vtkAbstractArray* column)
+{
+  vtkDataArray* dataArray = vtkDataArray::SafeDownCast(column);
+  if (!dataArray || dataArray->GetNumberOfComponents() != 1)
+    {
+    return TextColumn;
+    }
+  if (dataArray->GetDataType() == VTK_DOUBLE ||
+      dataArray->GetDataType() == VTK_FLOAT)
+    {
+    return RealColumn;
+    }
+  return IntegerColumn;
+}
+
+//----------------------------------------------------------------------------
+// Type of the array that stores a column of a given declared SQL type,
+// following the type affinity rules of SQLite. SQLite integers are 64-bit.
+int GetColumnArrayType(std::string declaredType)
+{
+  std::transform(declaredType.begin(), declaredType.end(),
+                 declaredType.begin(), ::toupper);
+  if (declaredType.find("INT") != std::string::npos)
+    {
+    return VTK_TYPE_INT64;
+    }
+  if (declaredType.find("REAL") != std::string::npos ||
+      declaredType.find("FLOA") != std::string::npos ||
+      declaredType.find("DOUB") != std::string::npos)
+    {
+    return VTK_DOUBLE;
+    }
+  return VTK_STRING;
+}
+
+}
+
 //------------------------------------------------------------------------------
 vtkMRMLNodeNewMacro(vtkMRMLTableSQLiteStorageNode);
 
@@ -83,6 +139,11 @@ int vtkMRMLTableSQLiteStorageNode::ReadDataInternal(vtkMRMLNode *refNode)
     vtkErrorMacro("ReadData: unable to cast input node " << refNode->GetID() << " to a table node");
     return 0;
     }
+  if (!this->TableName || std::string(this->TableName).empty())
+    {
+    vtkErrorMacro("ReadData: no table name specified");
+    return 0;
+    }
 
   // Check that the file exists
   if (vtksys::SystemTools::FileExists(fullName) == false)
@@ -103,18 +164,66 @@ int vtkMRMLTableSQLiteStorageNode::ReadDataInternal(vtkMRMLNode *refNode)
 
   vtkSmartPointer<vtkSQLiteQuery> query = vtkSmartPointer<vtkSQLiteQuery>::Take(
                    vtkSQLiteQuery::SafeDownCast( database->GetQueryInstance()));
+
+  // The column arrays are typed from the declared types of the table
+  // columns rather than from the values of the first row.
+  std::vector<int> columnArrayTypes;
+  std::string tableInfoQuery("PRAGMA table_info(");
+  tableInfoQuery += std::string(this->TableName) + ")";
+  query->SetQuery(tableInfoQuery.c_str());
+  if (query->Execute())
+    {
+    while (query->NextRow())
+      {
+      // columns: cid, name, type, notnull, dflt_value, pk
+      columnArrayTypes.push_back(GetColumnArrayType(query->DataValue(2).ToString()));
+      }
+    }
+
   std::string queryString("select * from ");
   queryString += std::string(this->TableName);
   query->SetQuery(queryString.c_str());
-  query->Execute();
-
-  vtkSmartPointer<vtkRowQueryToTable> queryToTable = vtkSmartPointer<vtkRowQueryToTable>::New();
-  queryToTable->SetQuery(query);
-  queryToTable->Update();
+  if (!query->Execute())
+    {
+    vtkErrorMacro("ReadData: unable to read table '" << this->TableName
+                  << "' from database file '" << fullName << "'");
+    return 0;
+    }
 
-  vtkSmartPointer<vtkTable> table = queryToTable->GetOutput();
+  // Fill the table columns directly, row by row
+  vtkNew<vtkTable> table;
+  const int numColumns = query->GetNumberOfFields();
+  columnArrayTypes.resize(numColumns, VTK_STRING);
+  std::vector<vtkAbstractArray*> columns(numColumns);
+  for (int j = 0; j < numColumns; j++)
+    {
+    vtkSmartPointer<vtkAbstractArray> column = vtkSmartPointer<vtkAbstractArray>::Take(
+      columnArrayTypes[j] == VTK_TYPE_INT64 ?
+        vtkTypeInt64Array::New() : vtkAbstractArray::CreateArray(columnArrayTypes[j]));
+    column->SetName(query->GetFieldName(j));
+    table->AddColumn(column);
+    columns[j] = column;
+    }
+  while (query->NextRow())
+    {
+    for (int j = 0; j < numColumns; j++)
+      {
+      switch (columnArrayTypes[j])
+        {
+        case VTK_DOUBLE:
+          static_cast<vtkDoubleArray*>(columns[j])->InsertNextValue(query->DataValue(j).ToDouble());
+          break;
+        case VTK_TYPE_INT64:
+          static_cast<vtkTypeInt64Array*>(columns[j])->InsertNextValue(query->DataValue(j).ToTypeInt64());
+          break;
+        default:
+          static_cast<vtkStringArray*>(columns[j])->InsertNextValue(query->DataValue(j).ToString());
+          break;
+        }
+      }
+    }
 
-  tableNode->SetAndObserveTable(table);
+  tableNode->SetAndObserveTable(table.GetPointer());
 
   vtkDebugMacro("ReadData: successfully read table from file: " << fullName);
 
@@ -148,27 +257,21 @@ int vtkMRMLTableSQLiteStorageNode::WriteDataInternal(vtkMRMLNode *refNode)
     return 0;
     }
 
-  std::string dbname = std::string("sqlite://") + fullName;
-
-  //vtkSmartPointer<vtkSQLiteDatabase> database = vtkSmartPointer<vtkSQLiteDatabase>::Take(vtkSQLiteDatabase::SafeDownCast( vtkSQLiteDatabase::CreateFromURL(dbname.c_str())));
-  vtkSQLiteDatabase *database = vtkSQLiteDatabase::SafeDownCast( vtkSQLiteDatabase::CreateFromURL(dbname.c_str()));
-
-  if (!database || !database->Open(this->GetPassword(), vtkSQLiteDatabase::USE_EXISTING_OR_CREATE))
-    {
-    vtkErrorMacro("ReadData: database file '" << fullName << "cannot be openned");
-    return 0;
-    }
-
   vtkTable *table = tableNode->GetTable();
   if (!table)
     {
-    vtkErrorMacro("ReadData: no table to write for the node '" << std::string(tableNode->GetName()));
+    vtkErrorMacro("WriteData: no table to write for the node '" << std::string(tableNode->GetName()));
     return 0;
     }
 
-  if (!this->TableName || std::string(this->TableName).empty())
+  std::string dbname = std::string("sqlite://") + fullName;
+
+  vtkSmartPointer<vtkSQLiteDatabase> database = vtkSmartPointer<vtkSQLiteDatabase>::Take(
+                   vtkSQLiteDatabase::SafeDownCast( vtkSQLiteDatabase::CreateFromURL(dbname.c_str())));
+
+  if (!database.GetPointer() || !database->Open(this->GetPassword(), vtkSQLiteDatabase::USE_EXISTING_OR_CREATE))
     {
-    vtkErrorMacro("ReadData: no table name for the node '" << std::string(tableNode->GetName()));
+    vtkErrorMacro("WriteData: database file '" << fullName << "cannot be openned");
     return 0;
     }
 
@@ -176,91 +279,113 @@ int vtkMRMLTableSQLiteStorageNode::WriteDataInternal(vtkMRMLNode *refNode)
   this->DropTable(this->TableName, database);
 
   //converting this table to SQLite will require two queries: one to create
-  //the table, and another to populate its rows with data.
+  //the table, and another one, prepared once, to insert its rows.
   std::string createTableQuery = "CREATE TABLE IF NOT EXISTS ";
   createTableQuery += this->TableName;
   createTableQuery += "(";
 
-  std::string insertPreamble = "INSERT into ";
-  insertPreamble += this->TableName;
-  insertPreamble += "(";
+  std::string insertQuery = "INSERT into ";
+  insertQuery += this->TableName;
+  insertQuery += "(";
+  std::string insertValues = ") VALUES (";
 
   //get the columns from the vtkTable to finish the query
   vtkIdType numColumns = table->GetNumberOfColumns();
+  std::vector<ColumnType> columnTypes(numColumns);
   for(vtkIdType i = 0; i < numColumns; i++)
     {
     //get this column's name
     std::string columnName = table->GetColumn(i)->GetName();
     createTableQuery += columnName;
-    insertPreamble += "'" + columnName + "'";
+    insertQuery += "'" + columnName + "'";
+    insertValues += "?";
 
     //figure out what type of data is stored in this column
-    std::string columnType = table->GetColumn(i)->GetClassName();
-
-    if( (columnType.find("String") != std::string::npos) ||
-        (columnType.find("Data") != std::string::npos) ||
-        (columnType.find("Variant") != std::string::npos) )
-      {
-      createTableQuery += " TEXT";
-      }
-    else if( (columnType.find("Double") != std::string::npos) ||
-             (columnType.find("Float") != std::string::npos) )
-      {
-      createTableQuery += " REAL";
-      }
-    else
-      {
-      createTableQuery += " INTEGER";
-      }
-    if(i == numColumns - 1)
+    columnTypes[i] = GetColumnType(table->GetColumn(i));
+    switch (columnTypes[i])
       {
-      createTableQuery += ");";
-      insertPreamble += ") VALUES (";
+      case RealColumn:
+        createTableQuery += " REAL";
+        break;
+      case IntegerColumn:
+        createTableQuery += " INTEGER";
+        break;
+      default:
+        createTableQuery += " TEXT";
+        break;
       }
-    else
+    if(i < numColumns - 1)
       {
       createTableQuery += ", ";
-      insertPreamble += ", ";
+      insertQuery += ", ";
+      insertValues += ", ";
       }
     }
+  createTableQuery += ");";
+  insertQuery += insertValues + ");";
 
   //perform the create table query
-  vtkSQLiteQuery *query =
-    static_cast<vtkSQLiteQuery*>(database->GetQueryInstance());
+  vtkSmartPointer<vtkSQLiteQuery> query = vtkSmartPointer<vtkSQLiteQuery>::Take(
+                   vtkSQLiteQuery::SafeDownCast( database->GetQueryInstance()));
 
   query->SetQuery(createTableQuery.c_str());
-  cout << "creating the table" << endl;
   if(!query->Execute())
     {
     vtkErrorMacro(<<"Error performing 'create table' query");
+    return 0;
+    }
+
+  // Insert all the rows in a single transaction: without it, every insert
+  // is committed (and synced to disk) individually.
+  if (!query->BeginTransaction())
+    {
+    vtkErrorMacro(<<"Error starting the 'insert' transaction");
+    return 0;
     }
+  query->SetQuery(insertQuery.c_str());
 
-  //iterate over the rows of the vtkTable to complete the insert query
+  //iterate over the rows of the vtkTable and bind their values to the
+  //insert query. Numbers are bound with their type to keep their precision.
   vtkIdType numRows = table->GetNumberOfRows();
   for(vtkIdType i = 0; i < numRows; i++)
     {
-    std::string insertQuery = insertPreamble;
     for (vtkIdType j = 0; j < numColumns; j++)
       {
-      insertQuery += "'" + table->GetValue(i, j).ToString() + "'";
-      if(j < numColumns - 1)
+      vtkAbstractArray* column = table->GetColumn(j);
+      switch (columnTypes[j])
         {
-        insertQuery += ", ";
+        case RealColumn:
+          query->BindParameter(j, static_cast<vtkDataArray*>(column)->GetComponent(i, 0));
+          break;
+        case IntegerColumn:
+          query->BindParameter(j, column->GetVariantValue(i).ToTypeInt64());
+          break;
+        default:
+          {
+          vtkStringArray* stringColumn = vtkStringArray::SafeDownCast(column);
+          query->BindParameter(j, stringColumn ? stringColumn->GetValue(i) :
+                                                 table->GetValue(i, j).ToString());
+          }
+          break;
         }
       }
-    insertQuery += ");";
     //perform the insert query for this row
-    query->SetQuery(insertQuery.c_str());
     if(!query->Execute())
       {
-      vtkErrorMacro(<<"Error performing 'insert' query");
+      vtkErrorMacro(<<"Error performing 'insert' query for row " << i);
+      query->RollbackTransaction();
+      return 0;
       }
     }
 
+  if (!query->CommitTransaction())
+    {
+    vtkErrorMacro(<<"Error committing the 'insert' transaction");
+    return 0;
+    }
+
   //cleanup and return
-  query->Delete();
   database->Close();
-  database->Delete();
 
   vtkDebugMacro("WriteData: successfully wrote table to database: " << fullName);
   return 1;
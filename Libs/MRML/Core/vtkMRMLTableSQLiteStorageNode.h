@@ -30,7 +30,11 @@
 /// vtkMRMLTableSQLiteStorageNode allows reading/writing of table node from
 /// SQLight database.
 ///
-///
+/// The rows are inserted in a single transaction with one prepared query.
+/// Floating point columns are stored as REAL, other single component numeric
+/// columns as INTEGER and the remaining columns as TEXT. When reading, the
+/// column arrays are created from the declared column types (vtkDoubleArray,
+/// vtkIntArray or vtkStringArray).
 
 class vtkSQLiteDatabase;
 
@@ -259,40 +259,9 @@ void ApplyImageSeriesReaderWorkaround(vtkMRMLVolumeArchetypeStorageNode * storag
 } // end of anonymous namespace
 
 //----------------------------------------------------------------------------
-int vtkMRMLVolumeArchetypeStorageNode::ReadDataInternal(vtkMRMLNode *refNode)
+vtkITKArchetypeImageSeriesReader* vtkMRMLVolumeArchetypeStorageNode
+::InstantiateVolumeReader(vtkMRMLNode *refNode, const std::string& fullName)
 {
-  std::string fullName = this->GetFullNameFromFileName();
-  vtkDebugMacro("ReadData: got full archetype name " << fullName);
-
-  if (fullName.empty())
-    {
-    vtkErrorMacro("ReadData: File name not specified");
-    return 0;
-    }
-
-  //
-  // vtkMRMLVolumeNode
-  //   |
-  //   |--vtkMRMLScalarVolumeNode
-  //         |
-  //         |----vtkMRMLDiffusionWeightedVolumeNode
-  //         |
-  //         |----vtkMRMLTensorVolumeNode
-  //                  |
-  //                  |---vtkMRMLDiffusionImageVolumeNode
-  //                  |       |
-  //                  |       |---vtkMRMLDiffusionTensorVolumeNode
-  //                  |
-  //                  |---vtkMRMLVectorVolumeNode
-  //
-
-  vtkMRMLScalarVolumeNode * volNode = vtkMRMLScalarVolumeNode::SafeDownCast(refNode);
-  if(volNode == NULL)
-    {
-    vtkErrorMacro("ReadData: Reference node is expected to be a vtkMRMLScalarVolumeNode");
-    return 0;
-    }
-
   vtkSmartPointer<vtkITKArchetypeImageSeriesReader> reader;
 
   if (refNode->IsA("vtkMRMLVectorVolumeNode"))
@@ -314,15 +283,7 @@ int vtkMRMLVolumeArchetypeStorageNode::ReadDataInternal(vtkMRMLNode *refNode)
 
   if (reader.GetPointer() == NULL)
     {
-    vtkErrorMacro("ReadData: Failed to instantiate a file reader");
-    return 0;
-    }
-
-  reader->AddObserver( vtkCommand::ProgressEvent,  this->MRMLCallbackCommand);
-
-  if (volNode->GetImageData())
-    {
-    volNode->SetAndObserveImageData(NULL);
+    return NULL;
     }
 
   // Set the list of file names on the reader
@@ -344,6 +305,14 @@ int vtkMRMLVolumeArchetypeStorageNode::ReadDataInternal(vtkMRMLNode *refNode)
     reader->SetUseNativeOriginOn();
     }
 
+  reader->Register(0);
+  return reader;
+}
+
+//----------------------------------------------------------------------------
+bool vtkMRMLVolumeArchetypeStorageNode::UpdateVolumeReader(
+  vtkITKArchetypeImageSeriesReader* reader, vtkMRMLNode *refNode, const std::string& fullName)
+{
   try
     {
     vtkDebugMacro("ReadData: right before reader update, reader num files = " << reader->GetNumberOfFileNames());
@@ -367,6 +336,97 @@ int vtkMRMLVolumeArchetypeStorageNode::ReadDataInternal(vtkMRMLNode *refNode)
                   << " [" << reader0thFileName.c_str() << "]\n"
                   << "ITK exception info: error in " << e.GetLocation() << "\n"
                   << e.GetDescription() << "\n");
+    return false;
+    }
+
+  return true;
+}
+
+//----------------------------------------------------------------------------
+int vtkMRMLVolumeArchetypeStorageNode::PreReadDataInternal(vtkMRMLNode *refNode)
+{
+  // The reader doesn't access any node, its output is set into the volume
+  // node by ReadDataInternal().
+  std::string fullName = this->GetFullNameFromFileName();
+  if (fullName.empty())
+    {
+    vtkErrorMacro("PreReadData: File name not specified");
+    return 0;
+    }
+  vtkSmartPointer<vtkITKArchetypeImageSeriesReader> reader;
+  reader.TakeReference(this->InstantiateVolumeReader(refNode, fullName));
+  if (reader.GetPointer() == NULL)
+    {
+    vtkErrorMacro("PreReadData: Failed to instantiate a file reader");
+    return 0;
+    }
+  if (!this->UpdateVolumeReader(reader, refNode, fullName))
+    {
+    return 0;
+    }
+  this->PreReadObject = reader;
+  return 1;
+}
+
+//----------------------------------------------------------------------------
+int vtkMRMLVolumeArchetypeStorageNode::ReadDataInternal(vtkMRMLNode *refNode)
+{
+  std::string fullName = this->GetFullNameFromFileName();
+  vtkDebugMacro("ReadData: got full archetype name " << fullName);
+
+  if (fullName.empty())
+    {
+    vtkErrorMacro("ReadData: File name not specified");
+    return 0;
+    }
+
+  //
+  // vtkMRMLVolumeNode
+  //   |
+  //   |--vtkMRMLScalarVolumeNode
+  //         |
+  //         |----vtkMRMLDiffusionWeightedVolumeNode
+  //         |
+  //         |----vtkMRMLTensorVolumeNode
+  //                  |
+  //                  |---vtkMRMLDiffusionImageVolumeNode
+  //                  |       |
+  //                  |       |---vtkMRMLDiffusionTensorVolumeNode
+  //                  |
+  //                  |---vtkMRMLVectorVolumeNode
+  //
+
+  vtkMRMLScalarVolumeNode * volNode = vtkMRMLScalarVolumeNode::SafeDownCast(refNode);
+  if(volNode == NULL)
+    {
+    vtkErrorMacro("ReadData: Reference node is expected to be a vtkMRMLScalarVolumeNode");
+    return 0;
+    }
+
+  // The file may have been read ahead by PreReadDataInternal()
+  vtkSmartPointer<vtkITKArchetypeImageSeriesReader> reader =
+    vtkITKArchetypeImageSeriesReader::SafeDownCast(this->PreReadObject);
+  if (reader.GetPointer() == NULL)
+    {
+    reader.TakeReference(this->InstantiateVolumeReader(refNode, fullName));
+    }
+
+  if (reader.GetPointer() == NULL)
+    {
+    vtkErrorMacro("ReadData: Failed to instantiate a file reader");
+    return 0;
+    }
+
+  reader->AddObserver( vtkCommand::ProgressEvent,  this->MRMLCallbackCommand);
+
+  if (volNode->GetImageData())
+    {
+    volNode->SetAndObserveImageData(NULL);
+    }
+
+  // Nothing is read again if the reader is up to date
+  if (!this->UpdateVolumeReader(reader, refNode, fullName))
+    {
     return 0;
     }
 
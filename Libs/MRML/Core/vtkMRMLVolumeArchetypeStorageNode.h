@@ -80,6 +80,10 @@ public:
   virtual bool CanReadInReferenceNode(vtkMRMLNode* refNode);
   virtual bool CanWriteFromReferenceNode(vtkMRMLNode* refNode);
 
+  /// Volumes are read by a reader that doesn't access the volume node, they
+  /// can be read in parallel.
+  virtual bool CanReadInParallel() { return true; };
+
   ///
   /// Configure the storage node for data exchange. This is an
   /// opportunity to optimize the storage node's settings, for
@@ -97,9 +101,23 @@ protected:
 
   vtkITKArchetypeImageSeriesReader* InstantiateVectorVolumeReader(const std::string &fullName);
 
+  /// Create and configure the reader of \a fullName for \a refNode without
+  /// reading the file. Return NULL on failure. The caller is responsible for
+  /// deleting the reader.
+  vtkITKArchetypeImageSeriesReader* InstantiateVolumeReader(vtkMRMLNode *refNode,
+                                                            const std::string &fullName);
+
+  /// Read the file with \a reader. Return false and report the error on
+  /// failure.
+  bool UpdateVolumeReader(vtkITKArchetypeImageSeriesReader* reader,
+                          vtkMRMLNode *refNode, const std::string &fullName);
+
   /// Read data and set it in the referenced node
   virtual int ReadDataInternal(vtkMRMLNode *refNode);
 
+  /// Read the file with a reader kept in PreReadObject
+  virtual int PreReadDataInternal(vtkMRMLNode *refNode);
+
   /// Write data from a referenced node
   virtual int WriteDataInternal(vtkMRMLNode *refNode);
 
@@ -0,0 +1,646 @@
+/*=auto=========================================================================
+
+  Portions (c) Copyright 2005 Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Program:   3D Slicer
+
+=========================================================================auto=*/
+
+// MRML includes
+#include "vtkMRMLVolumeHistogram.h"
+
+// VTK includes
+#include <vtkDataArray.h>
+#include <vtkIdTypeArray.h>
+#include <vtkImageData.h>
+#include <vtkMultiThreader.h>
+#include <vtkNew.h>
+#include <vtkObjectFactory.h>
+#include <vtkPointData.h>
+
+// STD includes
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+//----------------------------------------------------------------------------
+vtkStandardNewMacro(vtkMRMLVolumeHistogram);
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+struct vtkMRMLVolumeHistogramThreadStruct
+{
+  void* Scalars;
+  int ScalarType;
+  int NumberOfComponents;
+  int Component;
+  int Dimensions[3];
+  double Spacing[3];
+  vtkIdType NumberOfVoxels;
+  vtkIdType SampleStep;
+  vtkIdType NumberOfSamples;
+
+  /// Compute the gradient magnitude instead of the scalar
+  bool GradientMagnitude;
+  /// Fill the histograms, only compute the ranges otherwise
+  bool Histogram;
+
+  double ScalarBinOrigin;
+  double ScalarBinWidth;
+  int NumberOfScalarBins;
+  double GradientMagnitudeBinWidth;
+  int NumberOfGradientMagnitudeBins;
+  int JointHistogramDimensions[2];
+
+  /// Results, one per thread
+  std::vector<double> Min;
+  std::vector<double> Max;
+  std::vector<std::vector<vtkIdType> > Counts;
+  std::vector<std::vector<vtkIdType> > JointCounts;
+};
+
+//----------------------------------------------------------------------------
+// x - x is 0 for finite values and NaN for NaN and infinite values.
+inline bool IsFinite(double value)
+{
+  return value - value == 0.;
+}
+
+//----------------------------------------------------------------------------
+// Return the voxel sampled in the stratum: a pseudo-random (but
+// deterministic) voxel among the SampleStep voxels of the stratum.
+inline vtkIdType GetSampledVoxel(const vtkMRMLVolumeHistogramThreadStruct* str,
+                                 vtkIdType stratum)
+{
+  const vtkIdType firstVoxel = stratum * str->SampleStep;
+  if (str->SampleStep == 1)
+    {
+    return firstVoxel;
+    }
+  vtkTypeUInt32 hash = static_cast<vtkTypeUInt32>(stratum);
+  hash ^= hash >> 16;
+  hash *= 0x7feb352dU;
+  hash ^= hash >> 15;
+  hash *= 0x846ca68bU;
+  hash ^= hash >> 16;
+  const vtkIdType stratumSize =
+    std::min(str->SampleStep, str->NumberOfVoxels - firstVoxel);
+  return firstVoxel + static_cast<vtkIdType>(hash % stratumSize);
+}
+
+//----------------------------------------------------------------------------
+// Central differences, one-sided differences on the boundaries.
+template <class T>
+double GetGradientMagnitude(const vtkMRMLVolumeHistogramThreadStruct* str,
+                            const T* scalars, vtkIdType voxel)
+{
+  const vtkIdType sliceSize =
+    static_cast<vtkIdType>(str->Dimensions[0]) * str->Dimensions[1];
+  int ijk[3];
+  ijk[2] = static_cast<int>(voxel / sliceSize);
+  const vtkIdType sliceVoxel = voxel - ijk[2] * sliceSize;
+  ijk[1] = static_cast<int>(sliceVoxel / str->Dimensions[0]);
+  ijk[0] = static_cast<int>(sliceVoxel - ijk[1] * str->Dimensions[0]);
+  vtkIdType increments[3];
+  increments[0] = str->NumberOfComponents;
+  increments[1] = increments[0] * str->Dimensions[0];
+  increments[2] = increments[1] * str->Dimensions[1];
+
+  const T* scalar = scalars + voxel * str->NumberOfComponents + str->Component;
+  double squaredMagnitude = 0.;
+  for (int axis = 0; axis < 3; ++axis)
+    {
+    const int previous = ijk[axis] > 0 ? 1 : 0;
+    const int next = ijk[axis] < str->Dimensions[axis] - 1 ? 1 : 0;
+    if (previous + next == 0)
+      {
+      continue;
+      }
+    const double difference =
+      (static_cast<double>(scalar[next * increments[axis]]) -
+       static_cast<double>(scalar[-previous * increments[axis]])) /
+      ((previous + next) * str->Spacing[axis]);
+    squaredMagnitude += difference * difference;
+    }
+  return sqrt(squaredMagnitude);
+}
+
+//----------------------------------------------------------------------------
+inline int GetBin(double value, double origin, double width, int numberOfBins)
+{
+  const int bin = static_cast<int>((value - origin) / width);
+  return std::max(0, std::min(bin, numberOfBins - 1));
+}
+
+//----------------------------------------------------------------------------
+template <class T>
+void vtkMRMLVolumeHistogramExecute(vtkMRMLVolumeHistogramThreadStruct* str,
+                                   const T* scalars,
+                                   int threadId, int threadCount)
+{
+  const vtkIdType firstSample = str->NumberOfSamples * threadId / threadCount;
+  const vtkIdType lastSample = str->NumberOfSamples * (threadId + 1) / threadCount;
+
+  double minValue = VTK_DOUBLE_MAX;
+  double maxValue = VTK_DOUBLE_MIN;
+  vtkIdType* counts = 0;
+  vtkIdType* jointCounts = 0;
+  if (str->Histogram)
+    {
+    counts = &str->Counts[threadId][0];
+    if (str->GradientMagnitude)
+      {
+      jointCounts = &str->JointCounts[threadId][0];
+      }
+    }
+
+  for (vtkIdType sample = firstSample; sample < lastSample; ++sample)
+    {
+    const vtkIdType voxel = GetSampledVoxel(str, sample);
+    const double scalar = static_cast<double>(
+      scalars[voxel * str->NumberOfComponents + str->Component]);
+    if (!IsFinite(scalar))
+      {
+      continue;
+      }
+    double value = scalar;
+    if (str->GradientMagnitude)
+      {
+      value = GetGradientMagnitude(str, scalars, voxel);
+      if (!IsFinite(value))
+        {
+        continue;
+        }
+      }
+    if (!str->Histogram)
+      {
+      minValue = std::min(minValue, value);
+      maxValue = std::max(maxValue, value);
+      continue;
+      }
+    const int scalarBin = GetBin(scalar, str->ScalarBinOrigin,
+                                 str->ScalarBinWidth, str->NumberOfScalarBins);
+    if (!str->GradientMagnitude)
+      {
+      ++counts[scalarBin];
+      continue;
+      }
+    const int gradientBin = GetBin(value, 0., str->GradientMagnitudeBinWidth,
+                                   str->NumberOfGradientMagnitudeBins);
+    ++counts[gradientBin];
+    const vtkIdType jointScalarBin = static_cast<vtkIdType>(scalarBin) *
+      str->JointHistogramDimensions[0] / str->NumberOfScalarBins;
+    const vtkIdType jointGradientBin = static_cast<vtkIdType>(gradientBin) *
+      str->JointHistogramDimensions[1] / str->NumberOfGradientMagnitudeBins;
+    ++jointCounts[jointGradientBin * str->JointHistogramDimensions[0] + jointScalarBin];
+    }
+  str->Min[threadId] = minValue;
+  str->Max[threadId] = maxValue;
+}
+
+//----------------------------------------------------------------------------
+// Each thread processes a contiguous range of samples.
+VTK_THREAD_RETURN_TYPE vtkMRMLVolumeHistogramThreadedExecute(void* arg)
+{
+  vtkMultiThreader::ThreadInfo* info = static_cast<vtkMultiThreader::ThreadInfo*>(arg);
+  vtkMRMLVolumeHistogramThreadStruct* str =
+    static_cast<vtkMRMLVolumeHistogramThreadStruct*>(info->UserData);
+  switch (str->ScalarType)
+    {
+    vtkTemplateMacro(vtkMRMLVolumeHistogramExecute(
+      str, static_cast<const VTK_TT*>(str->Scalars),
+      info->ThreadID, info->NumberOfThreads));
+    default:
+      break;
+    }
+  return VTK_THREAD_RETURN_VALUE;
+}
+
+//----------------------------------------------------------------------------
+// Run the pass and return the range of the values over all the threads.
+// The histograms of the threads are summed into the first thread histograms.
+void Execute(vtkMRMLVolumeHistogramThreadStruct& str, int numberOfThreads,
+             double range[2])
+{
+  vtkNew<vtkMultiThreader> threader;
+  threader->SetNumberOfThreads(numberOfThreads);
+  numberOfThreads = threader->GetNumberOfThreads();
+  str.Min.assign(numberOfThreads, VTK_DOUBLE_MAX);
+  str.Max.assign(numberOfThreads, VTK_DOUBLE_MIN);
+  str.Counts.clear();
+  str.JointCounts.clear();
+  if (str.Histogram)
+    {
+    const int numberOfBins = str.GradientMagnitude ?
+      str.NumberOfGradientMagnitudeBins : str.NumberOfScalarBins;
+    str.Counts.resize(numberOfThreads, std::vector<vtkIdType>(numberOfBins, 0));
+    if (str.GradientMagnitude)
+      {
+      str.JointCounts.resize(numberOfThreads, std::vector<vtkIdType>(
+        str.JointHistogramDimensions[0] * str.JointHistogramDimensions[1], 0));
+      }
+    }
+  threader->SetSingleMethod(vtkMRMLVolumeHistogramThreadedExecute, &str);
+  threader->SingleMethodExecute();
+
+  range[0] = *std::min_element(str.Min.begin(), str.Min.end());
+  range[1] = *std::max_element(str.Max.begin(), str.Max.end());
+  for (int thread = 1; thread < static_cast<int>(str.Counts.size()); ++thread)
+    {
+    for (size_t bin = 0; bin < str.Counts[0].size(); ++bin)
+      {
+      str.Counts[0][bin] += str.Counts[thread][bin];
+      }
+    }
+  for (int thread = 1; thread < static_cast<int>(str.JointCounts.size()); ++thread)
+    {
+    for (size_t bin = 0; bin < str.JointCounts[0].size(); ++bin)
+      {
+      str.JointCounts[0][bin] += str.JointCounts[thread][bin];
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+void CopyCounts(const std::vector<vtkIdType>& counts, vtkIdTypeArray* histogram)
+{
+  histogram->SetNumberOfTuples(static_cast<vtkIdType>(counts.size()));
+  std::copy(counts.begin(), counts.end(), histogram->GetPointer(0));
+  histogram->Modified();
+}
+
+}
+
+//----------------------------------------------------------------------------
+vtkMRMLVolumeHistogram::vtkMRMLVolumeHistogram()
+{
+  this->ImageData = 0;
+  this->Component = 0;
+  this->MaximumNumberOfScalarBins = 65536;
+  this->NumberOfGradientMagnitudeBins = 1024;
+  this->MaximumJointHistogramDimensions[0] = 256;
+  this->MaximumJointHistogramDimensions[1] = 256;
+  this->MaximumNumberOfSamples = 16 * 1024 * 1024;
+  this->NumberOfThreads = 0;
+
+  this->ScalarHistogram = vtkIdTypeArray::New();
+  this->ScalarRange[0] = 0.;
+  this->ScalarRange[1] = 0.;
+  this->ScalarBinOrigin = 0.;
+  this->ScalarBinWidth = 1.;
+  this->NumberOfSamples = 0;
+
+  this->GradientMagnitudeHistogram = vtkIdTypeArray::New();
+  this->JointHistogram = vtkIdTypeArray::New();
+  this->GradientMagnitudeRange[0] = 0.;
+  this->GradientMagnitudeRange[1] = 0.;
+  this->GradientMagnitudeBinWidth = 1.;
+  this->JointHistogramDimensions[0] = 0;
+  this->JointHistogramDimensions[1] = 0;
+}
+
+//----------------------------------------------------------------------------
+vtkMRMLVolumeHistogram::~vtkMRMLVolumeHistogram()
+{
+  this->SetImageData(0);
+  this->ScalarHistogram->Delete();
+  this->GradientMagnitudeHistogram->Delete();
+  this->JointHistogram->Delete();
+}
+
+//----------------------------------------------------------------------------
+void vtkMRMLVolumeHistogram::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os, indent);
+  os << indent << "ImageData: " << this->ImageData << "\n";
+  os << indent << "Component: " << this->Component << "\n";
+  os << indent << "MaximumNumberOfScalarBins: " << this->MaximumNumberOfScalarBins << "\n";
+  os << indent << "NumberOfGradientMagnitudeBins: " << this->NumberOfGradientMagnitudeBins << "\n";
+  os << indent << "MaximumJointHistogramDimensions: "
+     << this->MaximumJointHistogramDimensions[0] << " "
+     << this->MaximumJointHistogramDimensions[1] << "\n";
+  os << indent << "MaximumNumberOfSamples: " << this->MaximumNumberOfSamples << "\n";
+  os << indent << "NumberOfThreads: " << this->NumberOfThreads << "\n";
+  os << indent << "ScalarRange: " << this->ScalarRange[0] << " " << this->ScalarRange[1] << "\n";
+  os << indent << "ScalarBinOrigin: " << this->ScalarBinOrigin << "\n";
+  os << indent << "ScalarBinWidth: " << this->ScalarBinWidth << "\n";
+  os << indent << "NumberOfSamples: " << this->NumberOfSamples << "\n";
+  os << indent << "GradientMagnitudeRange: " << this->GradientMagnitudeRange[0]
+     << " " << this->GradientMagnitudeRange[1] << "\n";
+  os << indent << "GradientMagnitudeBinWidth: " << this->GradientMagnitudeBinWidth << "\n";
+}
+
+//----------------------------------------------------------------------------
+void vtkMRMLVolumeHistogram::SetImageData(vtkImageData* imageData)
+{
+  if (imageData == this->ImageData)
+    {
+    return;
+    }
+  vtkImageData* oldImageData = this->ImageData;
+  this->ImageData = imageData;
+  if (this->ImageData)
+    {
+    this->ImageData->Register(this);
+    }
+  if (oldImageData)
+    {
+    oldImageData->UnRegister(this);
+    }
+  this->Modified();
+}
+
+//----------------------------------------------------------------------------
+int vtkMRMLVolumeHistogram::GetNumberOfThreadsToUse()const
+{
+  return this->NumberOfThreads > 0 ?
+    this->NumberOfThreads : vtkMultiThreader::GetGlobalDefaultNumberOfThreads();
+}
+
+//----------------------------------------------------------------------------
+vtkIdType vtkMRMLVolumeHistogram::GetSampleStep(vtkIdType numberOfVoxels)const
+{
+  if (this->MaximumNumberOfSamples <= 0 ||
+      numberOfVoxels <= this->MaximumNumberOfSamples)
+    {
+    return 1;
+    }
+  return (numberOfVoxels + this->MaximumNumberOfSamples - 1) /
+    this->MaximumNumberOfSamples;
+}
+
+//----------------------------------------------------------------------------
+bool vtkMRMLVolumeHistogram::IsUpToDate(const vtkTimeStamp& computeTime)
+{
+  // vtkImageData::GetMTime() takes into account the scalars MTime.
+  return computeTime.GetMTime() > this->GetMTime() &&
+    this->ImageData && computeTime.GetMTime() > this->ImageData->GetMTime();
+}
+
+//----------------------------------------------------------------------------
+bool vtkMRMLVolumeHistogram::UpdateScalarHistogram()
+{
+  vtkDataArray* scalars = (this->ImageData && this->ImageData->GetPointData()) ?
+    this->ImageData->GetPointData()->GetScalars() : 0;
+  int dimensions[3] = {0, 0, 0};
+  if (this->ImageData)
+    {
+    this->ImageData->GetDimensions(dimensions);
+    }
+  const vtkIdType numberOfVoxels =
+    static_cast<vtkIdType>(dimensions[0]) * dimensions[1] * dimensions[2];
+  if (!scalars || numberOfVoxels == 0 ||
+      scalars->GetNumberOfTuples() != numberOfVoxels ||
+      this->Component < 0 || this->Component >= scalars->GetNumberOfComponents())
+    {
+    this->ScalarHistogram->SetNumberOfTuples(0);
+    this->GradientMagnitudeHistogram->SetNumberOfTuples(0);
+    this->JointHistogram->SetNumberOfTuples(0);
+    this->NumberOfSamples = 0;
+    this->ScalarHistogramTime = vtkTimeStamp();
+    this->GradientMagnitudeHistogramTime = vtkTimeStamp();
+    return false;
+    }
+  if (this->IsUpToDate(this->ScalarHistogramTime))
+    {
+    return true;
+    }
+
+  vtkMRMLVolumeHistogramThreadStruct str;
+  str.Scalars = scalars->GetVoidPointer(0);
+  str.ScalarType = scalars->GetDataType();
+  str.NumberOfComponents = scalars->GetNumberOfComponents();
+  str.Component = this->Component;
+  std::copy(dimensions, dimensions + 3, str.Dimensions);
+  this->ImageData->GetSpacing(str.Spacing);
+  str.NumberOfVoxels = numberOfVoxels;
+  str.GradientMagnitude = false;
+  str.Histogram = false;
+
+  // The scalar range is computed from all the voxels so that it is exact,
+  // only the histogram is computed from the samples.
+  str.SampleStep = 1;
+  str.NumberOfSamples = numberOfVoxels;
+  Execute(str, static_cast<int>(std::min(
+    static_cast<vtkIdType>(this->GetNumberOfThreadsToUse()), numberOfVoxels)),
+    this->ScalarRange);
+  if (this->ScalarRange[0] > this->ScalarRange[1])
+    {
+    // Only non finite values
+    this->ScalarRange[0] = 0.;
+    this->ScalarRange[1] = 0.;
+    }
+
+  str.SampleStep = this->GetSampleStep(numberOfVoxels);
+  str.NumberOfSamples = (numberOfVoxels + str.SampleStep - 1) / str.SampleStep;
+  const int numberOfThreads = static_cast<int>(std::min(
+    static_cast<vtkIdType>(this->GetNumberOfThreadsToUse()), str.NumberOfSamples));
+
+  // Integer scalars have bins of integer width so that every bin contains
+  // the same number of values.
+  const double rangeSize = this->ScalarRange[1] - this->ScalarRange[0];
+  const int maximumNumberOfBins = std::max(this->MaximumNumberOfScalarBins, 1);
+  this->ScalarBinOrigin = this->ScalarRange[0];
+  if (str.ScalarType != VTK_FLOAT && str.ScalarType != VTK_DOUBLE)
+    {
+    this->ScalarBinWidth = std::max(1., ceil((rangeSize + 1.) / maximumNumberOfBins));
+    str.NumberOfScalarBins = static_cast<int>(floor(rangeSize / this->ScalarBinWidth)) + 1;
+    }
+  else if (rangeSize > 0.)
+    {
+    this->ScalarBinWidth = rangeSize / maximumNumberOfBins;
+    str.NumberOfScalarBins = maximumNumberOfBins;
+    }
+  else
+    {
+    this->ScalarBinWidth = 1.;
+    str.NumberOfScalarBins = 1;
+    }
+  str.ScalarBinOrigin = this->ScalarBinOrigin;
+  str.ScalarBinWidth = this->ScalarBinWidth;
+  str.Histogram = true;
+  double range[2];
+  Execute(str, numberOfThreads, range);
+  CopyCounts(str.Counts[0], this->ScalarHistogram);
+
+  this->NumberOfSamples = str.NumberOfSamples;
+  this->ScalarHistogramTime.Modified();
+  vtkDebugMacro("UpdateScalarHistogram: " << str.NumberOfScalarBins
+                << " bins computed from " << str.NumberOfSamples << " samples");
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool vtkMRMLVolumeHistogram::UpdateGradientMagnitudeHistogram()
+{
+  if (!this->UpdateScalarHistogram())
+    {
+    return false;
+    }
+  if (this->IsUpToDate(this->GradientMagnitudeHistogramTime) &&
+      this->GradientMagnitudeHistogramTime > this->ScalarHistogramTime)
+    {
+    return true;
+    }
+
+  vtkDataArray* scalars = this->ImageData->GetPointData()->GetScalars();
+  vtkMRMLVolumeHistogramThreadStruct str;
+  str.Scalars = scalars->GetVoidPointer(0);
+  str.ScalarType = scalars->GetDataType();
+  str.NumberOfComponents = scalars->GetNumberOfComponents();
+  str.Component = this->Component;
+  this->ImageData->GetDimensions(str.Dimensions);
+  this->ImageData->GetSpacing(str.Spacing);
+  str.NumberOfVoxels = scalars->GetNumberOfTuples();
+  str.SampleStep = this->GetSampleStep(str.NumberOfVoxels);
+  str.NumberOfSamples = this->NumberOfSamples;
+  str.GradientMagnitude = true;
+  str.Histogram = false;
+  str.ScalarBinOrigin = this->ScalarBinOrigin;
+  str.ScalarBinWidth = this->ScalarBinWidth;
+  str.NumberOfScalarBins = static_cast<int>(this->ScalarHistogram->GetNumberOfTuples());
+  const int numberOfThreads = static_cast<int>(std::min(
+    static_cast<vtkIdType>(this->GetNumberOfThreadsToUse()), str.NumberOfSamples));
+
+  Execute(str, numberOfThreads, this->GradientMagnitudeRange);
+  if (this->GradientMagnitudeRange[0] > this->GradientMagnitudeRange[1])
+    {
+    this->GradientMagnitudeRange[0] = 0.;
+    this->GradientMagnitudeRange[1] = 0.;
+    }
+
+  str.NumberOfGradientMagnitudeBins = std::max(this->NumberOfGradientMagnitudeBins, 1);
+  this->GradientMagnitudeBinWidth = this->GradientMagnitudeRange[1] > 0. ?
+    this->GradientMagnitudeRange[1] / str.NumberOfGradientMagnitudeBins : 1.;
+  str.GradientMagnitudeBinWidth = this->GradientMagnitudeBinWidth;
+  this->JointHistogramDimensions[0] = std::max(1, std::min(
+    this->MaximumJointHistogramDimensions[0], str.NumberOfScalarBins));
+  this->JointHistogramDimensions[1] = std::max(1, std::min(
+    this->MaximumJointHistogramDimensions[1], str.NumberOfGradientMagnitudeBins));
+  str.JointHistogramDimensions[0] = this->JointHistogramDimensions[0];
+  str.JointHistogramDimensions[1] = this->JointHistogramDimensions[1];
+  str.Histogram = true;
+  double range[2];
+  Execute(str, numberOfThreads, range);
+  CopyCounts(str.Counts[0], this->GradientMagnitudeHistogram);
+  CopyCounts(str.JointCounts[0], this->JointHistogram);
+
+  this->GradientMagnitudeHistogramTime.Modified();
+  return true;
+}
+
+//----------------------------------------------------------------------------
+vtkIdTypeArray* vtkMRMLVolumeHistogram::GetScalarHistogram()
+{
+  this->UpdateScalarHistogram();
+  return this->ScalarHistogram;
+}
+
+//----------------------------------------------------------------------------
+double vtkMRMLVolumeHistogram::GetScalarBinOrigin()
+{
+  this->UpdateScalarHistogram();
+  return this->ScalarBinOrigin;
+}
+
+//----------------------------------------------------------------------------
+double vtkMRMLVolumeHistogram::GetScalarBinWidth()
+{
+  this->UpdateScalarHistogram();
+  return this->ScalarBinWidth;
+}
+
+//----------------------------------------------------------------------------
+bool vtkMRMLVolumeHistogram::GetScalarRange(double range[2])
+{
+  if (!this->UpdateScalarHistogram())
+    {
+    return false;
+    }
+  range[0] = this->ScalarRange[0];
+  range[1] = this->ScalarRange[1];
+  return true;
+}
+
+//----------------------------------------------------------------------------
+double vtkMRMLVolumeHistogram::GetScalarAtPercentile(double percentile)
+{
+  vtkIdTypeArray* histogram = this->GetScalarHistogram();
+  const vtkIdType numberOfBins = histogram->GetNumberOfTuples();
+  const vtkIdType* counts = numberOfBins ? histogram->GetPointer(0) : 0;
+  vtkIdType total = 0;
+  for (vtkIdType bin = 0; bin < numberOfBins; ++bin)
+    {
+    total += counts[bin];
+    }
+  if (total == 0)
+    {
+    return this->ScalarRange[0];
+    }
+  const double target = std::max(0., std::min(percentile, 100.)) * total / 100.;
+  double cumulated = 0.;
+  for (vtkIdType bin = 0; bin < numberOfBins; ++bin)
+    {
+    if (counts[bin] > 0 && cumulated + counts[bin] >= target)
+      {
+      const double value = this->ScalarBinOrigin + this->ScalarBinWidth *
+        (bin + (target - cumulated) / counts[bin]);
+      return std::max(this->ScalarRange[0], std::min(value, this->ScalarRange[1]));
+      }
+    cumulated += counts[bin];
+    }
+  return this->ScalarRange[1];
+}
+
+//----------------------------------------------------------------------------
+vtkIdTypeArray* vtkMRMLVolumeHistogram::GetGradientMagnitudeHistogram()
+{
+  this->UpdateGradientMagnitudeHistogram();
+  return this->GradientMagnitudeHistogram;
+}
+
+//----------------------------------------------------------------------------
+double vtkMRMLVolumeHistogram::GetGradientMagnitudeBinWidth()
+{
+  this->UpdateGradientMagnitudeHistogram();
+  return this->GradientMagnitudeBinWidth;
+}
+
+//----------------------------------------------------------------------------
+bool vtkMRMLVolumeHistogram::GetGradientMagnitudeRange(double range[2])
+{
+  if (!this->UpdateGradientMagnitudeHistogram())
+    {
+    return false;
+    }
+  range[0] = this->GradientMagnitudeRange[0];
+  range[1] = this->GradientMagnitudeRange[1];
+  return true;
+}
+
+//----------------------------------------------------------------------------
+vtkIdTypeArray* vtkMRMLVolumeHistogram::GetJointHistogram()
+{
+  this->UpdateGradientMagnitudeHistogram();
+  return this->JointHistogram;
+}
+
+//----------------------------------------------------------------------------
+void vtkMRMLVolumeHistogram::GetJointHistogramDimensions(int dimensions[2])
+{
+  this->UpdateGradientMagnitudeHistogram();
+  dimensions[0] = this->JointHistogramDimensions[0];
+  dimensions[1] = this->JointHistogramDimensions[1];
+}
+
+//----------------------------------------------------------------------------
+vtkIdType vtkMRMLVolumeHistogram::GetNumberOfSamples()
+{
+  this->UpdateScalarHistogram();
+  return this->NumberOfSamples;
+}
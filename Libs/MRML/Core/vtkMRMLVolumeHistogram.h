@@ -0,0 +1,169 @@
+/*=auto=========================================================================
+
+  Portions (c) Copyright 2005 Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Program:   3D Slicer
+
+=========================================================================auto=*/
+
+#ifndef __vtkMRMLVolumeHistogram_h
+#define __vtkMRMLVolumeHistogram_h
+
+// MRML includes
+#include "vtkMRML.h"
+
+// VTK includes
+#include <vtkObject.h>
+#include <vtkTimeStamp.h>
+class vtkIdTypeArray;
+class vtkImageData;
+
+/// \brief Cached histograms of the scalars of an image.
+///
+/// vtkMRMLVolumeHistogram computes the scalar histogram, the gradient
+/// magnitude histogram and the joint (2D) scalar/gradient magnitude histogram
+/// of one component of an image. The histograms are computed by multiple
+/// threads and are only recomputed when the image data (or its scalars) or
+/// the parameters are modified, so they can be shared by all the consumers
+/// of a volume (e.g. auto window/level, transfer function editing...).
+/// \sa vtkMRMLVolumeNode::GetHistogram()
+///
+/// The scalar histogram is computed with the finest resolution allowed by
+/// MaximumNumberOfScalarBins: integer images have bins of integer width (1
+/// when the scalar range allows it). Gradient magnitudes are computed with
+/// central differences (one-sided on the boundaries) using the image spacing.
+///
+/// When the image has more than MaximumNumberOfSamples voxels, the
+/// histograms are computed on a stratified subsample: the voxels are split in
+/// MaximumNumberOfSamples consecutive strata and one voxel per stratum is
+/// chosen pseudo-randomly (the choice is deterministic). The scalar range is
+/// always computed from all the voxels, the gradient magnitude range is
+/// the range of the samples.
+/// Non finite values (NaN, inf) are ignored.
+class VTK_MRML_EXPORT vtkMRMLVolumeHistogram : public vtkObject
+{
+public:
+  static vtkMRMLVolumeHistogram *New();
+  vtkTypeMacro(vtkMRMLVolumeHistogram,vtkObject);
+  void PrintSelf(ostream& os, vtkIndent indent);
+
+  /// Image the histograms are computed from.
+  void SetImageData(vtkImageData* imageData);
+  vtkGetObjectMacro(ImageData, vtkImageData);
+
+  /// Component of the scalars the histograms are computed from.
+  /// 0 by default.
+  vtkSetMacro(Component, int);
+  vtkGetMacro(Component, int);
+
+  /// Maximum number of bins of the scalar histogram.
+  /// 65536 by default.
+  vtkSetMacro(MaximumNumberOfScalarBins, int);
+  vtkGetMacro(MaximumNumberOfScalarBins, int);
+
+  /// Number of bins of the gradient magnitude histogram.
+  /// 1024 by default.
+  vtkSetMacro(NumberOfGradientMagnitudeBins, int);
+  vtkGetMacro(NumberOfGradientMagnitudeBins, int);
+
+  /// Maximum number of scalar (first) and gradient magnitude (second) bins of
+  /// the joint histogram. 256x256 by default.
+  vtkSetVector2Macro(MaximumJointHistogramDimensions, int);
+  vtkGetVector2Macro(MaximumJointHistogramDimensions, int);
+
+  /// Number of voxels above which the histograms are computed on a
+  /// subsample of the image (the scalar range is not). 0 means no
+  /// subsampling.
+  /// 16M (16777216) by default.
+  vtkSetMacro(MaximumNumberOfSamples, vtkIdType);
+  vtkGetMacro(MaximumNumberOfSamples, vtkIdType);
+
+  /// Number of threads used to compute the histograms.
+  /// If 0 (default), vtkMultiThreader::GetGlobalDefaultNumberOfThreads()
+  /// is used.
+  vtkSetMacro(NumberOfThreads, int);
+  vtkGetMacro(NumberOfThreads, int);
+
+  /// Compute the scalar histogram if it is not up-to-date.
+  /// Return false if there is no image or no scalars to compute it from.
+  bool UpdateScalarHistogram();
+
+  /// Compute the gradient magnitude and joint histograms if they are not
+  /// up-to-date. The scalar histogram is updated first.
+  /// Return false if there is no image or no scalars to compute it from.
+  bool UpdateGradientMagnitudeHistogram();
+
+  /// Scalar histogram, one tuple per bin. Bin \a i contains the samples in
+  /// [origin + i * width, origin + (i + 1) * width[.
+  /// The histogram is updated if needed.
+  /// \sa GetScalarBinOrigin(), GetScalarBinWidth()
+  vtkIdTypeArray* GetScalarHistogram();
+  double GetScalarBinOrigin();
+  double GetScalarBinWidth();
+  /// Range of the scalars of all the voxels, even if the histogram is
+  /// subsampled. Return false if there is no scalars.
+  bool GetScalarRange(double range[2]);
+
+  /// Return the scalar value under which \a percentile percent of the samples
+  /// are, interpolated within the bins. \a percentile is in [0, 100].
+  double GetScalarAtPercentile(double percentile);
+
+  /// Gradient magnitude histogram, starting at 0.
+  /// The histograms are updated if needed.
+  vtkIdTypeArray* GetGradientMagnitudeHistogram();
+  double GetGradientMagnitudeBinWidth();
+  bool GetGradientMagnitudeRange(double range[2]);
+
+  /// Joint histogram: the scalar bins are the fastest varying. The scalar
+  /// axis covers the same range as the scalar histogram and the gradient
+  /// magnitude axis the same range as the gradient magnitude histogram.
+  /// The histograms are updated if needed.
+  vtkIdTypeArray* GetJointHistogram();
+  void GetJointHistogramDimensions(int dimensions[2]);
+
+  /// Number of voxels the histograms are computed from, non finite values
+  /// included. It is lower than the number of voxels if the image has been
+  /// subsampled.
+  vtkIdType GetNumberOfSamples();
+
+protected:
+  vtkMRMLVolumeHistogram();
+  ~vtkMRMLVolumeHistogram();
+
+  int GetNumberOfThreadsToUse()const;
+  /// Return the step between two strata, 1 if all the voxels are sampled.
+  vtkIdType GetSampleStep(vtkIdType numberOfVoxels)const;
+  /// Return true if the histograms are up-to-date with \a computeTime.
+  bool IsUpToDate(const vtkTimeStamp& computeTime);
+
+  vtkImageData* ImageData;
+  int Component;
+  int MaximumNumberOfScalarBins;
+  int NumberOfGradientMagnitudeBins;
+  int MaximumJointHistogramDimensions[2];
+  vtkIdType MaximumNumberOfSamples;
+  int NumberOfThreads;
+
+  vtkIdTypeArray* ScalarHistogram;
+  double ScalarRange[2];
+  double ScalarBinOrigin;
+  double ScalarBinWidth;
+  vtkIdType NumberOfSamples;
+  vtkTimeStamp ScalarHistogramTime;
+
+  vtkIdTypeArray* GradientMagnitudeHistogram;
+  vtkIdTypeArray* JointHistogram;
+  double GradientMagnitudeRange[2];
+  double GradientMagnitudeBinWidth;
+  int JointHistogramDimensions[2];
+  vtkTimeStamp GradientMagnitudeHistogramTime;
+
+private:
+  vtkMRMLVolumeHistogram(const vtkMRMLVolumeHistogram&);  // Not implemented.
+  void operator=(const vtkMRMLVolumeHistogram&);  // Not implemented.
+};
+
+#endif
@@ -15,6 +15,7 @@ Version:   $Revision: 1.14 $
 // MRML includes
 #include "vtkEventBroker.h"
 #include "vtkMRMLScalarVolumeDisplayNode.h"
+#include "vtkMRMLVolumeHistogram.h"
 #include "vtkMRMLVolumeNode.h"
 #include "vtkMRMLTransformNode.h"
 
@@ -65,6 +66,7 @@ vtkMRMLVolumeNode::vtkMRMLVolumeNode()
 
   this->ImageDataConnection = NULL;
   this->DataEventForwarder = NULL;
+  this->Histogram = NULL;
 }
 
 //----------------------------------------------------------------------------
@@ -75,6 +77,10 @@ vtkMRMLVolumeNode::~vtkMRMLVolumeNode()
     {
     this->DataEventForwarder->Delete();
     }
+  if (this->Histogram)
+    {
+    this->Histogram->Delete();
+    }
 }
 
 //----------------------------------------------------------------------------
@@ -772,6 +778,11 @@ void vtkMRMLVolumeNode
     }
 
   this->SetImageDataToDisplayNodes();
+  if (this->Histogram)
+    {
+    // Don't keep the previous image data alive
+    this->Histogram->SetImageData(this->GetImageData());
+    }
 
   if (oldImageDataAlgorithm != NULL)
     {
@@ -785,6 +796,17 @@ void vtkMRMLVolumeNode
   this->InvokeEvent( vtkMRMLVolumeNode::ImageDataModifiedEvent , this);
 }
 
+//---------------------------------------------------------------------------
+vtkMRMLVolumeHistogram* vtkMRMLVolumeNode::GetHistogram()
+{
+  if (!this->Histogram)
+    {
+    this->Histogram = vtkMRMLVolumeHistogram::New();
+    }
+  this->Histogram->SetImageData(this->GetImageData());
+  return this->Histogram;
+}
+
 //---------------------------------------------------------------------------
 void vtkMRMLVolumeNode
 ::SetImageDataToDisplayNodes()
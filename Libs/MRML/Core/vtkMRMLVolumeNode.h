@@ -18,6 +18,7 @@
 // MRML includes
 #include "vtkMRMLDisplayableNode.h"
 class vtkMRMLVolumeDisplayNode;
+class vtkMRMLVolumeHistogram;
 
 // VTK includes
 class vtkAlgorithmOutput;
@@ -163,6 +164,12 @@ public:
   /// Return the input image data pipeline.
   vtkGetObjectMacro(ImageDataConnection, vtkAlgorithmOutput);
 
+  /// Histograms of the image data, shared by all the users of the volume.
+  /// The histograms are computed on demand and are cached until the image
+  /// data is modified.
+  /// \sa vtkMRMLVolumeHistogram
+  vtkMRMLVolumeHistogram* GetHistogram();
+
   ///
   /// alternative method to propagate events generated in Display nodes
   virtual void ProcessMRMLEvents ( vtkObject * /*caller*/,
@@ -220,6 +227,7 @@ protected:
 
   vtkAlgorithmOutput* ImageDataConnection;
   vtkEventForwarderCommand* DataEventForwarder;
+  vtkMRMLVolumeHistogram* Histogram;
 
   itk::MetaDataDictionary Dictionary;
 };
@@ -0,0 +1,261 @@
+/*=auto=========================================================================
+
+  Portions (c) Copyright 2005 Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Program:   3D Slicer
+
+=========================================================================auto=*/
+
+// MRMLIDImageIO includes
+#include "itkSharedMemoryImageIO.h"
+
+// ITK includes
+#include <itkImage.h>
+#include <itkImageFileReader.h>
+#include <itkImageFileWriter.h>
+#include <itkImageIOFactory.h>
+#include <itkVectorImage.h>
+
+// ITKSYS includes
+#include <itksys/SystemTools.hxx>
+
+// STD includes
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+
+#ifdef _WIN32
+# include <process.h>
+# define getpid _getpid
+#else
+# include <unistd.h>
+#endif
+
+namespace
+{
+
+typedef itk::Image<short, 3> ScalarImageType;
+typedef itk::VectorImage<float, 3> VectorImageType;
+
+//----------------------------------------------------------------------------
+// Image with a non trivial geometry
+template <class TImage>
+void InitializeImage(TImage* image, unsigned int numberOfComponents)
+{
+  typename TImage::SizeType size = {{7, 5, 3}};
+  typename TImage::RegionType region;
+  region.SetSize(size);
+  image->SetRegions(region);
+  image->SetNumberOfComponentsPerPixel(numberOfComponents);
+  image->Allocate();
+
+  typename TImage::SpacingType spacing;
+  spacing[0] = 0.5;
+  spacing[1] = 1.;
+  spacing[2] = 2.5;
+  image->SetSpacing(spacing);
+  typename TImage::PointType origin;
+  origin[0] = -10.;
+  origin[1] = 20.;
+  origin[2] = 3.5;
+  image->SetOrigin(origin);
+  typename TImage::DirectionType direction;
+  direction.Fill(0.);
+  direction[0][1] = 1.;
+  direction[1][0] = -1.;
+  direction[2][2] = 1.;
+  image->SetDirection(direction);
+}
+
+//----------------------------------------------------------------------------
+ScalarImageType::Pointer CreateScalarImage()
+{
+  ScalarImageType::Pointer image = ScalarImageType::New();
+  InitializeImage(image.GetPointer(), 1);
+  short* buffer = image->GetBufferPointer();
+  for (size_t i = 0; i < image->GetPixelContainer()->Size(); ++i)
+    {
+    buffer[i] = static_cast<short>(i * 37 - 500);
+    }
+  return image;
+}
+
+//----------------------------------------------------------------------------
+VectorImageType::Pointer CreateVectorImage()
+{
+  VectorImageType::Pointer image = VectorImageType::New();
+  InitializeImage(image.GetPointer(), 3);
+  float* buffer = image->GetBufferPointer();
+  for (size_t i = 0; i < image->GetPixelContainer()->Size(); ++i)
+    {
+    buffer[i] = static_cast<float>(i) * 0.25f - 10.f;
+    }
+  return image;
+}
+
+//----------------------------------------------------------------------------
+template <class TImage>
+bool CheckSameImage(int line, TImage* image, TImage* expected)
+{
+  if (image->GetLargestPossibleRegion() != expected->GetLargestPossibleRegion() ||
+      image->GetNumberOfComponentsPerPixel() != expected->GetNumberOfComponentsPerPixel())
+    {
+    std::cerr << "Line " << line << " - Wrong image size: "
+              << image->GetLargestPossibleRegion() << " instead of "
+              << expected->GetLargestPossibleRegion() << std::endl;
+    return false;
+    }
+  if (image->GetSpacing() != expected->GetSpacing() ||
+      image->GetOrigin() != expected->GetOrigin() ||
+      image->GetDirection() != expected->GetDirection())
+    {
+    std::cerr << "Line " << line << " - Wrong image geometry: "
+              << image->GetSpacing() << " " << image->GetOrigin() << " "
+              << image->GetDirection() << std::endl;
+    return false;
+    }
+  const size_t size = expected->GetPixelContainer()->Size();
+  for (size_t i = 0; i < size; ++i)
+    {
+    if (image->GetBufferPointer()[i] != expected->GetBufferPointer()[i])
+      {
+      std::cerr << "Line " << line << " - Wrong value " << i << ": "
+                << image->GetBufferPointer()[i] << " instead of "
+                << expected->GetBufferPointer()[i] << std::endl;
+      return false;
+      }
+    }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+// Write the image in a segment and read it back. If useFactory is true, the
+// ImageIO is created by the registered factories.
+template <class TImage>
+bool TestRoundTrip(int line, TImage* image, const std::string& fileName,
+                   bool useFactory)
+{
+  typedef itk::ImageFileWriter<TImage> WriterType;
+  typedef itk::ImageFileReader<TImage> ReaderType;
+  typename WriterType::Pointer writer = WriterType::New();
+  typename ReaderType::Pointer reader = ReaderType::New();
+  if (!useFactory)
+    {
+    writer->SetImageIO(itk::SharedMemoryImageIO::New());
+    reader->SetImageIO(itk::SharedMemoryImageIO::New());
+    }
+  try
+    {
+    writer->SetFileName(fileName);
+    writer->SetInput(image);
+    writer->Update();
+    reader->SetFileName(fileName);
+    reader->Update();
+    }
+  catch (itk::ExceptionObject& exception)
+    {
+    std::cerr << "Line " << line << " - Failed to exchange " << fileName
+              << ": " << exception << std::endl;
+    itk::SharedMemoryImageIO::RemoveSharedMemory(fileName);
+    return false;
+    }
+  if (!itk::SharedMemoryImageIO::RemoveSharedMemory(fileName))
+    {
+    std::cerr << "Line " << line << " - Failed to remove " << fileName << std::endl;
+    return false;
+    }
+  if (useFactory &&
+      strcmp(reader->GetImageIO()->GetNameOfClass(), "SharedMemoryImageIO") != 0)
+    {
+    std::cerr << "Line " << line << " - Wrong ImageIO: "
+              << reader->GetImageIO()->GetNameOfClass() << std::endl;
+    return false;
+    }
+  return CheckSameImage(line, reader->GetOutput(), image);
+}
+
+}
+
+//----------------------------------------------------------------------------
+int itkSharedMemoryImageIOTest1(int argc, char * argv [] )
+{
+  if (argc < 2)
+    {
+    std::cerr << "Usage: " << argv[0] << " <MRMLSharedMemoryIOPlugin directory>" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Only load the plugin under test
+  static std::string emptyAutoLoadPath("ITK_AUTOLOAD_PATH=");
+  itksys::SystemTools::PutEnv(const_cast<char*>(emptyAutoLoadPath.c_str()));
+
+  std::ostringstream segmentName;
+  segmentName << "SlicerTest" << getpid();
+  const std::string fileName =
+    itk::SharedMemoryImageIO::GetSharedMemoryFileName(segmentName.str());
+  if (!itk::SharedMemoryImageIO::IsSharedMemoryFileName(fileName) ||
+      itk::SharedMemoryImageIO::IsSharedMemoryFileName("slicer:shm#") ||
+      itk::SharedMemoryImageIO::IsSharedMemoryFileName("slicer:shm#a/b") ||
+      itk::SharedMemoryImageIO::IsSharedMemoryFileName("/tmp/image.nrrd"))
+    {
+    std::cerr << "Line " << __LINE__ << " - IsSharedMemoryFileName failed" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  if (!itk::SharedMemoryImageIO::IsSupported())
+    {
+    std::cout << "Shared memory is not supported on this platform" << std::endl;
+    itk::SharedMemoryImageIO::Pointer imageIO = itk::SharedMemoryImageIO::New();
+    if (imageIO->CanWriteFile(fileName.c_str()) ||
+        imageIO->CanReadFile(fileName.c_str()))
+      {
+      std::cerr << "Line " << __LINE__ << " - Unsupported IO can read or write" << std::endl;
+      return EXIT_FAILURE;
+      }
+    return EXIT_SUCCESS;
+    }
+
+  // Round trip through the ImageIO
+  ScalarImageType::Pointer scalarImage = CreateScalarImage();
+  VectorImageType::Pointer vectorImage = CreateVectorImage();
+  if (!TestRoundTrip(__LINE__, scalarImage.GetPointer(), fileName, false) ||
+      !TestRoundTrip(__LINE__, vectorImage.GetPointer(), fileName, false))
+    {
+    return EXIT_FAILURE;
+    }
+
+  // A removed segment can't be read anymore
+  itk::SharedMemoryImageIO::Pointer imageIO = itk::SharedMemoryImageIO::New();
+  if (imageIO->CanReadFile(fileName.c_str()) ||
+      itk::SharedMemoryImageIO::RemoveSharedMemory(fileName))
+    {
+    std::cerr << "Line " << __LINE__ << " - Segment not removed" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Without the plugin, no ImageIO can write the segment
+  if (itk::ImageIOFactory::CreateImageIO(fileName.c_str(),
+                                         itk::ImageIOFactory::WriteMode).IsNotNull())
+    {
+    std::cerr << "Line " << __LINE__ << " - Unexpected ImageIO" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Round trip through the ImageIO created by the plugin, the same way the
+  // CLI executables load it.
+  static std::string pluginAutoLoadPath;
+  pluginAutoLoadPath = std::string("ITK_AUTOLOAD_PATH=") + argv[1];
+  itksys::SystemTools::PutEnv(const_cast<char*>(pluginAutoLoadPath.c_str()));
+  itk::ObjectFactoryBase::ReHash();
+  if (!TestRoundTrip(__LINE__, scalarImage.GetPointer(), fileName, true) ||
+      !TestRoundTrip(__LINE__, vectorImage.GetPointer(), fileName, true))
+    {
+    return EXIT_FAILURE;
+    }
+
+  return EXIT_SUCCESS;
+}
@@ -105,7 +105,7 @@ MRMLIDImageIO
       }
 
     // now pull off the scene
-    vtkMRMLScene *scene;
+    vtkMRMLScene *scene = 0;
     hloc = fname.find("#", loc);
     if (hloc == std::string::npos)
       {
@@ -136,6 +136,10 @@ MRMLIDImageIO
     // so far so good.  now lookup the node in the scene and see if we
     // can cast down to a MRMLVolumeNode
     //
+    if (!scene)
+      {
+      return 0;
+      }
     vtkMRMLNode *node = scene->GetNodeByID(this->NodeID.c_str());
 
     if (node)
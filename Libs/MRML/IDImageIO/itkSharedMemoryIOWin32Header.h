@@ -0,0 +1,31 @@
+/*=auto=========================================================================
+
+  Portions (c) Copyright 2005 Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Program:   3D MRML
+
+=========================================================================auto=*/
+///  itkSharedMemoryIOWin32Header - manage Windows system differences
+///
+/// The itkSharedMemoryIOWin32Header captures some system differences between Unix
+/// and Windows operating systems.
+
+#ifndef __itkSharedMemoryIOWin32Header_h
+#define __itkSharedMemoryIOWin32Header_h
+
+#include <itkMRMLIDImageIOConfigure.h>
+
+#if defined(WIN32) && !defined(MRMLIDIO_STATIC)
+#if defined(MRMLSharedMemoryIO_EXPORTS)
+#define MRMLSharedMemoryIO_EXPORT __declspec( dllexport )
+#else
+#define MRMLSharedMemoryIO_EXPORT __declspec( dllimport )
+#endif
+#else
+#define MRMLSharedMemoryIO_EXPORT
+#endif
+
+#endif
@@ -0,0 +1,382 @@
+/*=auto=========================================================================
+
+  Portions (c) Copyright 2005 Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Program:   MRML
+
+=========================================================================auto=*/
+
+#include "itkSharedMemoryImageIO.h"
+
+// STD includes
+#include <algorithm>
+#include <cstring>
+
+#ifdef MRMLIDIO_HAVE_SHM_OPEN
+# include <fcntl.h>
+# include <sys/mman.h>
+# include <sys/stat.h>
+# include <unistd.h>
+#endif
+
+namespace
+{
+
+const char SharedMemoryFileNamePrefix[] = "slicer:shm#";
+const char SharedMemoryMagic[8] = "SLCRSHM";
+const unsigned int SharedMemoryVersion = 1;
+const unsigned int SharedMemoryMaximumDimension = 4;
+
+//----------------------------------------------------------------------------
+// Layout of the beginning of a segment. The pixel buffer follows the header
+// at GetDataOffset().
+struct SharedMemoryImageHeader
+{
+  char Magic[8];
+  unsigned int Version;
+  unsigned int NumberOfDimensions;
+  unsigned int PixelType;
+  unsigned int ComponentType;
+  unsigned int NumberOfComponents;
+  unsigned int Reserved;
+  unsigned long long Dimensions[SharedMemoryMaximumDimension];
+  double Spacing[SharedMemoryMaximumDimension];
+  double Origin[SharedMemoryMaximumDimension];
+  double Direction[SharedMemoryMaximumDimension * SharedMemoryMaximumDimension];
+  unsigned long long DataSize;
+};
+
+//----------------------------------------------------------------------------
+// Keep the pixel buffer 64-byte aligned
+size_t GetDataOffset()
+{
+  return ((sizeof(SharedMemoryImageHeader) + 63) / 64) * 64;
+}
+
+//----------------------------------------------------------------------------
+// Return the POSIX name of the segment ("/<segment name>") or an empty
+// string if the filename does not designate a segment.
+std::string GetSegmentName(const std::string& fileName)
+{
+  const size_t prefixLength = sizeof(SharedMemoryFileNamePrefix) - 1;
+  if (fileName.compare(0, prefixLength, SharedMemoryFileNamePrefix) != 0 ||
+      fileName.size() == prefixLength ||
+      fileName.find('/', prefixLength) != std::string::npos)
+    {
+    return std::string();
+    }
+  return std::string("/") + fileName.substr(prefixLength);
+}
+
+//----------------------------------------------------------------------------
+// Memory mapping of a segment, unmapped when the object is destroyed.
+class SharedMemorySegment
+{
+public:
+  SharedMemorySegment()
+    : Address(0), Size(0)
+  {
+  }
+  ~SharedMemorySegment()
+  {
+    this->Close();
+  }
+
+  /// Map an existing segment in read-only mode.
+  bool Open(const std::string& segmentName)
+  {
+    this->Close();
+#ifdef MRMLIDIO_HAVE_SHM_OPEN
+    int fd = shm_open(segmentName.c_str(), O_RDONLY, 0);
+    if (fd == -1)
+      {
+      return false;
+      }
+    struct stat status;
+    if (fstat(fd, &status) == 0 &&
+        static_cast<size_t>(status.st_size) >= GetDataOffset())
+      {
+      this->Map(fd, static_cast<size_t>(status.st_size), PROT_READ);
+      }
+    close(fd);
+#else
+    (void)segmentName;
+#endif
+    return this->Address != 0;
+  }
+
+  /// Create a new segment of the given size, replacing any existing segment
+  /// with the same name, and map it in read-write mode.
+  bool Create(const std::string& segmentName, size_t size)
+  {
+    this->Close();
+#ifdef MRMLIDIO_HAVE_SHM_OPEN
+    // Unlink first so that a process still reading a previous segment with
+    // the same name keeps its own copy.
+    shm_unlink(segmentName.c_str());
+    int fd = shm_open(segmentName.c_str(), O_RDWR | O_CREAT | O_EXCL,
+                      S_IRUSR | S_IWUSR);
+    if (fd == -1)
+      {
+      return false;
+      }
+    if (ftruncate(fd, static_cast<off_t>(size)) == 0)
+      {
+      this->Map(fd, size, PROT_READ | PROT_WRITE);
+      }
+    close(fd);
+    if (!this->Address)
+      {
+      shm_unlink(segmentName.c_str());
+      }
+#else
+    (void)segmentName;
+    (void)size;
+#endif
+    return this->Address != 0;
+  }
+
+  void Close()
+  {
+#ifdef MRMLIDIO_HAVE_SHM_OPEN
+    if (this->Address)
+      {
+      munmap(this->Address, this->Size);
+      }
+#endif
+    this->Address = 0;
+    this->Size = 0;
+  }
+
+  const SharedMemoryImageHeader* GetHeader() const
+  {
+    return reinterpret_cast<const SharedMemoryImageHeader*>(this->Address);
+  }
+
+  bool IsValid() const
+  {
+    const SharedMemoryImageHeader* header = this->GetHeader();
+    return header &&
+           memcmp(header->Magic, SharedMemoryMagic, sizeof(SharedMemoryMagic)) == 0 &&
+           header->Version == SharedMemoryVersion &&
+           header->NumberOfDimensions <= SharedMemoryMaximumDimension &&
+           GetDataOffset() + header->DataSize <= this->Size;
+  }
+
+  void* Address;
+  size_t Size;
+
+private:
+#ifdef MRMLIDIO_HAVE_SHM_OPEN
+  void Map(int fd, size_t size, int protection)
+  {
+    void* address = mmap(0, size, protection, MAP_SHARED, fd, 0);
+    if (address != MAP_FAILED)
+      {
+      this->Address = address;
+      this->Size = size;
+      }
+  }
+#endif
+};
+
+}
+
+namespace itk
+{
+
+//----------------------------------------------------------------------------
+SharedMemoryImageIO::SharedMemoryImageIO()
+{
+}
+
+//----------------------------------------------------------------------------
+SharedMemoryImageIO::~SharedMemoryImageIO()
+{
+}
+
+//----------------------------------------------------------------------------
+bool SharedMemoryImageIO::IsSupported()
+{
+#ifdef MRMLIDIO_HAVE_SHM_OPEN
+  return true;
+#else
+  return false;
+#endif
+}
+
+//----------------------------------------------------------------------------
+bool SharedMemoryImageIO::IsSharedMemoryFileName(const std::string& fileName)
+{
+  return !GetSegmentName(fileName).empty();
+}
+
+//----------------------------------------------------------------------------
+std::string SharedMemoryImageIO::GetSharedMemoryFileName(const std::string& segmentName)
+{
+  return std::string(SharedMemoryFileNamePrefix) + segmentName;
+}
+
+//----------------------------------------------------------------------------
+bool SharedMemoryImageIO::RemoveSharedMemory(const std::string& fileName)
+{
+  std::string segmentName = GetSegmentName(fileName);
+  if (segmentName.empty())
+    {
+    return false;
+    }
+#ifdef MRMLIDIO_HAVE_SHM_OPEN
+  return shm_unlink(segmentName.c_str()) == 0;
+#else
+  return false;
+#endif
+}
+
+//----------------------------------------------------------------------------
+void SharedMemoryImageIO::CopyImageInformation(const ImageIOBase* source)
+{
+  if (!source)
+    {
+    return;
+    }
+  this->SetNumberOfDimensions(source->GetNumberOfDimensions());
+  for (unsigned int i = 0; i < source->GetNumberOfDimensions(); ++i)
+    {
+    this->SetDimensions(i, source->GetDimensions(i));
+    this->SetSpacing(i, source->GetSpacing(i));
+    this->SetOrigin(i, source->GetOrigin(i));
+    this->SetDirection(i, source->GetDirection(i));
+    }
+  this->SetPixelType(source->GetPixelType());
+  this->SetComponentType(source->GetComponentType());
+  this->SetNumberOfComponents(source->GetNumberOfComponents());
+}
+
+//----------------------------------------------------------------------------
+bool SharedMemoryImageIO::CanReadFile(const char* fileName)
+{
+  if (!fileName || !SharedMemoryImageIO::IsSupported())
+    {
+    return false;
+    }
+  std::string segmentName = GetSegmentName(fileName);
+  if (segmentName.empty())
+    {
+    return false;
+    }
+  SharedMemorySegment segment;
+  return segment.Open(segmentName) && segment.IsValid();
+}
+
+//----------------------------------------------------------------------------
+void SharedMemoryImageIO::ReadImageInformation()
+{
+  SharedMemorySegment segment;
+  if (!segment.Open(GetSegmentName(m_FileName)) || !segment.IsValid())
+    {
+    itkExceptionMacro("Unable to open shared memory image " << m_FileName);
+    }
+  const SharedMemoryImageHeader* header = segment.GetHeader();
+
+  this->SetNumberOfDimensions(header->NumberOfDimensions);
+  for (unsigned int i = 0; i < header->NumberOfDimensions; ++i)
+    {
+    this->SetDimensions(i, static_cast<SizeValueType>(header->Dimensions[i]));
+    this->SetSpacing(i, header->Spacing[i]);
+    this->SetOrigin(i, header->Origin[i]);
+    std::vector<double> direction(header->NumberOfDimensions);
+    for (unsigned int j = 0; j < header->NumberOfDimensions; ++j)
+      {
+      direction[j] = header->Direction[i * SharedMemoryMaximumDimension + j];
+      }
+    this->SetDirection(i, direction);
+    }
+  this->SetPixelType(static_cast<IOPixelType>(header->PixelType));
+  this->SetComponentType(static_cast<IOComponentType>(header->ComponentType));
+  this->SetNumberOfComponents(header->NumberOfComponents);
+}
+
+//----------------------------------------------------------------------------
+void SharedMemoryImageIO::Read(void* buffer)
+{
+  SharedMemorySegment segment;
+  if (!segment.Open(GetSegmentName(m_FileName)) || !segment.IsValid())
+    {
+    itkExceptionMacro("Unable to open shared memory image " << m_FileName);
+    }
+  const SharedMemoryImageHeader* header = segment.GetHeader();
+  if (header->DataSize != this->GetImageSizeInBytes())
+    {
+    itkExceptionMacro("Shared memory image " << m_FileName << " has "
+                      << header->DataSize << " bytes instead of "
+                      << this->GetImageSizeInBytes());
+    }
+  memcpy(buffer,
+         static_cast<const char*>(segment.Address) + GetDataOffset(),
+         static_cast<size_t>(header->DataSize));
+}
+
+//----------------------------------------------------------------------------
+bool SharedMemoryImageIO::CanWriteFile(const char* fileName)
+{
+  return fileName && SharedMemoryImageIO::IsSupported() &&
+         SharedMemoryImageIO::IsSharedMemoryFileName(fileName);
+}
+
+//----------------------------------------------------------------------------
+void SharedMemoryImageIO::WriteImageInformation()
+{
+}
+
+//----------------------------------------------------------------------------
+void SharedMemoryImageIO::Write(const void* buffer)
+{
+  if (this->GetNumberOfDimensions() > SharedMemoryMaximumDimension)
+    {
+    itkExceptionMacro("Shared memory images are limited to "
+                      << SharedMemoryMaximumDimension << " dimensions");
+    }
+  const unsigned long long dataSize = this->GetImageSizeInBytes();
+  SharedMemorySegment segment;
+  if (!segment.Create(GetSegmentName(m_FileName),
+                      GetDataOffset() + static_cast<size_t>(dataSize)))
+    {
+    itkExceptionMacro("Unable to create shared memory image " << m_FileName);
+    }
+
+  SharedMemoryImageHeader* header =
+    reinterpret_cast<SharedMemoryImageHeader*>(segment.Address);
+  memset(header, 0, sizeof(SharedMemoryImageHeader));
+  memcpy(header->Magic, SharedMemoryMagic, sizeof(SharedMemoryMagic));
+  header->Version = SharedMemoryVersion;
+  header->NumberOfDimensions = this->GetNumberOfDimensions();
+  header->PixelType = static_cast<unsigned int>(this->GetPixelType());
+  header->ComponentType = static_cast<unsigned int>(this->GetComponentType());
+  header->NumberOfComponents = this->GetNumberOfComponents();
+  for (unsigned int i = 0; i < this->GetNumberOfDimensions(); ++i)
+    {
+    header->Dimensions[i] = this->GetDimensions(i);
+    header->Spacing[i] = this->GetSpacing(i);
+    header->Origin[i] = this->GetOrigin(i);
+    std::vector<double> direction = this->GetDirection(i);
+    for (unsigned int j = 0; j < direction.size() && j < SharedMemoryMaximumDimension; ++j)
+      {
+      header->Direction[i * SharedMemoryMaximumDimension + j] = direction[j];
+      }
+    }
+  header->DataSize = dataSize;
+  memcpy(static_cast<char*>(segment.Address) + GetDataOffset(), buffer,
+         static_cast<size_t>(dataSize));
+}
+
+//----------------------------------------------------------------------------
+void SharedMemoryImageIO::PrintSelf(std::ostream& os, Indent indent) const
+{
+  Superclass::PrintSelf(os, indent);
+  os << indent << "Supported: " << (SharedMemoryImageIO::IsSupported() ? "true" : "false") << std::endl;
+}
+
+} // end namespace itk
@@ -0,0 +1,117 @@
+/*=auto=========================================================================
+
+  Portions (c) Copyright 2005 Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Program:   MRML
+
+=========================================================================auto=*/
+
+#ifndef __itkSharedMemoryImageIO_h
+#define __itkSharedMemoryImageIO_h
+
+#ifdef _MSC_VER
+#pragma warning ( disable : 4786 )
+#endif
+
+#include "itkSharedMemoryIOWin32Header.h"
+
+#include "itkImageIOBase.h"
+
+namespace itk
+{
+/** \class SharedMemoryImageIO
+ * \brief ImageIO object for exchanging images between processes through
+ * shared memory.
+ *
+ * SharedMemoryImageIO reads and writes images in named POSIX shared
+ * memory segments (shm_open/mmap) instead of files. It is used to pass
+ * the images between Slicer and the command line modules it runs as
+ * separate executables without going through the disk. The segment
+ * contains a small header with the image information (dimensions,
+ * spacing, origin, direction and pixel type) followed by the pixel buffer.
+ * The meta-data dictionary is not transferred.
+ *
+ * The "filename" specified looks like:
+ *     <code>slicer:shm#\<segment name\></code>
+ *
+ * On platforms without POSIX shared memory, CanReadFile() and
+ * CanWriteFile() always return false so that the caller can fall back
+ * to files.
+ *
+ * \sa MRMLIDImageIO
+ */
+class MRMLSharedMemoryIO_EXPORT SharedMemoryImageIO : public ImageIOBase
+{
+public:
+  /** Standard class typedefs. */
+  typedef SharedMemoryImageIO  Self;
+  typedef ImageIOBase          Superclass;
+  typedef SmartPointer<Self>   Pointer;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro(Self);
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro(SharedMemoryImageIO, ImageIOBase);
+
+  /** Return true if shared memory segments are supported on this
+   * platform. */
+  static bool IsSupported();
+
+  /** Return true if the filename designates a shared memory segment. */
+  static bool IsSharedMemoryFileName(const std::string& fileName);
+
+  /** Return the filename designating the segment with the given name.
+   * The name must be a short (less than 30 characters on Mac OS X)
+   * string without any '/'. */
+  static std::string GetSharedMemoryFileName(const std::string& segmentName);
+
+  /** Remove the segment designated by the filename. The memory is
+   * released when no process has it mapped anymore.
+   * Returns true if the segment existed and has been removed. */
+  static bool RemoveSharedMemory(const std::string& fileName);
+
+  /** Copy the dimensions, spacing, origin, direction, pixel type and
+   * component type from another ImageIO. This is useful to write a
+   * buffer described by an ImageIO that has read its image information. */
+  void CopyImageInformation(const ImageIOBase* source);
+
+  /** Determine the file type. Returns true if this ImageIO can read the
+   * file specified. */
+  virtual bool CanReadFile(const char*) ITK_OVERRIDE;
+
+  /** Set the spacing and dimension information for the set filename. */
+  virtual void ReadImageInformation() ITK_OVERRIDE;
+
+  /** Reads the data from the shared memory into the buffer provided. */
+  virtual void Read(void* buffer) ITK_OVERRIDE;
+
+  /*-------- This part of the interfaces deals with writing data. ----- */
+
+  /** Determine the file type. Returns true if this ImageIO can write the
+   * file specified. */
+  virtual bool CanWriteFile(const char*) ITK_OVERRIDE;
+
+  /** The image information is written with the data in Write(). */
+  virtual void WriteImageInformation() ITK_OVERRIDE;
+
+  /** Create the shared memory segment and copy the image information and
+   * the buffer into it. An existing segment with the same name is
+   * replaced. */
+  virtual void Write(const void* buffer) ITK_OVERRIDE;
+
+protected:
+  SharedMemoryImageIO();
+  ~SharedMemoryImageIO();
+  void PrintSelf(std::ostream& os, Indent indent) const ITK_OVERRIDE;
+
+private:
+  SharedMemoryImageIO(const Self&); //purposely not implemented
+  void operator=(const Self&); //purposely not implemented
+};
+
+} /// end namespace itk
+#endif /// __itkSharedMemoryImageIO_h
@@ -0,0 +1,45 @@
+/*=========================================================================
+
+  Program:   Insight Segmentation & Registration Toolkit
+  Language:  C++
+
+  Copyright (c) Insight Software Consortium. All rights reserved.
+  See ITKCopyright.txt or http://www.itk.org/HTML/Copyright.htm for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+#include "itkSharedMemoryImageIOFactory.h"
+#include "itkVersion.h"
+
+
+namespace itk
+{
+SharedMemoryImageIOFactory::SharedMemoryImageIOFactory()
+{
+  this->RegisterOverride("itkImageIOBase",
+                         "itkSharedMemoryImageIO",
+                         "ImageIO to exchange images through shared memory.",
+                         1,
+                         CreateObjectFunction<SharedMemoryImageIO>::New());
+}
+
+SharedMemoryImageIOFactory::~SharedMemoryImageIOFactory()
+{
+}
+
+const char*
+SharedMemoryImageIOFactory::GetITKSourceVersion(void) const
+{
+  return ITK_SOURCE_VERSION;
+}
+
+const char*
+SharedMemoryImageIOFactory::GetDescription() const
+{
+  return "ImageIOFactory that imports/exports data to a shared memory segment.";
+}
+
+} // end namespace itk
@@ -0,0 +1,69 @@
+/*=========================================================================
+
+  Program:   Insight Segmentation & Registration Toolkit
+  Language:  C++
+
+  Copyright (c) Insight Software Consortium. All rights reserved.
+  See ITKCopyright.txt or http://www.itk.org/HTML/Copyright.htm for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+#ifndef __itkSharedMemoryImageIOFactory_h
+#define __itkSharedMemoryImageIOFactory_h
+
+#include "itkObjectFactoryBase.h"
+#include "itkImageIOBase.h"
+
+#include "itkSharedMemoryImageIO.h"
+
+#include "itkSharedMemoryIOWin32Header.h"
+
+namespace itk
+{
+/** \class SharedMemoryImageIOFactory
+ * \brief Create instances of SharedMemoryImageIO objects using an object factory.
+ */
+class MRMLSharedMemoryIO_EXPORT SharedMemoryImageIOFactory : public ObjectFactoryBase
+{
+public:
+  /** Standard class typedefs. */
+  typedef SharedMemoryImageIOFactory   Self;
+  typedef ObjectFactoryBase  Superclass;
+  typedef SmartPointer<Self>  Pointer;
+  typedef SmartPointer<const Self>  ConstPointer;
+
+  /** Class methods used to interface with the registered factories. */
+  virtual const char* GetITKSourceVersion(void) const ITK_OVERRIDE;
+  virtual const char* GetDescription(void) const ITK_OVERRIDE;
+
+  /** Method for class instantiation. */
+  itkFactorylessNewMacro(Self);
+  static SharedMemoryImageIOFactory* FactoryNew() { return new SharedMemoryImageIOFactory;}
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro(SharedMemoryImageIOFactory, ObjectFactoryBase);
+
+  /** Register one factory of this type  */
+  static void RegisterOneFactory(void)
+  {
+    SharedMemoryImageIOFactory::Pointer factory = SharedMemoryImageIOFactory::New();
+    ObjectFactoryBase::RegisterFactory(factory);
+  }
+
+protected:
+  SharedMemoryImageIOFactory();
+  ~SharedMemoryImageIOFactory();
+
+private:
+  SharedMemoryImageIOFactory(const Self&); //purposely not implemented
+  void operator=(const Self&); //purposely not implemented
+
+};
+
+
+} /// end namespace itk
+
+#endif
@@ -0,0 +1,238 @@
+/*=auto=========================================================================
+
+  Portions (c) Copyright 2005 Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Program:   3D Slicer
+
+=========================================================================auto=*/
+
+// MRMLLogic includes
+#include "vtkImageResliceMapToColors.h"
+
+// MRML includes
+#include "vtkMRMLColorTableNode.h"
+#include "vtkMRMLCoreTestingMacros.h"
+#include "vtkMRMLScalarVolumeDisplayNode.h"
+#include "vtkMRMLScene.h"
+
+// VTK includes
+#include <vtkAlgorithmOutput.h>
+#include <vtkImageData.h>
+#include <vtkImageReslice.h>
+#include <vtkMatrix4x4.h>
+#include <vtkNew.h>
+#include <vtkTimerLog.h>
+#include <vtkTransform.h>
+
+// STD includes
+#include <cstdlib>
+#include <iostream>
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+void CreateVolume(vtkImageData* imageData)
+{
+  imageData->SetExtent(0, 127, 0, 99, 0, 19);
+  imageData->SetSpacing(0.9, 1.1, 2.0);
+  imageData->SetOrigin(-10., 5., 3.);
+  imageData->AllocateScalars(VTK_SHORT, 1);
+  short* ptr = static_cast<short*>(imageData->GetScalarPointer());
+  for (int k = 0; k < 20; ++k)
+    {
+    for (int j = 0; j < 100; ++j)
+      {
+      for (int i = 0; i < 128; ++i)
+        {
+        *ptr++ = static_cast<short>(((i * 7 + j * 13 + k * 29) % 400) - 100);
+        }
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+// Oblique slice through the volume that is partially outside of the volume
+void CreateResliceMatrix(vtkMatrix4x4* matrix, int dimension)
+{
+  vtkNew<vtkTransform> transform;
+  transform->Translate(-23.3, 1.7, 19.1);
+  transform->RotateZ(30.);
+  transform->RotateX(10.);
+  transform->Scale(150. / dimension, 140. / dimension, 1.);
+  matrix->DeepCopy(transform->GetMatrix());
+}
+
+//----------------------------------------------------------------------------
+// Percentage of the pixels whose color is different
+double CompareImages(vtkImageData* image1, vtkImageData* image2)
+{
+  int* dims1 = image1->GetDimensions();
+  int* dims2 = image2->GetDimensions();
+  if (dims1[0] != dims2[0] || dims1[1] != dims2[1] || dims1[2] != dims2[2] ||
+      image1->GetNumberOfScalarComponents() != 4 ||
+      image2->GetNumberOfScalarComponents() != 4 ||
+      image1->GetScalarType() != VTK_UNSIGNED_CHAR ||
+      image2->GetScalarType() != VTK_UNSIGNED_CHAR)
+    {
+    std::cerr << "Images of different format" << std::endl;
+    return 100.;
+    }
+  const vtkIdType numberOfPixels =
+    static_cast<vtkIdType>(dims1[0]) * dims1[1] * dims1[2];
+  const unsigned char* ptr1 = static_cast<unsigned char*>(image1->GetScalarPointer());
+  const unsigned char* ptr2 = static_cast<unsigned char*>(image2->GetScalarPointer());
+  vtkIdType differences = 0;
+  for (vtkIdType i = 0; i < numberOfPixels; ++i, ptr1 += 4, ptr2 += 4)
+    {
+    // the color of transparent pixels does not matter
+    if (ptr1[3] != ptr2[3] ||
+        (ptr1[3] != 0 && (ptr1[0] != ptr2[0] || ptr1[1] != ptr2[1] || ptr1[2] != ptr2[2])))
+      {
+      ++differences;
+      }
+    }
+  return 100. * differences / numberOfPixels;
+}
+
+//----------------------------------------------------------------------------
+// Compare the fused filter with the reference pipeline on a slice of
+// dimension x dimension pixels. Both are run \a iterations times, their
+// average timings are printed if printTimings is true.
+int TestFusedReslice(bool linear, int dimension, int iterations, bool printTimings)
+{
+  vtkNew<vtkImageData> volume;
+  CreateVolume(volume.GetPointer());
+  vtkNew<vtkMatrix4x4> resliceMatrix;
+  CreateResliceMatrix(resliceMatrix.GetPointer(), dimension);
+
+  // Reference: reslice and display node pipeline as in vtkMRMLSliceLayerLogic
+  vtkNew<vtkImageReslice> reslice;
+  reslice->SetBackgroundColor(0, 0, 0, 0);
+  reslice->AutoCropOutputOff();
+  reslice->SetOptimization(1);
+  reslice->SetOutputOrigin(0, 0, 0);
+  reslice->SetOutputSpacing(1, 1, 1);
+  reslice->SetOutputDimensionality(3);
+  reslice->GenerateStencilOutputOn();
+  reslice->SetOutputExtent(0, dimension - 1, 0, dimension - 1, 0, 0);
+  vtkNew<vtkTransform> resliceTransform;
+  resliceTransform->SetMatrix(resliceMatrix.GetPointer());
+  reslice->SetResliceTransform(resliceTransform.GetPointer());
+  reslice->SetInterpolationMode(linear ? VTK_RESLICE_LINEAR : VTK_RESLICE_NEAREST);
+  reslice->SetInputData(volume.GetPointer());
+
+  vtkNew<vtkMRMLScene> scene;
+  vtkNew<vtkMRMLColorTableNode> colorNode;
+  colorNode->SetTypeToOcean();
+  scene->AddNode(colorNode.GetPointer());
+  vtkNew<vtkMRMLScalarVolumeDisplayNode> displayNode;
+  scene->AddNode(displayNode.GetPointer());
+  displayNode->SetAndObserveColorNodeID(colorNode->GetID());
+  displayNode->SetAutoWindowLevel(0);
+  displayNode->SetAutoThreshold(0);
+  displayNode->SetWindowLevel(200., 50.);
+  displayNode->SetThreshold(-20., 150.);
+  displayNode->ApplyThresholdOn();
+  displayNode->SetInputImageDataConnection(reslice->GetOutputPort());
+  displayNode->SetBackgroundImageStencilDataConnection(reslice->GetOutputPort(1));
+
+  vtkNew<vtkImageResliceMapToColors> resliceMapToColors;
+  resliceMapToColors->SetInputData(volume.GetPointer());
+  resliceMapToColors->SetResliceMatrix(resliceMatrix.GetPointer());
+  resliceMapToColors->SetOutputExtent(0, dimension - 1, 0, dimension - 1, 0, 0);
+  resliceMapToColors->SetInterpolationMode(
+    linear ? VTK_RESLICE_LINEAR : VTK_RESLICE_NEAREST);
+  resliceMapToColors->SetWindow(displayNode->GetWindow());
+  resliceMapToColors->SetLevel(displayNode->GetLevel());
+  resliceMapToColors->SetApplyThreshold(displayNode->GetApplyThreshold());
+  resliceMapToColors->SetLowerThreshold(displayNode->GetLowerThreshold());
+  resliceMapToColors->SetUpperThreshold(displayNode->GetUpperThreshold());
+  resliceMapToColors->SetLookupTable(colorNode->GetScalarsToColors());
+
+  vtkAlgorithm* displayPipeline =
+    displayNode->GetOutputImageDataConnection()->GetProducer();
+  vtkNew<vtkTimerLog> timer;
+  timer->StartTimer();
+  for (int i = 0; i < iterations; ++i)
+    {
+    reslice->Modified();
+    displayPipeline->Update();
+    }
+  timer->StopTimer();
+  const double pipelineTime = timer->GetElapsedTime() / iterations;
+
+  timer->StartTimer();
+  for (int i = 0; i < iterations; ++i)
+    {
+    resliceMapToColors->Modified();
+    resliceMapToColors->Update();
+    }
+  timer->StopTimer();
+  const double fusedTime = timer->GetElapsedTime() / iterations;
+
+  if (printTimings)
+    {
+    std::cout << (linear ? "Linear" : "Nearest") << " " << dimension << "x"
+              << dimension << ": pipeline " << pipelineTime * 1000. << "ms, fused "
+              << fusedTime * 1000. << "ms" << std::endl;
+    }
+
+  // Pixels on the border of the volume or the threshold range may differ
+  // because of rounding.
+  const double difference = CompareImages(
+    vtkImageData::SafeDownCast(displayPipeline->GetOutputDataObject(0)),
+    resliceMapToColors->GetOutput());
+  const double tolerance = linear ? 1. : 0.1;
+  if (difference > tolerance)
+    {
+    std::cerr << "Line " << __LINE__ << " - " << difference
+              << "% of the pixels are different" << std::endl;
+    return EXIT_FAILURE;
+    }
+  return EXIT_SUCCESS;
+}
+
+}
+
+//----------------------------------------------------------------------------
+// Usage: vtkImageResliceMapToColorsTest [iterations]
+// If a number of iterations is given, 1024x1024 slices are also resliced that
+// many times and the timings are printed (benchmark).
+int vtkImageResliceMapToColorsTest(int argc, char * argv [])
+{
+  vtkNew<vtkImageResliceMapToColors> resliceMapToColors;
+  EXERCISE_BASIC_OBJECT_METHODS(resliceMapToColors.GetPointer());
+
+  // Without input scalars the output is transparent
+  resliceMapToColors->SetOutputExtent(0, 9, 0, 9, 0, 0);
+  vtkNew<vtkImageData> emptyImage;
+  resliceMapToColors->SetInputData(emptyImage.GetPointer());
+  resliceMapToColors->Update();
+
+  if (TestFusedReslice(false, 256, 1, false) != EXIT_SUCCESS ||
+      TestFusedReslice(true, 256, 1, false) != EXIT_SUCCESS)
+    {
+    return EXIT_FAILURE;
+    }
+
+  if (argc > 1)
+    {
+    const int iterations = atoi(argv[1]);
+    if (iterations < 1)
+      {
+      std::cerr << "Line " << __LINE__ << " - Invalid number of iterations: "
+                << argv[1] << std::endl;
+      return EXIT_FAILURE;
+      }
+    if (TestFusedReslice(false, 1024, iterations, true) != EXIT_SUCCESS ||
+        TestFusedReslice(true, 1024, iterations, true) != EXIT_SUCCESS)
+      {
+      return EXIT_FAILURE;
+      }
+    }
+  return EXIT_SUCCESS;
+}
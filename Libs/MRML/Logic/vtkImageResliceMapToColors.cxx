@@ -0,0 +1,587 @@
+/*=auto=========================================================================
+
+  Portions (c) Copyright 2005 Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Program:   3D Slicer
+
+=========================================================================auto=*/
+
+#include "vtkImageResliceMapToColors.h"
+
+// VTK includes
+#include <vtkImageData.h>
+#include <vtkImageReslice.h>
+#include <vtkInformation.h>
+#include <vtkInformationVector.h>
+#include <vtkMatrix4x4.h>
+#include <vtkNew.h>
+#include <vtkObjectFactory.h>
+#include <vtkPointData.h>
+#include <vtkScalarsToColors.h>
+#include <vtkStreamingDemandDrivenPipeline.h>
+#include <vtkTypeTraits.h>
+
+// STD includes
+#include <algorithm>
+#include <cmath>
+
+//----------------------------------------------------------------------------
+vtkStandardNewMacro(vtkImageResliceMapToColors);
+vtkCxxSetObjectMacro(vtkImageResliceMapToColors, LookupTable, vtkScalarsToColors);
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+// Map pixel values to colors the same way as the vtkImageMapToWindowLevelColors,
+// vtkImageThreshold and vtkImageMapToColors filters of
+// vtkMRMLScalarVolumeDisplayNode.
+template <class T>
+class ColorMapper
+{
+public:
+  ColorMapper(vtkImageResliceMapToColors* self, const unsigned char* levelColors)
+  {
+    const double typeMin = static_cast<double>(vtkTypeTraits<T>::Min());
+    const double typeMax = static_cast<double>(vtkTypeTraits<T>::Max());
+    const double window = self->GetWindow();
+    const double level = self->GetLevel();
+
+    // see vtkImageMapToWindowLevelClamps()
+    const double lower = level - fabs(window) / 2.0;
+    const double upper = lower + fabs(window);
+    const double adjustedLower = std::min(std::max(lower, typeMin), typeMax);
+    const double adjustedUpper = std::min(std::max(upper, typeMin), typeMax);
+    this->Lower = static_cast<T>(adjustedLower);
+    this->Upper = static_cast<T>(adjustedUpper);
+    double lowerValue = 0.;
+    double upperValue = 255.;
+    if (window != 0.)
+      {
+      lowerValue = 255.0 * (adjustedLower - lower) / window;
+      upperValue = 255.0 * (adjustedUpper - lower) / window;
+      if (window < 0.)
+        {
+        lowerValue += 255.;
+        upperValue += 255.;
+        }
+      }
+    this->LowerValue = static_cast<unsigned char>(std::min(std::max(lowerValue, 0.), 255.));
+    this->UpperValue = static_cast<unsigned char>(std::min(std::max(upperValue, 0.), 255.));
+    this->Shift = window / 2.0 - level;
+    this->Scale = window != 0. ? 255.0 / window : 0.;
+
+    // see vtkImageThreshold
+    this->ApplyThreshold = (self->GetApplyThreshold() != 0);
+    this->LowerThreshold = static_cast<T>(
+      std::min(std::max(self->GetLowerThreshold(), typeMin), typeMax));
+    this->UpperThreshold = static_cast<T>(
+      std::min(std::max(self->GetUpperThreshold(), typeMin), typeMax));
+
+    this->LevelColors = levelColors;
+  }
+
+  inline void Map(T value, unsigned char* rgba) const
+  {
+    unsigned char level;
+    if (value <= this->Lower)
+      {
+      level = this->LowerValue;
+      }
+    else if (value >= this->Upper)
+      {
+      level = this->UpperValue;
+      }
+    else
+      {
+      level = static_cast<unsigned char>((value + this->Shift) * this->Scale);
+      }
+    const unsigned char* color = this->LevelColors + 4 * level;
+    rgba[0] = color[0];
+    rgba[1] = color[1];
+    rgba[2] = color[2];
+    rgba[3] = (color[3] != 0 &&
+               (!this->ApplyThreshold ||
+                (this->LowerThreshold <= value && value <= this->UpperThreshold))) ? 255 : 0;
+  }
+
+protected:
+  T Lower;
+  T Upper;
+  unsigned char LowerValue;
+  unsigned char UpperValue;
+  double Shift;
+  double Scale;
+  bool ApplyThreshold;
+  T LowerThreshold;
+  T UpperThreshold;
+  const unsigned char* LevelColors;
+};
+
+//----------------------------------------------------------------------------
+// Round and clamp an interpolated value the same way as vtkImageReslice.
+template <class T>
+inline T RoundToScalarType(double value)
+{
+  value = std::min(std::max(value, static_cast<double>(vtkTypeTraits<T>::Min())),
+                   static_cast<double>(vtkTypeTraits<T>::Max()));
+  return static_cast<T>(std::floor(value + 0.5));
+}
+
+template <>
+inline float RoundToScalarType<float>(double value)
+{
+  return static_cast<float>(value);
+}
+
+template <>
+inline double RoundToScalarType<double>(double value)
+{
+  return value;
+}
+
+//----------------------------------------------------------------------------
+template <class T>
+void BuildValueColors(vtkImageResliceMapToColors* self,
+                      const unsigned char* levelColors,
+                      std::vector<unsigned char>& valueColors)
+{
+  ColorMapper<T> mapper(self, levelColors);
+  const int minValue = static_cast<int>(vtkTypeTraits<T>::Min());
+  const int maxValue = static_cast<int>(vtkTypeTraits<T>::Max());
+  valueColors.resize(4 * (maxValue - minValue + 1));
+  for (int value = minValue; value <= maxValue; ++value)
+    {
+    mapper.Map(static_cast<T>(value), &valueColors[4 * (value - minValue)]);
+    }
+}
+
+//----------------------------------------------------------------------------
+template <class T>
+void ComputeBackgroundColor(vtkImageResliceMapToColors* self,
+                            const unsigned char* levelColors,
+                            unsigned char backgroundColor[4])
+{
+  // vtkImageReslice outputs 0 outside of the input and the stencil makes
+  // it transparent.
+  ColorMapper<T> mapper(self, levelColors);
+  mapper.Map(static_cast<T>(0), backgroundColor);
+  backgroundColor[3] = 0;
+}
+
+//----------------------------------------------------------------------------
+// Each row of the output extent is clipped to the pixels that are inside of
+// the input, these pixels are sampled and mapped to colors, the others get
+// the background color.
+template <class T>
+void vtkImageResliceMapToColorsExecute(vtkImageResliceMapToColors* self,
+                                       vtkImageData* inData, const T* inPtr,
+                                       vtkImageData* outData, int outExt[6],
+                                       const double matrix[3][4],
+                                       const unsigned char* levelColors,
+                                       const unsigned char* valueColors,
+                                       const unsigned char backgroundColor[4])
+{
+  const double tolerance = 1e-6;
+  ColorMapper<T> mapper(self, levelColors);
+  const bool linear = (self->GetInterpolationMode() == VTK_RESLICE_LINEAR);
+  const int minValue = static_cast<int>(vtkTypeTraits<T>::Min());
+
+  int inExt[6];
+  inData->GetExtent(inExt);
+  vtkIdType inInc[3];
+  inData->GetIncrements(inInc);
+  int maxIndex[3];
+  double bounds[3][2];
+  for (int i = 0; i < 3; ++i)
+    {
+    maxIndex[i] = inExt[2*i+1] - inExt[2*i];
+    // border mode of vtkImageReslice: the input is extended by half a voxel
+    bounds[i][0] = -0.5;
+    bounds[i][1] = maxIndex[i] + 0.5;
+    }
+
+  const int rowLength = outExt[1] - outExt[0] + 1;
+  for (int z = outExt[4]; z <= outExt[5]; ++z)
+    {
+    for (int y = outExt[2]; y <= outExt[3]; ++y)
+      {
+      // index in the input of the first pixel of the row and increment
+      // between two pixels of the row
+      double start[3];
+      double step[3];
+      for (int i = 0; i < 3; ++i)
+        {
+        start[i] = matrix[i][0] * outExt[0] + matrix[i][1] * y +
+                   matrix[i][2] * z + matrix[i][3] - inExt[2*i];
+        step[i] = matrix[i][0];
+        }
+
+      int first = 0;
+      int last = rowLength - 1;
+      for (int i = 0; i < 3 && first <= last; ++i)
+        {
+        if (step[i] == 0.)
+          {
+          if (start[i] < bounds[i][0] - tolerance || start[i] > bounds[i][1] + tolerance)
+            {
+            first = rowLength;
+            }
+          continue;
+          }
+        double t0 = (bounds[i][0] - start[i]) / step[i];
+        double t1 = (bounds[i][1] - start[i]) / step[i];
+        if (t0 > t1)
+          {
+          std::swap(t0, t1);
+          }
+        t0 = std::min(std::max(t0 - tolerance, -1.), static_cast<double>(rowLength));
+        t1 = std::min(std::max(t1 + tolerance, -1.), static_cast<double>(rowLength));
+        first = std::max(first, static_cast<int>(std::ceil(t0)));
+        last = std::min(last, static_cast<int>(std::floor(t1)));
+        }
+      if (first > last)
+        {
+        first = rowLength;
+        last = rowLength - 1;
+        }
+
+      unsigned char* outPtr =
+        static_cast<unsigned char*>(outData->GetScalarPointer(outExt[0], y, z));
+      for (int x = 0; x < first; ++x, outPtr += 4)
+        {
+        outPtr[0] = backgroundColor[0];
+        outPtr[1] = backgroundColor[1];
+        outPtr[2] = backgroundColor[2];
+        outPtr[3] = backgroundColor[3];
+        }
+      for (int x = first; x <= last; ++x, outPtr += 4)
+        {
+        T value;
+        if (!linear)
+          {
+          vtkIdType offset = 0;
+          for (int i = 0; i < 3; ++i)
+            {
+            int index = static_cast<int>(std::floor(start[i] + x * step[i] + 0.5));
+            index = std::min(std::max(index, 0), maxIndex[i]);
+            offset += index * inInc[i];
+            }
+          value = inPtr[offset];
+          }
+        else
+          {
+          vtkIdType offsets[3][2];
+          double weights[3];
+          for (int i = 0; i < 3; ++i)
+            {
+            const double position = start[i] + x * step[i];
+            const double floorPosition = std::floor(position);
+            const int index = static_cast<int>(floorPosition);
+            weights[i] = position - floorPosition;
+            offsets[i][0] = std::min(std::max(index, 0), maxIndex[i]) * inInc[i];
+            offsets[i][1] = std::min(std::max(index + 1, 0), maxIndex[i]) * inInc[i];
+            }
+          double interpolated = 0.;
+          for (int k = 0; k < 2; ++k)
+            {
+            const double wk = k ? weights[2] : 1. - weights[2];
+            for (int j = 0; j < 2; ++j)
+              {
+              const double wj = wk * (j ? weights[1] : 1. - weights[1]);
+              const T* rowPtr = inPtr + offsets[2][k] + offsets[1][j];
+              interpolated += wj * ((1. - weights[0]) * rowPtr[offsets[0][0]] +
+                                    weights[0] * rowPtr[offsets[0][1]]);
+              }
+            }
+          value = RoundToScalarType<T>(interpolated);
+          }
+        if (valueColors)
+          {
+          const unsigned char* color =
+            valueColors + 4 * (static_cast<int>(value) - minValue);
+          outPtr[0] = color[0];
+          outPtr[1] = color[1];
+          outPtr[2] = color[2];
+          outPtr[3] = color[3];
+          }
+        else
+          {
+          mapper.Map(value, outPtr);
+          }
+        }
+      for (int x = last + 1; x < rowLength; ++x, outPtr += 4)
+        {
+        outPtr[0] = backgroundColor[0];
+        outPtr[1] = backgroundColor[1];
+        outPtr[2] = backgroundColor[2];
+        outPtr[3] = backgroundColor[3];
+        }
+      }
+    }
+}
+
+}
+
+//----------------------------------------------------------------------------
+vtkImageResliceMapToColors::vtkImageResliceMapToColors()
+{
+  this->ResliceMatrix = vtkMatrix4x4::New();
+  for (int i = 0; i < 6; ++i)
+    {
+    this->OutputExtent[i] = 0;
+    }
+  this->InterpolationMode = VTK_RESLICE_NEAREST;
+  this->Window = 256.;
+  this->Level = 128.;
+  this->ApplyThreshold = 0;
+  this->LowerThreshold = VTK_SHORT_MIN;
+  this->UpperThreshold = VTK_SHORT_MAX;
+  this->LookupTable = 0;
+  for (int i = 0; i < 4; ++i)
+    {
+    this->BackgroundColor[i] = 0;
+    }
+  for (int i = 0; i < 3; ++i)
+    {
+    for (int j = 0; j < 4; ++j)
+      {
+      this->IndexMatrix[i][j] = (i == j ? 1. : 0.);
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+vtkImageResliceMapToColors::~vtkImageResliceMapToColors()
+{
+  this->ResliceMatrix->Delete();
+  this->SetLookupTable(0);
+}
+
+//----------------------------------------------------------------------------
+void vtkImageResliceMapToColors::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os, indent);
+
+  os << indent << "ResliceMatrix:\n";
+  this->ResliceMatrix->PrintSelf(os, indent.GetNextIndent());
+  os << indent << "OutputExtent: " << this->OutputExtent[0];
+  for (int i = 1; i < 6; ++i)
+    {
+    os << " " << this->OutputExtent[i];
+    }
+  os << "\n";
+  os << indent << "InterpolationMode: " << this->InterpolationMode << "\n";
+  os << indent << "Window: " << this->Window << "\n";
+  os << indent << "Level: " << this->Level << "\n";
+  os << indent << "ApplyThreshold: " << this->ApplyThreshold << "\n";
+  os << indent << "LowerThreshold: " << this->LowerThreshold << "\n";
+  os << indent << "UpperThreshold: " << this->UpperThreshold << "\n";
+  os << indent << "LookupTable: " << this->LookupTable << "\n";
+}
+
+//----------------------------------------------------------------------------
+void vtkImageResliceMapToColors::SetResliceMatrix(vtkMatrix4x4* matrix)
+{
+  vtkNew<vtkMatrix4x4> identity;
+  if (matrix == 0)
+    {
+    matrix = identity.GetPointer();
+    }
+  for (int i = 0; i < 4; ++i)
+    {
+    for (int j = 0; j < 4; ++j)
+      {
+      if (this->ResliceMatrix->GetElement(i, j) != matrix->GetElement(i, j))
+        {
+        this->ResliceMatrix->DeepCopy(matrix);
+        return;
+        }
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+void vtkImageResliceMapToColors::SetInterpolationModeToNearestNeighbor()
+{
+  this->SetInterpolationMode(VTK_RESLICE_NEAREST);
+}
+
+//----------------------------------------------------------------------------
+void vtkImageResliceMapToColors::SetInterpolationModeToLinear()
+{
+  this->SetInterpolationMode(VTK_RESLICE_LINEAR);
+}
+
+//----------------------------------------------------------------------------
+unsigned long vtkImageResliceMapToColors::GetMTime()
+{
+  unsigned long mTime = this->Superclass::GetMTime();
+  mTime = std::max(mTime, this->ResliceMatrix->GetMTime());
+  if (this->LookupTable)
+    {
+    mTime = std::max(mTime, this->LookupTable->GetMTime());
+    }
+  return mTime;
+}
+
+//----------------------------------------------------------------------------
+int vtkImageResliceMapToColors::RequestInformation(
+  vtkInformation* vtkNotUsed(request),
+  vtkInformationVector** vtkNotUsed(inputVector),
+  vtkInformationVector* outputVector)
+{
+  vtkInformation* outInfo = outputVector->GetInformationObject(0);
+  outInfo->Set(vtkStreamingDemandDrivenPipeline::WHOLE_EXTENT(), this->OutputExtent, 6);
+  double spacing[3] = {1., 1., 1.};
+  double origin[3] = {0., 0., 0.};
+  outInfo->Set(vtkDataObject::SPACING(), spacing, 3);
+  outInfo->Set(vtkDataObject::ORIGIN(), origin, 3);
+  vtkDataObject::SetPointDataActiveScalarInfo(outInfo, VTK_UNSIGNED_CHAR, 4);
+  return 1;
+}
+
+//----------------------------------------------------------------------------
+int vtkImageResliceMapToColors::RequestUpdateExtent(
+  vtkInformation* vtkNotUsed(request),
+  vtkInformationVector** inputVector,
+  vtkInformationVector* vtkNotUsed(outputVector))
+{
+  // Any voxel of the input may be needed
+  vtkInformation* inInfo = inputVector[0]->GetInformationObject(0);
+  int inExt[6];
+  inInfo->Get(vtkStreamingDemandDrivenPipeline::WHOLE_EXTENT(), inExt);
+  inInfo->Set(vtkStreamingDemandDrivenPipeline::UPDATE_EXTENT(), inExt, 6);
+  return 1;
+}
+
+//----------------------------------------------------------------------------
+int vtkImageResliceMapToColors::RequestData(vtkInformation* request,
+                                            vtkInformationVector** inputVector,
+                                            vtkInformationVector* outputVector)
+{
+  vtkImageData* input = vtkImageData::GetData(inputVector[0]);
+
+  // Colors of the window/level outputs
+  this->LevelColors.resize(256 * 4);
+  unsigned char levels[256];
+  for (int i = 0; i < 256; ++i)
+    {
+    levels[i] = static_cast<unsigned char>(i);
+    }
+  if (this->LookupTable)
+    {
+    this->LookupTable->Build();
+    this->LookupTable->MapScalarsThroughTable(
+      levels, &this->LevelColors[0], VTK_UNSIGNED_CHAR, 256, 1, VTK_RGBA);
+    }
+  else
+    {
+    for (int i = 0; i < 256; ++i)
+      {
+      std::fill(&this->LevelColors[4*i], &this->LevelColors[4*i] + 3, levels[i]);
+      this->LevelColors[4*i + 3] = 255;
+      }
+    }
+
+  this->ValueColors.clear();
+  if (input && input->GetPointData()->GetScalars())
+    {
+    // From output pixel to input voxel index
+    double* spacing = input->GetSpacing();
+    double* origin = input->GetOrigin();
+    for (int i = 0; i < 3; ++i)
+      {
+      for (int j = 0; j < 4; ++j)
+        {
+        this->IndexMatrix[i][j] = this->ResliceMatrix->GetElement(i, j) / spacing[i];
+        }
+      this->IndexMatrix[i][3] -= origin[i] / spacing[i];
+      }
+
+    // Tabulate the colors of all the possible values if there are less
+    // values than output pixels.
+    const int* extent = this->OutputExtent;
+    const double numberOfPixels = (extent[1] - extent[0] + 1.) *
+      (extent[3] - extent[2] + 1.) * (extent[5] - extent[4] + 1.);
+    const double numberOfValues =
+      input->GetScalarTypeMax() - input->GetScalarTypeMin() + 1.;
+    if (numberOfValues <= numberOfPixels)
+      {
+      switch (input->GetScalarType())
+        {
+        case VTK_CHAR:
+          BuildValueColors<char>(this, &this->LevelColors[0], this->ValueColors);
+          break;
+        case VTK_SIGNED_CHAR:
+          BuildValueColors<signed char>(this, &this->LevelColors[0], this->ValueColors);
+          break;
+        case VTK_UNSIGNED_CHAR:
+          BuildValueColors<unsigned char>(this, &this->LevelColors[0], this->ValueColors);
+          break;
+        case VTK_SHORT:
+          BuildValueColors<short>(this, &this->LevelColors[0], this->ValueColors);
+          break;
+        case VTK_UNSIGNED_SHORT:
+          BuildValueColors<unsigned short>(this, &this->LevelColors[0], this->ValueColors);
+          break;
+        default:
+          break;
+        }
+      }
+
+    switch (input->GetScalarType())
+      {
+      vtkTemplateMacro(
+        ComputeBackgroundColor<VTK_TT>(this, &this->LevelColors[0], this->BackgroundColor));
+      default:
+        break;
+      }
+    }
+
+  return this->Superclass::RequestData(request, inputVector, outputVector);
+}
+
+//----------------------------------------------------------------------------
+void vtkImageResliceMapToColors::ThreadedRequestData(
+  vtkInformation* vtkNotUsed(request),
+  vtkInformationVector** vtkNotUsed(inputVector),
+  vtkInformationVector* vtkNotUsed(outputVector),
+  vtkImageData*** inData, vtkImageData** outData,
+  int outExt[6], int vtkNotUsed(threadId))
+{
+  vtkImageData* input = inData[0][0];
+  vtkImageData* output = outData[0];
+  if (!input || !input->GetPointData()->GetScalars())
+    {
+    // Nothing to reslice, the output is transparent
+    for (int z = outExt[4]; z <= outExt[5]; ++z)
+      {
+      for (int y = outExt[2]; y <= outExt[3]; ++y)
+        {
+        unsigned char* outPtr =
+          static_cast<unsigned char*>(output->GetScalarPointer(outExt[0], y, z));
+        std::fill(outPtr, outPtr + 4 * (outExt[1] - outExt[0] + 1), 0);
+        }
+      }
+    return;
+    }
+
+  const unsigned char* valueColors =
+    this->ValueColors.empty() ? 0 : &this->ValueColors[0];
+  void* inPtr = input->GetScalarPointer();
+  switch (input->GetScalarType())
+    {
+    vtkTemplateMacro(
+      vtkImageResliceMapToColorsExecute(this, input, static_cast<VTK_TT*>(inPtr),
+                                        output, outExt, this->IndexMatrix,
+                                        &this->LevelColors[0], valueColors,
+                                        this->BackgroundColor));
+    default:
+      vtkErrorMacro(<< "ThreadedRequestData: Unknown input scalar type");
+      return;
+    }
+}
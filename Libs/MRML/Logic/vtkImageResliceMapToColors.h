@@ -0,0 +1,140 @@
+/*=auto=========================================================================
+
+  Portions (c) Copyright 2005 Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Program:   3D Slicer
+
+=========================================================================auto=*/
+
+#ifndef __vtkImageResliceMapToColors_h
+#define __vtkImageResliceMapToColors_h
+
+// VTK includes
+#include <vtkThreadedImageAlgorithm.h>
+
+#include "vtkMRMLLogicWin32Header.h"
+
+class vtkMatrix4x4;
+class vtkScalarsToColors;
+
+// STD includes
+#include <vector>
+
+/// \brief Reslice a scalar volume and map it to RGBA colors in a single pass.
+///
+/// The output is the image produced for scalar volumes by the pipeline of
+/// vtkMRMLSliceLayerLogic: vtkImageReslice followed by the window/level,
+/// threshold and lookup table filters of vtkMRMLScalarVolumeDisplayNode.
+/// Each output pixel is sampled from the input and mapped to its color
+/// without intermediate images, the output rows are processed in parallel.
+/// For integer scalar types of up to 16 bits the color of each possible
+/// value is tabulated once per execution.
+///
+/// The alpha component is 255 if the pixel is inside the input volume,
+/// its color is not transparent and its value is within the threshold
+/// range (if ApplyThreshold is on), 0 otherwise. Only the first component
+/// of the input is used.
+/// \sa vtkMRMLSliceLayerLogic::SetFusedReslice()
+class VTK_MRML_LOGIC_EXPORT vtkImageResliceMapToColors : public vtkThreadedImageAlgorithm
+{
+public:
+  static vtkImageResliceMapToColors *New();
+  vtkTypeMacro(vtkImageResliceMapToColors,vtkThreadedImageAlgorithm);
+  void PrintSelf(ostream& os, vtkIndent indent);
+
+  ///
+  /// Linear transform from the output coordinates to the input coordinates,
+  /// similar to vtkImageReslice::SetResliceTransform(). The matrix is copied.
+  /// The output spacing is 1 and the output origin is 0.
+  void SetResliceMatrix(vtkMatrix4x4* matrix);
+  vtkGetObjectMacro(ResliceMatrix, vtkMatrix4x4);
+
+  ///
+  /// Extent of the output image.
+  vtkSetVector6Macro(OutputExtent, int);
+  vtkGetVector6Macro(OutputExtent, int);
+
+  ///
+  /// Nearest neighbor (VTK_RESLICE_NEAREST) or linear (VTK_RESLICE_LINEAR)
+  /// interpolation. Nearest neighbor by default.
+  vtkSetMacro(InterpolationMode, int);
+  vtkGetMacro(InterpolationMode, int);
+  void SetInterpolationModeToNearestNeighbor();
+  void SetInterpolationModeToLinear();
+
+  ///
+  /// Window and level applied to the scalars before the lookup table,
+  /// see vtkImageMapToWindowLevelColors.
+  vtkSetMacro(Window, double);
+  vtkGetMacro(Window, double);
+  vtkSetMacro(Level, double);
+  vtkGetMacro(Level, double);
+
+  ///
+  /// Pixels with a value outside of the threshold range are transparent
+  /// if ApplyThreshold is on, see vtkImageThreshold.
+  vtkSetMacro(ApplyThreshold, int);
+  vtkGetMacro(ApplyThreshold, int);
+  vtkBooleanMacro(ApplyThreshold, int);
+  vtkSetMacro(LowerThreshold, double);
+  vtkGetMacro(LowerThreshold, double);
+  vtkSetMacro(UpperThreshold, double);
+  vtkGetMacro(UpperThreshold, double);
+
+  ///
+  /// Lookup table indexed by the window/level output (0 to 255).
+  /// If null, a grey ramp is used.
+  virtual void SetLookupTable(vtkScalarsToColors*);
+  vtkGetObjectMacro(LookupTable, vtkScalarsToColors);
+
+  ///
+  /// Reimplemented to take into account the reslice matrix and the
+  /// lookup table.
+  unsigned long GetMTime();
+
+protected:
+  vtkImageResliceMapToColors();
+  ~vtkImageResliceMapToColors();
+
+  virtual int RequestInformation(vtkInformation*, vtkInformationVector**,
+                                 vtkInformationVector*);
+  virtual int RequestUpdateExtent(vtkInformation*, vtkInformationVector**,
+                                  vtkInformationVector*);
+  virtual int RequestData(vtkInformation*, vtkInformationVector**,
+                          vtkInformationVector*);
+  virtual void ThreadedRequestData(vtkInformation* request,
+                                   vtkInformationVector** inputVector,
+                                   vtkInformationVector* outputVector,
+                                   vtkImageData*** inData,
+                                   vtkImageData** outData,
+                                   int outExt[6], int threadId);
+
+  vtkMatrix4x4* ResliceMatrix;
+  int OutputExtent[6];
+  int InterpolationMode;
+  double Window;
+  double Level;
+  int ApplyThreshold;
+  double LowerThreshold;
+  double UpperThreshold;
+  vtkScalarsToColors* LookupTable;
+
+  /// Colors of the window/level outputs (256 RGBA).
+  std::vector<unsigned char> LevelColors;
+  /// Colors of all the values of the input scalar type (RGBA) if it is
+  /// an integer type of up to 16 bits, empty otherwise.
+  std::vector<unsigned char> ValueColors;
+  /// Color of the pixels outside of the input.
+  unsigned char BackgroundColor[4];
+  /// Transform from the output indexes to the input indexes.
+  double IndexMatrix[3][4];
+
+private:
+  vtkImageResliceMapToColors(const vtkImageResliceMapToColors&);  // Not implemented.
+  void operator=(const vtkImageResliceMapToColors&);  // Not implemented.
+};
+
+#endif
@@ -16,6 +16,7 @@
 #include "vtkMRMLSliceLayerLogic.h"
 
 // MRML includes
+#include "vtkMRMLColorNode.h"
 #include "vtkMRMLLabelMapVolumeNode.h"
 #include "vtkMRMLLabelMapVolumeDisplayNode.h"
 #include "vtkMRMLVectorVolumeDisplayNode.h"
@@ -46,6 +47,7 @@
 
 //
 #include "vtkImageLabelOutline.h"
+#include "vtkImageResliceMapToColors.h"
 
 // STD includes
 #include <algorithm>
@@ -140,6 +142,10 @@ vtkMRMLSliceLayerLogic::vtkMRMLSliceLayerLogic()
   this->ResliceUVW = vtkImageReslice::New();
   this->LabelOutline = vtkImageLabelOutline::New();
   this->LabelOutlineUVW = vtkImageLabelOutline::New();
+  this->ResliceMapToColors = vtkImageResliceMapToColors::New();
+  this->ResliceMapToColorsUVW = vtkImageResliceMapToColors::New();
+  this->FusedReslice = 0;
+  this->LinearResliceTransforms = false;
 
   //
   // Set parameters that won't change based on input
@@ -188,6 +194,8 @@ vtkMRMLSliceLayerLogic::~vtkMRMLSliceLayerLogic()
   this->ResliceUVW->SetInputConnection( 0 );
   this->LabelOutline->SetInputConnection( 0 );
   this->LabelOutlineUVW->SetInputConnection( 0 );
+  this->ResliceMapToColors->SetInputConnection( 0 );
+  this->ResliceMapToColorsUVW->SetInputConnection( 0 );
 
   this->Reslice->Delete();
   this->ResliceUVW->Delete();
@@ -195,6 +203,9 @@ vtkMRMLSliceLayerLogic::~vtkMRMLSliceLayerLogic()
   this->LabelOutline->Delete();
   this->LabelOutlineUVW->Delete();
 
+  this->ResliceMapToColors->Delete();
+  this->ResliceMapToColorsUVW->Delete();
+
   this->AssignAttributeTensorsToScalars->Delete();
   this->AssignAttributeScalarsToTensors->Delete();
   this->AssignAttributeScalarsToTensorsUVW->Delete();
@@ -514,6 +525,8 @@ void vtkMRMLSliceLayerLogic::UpdateTransforms()
   this->XYToIJKTransform->PostMultiply();
   this->UVWToIJKTransform->PostMultiply();
 
+  this->LinearResliceTransforms = false;
+
   if (this->SliceNode)
     {
     vtkMatrix4x4::Multiply4x4(this->SliceNode->GetXYToRAS(), xyToIJK.GetPointer(), xyToIJK.GetPointer());
@@ -555,6 +568,8 @@ void vtkMRMLSliceLayerLogic::UpdateTransforms()
       {
       SnapToPermuteMatrix(linearXYToIJKTransform);
       this->Reslice->SetResliceTransform(linearXYToIJKTransform);
+      this->ResliceMapToColors->SetResliceMatrix(linearXYToIJKTransform->GetMatrix());
+      this->LinearResliceTransforms = true;
       }
     else
       {
@@ -565,10 +580,12 @@ void vtkMRMLSliceLayerLogic::UpdateTransforms()
       {
       SnapToPermuteMatrix(linearUVWToIJKTransform);
       this->ResliceUVW->SetResliceTransform( linearUVWToIJKTransform );
+      this->ResliceMapToColorsUVW->SetResliceMatrix(linearUVWToIJKTransform->GetMatrix());
       }
     else
       {
       this->ResliceUVW->SetResliceTransform( this->UVWToIJKTransform );
+      this->LinearResliceTransforms = false;
       }
 
   }
@@ -599,6 +616,14 @@ void vtkMRMLSliceLayerLogic::UpdateTransforms()
                                      0, dimensionsUVW[1]-1,
                                      0, dimensionsUVW[2]-1);
 
+  this->ResliceMapToColors->SetOutputExtent( 0, dimensions[0]-1,
+                                             0, dimensions[1]-1,
+                                             0, dimensions[2]-1);
+
+  this->ResliceMapToColorsUVW->SetOutputExtent( 0, dimensionsUVW[0]-1,
+                                                0, dimensionsUVW[1]-1,
+                                                0, dimensionsUVW[2]-1);
+
   this->UpdatingTransforms = 0;
 
   //if (transformModified || transformModifiedUVW)
@@ -614,6 +639,10 @@ vtkImageData* vtkMRMLSliceLayerLogic::GetImageData()
     {
     return NULL;
     }
+  if (this->IsFusedResliceUsed())
+    {
+    return this->ResliceMapToColors->GetOutput();
+    }
   return this->GetVolumeDisplayNode()->GetOutputImageData();
 }
 
@@ -624,6 +653,10 @@ vtkAlgorithmOutput* vtkMRMLSliceLayerLogic::GetImageDataConnection()
     {
     return NULL;
     }
+  if (this->IsFusedResliceUsed())
+    {
+    return this->ResliceMapToColors->GetOutputPort();
+    }
   return this->GetVolumeDisplayNode()->GetOutputImageDataConnection();
 }
 
@@ -634,6 +667,11 @@ vtkImageData* vtkMRMLSliceLayerLogic::GetImageDataUVW()
     {
     return NULL;
     }
+  if (this->IsFusedResliceUsed())
+    {
+    return this->GetSliceImageDataConnectionUVW() ?
+      this->ResliceMapToColorsUVW->GetOutput() : NULL;
+    }
   return this->GetVolumeDisplayNodeUVW()->GetOutputImageData();
 }
 
@@ -644,6 +682,11 @@ vtkAlgorithmOutput* vtkMRMLSliceLayerLogic::GetImageDataConnectionUVW()
     {
     return NULL;
     }
+  if (this->IsFusedResliceUsed())
+    {
+    return this->GetSliceImageDataConnectionUVW() ?
+      this->ResliceMapToColorsUVW->GetOutputPort() : NULL;
+    }
   return this->GetVolumeDisplayNodeUVW()->GetOutputImageDataConnection();
 }
 
@@ -666,6 +709,8 @@ void vtkMRMLSliceLayerLogic::UpdateImageDisplay()
   unsigned long oldAssign = this->AssignAttributeTensorsToScalars->GetMTime();
   unsigned long oldLabel = this->LabelOutline->GetMTime();
   unsigned long oldLabelUVW = this->LabelOutlineUVW->GetMTime();
+  unsigned long oldFused = this->ResliceMapToColors->GetMTime();
+  unsigned long oldFusedUVW = this->ResliceMapToColorsUVW->GetMTime();
 
   if ( (this->VolumeNode->GetImageData() && labelMapVolumeDisplayNode) ||
        (scalarVolumeDisplayNode && scalarVolumeDisplayNode->GetInterpolate() == 0))
@@ -800,11 +845,24 @@ void vtkMRMLSliceLayerLogic::UpdateImageDisplay()
       }
     }
 
+  if (this->IsFusedResliceUsed())
+    {
+    this->UpdateResliceMapToColors(this->ResliceMapToColors, volumeDisplayNode);
+    this->UpdateResliceMapToColors(this->ResliceMapToColorsUVW, volumeDisplayNodeUVW);
+    }
+  else
+    {
+    this->ResliceMapToColors->SetInputConnection(0);
+    this->ResliceMapToColorsUVW->SetInputConnection(0);
+    }
+
   if ( oldReSliceMTime != this->Reslice->GetMTime() ||
        oldReSliceUVWMTime != this->ResliceUVW->GetMTime() ||
        oldAssign != this->AssignAttributeTensorsToScalars->GetMTime() ||
        oldLabel != this->LabelOutline->GetMTime() ||
        oldLabelUVW != this->LabelOutlineUVW->GetMTime() ||
+       oldFused != this->ResliceMapToColors->GetMTime() ||
+       oldFusedUVW != this->ResliceMapToColorsUVW->GetMTime() ||
        (volumeNode != 0 && (volumeNode->GetMTime() > oldReSliceMTime)) ||
        (volumeDisplayNode != 0 && (volumeDisplayNode->GetMTime() > oldReSliceMTime)) ||
        (volumeDisplayNodeUVW != 0 && (volumeDisplayNodeUVW->GetMTime() > oldReSliceUVWMTime))
@@ -814,6 +872,46 @@ void vtkMRMLSliceLayerLogic::UpdateImageDisplay()
     }
 }
 
+//----------------------------------------------------------------------------
+bool vtkMRMLSliceLayerLogic::IsFusedResliceUsed()
+{
+  if (!this->FusedReslice || !this->LinearResliceTransforms ||
+      !this->VolumeNode || !this->VolumeDisplayNode ||
+      this->VolumeNode->IsA("vtkMRMLDiffusionTensorVolumeNode"))
+    {
+    return false;
+    }
+  vtkImageData* imageData = this->VolumeNode->GetImageData();
+  // Subclasses of vtkMRMLScalarVolumeDisplayNode (label maps...) have their
+  // own pipeline.
+  return imageData != 0 &&
+    imageData->GetNumberOfScalarComponents() == 1 &&
+    strcmp(this->VolumeDisplayNode->GetClassName(), "vtkMRMLScalarVolumeDisplayNode") == 0;
+}
+
+//----------------------------------------------------------------------------
+void vtkMRMLSliceLayerLogic::UpdateResliceMapToColors(
+  vtkImageResliceMapToColors* resliceMapToColors, vtkMRMLVolumeDisplayNode* displayNode)
+{
+  vtkMRMLScalarVolumeDisplayNode* scalarVolumeDisplayNode =
+    vtkMRMLScalarVolumeDisplayNode::SafeDownCast(displayNode);
+  if (!scalarVolumeDisplayNode)
+    {
+    resliceMapToColors->SetInputConnection(0);
+    return;
+    }
+  resliceMapToColors->SetInputData(this->VolumeNode->GetImageData());
+  resliceMapToColors->SetInterpolationMode(
+    scalarVolumeDisplayNode->GetInterpolate() ? VTK_RESLICE_LINEAR : VTK_RESLICE_NEAREST);
+  resliceMapToColors->SetWindow(scalarVolumeDisplayNode->GetWindow());
+  resliceMapToColors->SetLevel(scalarVolumeDisplayNode->GetLevel());
+  resliceMapToColors->SetApplyThreshold(scalarVolumeDisplayNode->GetApplyThreshold());
+  resliceMapToColors->SetLowerThreshold(scalarVolumeDisplayNode->GetLowerThreshold());
+  resliceMapToColors->SetUpperThreshold(scalarVolumeDisplayNode->GetUpperThreshold());
+  vtkMRMLColorNode* colorNode = scalarVolumeDisplayNode->GetColorNode();
+  resliceMapToColors->SetLookupTable(colorNode ? colorNode->GetScalarsToColors() : 0);
+}
+
 //----------------------------------------------------------------------------
 vtkAlgorithmOutput* vtkMRMLSliceLayerLogic::GetSliceImageDataConnection()
 {
@@ -987,6 +1085,12 @@ void vtkMRMLSliceLayerLogic::PrintSelf(ostream& os, vtkIndent indent)
     os << indent << " (0)\n";
     }
 
+  os << indent << "FusedReslice: " << this->FusedReslice << "\n";
+  os << indent << "ResliceMapToColors:\n";
+  this->ResliceMapToColors->PrintSelf(os, nextIndent);
+  os << indent << "ResliceMapToColorsUVW:\n";
+  this->ResliceMapToColorsUVW->PrintSelf(os, nextIndent);
+
   os << indent << "IsLabelLayer: " << this->GetIsLabelLayer() << "\n";
   os << indent << "LabelOutline:\n";
   if (this->LabelOutline)
@@ -49,6 +49,7 @@
 
 class vtkAssignAttribute;
 class vtkImageReslice;
+class vtkImageResliceMapToColors;
 class vtkGeneralTransform;
 
 // STL includes
@@ -89,6 +90,23 @@ public:
   vtkGetObjectMacro (Reslice, vtkImageReslice);
   vtkGetObjectMacro (ResliceUVW, vtkImageReslice);
 
+  ///
+  /// If on, scalar volumes displayed with a vtkMRMLScalarVolumeDisplayNode
+  /// and a linear transform are resliced, window/leveled, thresholded and
+  /// mapped to colors in a single pass by ResliceMapToColors (and
+  /// ResliceMapToColorsUVW) instead of the Reslice and display node pipeline.
+  /// Other volumes always use the display node pipeline.
+  /// Off by default.
+  vtkGetMacro (FusedReslice, int);
+  vtkSetMacro (FusedReslice, int);
+  vtkBooleanMacro (FusedReslice, int);
+
+  ///
+  /// The filters used instead of the reslice and display node pipeline
+  /// when FusedReslice is on.
+  vtkGetObjectMacro (ResliceMapToColors, vtkImageResliceMapToColors);
+  vtkGetObjectMacro (ResliceMapToColorsUVW, vtkImageResliceMapToColors);
+
   ///
   /// Select if this is a label layer or not (it currently determines if we use
   /// the label outline filter)
@@ -156,6 +174,12 @@ protected:
   // Copy VolumeDisplayNodeObserved into VolumeDisplayNode
   void UpdateVolumeDisplayNode();
 
+  /// Return true if the output is computed by ResliceMapToColors
+  /// \sa FusedReslice
+  bool IsFusedResliceUsed();
+  void UpdateResliceMapToColors(vtkImageResliceMapToColors* resliceMapToColors,
+                                vtkMRMLVolumeDisplayNode* displayNode);
+
   ///
   /// the MRML Nodes that define this Logic's parameters
   vtkMRMLVolumeNode *VolumeNode;
@@ -170,6 +194,8 @@ protected:
   vtkImageReslice *ResliceUVW;
   vtkImageLabelOutline *LabelOutline;
   vtkImageLabelOutline *LabelOutlineUVW;
+  vtkImageResliceMapToColors *ResliceMapToColors;
+  vtkImageResliceMapToColors *ResliceMapToColorsUVW;
 
   vtkAssignAttribute* AssignAttributeTensorsToScalars;
   vtkAssignAttribute* AssignAttributeScalarsToTensors;
@@ -180,6 +206,9 @@ protected:
   vtkGeneralTransform *UVWToIJKTransform;
 
   int IsLabelLayer;
+  int FusedReslice;
+  /// True if XYToIJKTransform and UVWToIJKTransform are linear
+  bool LinearResliceTransforms;
 
   int UpdatingTransforms;
 };
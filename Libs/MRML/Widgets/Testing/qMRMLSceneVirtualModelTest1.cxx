@@ -0,0 +1,232 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  Copyright (c) Kitware Inc.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// Qt includes
+#include <QApplication>
+#include <QSignalSpy>
+#include <QTimer>
+#include <QTreeView>
+
+// qMRML includes
+#include "qMRMLSceneVirtualModel.h"
+#include "qMRMLSortFilterProxyModel.h"
+
+// MRML includes
+#include <vtkMRMLCameraNode.h>
+#include <vtkMRMLModelNode.h>
+#include <vtkMRMLScene.h>
+
+// VTK includes
+#include <vtkNew.h>
+#include <vtkSmartPointer.h>
+
+// STD includes
+#include <iostream>
+#include <vector>
+
+namespace
+{
+
+//-----------------------------------------------------------------------------
+// Check that each exposed row is the node of the scene at the same position
+bool CheckRows(int line, qMRMLSceneVirtualModel& model)
+{
+  vtkMRMLScene* scene = model.mrmlScene();
+  QModelIndex sceneIndex = model.mrmlSceneIndex();
+  const int rowCount = model.rowCount(sceneIndex);
+  if (rowCount > scene->GetNumberOfNodes())
+    {
+    std::cerr << "Line " << line << " - Wrong number of rows: " << rowCount
+              << " for " << scene->GetNumberOfNodes() << " nodes" << std::endl;
+    return false;
+    }
+  for (int row = 0; row < rowCount; ++row)
+    {
+    vtkMRMLNode* node = scene->GetNthNode(row);
+    QModelIndex index = model.index(row, 0, sceneIndex);
+    if (model.mrmlNodeFromIndex(index) != node ||
+        model.nodeRow(node) != row ||
+        model.indexFromNode(node) != index ||
+        index.data(qMRMLSceneModel::UIDRole).toString() != QString(node->GetID()) ||
+        index.data().toString() != QString(node->GetName()))
+      {
+      std::cerr << "Line " << line << " - Wrong node at row " << row << std::endl;
+      return false;
+      }
+    }
+  return true;
+}
+
+}
+
+//-----------------------------------------------------------------------------
+int qMRMLSceneVirtualModelTest1(int argc, char * argv [] )
+{
+  QApplication app(argc, argv);
+  qRegisterMetaType<QModelIndex>("QModelIndex");
+
+  qMRMLSceneVirtualModel model;
+  if (model.rowCount() != 0 || model.mrmlSceneIndex().isValid())
+    {
+    std::cerr << "Line " << __LINE__ << " - Model without scene has rows" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  vtkNew<vtkMRMLScene> scene;
+  std::vector<vtkSmartPointer<vtkMRMLNode> > nodes;
+  const int numberOfNodes = 2500;
+  for (int i = 0; i < numberOfNodes; ++i)
+    {
+    vtkSmartPointer<vtkMRMLNode> node;
+    if (i % 5 == 0)
+      {
+      node = vtkSmartPointer<vtkMRMLCameraNode>::New();
+      }
+    else
+      {
+      node = vtkSmartPointer<vtkMRMLModelNode>::New();
+      }
+    scene->AddNode(node);
+    nodes.push_back(node);
+    }
+
+  // Only the first batch is exposed
+  model.setMRMLScene(scene.GetPointer());
+  QModelIndex sceneIndex = model.mrmlSceneIndex();
+  if (model.rowCount() != 1 ||
+      model.rowCount(sceneIndex) != model.fetchBatchSize() ||
+      !model.canFetchMore(sceneIndex) ||
+      !CheckRows(__LINE__, model))
+    {
+    std::cerr << "Line " << __LINE__ << " - setMRMLScene() failed: "
+              << model.rowCount(sceneIndex) << " rows" << std::endl;
+    return EXIT_FAILURE;
+    }
+  model.fetchMore(sceneIndex);
+  if (model.rowCount(sceneIndex) != 2 * model.fetchBatchSize())
+    {
+    std::cerr << "Line " << __LINE__ << " - fetchMore() failed: "
+              << model.rowCount(sceneIndex) << " rows" << std::endl;
+    return EXIT_FAILURE;
+    }
+  // Requesting the index of a node that is not exposed fetches it
+  QModelIndex lastIndex = model.indexFromNode(nodes.back());
+  if (lastIndex.row() != numberOfNodes - 1 ||
+      model.rowCount(sceneIndex) != numberOfNodes ||
+      model.canFetchMore(sceneIndex) ||
+      !CheckRows(__LINE__, model))
+    {
+    std::cerr << "Line " << __LINE__ << " - indexFromNode() failed: "
+              << model.rowCount(sceneIndex) << " rows" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  QSignalSpy insertedSpy(&model, SIGNAL(rowsInserted(QModelIndex,int,int)));
+  QSignalSpy removedSpy(&model, SIGNAL(rowsRemoved(QModelIndex,int,int)));
+
+  // Node added and removed
+  vtkNew<vtkMRMLModelNode> addedNode;
+  scene->AddNode(addedNode.GetPointer());
+  scene->RemoveNode(nodes[10]);
+  if (insertedSpy.count() != 1 || removedSpy.count() != 1 ||
+      model.nodeRow(addedNode.GetPointer()) != numberOfNodes - 1 ||
+      model.nodeRow(nodes[11]) != 10 ||
+      model.nodeRow(nodes[10]) != -1 ||
+      !CheckRows(__LINE__, model))
+    {
+    std::cerr << "Line " << __LINE__ << " - Add or remove failed: "
+              << insertedSpy.count() << " " << removedSpy.count() << std::endl;
+    return EXIT_FAILURE;
+    }
+  insertedSpy.clear();
+  removedSpy.clear();
+
+  // The rows added and removed during a batch processing are signaled at
+  // the end of the batch processing.
+  scene->StartState(vtkMRMLScene::BatchProcessState);
+  for (int i = 0; i < 100; ++i)
+    {
+    vtkNew<vtkMRMLCameraNode> node;
+    scene->AddNode(node.GetPointer());
+    }
+  scene->RemoveNode(nodes[0]);
+  scene->RemoveNode(nodes[1]);
+  scene->RemoveNode(nodes[100]);
+  if (insertedSpy.count() != 0 || removedSpy.count() != 0)
+    {
+    std::cerr << "Line " << __LINE__ << " - Rows changed during batch processing: "
+              << insertedSpy.count() << " " << removedSpy.count() << std::endl;
+    return EXIT_FAILURE;
+    }
+  scene->EndState(vtkMRMLScene::BatchProcessState);
+  if (insertedSpy.count() != 1 || removedSpy.count() != 2 ||
+      model.rowCount(sceneIndex) != scene->GetNumberOfNodes() ||
+      !CheckRows(__LINE__, model))
+    {
+    std::cerr << "Line " << __LINE__ << " - Batch processing failed: "
+              << insertedSpy.count() << " " << removedSpy.count() << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Filter
+  qMRMLSortFilterProxyModel proxyModel;
+  proxyModel.setSourceModel(&model);
+  proxyModel.setNodeTypes(QStringList("vtkMRMLCameraNode"));
+  std::vector<vtkMRMLNode *> cameraNodes;
+  scene->GetNodesByClass("vtkMRMLCameraNode", cameraNodes);
+  if (proxyModel.sceneVirtualModel() != &model ||
+      proxyModel.mrmlScene() != scene.GetPointer() ||
+      proxyModel.rowCount(proxyModel.mrmlSceneIndex()) !=
+        static_cast<int>(cameraNodes.size()) ||
+      proxyModel.mrmlNodeFromIndex(
+        proxyModel.indexFromMRMLNode(cameraNodes.back())) != cameraNodes.back() ||
+      proxyModel.indexFromMRMLNode(nodes[2]).isValid())
+    {
+    std::cerr << "Line " << __LINE__ << " - Filtering failed: "
+              << proxyModel.rowCount(proxyModel.mrmlSceneIndex()) << " rows for "
+              << cameraNodes.size() << " camera nodes" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Name modified
+  nodes[3]->SetName("renamed");
+  if (model.indexFromNode(nodes[3]).data().toString() != "renamed")
+    {
+    std::cerr << "Line " << __LINE__ << " - Name not updated" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  QTreeView view;
+  view.setModel(&proxyModel);
+  view.show();
+
+  // Close
+  scene->Clear(0);
+  if (model.rowCount(sceneIndex) != scene->GetNumberOfNodes() ||
+      !CheckRows(__LINE__, model))
+    {
+    std::cerr << "Line " << __LINE__ << " - Close failed: "
+              << model.rowCount(sceneIndex) << " rows" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  if (argc < 2 || QString(argv[1]) != "-I" )
+    {
+    QTimer::singleShot(200, &app, SLOT(quit()));
+    }
+  return app.exec();
+}
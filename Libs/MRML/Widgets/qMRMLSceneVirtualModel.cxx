@@ -0,0 +1,1001 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  Copyright (c) Kitware Inc.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// Qt includes
+#include <QHash>
+#include <QIcon>
+#include <QVector>
+
+// qMRML includes
+#include "qMRMLSceneVirtualModel.h"
+
+// MRML includes
+#include <vtkMRMLDisplayableHierarchyNode.h>
+#include <vtkMRMLDisplayableNode.h>
+#include <vtkMRMLDisplayNode.h>
+#include <vtkMRMLScene.h>
+#include <vtkMRMLSelectionNode.h>
+
+// VTK includes
+#include <vtkCallbackCommand.h>
+#include <vtkCollection.h>
+#include <vtkSmartPointer.h>
+
+namespace
+{
+// Internal ids of the model indexes
+enum ItemId
+{
+  SceneItemId = 1,
+  NodeItemId
+};
+}
+
+//------------------------------------------------------------------------------
+// qMRMLSceneVirtualModelPrivate
+//------------------------------------------------------------------------------
+class qMRMLSceneVirtualModelPrivate
+{
+  Q_DECLARE_PUBLIC(qMRMLSceneVirtualModel);
+protected:
+  qMRMLSceneVirtualModel* const q_ptr;
+public:
+  qMRMLSceneVirtualModelPrivate(qMRMLSceneVirtualModel& object);
+  ~qMRMLSceneVirtualModelPrivate();
+  void init();
+
+  bool isSceneIndex(const QModelIndex& index)const;
+  /// Update the rows in NodeRows that may have changed since the last update.
+  void updateNodeRows()const;
+  /// Expose the rows up to \a lastRow to the views.
+  void fetchRows(int lastRow);
+  /// Remove the rows from \a first to \a last, signal it if they are exposed.
+  void removeRows(int first, int last);
+  /// Remove the rows of the nodes removed during the batch processing.
+  void removeRemovedNodeRows();
+  void listenNodeModifiedEvent();
+  void resetColumns();
+
+  int nodeVisibility(vtkMRMLNode* node)const;
+  void setNodeVisibility(vtkMRMLNode* node, int visible);
+
+  vtkSmartPointer<vtkCallbackCommand> CallBack;
+  vtkMRMLScene* MRMLScene;
+
+  /// Nodes in the order of the scene. The nodes removed while the scene is
+  /// batch processing are set to 0 until the end of the batch processing.
+  QVector<vtkMRMLNode*> Nodes;
+  /// Row of each node in Nodes. Only the rows lower than UpToDateRowCount
+  /// are guaranteed to be up to date, the others are updated on demand.
+  mutable QHash<vtkMRMLNode*, int> NodeRows;
+  mutable int UpToDateRowCount;
+  /// Number of rows exposed to the views.
+  int FetchedRowCount;
+  int FetchBatchSize;
+  bool FetchedAllBeforeBatchProcess;
+
+  qMRMLSceneModel::NodeTypes ListenNodeModifiedEvent;
+
+  int NameColumn;
+  int IDColumn;
+  int CheckableColumn;
+  int VisibilityColumn;
+  int ToolTipNameColumn;
+
+  QIcon VisibleIcon;
+  QIcon HiddenIcon;
+  QIcon PartiallyVisibleIcon;
+};
+
+//------------------------------------------------------------------------------
+qMRMLSceneVirtualModelPrivate::qMRMLSceneVirtualModelPrivate(qMRMLSceneVirtualModel& object)
+  : q_ptr(&object)
+{
+  this->CallBack = vtkSmartPointer<vtkCallbackCommand>::New();
+  this->MRMLScene = 0;
+  this->UpToDateRowCount = 0;
+  this->FetchedRowCount = 0;
+  this->FetchBatchSize = 1000;
+  this->FetchedAllBeforeBatchProcess = false;
+  this->ListenNodeModifiedEvent = qMRMLSceneModel::NoNodes;
+
+  this->NameColumn = -1;
+  this->IDColumn = -1;
+  this->CheckableColumn = -1;
+  this->VisibilityColumn = -1;
+  this->ToolTipNameColumn = -1;
+
+  this->HiddenIcon = QIcon(":Icons/VisibleOff.png");
+  this->VisibleIcon = QIcon(":Icons/VisibleOn.png");
+  this->PartiallyVisibleIcon = QIcon(":Icons/VisiblePartially.png");
+}
+
+//------------------------------------------------------------------------------
+qMRMLSceneVirtualModelPrivate::~qMRMLSceneVirtualModelPrivate()
+{
+  if (this->MRMLScene)
+    {
+    this->MRMLScene->RemoveObserver(this->CallBack);
+    }
+}
+
+//------------------------------------------------------------------------------
+void qMRMLSceneVirtualModelPrivate::init()
+{
+  Q_Q(qMRMLSceneVirtualModel);
+  this->CallBack->SetClientData(q);
+  this->CallBack->SetCallback(qMRMLSceneVirtualModel::onMRMLSceneEvent);
+
+  this->NameColumn = 0;
+  q->setListenNodeModifiedEvent(qMRMLSceneModel::OnlyVisibleNodes);
+}
+
+//------------------------------------------------------------------------------
+bool qMRMLSceneVirtualModelPrivate::isSceneIndex(const QModelIndex& index)const
+{
+  Q_Q(const qMRMLSceneVirtualModel);
+  return index.isValid() && index.model() == q &&
+    index.internalId() == SceneItemId && index.column() == 0;
+}
+
+//------------------------------------------------------------------------------
+void qMRMLSceneVirtualModelPrivate::updateNodeRows()const
+{
+  const int rowCount = this->Nodes.size();
+  for (int row = this->UpToDateRowCount; row < rowCount; ++row)
+    {
+    vtkMRMLNode* node = this->Nodes[row];
+    if (node)
+      {
+      this->NodeRows[node] = row;
+      }
+    }
+  this->UpToDateRowCount = rowCount;
+}
+
+//------------------------------------------------------------------------------
+void qMRMLSceneVirtualModelPrivate::fetchRows(int lastRow)
+{
+  Q_Q(qMRMLSceneVirtualModel);
+  lastRow = qMin(lastRow, this->Nodes.size() - 1);
+  const int firstRow = this->FetchedRowCount;
+  if (lastRow < firstRow)
+    {
+    return;
+    }
+  q->beginInsertRows(q->mrmlSceneIndex(), firstRow, lastRow);
+  this->FetchedRowCount = lastRow + 1;
+  q->endInsertRows();
+  if (this->ListenNodeModifiedEvent == qMRMLSceneModel::AllNodes)
+    {
+    for (int row = firstRow; row <= lastRow; ++row)
+      {
+      q->observeNode(this->Nodes[row]);
+      }
+    }
+}
+
+//------------------------------------------------------------------------------
+void qMRMLSceneVirtualModelPrivate::removeRows(int first, int last)
+{
+  Q_Q(qMRMLSceneVirtualModel);
+  // Removed nodes are either all exposed or all not exposed.
+  const bool fetched = (first < this->FetchedRowCount);
+  Q_ASSERT(!fetched || last < this->FetchedRowCount);
+  if (fetched)
+    {
+    q->beginRemoveRows(q->mrmlSceneIndex(), first, last);
+    }
+  for (int row = first; row <= last; ++row)
+    {
+    if (this->Nodes[row])
+      {
+      this->NodeRows.remove(this->Nodes[row]);
+      }
+    }
+  this->Nodes.remove(first, last - first + 1);
+  this->UpToDateRowCount = qMin(this->UpToDateRowCount, first);
+  if (fetched)
+    {
+    this->FetchedRowCount -= last - first + 1;
+    q->endRemoveRows();
+    }
+}
+
+//------------------------------------------------------------------------------
+void qMRMLSceneVirtualModelPrivate::removeRemovedNodeRows()
+{
+  // Remove the contiguous removed rows at once, starting from the last rows
+  // to not change the rows of the removed nodes that are not removed yet.
+  int last = this->FetchedRowCount - 1;
+  while (last >= 0)
+    {
+    if (this->Nodes[last] != 0)
+      {
+      --last;
+      continue;
+      }
+    int first = last;
+    while (first > 0 && this->Nodes[first - 1] == 0)
+      {
+      --first;
+      }
+    this->removeRows(first, last);
+    last = first - 1;
+    }
+}
+
+//------------------------------------------------------------------------------
+void qMRMLSceneVirtualModelPrivate::listenNodeModifiedEvent()
+{
+  Q_Q(qMRMLSceneVirtualModel);
+  q->qvtkDisconnect(0, vtkCommand::ModifiedEvent,
+                    q, SLOT(onMRMLNodeModified(vtkObject*)));
+  q->qvtkDisconnect(0, vtkMRMLNode::IDChangedEvent,
+                    q, SLOT(onMRMLNodeModified(vtkObject*)));
+  if (this->ListenNodeModifiedEvent != qMRMLSceneModel::AllNodes)
+    {
+    return;
+    }
+  for (int row = 0; row < this->FetchedRowCount; ++row)
+    {
+    if (this->Nodes[row])
+      {
+      q->observeNode(this->Nodes[row]);
+      }
+    }
+}
+
+//------------------------------------------------------------------------------
+void qMRMLSceneVirtualModelPrivate::resetColumns()
+{
+  Q_Q(qMRMLSceneVirtualModel);
+  // The columns are typically set once when the model is created, there is no
+  // need to signal each inserted or removed column.
+  q->beginResetModel();
+  q->endResetModel();
+}
+
+//------------------------------------------------------------------------------
+int qMRMLSceneVirtualModelPrivate::nodeVisibility(vtkMRMLNode* node)const
+{
+  vtkMRMLDisplayNode* displayNode = vtkMRMLDisplayNode::SafeDownCast(node);
+  vtkMRMLDisplayableNode* displayableNode =
+    vtkMRMLDisplayableNode::SafeDownCast(node);
+  vtkMRMLDisplayableHierarchyNode* displayableHierarchyNode =
+    vtkMRMLDisplayableHierarchyNode::SafeDownCast(node);
+  if (displayableHierarchyNode)
+    {
+    displayNode = displayableHierarchyNode->GetDisplayNode();
+    }
+  if (displayNode)
+    {
+    return displayNode->GetVisibility();
+    }
+  if (!displayableNode)
+    {
+    return -1;
+    }
+  std::string displayType;
+  vtkMRMLSelectionNode* selectionNode = vtkMRMLSelectionNode::SafeDownCast(
+    this->MRMLScene->GetNodeByID("vtkMRMLSelectionNodeSingleton"));
+  if (selectionNode)
+    {
+    displayType = selectionNode->GetModelHierarchyDisplayNodeClassName(
+      node->GetClassName());
+    }
+  if (!displayType.empty())
+    {
+    return displayableNode->GetDisplayClassVisibility(displayType.c_str());
+    }
+  return displayableNode->GetDisplayVisibility();
+}
+
+//------------------------------------------------------------------------------
+void qMRMLSceneVirtualModelPrivate::setNodeVisibility(vtkMRMLNode* node, int visible)
+{
+  vtkMRMLDisplayNode* displayNode = vtkMRMLDisplayNode::SafeDownCast(node);
+  vtkMRMLDisplayableNode* displayableNode =
+    vtkMRMLDisplayableNode::SafeDownCast(node);
+  vtkMRMLDisplayableHierarchyNode* displayableHierarchyNode =
+    vtkMRMLDisplayableHierarchyNode::SafeDownCast(node);
+  if (displayableHierarchyNode)
+    {
+    displayNode = displayableHierarchyNode->GetDisplayNode();
+    }
+  if (displayNode)
+    {
+    displayNode->SetVisibility(visible);
+    return;
+    }
+  if (!displayableNode)
+    {
+    return;
+    }
+  std::string displayType;
+  vtkMRMLSelectionNode* selectionNode = vtkMRMLSelectionNode::SafeDownCast(
+    this->MRMLScene->GetNodeByID("vtkMRMLSelectionNodeSingleton"));
+  if (selectionNode)
+    {
+    displayType = selectionNode->GetModelHierarchyDisplayNodeClassName(
+      node->GetClassName());
+    }
+  if (!displayType.empty())
+    {
+    displayableNode->SetDisplayClassVisibility(displayType.c_str(), visible);
+    }
+  else
+    {
+    displayableNode->SetDisplayVisibility(visible);
+    }
+}
+
+//------------------------------------------------------------------------------
+// qMRMLSceneVirtualModel
+//------------------------------------------------------------------------------
+qMRMLSceneVirtualModel::qMRMLSceneVirtualModel(QObject *_parent)
+  : QAbstractItemModel(_parent)
+  , d_ptr(new qMRMLSceneVirtualModelPrivate(*this))
+{
+  Q_D(qMRMLSceneVirtualModel);
+  d->init();
+}
+
+//------------------------------------------------------------------------------
+qMRMLSceneVirtualModel::~qMRMLSceneVirtualModel()
+{
+}
+
+//------------------------------------------------------------------------------
+void qMRMLSceneVirtualModel::setMRMLScene(vtkMRMLScene* scene)
+{
+  Q_D(qMRMLSceneVirtualModel);
+  if (scene == d->MRMLScene)
+    {
+    return;
+    }
+  if (d->MRMLScene)
+    {
+    d->MRMLScene->RemoveObserver(d->CallBack);
+    }
+  d->MRMLScene = scene;
+  this->updateScene();
+  if (scene)
+    {
+    scene->AddObserver(vtkMRMLScene::NodeAddedEvent, d->CallBack, 10.);
+    scene->AddObserver(vtkMRMLScene::NodeAboutToBeRemovedEvent, d->CallBack, -10.);
+    scene->AddObserver(vtkCommand::DeleteEvent, d->CallBack);
+    scene->AddObserver(vtkMRMLScene::StartBatchProcessEvent, d->CallBack);
+    scene->AddObserver(vtkMRMLScene::EndBatchProcessEvent, d->CallBack);
+    }
+}
+
+//------------------------------------------------------------------------------
+vtkMRMLScene* qMRMLSceneVirtualModel::mrmlScene()const
+{
+  Q_D(const qMRMLSceneVirtualModel);
+  return d->MRMLScene;
+}
+
+//------------------------------------------------------------------------------
+QModelIndex qMRMLSceneVirtualModel::mrmlSceneIndex()const
+{
+  Q_D(const qMRMLSceneVirtualModel);
+  return d->MRMLScene ? this->createIndex(0, 0, SceneItemId) : QModelIndex();
+}
+
+//------------------------------------------------------------------------------
+vtkMRMLNode* qMRMLSceneVirtualModel::mrmlNodeFromIndex(const QModelIndex &nodeIndex)const
+{
+  Q_D(const qMRMLSceneVirtualModel);
+  if (!nodeIndex.isValid() || nodeIndex.model() != this ||
+      nodeIndex.internalId() != NodeItemId ||
+      nodeIndex.row() >= d->FetchedRowCount)
+    {
+    return 0;
+    }
+  return d->Nodes[nodeIndex.row()];
+}
+
+//------------------------------------------------------------------------------
+QModelIndex qMRMLSceneVirtualModel::indexFromNode(vtkMRMLNode* node, int column)const
+{
+  Q_D(const qMRMLSceneVirtualModel);
+  const int row = this->nodeRow(node);
+  if (row < 0)
+    {
+    return QModelIndex();
+    }
+  if (row >= d->FetchedRowCount)
+    {
+    // Fetch up to the end of the batch that contains the node.
+    const int lastRow = d->FetchBatchSize > 0 ?
+      (row / d->FetchBatchSize + 1) * d->FetchBatchSize - 1 : d->Nodes.size() - 1;
+    const_cast<qMRMLSceneVirtualModelPrivate*>(d)->fetchRows(lastRow);
+    }
+  return this->index(row, column, this->mrmlSceneIndex());
+}
+
+//------------------------------------------------------------------------------
+int qMRMLSceneVirtualModel::nodeRow(vtkMRMLNode* node)const
+{
+  Q_D(const qMRMLSceneVirtualModel);
+  QHash<vtkMRMLNode*, int>::const_iterator it = d->NodeRows.find(node);
+  if (it != d->NodeRows.end() && it.value() < d->UpToDateRowCount)
+    {
+    return it.value();
+    }
+  if (d->UpToDateRowCount == d->Nodes.size())
+    {
+    return -1;
+    }
+  d->updateNodeRows();
+  return d->NodeRows.value(node, -1);
+}
+
+//------------------------------------------------------------------------------
+bool qMRMLSceneVirtualModel::isAffiliatedNode(vtkMRMLNode* nodeA, vtkMRMLNode* nodeB)const
+{
+  return nodeA == nodeB;
+}
+
+//------------------------------------------------------------------------------
+void qMRMLSceneVirtualModel::setListenNodeModifiedEvent(qMRMLSceneModel::NodeTypes listen)
+{
+  Q_D(qMRMLSceneVirtualModel);
+  if (d->ListenNodeModifiedEvent == listen)
+    {
+    return;
+    }
+  d->ListenNodeModifiedEvent = listen;
+  d->listenNodeModifiedEvent();
+}
+
+//------------------------------------------------------------------------------
+qMRMLSceneModel::NodeTypes qMRMLSceneVirtualModel::listenNodeModifiedEvent()const
+{
+  Q_D(const qMRMLSceneVirtualModel);
+  return d->ListenNodeModifiedEvent;
+}
+
+//------------------------------------------------------------------------------
+int qMRMLSceneVirtualModel::fetchBatchSize()const
+{
+  Q_D(const qMRMLSceneVirtualModel);
+  return d->FetchBatchSize;
+}
+
+//------------------------------------------------------------------------------
+void qMRMLSceneVirtualModel::setFetchBatchSize(int batchSize)
+{
+  Q_D(qMRMLSceneVirtualModel);
+  d->FetchBatchSize = qMax(batchSize, 0);
+  if (d->FetchBatchSize == 0)
+    {
+    d->fetchRows(d->Nodes.size() - 1);
+    }
+}
+
+//------------------------------------------------------------------------------
+void qMRMLSceneVirtualModel::observeNode(vtkMRMLNode* node)
+{
+  qvtkConnect(node, vtkCommand::ModifiedEvent,
+              this, SLOT(onMRMLNodeModified(vtkObject*)));
+  qvtkConnect(node, vtkMRMLNode::IDChangedEvent,
+              this, SLOT(onMRMLNodeModified(vtkObject*)));
+}
+
+//------------------------------------------------------------------------------
+QModelIndex qMRMLSceneVirtualModel::index(int row, int column,
+                                          const QModelIndex& parentIndex)const
+{
+  Q_D(const qMRMLSceneVirtualModel);
+  if (row < 0 || column < 0 || column >= this->columnCount(parentIndex))
+    {
+    return QModelIndex();
+    }
+  if (!parentIndex.isValid())
+    {
+    return (d->MRMLScene && row == 0) ?
+      this->createIndex(row, column, SceneItemId) : QModelIndex();
+    }
+  if (d->isSceneIndex(parentIndex) && row < d->FetchedRowCount)
+    {
+    return this->createIndex(row, column, NodeItemId);
+    }
+  return QModelIndex();
+}
+
+//------------------------------------------------------------------------------
+QModelIndex qMRMLSceneVirtualModel::parent(const QModelIndex& child)const
+{
+  if (!child.isValid() || child.internalId() != NodeItemId)
+    {
+    return QModelIndex();
+    }
+  return this->mrmlSceneIndex();
+}
+
+//------------------------------------------------------------------------------
+int qMRMLSceneVirtualModel::rowCount(const QModelIndex& parentIndex)const
+{
+  Q_D(const qMRMLSceneVirtualModel);
+  if (!parentIndex.isValid())
+    {
+    return d->MRMLScene ? 1 : 0;
+    }
+  return d->isSceneIndex(parentIndex) ? d->FetchedRowCount : 0;
+}
+
+//------------------------------------------------------------------------------
+int qMRMLSceneVirtualModel::columnCount(const QModelIndex& parentIndex)const
+{
+  Q_UNUSED(parentIndex);
+  return this->maxColumnId() + 1;
+}
+
+//------------------------------------------------------------------------------
+bool qMRMLSceneVirtualModel::hasChildren(const QModelIndex& parentIndex)const
+{
+  Q_D(const qMRMLSceneVirtualModel);
+  if (!parentIndex.isValid())
+    {
+    return d->MRMLScene != 0;
+    }
+  // The scene may have children that are not fetched yet
+  return d->isSceneIndex(parentIndex) && !d->Nodes.isEmpty();
+}
+
+//------------------------------------------------------------------------------
+bool qMRMLSceneVirtualModel::canFetchMore(const QModelIndex& parentIndex)const
+{
+  Q_D(const qMRMLSceneVirtualModel);
+  return d->isSceneIndex(parentIndex) &&
+    d->FetchedRowCount < d->Nodes.size();
+}
+
+//------------------------------------------------------------------------------
+void qMRMLSceneVirtualModel::fetchMore(const QModelIndex& parentIndex)
+{
+  Q_D(qMRMLSceneVirtualModel);
+  if (!this->canFetchMore(parentIndex))
+    {
+    return;
+    }
+  d->fetchRows(d->FetchBatchSize > 0 ?
+    d->FetchedRowCount + d->FetchBatchSize - 1 : d->Nodes.size() - 1);
+}
+
+//------------------------------------------------------------------------------
+QVariant qMRMLSceneVirtualModel::data(const QModelIndex& modelIndex, int role)const
+{
+  Q_D(const qMRMLSceneVirtualModel);
+  if (!modelIndex.isValid() || modelIndex.model() != this)
+    {
+    return QVariant();
+    }
+  if (modelIndex.internalId() == SceneItemId)
+    {
+    if (modelIndex.column() != 0)
+      {
+      return QVariant();
+      }
+    switch (role)
+      {
+      case Qt::DisplayRole:
+        return QString("Scene");
+      case qMRMLSceneModel::UIDRole:
+        return QString("scene");
+      case qMRMLSceneModel::PointerRole:
+        return QVariant::fromValue(reinterpret_cast<long long>(d->MRMLScene));
+      default:
+        return QVariant();
+      }
+    }
+  vtkMRMLNode* node = this->mrmlNodeFromIndex(modelIndex);
+  if (!node)
+    {
+    return QVariant();
+    }
+  return this->nodeData(node, modelIndex.column(), role);
+}
+
+//------------------------------------------------------------------------------
+QVariant qMRMLSceneVirtualModel::nodeData(vtkMRMLNode* node, int column, int role)const
+{
+  Q_D(const qMRMLSceneVirtualModel);
+  switch (role)
+    {
+    case qMRMLSceneModel::UIDRole:
+      return QString(node->GetID());
+    case qMRMLSceneModel::PointerRole:
+      return QVariant::fromValue(reinterpret_cast<long long>(node));
+    case Qt::DisplayRole:
+    case Qt::EditRole:
+      if (column == this->idColumn())
+        {
+        return QString(node->GetID());
+        }
+      if (column == this->nameColumn())
+        {
+        return QString(node->GetName());
+        }
+      break;
+    case Qt::ToolTipRole:
+      if (column == this->toolTipNameColumn())
+        {
+        return QString(node->GetName());
+        }
+      if (column == this->nameColumn())
+        {
+        return QString(node->GetNodeTagName());
+        }
+      break;
+    case Qt::CheckStateRole:
+      if (column == this->checkableColumn())
+        {
+        return node->GetSelected() ? Qt::Checked : Qt::Unchecked;
+        }
+      break;
+    case qMRMLSceneModel::VisibilityRole:
+      if (column == this->visibilityColumn())
+        {
+        return d->nodeVisibility(node);
+        }
+      break;
+    case Qt::DecorationRole:
+      if (column == this->visibilityColumn())
+        {
+        switch (d->nodeVisibility(node))
+          {
+          case 0:
+            return d->HiddenIcon;
+          case 1:
+            return d->VisibleIcon;
+          case 2:
+            return d->PartiallyVisibleIcon;
+          default:
+            break;
+          }
+        }
+      break;
+    default:
+      break;
+    }
+  return QVariant();
+}
+
+//------------------------------------------------------------------------------
+bool qMRMLSceneVirtualModel::setData(const QModelIndex& modelIndex,
+                                     const QVariant& value, int role)
+{
+  vtkMRMLNode* node = this->mrmlNodeFromIndex(modelIndex);
+  if (!node || !this->setNodeData(node, modelIndex.column(), value, role))
+    {
+    return false;
+    }
+  emit dataChanged(modelIndex, modelIndex);
+  return true;
+}
+
+//------------------------------------------------------------------------------
+bool qMRMLSceneVirtualModel::setNodeData(vtkMRMLNode* node, int column,
+                                         const QVariant& value, int role)
+{
+  Q_D(qMRMLSceneVirtualModel);
+  if (column == this->nameColumn() &&
+      (role == Qt::EditRole || role == Qt::DisplayRole))
+    {
+    node->SetName(value.toString().toLatin1());
+    return true;
+    }
+  if (column == this->checkableColumn() && role == Qt::CheckStateRole)
+    {
+    node->SetSelected(value.toInt() == Qt::Checked ? 1 : 0);
+    return true;
+    }
+  if (column == this->visibilityColumn() &&
+      role == qMRMLSceneModel::VisibilityRole)
+    {
+    d->setNodeVisibility(node, value.toInt());
+    return true;
+    }
+  return false;
+}
+
+//------------------------------------------------------------------------------
+Qt::ItemFlags qMRMLSceneVirtualModel::flags(const QModelIndex& modelIndex)const
+{
+  if (!modelIndex.isValid())
+    {
+    return Qt::ItemIsEnabled;
+    }
+  if (modelIndex.internalId() == SceneItemId)
+    {
+    return modelIndex.column() == 0 ? Qt::ItemIsEnabled : Qt::ItemFlags(0);
+    }
+  vtkMRMLNode* node = this->mrmlNodeFromIndex(modelIndex);
+  return node ? this->nodeFlags(node, modelIndex.column()) : Qt::ItemFlags(0);
+}
+
+//------------------------------------------------------------------------------
+Qt::ItemFlags qMRMLSceneVirtualModel::nodeFlags(vtkMRMLNode* node, int column)const
+{
+  Qt::ItemFlags flags = Qt::ItemIsEnabled | Qt::ItemIsSelectable;
+  if (column == this->checkableColumn() && node->GetSelectable())
+    {
+    flags = flags | Qt::ItemIsUserCheckable;
+    }
+  if (column == this->nameColumn())
+    {
+    flags = flags | Qt::ItemIsEditable;
+    }
+  return flags;
+}
+
+//------------------------------------------------------------------------------
+void qMRMLSceneVirtualModel::updateScene()
+{
+  Q_D(qMRMLSceneVirtualModel);
+  this->beginResetModel();
+
+  qvtkDisconnect(0, vtkCommand::ModifiedEvent,
+                 this, SLOT(onMRMLNodeModified(vtkObject*)));
+  qvtkDisconnect(0, vtkMRMLNode::IDChangedEvent,
+                 this, SLOT(onMRMLNodeModified(vtkObject*)));
+
+  d->Nodes.clear();
+  d->NodeRows.clear();
+  d->UpToDateRowCount = 0;
+  d->FetchedRowCount = 0;
+  if (d->MRMLScene)
+    {
+    vtkCollection* nodes = d->MRMLScene->GetNodes();
+    d->Nodes.reserve(nodes->GetNumberOfItems());
+    vtkMRMLNode* node = 0;
+    vtkCollectionSimpleIterator it;
+    for (nodes->InitTraversal(it);
+         (node = vtkMRMLNode::SafeDownCast(nodes->GetNextItemAsObject(it))) ;)
+      {
+      d->Nodes.append(node);
+      }
+    // Expose the first batch of nodes, the node rows are computed on demand.
+    d->FetchedRowCount = d->FetchBatchSize > 0 ?
+      qMin(d->FetchBatchSize, d->Nodes.size()) : d->Nodes.size();
+    }
+  d->listenNodeModifiedEvent();
+
+  this->endResetModel();
+}
+
+//-----------------------------------------------------------------------------
+void qMRMLSceneVirtualModel::onMRMLSceneEvent(vtkObject* vtk_obj, unsigned long event,
+                                              void* client_data, void* call_data)
+{
+  vtkMRMLScene* scene = reinterpret_cast<vtkMRMLScene*>(vtk_obj);
+  qMRMLSceneVirtualModel* sceneModel =
+    reinterpret_cast<qMRMLSceneVirtualModel*>(client_data);
+  vtkMRMLNode* node = reinterpret_cast<vtkMRMLNode*>(call_data);
+  Q_ASSERT(scene);
+  Q_ASSERT(sceneModel);
+  switch(event)
+    {
+    case vtkMRMLScene::NodeAddedEvent:
+      Q_ASSERT(node);
+      sceneModel->onMRMLSceneNodeAdded(scene, node);
+      break;
+    case vtkMRMLScene::NodeAboutToBeRemovedEvent:
+      Q_ASSERT(node);
+      sceneModel->onMRMLSceneNodeAboutToBeRemoved(scene, node);
+      break;
+    case vtkCommand::DeleteEvent:
+      sceneModel->onMRMLSceneDeleted(scene);
+      break;
+    case vtkMRMLScene::StartBatchProcessEvent:
+      sceneModel->onMRMLSceneStartBatchProcess(scene);
+      break;
+    case vtkMRMLScene::EndBatchProcessEvent:
+      sceneModel->onMRMLSceneEndBatchProcess(scene);
+      break;
+    }
+}
+
+//------------------------------------------------------------------------------
+void qMRMLSceneVirtualModel::onMRMLSceneNodeAdded(vtkMRMLScene* scene, vtkMRMLNode* node)
+{
+  Q_D(qMRMLSceneVirtualModel);
+  Q_UNUSED(scene);
+  Q_ASSERT(scene == d->MRMLScene);
+  if (d->NodeRows.contains(node))
+    {
+    return;
+    }
+  // Nodes are appended to the scene. While the scene is batch processing or
+  // if the last rows are not fetched yet, the new row is not exposed: it is
+  // exposed at the end of the batch processing or when more rows are fetched.
+  const int row = d->Nodes.size();
+  const bool expose = !d->MRMLScene->IsBatchProcessing() &&
+    d->FetchedRowCount == row;
+  if (expose)
+    {
+    this->beginInsertRows(this->mrmlSceneIndex(), row, row);
+    }
+  d->Nodes.append(node);
+  d->NodeRows[node] = row;
+  if (expose)
+    {
+    ++d->FetchedRowCount;
+    this->endInsertRows();
+    if (d->ListenNodeModifiedEvent == qMRMLSceneModel::AllNodes)
+      {
+      this->observeNode(node);
+      }
+    }
+}
+
+//------------------------------------------------------------------------------
+void qMRMLSceneVirtualModel::onMRMLSceneNodeAboutToBeRemoved(vtkMRMLScene* scene, vtkMRMLNode* node)
+{
+  Q_D(qMRMLSceneVirtualModel);
+  Q_UNUSED(scene);
+  Q_ASSERT(scene == d->MRMLScene);
+  const int row = this->nodeRow(node);
+  if (row < 0)
+    {
+    // The node has been added with vtkMRMLScene::AddNodeNoNotify()
+    return;
+    }
+  qvtkDisconnect(node, vtkCommand::NoEvent, this, 0);
+  if (d->MRMLScene->IsBatchProcessing() && row < d->FetchedRowCount)
+    {
+    // The row is removed with the other removed rows at the end of the batch
+    // processing. Until then it has no data.
+    d->Nodes[row] = 0;
+    d->NodeRows.remove(node);
+    return;
+    }
+  d->removeRows(row, row);
+}
+
+//------------------------------------------------------------------------------
+void qMRMLSceneVirtualModel::onMRMLSceneStartBatchProcess(vtkMRMLScene* scene)
+{
+  Q_D(qMRMLSceneVirtualModel);
+  Q_UNUSED(scene);
+  d->FetchedAllBeforeBatchProcess = (d->FetchedRowCount == d->Nodes.size());
+}
+
+//------------------------------------------------------------------------------
+void qMRMLSceneVirtualModel::onMRMLSceneEndBatchProcess(vtkMRMLScene* scene)
+{
+  Q_D(qMRMLSceneVirtualModel);
+  Q_UNUSED(scene);
+  d->removeRemovedNodeRows();
+  // Signal the nodes added during the batch processing at once.
+  if (d->FetchedAllBeforeBatchProcess)
+    {
+    this->fetchMore(this->mrmlSceneIndex());
+    }
+}
+
+//------------------------------------------------------------------------------
+void qMRMLSceneVirtualModel::onMRMLSceneDeleted(vtkObject* scene)
+{
+  Q_UNUSED(scene);
+  this->setMRMLScene(0);
+}
+
+//------------------------------------------------------------------------------
+void qMRMLSceneVirtualModel::onMRMLNodeModified(vtkObject* node)
+{
+  const int row = this->nodeRow(vtkMRMLNode::SafeDownCast(node));
+  if (row < 0 || row >= this->rowCount(this->mrmlSceneIndex()))
+    {
+    return;
+    }
+  QModelIndex sceneIndex = this->mrmlSceneIndex();
+  emit dataChanged(this->index(row, 0, sceneIndex),
+                   this->index(row, this->columnCount() - 1, sceneIndex));
+}
+
+//------------------------------------------------------------------------------
+int qMRMLSceneVirtualModel::nameColumn()const
+{
+  Q_D(const qMRMLSceneVirtualModel);
+  return d->NameColumn;
+}
+
+//------------------------------------------------------------------------------
+void qMRMLSceneVirtualModel::setNameColumn(int column)
+{
+  Q_D(qMRMLSceneVirtualModel);
+  d->NameColumn = column;
+  d->resetColumns();
+}
+
+//------------------------------------------------------------------------------
+int qMRMLSceneVirtualModel::idColumn()const
+{
+  Q_D(const qMRMLSceneVirtualModel);
+  return d->IDColumn;
+}
+
+//------------------------------------------------------------------------------
+void qMRMLSceneVirtualModel::setIDColumn(int column)
+{
+  Q_D(qMRMLSceneVirtualModel);
+  d->IDColumn = column;
+  d->resetColumns();
+}
+
+//------------------------------------------------------------------------------
+int qMRMLSceneVirtualModel::checkableColumn()const
+{
+  Q_D(const qMRMLSceneVirtualModel);
+  return d->CheckableColumn;
+}
+
+//------------------------------------------------------------------------------
+void qMRMLSceneVirtualModel::setCheckableColumn(int column)
+{
+  Q_D(qMRMLSceneVirtualModel);
+  d->CheckableColumn = column;
+  d->resetColumns();
+}
+
+//------------------------------------------------------------------------------
+int qMRMLSceneVirtualModel::visibilityColumn()const
+{
+  Q_D(const qMRMLSceneVirtualModel);
+  return d->VisibilityColumn;
+}
+
+//------------------------------------------------------------------------------
+void qMRMLSceneVirtualModel::setVisibilityColumn(int column)
+{
+  Q_D(qMRMLSceneVirtualModel);
+  d->VisibilityColumn = column;
+  d->resetColumns();
+}
+
+//------------------------------------------------------------------------------
+int qMRMLSceneVirtualModel::toolTipNameColumn()const
+{
+  Q_D(const qMRMLSceneVirtualModel);
+  return d->ToolTipNameColumn;
+}
+
+//------------------------------------------------------------------------------
+void qMRMLSceneVirtualModel::setToolTipNameColumn(int column)
+{
+  Q_D(qMRMLSceneVirtualModel);
+  d->ToolTipNameColumn = column;
+  d->resetColumns();
+}
+
+//------------------------------------------------------------------------------
+int qMRMLSceneVirtualModel::maxColumnId()const
+{
+  Q_D(const qMRMLSceneVirtualModel);
+  int maxId = 0; // the scene is in the 1st column
+  maxId = qMax(maxId, d->NameColumn);
+  maxId = qMax(maxId, d->IDColumn);
+  maxId = qMax(maxId, d->CheckableColumn);
+  maxId = qMax(maxId, d->VisibilityColumn);
+  maxId = qMax(maxId, d->ToolTipNameColumn);
+  return maxId;
+}
@@ -0,0 +1,187 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  Copyright (c) Kitware Inc.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+#ifndef __qMRMLSceneVirtualModel_h
+#define __qMRMLSceneVirtualModel_h
+
+// Qt includes
+#include <QAbstractItemModel>
+
+// CTK includes
+#include <ctkPimpl.h>
+#include <ctkVTKObject.h>
+
+// qMRML includes
+#include "qMRMLSceneModel.h"
+#include "qMRMLWidgetsExport.h"
+
+class vtkMRMLNode;
+class vtkMRMLScene;
+
+class qMRMLSceneVirtualModelPrivate;
+
+/// qMRMLSceneVirtualModel is a lightweight alternative to qMRMLSceneModel for
+/// large scenes. It has the same layout as qMRMLSceneModel (the scene as a
+/// top level item and the nodes as its children) and provides the same data
+/// roles (qMRMLSceneModel::UIDRole, PointerRole, VisibilityRole), but no
+/// QStandardItem is created: the data is read from the nodes when requested.
+///
+/// The rows of the nodes are exposed to the views by batches of
+/// \a fetchBatchSize nodes (see canFetchMore() and fetchMore()), the position
+/// of each node is kept in a hash table and the rows added or removed while
+/// the scene is batch processing (import, close, restore...) are signaled
+/// once the batch processing is over.
+///
+/// It can be used as a source model of qMRMLSortFilterProxyModel.
+/// Extra items (pre/post items), hierarchies and drag and drop are not
+/// supported.
+/// \sa qMRMLSceneModel
+class QMRML_WIDGETS_EXPORT qMRMLSceneVirtualModel : public QAbstractItemModel
+{
+  Q_OBJECT
+  QVTK_OBJECT
+
+  /// This property controls whether to observe or not the modified event of
+  /// the node and signal dataChanged() accordingly.
+  /// OnlyVisibleNodes by default.
+  /// \sa qMRMLSceneModel::listenNodeModifiedEvent
+  Q_PROPERTY (qMRMLSceneModel::NodeTypes listenNodeModifiedEvent READ listenNodeModifiedEvent WRITE setListenNodeModifiedEvent)
+
+  /// Number of node rows exposed each time fetchMore() is called.
+  /// A value of 0 exposes all the nodes at once, it is useful for views
+  /// that never call fetchMore() (e.g. QComboBox).
+  /// 1000 by default.
+  Q_PROPERTY (int fetchBatchSize READ fetchBatchSize WRITE setFetchBatchSize)
+
+  /// Control in which column vtkMRMLNode names are displayed (Qt::DisplayRole).
+  /// A value of -1 hides it. First column (0) by default.
+  Q_PROPERTY (int nameColumn READ nameColumn WRITE setNameColumn)
+  /// Control in which column vtkMRMLNode IDs are displayed (Qt::DisplayRole).
+  /// A value of -1 hides it. Hidden by default (value of -1)
+  Q_PROPERTY (int idColumn READ idColumn WRITE setIDColumn)
+  /// Control in which column vtkMRMLNode::Selected are displayed (Qt::CheckStateRole).
+  /// A value of -1 hides it. Hidden by default (value of -1).
+  Q_PROPERTY (int checkableColumn READ checkableColumn WRITE setCheckableColumn)
+  /// Control in which column vtkMRMLNode::Visibility are displayed (Qt::DecorationRole).
+  /// A value of -1 hides it. Hidden by default (value of -1).
+  Q_PROPERTY (int visibilityColumn READ visibilityColumn WRITE setVisibilityColumn)
+  /// Control in which column tooltips are displayed (Qt::ToolTipRole).
+  /// A value of -1 hides it. Hidden by default (value of -1).
+  Q_PROPERTY (int toolTipNameColumn READ toolTipNameColumn WRITE setToolTipNameColumn)
+public:
+  typedef QAbstractItemModel Superclass;
+  qMRMLSceneVirtualModel(QObject *parent=0);
+  virtual ~qMRMLSceneVirtualModel();
+
+  /// 0 by default
+  Q_INVOKABLE virtual void setMRMLScene(vtkMRMLScene* scene);
+  Q_INVOKABLE vtkMRMLScene* mrmlScene()const;
+
+  /// invalid until a valid scene is set
+  QModelIndex mrmlSceneIndex()const;
+
+  /// Return the vtkMRMLNode associated to the node index.
+  /// 0 if the node index is not a MRML node (i.e. vtkMRMLScene)
+  vtkMRMLNode* mrmlNodeFromIndex(const QModelIndex &nodeIndex)const;
+  /// Return the index of the node. The rows are fetched up to the node row
+  /// if needed.
+  QModelIndex indexFromNode(vtkMRMLNode* node, int column = 0)const;
+  /// Return the row of the node under the scene index, -1 if the node is not
+  /// in the model. The row may not have been fetched yet.
+  int nodeRow(vtkMRMLNode* node)const;
+
+  /// Return true if the 2 nodes are the same node. There is no hierarchy
+  /// in the model.
+  /// \sa qMRMLSceneModel::isAffiliatedNode()
+  bool isAffiliatedNode(vtkMRMLNode* nodeA, vtkMRMLNode* nodeB)const;
+
+  void setListenNodeModifiedEvent(qMRMLSceneModel::NodeTypes nodesToListen);
+  qMRMLSceneModel::NodeTypes listenNodeModifiedEvent()const;
+
+  int fetchBatchSize()const;
+  void setFetchBatchSize(int batchSize);
+
+  int nameColumn()const;
+  void setNameColumn(int column);
+
+  int idColumn()const;
+  void setIDColumn(int column);
+
+  int checkableColumn()const;
+  void setCheckableColumn(int column);
+
+  int visibilityColumn()const;
+  void setVisibilityColumn(int column);
+
+  int toolTipNameColumn()const;
+  void setToolTipNameColumn(int column);
+
+  /// Observe node and signal dataChanged() when the node is modified.
+  /// \sa listenNodeModifiedEvent
+  virtual void observeNode(vtkMRMLNode* node);
+
+  virtual QModelIndex index(int row, int column,
+                            const QModelIndex& parent = QModelIndex())const;
+  virtual QModelIndex parent(const QModelIndex& child)const;
+  virtual int rowCount(const QModelIndex& parent = QModelIndex())const;
+  virtual int columnCount(const QModelIndex& parent = QModelIndex())const;
+  virtual bool hasChildren(const QModelIndex& parent = QModelIndex())const;
+  virtual QVariant data(const QModelIndex& index, int role = Qt::DisplayRole)const;
+  virtual bool setData(const QModelIndex& index, const QVariant& value,
+                       int role = Qt::EditRole);
+  virtual Qt::ItemFlags flags(const QModelIndex& index)const;
+
+  /// Return true if some nodes of the scene are not exposed yet.
+  virtual bool canFetchMore(const QModelIndex& parent)const;
+  /// Expose the next \a fetchBatchSize nodes of the scene.
+  virtual void fetchMore(const QModelIndex& parent);
+
+protected slots:
+  void onMRMLSceneDeleted(vtkObject* scene);
+  void onMRMLNodeModified(vtkObject* node);
+
+protected:
+  virtual void onMRMLSceneNodeAdded(vtkMRMLScene* scene, vtkMRMLNode* node);
+  virtual void onMRMLSceneNodeAboutToBeRemoved(vtkMRMLScene* scene, vtkMRMLNode* node);
+  virtual void onMRMLSceneStartBatchProcess(vtkMRMLScene* scene);
+  virtual void onMRMLSceneEndBatchProcess(vtkMRMLScene* scene);
+
+  /// Rebuild the node list from the scene and reset the model.
+  virtual void updateScene();
+
+  virtual Qt::ItemFlags nodeFlags(vtkMRMLNode* node, int column)const;
+  /// To reimplement if you want custom display of the node.
+  virtual QVariant nodeData(vtkMRMLNode* node, int column, int role)const;
+  /// To reimplement if you want to propagate user changes into the node.
+  virtual bool setNodeData(vtkMRMLNode* node, int column,
+                           const QVariant& value, int role);
+
+  static void onMRMLSceneEvent(vtkObject* vtk_obj, unsigned long event,
+                               void* client_data, void* call_data);
+
+  /// Must be reimplemented in subclasses that add new column types
+  virtual int maxColumnId()const;
+
+protected:
+  QScopedPointer<qMRMLSceneVirtualModelPrivate> d_ptr;
+
+private:
+  Q_DECLARE_PRIVATE(qMRMLSceneVirtualModel);
+  Q_DISABLE_COPY(qMRMLSceneVirtualModel);
+};
+
+#endif
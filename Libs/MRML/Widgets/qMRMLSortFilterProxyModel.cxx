@@ -22,6 +22,7 @@
 
 // qMRML includes
 #include "qMRMLSceneModel.h"
+#include "qMRMLSceneVirtualModel.h"
 #include "qMRMLSortFilterProxyModel.h"
 
 // VTK includes
@@ -98,6 +99,11 @@ QStandardItem* qMRMLSortFilterProxyModel::sourceItem(const QModelIndex& sourceIn
 //-----------------------------------------------------------------------------
 vtkMRMLScene* qMRMLSortFilterProxyModel::mrmlScene()const
 {
+  qMRMLSceneVirtualModel* sceneVirtualModel = this->sceneVirtualModel();
+  if (sceneVirtualModel)
+    {
+    return sceneVirtualModel->mrmlScene();
+    }
   qMRMLSceneModel* sceneModel = qobject_cast<qMRMLSceneModel*>(this->sourceModel());
   return sceneModel->mrmlScene();
 }
@@ -105,6 +111,11 @@ vtkMRMLScene* qMRMLSortFilterProxyModel::mrmlScene()const
 //-----------------------------------------------------------------------------
 QModelIndex qMRMLSortFilterProxyModel::mrmlSceneIndex()const
 {
+  qMRMLSceneVirtualModel* sceneVirtualModel = this->sceneVirtualModel();
+  if (sceneVirtualModel)
+    {
+    return this->mapFromSource(sceneVirtualModel->mrmlSceneIndex());
+    }
   qMRMLSceneModel* sceneModel = qobject_cast<qMRMLSceneModel*>(this->sourceModel());
   return this->mapFromSource(sceneModel->mrmlSceneIndex());
 }
@@ -112,6 +123,11 @@ QModelIndex qMRMLSortFilterProxyModel::mrmlSceneIndex()const
 //-----------------------------------------------------------------------------
 vtkMRMLNode* qMRMLSortFilterProxyModel::mrmlNodeFromIndex(const QModelIndex& proxyIndex)const
 {
+  qMRMLSceneVirtualModel* sceneVirtualModel = this->sceneVirtualModel();
+  if (sceneVirtualModel)
+    {
+    return sceneVirtualModel->mrmlNodeFromIndex(this->mapToSource(proxyIndex));
+    }
   qMRMLSceneModel* sceneModel = qobject_cast<qMRMLSceneModel*>(this->sourceModel());
   return sceneModel->mrmlNodeFromIndex(this->mapToSource(proxyIndex));
 }
@@ -119,6 +135,11 @@ vtkMRMLNode* qMRMLSortFilterProxyModel::mrmlNodeFromIndex(const QModelIndex& pro
 //-----------------------------------------------------------------------------
 QModelIndex qMRMLSortFilterProxyModel::indexFromMRMLNode(vtkMRMLNode* node, int column)const
 {
+  qMRMLSceneVirtualModel* sceneVirtualModel = this->sceneVirtualModel();
+  if (sceneVirtualModel)
+    {
+    return this->mapFromSource(sceneVirtualModel->indexFromNode(node, column));
+    }
   qMRMLSceneModel* sceneModel = qobject_cast<qMRMLSceneModel*>(this->sourceModel());
   return this->mapFromSource(sceneModel->indexFromNode(node, column));
 }
@@ -160,6 +181,27 @@ void qMRMLSortFilterProxyModel::removeAttribute(const QString& nodeType,
 //------------------------------------------------------------------------------
 bool qMRMLSortFilterProxyModel::filterAcceptsRow(int source_row, const QModelIndex &source_parent)const
 {
+  qMRMLSceneVirtualModel* sceneVirtualModel = this->sceneVirtualModel();
+  if (sceneVirtualModel)
+    {
+    // No QStandardItem, the node is retrieved from the source index
+    vtkMRMLNode* node = sceneVirtualModel->mrmlNodeFromIndex(
+      sceneVirtualModel->index(source_row, 0, source_parent));
+    AcceptType accept = this->filterAcceptsNode(node);
+    bool acceptRow = (accept == Accept);
+    if (accept == AcceptButPotentiallyRejectable)
+      {
+      acceptRow = this->QSortFilterProxyModel::filterAcceptsRow(source_row,
+                                                                source_parent);
+      }
+    if (node &&
+        sceneVirtualModel->listenNodeModifiedEvent() == qMRMLSceneModel::OnlyVisibleNodes &&
+        accept != Reject)
+      {
+      sceneVirtualModel->observeNode(node);
+      }
+    return acceptRow;
+    }
   QStandardItem* parentItem = this->sourceItem(source_parent);
   if (parentItem == 0)
     {
@@ -204,7 +246,6 @@ qMRMLSortFilterProxyModel::AcceptType qMRMLSortFilterProxyModel
 ::filterAcceptsNode(vtkMRMLNode* node)const
 {
   Q_D(const qMRMLSortFilterProxyModel);
-  qMRMLSceneModel* sceneModel = qobject_cast<qMRMLSceneModel*>(this->sourceModel());
   if (!node || !node->GetID())
     {
     return Accept;
@@ -245,9 +286,12 @@ qMRMLSortFilterProxyModel::AcceptType qMRMLSortFilterProxyModel
 
   if (!d->HideNodesUnaffiliatedWithNodeID.isEmpty())
     {
-    vtkMRMLNode* theNode = sceneModel->mrmlScene()->GetNodeByID(
+    vtkMRMLNode* theNode = this->mrmlScene()->GetNodeByID(
       d->HideNodesUnaffiliatedWithNodeID.toLatin1());
-    bool affiliated = sceneModel->isAffiliatedNode(node, theNode);
+    qMRMLSceneVirtualModel* sceneVirtualModel = this->sceneVirtualModel();
+    bool affiliated = sceneVirtualModel ?
+      sceneVirtualModel->isAffiliatedNode(node, theNode) :
+      this->sceneModel()->isAffiliatedNode(node, theNode);
     if (!affiliated)
       {
       return Reject;
@@ -541,3 +585,9 @@ qMRMLSceneModel* qMRMLSortFilterProxyModel::sceneModel()const
 {
   return qobject_cast<qMRMLSceneModel*>(this->sourceModel());
 }
+
+// --------------------------------------------------------------------------
+qMRMLSceneVirtualModel* qMRMLSortFilterProxyModel::sceneVirtualModel()const
+{
+  return qobject_cast<qMRMLSceneVirtualModel*>(this->sourceModel());
+}
@@ -36,10 +36,12 @@ class vtkMRMLNode;
 class vtkMRMLScene;
 class qMRMLAbstractItemHelper;
 class qMRMLSceneModel;
+class qMRMLSceneVirtualModel;
 class qMRMLSortFilterProxyModelPrivate;
 
 /// Filter nodes based on their types and attributes
 /// Support filtering QSortFilterProxyModel::filterRegExp
+/// The source model must be a qMRMLSceneModel or a qMRMLSceneVirtualModel.
 class QMRML_WIDGETS_EXPORT qMRMLSortFilterProxyModel : public QSortFilterProxyModel
 {
   Q_OBJECT
@@ -210,6 +212,8 @@ public:
 
   /// Return the scene model used as input if any.
   Q_INVOKABLE qMRMLSceneModel* sceneModel()const;
+  /// Return the scene virtual model used as input if any.
+  Q_INVOKABLE qMRMLSceneVirtualModel* sceneVirtualModel()const;
 
 public slots:
   /// Set the showHidden flag.
@@ -0,0 +1,115 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// vtkAddon includes
+#include <vtkImageLabelStatistics.h>
+
+// VTK includes
+#include <vtkDataArray.h>
+#include <vtkImageData.h>
+#include <vtkNew.h>
+#include <vtkTable.h>
+
+// STD includes
+#include <cmath>
+#include <iostream>
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+bool CheckValue(int line, vtkTable* table, const char* column, int row, double expected)
+{
+  vtkDataArray* array = vtkDataArray::SafeDownCast(table->GetColumnByName(column));
+  if (!array)
+    {
+    std::cerr << "Line " << line << " - Missing column " << column << std::endl;
+    return false;
+    }
+  double value = array->GetTuple1(row);
+  if (std::fabs(value - expected) > 1e-6)
+    {
+    std::cerr << "Line " << line << " - Wrong " << column << " for row " << row
+              << ": " << value << " instead of " << expected << std::endl;
+    return false;
+    }
+  return true;
+}
+
+}
+
+//----------------------------------------------------------------------------
+int vtkImageLabelStatisticsTest1(int vtkNotUsed(argc), char * vtkNotUsed(argv)[])
+{
+  // 10x10x10 grayscale image where the value is the slice index (z),
+  // and a label map with label 2 in slices 0-4 and label 7 in slices 5-9.
+  vtkNew<vtkImageData> grayscale;
+  grayscale->SetDimensions(10, 10, 10);
+  grayscale->AllocateScalars(VTK_SHORT, 1);
+  vtkNew<vtkImageData> labelMap;
+  labelMap->SetDimensions(10, 10, 10);
+  labelMap->AllocateScalars(VTK_UNSIGNED_CHAR, 1);
+  for (int z = 0; z < 10; ++z)
+    {
+    for (int y = 0; y < 10; ++y)
+      {
+      for (int x = 0; x < 10; ++x)
+        {
+        *static_cast<short*>(grayscale->GetScalarPointer(x, y, z)) = z;
+        *static_cast<unsigned char*>(labelMap->GetScalarPointer(x, y, z)) = (z < 5 ? 2 : 7);
+        }
+      }
+    }
+
+  for (int numberOfThreads = 1; numberOfThreads <= 4; numberOfThreads += 3)
+    {
+    vtkNew<vtkImageLabelStatistics> statistics;
+    statistics->SetGrayscaleInputData(grayscale.GetPointer());
+    statistics->SetLabelInputData(labelMap.GetPointer());
+    statistics->SetNumberOfThreads(numberOfThreads);
+    statistics->ComputeMedianOn();
+    statistics->Update();
+
+    vtkTable* table = statistics->GetOutput();
+    if (table->GetNumberOfRows() != 2)
+      {
+      std::cerr << "Line " << __LINE__ << " - Wrong number of labels: "
+                << table->GetNumberOfRows() << std::endl;
+      return EXIT_FAILURE;
+      }
+    // Sample standard deviation of 100 times each of 0, 1, 2, 3 and 4
+    double stdDev = std::sqrt(100. * (4 + 1 + 0 + 1 + 4) / 499.);
+    if (!CheckValue(__LINE__, table, "LabelValue", 0, 2) ||
+        !CheckValue(__LINE__, table, "Count", 0, 500) ||
+        !CheckValue(__LINE__, table, "Min", 0, 0) ||
+        !CheckValue(__LINE__, table, "Max", 0, 4) ||
+        !CheckValue(__LINE__, table, "Mean", 0, 2) ||
+        !CheckValue(__LINE__, table, "StdDev", 0, stdDev) ||
+        !CheckValue(__LINE__, table, "Sum", 0, 1000) ||
+        !CheckValue(__LINE__, table, "Median", 0, 2) ||
+        !CheckValue(__LINE__, table, "LabelValue", 1, 7) ||
+        !CheckValue(__LINE__, table, "Count", 1, 500) ||
+        !CheckValue(__LINE__, table, "Min", 1, 5) ||
+        !CheckValue(__LINE__, table, "Max", 1, 9) ||
+        !CheckValue(__LINE__, table, "Mean", 1, 7) ||
+        !CheckValue(__LINE__, table, "StdDev", 1, stdDev) ||
+        !CheckValue(__LINE__, table, "Median", 1, 7))
+      {
+      return EXIT_FAILURE;
+      }
+    }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,493 @@
+/*=auto=========================================================================
+
+  Portions (c) Copyright 2005 Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+=========================================================================auto=*/
+
+#include "vtkImageLabelStatistics.h"
+
+// VTK includes
+#include <vtkDoubleArray.h>
+#include <vtkIdTypeArray.h>
+#include <vtkImageData.h>
+#include <vtkInformation.h>
+#include <vtkInformationVector.h>
+#include <vtkIntArray.h>
+#include <vtkMultiThreader.h>
+#include <vtkNew.h>
+#include <vtkObjectFactory.h>
+#include <vtkPointData.h>
+#include <vtkTable.h>
+
+// STD includes
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <vector>
+
+vtkStandardNewMacro(vtkImageLabelStatistics);
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+// Statistics of the grayscale voxels of one label.
+struct LabelAccumulator
+{
+  LabelAccumulator()
+    : Count(0)
+    , Min(VTK_DOUBLE_MAX)
+    , Max(VTK_DOUBLE_MIN)
+    , Sum(0.)
+    , SumSquares(0.)
+  {}
+
+  void Add(double value)
+  {
+    ++this->Count;
+    this->Min = std::min(this->Min, value);
+    this->Max = std::max(this->Max, value);
+    this->Sum += value;
+    this->SumSquares += value * value;
+  }
+
+  void Merge(const LabelAccumulator& other)
+  {
+    this->Count += other.Count;
+    this->Min = std::min(this->Min, other.Min);
+    this->Max = std::max(this->Max, other.Max);
+    this->Sum += other.Sum;
+    this->SumSquares += other.SumSquares;
+    if (other.Histogram.empty())
+      {
+      return;
+      }
+    if (this->Histogram.empty())
+      {
+      this->Histogram = other.Histogram;
+      return;
+      }
+    for (size_t bin = 0; bin < this->Histogram.size(); ++bin)
+      {
+      this->Histogram[bin] += other.Histogram[bin];
+      }
+  }
+
+  vtkIdType Count;
+  double Min;
+  double Max;
+  double Sum;
+  double SumSquares;
+  std::vector<vtkIdType> Histogram;
+};
+
+//----------------------------------------------------------------------------
+// Per-thread label accumulators. Labels within the label map scalar range are
+// stored in a vector (if the range is not too large), other labels in a map.
+struct LabelAccumulatorTable
+{
+  LabelAccumulatorTable() : DenseMin(0) {}
+
+  LabelAccumulator& Get(long long label)
+  {
+    long long index = label - this->DenseMin;
+    if (index >= 0 && index < static_cast<long long>(this->Dense.size()))
+      {
+      return this->Dense[index];
+      }
+    return this->Sparse[label];
+  }
+
+  long long DenseMin;
+  std::vector<LabelAccumulator> Dense;
+  std::map<long long, LabelAccumulator> Sparse;
+};
+
+// Maximum label range for which per-thread accumulators are preallocated.
+const long long MaximumDenseLabelRange = 65536;
+
+//----------------------------------------------------------------------------
+struct vtkImageLabelStatisticsThreadStruct
+{
+  vtkImageLabelStatistics* Filter;
+  vtkImageData* Grayscale;
+  vtkImageData* LabelMap;
+  int Extent[6];
+  std::vector<LabelAccumulatorTable> Tables;
+
+  bool ComputeHistograms;
+  double HistogramMin;
+  double HistogramBinWidth;
+  int NumberOfHistogramBins;
+};
+
+//----------------------------------------------------------------------------
+template <class TGray, class TLabel>
+void vtkImageLabelStatisticsAccumulate(vtkImageLabelStatisticsThreadStruct* str,
+                                       int ext[6], TGray* grayPtr, TLabel* labelPtr,
+                                       LabelAccumulatorTable& table, int threadId)
+{
+  vtkIdType grayIncX, grayIncY, grayIncZ;
+  vtkIdType labelIncX, labelIncY, labelIncZ;
+  str->Grayscale->GetContinuousIncrements(ext, grayIncX, grayIncY, grayIncZ);
+  str->LabelMap->GetContinuousIncrements(ext, labelIncX, labelIncY, labelIncZ);
+  int grayComponents = str->Grayscale->GetNumberOfScalarComponents();
+  int labelComponents = str->LabelMap->GetNumberOfScalarComponents();
+
+  const bool computeHistograms = str->ComputeHistograms;
+  const double histogramMin = str->HistogramMin;
+  const double histogramScale = 1. / str->HistogramBinWidth;
+  const int lastBin = str->NumberOfHistogramBins - 1;
+
+  int maxY = ext[3] - ext[2];
+  int maxZ = ext[5] - ext[4];
+  unsigned long count = 0;
+  unsigned long target = static_cast<unsigned long>((maxZ+1)*(maxY+1)/50.0);
+  target++;
+
+  // Neighbor voxels often share the same label, keep the last accumulator
+  // to avoid looking it up for each voxel.
+  LabelAccumulator* accumulator = 0;
+  TLabel lastLabel = 0;
+
+  for (int idxZ = 0; idxZ <= maxZ; idxZ++)
+    {
+    for (int idxY = 0; !str->Filter->GetAbortExecute() && idxY <= maxY; idxY++)
+      {
+      if (!threadId)
+        {
+        if (!(count%target))
+          {
+          str->Filter->UpdateProgress(count/(50.0*target));
+          }
+        count++;
+        }
+      for (int idxX = ext[0]; idxX <= ext[1]; idxX++)
+        {
+        TLabel label = *labelPtr;
+        if (!accumulator || label != lastLabel)
+          {
+          accumulator = &table.Get(static_cast<long long>(label));
+          lastLabel = label;
+          }
+        double value = static_cast<double>(*grayPtr);
+        accumulator->Add(value);
+        if (computeHistograms)
+          {
+          if (accumulator->Histogram.empty())
+            {
+            accumulator->Histogram.resize(lastBin + 1, 0);
+            }
+          int bin = static_cast<int>((value - histogramMin) * histogramScale);
+          bin = std::max(0, std::min(bin, lastBin));
+          ++accumulator->Histogram[bin];
+          }
+        grayPtr += grayComponents;
+        labelPtr += labelComponents;
+        }
+      grayPtr += grayIncY;
+      labelPtr += labelIncY;
+      }
+    grayPtr += grayIncZ;
+    labelPtr += labelIncZ;
+    }
+}
+
+//----------------------------------------------------------------------------
+template <class TLabel>
+void vtkImageLabelStatisticsExecute(vtkImageLabelStatisticsThreadStruct* str,
+                                    int ext[6], TLabel* labelPtr,
+                                    LabelAccumulatorTable& table, int threadId)
+{
+  void* grayPtr = str->Grayscale->GetScalarPointerForExtent(ext);
+  switch (str->Grayscale->GetScalarType())
+    {
+    vtkTemplateMacro(
+      vtkImageLabelStatisticsAccumulate(str, ext, static_cast<VTK_TT*>(grayPtr),
+                                        labelPtr, table, threadId));
+    default:
+      vtkGenericWarningMacro(<< "vtkImageLabelStatistics: Unknown grayscale scalar type");
+      return;
+    }
+}
+
+//----------------------------------------------------------------------------
+// Each thread processes a slab of the extent along the slowest varying axis.
+VTK_THREAD_RETURN_TYPE vtkImageLabelStatisticsThreadedExecute(void* arg)
+{
+  vtkMultiThreader::ThreadInfo* info = static_cast<vtkMultiThreader::ThreadInfo*>(arg);
+  int threadId = info->ThreadID;
+  int threadCount = info->NumberOfThreads;
+  vtkImageLabelStatisticsThreadStruct* str =
+    static_cast<vtkImageLabelStatisticsThreadStruct*>(info->UserData);
+
+  int ext[6];
+  std::copy(str->Extent, str->Extent + 6, ext);
+  int axis = (ext[5] > ext[4]) ? 2 : 1;
+  int length = ext[2*axis+1] - ext[2*axis] + 1;
+  int begin = ext[2*axis] + (length * threadId) / threadCount;
+  int end = ext[2*axis] + (length * (threadId + 1)) / threadCount - 1;
+  if (end < begin)
+    {
+    return VTK_THREAD_RETURN_VALUE;
+    }
+  ext[2*axis] = begin;
+  ext[2*axis+1] = end;
+
+  void* labelPtr = str->LabelMap->GetScalarPointerForExtent(ext);
+  LabelAccumulatorTable& table = str->Tables[threadId];
+  switch (str->LabelMap->GetScalarType())
+    {
+    vtkTemplateMacro(
+      vtkImageLabelStatisticsExecute(str, ext, static_cast<VTK_TT*>(labelPtr),
+                                     table, threadId));
+    default:
+      vtkGenericWarningMacro(<< "vtkImageLabelStatistics: Unknown label map scalar type");
+      break;
+    }
+  return VTK_THREAD_RETURN_VALUE;
+}
+
+//----------------------------------------------------------------------------
+// Return the grayscale value of the voxel of a given rank (0 is the smallest
+// value) using the histogram of a label.
+double GetValueAtRank(const LabelAccumulator& accumulator, vtkIdType rank,
+                      double histogramMin, double binWidth, double binOffset)
+{
+  vtkIdType cumulativeCount = 0;
+  for (size_t bin = 0; bin < accumulator.Histogram.size(); ++bin)
+    {
+    cumulativeCount += accumulator.Histogram[bin];
+    if (cumulativeCount > rank)
+      {
+      double value = histogramMin + bin * binWidth + binOffset;
+      return std::max(accumulator.Min, std::min(value, accumulator.Max));
+      }
+    }
+  return accumulator.Max;
+}
+
+}
+
+//----------------------------------------------------------------------------
+vtkImageLabelStatistics::vtkImageLabelStatistics()
+{
+  this->SetNumberOfInputPorts(2);
+  this->ComputeMedian = false;
+  this->NumberOfHistogramBins = 4096;
+  this->NumberOfThreads = 0;
+  this->Threader = vtkMultiThreader::New();
+}
+
+//----------------------------------------------------------------------------
+vtkImageLabelStatistics::~vtkImageLabelStatistics()
+{
+  this->Threader->Delete();
+}
+
+//----------------------------------------------------------------------------
+void vtkImageLabelStatistics::SetGrayscaleInputData(vtkImageData* image)
+{
+  this->SetInputData(0, image);
+}
+
+//----------------------------------------------------------------------------
+void vtkImageLabelStatistics::SetGrayscaleInputConnection(vtkAlgorithmOutput* output)
+{
+  this->SetInputConnection(0, output);
+}
+
+//----------------------------------------------------------------------------
+void vtkImageLabelStatistics::SetLabelInputData(vtkImageData* labelMap)
+{
+  this->SetInputData(1, labelMap);
+}
+
+//----------------------------------------------------------------------------
+void vtkImageLabelStatistics::SetLabelInputConnection(vtkAlgorithmOutput* output)
+{
+  this->SetInputConnection(1, output);
+}
+
+//----------------------------------------------------------------------------
+int vtkImageLabelStatistics::FillInputPortInformation(int vtkNotUsed(port), vtkInformation* info)
+{
+  info->Set(vtkAlgorithm::INPUT_REQUIRED_DATA_TYPE(), "vtkImageData");
+  return 1;
+}
+
+//----------------------------------------------------------------------------
+int vtkImageLabelStatistics::RequestData(vtkInformation* vtkNotUsed(request),
+                                         vtkInformationVector** inputVector,
+                                         vtkInformationVector* outputVector)
+{
+  vtkImageData* grayscale = vtkImageData::GetData(inputVector[0]);
+  vtkImageData* labelMap = vtkImageData::GetData(inputVector[1]);
+  vtkTable* output = vtkTable::GetData(outputVector);
+  if (!grayscale || !labelMap ||
+      !grayscale->GetPointData()->GetScalars() ||
+      !labelMap->GetPointData()->GetScalars())
+    {
+    vtkErrorMacro("RequestData: grayscale and label map images with scalars are required");
+    return 0;
+    }
+
+  vtkNew<vtkIntArray> labelValues;
+  labelValues->SetName("LabelValue");
+  vtkNew<vtkIdTypeArray> counts;
+  counts->SetName("Count");
+  vtkNew<vtkDoubleArray> mins;
+  mins->SetName("Min");
+  vtkNew<vtkDoubleArray> maxs;
+  maxs->SetName("Max");
+  vtkNew<vtkDoubleArray> means;
+  means->SetName("Mean");
+  vtkNew<vtkDoubleArray> stdDevs;
+  stdDevs->SetName("StdDev");
+  vtkNew<vtkDoubleArray> sums;
+  sums->SetName("Sum");
+  vtkNew<vtkDoubleArray> medians;
+  medians->SetName("Median");
+
+  // Process the intersection of the two extents
+  vtkImageLabelStatisticsThreadStruct str;
+  int* grayscaleExtent = grayscale->GetExtent();
+  int* labelExtent = labelMap->GetExtent();
+  bool emptyExtent = false;
+  for (int i = 0; i < 3; ++i)
+    {
+    str.Extent[2*i] = std::max(grayscaleExtent[2*i], labelExtent[2*i]);
+    str.Extent[2*i+1] = std::min(grayscaleExtent[2*i+1], labelExtent[2*i+1]);
+    emptyExtent = emptyExtent || str.Extent[2*i] > str.Extent[2*i+1];
+    }
+
+  str.Filter = this;
+  str.Grayscale = grayscale;
+  str.LabelMap = labelMap;
+
+  // Histograms (for the median) span the grayscale scalar range. For integer
+  // types, use one bin per value if possible to get an exact median.
+  str.ComputeHistograms = this->ComputeMedian;
+  double grayscaleRange[2] = {0., 0.};
+  grayscale->GetPointData()->GetScalars()->GetRange(grayscaleRange, 0);
+  str.HistogramMin = grayscaleRange[0];
+  str.HistogramBinWidth = 1.;
+  str.NumberOfHistogramBins = 1;
+  double binOffset = 0.;
+  int grayscaleType = grayscale->GetScalarType();
+  bool integerGrayscale = (grayscaleType != VTK_FLOAT && grayscaleType != VTK_DOUBLE);
+  double valueRange = grayscaleRange[1] - grayscaleRange[0];
+  if (integerGrayscale && valueRange + 1 <= this->NumberOfHistogramBins)
+    {
+    str.NumberOfHistogramBins = static_cast<int>(valueRange) + 1;
+    }
+  else if (valueRange > 0.)
+    {
+    str.NumberOfHistogramBins = this->NumberOfHistogramBins;
+    str.HistogramBinWidth = valueRange / this->NumberOfHistogramBins;
+    binOffset = str.HistogramBinWidth / 2.;
+    }
+
+  std::map<long long, LabelAccumulator> labels;
+  if (!emptyExtent)
+    {
+    int numberOfThreads = this->NumberOfThreads > 0 ?
+      this->NumberOfThreads : vtkMultiThreader::GetGlobalDefaultNumberOfThreads();
+    int splitAxis = (str.Extent[5] > str.Extent[4]) ? 2 : 1;
+    numberOfThreads = std::max(1, std::min(numberOfThreads,
+      str.Extent[2*splitAxis+1] - str.Extent[2*splitAxis] + 1));
+
+    double labelRange[2] = {0., 0.};
+    labelMap->GetPointData()->GetScalars()->GetRange(labelRange, 0);
+    long long denseMin = static_cast<long long>(std::floor(labelRange[0]));
+    long long denseSize = static_cast<long long>(std::floor(labelRange[1])) - denseMin + 1;
+    str.Tables.resize(numberOfThreads);
+    if (denseSize > 0 && denseSize <= MaximumDenseLabelRange)
+      {
+      for (int i = 0; i < numberOfThreads; ++i)
+        {
+        str.Tables[i].DenseMin = denseMin;
+        str.Tables[i].Dense.resize(static_cast<size_t>(denseSize));
+        }
+      }
+
+    this->Threader->SetNumberOfThreads(numberOfThreads);
+    this->Threader->SetSingleMethod(vtkImageLabelStatisticsThreadedExecute, &str);
+    this->Threader->SingleMethodExecute();
+
+    // Merge the per-thread tables
+    for (int i = 0; i < numberOfThreads; ++i)
+      {
+      LabelAccumulatorTable& table = str.Tables[i];
+      for (size_t index = 0; index < table.Dense.size(); ++index)
+        {
+        if (table.Dense[index].Count > 0)
+          {
+          labels[table.DenseMin + static_cast<long long>(index)].Merge(table.Dense[index]);
+          }
+        }
+      for (std::map<long long, LabelAccumulator>::iterator it = table.Sparse.begin();
+           it != table.Sparse.end(); ++it)
+        {
+        labels[it->first].Merge(it->second);
+        }
+      }
+    }
+
+  for (std::map<long long, LabelAccumulator>::iterator it = labels.begin();
+       it != labels.end(); ++it)
+    {
+    const LabelAccumulator& accumulator = it->second;
+    double count = static_cast<double>(accumulator.Count);
+    double mean = accumulator.Sum / count;
+    double stdDev = 0.;
+    if (accumulator.Count > 1)
+      {
+      double variance = (accumulator.SumSquares - mean * mean * count) / (count - 1.);
+      stdDev = variance > 0. ? sqrt(variance) : 0.;
+      }
+    labelValues->InsertNextValue(static_cast<int>(it->first));
+    counts->InsertNextValue(accumulator.Count);
+    mins->InsertNextValue(accumulator.Min);
+    maxs->InsertNextValue(accumulator.Max);
+    means->InsertNextValue(mean);
+    stdDevs->InsertNextValue(stdDev);
+    sums->InsertNextValue(accumulator.Sum);
+    if (this->ComputeMedian)
+      {
+      // Average of the two middle values if the count is even
+      double lower = GetValueAtRank(accumulator, (accumulator.Count - 1) / 2,
+        str.HistogramMin, str.HistogramBinWidth, binOffset);
+      double upper = GetValueAtRank(accumulator, accumulator.Count / 2,
+        str.HistogramMin, str.HistogramBinWidth, binOffset);
+      medians->InsertNextValue((lower + upper) / 2.);
+      }
+    }
+
+  output->Initialize();
+  output->AddColumn(labelValues.GetPointer());
+  output->AddColumn(counts.GetPointer());
+  output->AddColumn(mins.GetPointer());
+  output->AddColumn(maxs.GetPointer());
+  output->AddColumn(means.GetPointer());
+  output->AddColumn(stdDevs.GetPointer());
+  output->AddColumn(sums.GetPointer());
+  if (this->ComputeMedian)
+    {
+    output->AddColumn(medians.GetPointer());
+    }
+  return 1;
+}
+
+//----------------------------------------------------------------------------
+void vtkImageLabelStatistics::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os,indent);
+
+  os << indent << "ComputeMedian: " << this->ComputeMedian << "\n";
+  os << indent << "NumberOfHistogramBins: " << this->NumberOfHistogramBins << "\n";
+  os << indent << "NumberOfThreads: " << this->NumberOfThreads << "\n";
+}
@@ -0,0 +1,96 @@
+/*=auto=========================================================================
+
+  Portions (c) Copyright 2005 Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+=========================================================================auto=*/
+
+/// \brief vtkImageLabelStatistics - compute grayscale statistics of all the
+/// labels of a label map in a single pass.
+///
+/// The filter takes a grayscale image on input port 0 and a label map on
+/// input port 1 and outputs a table with one row per label value found in the
+/// label map (sorted by increasing label value). The table has the columns
+/// "LabelValue", "Count", "Min", "Max", "Mean", "StdDev", "Sum" and, if
+/// ComputeMedian is enabled, "Median".
+///
+/// Voxels are processed by multiple threads. Each thread accumulates the
+/// statistics of its slab in its own per-label table and the tables are
+/// merged at the end, so that the cost does not depend on the number of
+/// labels.
+///
+/// Only the first component of the grayscale image is used. Label values
+/// are truncated to integers. If the two inputs have different extents, the
+/// intersection of the extents is processed.
+/// StdDev is the sample standard deviation, like vtkImageAccumulate.
+///
+/// The median is computed from a per-label histogram of the grayscale values
+/// over the grayscale scalar range. For integer grayscale images whose range
+/// fits in NumberOfHistogramBins, the median is exact, otherwise its
+/// precision is the bin width.
+
+#ifndef __vtkImageLabelStatistics_h
+#define __vtkImageLabelStatistics_h
+
+#include "vtkAddon.h"
+
+#include "vtkTableAlgorithm.h"
+
+class vtkImageData;
+class vtkMultiThreader;
+
+class VTK_ADDON_EXPORT vtkImageLabelStatistics : public vtkTableAlgorithm
+{
+public:
+  static vtkImageLabelStatistics *New();
+  vtkTypeMacro(vtkImageLabelStatistics,vtkTableAlgorithm);
+  virtual void PrintSelf(ostream& os, vtkIndent indent);
+
+  // Description:
+  // Set the grayscale image (input port 0) and the label map (input port 1).
+  void SetGrayscaleInputData(vtkImageData* image);
+  void SetGrayscaleInputConnection(vtkAlgorithmOutput* output);
+  void SetLabelInputData(vtkImageData* labelMap);
+  void SetLabelInputConnection(vtkAlgorithmOutput* output);
+
+  // Description:
+  // Compute the median grayscale value of each label. Off by default.
+  vtkSetMacro(ComputeMedian, bool);
+  vtkGetMacro(ComputeMedian, bool);
+  vtkBooleanMacro(ComputeMedian, bool);
+
+  // Description:
+  // Number of bins of the per-label histograms used to compute the median.
+  // 4096 by default.
+  vtkSetClampMacro(NumberOfHistogramBins, int, 1, VTK_INT_MAX);
+  vtkGetMacro(NumberOfHistogramBins, int);
+
+  // Description:
+  // Maximum number of threads to use. 0 (default) uses the
+  // vtkMultiThreader global default number of threads.
+  vtkSetClampMacro(NumberOfThreads, int, 0, VTK_INT_MAX);
+  vtkGetMacro(NumberOfThreads, int);
+
+protected:
+  vtkImageLabelStatistics();
+  ~vtkImageLabelStatistics();
+
+  virtual int FillInputPortInformation(int port, vtkInformation* info);
+  virtual int RequestData(vtkInformation* request,
+                          vtkInformationVector** inputVector,
+                          vtkInformationVector* outputVector);
+
+  bool ComputeMedian;
+  int NumberOfHistogramBins;
+  int NumberOfThreads;
+
+  vtkMultiThreader* Threader;
+
+private:
+  vtkImageLabelStatistics(const vtkImageLabelStatistics&);  // Not implemented.
+  void operator=(const vtkImageLabelStatistics&);  // Not implemented.
+};
+
+#endif
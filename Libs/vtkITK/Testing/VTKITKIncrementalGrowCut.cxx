@@ -0,0 +1,186 @@
+
+#include <vtkITKIncrementalGrowCutSegmentationImageFilter.h>
+
+// VTK includes
+#include <vtkImageData.h>
+#include <vtkNew.h>
+
+// STD includes
+#include <cstring>
+#include <iostream>
+
+namespace
+{
+
+const int Size = 40;
+
+//----------------------------------------------------------------------------
+// Bright sphere on a dark background with some deterministic noise
+void CreateImage(vtkImageData* image)
+{
+  image->SetDimensions(Size, Size, Size);
+  image->AllocateScalars(VTK_SHORT, 1);
+  short* ptr = static_cast<short*>(image->GetScalarPointer());
+  unsigned int random = 12345;
+  for (int k = 0; k < Size; ++k)
+    {
+    for (int j = 0; j < Size; ++j)
+      {
+      for (int i = 0; i < Size; ++i)
+        {
+        random = random * 1103515245 + 12345;
+        const int r2 = (i - 20) * (i - 20) + (j - 20) * (j - 20) + (k - 20) * (k - 20);
+        *ptr++ = static_cast<short>((r2 < 100 ? 100 : 0) + (random >> 16) % 10);
+        }
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+void CreateSeeds(vtkImageData* seeds)
+{
+  seeds->SetDimensions(Size, Size, Size);
+  seeds->AllocateScalars(VTK_SHORT, 1);
+  memset(seeds->GetScalarPointer(), 0, Size * Size * Size * sizeof(short));
+}
+
+//----------------------------------------------------------------------------
+void SetSeed(vtkImageData* seeds, int i, int j, int k, short label)
+{
+  *static_cast<short*>(seeds->GetScalarPointer(i, j, k)) = label;
+  seeds->Modified();
+}
+
+//----------------------------------------------------------------------------
+bool CompareOutputs(int line, vtkImageData* output1, vtkImageData* output2)
+{
+  if (memcmp(output1->GetScalarPointer(), output2->GetScalarPointer(),
+             Size * Size * Size * sizeof(short)) != 0)
+    {
+    std::cerr << "Line " << line << " - Outputs differ" << std::endl;
+    return false;
+    }
+  return true;
+}
+
+}
+
+//----------------------------------------------------------------------------
+int main(int vtkNotUsed(argc), char * vtkNotUsed(argv)[])
+{
+  vtkNew<vtkImageData> image;
+  CreateImage(image.GetPointer());
+  vtkNew<vtkImageData> seeds;
+  CreateSeeds(seeds.GetPointer());
+  SetSeed(seeds.GetPointer(), 20, 20, 20, 1);
+  SetSeed(seeds.GetPointer(), 5, 5, 5, 2);
+
+  vtkNew<vtkITKIncrementalGrowCutSegmentationImageFilter> growCut;
+  growCut->SetInputData(0, image.GetPointer());
+  growCut->SetInputData(1, seeds.GetPointer());
+  growCut->SetObjectSize(10);
+  growCut->SetContrastNoiseRatio(0.8);
+  growCut->Update();
+  if (growCut->GetStateReused() != 0 ||
+      growCut->GetOutput()->GetScalarType() != VTK_SHORT ||
+      growCut->GetOutput()->GetScalarComponentAsDouble(20, 20, 20, 0) != 1. ||
+      growCut->GetOutput()->GetScalarComponentAsDouble(5, 5, 5, 0) != 2.)
+    {
+    std::cerr << "Line " << __LINE__ << " - First execution failed" << std::endl;
+    return EXIT_FAILURE;
+    }
+  const vtkIdType firstUpdatedVoxels = growCut->GetNumberOfUpdatedVoxels();
+
+  // Added seeds resume from the previous state, even outside of the previous
+  // region of interest.
+  SetSeed(seeds.GetPointer(), 35, 35, 35, 2);
+  SetSeed(seeds.GetPointer(), 22, 20, 20, 1);
+  growCut->Update();
+
+  vtkNew<vtkITKIncrementalGrowCutSegmentationImageFilter> fullGrowCut;
+  fullGrowCut->SetInputData(0, image.GetPointer());
+  fullGrowCut->SetInputData(1, seeds.GetPointer());
+  fullGrowCut->SetObjectSize(10);
+  fullGrowCut->SetContrastNoiseRatio(0.8);
+  fullGrowCut->SetNumberOfThreads(1);
+  fullGrowCut->Update();
+  if (growCut->GetStateReused() != 1 ||
+      fullGrowCut->GetStateReused() != 0 ||
+      growCut->GetNumberOfUpdatedVoxels() >= fullGrowCut->GetNumberOfUpdatedVoxels() ||
+      !CompareOutputs(__LINE__, growCut->GetOutput(), fullGrowCut->GetOutput()))
+    {
+    std::cerr << "Line " << __LINE__ << " - Incremental execution failed: "
+              << growCut->GetNumberOfUpdatedVoxels() << " updated voxels instead of "
+              << fullGrowCut->GetNumberOfUpdatedVoxels() << " (first execution: "
+              << firstUpdatedVoxels << ")" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Removed seeds reset the state
+  SetSeed(seeds.GetPointer(), 35, 35, 35, 0);
+  growCut->Update();
+  fullGrowCut->ResetState();
+  fullGrowCut->Update();
+  if (growCut->GetStateReused() != 0 ||
+      !CompareOutputs(__LINE__, growCut->GetOutput(), fullGrowCut->GetOutput()))
+    {
+    std::cerr << "Line " << __LINE__ << " - Seed removal failed" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Changed parameters reset the state
+  growCut->SetObjectSize(15);
+  growCut->Update();
+  if (growCut->GetStateReused() != 0)
+    {
+    std::cerr << "Line " << __LINE__ << " - Parameter change failed" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // The output fed back as seeds with a new stroke (e.g. GrowCut applied
+  // again by the Editor on its result) only propagates the stroke, the same
+  // way as the seeds with the stroke: the voxels already labeled are not
+  // seeds again and don't extend the region of interest.
+  vtkNew<vtkImageData> strokeSeeds;
+  strokeSeeds->DeepCopy(seeds.GetPointer());
+  vtkNew<vtkImageData> feedbackSeeds;
+  feedbackSeeds->DeepCopy(growCut->GetOutput());
+  // The stroke relabels the tip of the sphere
+  const int strokeSize = 3;
+  for (int k = 27; k < 27 + strokeSize; ++k)
+    {
+    SetSeed(strokeSeeds.GetPointer(), 20, 20, k, 2);
+    SetSeed(feedbackSeeds.GetPointer(), 20, 20, k, 2);
+    }
+
+  vtkNew<vtkITKIncrementalGrowCutSegmentationImageFilter> strokeGrowCut;
+  strokeGrowCut->SetInputData(0, image.GetPointer());
+  strokeGrowCut->SetInputData(1, seeds.GetPointer());
+  strokeGrowCut->SetObjectSize(15);
+  strokeGrowCut->SetContrastNoiseRatio(0.8);
+  strokeGrowCut->SetNumberOfThreads(1);
+  strokeGrowCut->Update();
+  const vtkIdType seedsUpdatedVoxels = strokeGrowCut->GetNumberOfUpdatedVoxels();
+  strokeGrowCut->SetInputData(1, strokeSeeds.GetPointer());
+  strokeGrowCut->Update();
+
+  growCut->SetNumberOfThreads(1);
+  growCut->SetInputData(1, feedbackSeeds.GetPointer());
+  growCut->Update();
+  if (growCut->GetStateReused() != 1 ||
+      strokeGrowCut->GetStateReused() != 1 ||
+      growCut->GetNumberOfUpdatedVoxels() < strokeSize ||
+      growCut->GetNumberOfUpdatedVoxels() != strokeGrowCut->GetNumberOfUpdatedVoxels() ||
+      growCut->GetNumberOfUpdatedVoxels() >= seedsUpdatedVoxels / 10 ||
+      !CompareOutputs(__LINE__, growCut->GetOutput(), strokeGrowCut->GetOutput()))
+    {
+    std::cerr << "Line " << __LINE__ << " - Feedback execution failed: "
+              << growCut->GetNumberOfUpdatedVoxels() << " updated voxels instead of "
+              << strokeGrowCut->GetNumberOfUpdatedVoxels() << " for a stroke of "
+              << strokeSize << " voxels (first execution: "
+              << seedsUpdatedVoxels << ")" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  return EXIT_SUCCESS;
+}
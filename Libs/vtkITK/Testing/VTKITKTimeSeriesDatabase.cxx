@@ -0,0 +1,288 @@
+#include <itkTimeSeriesDatabase.h>
+
+// ITK includes
+#include <itkFactoryRegistration.h>
+#include <itkImage.h>
+#include <itkImageFileWriter.h>
+#include <itkImageRegionIteratorWithIndex.h>
+#include <itkMultiThreader.h>
+
+// STD includes
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+namespace
+{
+
+typedef itk::Image<short, 3> ImageType;
+typedef itk::TimeSeriesDatabase<short> DatabaseType;
+
+// 2x2x2 blocks, the last ones partially filled
+const int Size[3] = {20, 18, 17};
+const unsigned int NumberOfVolumes = 5;
+
+//----------------------------------------------------------------------------
+short Value(const ImageType::IndexType& idx, unsigned int volume)
+{
+  return static_cast<short>(idx[0] + 20 * idx[1] + 7 * idx[2] + 1000 * volume);
+}
+
+//----------------------------------------------------------------------------
+void WriteVolumes(const std::string& directory)
+{
+  ImageType::RegionType region;
+  for (int i = 0; i < 3; ++i)
+    {
+    region.SetSize(i, Size[i]);
+    }
+  for (unsigned int volume = 0; volume < NumberOfVolumes; ++volume)
+    {
+    ImageType::Pointer image = ImageType::New();
+    image->SetRegions(region);
+    image->Allocate();
+    itk::ImageRegionIteratorWithIndex<ImageType> it(image, region);
+    for (it.GoToBegin(); !it.IsAtEnd(); ++it)
+      {
+      it.Set(Value(it.GetIndex(), volume));
+      }
+    std::stringstream fileName;
+    fileName << directory << "/VTKITKTimeSeriesDatabase_" << volume << ".nrrd";
+    itk::ImageFileWriter<ImageType>::Pointer writer = itk::ImageFileWriter<ImageType>::New();
+    writer->SetFileName(fileName.str());
+    writer->SetInput(image);
+    writer->Update();
+    }
+}
+
+//----------------------------------------------------------------------------
+bool CheckTimeSeries(int line, DatabaseType* database)
+{
+  DatabaseType::IndexListType indices;
+  for (int k = 0; k < Size[2]; k += 4)
+    {
+    for (int j = Size[1] - 1; j >= 0; j -= 4)
+      {
+      for (int i = 0; i < Size[0]; i += 6)
+        {
+        ImageType::IndexType idx = {{i, j, k}};
+        indices.push_back(idx);
+        }
+      }
+    }
+  std::vector<short> buffer(indices.size() * NumberOfVolumes);
+  database->GetVoxelTimeSeries(indices, &buffer[0]);
+  for (size_t v = 0; v < indices.size(); ++v)
+    {
+    DatabaseType::ArrayType timeSeries;
+    database->GetVoxelTimeSeries(indices[v], timeSeries);
+    for (unsigned int volume = 0; volume < NumberOfVolumes; ++volume)
+      {
+      if (buffer[v * NumberOfVolumes + volume] != Value(indices[v], volume) ||
+          timeSeries.GetSize() != NumberOfVolumes ||
+          timeSeries[volume] != Value(indices[v], volume))
+        {
+        std::cerr << "Line " << line << " - Wrong time series at " << indices[v]
+                  << " volume " << volume << ": "
+                  << buffer[v * NumberOfVolumes + volume] << " instead of "
+                  << Value(indices[v], volume) << std::endl;
+        return false;
+        }
+      }
+    }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+struct ThreadedTimeSeriesData
+{
+  DatabaseType* Database;
+  DatabaseType::IndexListType Indices;
+  std::vector<int> Failures;
+};
+
+//----------------------------------------------------------------------------
+// Read the time series of all the voxels several times. Each thread starts
+// at a different voxel so that the threads read different blocks at the
+// same time.
+ITK_THREAD_RETURN_TYPE ThreadedGetVoxelTimeSeries(void* arg)
+{
+  itk::MultiThreader::ThreadInfoStruct* info =
+    static_cast<itk::MultiThreader::ThreadInfoStruct*>(arg);
+  ThreadedTimeSeriesData* data = static_cast<ThreadedTimeSeriesData*>(info->UserData);
+  const size_t numberOfIndices = data->Indices.size();
+  const size_t start = info->ThreadID * numberOfIndices / info->NumberOfThreads;
+  DatabaseType::IndexListType indices;
+  for (size_t v = 0; v < numberOfIndices; ++v)
+    {
+    indices.push_back(data->Indices[(start + v) % numberOfIndices]);
+    }
+  std::vector<short> buffer(numberOfIndices * NumberOfVolumes);
+  for (int iteration = 0; iteration < 5; ++iteration)
+    {
+    try
+      {
+      data->Database->GetVoxelTimeSeries(indices, &buffer[0]);
+      }
+    catch (itk::ExceptionObject&)
+      {
+      data->Failures[info->ThreadID] = 1;
+      return ITK_THREAD_RETURN_VALUE;
+      }
+    for (size_t v = 0; v < numberOfIndices; ++v)
+      {
+      for (unsigned int volume = 0; volume < NumberOfVolumes; ++volume)
+        {
+        if (buffer[v * NumberOfVolumes + volume] != Value(indices[v], volume))
+          {
+          data->Failures[info->ThreadID] = 1;
+          return ITK_THREAD_RETURN_VALUE;
+          }
+        }
+      }
+    }
+  return ITK_THREAD_RETURN_VALUE;
+}
+
+//----------------------------------------------------------------------------
+// Read the time series of the same connected database from several threads
+bool CheckThreadedTimeSeries(int line, DatabaseType* database)
+{
+  ThreadedTimeSeriesData data;
+  data.Database = database;
+  for (int k = 0; k < Size[2]; ++k)
+    {
+    for (int j = 0; j < Size[1]; ++j)
+      {
+      for (int i = 0; i < Size[0]; ++i)
+        {
+        ImageType::IndexType idx = {{i, j, k}};
+        data.Indices.push_back(idx);
+        }
+      }
+    }
+  itk::MultiThreader::Pointer threader = itk::MultiThreader::New();
+  threader->SetNumberOfThreads(4);
+  data.Failures.resize(threader->GetNumberOfThreads(), 0);
+  threader->SetSingleMethod(ThreadedGetVoxelTimeSeries, &data);
+  threader->SingleMethodExecute();
+  for (size_t thread = 0; thread < data.Failures.size(); ++thread)
+    {
+    if (data.Failures[thread])
+      {
+      std::cerr << "Line " << line << " - Wrong time series in thread "
+                << thread << std::endl;
+      return false;
+      }
+    }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool CheckVolume(int line, DatabaseType* database, unsigned int volume)
+{
+  database->SetCurrentImage(volume);
+  database->Update();
+  itk::ImageRegionIteratorWithIndex<ImageType> it(database->GetOutput(),
+    database->GetOutput()->GetLargestPossibleRegion());
+  for (it.GoToBegin(); !it.IsAtEnd(); ++it)
+    {
+    if (it.Get() != Value(it.GetIndex(), volume))
+      {
+      std::cerr << "Line " << line << " - Wrong voxel at " << it.GetIndex()
+                << " in volume " << volume << std::endl;
+      return false;
+      }
+    }
+  return true;
+}
+
+}
+
+//----------------------------------------------------------------------------
+int main(int argc, char *argv[])
+{
+  itk::itkFactoryRegistration();
+
+  if (argc < 2)
+    {
+    std::cerr << "Usage: " << argv[0] << " <temporary directory>" << std::endl;
+    return EXIT_FAILURE;
+    }
+  const std::string directory = argv[1];
+  const std::string databaseFileName = directory + "/VTKITKTimeSeriesDatabase.tsd";
+
+  try
+    {
+    WriteVolumes(directory);
+    // 4 blocks per file to spread the database over several files
+    DatabaseType::CreateFromFileArchetype(databaseFileName.c_str(),
+      (directory + "/VTKITKTimeSeriesDatabase_0.nrrd").c_str(),
+      4 * 4096 * sizeof(short));
+
+    for (int useMemoryMapping = 1; useMemoryMapping >= 0; --useMemoryMapping)
+      {
+      DatabaseType::Pointer database = DatabaseType::New();
+      database->SetUseMemoryMapping(useMemoryMapping != 0);
+      database->Connect(databaseFileName.c_str());
+      if (!database->IsOpen() ||
+          database->GetNumberOfVolumes() != static_cast<int>(NumberOfVolumes))
+        {
+        std::cerr << "Line " << __LINE__ << " - Failed to connect" << std::endl;
+        return EXIT_FAILURE;
+        }
+
+      // Every block is read once, the second pass only hits the cache
+      if (!CheckTimeSeries(__LINE__, database) ||
+          database->GetNumberOfCacheMisses() != 8 * NumberOfVolumes)
+        {
+        std::cerr << "Line " << __LINE__ << " - Wrong number of misses: "
+                  << database->GetNumberOfCacheMisses() << std::endl;
+        return EXIT_FAILURE;
+        }
+      database->ResetCacheStatistics();
+      if (!CheckTimeSeries(__LINE__, database) ||
+          database->GetNumberOfCacheMisses() != 0 ||
+          database->GetNumberOfCacheHits() == 0)
+        {
+        std::cerr << "Line " << __LINE__ << " - Wrong cache statistics: "
+                  << database->GetNumberOfCacheHits() << " hits, "
+                  << database->GetNumberOfCacheMisses() << " misses" << std::endl;
+        return EXIT_FAILURE;
+        }
+
+      for (unsigned int volume = 0; volume < NumberOfVolumes; ++volume)
+        {
+        if (!CheckVolume(__LINE__, database, volume))
+          {
+          return EXIT_FAILURE;
+          }
+        }
+      database->Disconnect();
+
+      // Several threads read the same database, starting with an empty
+      // cache. Each block is still counted as missed once.
+      DatabaseType::Pointer threadedDatabase = DatabaseType::New();
+      threadedDatabase->SetUseMemoryMapping(useMemoryMapping != 0);
+      threadedDatabase->Connect(databaseFileName.c_str());
+      if (!CheckThreadedTimeSeries(__LINE__, threadedDatabase))
+        {
+        return EXIT_FAILURE;
+        }
+      if (threadedDatabase->GetNumberOfCacheMisses() != 8 * NumberOfVolumes)
+        {
+        std::cerr << "Line " << __LINE__ << " - Wrong number of misses: "
+                  << threadedDatabase->GetNumberOfCacheMisses() << std::endl;
+        return EXIT_FAILURE;
+        }
+      threadedDatabase->Disconnect();
+      }
+    }
+  catch (itk::ExceptionObject& e)
+    {
+    std::cerr << "Line " << __LINE__ << " - Exception: " << e << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  return EXIT_SUCCESS;
+}
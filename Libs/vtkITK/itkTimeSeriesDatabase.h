@@ -5,8 +5,10 @@
 #include <itkImage.h>
 #include <itkArray.h>
 #include <itkImageSource.h>
+#include <itkSimpleFastMutexLock.h>
 #include <iostream>
 #include <fstream>
+#include <vector>
 #include <itkTimeSeriesDatabaseHelper.h>
 
 #define TimeSeriesBlockSize 16
@@ -94,13 +96,49 @@ public:
    */
   void GetVoxelTimeSeries ( typename OutputImageType::IndexType idx, ArrayType& array );
 
+  /** Read the time courses of many voxels at once.
+   * The time course of indices[i] is stored in
+   * buffer[i*GetNumberOfVolumes()] .. buffer[(i+1)*GetNumberOfVolumes()-1].
+   * The voxels are grouped by block so that each block is read only once.
+   * Once connected, multiple threads can read time courses concurrently:
+   * memory mapped blocks are read without any lock.
+   */
+  typedef std::vector<typename OutputImageType::IndexType> IndexListType;
+  void GetVoxelTimeSeries ( const IndexListType& indices, TPixel* buffer ) const;
+
   /** Set the size of the cache in MiB (1 MiB = 2^20 bytes)
+   * The cache is only used when the files are not memory mapped.
    */
   void SetCacheSizeInMiB ( float sz );
   /** Get the size of the cache in MiB (1 MiB = 2^20 bytes)
    */
   float GetCacheSizeInMiB ();
 
+  /** Whether Connect maps the files in memory (if supported by the
+   * platform) instead of reading blocks through the cache. On by default.
+   */
+  itkSetMacro ( UseMemoryMapping, bool );
+  itkGetConstMacro ( UseMemoryMapping, bool );
+  itkBooleanMacro ( UseMemoryMapping );
+  /** Return true if the connected files are memory mapped */
+  bool IsMemoryMapped() const { return !this->m_MappedFiles.empty(); }
+
+  /** Number of volumes after CurrentImage whose blocks are read ahead by
+   * GenerateData, so that stepping through the volumes doesn't wait for
+   * the disk. Only used when the files are memory mapped. 2 by default.
+   */
+  itkSetMacro ( ReadAheadVolumes, unsigned int );
+  itkGetConstMacro ( ReadAheadVolumes, unsigned int );
+
+  /** Block read statistics since Connect or ResetCacheStatistics.
+   * A block read is a hit if the block was already read or read ahead
+   * (memory mapped files) or was in the cache (other files), a miss
+   * otherwise.
+   */
+  unsigned long GetNumberOfCacheHits() const;
+  unsigned long GetNumberOfCacheMisses() const;
+  void ResetCacheStatistics();
+
 
 protected:
   TimeSeriesDatabase();
@@ -137,13 +175,36 @@ protected:
   std::vector<std::string> m_DatabaseFileNames;
   unsigned long m_BlocksPerFile;
 
+  typedef itk::TimeSeriesDatabaseHelper::counted_ptr<
+    itk::TimeSeriesDatabaseHelper::MappedFile> MappedFilePtr;
+  std::vector<MappedFilePtr> m_MappedFiles;
+  bool m_UseMemoryMapping;
+  unsigned int m_ReadAheadVolumes;
+
   /// our cache
   struct CacheBlock
   {
     TPixel data[TimeSeriesBlockSize*TimeSeriesBlockSize*TimeSeriesBlockSize];
   };
-  TimeSeriesDatabaseHelper::LRUCache<unsigned long, CacheBlock> m_Cache;
-  CacheBlock* GetCacheBlock ( unsigned long index );
+  mutable TimeSeriesDatabaseHelper::LRUCache<unsigned long, CacheBlock> m_Cache;
+  CacheBlock* GetCacheBlock ( unsigned long index ) const;
+
+  /// Return the block at index. Memory mapped blocks are returned directly,
+  /// other blocks are copied from the cache into buffer.
+  /// Thread-safe, the cache is locked if the files are not memory mapped.
+  const TPixel* ReadBlock ( unsigned long index, TPixel* buffer ) const;
+  /// Read ahead the blocks at the given indices (memory mapped files only)
+  void ReadAheadBlocks ( const std::vector<unsigned long>& indices ) const;
+  /// Count the block reads as hits or misses, and mark the read and read
+  /// ahead blocks as loaded.
+  void UpdateCacheStatistics ( const std::vector<unsigned long>& readIndices,
+                               const std::vector<unsigned long>& readAheadIndices ) const;
+
+  /// Locks the cache and the statistics
+  mutable SimpleFastMutexLock m_Lock;
+  mutable std::vector<bool> m_LoadedBlocks;
+  mutable unsigned long m_CacheHits;
+  mutable unsigned long m_CacheMisses;
 };
 
 } // end namespace itk
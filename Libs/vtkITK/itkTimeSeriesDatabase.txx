@@ -9,7 +9,10 @@
 #include <itkImageFileReader.h>
 #include <itksys/SystemTools.hxx>
 #include "itkArchetypeSeriesFileNames.h"
+#include <algorithm>
+#include <cstring>
 #include <fstream>
+#include <utility>
 #include <vector>
 
 namespace itk {
@@ -53,6 +56,7 @@ bool TimeSeriesDatabase<TPixel>::CalculateIntersection ( Size<3> BlockIndex,
 template <class TPixel>
 bool TimeSeriesDatabase<TPixel>::IsOpen () const
 {
+  if ( !this->m_MappedFiles.empty() ) { return true; }
   if ( this->m_DatabaseFiles.size() == 0 ) { return false; }
   return const_cast<std::fstream*>(this->m_DatabaseFiles[0].get())->is_open();
 }
@@ -65,7 +69,11 @@ void TimeSeriesDatabase<TPixel>::Disconnect ()
     this->m_DatabaseFiles[idx]->close();
     }
   this->m_DatabaseFiles.clear();
+  this->m_MappedFiles.clear();
   this->m_DatabaseFileNames.clear();
+  this->m_Cache.clear();
+  this->m_LoadedBlocks.clear();
+  this->ResetCacheStatistics();
 }
 
 template <class TPixel>
@@ -121,16 +129,39 @@ void TimeSeriesDatabase<TPixel>::Connect ( const char* filename )
   // Read the "Filenames:" line
   o >> dummy;
   this->m_DatabaseFiles.clear();
+  this->m_MappedFiles.clear();
   this->m_DatabaseFileNames.clear();
-  // Read and open the files
+  this->m_Cache.clear();
   for ( int idx = 0; idx < NumberOfFiles; idx++ )
     {
     std::string Filename;
     o >> Filename;
-    // std::cout << "Reading file " << idx << " " << Filename << std::endl;
     this->m_DatabaseFileNames.push_back ( Filename );
-    this->m_DatabaseFiles.push_back ( StreamPtr ( new std::fstream ( Filename.c_str(), ::std::ios::in | ::std::ios::binary ) ) );
     }
+  // Map the files, or open them if any of them can't be mapped
+  if ( this->m_UseMemoryMapping )
+    {
+    for ( ::size_t idx = 0; idx < this->m_DatabaseFileNames.size(); idx++ )
+      {
+      MappedFilePtr File ( new TimeSeriesDatabaseHelper::MappedFile );
+      if ( !File->Open ( this->m_DatabaseFileNames[idx].c_str() ) )
+        {
+        this->m_MappedFiles.clear();
+        break;
+        }
+      this->m_MappedFiles.push_back ( File );
+      }
+    }
+  if ( this->m_MappedFiles.empty() )
+    {
+    for ( ::size_t idx = 0; idx < this->m_DatabaseFileNames.size(); idx++ )
+      {
+      this->m_DatabaseFiles.push_back ( StreamPtr ( new std::fstream ( this->m_DatabaseFileNames[idx].c_str(), ::std::ios::in | ::std::ios::binary ) ) );
+      }
+    }
+  // Header block + blocks of all the volumes
+  this->m_LoadedBlocks.assign ( 1 + m_BlocksPerImage[0] * m_BlocksPerImage[1] * m_BlocksPerImage[2] * m_Dimensions[3], false );
+  this->ResetCacheStatistics();
   /*
   std::cout << "ImageSize: " << m_OutputRegion.GetSize() << endl;
   std::cout << "ImageOrigin: " << m_OutputOrigin << endl;
@@ -184,13 +215,16 @@ template <class TPixel>
 
 
 template <class TPixel>
-typename TimeSeriesDatabase<TPixel>::CacheBlock* TimeSeriesDatabase<TPixel>::GetCacheBlock ( unsigned long index )
+typename TimeSeriesDatabase<TPixel>::CacheBlock* TimeSeriesDatabase<TPixel>::GetCacheBlock ( unsigned long index ) const
 {
   CacheBlock* Buffer = this->m_Cache.find ( index );
-  if ( Buffer == 0 ) {
+  if ( Buffer != 0 ) {
+    this->m_CacheHits++;
+  } else {
+    this->m_CacheMisses++;
     // Fill it in
     CacheBlock B;
-    int FileIdx = this->CalculateFileIndex ( index );
+    int FileIdx = CalculateFileIndex ( index, this->m_BlocksPerFile );
 
     this->m_DatabaseFiles[FileIdx]->seekg ( this->CalculatePosition ( index, this->m_BlocksPerFile ) );
     this->m_DatabaseFiles[FileIdx]->read ( reinterpret_cast<char*> ( B.data ), TimeSeriesVolumeBlockSize * sizeof ( TPixel ) );
@@ -202,25 +236,152 @@ typename TimeSeriesDatabase<TPixel>::CacheBlock* TimeSeriesDatabase<TPixel>::Get
 
 
 template <class TPixel>
-void TimeSeriesDatabase<TPixel>::GetVoxelTimeSeries ( typename OutputImageType::IndexType idx, ArrayType& array )
+const TPixel* TimeSeriesDatabase<TPixel>::ReadBlock ( unsigned long index, TPixel* buffer ) const
 {
-  // See if the index is inside the volume
-  // and figure out which cache block we need
-  Size<3> CurrentBlock;
-  Size<3> Offset;
-  for ( int i = 0; i < 3; i++ ) {
-    if ( idx[i] < 0 || idx[i] > this->m_OutputRegion.Size[i] ) {
-      throw 1;
+  const ::size_t BlockBytes = TimeSeriesVolumeBlockSize * sizeof ( TPixel );
+  if ( !this->m_MappedFiles.empty() )
+    {
+    const unsigned int FileIdx = CalculateFileIndex ( index, this->m_BlocksPerFile );
+    const ::size_t Position = ( index % this->m_BlocksPerFile ) * BlockBytes;
+    if ( FileIdx >= this->m_MappedFiles.size()
+         || Position + BlockBytes > this->m_MappedFiles[FileIdx]->GetSize() )
+      {
+      itkExceptionMacro ( "TimeSeriesDatabase::ReadBlock: block " << index << " is not in the database files" );
+      }
+    return reinterpret_cast<const TPixel*> ( this->m_MappedFiles[FileIdx]->GetAddress() + Position );
     }
-    CurrentBlock[i] = reinterpret_cast<unsigned long> ( idx[i] / (double)TimeSeriesBlockSize );
-    Offset[i] = idx[i] % TimeSeriesBlockSize;
-  }
-  unsigned long offset = Offset[0] + Offset[1] * TimeSeriesBlockSize + Offset[2] * TimeSeriesBlockSizeP2;
+  // The cache is shared by all the readers, copy the block while it is locked
+  this->m_Lock.Lock();
+  memcpy ( buffer, this->GetCacheBlock ( index )->data, BlockBytes );
+  this->m_Lock.Unlock();
+  return buffer;
+}
+
+template <class TPixel>
+void TimeSeriesDatabase<TPixel>::ReadAheadBlocks ( const std::vector<unsigned long>& indices ) const
+{
+  const ::size_t BlockBytes = TimeSeriesVolumeBlockSize * sizeof ( TPixel );
+  for ( ::size_t idx = 0; !this->m_MappedFiles.empty() && idx < indices.size(); idx++ )
+    {
+    const unsigned int FileIdx = CalculateFileIndex ( indices[idx], this->m_BlocksPerFile );
+    if ( FileIdx < this->m_MappedFiles.size() )
+      {
+      this->m_MappedFiles[FileIdx]->WillNeed ( ( indices[idx] % this->m_BlocksPerFile ) * BlockBytes, BlockBytes );
+      }
+    }
+}
+
+template <class TPixel>
+void TimeSeriesDatabase<TPixel>::UpdateCacheStatistics ( const std::vector<unsigned long>& readIndices,
+                                                         const std::vector<unsigned long>& readAheadIndices ) const
+{
+  // Blocks read through the cache are counted by GetCacheBlock
+  if ( this->m_MappedFiles.empty() )
+    {
+    return;
+    }
+  this->m_Lock.Lock();
+  for ( ::size_t idx = 0; idx < readIndices.size(); idx++ )
+    {
+    if ( readIndices[idx] >= this->m_LoadedBlocks.size() )
+      {
+      continue;
+      }
+    if ( this->m_LoadedBlocks[readIndices[idx]] )
+      {
+      this->m_CacheHits++;
+      }
+    else
+      {
+      this->m_CacheMisses++;
+      this->m_LoadedBlocks[readIndices[idx]] = true;
+      }
+    }
+  for ( ::size_t idx = 0; idx < readAheadIndices.size(); idx++ )
+    {
+    if ( readAheadIndices[idx] < this->m_LoadedBlocks.size() )
+      {
+      this->m_LoadedBlocks[readAheadIndices[idx]] = true;
+      }
+    }
+  this->m_Lock.Unlock();
+}
+
+template <class TPixel>
+void TimeSeriesDatabase<TPixel>::GetVoxelTimeSeries ( typename OutputImageType::IndexType idx, ArrayType& array )
+{
+  IndexListType indices ( 1, idx );
   array = ArrayType ( this->m_Dimensions[3] );
-  for ( int volume = 0; volume < this->m_Dimensions[3]; volume++ ) {
-    CacheBlock* cache = this->GetCacheBlock ( CurrentBlock, volume );
-    array[volume] = cache->data[offset];
-  }
+  this->GetVoxelTimeSeries ( indices, array.data_block() );
+}
+
+template <class TPixel>
+void TimeSeriesDatabase<TPixel>::GetVoxelTimeSeries ( const IndexListType& indices, TPixel* buffer ) const
+{
+  if ( !this->IsOpen() )
+    {
+    itkExceptionMacro ( "TimeSeriesDatabase::GetVoxelTimeSeries: not open for reading" );
+    }
+  unsigned int BlocksPerImage[3];
+  for ( unsigned int i = 0; i < 3; i++ )
+    {
+    BlocksPerImage[i] = this->m_BlocksPerImage[i];
+    }
+  const unsigned long BlocksPerVolume = BlocksPerImage[0] * BlocksPerImage[1] * BlocksPerImage[2];
+  const unsigned int NumberOfVolumes = this->m_Dimensions[3];
+
+  // Sort the voxels by block (index of the block in the first volume)
+  std::vector<std::pair<unsigned long, ::size_t> > Voxels ( indices.size() );
+  for ( ::size_t v = 0; v < indices.size(); v++ )
+    {
+    Size<3> CurrentBlock;
+    for ( unsigned int i = 0; i < 3; i++ )
+      {
+      if ( indices[v][i] < 0 || indices[v][i] >= static_cast<IndexValueType> ( this->m_OutputRegion.GetSize(i) ) )
+        {
+        itkExceptionMacro ( "TimeSeriesDatabase::GetVoxelTimeSeries: index " << indices[v] << " is outside of the volume" );
+        }
+      CurrentBlock[i] = indices[v][i] / TimeSeriesBlockSize;
+      }
+    Voxels[v] = std::make_pair ( CalculateIndex ( CurrentBlock, 0, BlocksPerImage ), v );
+    }
+  std::sort ( Voxels.begin(), Voxels.end() );
+
+  // Read each block once for all of its voxels, after asking for the whole
+  // time course of the block to be read ahead.
+  TPixel BlockBuffer[TimeSeriesVolumeBlockSize];
+  std::vector<unsigned long> ReadIndices;
+  std::vector<unsigned long> ReadAheadIndices ( NumberOfVolumes );
+  ::size_t First = 0;
+  while ( First < Voxels.size() )
+    {
+    const unsigned long FirstIndex = Voxels[First].first;
+    ::size_t Last = First;
+    while ( Last < Voxels.size() && Voxels[Last].first == FirstIndex )
+      {
+      Last++;
+      }
+    for ( unsigned int volume = 0; volume < NumberOfVolumes; volume++ )
+      {
+      ReadAheadIndices[volume] = FirstIndex + volume * BlocksPerVolume;
+      }
+    this->ReadAheadBlocks ( ReadAheadIndices );
+    for ( unsigned int volume = 0; volume < NumberOfVolumes; volume++ )
+      {
+      const TPixel* Block = this->ReadBlock ( ReadAheadIndices[volume], BlockBuffer );
+      ReadIndices.push_back ( ReadAheadIndices[volume] );
+      for ( ::size_t v = First; v < Last; v++ )
+        {
+        const typename OutputImageType::IndexType& idx = indices[Voxels[v].second];
+        const unsigned long offset = idx[0] % TimeSeriesBlockSize
+          + ( idx[1] % TimeSeriesBlockSize ) * TimeSeriesBlockSize
+          + ( idx[2] % TimeSeriesBlockSize ) * TimeSeriesBlockSizeP2;
+        buffer[Voxels[v].second * NumberOfVolumes + volume] = Block[offset];
+        }
+      }
+    First = Last;
+    }
+  this->UpdateCacheStatistics ( ReadIndices, std::vector<unsigned long>() );
 }
 
 
@@ -264,7 +425,27 @@ void TimeSeriesDatabase<TPixel>::GenerateData()
     }
 
   Size<3> CurrentBlock;
-  // Now, read our data, caching as we go, in future, make this thread safe
+  // Read ahead the blocks of the region in this volume and the next ones
+  std::vector<unsigned long> ReadIndices;
+  std::vector<unsigned long> ReadAheadIndices;
+  if ( this->IsMemoryMapped() )
+    {
+    const unsigned int LastImage = TSD_MIN<unsigned int> ( this->m_CurrentImage + this->m_ReadAheadVolumes,
+                                                           this->m_Dimensions[3] - 1 );
+    for ( unsigned int image = this->m_CurrentImage; image <= LastImage; image++ ) {
+      for ( CurrentBlock[2] = BlockStart[2]; CurrentBlock[2] < BlockStart[2] + BlockCount[2]; CurrentBlock[2]++ ) {
+        for ( CurrentBlock[1] = BlockStart[1]; CurrentBlock[1] < BlockStart[1] + BlockCount[1]; CurrentBlock[1]++ ) {
+          for ( CurrentBlock[0] = BlockStart[0]; CurrentBlock[0] < BlockStart[0] + BlockCount[0]; CurrentBlock[0]++ ) {
+            ReadAheadIndices.push_back ( this->CalculateIndex ( CurrentBlock, image ) );
+          }
+        }
+      }
+    }
+    this->ReadAheadBlocks ( ReadAheadIndices );
+    }
+
+  // Now, read our data
+  TPixel BlockBuffer[TimeSeriesVolumeBlockSize];
   Size<3> BlockSize = { {TimeSeriesBlockSize, TimeSeriesBlockSize, TimeSeriesBlockSize }};
   ImageRegion<3> BlockRegion;
   BlockRegion.SetSize ( BlockSize );
@@ -275,7 +456,8 @@ void TimeSeriesDatabase<TPixel>::GenerateData()
         typename OutputImageType::RegionType BR, IR;
         if ( print ) {  std::cout << "For Block Index: " << CurrentBlock << std::endl; }
         unsigned long index = this->CalculateIndex ( CurrentBlock, this->m_CurrentImage );
-        CacheBlock* Buffer = this->GetCacheBlock ( index );
+        const TPixel* Buffer = this->ReadBlock ( index, BlockBuffer );
+        ReadIndices.push_back ( index );
         if ( this->CalculateIntersection ( CurrentBlock, Region, BR, IR ) ) {
           // Just iterate over whole block
           // Good we can use an iterator!
@@ -290,7 +472,7 @@ void TimeSeriesDatabase<TPixel>::GenerateData()
           BlockRegion.SetIndex ( BlockIndex );
           ImageRegionIterator<OutputImageType> it ( output, IR );
           it.GoToBegin();
-          TPixel* ptr = Buffer->data;
+          const TPixel* ptr = Buffer;
           while ( !it.IsAtEnd() ) {
             it.Set ( *ptr );
             ++it;
@@ -305,7 +487,7 @@ void TimeSeriesDatabase<TPixel>::GenerateData()
             std::cout << "Count: " << Count << std::endl;
             std::cout << "Block Region: " << BR;
             std::cout << "Image Region: " << IR;
-            std::cout << "First voxel: " << Buffer->data[0] << std::endl;
+            std::cout << "First voxel: " << Buffer[0] << std::endl;
           }
           unsigned int bx, by, bz, x, y, z;
           for ( z = 0; z < Count[2]; z++ ) {
@@ -325,7 +507,7 @@ void TimeSeriesDatabase<TPixel>::GenerateData()
                 }
                 */
 
-                output->SetPixel ( ImageIndex, Buffer->data[bx + TimeSeriesBlockSize*by + TimeSeriesBlockSize*TimeSeriesBlockSize*bz] );
+                output->SetPixel ( ImageIndex, Buffer[bx + TimeSeriesBlockSize*by + TimeSeriesBlockSize*TimeSeriesBlockSize*bz] );
                 }
               }
             }
@@ -333,6 +515,7 @@ void TimeSeriesDatabase<TPixel>::GenerateData()
         }
       }
     }
+  this->UpdateCacheStatistics ( ReadIndices, ReadAheadIndices );
 
   return;
 }
@@ -569,16 +752,47 @@ void TimeSeriesDatabase<TPixel>::SetCacheSizeInMiB ( float sz )
 {
   // How many blocks is this?
   double BlockSizeInMiB = sizeof ( TPixel ) * TimeSeriesVolumeBlockSize / ( 1024*1024.);
-  unsigned long int blocks = (unsigned long int) ceil ( sz * BlockSizeInMiB );
+  unsigned long int blocks = (unsigned long int) ceil ( sz / BlockSizeInMiB );
   this->m_Cache.set_maxsize ( blocks );
 }
 
 
 
+template <class TPixel>
+unsigned long TimeSeriesDatabase<TPixel>::GetNumberOfCacheHits () const
+{
+  this->m_Lock.Lock();
+  unsigned long hits = this->m_CacheHits;
+  this->m_Lock.Unlock();
+  return hits;
+}
+
+template <class TPixel>
+unsigned long TimeSeriesDatabase<TPixel>::GetNumberOfCacheMisses () const
+{
+  this->m_Lock.Lock();
+  unsigned long misses = this->m_CacheMisses;
+  this->m_Lock.Unlock();
+  return misses;
+}
+
+template <class TPixel>
+void TimeSeriesDatabase<TPixel>::ResetCacheStatistics ()
+{
+  this->m_Lock.Lock();
+  this->m_CacheHits = 0;
+  this->m_CacheMisses = 0;
+  this->m_Lock.Unlock();
+}
+
 template <class TPixel>
 TimeSeriesDatabase<TPixel>::TimeSeriesDatabase () : m_Cache ( 1024 ){
   this->m_Dimensions.SetSize ( 4 );
   this->m_BlocksPerImage.SetSize ( 4 );
+  this->m_UseMemoryMapping = true;
+  this->m_ReadAheadVolumes = 2;
+  this->m_CacheHits = 0;
+  this->m_CacheMisses = 0;
 }
 
 template <class TPixel>
@@ -601,8 +815,13 @@ TimeSeriesDatabase<TPixel>
   os << indent << "OutputRegion: " << m_OutputRegion;
   os << indent << "OutputOrigin: " << m_OutputOrigin << "\n";
   os << indent << "OutputDirection: " << m_OutputDirection << "\n";
+  os << indent << "UseMemoryMapping: " << m_UseMemoryMapping << "\n";
+  os << indent << "ReadAheadVolumes: " << m_ReadAheadVolumes << "\n";
   if ( this->IsOpen() ) {
     os << indent << "Database is open." << "\n";
+    os << indent << "Memory mapped: " << this->IsMemoryMapped() << "\n";
+    os << indent << "Cache hits: " << this->GetNumberOfCacheHits() << "\n";
+    os << indent << "Cache misses: " << this->GetNumberOfCacheMisses() << "\n";
     os << indent << "Blocks per file: " << this->m_BlocksPerFile << "\n";
     os << indent << "File names: " << "\n";
     for ( ::size_t idx = 0; idx < this->m_DatabaseFileNames.size(); idx++ )
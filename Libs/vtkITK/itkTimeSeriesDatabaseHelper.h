@@ -7,6 +7,15 @@
 #include <cstdarg>
 #include <cassert>
 
+#include "vtkITKConfigure.h"
+
+#ifdef VTKITK_HAVE_MMAP
+# include <fcntl.h>
+# include <sys/mman.h>
+# include <sys/stat.h>
+# include <unistd.h>
+#endif
+
 namespace itk {
   namespace TimeSeriesDatabaseHelper {
     /// Some useful classes
@@ -85,6 +94,86 @@ namespace itk {
         }
       };
 
+    /// Read-only memory mapping of a whole file, unmapped when the object
+    /// is destroyed. Open() always fails if memory mapping is not supported
+    /// (VTKITK_HAVE_MMAP not defined).
+    /// Once opened, the mapping can be read by multiple threads.
+    class MappedFile
+      {
+      public:
+        MappedFile() : Address(0), Size(0) {}
+        ~MappedFile() { this->Close(); }
+
+        bool Open(const char* filename)
+        {
+          this->Close();
+#ifdef VTKITK_HAVE_MMAP
+          int fd = open(filename, O_RDONLY);
+          if (fd == -1)
+            {
+            return false;
+            }
+          struct stat status;
+          if (fstat(fd, &status) == 0 && status.st_size > 0)
+            {
+            void* address = mmap(0, static_cast<size_t>(status.st_size),
+                                 PROT_READ, MAP_SHARED, fd, 0);
+            if (address != MAP_FAILED)
+              {
+              this->Address = static_cast<char*>(address);
+              this->Size = static_cast<size_t>(status.st_size);
+              }
+            }
+          close(fd);
+#else
+          (void)filename;
+#endif
+          return this->Address != 0;
+        }
+
+        void Close()
+        {
+#ifdef VTKITK_HAVE_MMAP
+          if (this->Address)
+            {
+            munmap(this->Address, this->Size);
+            }
+#endif
+          this->Address = 0;
+          this->Size = 0;
+        }
+
+        const char* GetAddress() const { return this->Address; }
+        size_t GetSize() const { return this->Size; }
+
+        /// Advise the system that [offset, offset+length[ will be read soon,
+        /// so that it is read ahead from disk asynchronously.
+        void WillNeed(size_t offset, size_t length) const
+        {
+#if defined(VTKITK_HAVE_MMAP) && defined(VTKITK_HAVE_POSIX_MADVISE)
+          if (!this->Address || offset >= this->Size)
+            {
+            return;
+            }
+          // the address must be page-aligned
+          static const size_t pageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+          const size_t start = offset - offset % pageSize;
+          const size_t end = offset + length < this->Size ? offset + length : this->Size;
+          posix_madvise(this->Address + start, end - start, POSIX_MADV_WILLNEED);
+#else
+          (void)offset;
+          (void)length;
+#endif
+        }
+
+      private:
+        MappedFile(const MappedFile&); /// Not implemented.
+        void operator=(const MappedFile&); /// Not implemented.
+
+        char* Address;
+        size_t Size;
+      };
+
     /// LRU Cache
 
     using namespace std;
@@ -0,0 +1,740 @@
+/**********************************************************************
+ * vtkITKIncrementalGrowCutSegmentationImageFilter
+ * GrowCut cellular automaton that keeps its state between executions
+ * and only processes the active front of changed voxels.
+ **********************************************************************/
+
+#include "vtkITKIncrementalGrowCutSegmentationImageFilter.h"
+
+// VTK includes
+#include <vtkDataSetAttributes.h>
+#include <vtkImageData.h>
+#include <vtkInformation.h>
+#include <vtkInformationVector.h>
+#include <vtkMultiThreader.h>
+#include <vtkNew.h>
+#include <vtkObjectFactory.h>
+#include <vtkStreamingDemandDrivenPipeline.h>
+
+// STD includes
+#include <algorithm>
+#include <cmath>
+
+//-----------------------------------------------------------------------------
+vtkStandardNewMacro(vtkITKIncrementalGrowCutSegmentationImageFilter);
+
+namespace
+{
+
+//-----------------------------------------------------------------------------
+// Batches smaller than this are processed in the calling thread, spawning
+// threads would cost more than the attacks.
+const vtkIdType MinimumBatchSizePerThread = 2048;
+
+//-----------------------------------------------------------------------------
+// The front is a bucket queue: the strengths are quantized into levels and
+// the strongest level is processed first (as in Dijkstra's algorithm) so
+// that most voxels attack only once. The voxels of a level are processed as
+// a batch by multiple threads.
+const int NumberOfStrengthLevels = 1 << 16;
+
+//-----------------------------------------------------------------------------
+struct Attack
+{
+  vtkIdType Voxel;
+  int Label;
+  float Strength;
+};
+
+//-----------------------------------------------------------------------------
+struct PropagateThreadStruct
+{
+  const float* Intensities;
+  const float* MaxDistances;
+  const float* Strengths;
+  const int* Labels;
+  const vtkIdType* Batch;
+  vtkIdType BatchSize;
+  int Dimensions[3];
+  std::vector<std::vector<Attack> > Attacks;
+};
+
+//-----------------------------------------------------------------------------
+// Each batch voxel attacks its 26 neighbors in the region of interest. The
+// successful attacks are collected per thread and applied once all the
+// threads are done, the state is only read here.
+void ComputeAttacks(PropagateThreadStruct* str, int threadId, int numberOfThreads)
+{
+  std::vector<Attack>& attacks = str->Attacks[threadId];
+  attacks.clear();
+  const vtkIdType begin = str->BatchSize * threadId / numberOfThreads;
+  const vtkIdType end = str->BatchSize * (threadId + 1) / numberOfThreads;
+  const int* dims = str->Dimensions;
+  const vtkIdType sliceSize = static_cast<vtkIdType>(dims[0]) * dims[1];
+  for (vtkIdType f = begin; f < end; ++f)
+    {
+    const vtkIdType q = str->Batch[f];
+    const int i = static_cast<int>(q % dims[0]);
+    const int j = static_cast<int>((q / dims[0]) % dims[1]);
+    const int k = static_cast<int>(q / sliceSize);
+    const float intensity = str->Intensities[q];
+    const float strength = str->Strengths[q];
+    const int label = str->Labels[q];
+    for (int dk = -1; dk <= 1; ++dk)
+      {
+      if (k + dk < 0 || k + dk >= dims[2])
+        {
+        continue;
+        }
+      for (int dj = -1; dj <= 1; ++dj)
+        {
+        if (j + dj < 0 || j + dj >= dims[1])
+          {
+          continue;
+          }
+        for (int di = -1; di <= 1; ++di)
+          {
+          if (i + di < 0 || i + di >= dims[0] || (di == 0 && dj == 0 && dk == 0))
+            {
+            continue;
+            }
+          const vtkIdType p = q + dk * sliceSize + dj * dims[0] + di;
+          const float difference = intensity - str->Intensities[p];
+          const float maxDistance = str->MaxDistances[p];
+          const float weight = (maxDistance > 0.) ?
+            (1.f - difference * difference / maxDistance) : 1.f;
+          const float attackStrength = weight * strength;
+          if (attackStrength > str->Strengths[p])
+            {
+            Attack attack;
+            attack.Voxel = p;
+            attack.Label = label;
+            attack.Strength = attackStrength;
+            attacks.push_back(attack);
+            }
+          }
+        }
+      }
+    }
+}
+
+//-----------------------------------------------------------------------------
+VTK_THREAD_RETURN_TYPE PropagateThreadedExecute(void* arg)
+{
+  vtkMultiThreader::ThreadInfo* info = static_cast<vtkMultiThreader::ThreadInfo*>(arg);
+  ComputeAttacks(static_cast<PropagateThreadStruct*>(info->UserData),
+                 info->ThreadID, info->NumberOfThreads);
+  return VTK_THREAD_RETURN_VALUE;
+}
+
+//-----------------------------------------------------------------------------
+// Compute the bounding box (in structured coordinates) of the new seeds: the
+// non zero voxels that are not already seeds of the state nor labeled as the
+// seed with a strength of at least threshold (e.g. the previous output fed
+// back as seeds). hasSeeds is set to true if there is any non zero voxel.
+// Return false if there is no new seed.
+template <class T>
+bool GetNewSeedBounds(T* seeds, const int dims[3], const int roi[6],
+                      const int* stateSeeds, const int* labels,
+                      const float* strengths, float threshold,
+                      int bounds[6], bool& hasSeeds)
+{
+  bool found = false;
+  hasSeeds = false;
+  vtkIdType id = 0;
+  for (int k = 0; k < dims[2]; ++k)
+    {
+    for (int j = 0; j < dims[1]; ++j)
+      {
+      for (int i = 0; i < dims[0]; ++i, ++id)
+        {
+        if (seeds[id] == 0)
+          {
+          continue;
+          }
+        hasSeeds = true;
+        if (i >= roi[0] && i <= roi[1] &&
+            j >= roi[2] && j <= roi[3] &&
+            k >= roi[4] && k <= roi[5])
+          {
+          const vtkIdType roiId =
+            (static_cast<vtkIdType>(k - roi[4]) * (roi[3] - roi[2] + 1) + (j - roi[2])) *
+            (roi[1] - roi[0] + 1) + (i - roi[0]);
+          const int seed = static_cast<int>(seeds[id]);
+          if (seed == stateSeeds[roiId] ||
+              (seed == labels[roiId] && strengths[roiId] >= threshold))
+            {
+            continue;
+            }
+          }
+        if (!found)
+          {
+          bounds[0] = bounds[1] = i;
+          bounds[2] = bounds[3] = j;
+          bounds[4] = bounds[5] = k;
+          found = true;
+          continue;
+          }
+        bounds[0] = std::min(bounds[0], i);
+        bounds[1] = std::max(bounds[1], i);
+        bounds[2] = std::min(bounds[2], j);
+        bounds[3] = std::max(bounds[3], j);
+        bounds[4] = std::min(bounds[4], k);
+        bounds[5] = std::max(bounds[5], k);
+        }
+      }
+    }
+  return found;
+}
+
+//-----------------------------------------------------------------------------
+// Copy the region of interest of the image into roiValues.
+template <class T, class OT>
+void CopyRegion(T* image, const int dims[3], const int roi[6], OT* roiValues)
+{
+  for (int k = roi[4]; k <= roi[5]; ++k)
+    {
+    for (int j = roi[2]; j <= roi[3]; ++j)
+      {
+      const T* row = image + (static_cast<vtkIdType>(k) * dims[1] + j) * dims[0];
+      for (int i = roi[0]; i <= roi[1]; ++i)
+        {
+        *roiValues++ = static_cast<OT>(row[i]);
+        }
+      }
+    }
+}
+
+//-----------------------------------------------------------------------------
+// For each voxel of the region of interest, compute the largest squared
+// intensity difference with its 26 neighbors in the image, as
+// itk::GrowCutSegmentationImageFilter::InitializeDistancesImage() does.
+template <class T>
+void ComputeMaxDistances(T* image, const int dims[3], const int roi[6],
+                         float* maxDistances)
+{
+  const vtkIdType sliceSize = static_cast<vtkIdType>(dims[0]) * dims[1];
+  for (int k = roi[4]; k <= roi[5]; ++k)
+    {
+    for (int j = roi[2]; j <= roi[3]; ++j)
+      {
+      for (int i = roi[0]; i <= roi[1]; ++i)
+        {
+        const float center = static_cast<float>(
+          image[k * sliceSize + static_cast<vtkIdType>(j) * dims[0] + i]);
+        float maxDistance = 0.;
+        for (int nk = std::max(k - 1, 0); nk <= std::min(k + 1, dims[2] - 1); ++nk)
+          {
+          for (int nj = std::max(j - 1, 0); nj <= std::min(j + 1, dims[1] - 1); ++nj)
+            {
+            for (int ni = std::max(i - 1, 0); ni <= std::min(i + 1, dims[0] - 1); ++ni)
+              {
+              const float difference = static_cast<float>(
+                image[nk * sliceSize + static_cast<vtkIdType>(nj) * dims[0] + ni]) - center;
+              maxDistance = std::max(maxDistance, difference * difference);
+              }
+            }
+          }
+        *maxDistances++ = maxDistance;
+        }
+      }
+    }
+}
+
+//-----------------------------------------------------------------------------
+template <class T>
+struct MaxDistancesThreadStruct
+{
+  T* Image;
+  int Dimensions[3];
+  int ROI[6];
+  float* MaxDistances;
+};
+
+//-----------------------------------------------------------------------------
+// Each thread computes the maximum distances of a slab of the region of
+// interest.
+template <class T>
+VTK_THREAD_RETURN_TYPE ComputeMaxDistancesThreadedExecute(void* arg)
+{
+  vtkMultiThreader::ThreadInfo* info = static_cast<vtkMultiThreader::ThreadInfo*>(arg);
+  MaxDistancesThreadStruct<T>* str = static_cast<MaxDistancesThreadStruct<T>*>(info->UserData);
+  const int numberOfSlices = str->ROI[5] - str->ROI[4] + 1;
+  int slab[6];
+  std::copy(str->ROI, str->ROI + 6, slab);
+  slab[4] = str->ROI[4] + numberOfSlices * info->ThreadID / info->NumberOfThreads;
+  slab[5] = str->ROI[4] + numberOfSlices * (info->ThreadID + 1) / info->NumberOfThreads - 1;
+  if (slab[4] <= slab[5])
+    {
+    const vtkIdType sliceSize = static_cast<vtkIdType>(str->ROI[1] - str->ROI[0] + 1) *
+      (str->ROI[3] - str->ROI[2] + 1);
+    ComputeMaxDistances(str->Image, str->Dimensions, slab,
+                        str->MaxDistances + (slab[4] - str->ROI[4]) * sliceSize);
+    }
+  return VTK_THREAD_RETURN_VALUE;
+}
+
+//-----------------------------------------------------------------------------
+template <class T>
+void ComputeMaxDistancesThreaded(T* image, const int dims[3], const int roi[6],
+                                 float* maxDistances, int numberOfThreads)
+{
+  MaxDistancesThreadStruct<T> str;
+  str.Image = image;
+  std::copy(dims, dims + 3, str.Dimensions);
+  std::copy(roi, roi + 6, str.ROI);
+  str.MaxDistances = maxDistances;
+  vtkNew<vtkMultiThreader> threader;
+  threader->SetNumberOfThreads(std::max(1, std::min(numberOfThreads, roi[5] - roi[4] + 1)));
+  threader->SetSingleMethod(ComputeMaxDistancesThreadedExecute<T>, &str);
+  threader->SingleMethodExecute();
+}
+
+//-----------------------------------------------------------------------------
+// Write the labels of the region of interest whose strength is at least
+// threshold into the output, the other voxels are set to 0.
+template <class T>
+void WriteOutput(T* output, const int dims[3], const int roi[6],
+                 const int* labels, const float* strengths, float threshold)
+{
+  std::fill(output, output + static_cast<vtkIdType>(dims[0]) * dims[1] * dims[2],
+            static_cast<T>(0));
+  if (roi[0] > roi[1])
+    {
+    return;
+    }
+  for (int k = roi[4]; k <= roi[5]; ++k)
+    {
+    for (int j = roi[2]; j <= roi[3]; ++j)
+      {
+      T* row = output + (static_cast<vtkIdType>(k) * dims[1] + j) * dims[0];
+      for (int i = roi[0]; i <= roi[1]; ++i, ++labels, ++strengths)
+        {
+        row[i] = (*strengths >= threshold) ? static_cast<T>(*labels) : static_cast<T>(0);
+        }
+      }
+    }
+}
+
+//-----------------------------------------------------------------------------
+vtkIdType GetRegionSize(const int roi[6])
+{
+  if (roi[0] > roi[1])
+    {
+    return 0;
+    }
+  return static_cast<vtkIdType>(roi[1] - roi[0] + 1) *
+    (roi[3] - roi[2] + 1) * (roi[5] - roi[4] + 1);
+}
+
+}
+
+//-----------------------------------------------------------------------------
+vtkITKIncrementalGrowCutSegmentationImageFilter::vtkITKIncrementalGrowCutSegmentationImageFilter()
+{
+  this->ObjectSize = 20;
+  this->ContrastNoiseRatio = 1.0;
+  this->ConfidenceThreshold = 0.2;
+  this->NumberOfThreads = 0;
+  this->StateReused = 0;
+  this->NumberOfUpdatedVoxels = 0;
+  this->StateImage = 0;
+  this->StateImageMTime = 0;
+  this->StateObjectSize = 0.;
+  this->StateSeedStrength = 0.;
+  for (int i = 0; i < 6; ++i)
+    {
+    this->StateExtent[i] = 0;
+    this->ROI[i] = (i % 2) ? -1 : 0;
+    }
+  this->SetNumberOfInputPorts(2);
+  this->SetNumberOfOutputPorts(1);
+}
+
+//-----------------------------------------------------------------------------
+void vtkITKIncrementalGrowCutSegmentationImageFilter::ResetState()
+{
+  for (int i = 0; i < 6; ++i)
+    {
+    this->ROI[i] = (i % 2) ? -1 : 0;
+    }
+  this->StateImage = 0;
+  std::vector<float>().swap(this->Intensities);
+  std::vector<float>().swap(this->MaxDistances);
+  std::vector<float>().swap(this->Strengths);
+  std::vector<int>().swap(this->Labels);
+  std::vector<int>().swap(this->Seeds);
+  std::vector<float>().swap(this->AttackStrengths);
+  std::vector<std::vector<vtkIdType> >().swap(this->Front);
+}
+
+//-----------------------------------------------------------------------------
+int vtkITKIncrementalGrowCutSegmentationImageFilter::GetFrontLevel(float strength)const
+{
+  if (this->StateSeedStrength <= 0.)
+    {
+    return 0;
+    }
+  const int level = static_cast<int>(strength / this->StateSeedStrength * NumberOfStrengthLevels);
+  return std::max(0, std::min(level, NumberOfStrengthLevels - 1));
+}
+
+//-----------------------------------------------------------------------------
+void vtkITKIncrementalGrowCutSegmentationImageFilter::PushFront(vtkIdType voxel)
+{
+  if (this->Front.empty())
+    {
+    this->Front.resize(NumberOfStrengthLevels);
+    }
+  this->Front[this->GetFrontLevel(this->Strengths[voxel])].push_back(voxel);
+}
+
+//-----------------------------------------------------------------------------
+void vtkITKIncrementalGrowCutSegmentationImageFilter::ResizeState(
+  vtkImageData* image, const int roi[6])
+{
+  int dims[3];
+  image->GetDimensions(dims);
+  const vtkIdType size = GetRegionSize(roi);
+
+  std::vector<float> intensities(size);
+  std::vector<float> maxDistances(size);
+  switch (image->GetScalarType())
+    {
+    vtkTemplateMacro(
+      CopyRegion(static_cast<VTK_TT*>(image->GetScalarPointer()), dims, roi,
+                 &intensities[0]);
+      ComputeMaxDistancesThreaded(static_cast<VTK_TT*>(image->GetScalarPointer()),
+                                  dims, roi, &maxDistances[0],
+                                  this->GetNumberOfThreadsToUse()));
+    }
+  std::vector<float> strengths(size, 0.f);
+  std::vector<int> labels(size, 0);
+  std::vector<int> seeds(size, 0);
+  std::vector<float> attackStrengths(size, 0.f);
+  std::vector<vtkIdType> boundary;
+
+  // The previous region of interest is inside the new one, its state is
+  // still valid but the labeled voxels on its boundary can now attack the
+  // new voxels.
+  const int* oldROI = this->ROI;
+  if (oldROI[0] <= oldROI[1])
+    {
+    const int nx = roi[1] - roi[0] + 1;
+    const int ny = roi[3] - roi[2] + 1;
+    vtkIdType oldId = 0;
+    for (int k = oldROI[4]; k <= oldROI[5]; ++k)
+      {
+      for (int j = oldROI[2]; j <= oldROI[3]; ++j)
+        {
+        for (int i = oldROI[0]; i <= oldROI[1]; ++i, ++oldId)
+          {
+          const vtkIdType id = (static_cast<vtkIdType>(k - roi[4]) * ny +
+                                (j - roi[2])) * nx + (i - roi[0]);
+          strengths[id] = this->Strengths[oldId];
+          labels[id] = this->Labels[oldId];
+          seeds[id] = this->Seeds[oldId];
+          attackStrengths[id] = this->AttackStrengths[oldId];
+          const bool onBoundary =
+            i == oldROI[0] || i == oldROI[1] ||
+            j == oldROI[2] || j == oldROI[3] ||
+            k == oldROI[4] || k == oldROI[5];
+          if (onBoundary && strengths[id] > 0.)
+            {
+            attackStrengths[id] = 0.f;
+            boundary.push_back(id);
+            }
+          }
+        }
+      }
+    }
+
+  std::copy(roi, roi + 6, this->ROI);
+  this->Intensities.swap(intensities);
+  this->MaxDistances.swap(maxDistances);
+  this->Strengths.swap(strengths);
+  this->Labels.swap(labels);
+  this->Seeds.swap(seeds);
+  this->AttackStrengths.swap(attackStrengths);
+  std::vector<std::vector<vtkIdType> >().swap(this->Front);
+  for (size_t i = 0; i < boundary.size(); ++i)
+    {
+    this->PushFront(boundary[i]);
+    }
+}
+
+//-----------------------------------------------------------------------------
+int vtkITKIncrementalGrowCutSegmentationImageFilter::GetNumberOfThreadsToUse()const
+{
+  return this->NumberOfThreads > 0 ?
+    this->NumberOfThreads : vtkMultiThreader::GetGlobalDefaultNumberOfThreads();
+}
+
+//-----------------------------------------------------------------------------
+void vtkITKIncrementalGrowCutSegmentationImageFilter::Propagate()
+{
+  if (this->Front.empty())
+    {
+    return;
+    }
+  PropagateThreadStruct str;
+  str.Intensities = &this->Intensities[0];
+  str.MaxDistances = &this->MaxDistances[0];
+  str.Strengths = &this->Strengths[0];
+  str.Labels = &this->Labels[0];
+  str.Dimensions[0] = this->ROI[1] - this->ROI[0] + 1;
+  str.Dimensions[1] = this->ROI[3] - this->ROI[2] + 1;
+  str.Dimensions[2] = this->ROI[5] - this->ROI[4] + 1;
+
+  const int maximumNumberOfThreads = this->GetNumberOfThreadsToUse();
+  str.Attacks.resize(std::max(1, maximumNumberOfThreads));
+
+  // Attacks are weaker than the attacker, they can only push voxels to the
+  // current level or to a lower one.
+  std::vector<vtkIdType> batch;
+  for (int level = NumberOfStrengthLevels - 1; level >= 0; --level)
+    {
+    std::vector<vtkIdType>& front = this->Front[level];
+    while (!front.empty())
+      {
+      // Skip the voxels that have already attacked with their current
+      // strength (pushed multiple times).
+      batch.clear();
+      for (size_t f = 0; f < front.size(); ++f)
+        {
+        const vtkIdType voxel = front[f];
+        if (this->Strengths[voxel] > this->AttackStrengths[voxel])
+          {
+          this->AttackStrengths[voxel] = this->Strengths[voxel];
+          batch.push_back(voxel);
+          }
+        }
+      front.clear();
+      if (batch.empty())
+        {
+        break;
+        }
+      str.Batch = &batch[0];
+      str.BatchSize = static_cast<vtkIdType>(batch.size());
+      int numberOfThreads = static_cast<int>(std::min(
+        static_cast<vtkIdType>(maximumNumberOfThreads),
+        str.BatchSize / MinimumBatchSizePerThread));
+      if (numberOfThreads > 1)
+        {
+        vtkNew<vtkMultiThreader> threader;
+        threader->SetNumberOfThreads(numberOfThreads);
+        numberOfThreads = threader->GetNumberOfThreads();
+        threader->SetSingleMethod(PropagateThreadedExecute, &str);
+        threader->SingleMethodExecute();
+        }
+      else
+        {
+        numberOfThreads = 1;
+        ComputeAttacks(&str, 0, 1);
+        }
+
+      // Attacks are applied in the order of the batch whatever the number of
+      // threads, the result does not depend on the number of threads.
+      for (int t = 0; t < numberOfThreads; ++t)
+        {
+        const std::vector<Attack>& attacks = str.Attacks[t];
+        for (size_t a = 0; a < attacks.size(); ++a)
+          {
+          const Attack& attack = attacks[a];
+          if (attack.Strength <= this->Strengths[attack.Voxel])
+            {
+            continue;
+            }
+          this->Strengths[attack.Voxel] = attack.Strength;
+          this->Labels[attack.Voxel] = attack.Label;
+          ++this->NumberOfUpdatedVoxels;
+          this->PushFront(attack.Voxel);
+          }
+        }
+      }
+    }
+  std::vector<std::vector<vtkIdType> >().swap(this->Front);
+}
+
+//-----------------------------------------------------------------------------
+int vtkITKIncrementalGrowCutSegmentationImageFilter::RequestInformation(
+  vtkInformation * request,
+  vtkInformationVector **inputVector,
+  vtkInformationVector *outputVector)
+{
+  this->Superclass::RequestInformation(request, inputVector, outputVector);
+
+  // the output has the scalar type of the seeds
+  vtkInformation *seedInfo = inputVector[1]->GetInformationObject(0);
+  vtkInformation *outInfo = outputVector->GetInformationObject(0);
+  vtkInformation *scalarInfo = seedInfo ? vtkDataObject::GetActiveFieldInformation(
+    seedInfo, vtkDataObject::FIELD_ASSOCIATION_POINTS,
+    vtkDataSetAttributes::SCALARS) : 0;
+  if (scalarInfo)
+    {
+    vtkDataObject::SetPointDataActiveScalarInfo(
+      outInfo, scalarInfo->Get(vtkDataObject::FIELD_ARRAY_TYPE()), 1);
+    }
+  return 1;
+}
+
+//-----------------------------------------------------------------------------
+int vtkITKIncrementalGrowCutSegmentationImageFilter::RequestData(
+  vtkInformation *vtkNotUsed(request),
+  vtkInformationVector **inputVector,
+  vtkInformationVector *outputVector)
+{
+  vtkImageData *image = vtkImageData::GetData(inputVector[0]);
+  vtkImageData *seedImage = vtkImageData::GetData(inputVector[1]);
+  vtkImageData *output = vtkImageData::GetData(outputVector);
+  if (!image || !seedImage || !output)
+    {
+    vtkErrorMacro("RequestData: missing input or output image");
+    return 0;
+    }
+
+  int extent[6];
+  int seedExtent[6];
+  image->GetExtent(extent);
+  seedImage->GetExtent(seedExtent);
+  if (!std::equal(extent, extent + 6, seedExtent))
+    {
+    vtkErrorMacro("RequestData: the seed image does not have the extent of the image");
+    return 0;
+    }
+  int dims[3];
+  image->GetDimensions(dims);
+
+  output->SetExtent(extent);
+  output->AllocateScalars(seedImage->GetScalarType(), 1);
+
+  this->StateReused = 0;
+  this->NumberOfUpdatedVoxels = 0;
+
+  const double seedStrength = (this->ContrastNoiseRatio > 1.0) ?
+    this->ContrastNoiseRatio / 100.0 : this->ContrastNoiseRatio;
+  if (this->ROI[0] > this->ROI[1] ||
+      this->StateImage != image ||
+      this->StateImageMTime != image->GetMTime() ||
+      !std::equal(extent, extent + 6, this->StateExtent) ||
+      this->StateObjectSize != this->ObjectSize ||
+      this->StateSeedStrength != seedStrength)
+    {
+    this->ResetState();
+    }
+  this->StateImage = image;
+  this->StateImageMTime = image->GetMTime();
+  std::copy(extent, extent + 6, this->StateExtent);
+  this->StateObjectSize = this->ObjectSize;
+  this->StateSeedStrength = seedStrength;
+
+  // The region of interest contains the new seeds padded by the object size.
+  // Seeds already in the state (e.g. the previous output fed back as seeds)
+  // don't extend it and are not propagated again.
+  const float threshold = static_cast<float>(this->ConfidenceThreshold);
+  const int radius = static_cast<int>(this->ObjectSize);
+  bool hasSeeds = false;
+  for (int pass = 0; pass < 2; ++pass)
+    {
+    const bool stateReused = this->ROI[0] <= this->ROI[1];
+    int seedBounds[6];
+    bool hasNewSeeds = false;
+    switch (seedImage->GetScalarType())
+      {
+      vtkTemplateMacro(
+        hasNewSeeds = GetNewSeedBounds(static_cast<VTK_TT*>(seedImage->GetScalarPointer()),
+                                       dims, this->ROI,
+                                       this->Seeds.empty() ? 0 : &this->Seeds[0],
+                                       this->Labels.empty() ? 0 : &this->Labels[0],
+                                       this->Strengths.empty() ? 0 : &this->Strengths[0],
+                                       threshold, seedBounds, hasSeeds));
+      }
+    if (!hasSeeds)
+      {
+      this->ResetState();
+      break;
+      }
+    int newROI[6];
+    std::copy(this->ROI, this->ROI + 6, newROI);
+    if (hasNewSeeds)
+      {
+      for (int i = 0; i < 3; ++i)
+        {
+        const int lower = std::max(seedBounds[2 * i] - radius, 0);
+        const int upper = std::min(seedBounds[2 * i + 1] + radius, dims[i] - 1);
+        newROI[2 * i] = stateReused ? std::min(lower, this->ROI[2 * i]) : lower;
+        newROI[2 * i + 1] = stateReused ? std::max(upper, this->ROI[2 * i + 1]) : upper;
+        }
+      }
+    if (!std::equal(newROI, newROI + 6, this->ROI))
+      {
+      this->ResizeState(image, newROI);
+      }
+
+    std::vector<int> seeds(GetRegionSize(this->ROI));
+    switch (seedImage->GetScalarType())
+      {
+      vtkTemplateMacro(
+        CopyRegion(static_cast<VTK_TT*>(seedImage->GetScalarPointer()),
+                   dims, this->ROI, &seeds[0]));
+      }
+    // Seeds can only be added to a valid state, removed or relabeled
+    // seeds invalidate the strengths propagated from them.
+    bool seedRemoved = false;
+    for (size_t i = 0; i < seeds.size() && !seedRemoved; ++i)
+      {
+      seedRemoved = (this->Seeds[i] != 0 && seeds[i] != this->Seeds[i]);
+      }
+    if (seedRemoved)
+      {
+      vtkDebugMacro("RequestData: seeds removed, reset the state");
+      this->ResetState();
+      continue;
+      }
+    for (size_t i = 0; i < seeds.size(); ++i)
+      {
+      if (seeds[i] == 0 || seeds[i] == this->Seeds[i] ||
+          (seeds[i] == this->Labels[i] && this->Strengths[i] >= threshold))
+        {
+        continue;
+        }
+      this->Seeds[i] = seeds[i];
+      this->Labels[i] = seeds[i];
+      this->Strengths[i] = static_cast<float>(seedStrength);
+      ++this->NumberOfUpdatedVoxels;
+      this->PushFront(static_cast<vtkIdType>(i));
+      }
+    this->StateReused = stateReused ? 1 : 0;
+    break;
+    }
+  if (hasSeeds)
+    {
+    this->Propagate();
+    }
+
+  switch (output->GetScalarType())
+    {
+    vtkTemplateMacro(
+      WriteOutput(static_cast<VTK_TT*>(output->GetScalarPointer()), dims, this->ROI,
+                  this->Labels.empty() ? 0 : &this->Labels[0],
+                  this->Strengths.empty() ? 0 : &this->Strengths[0],
+                  static_cast<float>(this->ConfidenceThreshold)));
+    }
+  return 1;
+}
+
+//-----------------------------------------------------------------------------
+void vtkITKIncrementalGrowCutSegmentationImageFilter::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os,indent);
+
+  os << indent << "ObjectSize: " << this->ObjectSize << std::endl;
+  os << indent << "ContrastNoiseRatio: " << this->ContrastNoiseRatio << std::endl;
+  os << indent << "ConfidenceThreshold: " << this->ConfidenceThreshold << std::endl;
+  os << indent << "NumberOfThreads: " << this->NumberOfThreads << std::endl;
+  os << indent << "StateReused: " << this->StateReused << std::endl;
+  os << indent << "NumberOfUpdatedVoxels: " << this->NumberOfUpdatedVoxels << std::endl;
+  os << indent << "ROI: " << this->ROI[0] << " " << this->ROI[1] << " "
+     << this->ROI[2] << " " << this->ROI[3] << " "
+     << this->ROI[4] << " " << this->ROI[5] << std::endl;
+}
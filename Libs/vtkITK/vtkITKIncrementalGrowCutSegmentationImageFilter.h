@@ -0,0 +1,141 @@
+#ifndef __vtkITKIncrementalGrowCutSegmentationImageFilter_h
+#define __vtkITKIncrementalGrowCutSegmentationImageFilter_h
+
+#include "vtkITK.h"
+
+// VTK includes
+#include <vtkImageAlgorithm.h>
+
+// STD includes
+#include <vector>
+
+class vtkImageData;
+
+/// \brief Stateful GrowCut segmentation that resumes from its previous result.
+///
+/// vtkITKIncrementalGrowCutSegmentationImageFilter computes the same
+/// cellular automaton as itk::GrowCutSegmentationImageFilter (each labeled
+/// voxel attacks its 26 neighbors with a strength weighted by the intensity
+/// difference) but keeps the labels and strengths of the automaton between
+/// two executions.
+/// Only the voxels whose strength changed (the active front) attack their
+/// neighbors, the strongest first so that most voxels attack only once.
+/// Voxels of similar strength are processed by multiple threads and the
+/// computation is restricted to the bounding box of the seeds padded by
+/// ObjectSize.
+///
+/// When the filter is executed again with the same intensity image and
+/// parameters and seeds have only been added (e.g. new strokes painted by the
+/// user), the automaton resumes from the new seeds only. Seed voxels that
+/// already have the seed label with a strength of at least
+/// ConfidenceThreshold are not new seeds: the previous output can be fed
+/// back as seeds with the new strokes (e.g. by the Editor). If seeds have
+/// been removed or relabeled, the intensity image or the parameters have
+/// changed, the state is reset and the automaton is computed from scratch.
+///
+/// Usage: SetInputData(0, image) sets the intensity image (required)
+/// SetInputData(1, seeds) sets the seed image, 0 for no seed (required)
+///
+/// GetOutput produces the segmented image, of the scalar type of the seeds.
+/// Voxels whose strength is lower than ConfidenceThreshold are set to 0.
+/// \sa vtkITKGrowCutSegmentationImageFilter
+class VTK_ITK_EXPORT vtkITKIncrementalGrowCutSegmentationImageFilter
+  : public vtkImageAlgorithm
+{
+public:
+  static vtkITKIncrementalGrowCutSegmentationImageFilter *New();
+  vtkTypeMacro(vtkITKIncrementalGrowCutSegmentationImageFilter, vtkImageAlgorithm);
+  void PrintSelf(ostream& os, vtkIndent indent);
+
+  /// Padding in voxels around the seeds where the segmentation is computed.
+  /// 20 by default.
+  vtkSetMacro(ObjectSize, double);
+  vtkGetMacro(ObjectSize, double);
+
+  /// Strength of the seeds. Values larger than 1 are considered as
+  /// percentages. 1 by default.
+  vtkSetMacro(ContrastNoiseRatio, double);
+  vtkGetMacro(ContrastNoiseRatio, double);
+
+  /// Strength under which a voxel is not labeled in the output.
+  /// 0.2 by default.
+  vtkSetMacro(ConfidenceThreshold, double);
+  vtkGetMacro(ConfidenceThreshold, double);
+
+  /// Number of threads used to process the batches of the active front.
+  /// If 0 (default), vtkMultiThreader::GetGlobalDefaultNumberOfThreads()
+  /// is used.
+  vtkSetMacro(NumberOfThreads, int);
+  vtkGetMacro(NumberOfThreads, int);
+
+  /// Discard the automaton state, the next execution computes the
+  /// segmentation from scratch.
+  void ResetState();
+
+  /// Return 1 if the last execution resumed from the previous state, 0 if
+  /// it was computed from scratch.
+  vtkGetMacro(StateReused, int);
+
+  /// Number of times a voxel label or strength changed during the last
+  /// execution, it measures the work done by the automaton.
+  vtkGetMacro(NumberOfUpdatedVoxels, vtkIdType);
+
+protected:
+  vtkITKIncrementalGrowCutSegmentationImageFilter();
+  ~vtkITKIncrementalGrowCutSegmentationImageFilter(){}
+
+  virtual int RequestInformation(vtkInformation *, vtkInformationVector **, vtkInformationVector *);
+  virtual int RequestData(vtkInformation *, vtkInformationVector **, vtkInformationVector *);
+
+  /// Reallocate the state to the region of interest \a roi. The state of the
+  /// voxels of the previous region of interest is kept and the labeled voxels
+  /// on its boundary are added to the active front.
+  void ResizeState(vtkImageData* image, const int roi[6]);
+
+  /// Run the automaton until the active front is empty.
+  void Propagate();
+
+  /// Add the voxel to the active front, at the level of its strength.
+  void PushFront(vtkIdType voxel);
+  int GetFrontLevel(float strength)const;
+
+  int GetNumberOfThreadsToUse()const;
+
+  double ObjectSize;
+  double ContrastNoiseRatio;
+  double ConfidenceThreshold;
+  int NumberOfThreads;
+
+  int StateReused;
+  vtkIdType NumberOfUpdatedVoxels;
+
+  /// Intensity image and parameters the state has been computed with.
+  vtkImageData* StateImage;
+  unsigned long StateImageMTime;
+  int StateExtent[6];
+  double StateObjectSize;
+  double StateSeedStrength;
+
+  /// Region of interest of the state, in structured coordinates of the
+  /// image. Empty (ROI[0] > ROI[1]) when there is no state.
+  int ROI[6];
+
+  /// State of the automaton, one value per voxel of the region of interest.
+  std::vector<float> Intensities;
+  std::vector<float> MaxDistances;
+  std::vector<float> Strengths;
+  std::vector<int> Labels;
+  std::vector<int> Seeds;
+  /// Strength of the voxels the last time they attacked their neighbors.
+  std::vector<float> AttackStrengths;
+
+  /// Voxels (indices in the region of interest) whose strength changed and
+  /// that have not attacked their neighbors yet, per level of strength.
+  std::vector<std::vector<vtkIdType> > Front;
+
+private:
+  vtkITKIncrementalGrowCutSegmentationImageFilter(const vtkITKIncrementalGrowCutSegmentationImageFilter&);  // Not implemented.
+  void operator=(const vtkITKIncrementalGrowCutSegmentationImageFilter&);  // Not implemented.
+};
+
+#endif
@@ -0,0 +1,230 @@
+/*=auto=========================================================================
+
+  Portions (c) Copyright 2005 Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Program:   3D Slicer
+
+=========================================================================auto=*/
+
+// vtkTeem includes
+#include <vtkSeedTracts.h>
+
+// VTK includes
+#include <vtkCellArray.h>
+#include <vtkFloatArray.h>
+#include <vtkImageData.h>
+#include <vtkNew.h>
+#include <vtkPointData.h>
+#include <vtkPolyData.h>
+#include <vtkTrivialProducer.h>
+
+// STD includes
+#include <cmath>
+#include <iostream>
+
+namespace
+{
+
+const int Dimensions[3] = {20, 10, 10};
+
+//----------------------------------------------------------------------------
+// Linear tensors along the x axis everywhere
+void CreateTensorField(vtkImageData* tensorImage)
+{
+  tensorImage->SetDimensions(Dimensions[0], Dimensions[1], Dimensions[2]);
+  vtkNew<vtkFloatArray> tensors;
+  tensors->SetNumberOfComponents(9);
+  tensors->SetNumberOfTuples(Dimensions[0] * Dimensions[1] * Dimensions[2]);
+  for (vtkIdType i = 0; i < tensors->GetNumberOfTuples(); ++i)
+    {
+    const float tensor[9] = {1.f, 0.f, 0.f, 0.f, 0.1f, 0.f, 0.f, 0.f, 0.1f};
+    tensors->SetTupleValue(i, tensor);
+    }
+  tensorImage->GetPointData()->SetTensors(tensors.GetPointer());
+}
+
+//----------------------------------------------------------------------------
+// Voxels within [min, max] have the given value, the others are 0
+void CreateLabelMap(vtkImageData* labelMap, const int min[3], const int max[3],
+                    short value)
+{
+  labelMap->SetDimensions(Dimensions[0], Dimensions[1], Dimensions[2]);
+  labelMap->AllocateScalars(VTK_SHORT, 1);
+  short* ptr = static_cast<short*>(labelMap->GetScalarPointer());
+  for (int k = 0; k < Dimensions[2]; ++k)
+    {
+    for (int j = 0; j < Dimensions[1]; ++j)
+      {
+      for (int i = 0; i < Dimensions[0]; ++i)
+        {
+        *ptr++ = (i >= min[0] && i <= max[0] && j >= min[1] && j <= max[1] &&
+                  k >= min[2] && k <= max[2]) ? value : 0;
+        }
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+bool CheckSameFibers(int line, vtkPolyData* fibers, vtkPolyData* expected,
+                     double tolerance)
+{
+  if (fibers->GetNumberOfLines() != expected->GetNumberOfLines() ||
+      fibers->GetNumberOfPoints() != expected->GetNumberOfPoints() ||
+      fibers->GetLines()->GetData()->GetNumberOfTuples() !=
+        expected->GetLines()->GetData()->GetNumberOfTuples())
+    {
+    std::cerr << "Line " << line << " - Wrong number of fibers: "
+              << fibers->GetNumberOfLines() << " fibers, "
+              << fibers->GetNumberOfPoints() << " points instead of "
+              << expected->GetNumberOfLines() << " fibers, "
+              << expected->GetNumberOfPoints() << " points" << std::endl;
+    return false;
+    }
+  vtkIdTypeArray* cells = fibers->GetLines()->GetData();
+  vtkIdTypeArray* expectedCells = expected->GetLines()->GetData();
+  for (vtkIdType i = 0; i < cells->GetNumberOfTuples(); ++i)
+    {
+    if (cells->GetValue(i) != expectedCells->GetValue(i))
+      {
+      std::cerr << "Line " << line << " - Wrong lines" << std::endl;
+      return false;
+      }
+    }
+  vtkDataArray* tensors = fibers->GetPointData()->GetTensors();
+  vtkDataArray* expectedTensors = expected->GetPointData()->GetTensors();
+  for (vtkIdType i = 0; i < fibers->GetNumberOfPoints(); ++i)
+    {
+    double point[3];
+    double expectedPoint[3];
+    fibers->GetPoint(i, point);
+    expected->GetPoint(i, expectedPoint);
+    for (int j = 0; j < 3; ++j)
+      {
+      if (fabs(point[j] - expectedPoint[j]) > tolerance)
+        {
+        std::cerr << "Line " << line << " - Wrong point " << i << std::endl;
+        return false;
+        }
+      }
+    for (int j = 0; j < 9; ++j)
+      {
+      if (fabs(tensors->GetComponent(i, j) -
+               expectedTensors->GetComponent(i, j)) > tolerance)
+        {
+        std::cerr << "Line " << line << " - Wrong tensor " << i << std::endl;
+        return false;
+        }
+      }
+    }
+  return true;
+}
+
+}
+
+//----------------------------------------------------------------------------
+int vtkSeedTractsTest1(int , char * [] )
+{
+  vtkNew<vtkImageData> tensorImage;
+  CreateTensorField(tensorImage.GetPointer());
+  vtkNew<vtkTrivialProducer> tensorProducer;
+  tensorProducer->SetOutput(tensorImage.GetPointer());
+
+  // 16 seed voxels in the middle of the field
+  vtkNew<vtkImageData> roi;
+  const int roiMin[3] = {8, 4, 4};
+  const int roiMax[3] = {11, 5, 5};
+  CreateLabelMap(roi.GetPointer(), roiMin, roiMax, 1);
+  vtkNew<vtkTrivialProducer> roiProducer;
+  roiProducer->SetOutput(roi.GetPointer());
+
+  // only the fibers of the seeds with j == 4 go through ROI2
+  vtkNew<vtkImageData> roi2;
+  const int roi2Min[3] = {0, 0, 0};
+  const int roi2Max[3] = {1, 4, 9};
+  CreateLabelMap(roi2.GetPointer(), roi2Min, roi2Max, 2);
+  vtkNew<vtkTrivialProducer> roi2Producer;
+  roi2Producer->SetOutput(roi2.GetPointer());
+
+  vtkNew<vtkHyperStreamlineDTMRI> settings;
+  settings->SetIntegrationStepLength(0.25);
+
+  vtkNew<vtkSeedTracts> seedTracts;
+  seedTracts->SetInputTensorFieldConnection(tensorProducer->GetOutputPort());
+  seedTracts->SetInputROIConnection(roiProducer->GetOutputPort());
+  seedTracts->SetInputROIConnection2(roi2Producer->GetOutputPort());
+  seedTracts->SetInputROIValue(1);
+  seedTracts->SetInputROI2Value(2);
+  seedTracts->SetMinimumPathLength(10.);
+  seedTracts->SetVtkHyperStreamlinePointsSettings(settings.GetPointer());
+
+  // Reference: one streamline object per seed point
+  seedTracts->SeedStreamlinesInROI();
+  vtkNew<vtkPolyData> expectedFibers;
+  seedTracts->TransformStreamlinesToRASAndAppendToPolyData(expectedFibers.GetPointer());
+  seedTracts->DeleteAllStreamlines();
+  if (expectedFibers->GetNumberOfLines() != 16)
+    {
+    std::cerr << "Line " << __LINE__ << " - Wrong number of fibers: "
+              << expectedFibers->GetNumberOfLines() << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  vtkNew<vtkPolyData> fibers;
+  seedTracts->SetNumberOfThreads(1);
+  seedTracts->SeedStreamlinesInROIToPolyData(fibers.GetPointer());
+  if (!CheckSameFibers(__LINE__, fibers.GetPointer(),
+                       expectedFibers.GetPointer(), 1e-5))
+    {
+    return EXIT_FAILURE;
+    }
+
+  // The fibers are the same whatever the number of threads
+  seedTracts->SetIsotropicSeeding(1);
+  seedTracts->SetIsotropicSeedingResolution(0.5);
+  seedTracts->SeedStreamlinesInROIToPolyData(fibers.GetPointer());
+  vtkNew<vtkPolyData> threadedFibers;
+  seedTracts->SetNumberOfThreads(4);
+  seedTracts->SeedStreamlinesInROIToPolyData(threadedFibers.GetPointer());
+  if (fibers->GetNumberOfLines() != 128 ||
+      !CheckSameFibers(__LINE__, threadedFibers.GetPointer(),
+                       fibers.GetPointer(), 0.))
+    {
+    std::cerr << "Line " << __LINE__ << " - Wrong number of fibers: "
+              << fibers->GetNumberOfLines() << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Too short fibers are discarded
+  seedTracts->SetMinimumPathLength(100.);
+  seedTracts->SeedStreamlinesInROIToPolyData(threadedFibers.GetPointer());
+  if (threadedFibers->GetNumberOfLines() != 0 ||
+      threadedFibers->GetNumberOfPoints() != 0)
+    {
+    std::cerr << "Line " << __LINE__ << " - Wrong number of fibers: "
+              << threadedFibers->GetNumberOfLines() << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Only the fibers going through ROI2 are kept
+  seedTracts->SeedStreamlinesFromROIIntersectWithROI2ToPolyData(threadedFibers.GetPointer());
+  if (threadedFibers->GetNumberOfLines() != 8)
+    {
+    std::cerr << "Line " << __LINE__ << " - Wrong number of fibers: "
+              << threadedFibers->GetNumberOfLines() << std::endl;
+    return EXIT_FAILURE;
+    }
+  for (vtkIdType i = 0; i < threadedFibers->GetNumberOfPoints(); ++i)
+    {
+    if (fabs(threadedFibers->GetPoint(i)[1] - 4.) > 1e-3)
+      {
+      std::cerr << "Line " << __LINE__ << " - Wrong fiber point: "
+                << threadedFibers->GetPoint(i)[1] << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+
+  return EXIT_SUCCESS;
+}
@@ -14,7 +14,10 @@
 #include "vtkHyperStreamlineDTMRI.h"
 
 #include "vtkCellArray.h"
+#include "vtkDoubleArray.h"
 #include "vtkFloatArray.h"
+#include "vtkGenericCell.h"
+#include "vtkIdList.h"
 #include "vtkMath.h"
 #include "vtkObjectFactory.h"
 #include "vtkPointData.h"
@@ -118,6 +121,19 @@ static void FixVectors(double **prev, double **current, int iv, int ix, int iy)
     }
 }
 
+// Copy the tuples of the points of a cell. Unlike vtkDataArray::GetTuples(),
+// it doesn't use the internal tuple buffer of the input array so it can be
+// called by multiple threads.
+static void GetCellTuples(vtkDataArray *inArray, vtkIdList *ptIds,
+                          vtkDoubleArray *cellArray)
+{
+  const int numComp = inArray->GetNumberOfComponents();
+  for (vtkIdType i=0; i < ptIds->GetNumberOfIds(); i++)
+    {
+    inArray->GetTuple(ptIds->GetId(i), cellArray->GetPointer(i * numComp));
+    }
+}
+
 int vtkHyperStreamlineDTMRI::RequestData(
   vtkInformation *vtkNotUsed(request),
   vtkInformationVector **inputVector,
@@ -132,28 +148,79 @@ vtkDataSet *input = vtkDataSet::SafeDownCast(
 vtkPolyData *output = vtkPolyData::SafeDownCast(
   outInfo->Get(vtkDataObject::DATA_OBJECT()));
 
+  double startPosition[3];
+  double tol2;
+  int i;
+
+  vtkDebugMacro(<<"Generating hyperstreamline(s)");
+  this->NumberOfStreamers = 0;
+
+  if ( ! input->GetPointData()->GetTensors() )
+    {
+    vtkErrorMacro(<<"No tensor data defined!");
+    return 0;
+    }
+
+  vtkTractographyScratch scratch;
+
+  if ( this->StartFrom == VTK_START_FROM_POSITION )
+    {
+    for (i=0; i<3; i++)
+      {
+      startPosition[i] = this->StartPosition[i];
+      }
+    }
+  else //VTK_START_FROM_LOCATION
+    {
+    double *w = new double[input->GetMaxCellSize()];
+    input->GetCell(this->StartCell, scratch.Cell);
+    scratch.Cell->EvaluateLocation(this->StartSubId, this->StartPCoords,
+                                   startPosition, w);
+    delete [] w;
+    }
+
+  tol2 = input->GetLength() / 1000.0;
+  tol2 = tol2 * tol2;
+
+  this->IntegrateStreamers(input, startPosition, tol2, &scratch);
+
+  this->Streamers = scratch.Streamers;
+  this->NumberOfStreamers = scratch.NumberOfStreamers;
+  this->BuildLines(input,output);
+
+  // the streamers belong to the scratch buffers
+  this->Streamers = NULL;
+  return 1;
+}
 
+//----------------------------------------------------------------------------
+bool vtkHyperStreamlineDTMRI::IntegrateStreamers(vtkDataSet *input,
+                                                 const double startPosition[3],
+                                                 double tol2,
+                                                 vtkTractographyScratch *scratch)const
+{
   vtkPointData *pd=input->GetPointData();
   vtkDataArray *inScalars;
   vtkDataArray *inTensors;
   double *tensor;
   vtkTractographyPoint *sNext, *sPtr;
   int i, j, k, ptId, subId, iv, ix, iy;
-  vtkCell *cell;
+  vtkGenericCell *cell = scratch->Cell;
   double ev[3];
   double xNext[3];
-  double d, step, dir, tol2, p[3];
+  double d, step, dir, p[3];
   double *w;
   double dist2;
   double closestPoint[3];
   double *m[3], *v[3];
   double m0[3], m1[3], m2[3];
   double v0[3], v1[3], v2[3];
-  vtkDataArray *cellTensors = 0;
-  vtkDataArray *cellScalars = 0;
+  vtkDoubleArray *cellTensors = 0;
+  vtkDoubleArray *cellScalars = 0;
   int pointCount;
   vtkTractographyPoint *sPrev, *sPrevPrev;
   double kv1[3], kv2[3], ku1[3], ku2[3], kl1, kl2, kn[3], K = 0.0;
+  vtkTractographyArray *streamers = scratch->Streamers;
   // set up working matrices
   v[0] = v0; v[1] = v1; v[2] = v2;
   m[0] = m0; m[1] = m1; m[2] = m2;
@@ -161,86 +228,70 @@ vtkPolyData *output = vtkPolyData::SafeDownCast(
   //static const float sqrt3halves = sqrt((float)3/2);
   int keepIntegrating;
 
-  vtkDebugMacro(<<"Generating hyperstreamline(s)");
-  this->NumberOfStreamers = 0;
+  scratch->NumberOfStreamers = 0;
 
   if ( ! (inTensors=pd->GetTensors()) )
     {
-    vtkErrorMacro(<<"No tensor data defined!");
-    return 0;
+    return false;
     }
-  w = new double[input->GetMaxCellSize()];
-
-  inScalars = pd->GetScalars();
-  if (inTensors)
+  if (scratch->WeightsSize < input->GetMaxCellSize())
     {
-    cellTensors = vtkDataArray::CreateDataArray(inTensors->GetDataType());
+    delete [] scratch->Weights;
+    scratch->WeightsSize = input->GetMaxCellSize();
+    scratch->Weights = new double[scratch->WeightsSize];
     }
+  w = scratch->Weights;
+
+  inScalars = pd->GetScalars();
+  cellTensors = scratch->CellTensors;
+  cellTensors->SetNumberOfComponents(inTensors->GetNumberOfComponents());
+  cellTensors->SetNumberOfTuples(VTK_CELL_SIZE);
   if (inScalars)
     {
-    cellScalars = vtkDataArray::CreateDataArray(inScalars->GetDataType());
-    }
-  int numComp;
-  if (inTensors && cellTensors)
-    {
-    numComp = inTensors->GetNumberOfComponents();
-    cellTensors->SetNumberOfComponents(numComp);
-    cellTensors->SetNumberOfTuples(VTK_CELL_SIZE);
-    }
-  if (inScalars && cellScalars)
-    {
-    numComp = inScalars->GetNumberOfComponents();
-    cellScalars->SetNumberOfComponents(numComp);
+    cellScalars = scratch->CellScalars;
+    cellScalars->SetNumberOfComponents(inScalars->GetNumberOfComponents());
     cellScalars->SetNumberOfTuples(VTK_CELL_SIZE);
     }
 
-
-  tol2 = input->GetLength() / 1000.0;
-  tol2 = tol2 * tol2;
   iv = this->IntegrationEigenvector;
   ix = (iv + 1) % 3;
   iy = (iv + 2) % 3;
   //
   // Create starting points
   //
-  this->NumberOfStreamers = 1;
+  scratch->NumberOfStreamers = 1;
 
   if ( this->IntegrationDirection == VTK_INTEGRATE_BOTH_DIRECTIONS )
     {
-    this->NumberOfStreamers *= 2;
+    scratch->NumberOfStreamers *= 2;
     }
-
-  this->Streamers = new vtkTractographyArray[this->NumberOfStreamers];
-
-  if ( this->StartFrom == VTK_START_FROM_POSITION )
+  // reset both streamers, BuildLinesForSingleTrajectory() always reads the
+  // second one
+  for (i=0; i < 2; i++)
     {
-    sPtr = this->Streamers[0].InsertNextTractographyPoint();
-    for (i=0; i<3; i++)
-      {
-      sPtr->X[i] = this->StartPosition[i];
-      }
-    sPtr->CellId = input->FindCell(this->StartPosition, NULL, (-1), 0.0,
-                                   sPtr->SubId, sPtr->P, w);
+    streamers[i].Reset();
+    streamers[i].Direction = VTK_INTEGRATE_FORWARD;
     }
 
-  else //VTK_START_FROM_LOCATION
+  sPtr = streamers[0].InsertNextTractographyPoint();
+  for (i=0; i<3; i++)
     {
-    sPtr = this->Streamers[0].InsertNextTractographyPoint();
-    cell =  input->GetCell(sPtr->CellId);
-    cell->EvaluateLocation(sPtr->SubId, sPtr->P, sPtr->X, w);
+    sPtr->X[i] = startPosition[i];
     }
+  sPtr->CellId = input->FindCell(sPtr->X, NULL, cell, (-1), 0.0,
+                                 sPtr->SubId, sPtr->P, w);
   //
   // Finish initializing each hyperstreamline
   //
-  this->Streamers[0].Direction = 1.0;
-  sPtr = this->Streamers[0].GetTractographyPoint(0);
+  streamers[0].Direction = 1.0;
+  sPtr = streamers[0].GetTractographyPoint(0);
   sPtr->D = 0.0;
   if ( sPtr->CellId >= 0 ) //starting point in dataset
     {
-    cell = input->GetCell(sPtr->CellId);
+    input->GetCell(sPtr->CellId, cell);
     cell->EvaluateLocation(sPtr->SubId, sPtr->P, xNext, w);
 
-    inTensors->GetTuples(cell->PointIds, cellTensors);
+    GetCellTuples(inTensors, cell->PointIds, cellTensors);
 
     // interpolate tensor, compute eigenfunctions
     for (j=0; j<3; j++)
@@ -278,7 +329,7 @@ vtkPolyData *output = vtkPolyData::SafeDownCast(
 
     if ( inScalars )
       {
-      inScalars->GetTuples(cell->PointIds, cellScalars);
+      GetCellTuples(inScalars, cell->PointIds, cellScalars);
       for (sPtr->S=0, i=0; i < cell->GetNumberOfPoints(); i++)
         {
         sPtr->S += cellScalars->GetTuple(i)[0] * w[i];
@@ -289,34 +340,34 @@ vtkPolyData *output = vtkPolyData::SafeDownCast(
 
     if ( this->IntegrationDirection == VTK_INTEGRATE_BOTH_DIRECTIONS )
       {
-      this->Streamers[1].Direction = -1.0;
-      sNext = this->Streamers[1].InsertNextTractographyPoint();
+      streamers[1].Direction = -1.0;
+      sNext = streamers[1].InsertNextTractographyPoint();
       *sNext = *sPtr;
       }
     else if ( this->IntegrationDirection == VTK_INTEGRATE_BACKWARD )
       {
-      this->Streamers[0].Direction = -1.0;
+      streamers[0].Direction = -1.0;
       }
     } //for hyperstreamline in dataset
 
   //
   // For each hyperstreamline, integrate in appropriate direction (using RK2).
   //
-  for (ptId=0; ptId < this->NumberOfStreamers; ptId++)
+  for (ptId=0; ptId < scratch->NumberOfStreamers; ptId++)
     {
     //get starting step
-    sPtr = this->Streamers[ptId].GetTractographyPoint(0);
+    sPtr = streamers[ptId].GetTractographyPoint(0);
     if ( sPtr->CellId < 0 )
       {
       continue;
       }
 
-    dir = this->Streamers[ptId].Direction;
-    cell = input->GetCell(sPtr->CellId);
+    dir = streamers[ptId].Direction;
+    input->GetCell(sPtr->CellId, cell);
     cell->EvaluateLocation(sPtr->SubId, sPtr->P, xNext, w);
     step = this->IntegrationStepLength;
-    inTensors->GetTuples(cell->PointIds, cellTensors);
-    if ( inScalars ) {inScalars->GetTuples(cell->PointIds, cellScalars);}
+    GetCellTuples(inTensors, cell->PointIds, cellTensors);
+    if ( inScalars ) {GetCellTuples(inScalars, cell->PointIds, cellScalars);}
 
 
     // This is the flag for integration to continue if FA, curvature
@@ -345,8 +396,8 @@ vtkPolyData *output = vtkPolyData::SafeDownCast(
             // kn=2*(u2-u1)/(norm(v1)+norm(v2));
             // absk=norm(kn);  % absolute value of the curvature
 
-            sPrev = this->Streamers[ptId].GetTractographyPoint(pointCount-1);
-            sPrevPrev = this->Streamers[ptId].GetTractographyPoint(pointCount-2);
+            sPrev = streamers[ptId].GetTractographyPoint(pointCount-1);
+            sPrevPrev = streamers[ptId].GetTractographyPoint(pointCount-2);
             kl2=0;
             kl1=0;
             for (i=0; i<3; i++)
@@ -430,7 +481,7 @@ vtkPolyData *output = vtkPolyData::SafeDownCast(
         xNext[i] = sPtr->X[i] +
                    dir * (step/2.0) * (sPtr->V[i][iv] + v[i][iv]);
         }
-      sNext = this->Streamers[ptId].InsertNextTractographyPoint();
+      sNext = streamers[ptId].InsertNextTractographyPoint();
 
       if ( cell->EvaluatePosition(xNext, closestPoint, sNext->SubId,
       sNext->P, dist2, w) )
@@ -444,7 +495,7 @@ vtkPolyData *output = vtkPolyData::SafeDownCast(
         }
       else
         { //integration has passed out of cell
-        sNext->CellId = input->FindCell(xNext, cell, sPtr->CellId, tol2,
+        sNext->CellId = input->FindCell(xNext, NULL, cell, sPtr->CellId, tol2,
                                         sNext->SubId, sNext->P, w);
         if ( sNext->CellId >= 0 ) //make sure not out of dataset
           {
@@ -452,9 +503,9 @@ vtkPolyData *output = vtkPolyData::SafeDownCast(
             {
             sNext->X[i] = xNext[i];
             }
-          cell = input->GetCell(sNext->CellId);
-          inTensors->GetTuples(cell->PointIds, cellTensors);
-          if (inScalars){inScalars->GetTuples(cell->PointIds, cellScalars);}
+          input->GetCell(sNext->CellId, cell);
+          GetCellTuples(inTensors, cell->PointIds, cellTensors);
+          if (inScalars){GetCellTuples(inScalars, cell->PointIds, cellScalars);}
           step = this->IntegrationStepLength;
           }
         }
@@ -486,7 +537,7 @@ vtkPolyData *output = vtkPolyData::SafeDownCast(
         FixVectors(sPtr->V, sNext->V, iv, ix, iy);
 
         // compute invariants at final position
-        switch (this->GetStoppingMode()) {
+        switch (this->StoppingMode) {
         case vtkDiffusionTensorMathematics::VTK_TENS_FRACTIONAL_ANISOTROPY:
             stop = vtkDiffusionTensorMathematics::FractionalAnisotropy(sNext->W);
             break;
@@ -543,22 +594,7 @@ vtkPolyData *output = vtkPolyData::SafeDownCast(
 
     } //for each hyperstreamline
 
-  this->BuildLines(input,output);
-
-  delete [] w;
-  if (inTensors)
-    {
-    cellTensors->Delete();
-    }
-  if (inScalars)
-    {
-    cellScalars->Delete();
-    }
-
-  // note: these two lines fix memory leak in code copied from vtk
-  delete [] this->Streamers;
-  this->Streamers = NULL;
-  return 1;
+  return true;
 }
 
 void vtkHyperStreamlineDTMRI::BuildLines(vtkDataSet *input, vtkPolyData *output)
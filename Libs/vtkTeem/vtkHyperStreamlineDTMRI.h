@@ -100,6 +100,18 @@ public:
   vtkSetMacro(OneTrajectoryPerSeedPoint, int);
   vtkBooleanMacro(OneTrajectoryPerSeedPoint, int);
 
+  //BTX
+  ///
+  /// Integrate the trajectories starting at \a startPosition through the
+  /// tensors of \a input into the streamers of \a scratch, using the
+  /// current settings of the filter. The filter is not modified: multiple
+  /// threads can integrate different seed points with the same filter as long
+  /// as each of them has its own scratch.
+  /// Return false if the input has no tensors.
+  bool IntegrateStreamers(vtkDataSet *input, const double startPosition[3],
+                          double tol2, vtkTractographyScratch *scratch)const;
+  //ETX
+
 protected:
   vtkHyperStreamlineDTMRI();
   ~vtkHyperStreamlineDTMRI();
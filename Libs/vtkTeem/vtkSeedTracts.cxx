@@ -20,18 +20,25 @@
 #include <vtkAlgorithmOutput.h>
 #include <vtkCellArray.h>
 #include <vtkCommand.h>
+#include <vtkDoubleArray.h>
+#include <vtkFloatArray.h>
 #include <vtkInformation.h>
 #include <vtkMath.h>
+#include <vtkMultiThreader.h>
 #include <vtkNew.h>
 #include <vtkPointData.h>
 #include <vtkPolyDataWriter.h>
+#include <vtkSimpleCriticalSection.h>
 #include <vtkStreamingDemandDrivenPipeline.h>
 #include <vtkTimerLog.h>
 #include <vtkTransformPolyDataFilter.h>
 #include <vtkVersion.h>
 
 // STD includes
+#include <algorithm>
+#include <cstring>
 #include <sstream>
+#include <vector>
 
 //----------------------------------------------------------------------------
 vtkStandardNewMacro(vtkSeedTracts);
@@ -79,6 +86,7 @@ vtkSeedTracts::vtkSeedTracts()
   this->FilePrefix = NULL;
   this->UseStartingThreshold = 0;
   this->StartingThreshold = 0;
+  this->NumberOfThreads = 0;
 }
 
 //----------------------------------------------------------------------------
@@ -1163,6 +1171,581 @@ void vtkSeedTracts::SeedStreamlinesFromROIIntersectWithROI2()
   std::cout << "Tractography in ROI time: " << timer->GetElapsedTime() << endl;
 }
 
+//----------------------------------------------------------------------------
+void vtkSeedTracts::ComputeSeedPoints(vtkDoubleArray *seeds,
+                                      bool useSeedingOptions)
+{
+  double idxX, idxY, idxZ;
+  double maxX, maxY, maxZ;
+  double gridIncX, gridIncY, gridIncZ;
+  int inExt[6];
+  double point[3], point2[3];
+
+  vtkImageData* inputTensorField = vtkImageData::SafeDownCast(this->InputTensorFieldConnection->GetProducer()->GetOutputDataObject(0));
+  vtkImageData* inputROI = vtkImageData::SafeDownCast(this->InputROIConnection->GetProducer()->GetOutputDataObject(0));
+  vtkInformation *inInfo = this->InputROIConnection->GetProducer()->GetOutputInformation(0);
+  inInfo->Get(vtkStreamingDemandDrivenPipeline::WHOLE_EXTENT(), inExt);
+
+  double spacing[3];
+  inputTensorField->GetSpacing(spacing);
+  double bounds[6];
+  inputTensorField->GetBounds(bounds);
+  vtkDataArray *inTensors = inputTensorField->GetPointData()->GetTensors();
+
+  // find the region to loop over
+  maxX = inExt[1] - inExt[0];
+  maxY = inExt[3] - inExt[2];
+  maxZ = inExt[5] - inExt[4];
+
+  // see SeedStreamlinesInROI() for the isotropic grid increments
+  if (useSeedingOptions && this->IsotropicSeeding)
+    {
+    gridIncX = this->IsotropicSeedingResolution/spacing[0];
+    gridIncY = this->IsotropicSeedingResolution/spacing[1];
+    gridIncZ = this->IsotropicSeedingResolution/spacing[2];
+    }
+  else
+    {
+    gridIncX = 1;
+    gridIncY = 1;
+    gridIncZ = 1;
+    }
+
+  double tensor[3][3];
+  double *m[3], w[3], *v[3];
+  double m0[3], m1[3], m2[3];
+  double v0[3], v1[3], v2[3];
+  m[0] = m0; m[1] = m1; m[2] = m2;
+  v[0] = v0; v[1] = v1; v[2] = v2;
+
+  for (idxZ = 0; idxZ <= maxZ; idxZ+=gridIncZ)
+    {
+    for (idxY = 0; idxY <= maxY; idxY+=gridIncY)
+      {
+      for (idxX = 0; idxX <= maxX; idxX+=gridIncX)
+        {
+        // get the pointer to the nearest voxel at this location
+        int pt[3];
+        pt[0]= (int) floor(idxX + 0.5);
+        pt[1]= (int) floor(idxY + 0.5);
+        pt[2]= (int) floor(idxZ + 0.5);
+        short *inPtr = (short *) inputROI->GetScalarPointer(pt);
+        if (*inPtr != this->InputROIValue)
+          {
+          continue;
+          }
+
+        // First transform to world space.
+        point[0]=idxX;
+        point[1]=idxY;
+        point[2]=idxZ;
+        this->ROIToWorld->TransformPoint(point,point2);
+
+        // jitter about seed point if requested, the random numbers are
+        // drawn in the same order as in SeedStreamlinesInROI()
+        if (useSeedingOptions && this->RandomGrid)
+          {
+          //Call random twice to avoid init problems
+          double rand=vtkMath::Random();
+          for (int ridx = 0; ridx < 3; ridx++)
+            {
+            if (this->IsotropicSeeding)
+              {
+              rand = vtkMath::Random( - this->IsotropicSeedingResolution / 2.0, this->IsotropicSeedingResolution / 2.0 );
+              }
+            else
+              {
+              rand = vtkMath::Random( - spacing[0] / 2.0 , spacing[0] / 2.0 );
+              }
+            point2[ridx] = point2[ridx] + rand;
+            }
+          }
+
+        // Now transform to scaled ijk of the input tensors
+        this->WorldToTensorScaledIJK->TransformPoint(point2,point);
+
+        // make sure it is within the bounds of the tensor dataset
+        if (point[0] < bounds[0] || point[0] > bounds[1] ||
+            point[1] < bounds[2] || point[1] > bounds[3] ||
+            point[2] < bounds[4] || point[2] > bounds[5])
+          {
+          continue;
+          }
+
+        if (useSeedingOptions && this->UseStartingThreshold)
+          {
+          // Check the tensor threshold
+          int  ijk[3];
+          double  pcoords[3];
+          inputTensorField->ComputeStructuredCoordinates(point, ijk, pcoords);
+          vtkIdType tensorId = inputTensorField->ComputePointId(ijk);
+          inTensors->GetTuple(tensorId,(double *)tensor);
+          for (int j=0; j<3; j++)
+            {
+            for (int i=0; i<3; i++)
+              {
+              // transpose
+              m[i][j] = tensor[j][i];
+              }
+            }
+          vtkDiffusionTensorMathematics::TeemEigenSolver(m,w,v);
+          if (vtkDiffusionTensorMathematics::LinearMeasure(w) < this->StartingThreshold)
+            {
+            continue;
+            }
+          }
+
+        seeds->InsertNextTuple(point);
+        }
+      }
+    }
+}
+
+namespace
+{
+
+// Number of consecutive seed points a thread traces at once
+const vtkIdType SeedChunkSize = 16;
+
+//----------------------------------------------------------------------------
+// Fibers kept from a chunk of seed points, in the order of their seeds.
+struct FiberChunk
+{
+  std::vector<float> Points;
+  std::vector<float> Tensors;
+  std::vector<vtkIdType> NumberOfPoints;
+};
+
+//----------------------------------------------------------------------------
+struct SeedTractsThreadStruct
+{
+  vtkSeedTracts *Self;
+  vtkImageData *TensorField;
+  vtkHyperStreamlineDTMRI *Tracker;
+  double Tolerance2;
+  vtkDoubleArray *Seeds;
+
+  double TensorScaledIJKToWorld[4][4];
+  double Rotation[3][3];
+  double RotationTranspose[3][3];
+
+  bool IntersectROI2;
+  double MinimumPathLength;
+  double IntegrationStepLength;
+  double WorldToROI2[4][4];
+  const short *ROI2Scalars;
+  int ROI2Extent[6];
+  vtkIdType ROI2Increments[3];
+  int ROI2Value;
+
+  std::vector<FiberChunk> Chunks;
+  vtkIdType NextChunk;
+  vtkSimpleCriticalSection Lock;
+};
+
+//----------------------------------------------------------------------------
+void TransformPoint(const double matrix[4][4], const double in[3],
+                    double out[3])
+{
+  for (int i = 0; i < 3; ++i)
+    {
+    out[i] = matrix[i][0] * in[0] + matrix[i][1] * in[1] +
+             matrix[i][2] * in[2] + matrix[i][3];
+    }
+}
+
+//----------------------------------------------------------------------------
+bool IsInROI2(const SeedTractsThreadStruct *str, const double world[3])
+{
+  double point[3];
+  TransformPoint(str->WorldToROI2, world, point);
+  vtkIdType offset = 0;
+  for (int i = 0; i < 3; ++i)
+    {
+    const int pt = static_cast<int>(floor(point[i] + 0.5));
+    if (pt < str->ROI2Extent[2*i] || pt > str->ROI2Extent[2*i+1])
+      {
+      return false;
+      }
+    offset += (pt - str->ROI2Extent[2*i]) * str->ROI2Increments[i];
+    }
+  return str->ROI2Scalars[offset] == str->ROI2Value;
+}
+
+//----------------------------------------------------------------------------
+// Append the point in RAS and its tensor rotated into RAS (R T R').
+// Return true if the point is in ROI2.
+bool AppendFiberPoint(const SeedTractsThreadStruct *str,
+                      vtkTractographyPoint *sPtr, FiberChunk *chunk)
+{
+  double point[3];
+  TransformPoint(str->TensorScaledIJKToWorld, sPtr->X, point);
+  for (int i = 0; i < 3; ++i)
+    {
+    chunk->Points.push_back(static_cast<float>(point[i]));
+    }
+
+  double tensor[3][3];
+  double temp[3][3];
+  for (int row = 0; row < 3; row++)
+    {
+    for (int col = 0; col < 3; col++)
+      {
+      tensor[row][col] = sPtr->T[row][col];
+      }
+    }
+  vtkMath::Multiply3x3(str->Rotation, tensor, temp);
+  vtkMath::Multiply3x3(temp, str->RotationTranspose, tensor);
+  for (int row = 0; row < 3; row++)
+    {
+    for (int col = 0; col < 3; col++)
+      {
+      chunk->Tensors.push_back(static_cast<float>(tensor[row][col]));
+      }
+    }
+
+  return str->IntersectROI2 && IsInROI2(str, point);
+}
+
+//----------------------------------------------------------------------------
+// Append the trajectory integrated in scratch to the chunk if it is kept.
+// The points are in the same order as in
+// vtkHyperStreamlineDTMRI::BuildLinesForSingleTrajectory(): backwards
+// along the first streamer (skipping the seed point), then forwards along
+// the second one.
+void AppendFiber(const SeedTractsThreadStruct *str,
+                 vtkTractographyScratch *scratch, FiberChunk *chunk)
+{
+  const size_t firstPoint = chunk->Points.size() / 3;
+  bool intersects = false;
+
+  vtkTractographyArray *streamer = &scratch->Streamers[0];
+  for (vtkIdType i = streamer->GetNumberOfPoints() - 1; i > 0; --i)
+    {
+    vtkTractographyPoint *sPtr = streamer->GetTractographyPoint(i);
+    if (sPtr->CellId >= 0)
+      {
+      intersects = AppendFiberPoint(str, sPtr, chunk) || intersects;
+      }
+    }
+  streamer = &scratch->Streamers[1];
+  for (vtkIdType i = 0; i < streamer->GetNumberOfPoints(); ++i)
+    {
+    vtkTractographyPoint *sPtr = streamer->GetTractographyPoint(i);
+    if (sPtr->CellId < 0)
+      {
+      break;
+      }
+    intersects = AppendFiberPoint(str, sPtr, chunk) || intersects;
+    }
+
+  const vtkIdType numberOfPoints =
+    static_cast<vtkIdType>(chunk->Points.size() / 3 - firstPoint);
+  const bool keep = str->IntersectROI2 ? intersects :
+    (numberOfPoints - 1) * str->IntegrationStepLength > str->MinimumPathLength;
+  if (keep && numberOfPoints > 0)
+    {
+    chunk->NumberOfPoints.push_back(numberOfPoints);
+    }
+  else
+    {
+    chunk->Points.resize(firstPoint * 3);
+    chunk->Tensors.resize(firstPoint * 9);
+    }
+}
+
+//----------------------------------------------------------------------------
+// Each thread traces the seed points of the next chunk not traced yet until
+// all the chunks are traced. The fibers of a chunk only depend on its seed
+// points, not on the thread that traced them.
+VTK_THREAD_RETURN_TYPE SeedTractsThreadedExecute(void *arg)
+{
+  vtkMultiThreader::ThreadInfo* info = static_cast<vtkMultiThreader::ThreadInfo*>(arg);
+  SeedTractsThreadStruct* str = static_cast<SeedTractsThreadStruct*>(info->UserData);
+  const vtkIdType numberOfSeeds = str->Seeds->GetNumberOfTuples();
+  const vtkIdType numberOfChunks = static_cast<vtkIdType>(str->Chunks.size());
+
+  vtkTractographyScratch scratch;
+  while (true)
+    {
+    str->Lock.Lock();
+    vtkIdType chunkId = str->NextChunk++;
+    str->Lock.Unlock();
+    if (chunkId >= numberOfChunks)
+      {
+      break;
+      }
+    FiberChunk *chunk = &str->Chunks[chunkId];
+    const vtkIdType lastSeed =
+      std::min((chunkId + 1) * SeedChunkSize, numberOfSeeds);
+    for (vtkIdType seedId = chunkId * SeedChunkSize; seedId < lastSeed; ++seedId)
+      {
+      if (str->Tracker->IntegrateStreamers(str->TensorField,
+                                           str->Seeds->GetPointer(3 * seedId),
+                                           str->Tolerance2, &scratch))
+        {
+        AppendFiber(str, &scratch, chunk);
+        }
+      }
+    // Events can only be invoked from the calling thread
+    if (info->ThreadID == 0)
+      {
+      double progress = (chunkId + 1.0) / numberOfChunks;
+      str->Self->InvokeEvent(vtkCommand::ProgressEvent, (void *)&progress);
+      }
+    }
+  return VTK_THREAD_RETURN_VALUE;
+}
+
+}
+
+//----------------------------------------------------------------------------
+void vtkSeedTracts::SeedStreamlinesToPolyData(vtkDoubleArray *seeds,
+                                              bool intersectROI2,
+                                              vtkPolyData *outFibers)
+{
+  vtkNew<vtkTimerLog> timer;
+  timer->StartTimer();
+
+  vtkImageData* inputTensorField = vtkImageData::SafeDownCast(this->InputTensorFieldConnection->GetProducer()->GetOutputDataObject(0));
+  if (!inputTensorField || !inputTensorField->GetPointData()->GetTensors())
+    {
+    vtkErrorMacro("No tensors in the tensor data input.");
+    return;
+    }
+
+  // All the threads share the same (read-only) streamline settings
+  vtkNew<vtkHyperStreamlineDTMRI> tracker;
+  if (this->VtkHyperStreamlinePointsSettings)
+    {
+    this->UpdateHyperStreamlinePointsSettings(tracker.GetPointer());
+    }
+  tracker->OutputTensorsOn();
+  tracker->OneTrajectoryPerSeedPointOn();
+
+  SeedTractsThreadStruct str;
+  str.Self = this;
+  str.TensorField = inputTensorField;
+  str.Tracker = tracker.GetPointer();
+  str.Tolerance2 = inputTensorField->GetLength() / 1000.0;
+  str.Tolerance2 = str.Tolerance2 * str.Tolerance2;
+  str.Seeds = seeds;
+
+  // Matrices are copied so that the threads don't use the transforms
+  vtkNew<vtkMatrix4x4> tensorScaledIJKToWorld;
+  vtkMatrix4x4::Invert(this->WorldToTensorScaledIJK->GetMatrix(),
+                       tensorScaledIJKToWorld.GetPointer());
+  memcpy(str.TensorScaledIJKToWorld, tensorScaledIJKToWorld->Element,
+         sizeof(str.TensorScaledIJKToWorld));
+  for (int row = 0; row < 3; row++)
+    {
+    for (int col = 0; col < 3; col++)
+      {
+      str.Rotation[row][col] = this->TensorRotationMatrix->Element[row][col];
+      str.RotationTranspose[row][col] = this->TensorRotationMatrix->Element[col][row];
+      }
+    }
+
+  str.IntersectROI2 = intersectROI2;
+  str.MinimumPathLength = this->MinimumPathLength;
+  str.IntegrationStepLength = tracker->GetIntegrationStepLength();
+  str.ROI2Scalars = NULL;
+  str.ROI2Value = this->InputROI2Value;
+  if (intersectROI2)
+    {
+    vtkImageData* inputROI2 = vtkImageData::SafeDownCast(this->InputROIConnection2->GetProducer()->GetOutputDataObject(0));
+    if (!inputROI2 || inputROI2->GetScalarType() != VTK_SHORT)
+      {
+      vtkErrorMacro("ROI2 must be of type short.");
+      return;
+      }
+    vtkNew<vtkMatrix4x4> worldToROI2;
+    vtkMatrix4x4::Invert(this->ROI2ToWorld->GetMatrix(),
+                         worldToROI2.GetPointer());
+    memcpy(str.WorldToROI2, worldToROI2->Element, sizeof(str.WorldToROI2));
+    str.ROI2Scalars = static_cast<short*>(inputROI2->GetScalarPointer());
+    inputROI2->GetExtent(str.ROI2Extent);
+    inputROI2->GetIncrements(str.ROI2Increments);
+    }
+
+  const vtkIdType numberOfSeeds = seeds->GetNumberOfTuples();
+  str.Chunks.resize((numberOfSeeds + SeedChunkSize - 1) / SeedChunkSize);
+  str.NextChunk = 0;
+
+  int numberOfThreads = this->NumberOfThreads > 0 ?
+    this->NumberOfThreads : vtkMultiThreader::GetGlobalDefaultNumberOfThreads();
+  numberOfThreads = std::max(1, std::min(numberOfThreads,
+                                         static_cast<int>(str.Chunks.size())));
+  vtkNew<vtkMultiThreader> threader;
+  threader->SetNumberOfThreads(numberOfThreads);
+  threader->SetSingleMethod(SeedTractsThreadedExecute, &str);
+  threader->SingleMethodExecute();
+
+  // Concatenate the chunks in the order of the seed points
+  vtkIdType numberOfFibers = 0;
+  vtkIdType numberOfPoints = 0;
+  for (size_t i = 0; i < str.Chunks.size(); ++i)
+    {
+    numberOfFibers += static_cast<vtkIdType>(str.Chunks[i].NumberOfPoints.size());
+    numberOfPoints += static_cast<vtkIdType>(str.Chunks[i].Points.size() / 3);
+    }
+
+  vtkNew<vtkPoints> points;
+  points->SetDataTypeToFloat();
+  points->SetNumberOfPoints(numberOfPoints);
+  float *outPoints = vtkFloatArray::SafeDownCast(points->GetData())->GetPointer(0);
+
+  vtkNew<vtkFloatArray> newTensors;
+  newTensors->SetNumberOfComponents(9);
+  newTensors->SetNumberOfTuples(numberOfPoints);
+  float *outTensors = newTensors->GetPointer(0);
+
+  vtkNew<vtkCellArray> lines;
+  vtkIdType *cells = lines->WritePointer(numberOfFibers,
+                                         numberOfFibers + numberOfPoints);
+
+  vtkIdType ptId = 0;
+  for (size_t i = 0; i < str.Chunks.size(); ++i)
+    {
+    const FiberChunk &chunk = str.Chunks[i];
+    if (chunk.NumberOfPoints.empty())
+      {
+      continue;
+      }
+    memcpy(outPoints + 3 * ptId, &chunk.Points[0],
+           chunk.Points.size() * sizeof(float));
+    memcpy(outTensors + 9 * ptId, &chunk.Tensors[0],
+           chunk.Tensors.size() * sizeof(float));
+    for (size_t j = 0; j < chunk.NumberOfPoints.size(); ++j)
+      {
+      *cells++ = chunk.NumberOfPoints[j];
+      for (vtkIdType k = 0; k < chunk.NumberOfPoints[j]; ++k)
+        {
+        *cells++ = ptId++;
+        }
+      }
+    }
+
+  outFibers->SetPoints(points.GetPointer());
+  outFibers->SetLines(lines.GetPointer());
+  outFibers->GetPointData()->SetTensors(newTensors.GetPointer());
+  // Remove the scalars if any, we don't need
+  // to save anything but the tensors
+  outFibers->GetPointData()->SetScalars(NULL);
+
+  timer->StopTimer();
+  vtkDebugMacro("Traced " << numberOfFibers << " fibers from "
+                << numberOfSeeds << " seed points with " << numberOfThreads
+                << " threads in " << timer->GetElapsedTime() << "s");
+}
+
+//----------------------------------------------------------------------------
+void vtkSeedTracts::SeedStreamlinesInROIToPolyData(vtkPolyData *outFibers)
+{
+  if (outFibers == NULL)
+    {
+    vtkErrorMacro("PolyData objects has not been allocated");
+    return;
+    }
+  if (this->InputROIConnection == NULL)
+    {
+    vtkErrorMacro("No ROI input.");
+    return;
+    }
+  if (this->InputTensorFieldConnection == NULL)
+    {
+    vtkErrorMacro("No tensor data input.");
+    return;
+    }
+  if (this->InputROIValue <= 0)
+    {
+    vtkErrorMacro("Input ROI value has not been set or is 0. (value is "  << this->InputROIValue << ".");
+    return;
+    }
+  this->InputROIConnection->GetProducer()->Update();
+  this->InputTensorFieldConnection->GetProducer()->Update();
+
+  vtkNew<vtkDoubleArray> seeds;
+  seeds->SetNumberOfComponents(3);
+  this->ComputeSeedPoints(seeds.GetPointer(), true);
+  this->SeedStreamlinesToPolyData(seeds.GetPointer(), false, outFibers);
+}
+
+//----------------------------------------------------------------------------
+void vtkSeedTracts::SeedStreamlinesInROIWithMultipleValuesToPolyData(vtkPolyData *outFibers)
+{
+  if (outFibers == NULL)
+    {
+    vtkErrorMacro("PolyData objects has not been allocated");
+    return;
+    }
+  if (this->InputMultipleROIValues == NULL)
+    {
+    vtkErrorMacro(<<"No values to seed from. SetInputMultipleROIValues before trying.");
+    return;
+    }
+  if (this->InputROIConnection == NULL)
+    {
+    vtkErrorMacro("No ROI input.");
+    return;
+    }
+  if (this->InputTensorFieldConnection == NULL)
+    {
+    vtkErrorMacro("No tensor data input.");
+    return;
+    }
+  this->InputROIConnection->GetProducer()->Update();
+  this->InputTensorFieldConnection->GetProducer()->Update();
+
+  // The seed points of all the values are traced at once
+  int initialROIValue = this->InputROIValue;
+  vtkNew<vtkDoubleArray> seeds;
+  seeds->SetNumberOfComponents(3);
+  for (int i=0 ; i<this->InputMultipleROIValues->GetNumberOfTuples() ; i++)
+    {
+    this->InputROIValue = this->InputMultipleROIValues->GetValue(i);
+    if (this->InputROIValue <= 0)
+      {
+      vtkErrorMacro("Input ROI value has not been set or is 0. (value is "  << this->InputROIValue << ". Trying next value");
+      break;
+      }
+    this->ComputeSeedPoints(seeds.GetPointer(), true);
+    }
+  //Restore InputROIValue variable
+  this->InputROIValue = initialROIValue;
+
+  this->SeedStreamlinesToPolyData(seeds.GetPointer(), false, outFibers);
+}
+
+//----------------------------------------------------------------------------
+void vtkSeedTracts::SeedStreamlinesFromROIIntersectWithROI2ToPolyData(vtkPolyData *outFibers)
+{
+  if (outFibers == NULL)
+    {
+    vtkErrorMacro("PolyData objects has not been allocated");
+    return;
+    }
+  if (this->InputROIConnection == NULL || this->InputROIConnection2 == NULL)
+    {
+    vtkErrorMacro("No ROI input.");
+    return;
+    }
+  if (this->InputTensorFieldConnection == NULL)
+    {
+    vtkErrorMacro("No tensor data input.");
+    return;
+    }
+  this->InputROIConnection->GetProducer()->Update();
+  this->InputROIConnection2->GetProducer()->Update();
+  this->InputTensorFieldConnection->GetProducer()->Update();
+
+  // seed in each voxel in the ROI, as SeedStreamlinesFromROIIntersectWithROI2()
+  vtkNew<vtkDoubleArray> seeds;
+  seeds->SetNumberOfComponents(3);
+  this->ComputeSeedPoints(seeds.GetPointer(), false);
+  this->SeedStreamlinesToPolyData(seeds.GetPointer(), true, outFibers);
+}
+
 //----------------------------------------------------------------------------
 void vtkSeedTracts::DeleteAllStreamlines()
 {
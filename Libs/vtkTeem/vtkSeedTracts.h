@@ -25,6 +25,7 @@
 #include "vtkTransform.h"
 #include "vtkCollection.h"
 #include "vtkShortArray.h"
+class vtkDoubleArray;
 
 #include "vtkHyperStreamline.h"
 #include "vtkHyperStreamlineDTMRI.h"
@@ -62,6 +63,28 @@ public:
   /// that pass through ROI2.
   void SeedStreamlinesFromROIIntersectWithROI2();
 
+  /// Description
+  /// Same as SeedStreamlinesInROI(), SeedStreamlinesInROIWithMultipleValues()
+  /// and SeedStreamlinesFromROIIntersectWithROI2() but the streamlines are
+  /// traced in parallel by NumberOfThreads threads and directly stored into
+  /// \a outFibers, as TransformStreamlinesToRASAndAppendToPolyData() would:
+  /// one line per seed point, points in RAS and rotated tensors.
+  /// The Streamlines collection is not modified and FileDirectoryName is
+  /// ignored. The lines are in the order of their seed points, the output
+  /// does not depend on the number of threads.
+  /// Only vtkHyperStreamlineDTMRI streamlines are supported, using the
+  /// VtkHyperStreamlinePointsSettings if any.
+  void SeedStreamlinesInROIToPolyData(vtkPolyData *outFibers);
+  void SeedStreamlinesInROIWithMultipleValuesToPolyData(vtkPolyData *outFibers);
+  void SeedStreamlinesFromROIIntersectWithROI2ToPolyData(vtkPolyData *outFibers);
+
+  /// Description
+  /// Number of threads used by the *ToPolyData seeding methods.
+  /// If 0 (default), vtkMultiThreader::GetGlobalDefaultNumberOfThreads()
+  /// is used.
+  vtkSetMacro(NumberOfThreads,int);
+  vtkGetMacro(NumberOfThreads,int);
+
  /// Description
  /// Store all the streamlines in one vtkPolyData and
  /// transform the points to be in RAS. It takes
@@ -289,6 +312,20 @@ protected:
 
   int PointWithinTensorData(double *point, double *pointw);
 
+  /// Append to \a seeds the seed points (in scaled ijk of the tensors) of
+  /// the voxels with the value InputROIValue in the InputROI. The grid,
+  /// jittering and starting threshold options are only used if
+  /// \a useSeedingOptions is true.
+  void ComputeSeedPoints(vtkDoubleArray *seeds, bool useSeedingOptions);
+
+  /// Trace a streamline from each seed point with multiple threads and store
+  /// the ones longer than MinimumPathLength (or intersecting InputROI2 if
+  /// \a intersectROI2 is true) into \a outFibers.
+  void SeedStreamlinesToPolyData(vtkDoubleArray *seeds, bool intersectROI2,
+                                 vtkPolyData *outFibers);
+
+  int NumberOfThreads;
+
   int TypeOfHyperStreamline;
 
   char *FileDirectoryName;
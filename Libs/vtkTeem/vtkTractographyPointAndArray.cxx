@@ -13,6 +13,9 @@
 =========================================================================auto=*/
 #include "vtkTractographyPointAndArray.h"
 
+#include "vtkDoubleArray.h"
+#include "vtkGenericCell.h"
+
 // BTX
 vtkTractographyPoint::vtkTractographyPoint()
 {
@@ -96,3 +99,20 @@ vtkTractographyPoint *vtkTractographyArray::Resize(vtkIdType sz)
   return this->Array;
 }
 
+vtkTractographyScratch::vtkTractographyScratch()
+{
+  this->NumberOfStreamers = 0;
+  this->Cell = vtkGenericCell::New();
+  this->CellTensors = vtkDoubleArray::New();
+  this->CellScalars = vtkDoubleArray::New();
+  this->Weights = NULL;
+  this->WeightsSize = 0;
+}
+
+vtkTractographyScratch::~vtkTractographyScratch()
+{
+  this->Cell->Delete();
+  this->CellTensors->Delete();
+  this->CellScalars->Delete();
+  delete [] this->Weights;
+}
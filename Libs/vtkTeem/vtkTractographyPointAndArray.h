@@ -19,6 +19,9 @@
 #include "vtkStreamer.h"
 #include "vtkTeemConfigure.h"
 
+class vtkDoubleArray;
+class vtkGenericCell;
+
 /// copied directly from vtkTractographyStreamline.
 /// this class was defined in the vtkTractographyStreamline.cxx file.
 
@@ -76,6 +79,27 @@ public:
   double Direction;       /// integration direction
 };
 
+/// Buffers used to integrate the trajectories of a seed point, see
+/// vtkHyperStreamlineDTMRI::IntegrateStreamers(). A thread reuses the same
+/// buffers for all the seed points it integrates.
+class VTK_Teem_EXPORT vtkTractographyScratch { //;prevent man page generation
+public:
+  vtkTractographyScratch();
+  ~vtkTractographyScratch();
+
+  vtkTractographyArray Streamers[2]; /// one per integration direction
+  int NumberOfStreamers;
+  vtkGenericCell *Cell;
+  vtkDoubleArray *CellTensors; /// tensors at the points of Cell
+  vtkDoubleArray *CellScalars; /// scalars at the points of Cell
+  double *Weights;
+  int WeightsSize;
+
+private:
+  vtkTractographyScratch(const vtkTractographyScratch&); /// Not implemented.
+  void operator=(const vtkTractographyScratch&); /// Not implemented.
+};
+
 #define VTK_START_FROM_POSITION 0
 #define VTK_START_FROM_LOCATION 1
 
@@ -30,6 +30,8 @@ Version:   $Revision$
 #include "vtkITKArchetypeImageSeriesScalarReader.h"
 
 // VTK includes
+#include <vtkAlgorithmOutput.h>
+#include <vtkCriticalSection.h>
 #include <vtkDebugLeaks.h>
 #include <vtkDecimatePro.h>
 #include <vtkDiscreteMarchingCubes.h>
@@ -42,6 +44,8 @@ Version:   $Revision$
 #include <vtkImageToStructuredPoints.h>
 #include <vtkInformation.h>
 #include <vtkLookupTable.h>
+#include <vtkMatrix4x4.h>
+#include <vtkMultiThreader.h>
 #include <vtkNew.h>
 #include <vtkPointData.h>
 #include <vtkPolyDataNormals.h>
@@ -61,6 +65,418 @@ Version:   $Revision$
 // VTKsys includes
 #include <vtksys/SystemTools.hxx>
 
+// STD includes
+#include <algorithm>
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+// Model of a label generated by GenerateLabelSurfacesThreadedExecute()
+struct LabelSurfaceJob
+{
+  int Label;
+  std::string LabelName;
+  std::string FileName;
+  /// Extent of the voxels of the label in the input image
+  int LabelExtent[6];
+  bool Made;
+};
+
+//----------------------------------------------------------------------------
+// Shared by the threads generating the models of the labels
+struct LabelSurfaceThreadData
+{
+  std::vector<LabelSurfaceJob>* Jobs;
+  /// Guards NextJob, NumberOfCompletedJobs and the cropping of the input
+  vtkSimpleCriticalSection Lock;
+  size_t NextJob;
+  size_t NumberOfCompletedJobs;
+
+  vtkImageData* Image;
+  /// Translated image padded with a voxel, null if not padding
+  vtkAlgorithmOutput* PaddedImageConnection;
+  vtkMatrix4x4* IJKToRASMatrix;
+  std::string FilterType;
+  int Smooth;
+  float Decimate;
+  bool SplitNormals;
+  bool PointNormals;
+
+  ModuleProcessInformation* ProcessInformation;
+  double ProgressStart;
+  double ProgressFraction;
+};
+
+//----------------------------------------------------------------------------
+// Report progress the same way as vtkPluginFilterWatcher
+void ReportProgress(ModuleProcessInformation* processInformation,
+                    const std::string& comment, double progress)
+{
+  if (processInformation)
+    {
+    strncpy(processInformation->ProgressMessage, comment.c_str(), 1023);
+    processInformation->Progress = progress;
+    if (processInformation->ProgressCallbackFunction
+        && processInformation->ProgressCallbackClientData)
+      {
+      (*(processInformation->ProgressCallbackFunction))(processInformation->ProgressCallbackClientData);
+      }
+    }
+  else
+    {
+    std::cout << "<filter-progress>" << progress << "</filter-progress>" << std::endl;
+    std::cout << std::flush;
+    }
+}
+
+//----------------------------------------------------------------------------
+// Compute in one pass the extent of the voxels of each label between
+// minLabel and maxLabel. Labels without voxels have an empty extent.
+template <class T>
+void ComputeLabelExtents(vtkImageData* image, T* ptr, int minLabel, int maxLabel,
+                         std::vector<int>& labelExtents)
+{
+  labelExtents.resize(6 * (maxLabel - minLabel + 1));
+  for (size_t l = 0; l < labelExtents.size(); l += 6)
+    {
+    labelExtents[l] = labelExtents[l + 2] = labelExtents[l + 4] = VTK_INT_MAX;
+    labelExtents[l + 1] = labelExtents[l + 3] = labelExtents[l + 5] = VTK_INT_MIN;
+    }
+  int extent[6];
+  image->GetExtent(extent);
+  const int numberOfComponents = image->GetNumberOfScalarComponents();
+  for (int k = extent[4]; k <= extent[5]; ++k)
+    {
+    for (int j = extent[2]; j <= extent[3]; ++j)
+      {
+      for (int i = extent[0]; i <= extent[1]; ++i, ptr += numberOfComponents)
+        {
+        const double value = static_cast<double>(*ptr);
+        if (value < minLabel || value > maxLabel)
+          {
+          continue;
+          }
+        const int label = static_cast<int>(value);
+        if (label != value)
+          {
+          continue;
+          }
+        int* labelExtent = &labelExtents[6 * (label - minLabel)];
+        labelExtent[0] = std::min(labelExtent[0], i);
+        labelExtent[1] = std::max(labelExtent[1], i);
+        labelExtent[2] = std::min(labelExtent[2], j);
+        labelExtent[3] = std::max(labelExtent[3], j);
+        labelExtent[4] = std::min(labelExtent[4], k);
+        labelExtent[5] = std::max(labelExtent[5], k);
+        }
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+// Crop the input image to the extent of the label plus a voxel on each side
+// (so that the surface is the same as for the whole image).
+vtkSmartPointer<vtkImageData> CropLabel(LabelSurfaceThreadData* data,
+                                        const int labelExtent[6])
+{
+  int imageExtent[6];
+  data->Image->GetExtent(imageExtent);
+  int cropExtent[6];
+  vtkNew<vtkImageConstantPad> cropper;
+  cropper->SetNumberOfThreads(1);
+  cropper->SetConstant(0);
+  if (data->PaddedImageConnection)
+    {
+    // the padded image is translated by a voxel
+    for (int i = 0; i < 6; i += 2)
+      {
+      cropExtent[i] = labelExtent[i];
+      cropExtent[i + 1] = labelExtent[i + 1] + 2;
+      }
+    cropper->SetInputConnection(data->PaddedImageConnection);
+    }
+  else
+    {
+    for (int i = 0; i < 6; i += 2)
+      {
+      cropExtent[i] = std::max(labelExtent[i] - 1, imageExtent[i]);
+      cropExtent[i + 1] = std::min(labelExtent[i + 1] + 1, imageExtent[i + 1]);
+      }
+    cropper->SetInputData(data->Image);
+    }
+  cropper->SetOutputWholeExtent(cropExtent);
+  cropper->Update();
+  vtkSmartPointer<vtkImageData> croppedImage = vtkSmartPointer<vtkImageData>::New();
+  croppedImage->ShallowCopy(cropper->GetOutput());
+  return croppedImage;
+}
+
+//----------------------------------------------------------------------------
+// Same pipeline as the one of main() without joint smoothing, on the
+// cropped image.
+bool GenerateLabelSurface(LabelSurfaceJob& job, vtkImageData* croppedImage,
+                          LabelSurfaceThreadData* data)
+{
+  vtkNew<vtkImageThreshold> imageThreshold;
+  imageThreshold->SetNumberOfThreads(1);
+  imageThreshold->SetInputData(croppedImage);
+  imageThreshold->SetReplaceIn(1);
+  imageThreshold->SetReplaceOut(1);
+  imageThreshold->SetInValue(200);
+  imageThreshold->SetOutValue(0);
+  imageThreshold->ThresholdBetween(job.Label, job.Label);
+  imageThreshold->ReleaseDataFlagOn();
+
+  vtkNew<vtkMarchingCubes> mcubes;
+  mcubes->SetInputConnection(imageThreshold->GetOutputPort());
+  mcubes->SetValue(0, 100.5);
+  mcubes->ComputeScalarsOff();
+  mcubes->ComputeGradientsOff();
+  mcubes->ComputeNormalsOff();
+  mcubes->ReleaseDataFlagOn();
+  mcubes->Update();
+  if (mcubes->GetOutput()->GetNumberOfPolys() == 0)
+    {
+    return false;
+    }
+
+  vtkNew<vtkDecimatePro> decimator;
+  decimator->SetInputConnection(mcubes->GetOutputPort());
+  decimator->SetFeatureAngle(60);
+  decimator->SplittingOff();
+  decimator->PreserveTopologyOn();
+  decimator->SetMaximumError(1);
+  decimator->SetTargetReduction(data->Decimate);
+  decimator->ReleaseDataFlagOff();
+  vtkAlgorithmOutput* surfaceConnection = decimator->GetOutputPort();
+
+  vtkNew<vtkReverseSense> reverser;
+  if (data->IJKToRASMatrix->Determinant() < 0)
+    {
+    reverser->SetInputConnection(surfaceConnection);
+    reverser->ReverseNormalsOn();
+    reverser->ReleaseDataFlagOn();
+    surfaceConnection = reverser->GetOutputPort();
+    }
+
+  vtkSmartPointer<vtkPolyDataAlgorithm> smoother;
+  if (data->FilterType == "Sinc")
+    {
+    vtkSmartPointer<vtkWindowedSincPolyDataFilter> smootherSinc =
+      vtkSmartPointer<vtkWindowedSincPolyDataFilter>::New();
+    smootherSinc->SetPassBand(0.1);
+    smootherSinc->SetNumberOfIterations(data->Smooth);
+    smootherSinc->FeatureEdgeSmoothingOff();
+    smootherSinc->BoundarySmoothingOff();
+    smoother = smootherSinc;
+    }
+  else
+    {
+    vtkSmartPointer<vtkSmoothPolyDataFilter> smootherPoly =
+      vtkSmartPointer<vtkSmoothPolyDataFilter>::New();
+    smootherPoly->SetRelaxationFactor(0.33);
+    smootherPoly->SetFeatureAngle(60);
+    smootherPoly->SetConvergence(0);
+    smootherPoly->SetNumberOfIterations(data->Smooth);
+    smootherPoly->FeatureEdgeSmoothingOff();
+    smootherPoly->BoundarySmoothingOff();
+    smoother = smootherPoly;
+    }
+  smoother->SetInputConnection(surfaceConnection);
+  smoother->ReleaseDataFlagOn();
+
+  // each thread has its own transform, vtkTransform updates are not thread safe
+  vtkNew<vtkTransform> transformIJKtoRAS;
+  transformIJKtoRAS->SetMatrix(data->IJKToRASMatrix);
+  vtkNew<vtkTransformPolyDataFilter> transformer;
+  transformer->SetInputConnection(smoother->GetOutputPort());
+  transformer->SetTransform(transformIJKtoRAS.GetPointer());
+  transformer->ReleaseDataFlagOn();
+
+  vtkNew<vtkPolyDataNormals> normals;
+  normals->SetComputePointNormals(data->PointNormals);
+  normals->SetInputConnection(transformer->GetOutputPort());
+  normals->SetFeatureAngle(60);
+  normals->SetSplitting(data->SplitNormals);
+  normals->ReleaseDataFlagOn();
+
+  vtkNew<vtkStripper> stripper;
+  stripper->SetInputConnection(normals->GetOutputPort());
+  stripper->ReleaseDataFlagOff();
+  stripper->Update();
+
+  vtkNew<vtkPolyDataWriter> writer;
+  writer->SetInputConnection(stripper->GetOutputPort());
+  writer->SetFileType(2);
+  writer->SetFileName(job.FileName.c_str());
+  if (!writer->Write())
+    {
+    std::cerr << "ERROR: Failed to write model file " << job.FileName.c_str() << std::endl;
+    }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+VTK_THREAD_RETURN_TYPE GenerateLabelSurfacesThreadedExecute(void* arg)
+{
+  vtkMultiThreader::ThreadInfo* info = static_cast<vtkMultiThreader::ThreadInfo*>(arg);
+  LabelSurfaceThreadData* data = static_cast<LabelSurfaceThreadData*>(info->UserData);
+  std::vector<LabelSurfaceJob>& jobs = *data->Jobs;
+  while (true)
+    {
+    data->Lock.Lock();
+    const bool abort = data->ProcessInformation && data->ProcessInformation->Abort;
+    const size_t jobIndex = data->NextJob++;
+    vtkSmartPointer<vtkImageData> croppedImage;
+    if (!abort && jobIndex < jobs.size())
+      {
+      croppedImage = CropLabel(data, jobs[jobIndex].LabelExtent);
+      }
+    data->Lock.Unlock();
+    if (!croppedImage)
+      {
+      break;
+      }
+
+    jobs[jobIndex].Made = GenerateLabelSurface(jobs[jobIndex], croppedImage, data);
+    croppedImage = NULL;
+
+    data->Lock.Lock();
+    const size_t numberOfCompletedJobs = ++data->NumberOfCompletedJobs;
+    data->Lock.Unlock();
+    // the progress callback might not be thread safe, only the calling
+    // thread reports it
+    if (info->ThreadID == 0)
+      {
+      ReportProgress(data->ProcessInformation, "Generate Models",
+                     data->ProgressStart + data->ProgressFraction *
+                       numberOfCompletedJobs / jobs.size());
+      }
+    }
+  return VTK_THREAD_RETURN_VALUE;
+}
+
+//----------------------------------------------------------------------------
+// Add a model node with its storage and display nodes for the model of a
+// label that has been written in fileName, and put it in the hierarchy.
+void AddModelToScene(vtkMRMLScene* modelScene, int label,
+                     const std::string& labelName, const std::string& fileName,
+                     vtkMRMLColorTableNode* colorNode,
+                     vtkMRMLModelHierarchyNode* topColorHierarchyNode,
+                     vtkMRMLNode* rnd, bool debug)
+{
+  if (debug)
+    {
+    std::cout << "Adding model " << labelName << " to the output scene, with filename " << fileName.c_str()
+              << endl;
+    }
+  // each model needs a mrml node, a storage node and a display node
+  vtkNew<vtkMRMLModelNode> mnode;
+  mnode->SetScene(modelScene);
+  mnode->SetName(labelName.c_str());
+
+  vtkNew<vtkMRMLModelStorageNode> snode;
+  snode->SetFileName(fileName.c_str());
+  if (modelScene->AddNode(snode.GetPointer()) == NULL)
+    {
+    std::cerr << "ERROR: unable to add the storage node to the model scene" << endl;
+    }
+  vtkNew<vtkMRMLModelDisplayNode> dnode;
+  dnode->SetColor(0.5, 0.5, 0.5);
+  double *rgba;
+  if (colorNode != NULL)
+    {
+    rgba = colorNode->GetLookupTable()->GetTableValue(label);
+    if (rgba != NULL)
+      {
+      if (debug)
+        {
+        std::cout << "Got colour: " << rgba[0] << " " << rgba[1] << " " << rgba[2] << " " << rgba[3] << endl;
+        }
+      dnode->SetColor(rgba[0], rgba[1], rgba[2]);
+      }
+    else
+      {
+      std::cerr << "Couldn't get look up table value for " << label << ", display node colour is not set (grey)"
+                << endl;
+      }
+    }
+
+  dnode->SetVisibility(1);
+  modelScene->AddNode(dnode.GetPointer());
+  if (debug)
+    {
+    std::cout << "Added display node: id = " << (dnode->GetID() == NULL ? "(null)" : dnode->GetID()) << endl;
+    std::cout << "Setting model's storage node: id = "
+              << (snode->GetID() == NULL ? "(null)" : snode->GetID()) << endl;
+    }
+  mnode->SetAndObserveStorageNodeID(snode->GetID());
+  mnode->SetAndObserveDisplayNodeID(dnode->GetID());
+  modelScene->AddNode(mnode.GetPointer());
+
+  // put it in the hierarchy, either the flat one by default or
+  // try to find the matching color hierarchy node to make this an
+  // associated node
+  std::string colorName;
+  if (colorNode != NULL)
+    {
+    colorName = std::string(colorNode->GetColorNameAsFileName(label));
+    }
+  else
+    {
+    // might be in a testing case where the hierarchy nodes are
+    // numbered (made from the generic colors)
+    std::stringstream ss;
+    ss << label;
+    colorName = ss.str();
+    if (debug)
+      {
+      std::cout << "No color node, guessing at color name being same as label number " << colorName.c_str() << std::endl;
+      }
+    }
+  vtkMRMLNode *mrmlNode = NULL;
+  if (colorName.compare("") != 0)
+    {
+    mrmlNode = modelScene->GetFirstNodeByName(colorName.c_str());
+    }
+  // if there's no color hierarchy, or no color name or the mrml node
+  // named for the color isn't a model hierarchy node, use a flat hierarchy
+  if (topColorHierarchyNode == NULL ||
+      colorName.compare("") == 0 ||
+      mrmlNode == NULL ||
+      strcmp(mrmlNode->GetClassName(),"vtkMRMLModelHierarchyNode") != 0)
+    {
+    vtkNew<vtkMRMLModelHierarchyNode> mhnd;
+    mhnd->SetHideFromEditors(1);
+    modelScene->AddNode(mhnd.GetPointer());
+    mhnd->SetParentNodeID(rnd->GetID());
+    mhnd->SetModelNodeID(mnode->GetID());
+    }
+  else
+    {
+    // use the template color hierarchy
+    vtkMRMLModelHierarchyNode *colorHierarchyNode = vtkMRMLModelHierarchyNode::SafeDownCast(mrmlNode);
+    if (colorHierarchyNode)
+      {
+      colorHierarchyNode->SetAssociatedNodeID(mnode->GetID());
+      // and hide it so that it doesn't clutter up the tree
+      colorHierarchyNode->SetHideFromEditors(1);
+      if (debug)
+        {
+        std::cout << "Found a color hierarchy node with name " << colorHierarchyNode->GetName() << ", set it's associated node to this model id: " << mnode->GetID() << std::endl;
+        }
+      }
+    }
+  if (debug)
+    {
+    std::cout << "...done adding model to output scene" << endl;
+    }
+}
+
+}
+
+//----------------------------------------------------------------------------
 int main(int argc, char * argv[])
 {
   PARSE_ARGS;
@@ -85,6 +501,7 @@ int main(int argc, char * argv[])
     std::cout << "Split normals? " << SplitNormals << std::endl;
     std::cout << "Calculate point normals? " << PointNormals << std::endl;
     std::cout << "Pad? " << Pad << std::endl;
+    std::cout << "Number of threads: " << NumberOfThreads << std::endl;
     std::cout << "Filter type: " << FilterType << std::endl;
     std::cout << "Input color hierarchy scene file: "
               << (ModelHierarchyFile.size() > 0 ? ModelHierarchyFile.c_str() : "None")  << std::endl;
@@ -869,6 +1286,18 @@ int main(int argc, char * argv[])
       loopLabels.push_back(Labels[i]);
       }
     }
+
+  // Without joint smoothing, the models of the labels can be generated
+  // concurrently on the images cropped around each label.
+  const bool parallelSurfaces =
+    (NumberOfThreads != 1 && JointSmoothing == 0 && !SaveIntermediateModels);
+  if (NumberOfThreads != 1 && !parallelSurfaces)
+    {
+    std::cout << "Joint smoothing or saving intermediate models, "
+              << "generating the models one after another" << std::endl;
+    }
+  std::vector<LabelSurfaceJob> surfaceJobs;
+
   for(::size_t l = 0; l < loopLabels.size(); l++)
     {
     // get the label out of the vector
@@ -979,6 +1408,25 @@ int main(int argc, char * argv[])
       */
       }
 
+    if (parallelSurfaces)
+      {
+      LabelSurfaceJob job;
+      job.Label = i;
+      job.LabelName = labelName;
+      if (rootDir != "")
+        {
+        job.FileName = rootDir + std::string("/") + labelName + std::string(".vtk");
+        }
+      else
+        {
+        std::cout << "WARNING: output directory is an empty string..." << endl;
+        job.FileName = labelName + std::string(".vtk");
+        }
+      job.Made = false;
+      surfaceJobs.push_back(job);
+      continue;
+      }
+
     // threshold
     if (JointSmoothing == 0)
       {
@@ -1609,115 +2057,119 @@ int main(int argc, char * argv[])
       writer = NULL;
       if (modelScene.GetPointer() != NULL)
         {
-        if (debug)
-          {
-          std::cout << "Adding model " << labelName << " to the output scene, with filename " << fileName.c_str()
-                    << endl;
-          }
-        // each model needs a mrml node, a storage node and a display node
-        vtkNew<vtkMRMLModelNode> mnode;
-        mnode->SetScene(modelScene.GetPointer());
-        mnode->SetName(labelName.c_str());
-
-        vtkNew<vtkMRMLModelStorageNode> snode;
-        snode->SetFileName(fileName.c_str());
-        if (modelScene->AddNode(snode.GetPointer()) == NULL)
-          {
-          std::cerr << "ERROR: unable to add the storage node to the model scene" << endl;
-          }
-        vtkNew<vtkMRMLModelDisplayNode> dnode;
-        dnode->SetColor(0.5, 0.5, 0.5);
-        double *rgba;
-        if (colorNode != NULL)
-          {
-          rgba = colorNode->GetLookupTable()->GetTableValue(i);
-          if (rgba != NULL)
-            {
-            if (debug)
-              {
-              std::cout << "Got colour: " << rgba[0] << " " << rgba[1] << " " << rgba[2] << " " << rgba[3] << endl;
-              }
-            dnode->SetColor(rgba[0], rgba[1], rgba[2]);
-            }
-          else
-            {
-            std::cerr << "Couldn't get look up table value for " << i << ", display node colour is not set (grey)"
-                      << endl;
-            }
-          }
-
-        dnode->SetVisibility(1);
-        modelScene->AddNode(dnode.GetPointer());
-        if (debug)
-          {
-          std::cout << "Added display node: id = " << (dnode->GetID() == NULL ? "(null)" : dnode->GetID()) << endl;
-          std::cout << "Setting model's storage node: id = "
-                    << (snode->GetID() == NULL ? "(null)" : snode->GetID()) << endl;
-          }
-        mnode->SetAndObserveStorageNodeID(snode->GetID());
-        mnode->SetAndObserveDisplayNodeID(dnode->GetID());
-        modelScene->AddNode(mnode.GetPointer());
-
-        // put it in the hierarchy, either the flat one by default or
-        // try to find the matching color hierarchy node to make this an
-        // associated node
-        std::string colorName;
-        if (colorNode != NULL)
-          {
-          colorName = std::string(colorNode->GetColorNameAsFileName(i));
-          }
-        else
-          {
-          // might be in a testing case where the hierarchy nodes are
-          // numbered (made from the generic colors)
-          std::stringstream ss;
-          ss << i;
-          colorName = ss.str();
-          if (debug)
-            {
-            std::cout << "No color node, guessing at color name being same as label number " << colorName.c_str() << std::endl;
-            }
-          }
-        vtkMRMLNode *mrmlNode = NULL;
-        if (colorName.compare("") != 0)
-          {
-          mrmlNode = modelScene->GetFirstNodeByName(colorName.c_str());
-          }
-        // if there's no color hierarchy, or no color name or the mrml node
-        // named for the color isn't a model hierarchy node, use a flat hierarchy
-        if (topColorHierarchyNode == NULL ||
-            colorName.compare("") == 0 ||
-            mrmlNode == NULL ||
-            strcmp(mrmlNode->GetClassName(),"vtkMRMLModelHierarchyNode") != 0)
-          {
-          vtkNew<vtkMRMLModelHierarchyNode> mhnd;
-          mhnd->SetHideFromEditors(1);
-          modelScene->AddNode(mhnd.GetPointer());
-          mhnd->SetParentNodeID(rnd->GetID());
-          mhnd->SetModelNodeID(mnode->GetID());
-          }
-        else
-          {
-          // use the template color hierarchy
-          vtkMRMLModelHierarchyNode *colorHierarchyNode = vtkMRMLModelHierarchyNode::SafeDownCast(mrmlNode);
-          if (colorHierarchyNode)
-            {
-            colorHierarchyNode->SetAssociatedNodeID(mnode->GetID());
-            // and hide it so that it doesn't clutter up the tree
-            colorHierarchyNode->SetHideFromEditors(1);
-            if (debug)
-              {
-              std::cout << "Found a color hierarchy node with name " << colorHierarchyNode->GetName() << ", set it's associated node to this model id: " << mnode->GetID() << std::endl;
-              }
-            }
-          }
-        if (debug)
-          {
-          std::cout << "...done adding model to output scene" << endl;
-          }
+        AddModelToScene(modelScene.GetPointer(), i, labelName, fileName,
+                        colorNode, topColorHierarchyNode, rnd, debug);
         }
       } // end of skipping an empty label
     }   // end of loop over labels
+
+  if (parallelSurfaces && surfaceJobs.size() > 0)
+    {
+    int minLabel = surfaceJobs[0].Label;
+    int maxLabel = surfaceJobs[0].Label;
+    for (::size_t j = 1; j < surfaceJobs.size(); ++j)
+      {
+      minLabel = std::min(minLabel, surfaceJobs[j].Label);
+      maxLabel = std::max(maxLabel, surfaceJobs[j].Label);
+      }
+    std::vector<int> labelExtents;
+    switch (image->GetScalarType())
+      {
+      vtkTemplateMacro(ComputeLabelExtents(image, static_cast<VTK_TT*>(image->GetScalarPointer()),
+                                           minLabel, maxLabel, labelExtents));
+      default:
+        std::cerr << "ERROR: unsupported input scalar type " << image->GetScalarType() << std::endl;
+        return EXIT_FAILURE;
+      }
+    // labels without voxels are skipped the same way as by marching cubes
+    std::vector<LabelSurfaceJob> jobs;
+    for (::size_t j = 0; j < surfaceJobs.size(); ++j)
+      {
+      const int* labelExtent = &labelExtents[6 * (surfaceJobs[j].Label - minLabel)];
+      if (labelExtent[0] > labelExtent[1])
+        {
+        std::cout << "Cannot create a model from label " << surfaceJobs[j].Label
+                  << "\nNo polygons can be created,\nthere may be no voxels with this label in the volume." << endl;
+        continue;
+        }
+      std::copy(labelExtent, labelExtent + 6, surfaceJobs[j].LabelExtent);
+      jobs.push_back(surfaceJobs[j]);
+      }
+
+    if (strcmp(FilterType.c_str(), "Sinc") == 0 && Smooth == 1)
+      {
+      std::cerr << "Warning: Smoothing iterations of 1 not allowed for Sinc filter, using 2" << endl;
+      Smooth = 2;
+      }
+    vtkNew<vtkMatrix4x4> ijkToRASMatrix;
+    ijkToRASMatrix->DeepCopy(transformIJKtoRAS->GetMatrix());
+
+    LabelSurfaceThreadData data;
+    data.Jobs = &jobs;
+    data.NextJob = 0;
+    data.NumberOfCompletedJobs = 0;
+    data.Image = image;
+    data.PaddedImageConnection = Pad ? padder->GetInputConnection(0, 0) : 0;
+    data.IJKToRASMatrix = ijkToRASMatrix.GetPointer();
+    data.FilterType = FilterType;
+    data.Smooth = Smooth;
+    data.Decimate = Decimate;
+    data.SplitNormals = SplitNormals;
+    data.PointNormals = PointNormals;
+    data.ProcessInformation = CLPProcessInformation;
+    data.ProgressStart = currentFilterOffset / numFilterSteps;
+    data.ProgressFraction = numRepeatedFilterSteps * jobs.size() / numFilterSteps;
+
+    int numberOfThreads = NumberOfThreads > 0 ?
+      NumberOfThreads : vtkMultiThreader::GetGlobalDefaultNumberOfThreads();
+    numberOfThreads = std::min(numberOfThreads, static_cast<int>(jobs.size()));
+    if (debug)
+      {
+      std::cout << "Generating " << jobs.size() << " models with "
+                << numberOfThreads << " threads" << std::endl;
+      }
+    if (!CLPProcessInformation)
+      {
+      std::cout << "<filter-start>" << std::endl;
+      std::cout << "<filter-name>ModelMaker</filter-name>" << std::endl;
+      std::cout << "<filter-comment> \"Generate Models\" </filter-comment>" << std::endl;
+      std::cout << "</filter-start>" << std::endl;
+      std::cout << std::flush;
+      }
+    vtkNew<vtkMultiThreader> threader;
+    threader->SetNumberOfThreads(std::max(numberOfThreads, 1));
+    threader->SetSingleMethod(GenerateLabelSurfacesThreadedExecute, &data);
+    threader->SingleMethodExecute();
+    if (!CLPProcessInformation)
+      {
+      std::cout << "<filter-end>" << std::endl;
+      std::cout << "<filter-name>ModelMaker</filter-name>" << std::endl;
+      std::cout << "</filter-end>";
+      std::cout << std::flush;
+      }
+    if (CLPProcessInformation && CLPProcessInformation->Abort)
+      {
+      std::cerr << "Model generation aborted" << std::endl;
+      return EXIT_FAILURE;
+      }
+    currentFilterOffset += numRepeatedFilterSteps * jobs.size();
+
+    // add the models to the scene in the order of the labels
+    for (::size_t j = 0; j < jobs.size(); ++j)
+      {
+      if (!jobs[j].Made)
+        {
+        std::cout << "Cannot create a model from label " << jobs[j].Label
+                  << "\nNo polygons can be created,\nthere may be no voxels with this label in the volume." << endl;
+        continue;
+        }
+      if (modelScene.GetPointer() != NULL)
+        {
+        AddModelToScene(modelScene.GetPointer(), jobs[j].Label, jobs[j].LabelName,
+                        jobs[j].FileName, colorNode, topColorHierarchyNode, rnd, debug);
+        }
+      }
+    }
   if (debug)
     {
     std::cout << "End of looping over labels" << endl;
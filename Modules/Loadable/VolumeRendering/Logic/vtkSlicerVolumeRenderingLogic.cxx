@@ -33,6 +33,7 @@
 #include <vtkMRMLViewNode.h>
 #include <vtkMRMLVectorVolumeDisplayNode.h>
 #include <vtkMRMLVectorVolumeNode.h>
+#include <vtkMRMLVolumeHistogram.h>
 #include <vtkMRMLVolumePropertyNode.h>
 #include <vtkMRMLVolumePropertyStorageNode.h>
 
@@ -325,9 +326,9 @@ void vtkSlicerVolumeRenderingLogic
   {
     return;
   }
-  vtkImageData *input = vtkMRMLScalarVolumeNode::SafeDownCast(vspNode->GetVolumeNode())->GetImageData();
+  vtkMRMLVolumeHistogram* histogram = vspNode->GetVolumeNode()->GetHistogram();
   vtkVolumeProperty *prop = vspNode->GetVolumePropertyNode()->GetVolumeProperty();
-  if (input == NULL || prop == NULL)
+  if (prop == NULL)
     {
     return;
     }
@@ -335,14 +336,12 @@ void vtkSlicerVolumeRenderingLogic
   //update scalar range
   vtkColorTransferFunction *functionColor = prop->GetRGBTransferFunction();
 
-  vtkDataArray* scalars = input->GetPointData()->GetScalars();
-  if (!scalars)
+  // The exact scalar range is cached by the volume node histogram
+  double rangeNew[2];
+  if (!histogram->GetScalarRange(rangeNew))
     {
     return;
     }
-
-  double rangeNew[2];
-  scalars->GetRange(rangeNew);
   functionColor->AdjustRange(rangeNew);
   vtkDebugMacro("Color range: "<< functionColor->GetRange()[0] << " " << functionColor->GetRange()[1]);
 
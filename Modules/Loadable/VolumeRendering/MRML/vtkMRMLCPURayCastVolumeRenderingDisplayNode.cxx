@@ -34,6 +34,10 @@ vtkMRMLNodeNewMacro(vtkMRMLCPURayCastVolumeRenderingDisplayNode);
 vtkMRMLCPURayCastVolumeRenderingDisplayNode::vtkMRMLCPURayCastVolumeRenderingDisplayNode()
 {
   this->RaycastTechnique = vtkMRMLCPURayCastVolumeRenderingDisplayNode::Composite;
+  this->ProgressiveRendering = 0;
+  this->InteractiveImageSampleDistance = 4.;
+  this->LastFrameRenderTime = 0.;
+  this->LastFrameImageSampleDistance = 0.;
 }
 
 //----------------------------------------------------------------------------
@@ -59,6 +63,20 @@ void vtkMRMLCPURayCastVolumeRenderingDisplayNode::ReadXMLAttributes(const char**
       ss >> this->RaycastTechnique;
       continue;
       }
+    if (!strcmp(attName,"progressiveRendering"))
+      {
+      std::stringstream ss;
+      ss << attValue;
+      ss >> this->ProgressiveRendering;
+      continue;
+      }
+    if (!strcmp(attName,"interactiveImageSampleDistance"))
+      {
+      std::stringstream ss;
+      ss << attValue;
+      ss >> this->InteractiveImageSampleDistance;
+      continue;
+      }
     }
 }
 
@@ -70,6 +88,8 @@ void vtkMRMLCPURayCastVolumeRenderingDisplayNode::WriteXML(ostream& of, int nInd
   vtkIndent indent(nIndent);
 
   of << indent << " raycastTechnique=\"" << this->RaycastTechnique << "\"";
+  of << indent << " progressiveRendering=\"" << this->ProgressiveRendering << "\"";
+  of << indent << " interactiveImageSampleDistance=\"" << this->InteractiveImageSampleDistance << "\"";
 }
 
 //----------------------------------------------------------------------------
@@ -80,6 +100,8 @@ void vtkMRMLCPURayCastVolumeRenderingDisplayNode::Copy(vtkMRMLNode *anode)
   vtkMRMLCPURayCastVolumeRenderingDisplayNode *node = vtkMRMLCPURayCastVolumeRenderingDisplayNode::SafeDownCast(anode);
 
   this->SetRaycastTechnique(node->GetRaycastTechnique());
+  this->SetProgressiveRendering(node->GetProgressiveRendering());
+  this->SetInteractiveImageSampleDistance(node->GetInteractiveImageSampleDistance());
 
   this->EndModify(wasModifying);
 }
@@ -90,4 +112,18 @@ void vtkMRMLCPURayCastVolumeRenderingDisplayNode::PrintSelf(ostream& os, vtkInde
   this->Superclass::PrintSelf(os,indent);
 
   os << "RaycastTechnique: " << this->RaycastTechnique << "\n";
+  os << "ProgressiveRendering: " << this->ProgressiveRendering << "\n";
+  os << "InteractiveImageSampleDistance: " << this->InteractiveImageSampleDistance << "\n";
+  os << "LastFrameRenderTime: " << this->LastFrameRenderTime << "\n";
+  os << "LastFrameImageSampleDistance: " << this->LastFrameImageSampleDistance << "\n";
+}
+
+//----------------------------------------------------------------------------
+void vtkMRMLCPURayCastVolumeRenderingDisplayNode
+::SetLastFrameTiming(double renderTime, double imageSampleDistance)
+{
+  // Timing is updated after every frame, a ModifiedEvent would trigger yet
+  // another render.
+  this->LastFrameRenderTime = renderTime;
+  this->LastFrameImageSampleDistance = imageSampleDistance;
 }
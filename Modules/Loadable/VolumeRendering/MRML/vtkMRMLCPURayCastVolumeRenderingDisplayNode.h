@@ -56,6 +56,27 @@ public:
   vtkGetMacro (RaycastTechnique, int);
   vtkSetMacro (RaycastTechnique, int);
 
+  /// Render at a coarse image sample distance while the camera moves, then
+  /// refine the image over the next frames until full quality is reached.
+  /// Refinement is cancelled as soon as a new interaction starts.
+  /// 0 by default.
+  vtkGetMacro (ProgressiveRendering, int);
+  vtkSetMacro (ProgressiveRendering, int);
+  vtkBooleanMacro (ProgressiveRendering, int);
+
+  /// Image sample distance (in pixels) used while interacting when
+  /// ProgressiveRendering is enabled. Each refinement frame halves it.
+  /// 4 by default.
+  vtkGetMacro (InteractiveImageSampleDistance, double);
+  vtkSetMacro (InteractiveImageSampleDistance, double);
+
+  /// Time (in seconds) taken by the last rendered frame and the image sample
+  /// distance it was rendered with. These are set by the displayable manager
+  /// after each frame and don't fire any ModifiedEvent.
+  vtkGetMacro (LastFrameRenderTime, double);
+  vtkGetMacro (LastFrameImageSampleDistance, double);
+  void SetLastFrameTiming(double renderTime, double imageSampleDistance);
+
 protected:
   vtkMRMLCPURayCastVolumeRenderingDisplayNode();
   ~vtkMRMLCPURayCastVolumeRenderingDisplayNode();
@@ -71,6 +92,12 @@ protected:
    * 5: Illustrative Context Preserving Exploration
    * */
   int RaycastTechnique;
+
+  int ProgressiveRendering;
+  double InteractiveImageSampleDistance;
+
+  double LastFrameRenderTime;
+  double LastFrameImageSampleDistance;
 };
 
 #endif
@@ -37,6 +37,7 @@
 #include "vtkMRMLSliceLogic.h"
 #include "vtkMRMLTransformNode.h"
 #include "vtkMRMLViewNode.h"
+#include "vtkMRMLVolumeHistogram.h"
 #include "vtkMRMLVolumePropertyNode.h"
 #include "vtkMRMLVolumePropertyStorageNode.h"
 #include "vtkMRMLVolumeRenderingDisplayNode.h"
@@ -108,6 +109,8 @@ vtkMRMLVolumeRenderingDisplayableManager::vtkMRMLVolumeRenderingDisplayableManag
   this->Interaction = 0;
   // 0fps is a special value that means it hasn't been set.
   this->OriginalDesiredUpdateRate = 0.;
+  this->StyleInteraction = 0;
+  this->ProgressiveImageSampleDistance = 0.;
 
   this->RemoveInteractorStyleObservableEvent(vtkCommand::LeftButtonPressEvent);
   this->RemoveInteractorStyleObservableEvent(vtkCommand::LeftButtonReleaseEvent);
@@ -245,38 +248,13 @@ void vtkMRMLVolumeRenderingDisplayableManager::Reset()
 //---------------------------------------------------------------------------
 void vtkMRMLVolumeRenderingDisplayableManager::SetupHistograms(vtkMRMLVolumeRenderingDisplayNode* vspNode)
 {
-  vtkImageData *input = vtkMRMLScalarVolumeNode::SafeDownCast(vspNode->GetVolumeNode())->GetImageData();
-  if (input == NULL)
+  vtkMRMLVolumeNode* volumeNode = vspNode->GetVolumeNode();
+  if (volumeNode == NULL)
     {
     return;
     }
-/***
-  //-----------------------------------------
-  //  remove old histogram
-  //-----------------------------------------
-  if(this->Histograms != NULL)
-  {
-    this->Histograms->RemoveAllHistograms();
-    this->Histograms->Delete();
-    this->Histograms = vtkKWHistogramSet::New();
-  }
-
-  //setup histograms
-  this->Histograms->AddHistograms(input->GetPointData()->GetScalars());
-
-  //gradient histogram
-  vtkImageGradientMagnitude *grad = vtkImageGradientMagnitude::New();
-  grad->SetDimensionality(3);
-  grad->SetInputData(input);
-  grad->Update();
-
-  vtkKWHistogram *gradHisto = vtkKWHistogram::New();
-  gradHisto->BuildHistogram(grad->GetOutput()->GetPointData()->GetScalars(), 0);
-  this->Histograms->AddHistogram(gradHisto, "0gradient");
-
-  grad->Delete();
-  gradHisto->Delete();
-****/
+  // The gradient magnitude histogram is computed on demand only.
+  volumeNode->GetHistogram()->UpdateScalarHistogram();
 }
 
 //---------------------------------------------------------------------------
@@ -417,10 +395,13 @@ void vtkMRMLVolumeRenderingDisplayableManager
   this->UpdateMapper(mapper, vspNode);
   const bool highDef = vspNode->GetPerformanceControl() ==
     vtkMRMLVolumeRenderingDisplayNode::MaximumQuality;
-  mapper->SetAutoAdjustSampleDistances( highDef ? 0 : 1);
+  // In progressive rendering, the image sample distance is driven by the
+  // interaction instead of the allocated render time.
+  mapper->SetAutoAdjustSampleDistances(
+    highDef || vspNode->GetProgressiveRendering() ? 0 : 1);
   mapper->SetSampleDistance(this->GetSampleDistance(vspNode));
   mapper->SetInteractiveSampleDistance(this->GetSampleDistance(vspNode));
-  mapper->SetImageSampleDistance(highDef ? 0.5 : 1.);
+  mapper->SetImageSampleDistance(this->GetCPURaycastImageSampleDistance(vspNode));
 
   switch(vspNode->GetRaycastTechnique())
     {
@@ -436,6 +417,69 @@ void vtkMRMLVolumeRenderingDisplayableManager
     }
 }
 
+//---------------------------------------------------------------------------
+double vtkMRMLVolumeRenderingDisplayableManager
+::GetFullQualityImageSampleDistance(vtkMRMLVolumeRenderingDisplayNode* vspNode)
+{
+  return vspNode->GetPerformanceControl() ==
+    vtkMRMLVolumeRenderingDisplayNode::MaximumQuality ? 0.5 : 1.;
+}
+
+//---------------------------------------------------------------------------
+double vtkMRMLVolumeRenderingDisplayableManager
+::GetCPURaycastImageSampleDistance(vtkMRMLCPURayCastVolumeRenderingDisplayNode* vspNode)
+{
+  const double fullQualityImageSampleDistance =
+    this->GetFullQualityImageSampleDistance(vspNode);
+  if (!vspNode->GetProgressiveRendering() ||
+      this->ProgressiveImageSampleDistance == 0.)
+    {
+    return fullQualityImageSampleDistance;
+    }
+  return std::max(this->ProgressiveImageSampleDistance,
+                  fullQualityImageSampleDistance);
+}
+
+//---------------------------------------------------------------------------
+void vtkMRMLVolumeRenderingDisplayableManager
+::RefineProgressiveImageSampleDistance(vtkMRMLVolumeRenderingDisplayNode* vspNode)
+{
+  // The refinement stops after the frame rendered at full quality
+  this->ProgressiveImageSampleDistance /= 2.;
+  if (this->ProgressiveImageSampleDistance <=
+      this->GetFullQualityImageSampleDistance(vspNode))
+    {
+    this->ProgressiveImageSampleDistance = 0.;
+    }
+}
+
+//---------------------------------------------------------------------------
+void vtkMRMLVolumeRenderingDisplayableManager::OnRenderEnd()
+{
+  vtkMRMLCPURayCastVolumeRenderingDisplayNode* cpuNode =
+    vtkMRMLCPURayCastVolumeRenderingDisplayNode::SafeDownCast(this->DisplayedNode);
+  if (!cpuNode ||
+      !this->IsVolumeInView() ||
+      this->Volume->GetMapper() != this->MapperRaycast)
+    {
+    return;
+    }
+  cpuNode->SetLastFrameTiming(this->MapperRaycast->GetTimeToDraw(),
+                              this->MapperRaycast->GetImageSampleDistance());
+
+  if (!cpuNode->GetProgressiveRendering() ||
+      this->StyleInteraction > 0 ||
+      this->ProgressiveImageSampleDistance == 0.)
+    {
+    return;
+    }
+  // Refine the image in the next frame
+  this->RefineProgressiveImageSampleDistance(cpuNode);
+  this->MapperRaycast->SetImageSampleDistance(
+    this->GetCPURaycastImageSampleDistance(cpuNode));
+  this->RequestRender();
+}
+
 //---------------------------------------------------------------------------
 void vtkMRMLVolumeRenderingDisplayableManager
 ::UpdateGPURaycastMapper(
@@ -835,6 +879,14 @@ void vtkMRMLVolumeRenderingDisplayableManager::OnCreate()
     events->InsertNextValue(vtkMRMLViewNode::GraphicalResourcesCreatedEvent);
     vtkObserveMRMLNodeEventsMacro(viewNode, events.GetPointer());
     }
+  // Observe the end of the renders for progressive rendering
+  if (this->GetRenderer() && !vtkIsObservedMRMLNodeEventMacro(
+        this->GetRenderer(), vtkCommand::EndEvent))
+    {
+    vtkNew<vtkIntArray> events;
+    events->InsertNextValue(vtkCommand::EndEvent);
+    vtkObserveMRMLNodeEventsMacro(this->GetRenderer(), events.GetPointer());
+    }
 
   this->UpdateDisplayNodeList();
 
@@ -858,6 +910,14 @@ void vtkMRMLVolumeRenderingDisplayableManager
     {
     return;
     }
+  if (caller == this->GetRenderer())
+    {
+    if (event == vtkCommand::EndEvent)
+      {
+      this->OnRenderEnd();
+      }
+    return;
+    }
   vtkMRMLNode *node = NULL;
 
   // Observe ViewNode, Scenario Node, and Parameter node for modify events
@@ -1011,7 +1071,7 @@ void vtkMRMLVolumeRenderingDisplayableManager
 
   //this->GetInteractor()->Disable();
 
-  //this->SetupHistograms(vspNode);
+  this->SetupHistograms(vspNode);
   //if (vspNode->GetFgVolumeNode())
   //  this->SetupHistogramsFg(vspNode);
 
@@ -1043,14 +1103,29 @@ void vtkMRMLVolumeRenderingDisplayableManager
 //----------------------------------------------------------------------------
 void vtkMRMLVolumeRenderingDisplayableManager::OnInteractorStyleEvent(int eventid)
 {
+  vtkMRMLCPURayCastVolumeRenderingDisplayNode* cpuNode =
+    vtkMRMLCPURayCastVolumeRenderingDisplayNode::SafeDownCast(this->DisplayedNode);
+  const bool progressive = cpuNode && cpuNode->GetProgressiveRendering();
   // This is for the mappers that don't support SetDesiredUpdateRate
   switch(eventid)
     {
     case vtkCommand::EndInteractionEvent:
       //this->SetExpectedFPS(0.0001);
+      this->StyleInteraction = std::max(this->StyleInteraction - 1, 0);
+      if (progressive && this->StyleInteraction == 0 &&
+          this->ProgressiveImageSampleDistance > 0.)
+        {
+        // The still render following the interaction is the first
+        // refinement, the next ones are requested in OnRenderEnd()
+        this->RefineProgressiveImageSampleDistance(cpuNode);
+        }
       this->SetupMapperFromParametersNode(this->DisplayedNode);
       break;
     case vtkCommand::StartInteractionEvent:
+      ++this->StyleInteraction;
+      // Any refinement in progress is cancelled
+      this->ProgressiveImageSampleDistance = progressive ?
+        cpuNode->GetInteractiveImageSampleDistance() : 0.;
       this->SetupMapperFromParametersNode(this->DisplayedNode);
       //this->SetExpectedFPS(
       //  this->DisplayedNode ? this->DisplayedNode->GetExpectedFPS() : 15);
@@ -88,8 +88,11 @@ public:
   // Get Volume Actor
   vtkVolume* GetVolumeActor(){return this->Volume;}
 
+  /// Compute the scalar histogram of the volume. The histograms are cached by
+  /// the volume node, the logic takes the transfer function range from the
+  /// same cache (vtkSlicerVolumeRenderingLogic::UpdateTranferFunctionRangeFromImage()).
+  /// \sa vtkMRMLVolumeNode::GetHistogram()
   void SetupHistograms(vtkMRMLVolumeRenderingDisplayNode* vspNode);
-  //vtkKWHistogramSet* GetHistogramSet(){return this->Histograms;}
 
   virtual bool UpdateMapper(vtkMRMLVolumeRenderingDisplayNode* vspNode);
 
@@ -199,6 +202,12 @@ protected:
   int Interaction;
   double OriginalDesiredUpdateRate;
 
+  // When >0, the interactor style is interacting (e.g. the camera moves)
+  int StyleInteraction;
+  // Image sample distance of the CPU ray cast mapper while progressive
+  // rendering is in progress, 0 when the image is at full quality.
+  double ProgressiveImageSampleDistance;
+
 protected:
   void OnScenarioNodeModified();
   void OnVolumeRenderingDisplayNodeModified(vtkMRMLVolumeRenderingDisplayNode* dnode);
@@ -216,6 +225,16 @@ protected:
   int ValidateDisplayNode(vtkMRMLVolumeRenderingDisplayNode* vspNode);
   double GetSampleDistance(vtkMRMLVolumeRenderingDisplayNode* vspNode);
   double GetFramerate(vtkMRMLVolumeRenderingDisplayNode* vspNode);
+  double GetFullQualityImageSampleDistance(vtkMRMLVolumeRenderingDisplayNode* vspNode);
+  double GetCPURaycastImageSampleDistance(vtkMRMLCPURayCastVolumeRenderingDisplayNode* vspNode);
+
+  /// Halve the progressive image sample distance, reset it to 0 when the
+  /// full quality is reached.
+  void RefineProgressiveImageSampleDistance(vtkMRMLVolumeRenderingDisplayNode* vspNode);
+
+  /// Called after each render of the view: expose the timing of the frame
+  /// and, in progressive rendering, refine the image in the next frame.
+  void OnRenderEnd();
   virtual int GetMaxMemory(vtkVolumeMapper* mapper, vtkMRMLVolumeRenderingDisplayNode* vspNode);
 
 };
@@ -1110,6 +1110,11 @@
     mmpos[1] = pos[1] >> VTKKW_FPMM_SHIFT;                      \
     mmpos[2] = pos[2] >> VTKKW_FPMM_SHIFT;                      \
     mmvalid = mapper->CheckMinMaxVolumeFlag( mmpos, 0 );        \
+    if ( !mmvalid )                                             \
+      {                                                         \
+      k += mapper->SkipEmptySpace(                              \
+        pos, dir, static_cast<int>(numSteps-1-k) );             \
+      }                                                         \
     }                                                           \
                                                                 \
   if ( !mmvalid )                                               \
@@ -41,6 +41,8 @@ PURPOSE.  See the above copyright notice for more information.
 #include "vtkSlicerFixedPointRayCastImage.h"
 #include <vtkVersion.h>
 
+#include <vector>
+
 
 vtkStandardNewMacro(vtkSlicerFixedPointVolumeRayCastMapper);
 vtkCxxSetObjectMacro(vtkSlicerFixedPointVolumeRayCastMapper, RayCastImage, vtkSlicerFixedPointRayCastImage);
@@ -77,23 +79,34 @@ vtkCxxSetObjectMacro(vtkSlicerFixedPointVolumeRayCastMapper, RayCastImage, vtkSl
     B[2] = A[0]*M[2]  + A[1]*M[6]  + A[2]*M[10]
 
 
+// Fill in the min max elements of the slab [zStart, zEnd[. Only the slices
+// of the input contributing to these elements are read, and no element
+// outside of the slab is written so that slabs can be filled concurrently.
 template <class T>
 void vtkSlicerFixedPointVolumeRayCastMapperFillInMinMaxVolume( T *dataPtr, unsigned short *minMaxVolume,
                                                               int fullDim[3], int smallDim[4],
                                                               int independent, int components,
-                                                              float *shift, float *scale )
+                                                              float *shift, float *scale,
+                                                              int zStart, int zEnd )
 {
     int i, j, k, c;
     int sx1, sx2, sy1, sy2, sz1, sz2;
     int x, y, z;
 
-    T *dptr = dataPtr;
+    // Element z groups the samples of slices 4z to 4z+4
+    int kStart = 4*zStart;
+    int kEnd   = 4*zEnd + 1;
+    kEnd = (kEnd > fullDim[2])?(fullDim[2]):(kEnd);
+
+    T *dptr = dataPtr + static_cast<vtkIdType>(kStart)*fullDim[0]*fullDim[1]*components;
 
-    for ( k = 0; k < fullDim[2]; k++ )
+    for ( k = kStart; k < kEnd; k++ )
     {
         sz1 = (k < 1)?(0):(static_cast<int>((k-1)/4));
         sz2 =              static_cast<int>((k  )/4);
         sz2 = ( k == fullDim[2]-1 )?(sz1):(sz2);
+        sz1 = (sz1 < zStart)?(zStart):(sz1);
+        sz2 = (sz2 > zEnd-1)?(zEnd-1):(sz2);
         for ( j = 0; j < fullDim[1]; j++ )
         {
             sy1 = (j < 1)?(0):(static_cast<int>((j-1)/4));
@@ -142,6 +155,7 @@ void vtkSlicerFixedPointVolumeRayCastMapperFillInMinMaxVolume( T *dataPtr, unsig
     }
 }
 
+// Compute the gradients of the slab of slices of the thread thread_id
 template <class T>
 void vtkSlicerFixedPointVolumeRayCastMapperComputeGradients( T *dataPtr,
                                                             int dim[3],
@@ -152,7 +166,8 @@ void vtkSlicerFixedPointVolumeRayCastMapperComputeGradients( T *dataPtr,
                                                             unsigned short **gradientNormal,
                                                             unsigned char  **gradientMagnitude,
                                                             vtkDirectionEncoder *directionEncoder,
-                                                            vtkSlicerFixedPointVolumeRayCastMapper *me )
+                                                            vtkSlicerFixedPointVolumeRayCastMapper *me,
+                                                            int thread_id, int thread_count )
 {
     int                 x, y, z, c;
     int                 x_start, x_limit;
@@ -168,11 +183,6 @@ void vtkSlicerFixedPointVolumeRayCastMapperComputeGradients( T *dataPtr,
     unsigned short      *dirPtr, *cdirPtr;
     unsigned char       *magPtr, *cmagPtr;
 
-
-
-
-    me->InvokeEvent( vtkCommand::VolumeMapperComputeGradientsStartEvent, NULL );
-
     double avgSpacing = (spacing[0]+spacing[1]+spacing[2])/3.0;
 
     // adjust the aspect
@@ -211,10 +221,6 @@ void vtkSlicerFixedPointVolumeRayCastMapperComputeGradients( T *dataPtr,
         }
     }
 
-
-    int thread_id = 0;
-    int thread_count = 1;
-
     x_start = 0;
     x_limit = dim[0];
     y_start = 0;
@@ -384,17 +390,319 @@ void vtkSlicerFixedPointVolumeRayCastMapperComputeGradients( T *dataPtr,
                 magPtr  +=   increment;
             }
         }
-        if ( z%8 == 7 )
+        // Only the first thread reports the progress, from the calling thread
+        if ( thread_id == 0 && z%8 == 7 )
         {
             float args[1];
             args[0] =
-                static_cast<float>(z - z_start) /
-                static_cast<float>(z_limit - z_start - 1);
+                static_cast<float>(z - z_start + 1) /
+                static_cast<float>(z_limit - z_start);
             me->InvokeEvent( vtkCommand::VolumeMapperComputeGradientsProgressEvent, args );
         }
     }
+}
+
+// Fill in the maximum gradient magnitudes of the min max elements of the
+// slab [zStart, zEnd[, see vtkSlicerFixedPointVolumeRayCastMapperFillInMinMaxVolume
+static void vtkSlicerFixedPointVolumeRayCastMapperFillInMaxGradientMagnitudes( unsigned char **gradientMagnitude,
+                                                                              unsigned short *minMaxVolume,
+                                                                              int fullDim[3], int smallDim[4],
+                                                                              int zStart, int zEnd )
+{
+    int i, j, k, c;
+    int sx1, sx2, sy1, sy2, sz1, sz2;
+    int x, y, z;
+
+    // Forget the magnitudes of a previous fill, the flags in the lower
+    // eight bits are recomputed anyway
+    unsigned short *tmpPtr = minMaxVolume +
+        3*zStart*smallDim[0]*smallDim[1]*smallDim[3] + 2;
+    for ( i = 0; i < (zEnd-zStart)*smallDim[0]*smallDim[1]*smallDim[3]; i++ )
+    {
+        *tmpPtr = 0;
+        tmpPtr += 3;
+    }
+
+    int kStart = 4*zStart;
+    int kEnd   = 4*zEnd + 1;
+    kEnd = (kEnd > fullDim[2])?(fullDim[2]):(kEnd);
+
+    for ( k = kStart; k < kEnd; k++ )
+    {
+        sz1 = (k < 1)?(0):(static_cast<int>((k-1)/4));
+        sz2 =              static_cast<int>((k  )/4);
+        sz2 = ( k == fullDim[2]-1 )?(sz1):(sz2);
+        sz1 = (sz1 < zStart)?(zStart):(sz1);
+        sz2 = (sz2 > zEnd-1)?(zEnd-1):(sz2);
+
+        unsigned char *dptr = gradientMagnitude[k];
+
+        for ( j = 0; j < fullDim[1]; j++ )
+        {
+            sy1 = (j < 1)?(0):(static_cast<int>((j-1)/4));
+            sy2 =              static_cast<int>((j  )/4);
+            sy2 = ( j == fullDim[1]-1 )?(sy1):(sy2);
+
+            for ( i = 0; i < fullDim[0]; i++ )
+            {
+                sx1 = (i < 1)?(0):(static_cast<int>((i-1)/4));
+                sx2 =              static_cast<int>((i  )/4);
+                sx2 = ( i == fullDim[0]-1 )?(sx1):(sx2);
+
+                for ( c = 0; c < smallDim[3]; c++ )
+                {
+                    unsigned char val;
+                    val = *dptr;
+                    dptr++;
+
+                    for ( z = sz1; z <= sz2; z++ )
+                    {
+                        for ( y = sy1; y <= sy2; y++ )
+                        {
+                            for ( x = sx1; x <= sx2; x++ )
+                            {
+                                tmpPtr = minMaxVolume +
+                                    3*( z*smallDim[0]*smallDim[1]*smallDim[3] +
+                                    y*smallDim[0]*smallDim[3] +
+                                    x*smallDim[3] + c);
+
+                                // Need to keep track of max gradient magnitude in upper
+                                // eight bits. No need to preserve lower eight (the flag)
+                                // since we will be recomputing this.
+                                tmpPtr[2] = (val>(tmpPtr[2]>>8))?(val<<8):(tmpPtr[2]);
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+// Arguments of the threads filling in the min max volume. Each thread fills
+// in its own slab of min max elements.
+struct vtkSlicerFixedPointVolumeRayCastMapperMinMaxInfo
+{
+    void            *DataPtr;
+    int              ScalarType;
+    int              Independent;
+    int              Components;
+    float           *Shift;
+    float           *Scale;
+    // Fill in the gradient magnitudes instead of the scalars if not NULL
+    unsigned char  **GradientMagnitude;
+    unsigned short  *MinMaxVolume;
+    int              FullDim[3];
+    int              SmallDim[4];
+};
+
+static VTK_THREAD_RETURN_TYPE vtkSlicerFixedPointVolumeRayCastMapper_FillInMinMaxVolume( void *arg )
+{
+    int threadID    = ((vtkMultiThreader::ThreadInfo *)(arg))->ThreadID;
+    int threadCount = ((vtkMultiThreader::ThreadInfo *)(arg))->NumberOfThreads;
+
+    vtkSlicerFixedPointVolumeRayCastMapperMinMaxInfo *info =
+        (vtkSlicerFixedPointVolumeRayCastMapperMinMaxInfo *)(((vtkMultiThreader::ThreadInfo *)arg)->UserData);
+
+    int zStart = static_cast<int>(( static_cast<double>(threadID) / threadCount ) * info->SmallDim[2] );
+    int zEnd   = static_cast<int>(( static_cast<double>(threadID+1) / threadCount ) * info->SmallDim[2] );
+    if ( zStart >= zEnd )
+    {
+        return VTK_THREAD_RETURN_VALUE;
+    }
+
+    if ( info->GradientMagnitude )
+    {
+        vtkSlicerFixedPointVolumeRayCastMapperFillInMaxGradientMagnitudes(
+            info->GradientMagnitude, info->MinMaxVolume,
+            info->FullDim, info->SmallDim, zStart, zEnd );
+        return VTK_THREAD_RETURN_VALUE;
+    }
+
+    switch ( info->ScalarType )
+    {
+        vtkTemplateMacro(
+            vtkSlicerFixedPointVolumeRayCastMapperFillInMinMaxVolume(
+            (VTK_TT *)(info->DataPtr), info->MinMaxVolume, info->FullDim, info->SmallDim,
+            info->Independent, info->Components, info->Shift, info->Scale,
+            zStart, zEnd ) );
+    }
+
+    return VTK_THREAD_RETURN_VALUE;
+}
+
+// Arguments of the threads computing the gradients. Each thread computes
+// its own slab of slices.
+struct vtkSlicerFixedPointVolumeRayCastMapperGradientsInfo
+{
+    vtkSlicerFixedPointVolumeRayCastMapper *Mapper;
+    void                *DataPtr;
+    int                  ScalarType;
+    int                  Dim[3];
+    double               Spacing[3];
+    int                  Components;
+    int                  Independent;
+    double               ScalarRange[4][2];
+    unsigned short     **GradientNormal;
+    unsigned char      **GradientMagnitude;
+    vtkDirectionEncoder *DirectionEncoder;
+};
+
+static VTK_THREAD_RETURN_TYPE vtkSlicerFixedPointVolumeRayCastMapper_ComputeGradients( void *arg )
+{
+    int threadID    = ((vtkMultiThreader::ThreadInfo *)(arg))->ThreadID;
+    int threadCount = ((vtkMultiThreader::ThreadInfo *)(arg))->NumberOfThreads;
+
+    vtkSlicerFixedPointVolumeRayCastMapperGradientsInfo *info =
+        (vtkSlicerFixedPointVolumeRayCastMapperGradientsInfo *)(((vtkMultiThreader::ThreadInfo *)arg)->UserData);
+
+    switch ( info->ScalarType )
+    {
+        vtkTemplateMacro(
+            vtkSlicerFixedPointVolumeRayCastMapperComputeGradients(
+            (VTK_TT *)(info->DataPtr), info->Dim, info->Spacing, info->Components,
+            info->Independent, info->ScalarRange,
+            info->GradientNormal,
+            info->GradientMagnitude,
+            info->DirectionEncoder,
+            info->Mapper,
+            threadID, threadCount ) );
+    }
+
+    return VTK_THREAD_RETURN_VALUE;
+}
+
+// Encoded gradient normals and magnitudes computed for an input, with one
+// entry per voxel (and per component if independent) stored slice after
+// slice. They are shared by the mappers rendering the same unmodified input,
+// e.g. when the display node of a volume is switched, and kept for a while
+// after the last mapper released them in case the input is rendered again.
+class vtkSlicerFixedPointVolumeRayCastMapperGradients
+{
+public:
+    vtkImageData   *Input;
+    unsigned long   InputMTime;
+    int             Independent;
+    int             Dim[3];
+    unsigned short *Normal;
+    unsigned char  *Magnitude;
+    int             ReferenceCount;
+};
+
+namespace
+{
+
+// Number of gradients no mapper uses anymore that are kept in the cache
+const int MaximumNumberOfUnusedGradients = 2;
+
+// Gradients of the cache, the most recently used last
+class vtkSlicerFixedPointVolumeRayCastMapperGradientsCache
+{
+public:
+    ~vtkSlicerFixedPointVolumeRayCastMapperGradientsCache()
+    {
+        for ( size_t i = 0; i < this->Gradients.size(); i++ )
+        {
+            Delete( this->Gradients[i] );
+        }
+    }
+
+    // Return the gradients computed for the input in its current state, with
+    // a reference added, or NULL if they are not cached
+    vtkSlicerFixedPointVolumeRayCastMapperGradients *Acquire( vtkImageData *input, int independent )
+    {
+        int dim[3];
+        input->GetDimensions( dim );
+        std::vector<vtkSlicerFixedPointVolumeRayCastMapperGradients *>::iterator it;
+        for ( it = this->Gradients.begin(); it != this->Gradients.end(); ++it )
+        {
+            vtkSlicerFixedPointVolumeRayCastMapperGradients *gradients = *it;
+            if ( gradients->Input == input &&
+                gradients->InputMTime == input->GetMTime() &&
+                gradients->Independent == independent &&
+                gradients->Dim[0] == dim[0] &&
+                gradients->Dim[1] == dim[1] &&
+                gradients->Dim[2] == dim[2] )
+            {
+                this->Gradients.erase( it );
+                this->Gradients.push_back( gradients );
+                gradients->ReferenceCount++;
+                return gradients;
+            }
+        }
+        return NULL;
+    }
+
+    // Allocate gradients for the input in its current state, with a
+    // reference added
+    vtkSlicerFixedPointVolumeRayCastMapperGradients *New( vtkImageData *input, int independent,
+                                                          int sliceSize )
+    {
+        vtkSlicerFixedPointVolumeRayCastMapperGradients *gradients =
+            new vtkSlicerFixedPointVolumeRayCastMapperGradients;
+        gradients->Input          = input;
+        gradients->InputMTime     = input->GetMTime();
+        gradients->Independent    = independent;
+        input->GetDimensions( gradients->Dim );
+        gradients->Normal         = new unsigned short [gradients->Dim[2] * sliceSize];
+        gradients->Magnitude      = new unsigned char [gradients->Dim[2] * sliceSize];
+        gradients->ReferenceCount = 1;
+        this->Gradients.push_back( gradients );
+        return gradients;
+    }
+
+    // Remove a reference and delete the least recently used gradients
+    // if too many are unused
+    void Release( vtkSlicerFixedPointVolumeRayCastMapperGradients *gradients )
+    {
+        gradients->ReferenceCount--;
+
+        int unused = 0;
+        for ( int i = static_cast<int>(this->Gradients.size()) - 1; i >= 0; i-- )
+        {
+            vtkSlicerFixedPointVolumeRayCastMapperGradients *cached = this->Gradients[i];
+            if ( cached->ReferenceCount > 0 || ++unused <= MaximumNumberOfUnusedGradients )
+            {
+                continue;
+            }
+            Delete( cached );
+            this->Gradients.erase( this->Gradients.begin() + i );
+        }
+    }
+
+    static void Delete( vtkSlicerFixedPointVolumeRayCastMapperGradients *gradients )
+    {
+        delete [] gradients->Normal;
+        delete [] gradients->Magnitude;
+        delete gradients;
+    }
+
+    std::vector<vtkSlicerFixedPointVolumeRayCastMapperGradients *> Gradients;
+};
+
+// The cache is created on demand and deleted with the unused gradients it
+// keeps when the last mapper is destroyed
+int NumberOfMappers = 0;
+vtkSlicerFixedPointVolumeRayCastMapperGradientsCache *GradientsCache = NULL;
+
+vtkSlicerFixedPointVolumeRayCastMapperGradientsCache *GetGradientsCache()
+{
+    if ( !GradientsCache )
+    {
+        GradientsCache = new vtkSlicerFixedPointVolumeRayCastMapperGradientsCache;
+    }
+    return GradientsCache;
+}
+
+void ReleaseGradientsCache()
+{
+    if ( --NumberOfMappers == 0 )
+    {
+        delete GradientsCache;
+        GradientsCache = NULL;
+    }
+}
 
-    me->InvokeEvent( vtkCommand::VolumeMapperComputeGradientsEndEvent, NULL );
 }
 
 // Construct a new vtkSlicerFixedPointVolumeRayCastMapper with default values
@@ -468,8 +776,7 @@ vtkSlicerFixedPointVolumeRayCastMapper::vtkSlicerFixedPointVolumeRayCastMapper()
     this->NumberOfGradientSlices       = 0;
     this->GradientNormal               = NULL;
     this->GradientMagnitude            = NULL;
-    this->ContiguousGradientNormal     = NULL;
-    this->ContiguousGradientMagnitude  = NULL;
+    this->Gradients                    = NULL;
 
     this->DirectionEncoder             = vtkSphericalDirectionEncoder::New();
     this->GradientShader               = vtkEncodedGradientShader::New();
@@ -506,12 +813,18 @@ vtkSlicerFixedPointVolumeRayCastMapper::vtkSlicerFixedPointVolumeRayCastMapper()
     this->MinMaxVolumeSize[3] = 0;
     this->SavedMinMaxInput = NULL;
 
+    // Coarser level of the min max volume, used to skip large empty regions
+    this->EmptySpaceVolume = NULL;
+    this->EmptySpaceVolumeSize[0] = 0;
+    this->EmptySpaceVolumeSize[1] = 0;
+    this->EmptySpaceVolumeSize[2] = 0;
+
     this->Volume = NULL;
     //SLICERADD
     this->ManualInteractive=0;
     //ENDSLICERADD
 
-
+    NumberOfMappers++;
 }
 
 // Destruct a vtkSlicerFixedPointVolumeRayCastMapper - clean up any memory used
@@ -571,44 +884,8 @@ vtkSlicerFixedPointVolumeRayCastMapper::~vtkSlicerFixedPointVolumeRayCastMapper(
     delete [] this->RowBounds;
     delete [] this->OldRowBounds;
 
-    int i;
-    if ( this->GradientNormal )
-    {
-        // Contiguous? Delete in one chunk otherwise delete slice by slice
-        if ( this->ContiguousGradientNormal )
-        {
-            delete [] this->ContiguousGradientNormal;
-            this->ContiguousGradientNormal = NULL;
-        }
-        else
-        {
-            for ( i = 0; i < this->NumberOfGradientSlices; i++ )
-            {
-                delete [] this->GradientNormal[i];
-            }
-        }
-        delete [] this->GradientNormal;
-        this->GradientNormal = NULL;
-    }
-
-    if ( this->GradientMagnitude )
-    {
-        // Contiguous? Delete in one chunk otherwise delete slice by slice
-        if ( this->ContiguousGradientMagnitude )
-        {
-            delete [] this->ContiguousGradientMagnitude;
-            this->ContiguousGradientMagnitude = NULL;
-        }
-        else
-        {
-            for ( i = 0; i < this->NumberOfGradientSlices; i++ )
-            {
-                delete [] this->GradientMagnitude[i];
-            }
-        }
-        delete [] this->GradientMagnitude;
-        this->GradientMagnitude = NULL;
-    }
+    this->ReleaseGradients();
+    ReleaseGradientsCache();
 
     this->DirectionEncoder->Delete();
     this->GradientShader->Delete();
@@ -620,6 +897,7 @@ vtkSlicerFixedPointVolumeRayCastMapper::~vtkSlicerFixedPointVolumeRayCastMapper(
 
     // Delete storage used by min/max volume
     delete [] this->MinMaxVolume;
+    delete [] this->EmptySpaceVolume;
 }
 
 float vtkSlicerFixedPointVolumeRayCastMapper::ComputeRequiredImageSampleDistance( float desiredTime,
@@ -776,59 +1054,28 @@ int vtkSlicerFixedPointVolumeRayCastMapper::GetNumberOfThreads()
 void vtkSlicerFixedPointVolumeRayCastMapper::FillInMaxGradientMagnitudes( int fullDim[3],
                                                                          int smallDim[4] )
 {
-    int i, j, k, c;
-    int sx1, sx2, sy1, sy2, sz1, sz2;
-    int x, y, z;
-
-
-    for ( k = 0; k < fullDim[2]; k++ )
+    vtkSlicerFixedPointVolumeRayCastMapperMinMaxInfo info;
+    info.DataPtr           = NULL;
+    info.ScalarType        = VTK_VOID;
+    info.Independent       = 0;
+    info.Components        = smallDim[3];
+    info.Shift             = NULL;
+    info.Scale             = NULL;
+    info.GradientMagnitude = this->GradientMagnitude;
+    info.MinMaxVolume      = this->MinMaxVolume;
+    for ( int i = 0; i < 3; i++ )
     {
-        sz1 = (k < 1)?(0):(static_cast<int>((k-1)/4));
-        sz2 =              static_cast<int>((k  )/4);
-        sz2 = ( k == fullDim[2]-1 )?(sz1):(sz2);
-
-        unsigned char *dptr = this->GradientMagnitude[k];
-
-        for ( j = 0; j < fullDim[1]; j++ )
-        {
-            sy1 = (j < 1)?(0):(static_cast<int>((j-1)/4));
-            sy2 =              static_cast<int>((j  )/4);
-            sy2 = ( j == fullDim[1]-1 )?(sy1):(sy2);
-
-            for ( i = 0; i < fullDim[0]; i++ )
-            {
-                sx1 = (i < 1)?(0):(static_cast<int>((i-1)/4));
-                sx2 =              static_cast<int>((i  )/4);
-                sx2 = ( i == fullDim[0]-1 )?(sx1):(sx2);
-
-                for ( c = 0; c < smallDim[3]; c++ )
-                {
-                    unsigned char val;
-                    val = *dptr;
-                    dptr++;
-
-                    for ( z = sz1; z <= sz2; z++ )
-                    {
-                        for ( y = sy1; y <= sy2; y++ )
-                        {
-                            for ( x = sx1; x <= sx2; x++ )
-                            {
-                                unsigned short *tmpPtr = this->MinMaxVolume +
-                                    3*( z*smallDim[0]*smallDim[1]*smallDim[3] +
-                                    y*smallDim[0]*smallDim[3] +
-                                    x*smallDim[3] + c);
-
-                                // Need to keep track of max gradient magnitude in upper
-                                // eight bits. No need to preserve lower eight (the flag)
-                                // since we will be recomputing this.
-                                tmpPtr[2] = (val>(tmpPtr[2]>>8))?(val<<8):(tmpPtr[2]);
-                            }
-                        }
-                    }
-                }
-            }
-        }
+        info.FullDim[i] = fullDim[i];
+    }
+    for ( int i = 0; i < 4; i++ )
+    {
+        info.SmallDim[i] = smallDim[i];
     }
+
+    // Fill in slabs of min max elements in parallel
+    this->Threader->SetSingleMethod( vtkSlicerFixedPointVolumeRayCastMapper_FillInMinMaxVolume,
+        (void *)&info );
+    this->Threader->SingleMethodExecute();
 }
 
 // This method should be called after UpdateColorTables since it
@@ -935,32 +1182,45 @@ void vtkSlicerFixedPointVolumeRayCastMapper::UpdateMinMaxVolume( vtkVolume *vol
             this->MinMaxVolumeSize[1] = targetSize[1];
             this->MinMaxVolumeSize[2] = targetSize[2];
             this->MinMaxVolumeSize[3] = targetSize[3];
+        }
 
-            // Initialize the structure
-            unsigned short *tmpPtr = this->MinMaxVolume;
-            for ( i = 0; i < targetSize[0] * targetSize[1] * targetSize[2]; i++ )
-            {
-                for ( j = 0; j < targetSize[3]; j++ )
-                {
-                    *(tmpPtr++) = 0xffff;  // Min Scalar
-                    *(tmpPtr++) = 0;       // Max Scalar
-                    *(tmpPtr++) = 0;       // Max Gradient Magnitude and
-                }                      // Flag computed from transfer functions
-            }
-
-            // Now put the scalar data values into the structure
-            int scalarType   = input->GetScalarType();
-            void *dataPtr = input->GetScalarPointer();
-
-            switch ( scalarType )
+        // Initialize the structure. This must be done whenever the scalars
+        // changed, not only when the size of the structure changed.
+        unsigned short *tmpPtr = this->MinMaxVolume;
+        for ( i = 0; i < targetSize[0] * targetSize[1] * targetSize[2]; i++ )
+        {
+            for ( j = 0; j < targetSize[3]; j++ )
             {
-                vtkTemplateMacro(
-                    vtkSlicerFixedPointVolumeRayCastMapperFillInMinMaxVolume(
-                    (VTK_TT *)(dataPtr), this->MinMaxVolume, dim, targetSize,
-                    independent, components, this->TableShift, this->TableScale) );
-            }
+                *(tmpPtr++) = 0xffff;  // Min Scalar
+                *(tmpPtr++) = 0;       // Max Scalar
+                *(tmpPtr++) = 0;       // Max Gradient Magnitude and
+            }                      // Flag computed from transfer functions
+        }
+
+        // Now put the scalar data values into the structure, each thread
+        // fills in its own slab of min max elements
+        vtkSlicerFixedPointVolumeRayCastMapperMinMaxInfo info;
+        info.DataPtr           = input->GetScalarPointer();
+        info.ScalarType        = input->GetScalarType();
+        info.Independent       = independent;
+        info.Components        = components;
+        info.Shift             = this->TableShift;
+        info.Scale             = this->TableScale;
+        info.GradientMagnitude = NULL;
+        info.MinMaxVolume      = this->MinMaxVolume;
+        for ( i = 0; i < 3; i++ )
+        {
+            info.FullDim[i] = dim[i];
+        }
+        for ( i = 0; i < 4; i++ )
+        {
+            info.SmallDim[i] = targetSize[i];
         }
 
+        this->Threader->SetSingleMethod( vtkSlicerFixedPointVolumeRayCastMapper_FillInMinMaxVolume,
+            (void *)&info );
+        this->Threader->SingleMethodExecute();
+
         this->SavedMinMaxInput = input;
         this->SavedMinMaxBuildTime.Modified();
     }
@@ -1075,8 +1335,63 @@ void vtkSlicerFixedPointVolumeRayCastMapper::UpdateMinMaxVolume( vtkVolume *vol
         }
     }
 
+    delete [] minNonZeroScalarIndex;
+    delete [] minNonZeroGradientMagnitudeIndex;
+
+    this->UpdateEmptySpaceVolume();
+
     this->SavedMinMaxFlagTime.Modified();
+}
 
+void vtkSlicerFixedPointVolumeRayCastMapper::UpdateEmptySpaceVolume()
+{
+    int i, j, k, c;
+
+    // Group 4x4x4 elements of the min max volume
+    int targetSize[3];
+    for ( i = 0; i < 3; i++ )
+    {
+        targetSize[i] = (this->MinMaxVolumeSize[i] + 3) / 4;
+    }
+
+    if ( this->EmptySpaceVolumeSize[0] != targetSize[0] ||
+        this->EmptySpaceVolumeSize[1] != targetSize[1] ||
+        this->EmptySpaceVolumeSize[2] != targetSize[2] )
+    {
+        delete [] this->EmptySpaceVolume;
+        this->EmptySpaceVolume = new unsigned char [targetSize[0] *
+            targetSize[1] *
+            targetSize[2] ];
+        this->EmptySpaceVolumeSize[0] = targetSize[0];
+        this->EmptySpaceVolumeSize[1] = targetSize[1];
+        this->EmptySpaceVolumeSize[2] = targetSize[2];
+    }
+
+    memset( this->EmptySpaceVolume, 0, targetSize[0] * targetSize[1] * targetSize[2] );
+
+    // A group is skipped only if all its elements are empty. Only the flag of
+    // the first component is checked when rendering but the flags of all the
+    // components are merged to stay conservative.
+    unsigned short *tmpPtr = this->MinMaxVolume;
+    for ( k = 0; k < this->MinMaxVolumeSize[2]; k++ )
+    {
+        for ( j = 0; j < this->MinMaxVolumeSize[1]; j++ )
+        {
+            unsigned char *groupPtr = this->EmptySpaceVolume +
+                (k/4)*targetSize[0]*targetSize[1] + (j/4)*targetSize[0];
+            for ( i = 0; i < this->MinMaxVolumeSize[0]; i++ )
+            {
+                for ( c = 0; c < this->MinMaxVolumeSize[3]; c++ )
+                {
+                    if ( tmpPtr[2]&0x00ff )
+                    {
+                        groupPtr[i/4] = 1;
+                    }
+                    tmpPtr += 3;
+                }
+            }
+        }
+    }
 }
 
 void vtkSlicerFixedPointVolumeRayCastMapper::UpdateCroppingRegions()
@@ -2510,127 +2825,85 @@ void vtkSlicerFixedPointVolumeRayCastMapper::ComputeGradients( vtkVolume *vol )
 {
     vtkImageData *input = this->GetInput();
 
-    void *dataPtr = input->GetScalarPointer();
-
-    int scalarType   = input->GetScalarType();
     int components   = input->GetPointData()->GetScalars()->GetNumberOfComponents();
     int independent  = vol->GetProperty()->GetIndependentComponents();
 
     int dim[3];
-    double spacing[3];
     input->GetDimensions(dim);
-    input->GetSpacing(spacing);
-
-    // Find the scalar range
-    double scalarRange[4][2];
-    int c;
-    for ( c = 0; c < components; c++ )
-    {
-        input->GetPointData()->GetScalars()->GetRange(scalarRange[c], c);
-    }
 
     int sliceSize = dim[0]*dim[1]*((independent)?(components):(1));
     int numSlices = dim[2];
 
     int i;
 
-    // Delete the prior gradient normal information
-    if ( this->GradientNormal )
-    {
-        // Contiguous? Delete in one chunk otherwise delete slice by slice
-        if ( this->ContiguousGradientNormal )
-        {
-            delete [] this->ContiguousGradientNormal;
-            this->ContiguousGradientNormal = NULL;
-        }
-        else
-        {
-            for ( i = 0; i < this->NumberOfGradientSlices; i++ )
-            {
-                delete [] this->GradientNormal[i];
-            }
-        }
-        delete [] this->GradientNormal;
-        this->GradientNormal = NULL;
-    }
+    // Release the prior gradient information
+    this->ReleaseGradients();
 
-    // Delete the prior gradient magnitude information
-    if ( this->GradientMagnitude )
+    // Reuse the gradients of another mapper, or of a previous rendering,
+    // if the input did not change since they have been computed
+    int computeGradients = 0;
+    this->Gradients = GetGradientsCache()->Acquire( input, independent );
+    if ( !this->Gradients )
     {
-        // Contiguous? Delete in one chunk otherwise delete slice by slice
-        if ( this->ContiguousGradientMagnitude )
-        {
-            delete [] this->ContiguousGradientMagnitude;
-            this->ContiguousGradientMagnitude = NULL;
-        }
-        else
-        {
-            for ( i = 0; i < this->NumberOfGradientSlices; i++ )
-            {
-                delete [] this->GradientMagnitude[i];
-            }
-        }
-        delete [] this->GradientMagnitude;
-        this->GradientMagnitude = NULL;
+        this->Gradients = GetGradientsCache()->New( input, independent, sliceSize );
+        computeGradients = 1;
     }
 
     this->NumberOfGradientSlices = numSlices;
     this->GradientNormal  = new unsigned short *[numSlices];
     this->GradientMagnitude = new unsigned char *[numSlices];
-
-    // first, attempt contiguous memory. If this fails, then go
-    // for non-contiguous
-    this->ContiguousGradientNormal = new unsigned short [numSlices * sliceSize];
-    this->ContiguousGradientMagnitude = new unsigned char [numSlices * sliceSize];
-
-    if ( this->ContiguousGradientNormal )
+    for ( i = 0; i < numSlices; i++ )
     {
-        // We were able to allocate contiguous space - we just need to set the
-        // slice pointers here
-        for ( i = 0; i < numSlices; i++ )
-        {
-            this->GradientNormal[i]  = this->ContiguousGradientNormal + i*sliceSize;
-        }
-    }
-    else
-    {
-        // We were not able to allocate contigous space - allocate it slice by slice
-        for ( i = 0; i < numSlices; i++ )
-        {
-            this->GradientNormal[i]  = new unsigned short [sliceSize];
-        }
+        this->GradientNormal[i]    = this->Gradients->Normal + i*sliceSize;
+        this->GradientMagnitude[i] = this->Gradients->Magnitude + i*sliceSize;
     }
 
-    if ( this->ContiguousGradientMagnitude )
+    if ( !computeGradients )
     {
-        // We were able to allocate contiguous space - we just need to set the
-        // slice pointers here
-        for ( i = 0; i < numSlices; i++ )
-        {
-            this->GradientMagnitude[i]  = this->ContiguousGradientMagnitude + i*sliceSize;
-        }
+        return;
     }
-    else
+
+    vtkSlicerFixedPointVolumeRayCastMapperGradientsInfo info;
+    info.Mapper            = this;
+    info.DataPtr           = input->GetScalarPointer();
+    info.ScalarType        = input->GetScalarType();
+    info.Components        = components;
+    info.Independent       = independent;
+    info.GradientNormal    = this->GradientNormal;
+    info.GradientMagnitude = this->GradientMagnitude;
+    info.DirectionEncoder  = this->DirectionEncoder;
+    input->GetDimensions( info.Dim );
+    input->GetSpacing( info.Spacing );
+
+    // Find the scalar range
+    int c;
+    for ( c = 0; c < components; c++ )
     {
-        // We were not able to allocate contigous space - allocate it slice by slice
-        for ( i = 0; i < numSlices; i++ )
-        {
-            this->GradientMagnitude[i] = new unsigned char [sliceSize];
-        }
+        input->GetPointData()->GetScalars()->GetRange(info.ScalarRange[c], c);
     }
 
+    this->InvokeEvent( vtkCommand::VolumeMapperComputeGradientsStartEvent, NULL );
 
+    // Each thread computes the gradients of its own slab of slices
+    this->Threader->SetSingleMethod( vtkSlicerFixedPointVolumeRayCastMapper_ComputeGradients,
+        (void *)&info );
+    this->Threader->SingleMethodExecute();
+
+    this->InvokeEvent( vtkCommand::VolumeMapperComputeGradientsEndEvent, NULL );
+}
 
-    switch ( scalarType )
+void vtkSlicerFixedPointVolumeRayCastMapper::ReleaseGradients()
+{
+    delete [] this->GradientNormal;
+    this->GradientNormal = NULL;
+    delete [] this->GradientMagnitude;
+    this->GradientMagnitude = NULL;
+    this->NumberOfGradientSlices = 0;
+
+    if ( this->Gradients )
     {
-        vtkTemplateMacro(
-            vtkSlicerFixedPointVolumeRayCastMapperComputeGradients(
-            (VTK_TT *)(dataPtr), dim, spacing, components,
-            independent, scalarRange,
-            this->GradientNormal,
-            this->GradientMagnitude,
-            this->DirectionEncoder,
-            this) );
+        GetGradientsCache()->Release( this->Gradients );
+        this->Gradients = NULL;
     }
 }
 
@@ -46,6 +46,17 @@
 // the neighborhood (an unsigned char) and the flag that is filled
 // in for the current lookup tables to indicate whether this region
 // can be skipped.
+//
+// On top of the min max volume, a coarser volume with one flag per
+// 4x4x4 group of min max elements (16x16x16 cells of the original volume)
+// indicates whether any of these elements may have non-zero opacity. Rays
+// crossing an empty group of elements jump directly to the last sample
+// inside of it instead of testing each sample.
+//
+// The gradients and the min max volume are computed by slabs of slices in
+// multiple threads. The encoded gradients are shared by all the mappers
+// rendering the same, unmodified input, so that switching between renderings
+// of the same volume does not recompute them.
 
 // .SECTION see also
 // vtkVolumeMapper
@@ -59,6 +70,7 @@
 
 #define VTKKW_FP_SHIFT       15
 #define VTKKW_FPMM_SHIFT     17
+#define VTKKW_FPES_SHIFT     19
 #define VTKKW_FP_MASK        0x7fff
 #define VTKKW_FP_SCALE       32767.0
 
@@ -82,6 +94,7 @@ class vtkEncodedGradientShader;
 class vtkFiniteDifferenceGradientEstimator;
 #include "vtkSlicerRayCastImageDisplayHelper.h"
 class vtkSlicerFixedPointRayCastImage;
+class vtkSlicerFixedPointVolumeRayCastMapperGradients;
 
 // Forward declaration needed for use by friend declaration below.
 VTK_THREAD_RETURN_TYPE SlicerFixedPointVolumeRayCastMapper_CastRays( void *arg );
@@ -192,6 +205,7 @@ public:
   void ShiftVectorDown( unsigned int in[3], unsigned int out[3] );
   int CheckMinMaxVolumeFlag( unsigned int pos[3], int c );
   int CheckMIPMinMaxVolumeFlag( unsigned int pos[3], int c, unsigned short maxIdx );
+  int SkipEmptySpace( unsigned int pos[3], unsigned int dir[3], int maxSteps );
 
   void LookupColorUC( unsigned short *colorTable,
                       unsigned short *scalarOpacityTable,
@@ -365,11 +379,13 @@ protected:
 
   unsigned short           **GradientNormal;
   unsigned char            **GradientMagnitude;
-  unsigned short            *ContiguousGradientNormal;
-  unsigned char             *ContiguousGradientMagnitude;
 
   int                        NumberOfGradientSlices;
 
+  // Encoded gradients GradientNormal and GradientMagnitude point into,
+  // possibly shared with other mappers rendering the same input
+  vtkSlicerFixedPointVolumeRayCastMapperGradients *Gradients;
+
   vtkDirectionEncoder       *DirectionEncoder;
 
   vtkEncodedGradientShader  *GradientShader;
@@ -397,6 +413,7 @@ protected:
   void          UpdateCroppingRegions();
 
   void          ComputeGradients( vtkVolume *vol );
+  void          ReleaseGradients();
 
   int           ClipRayAgainstClippingPlanes( float  rayStart[3],
                                               float  rayEnd[3],
@@ -440,7 +457,14 @@ protected:
 
   void            UpdateMinMaxVolume( vtkVolume *vol );
   void            FillInMaxGradientMagnitudes( int fullDim[3],
-                                               int smallDim[3] );
+                                               int smallDim[4] );
+
+  // One flag per 4x4x4 elements of the min max volume, non-zero if any of
+  // these elements has its flag set for the first component
+  unsigned char  *EmptySpaceVolume;
+  int             EmptySpaceVolumeSize[3];
+
+  void            UpdateEmptySpaceVolume();
 
 private:
   vtkSlicerFixedPointVolumeRayCastMapper(const vtkSlicerFixedPointVolumeRayCastMapper&);  // Not implemented.
@@ -564,6 +588,72 @@ inline int vtkSlicerFixedPointVolumeRayCastMapper::CheckMIPMinMaxVolumeFlag( uns
     }
 }
 
+// Called for a sample in an empty element of the min max volume. If the
+// whole group of elements containing the sample is empty, move pos along
+// dir to the last sample inside of the group, without taking more than
+// maxSteps steps. Return the number of steps taken.
+inline int vtkSlicerFixedPointVolumeRayCastMapper::SkipEmptySpace( unsigned int pos[3],
+                                                                   unsigned int dir[3],
+                                                                   int maxSteps )
+{
+  unsigned int espos[3];
+  espos[0] = pos[0] >> VTKKW_FPES_SHIFT;
+  espos[1] = pos[1] >> VTKKW_FPES_SHIFT;
+  espos[2] = pos[2] >> VTKKW_FPES_SHIFT;
+
+  if ( maxSteps <= 0 ||
+       this->EmptySpaceVolume[ espos[2]*this->EmptySpaceVolumeSize[0]*this->EmptySpaceVolumeSize[1] +
+                               espos[1]*this->EmptySpaceVolumeSize[0] +
+                               espos[0] ] )
+    {
+    return 0;
+    }
+
+  // Number of steps needed to leave the group, the smallest over the axes
+  unsigned int steps = static_cast<unsigned int>(maxSteps) + 1;
+  unsigned int increment[3];
+  int i;
+  for ( i = 0; i < 3; i++ )
+    {
+    unsigned int axisSteps;
+    if ( dir[i]&0x80000000 )
+      {
+      increment[i] = dir[i]&0x7fffffff;
+      if ( !increment[i] )
+        {
+        continue;
+        }
+      axisSteps = ( ((espos[i]+1) << VTKKW_FPES_SHIFT) - pos[i] + increment[i] - 1 ) / increment[i];
+      }
+    else
+      {
+      increment[i] = dir[i];
+      if ( !increment[i] )
+        {
+        continue;
+        }
+      axisSteps = ( pos[i] - (espos[i] << VTKKW_FPES_SHIFT) ) / increment[i] + 1;
+      }
+    steps = (axisSteps < steps)?(axisSteps):(steps);
+    }
+
+  // Stop on the last sample inside of the group, the next regular step
+  // leaves it
+  steps -= 1;
+  for ( i = 0; i < 3; i++ )
+    {
+    if ( dir[i]&0x80000000 )
+      {
+      pos[i] += steps*increment[i];
+      }
+    else
+      {
+      pos[i] -= steps*increment[i];
+      }
+    }
+  return static_cast<int>(steps);
+}
+
 inline void vtkSlicerFixedPointVolumeRayCastMapper::LookupColorUC( unsigned short *colorTable,
                                                      unsigned short *scalarOpacityTable,
                                                      unsigned short index,
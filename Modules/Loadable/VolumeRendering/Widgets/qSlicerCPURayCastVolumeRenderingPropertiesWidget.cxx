@@ -63,6 +63,8 @@ void qSlicerCPURayCastVolumeRenderingPropertiesWidgetPrivate
   this->populateRenderingTechniqueComboBox();
   QObject::connect(this->RenderingTechniqueComboBox, SIGNAL(currentIndexChanged(int)),
                    widget, SLOT(setRenderingTechnique(int)));
+  QObject::connect(this->ProgressiveRenderingCheckBox, SIGNAL(toggled(bool)),
+                   widget, SLOT(setProgressiveRendering(bool)));
 }
 
 // --------------------------------------------------------------------------
@@ -123,6 +125,8 @@ void qSlicerCPURayCastVolumeRenderingPropertiesWidget
     index = 0;
     }
   d->RenderingTechniqueComboBox->setCurrentIndex(index);
+  d->ProgressiveRenderingCheckBox->setChecked(
+    this->mrmlCPURayCastDisplayNode()->GetProgressiveRendering() != 0);
 }
 
 //-----------------------------------------------------------------------------
@@ -137,3 +141,14 @@ void qSlicerCPURayCastVolumeRenderingPropertiesWidget
   int technique = d->RenderingTechniqueComboBox->itemData(index).toInt();
   this->mrmlCPURayCastDisplayNode()->SetRaycastTechnique(technique);
 }
+
+//-----------------------------------------------------------------------------
+void qSlicerCPURayCastVolumeRenderingPropertiesWidget
+::setProgressiveRendering(bool enable)
+{
+  if (!this->mrmlCPURayCastDisplayNode())
+    {
+    return;
+    }
+  this->mrmlCPURayCastDisplayNode()->SetProgressiveRendering(enable ? 1 : 0);
+}
@@ -40,6 +40,7 @@ public:
 
 public slots:
   void setRenderingTechnique(int index);
+  void setProgressiveRendering(bool enable);
 
 protected slots:
   virtual void updateWidgetFromMRML();
@@ -508,44 +508,41 @@ class EditUtil(object):
 
 class UndoRedo(object):
   """ Code to manage a list of undo/redo volumes
-  stored in a compressed format using the vtkImageStash
-  class to compress label maps in a thread
+  stored in a compressed format using the vtkImageBrickStash
+  class. The label maps are split into bricks that are compressed
+  in parallel and shared between the check points, so a check point
+  only stores the bricks modified since the previous ones.
   """
 
   class checkPoint(object):
     """Internal class to store one checkpoint
-    step consisting of the stashed data
+    step consisting of the stashed snapshot
     and the volumeNode it corresponds to
     """
-    def __init__(self,volumeNode):
+    def __init__(self,volumeNode,stash):
       self.volumeNode = volumeNode
-      self.stashImage = vtk.vtkImageData()
-      self.stash = slicer.vtkImageStash()
-      self.stashImage.DeepCopy( volumeNode.GetImageData() )
-      self.stash.SetStashImage( self.stashImage )
-      self.stash.ThreadedStash()
+      self.stash = stash
+      self.snapshot = stash.Stash( volumeNode.GetImageData() )
 
     def restore(self):
-      """Unstash the volume but first check that the
-      stash operation is not still ongoing in the other thread.
-      TODO: the stash operation is determinisitic, so there's
-      no chance of a deadlock here, but it would still be better
-      to integrate the wait into the event queue to avoid locking
-      the interface.  In practice this would only happen if the user
-      clicks Undo while the thread is still executing, which is
-      unlikely.  And at worst this busy loop will consume two threads
-      (this one and the stashing one) for the time the stash takes to complete.
+      """Restore the bricks of the volume that differ from the snapshot
       """
-      while self.stash.GetStashing():
-        pass
-      self.stash.Unstash()
-      self.volumeNode.GetImageData().DeepCopy( self.stashImage )
+      self.stash.Unstash( self.snapshot, self.volumeNode.GetImageData() )
       EditUtil().markVolumeNodeAsModified(self.volumeNode)
 
+    def release(self):
+      """Release the bricks only used by this checkpoint
+      """
+      self.stash.RemoveSnapshot( self.snapshot )
+
 
-  def __init__(self,undoSize=100):
+  def __init__(self,undoSize=100,memoryBudget=512*1024*1024):
     self.enabled = True
     self.undoSize = undoSize
+    # maximum size in bytes of the compressed bricks of all the checkpoints,
+    # the oldest undo checkpoints are discarded when it is exceeded
+    self.memoryBudget = memoryBudget
+    self.stash = slicer.vtkImageBrickStash()
     self.undoList = []
     self.redoList = []
     self.stateChangedCallback = self.defaultStateChangedCallback
@@ -564,26 +561,48 @@ class UndoRedo(object):
     """for managing undo/redo button state"""
     return self.enabled and self.redoList != []
 
+  def releaseCheckPoints(self,checkPointList):
+    """ Internal helper function
+    Release the checkpoints of the list
+    """
+    for checkPoint in checkPointList:
+      checkPoint.release()
+
   def storeVolume(self,checkPointList,volumeNode):
     """ Internal helper function
     Save a stashed copy of the given volume node into
     the passed list (could be undo or redo list)
     """
     if not self.enabled or not volumeNode or not volumeNode.GetImageData():
-      return
-    checkPointList.append( self.checkPoint(volumeNode) )
+      return checkPointList
+    checkPoint = self.checkPoint(volumeNode,self.stash)
+    if checkPoint.snapshot < 0:
+      return checkPointList
+    checkPointList.append( checkPoint )
     self.stateChangedCallback()
     if len(checkPointList) >= self.undoSize:
+      self.releaseCheckPoints( checkPointList[:1] )
       return( checkPointList[1:] )
     else:
       return( checkPointList )
 
+  def enforceMemoryBudget(self):
+    """ Internal helper function
+    Discard the oldest undo checkpoints until the stashed
+    bricks fit in the memory budget.
+    """
+    while len(self.undoList) > 1 and self.stash.GetStashedSize() > self.memoryBudget:
+      self.releaseCheckPoints( self.undoList[:1] )
+      self.undoList = self.undoList[1:]
+
   def saveState(self):
     """Called by effects as they modify the label volume node
     """
     # store current state onto undoList
     self.undoList = self.storeVolume( self.undoList, EditUtil.getLabelVolume() )
+    self.releaseCheckPoints( self.redoList )
     self.redoList = []
+    self.enforceMemoryBudget()
     self.stateChangedCallback()
 
   def undo(self):
@@ -598,6 +617,7 @@ class UndoRedo(object):
     self.redoList = self.storeVolume( self.redoList, EditUtil.getLabelVolume() )
     # get the checkPoint to restore and remove it from the list
     self.undoList[-1].restore()
+    self.releaseCheckPoints( self.undoList[-1:] )
     self.undoList = self.undoList[:-1]
     self.stateChangedCallback()
 
@@ -613,5 +633,7 @@ class UndoRedo(object):
     self.undoList = self.storeVolume( self.undoList, EditUtil.getLabelVolume() )
     # get the checkPoint to restore and remove it from the list
     self.redoList[-1].restore()
+    self.releaseCheckPoints( self.redoList[-1:] )
     self.redoList = self.redoList[:-1]
+    self.enforceMemoryBudget()
     self.stateChangedCallback()
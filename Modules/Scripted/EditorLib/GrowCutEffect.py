@@ -144,6 +144,9 @@ class GrowCutEffectLogic(Effect.EffectLogic):
 
   def __init__(self,sliceLogic):
     super(GrowCutEffectLogic,self).__init__(sliceLogic)
+    # the filter keeps the GrowCut state between two applies so that
+    # only the strokes added since the last apply are propagated
+    self.growCutFilter = None
 
   def getInvalidInputsMessage(self):
     background = self.getScopedBackground()
@@ -162,7 +165,9 @@ class GrowCutEffectLogic(Effect.EffectLogic):
     return True
 
   def growCut(self):
-    growCutFilter = vtkITK.vtkITKGrowCutSegmentationImageFilter()
+    if not self.growCutFilter:
+      self.growCutFilter = vtkITK.vtkITKIncrementalGrowCutSegmentationImageFilter()
+    growCutFilter = self.growCutFilter
     background = self.getScopedBackground()
     gestureInput = self.getScopedLabelInput()
     growCutOutput = self.getScopedLabelOutput()
@@ -170,26 +175,11 @@ class GrowCutEffectLogic(Effect.EffectLogic):
     if not self.areInputsValid():
       logging.warning(self.getInvalidInputsMessage())
 
-    # set the make a zero-valued volume for the output
-    # TODO: maybe this should be done in numpy as a one-liner
-    thresh = vtk.vtkImageThreshold()
-    thresh.ReplaceInOn()
-    thresh.ReplaceOutOn()
-    thresh.SetInValue(0)
-    thresh.SetOutValue(0)
-    thresh.SetOutputScalarType( vtk.VTK_SHORT )
-    thresh.SetInputData( gestureInput )
-    thresh.SetOutput( growCutOutput )
-    thresh.Update()
-    growCutOutput.DeepCopy( gestureInput )
-
     growCutFilter.SetInputData( 0, background )
     growCutFilter.SetInputData( 1, gestureInput )
-    growCutFilter.SetInputConnection( 2, thresh.GetOutputPort() )
 
     objectSize = 5. # TODO: this is a magic number
     contrastNoiseRatio = 0.8 # TODO: this is a magic number
-    priorStrength = 0.003 # TODO: this is a magic number
     segmented = 2 # TODO: this is a magic number
     conversion = 1000 # TODO: this is a magic number
 
@@ -203,7 +193,6 @@ class GrowCutEffectLogic(Effect.EffectLogic):
 
     growCutFilter.SetObjectSize( oSize )
     growCutFilter.SetContrastNoiseRatio( contrastNoiseRatio )
-    growCutFilter.SetPriorSegmentConfidence( priorStrength )
     growCutFilter.Update()
 
     growCutOutput.DeepCopy( growCutFilter.GetOutput() )
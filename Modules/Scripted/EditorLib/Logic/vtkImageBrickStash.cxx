@@ -0,0 +1,608 @@
+/*=auto=========================================================================
+
+  Portions (c) Copyright 2005 Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+=========================================================================auto=*/
+
+#include "vtkImageBrickStash.h"
+
+// VTK includes
+#include <vtkDataArray.h>
+#include <vtkImageData.h>
+#include <vtkMultiThreader.h>
+#include <vtkObjectFactory.h>
+#include <vtkPointData.h>
+#include <vtkSmartPointer.h>
+#include <vtkUnsignedCharArray.h>
+#include <vtkZLibDataCompressor.h>
+
+// STD includes
+#include <algorithm>
+#include <cstring>
+#include <map>
+#include <vector>
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+// Compressed content of a brick, shared by all the snapshots it belongs to.
+struct Brick
+{
+  Brick() : ReferenceCount(0) {}
+  std::vector<unsigned char> CompressedData;
+  int ReferenceCount;
+};
+typedef std::map<vtkTypeUInt64, Brick> BrickMapType;
+
+//----------------------------------------------------------------------------
+struct Snapshot
+{
+  int Extent[6];
+  double Origin[3];
+  double Spacing[3];
+  int ScalarType;
+  int NumberOfComponents;
+  int BrickDimensions[3];
+  /// Hash of the content of each brick, x fastest.
+  std::vector<vtkTypeUInt64> BrickHashes;
+};
+
+//----------------------------------------------------------------------------
+// Split the scalars of an image into bricks, x fastest. Bricks on the
+// upper boundaries of the image can be smaller than BrickDimensions.
+class BrickGrid
+{
+public:
+  BrickGrid(const int dimensions[3], const int brickDimensions[3],
+            int voxelSize, unsigned char* scalars)
+    : VoxelSize(voxelSize), Scalars(scalars)
+  {
+    for (int i = 0; i < 3; ++i)
+      {
+      this->Dimensions[i] = dimensions[i];
+      this->BrickDimensions[i] = brickDimensions[i];
+      this->NumberOfBricks[i] =
+        (dimensions[i] + brickDimensions[i] - 1) / brickDimensions[i];
+      }
+  }
+
+  vtkIdType GetNumberOfBricks()const
+  {
+    return static_cast<vtkIdType>(this->NumberOfBricks[0]) *
+      this->NumberOfBricks[1] * this->NumberOfBricks[2];
+  }
+
+  size_t GetMaximumBrickSize()const
+  {
+    return static_cast<size_t>(this->BrickDimensions[0]) *
+      this->BrickDimensions[1] * this->BrickDimensions[2] * this->VoxelSize;
+  }
+
+  /// Copy the voxels of \a brick into \a buffer, return the number of bytes
+  /// copied.
+  size_t Gather(vtkIdType brick, unsigned char* buffer)const
+  {
+    return this->Copy(brick, buffer, true);
+  }
+
+  /// Copy \a buffer into the voxels of \a brick, return the number of bytes
+  /// copied.
+  size_t Scatter(vtkIdType brick, unsigned char* buffer)const
+  {
+    return this->Copy(brick, buffer, false);
+  }
+
+  /// Size in bytes of \a brick.
+  size_t GetBrickSize(vtkIdType brick)const
+  {
+    int min[3], max[3];
+    this->GetBrickBounds(brick, min, max);
+    return static_cast<size_t>(max[0] - min[0]) *
+      (max[1] - min[1]) * (max[2] - min[2]) * this->VoxelSize;
+  }
+
+protected:
+  /// Voxel indices of \a brick, from \a min included to \a max excluded.
+  void GetBrickBounds(vtkIdType brick, int min[3], int max[3])const
+  {
+    vtkIdType index[3];
+    index[0] = brick % this->NumberOfBricks[0];
+    index[1] = (brick / this->NumberOfBricks[0]) % this->NumberOfBricks[1];
+    index[2] = brick / (static_cast<vtkIdType>(this->NumberOfBricks[0]) *
+                        this->NumberOfBricks[1]);
+    for (int i = 0; i < 3; ++i)
+      {
+      min[i] = static_cast<int>(index[i]) * this->BrickDimensions[i];
+      max[i] = std::min(min[i] + this->BrickDimensions[i], this->Dimensions[i]);
+      }
+  }
+
+  size_t Copy(vtkIdType brick, unsigned char* buffer, bool gather)const
+  {
+    int min[3], max[3];
+    this->GetBrickBounds(brick, min, max);
+    const size_t rowSize = static_cast<size_t>(max[0] - min[0]) * this->VoxelSize;
+    unsigned char* bufferPtr = buffer;
+    for (int k = min[2]; k < max[2]; ++k)
+      {
+      for (int j = min[1]; j < max[1]; ++j)
+        {
+        unsigned char* rowPtr = this->Scalars +
+          ((static_cast<size_t>(k) * this->Dimensions[1] + j) *
+           this->Dimensions[0] + min[0]) * this->VoxelSize;
+        if (gather)
+          {
+          memcpy(bufferPtr, rowPtr, rowSize);
+          }
+        else
+          {
+          memcpy(rowPtr, bufferPtr, rowSize);
+          }
+        bufferPtr += rowSize;
+        }
+      }
+    return static_cast<size_t>(bufferPtr - buffer);
+  }
+
+  int Dimensions[3];
+  int BrickDimensions[3];
+  int NumberOfBricks[3];
+  int VoxelSize;
+  unsigned char* Scalars;
+};
+
+//----------------------------------------------------------------------------
+// 64 bits hash of the content of a brick (MurmurHash64A).
+vtkTypeUInt64 HashBrick(const unsigned char* data, size_t length)
+{
+  const vtkTypeUInt64 m = 0xc6a4a7935bd1e995ULL;
+  const int r = 47;
+  vtkTypeUInt64 h = 0x8445d61a4e774912ULL ^ (static_cast<vtkTypeUInt64>(length) * m);
+  const unsigned char* end = data + (length / 8) * 8;
+  for (; data != end; data += 8)
+    {
+    vtkTypeUInt64 k;
+    memcpy(&k, data, 8);
+    k *= m;
+    k ^= k >> r;
+    k *= m;
+    h ^= k;
+    h *= m;
+    }
+  switch (length & 7)
+    {
+    case 7: h ^= static_cast<vtkTypeUInt64>(data[6]) << 48;
+    case 6: h ^= static_cast<vtkTypeUInt64>(data[5]) << 40;
+    case 5: h ^= static_cast<vtkTypeUInt64>(data[4]) << 32;
+    case 4: h ^= static_cast<vtkTypeUInt64>(data[3]) << 24;
+    case 3: h ^= static_cast<vtkTypeUInt64>(data[2]) << 16;
+    case 2: h ^= static_cast<vtkTypeUInt64>(data[1]) << 8;
+    case 1: h ^= static_cast<vtkTypeUInt64>(data[0]);
+      h *= m;
+    }
+  h ^= h >> r;
+  h *= m;
+  h ^= h >> r;
+  return h;
+}
+
+//----------------------------------------------------------------------------
+struct vtkImageBrickStashThreadStruct
+{
+  const BrickGrid* Grid;
+  const BrickMapType* Bricks;
+  std::vector<vtkSmartPointer<vtkZLibDataCompressor> > Compressors;
+  /// Hashes of the bricks of the image (stash) or of the snapshot (unstash).
+  std::vector<vtkTypeUInt64>* BrickHashes;
+  /// Stash: compressed content of the bricks not found in Bricks.
+  std::vector<std::vector<unsigned char> >* NewBricks;
+  /// Unstash: if true, only the bricks that differ from the image are
+  /// restored, otherwise all the bricks are restored.
+  bool RestoreModifiedBricksOnly;
+  /// Unstash: number of restored bricks and of failures, per thread.
+  std::vector<vtkIdType> NumberOfRestoredBricks;
+  std::vector<vtkIdType> NumberOfFailures;
+};
+
+//----------------------------------------------------------------------------
+void GetThreadBrickRange(vtkMultiThreader::ThreadInfo* info, const BrickGrid* grid,
+                         vtkIdType& begin, vtkIdType& end)
+{
+  const vtkIdType numberOfBricks = grid->GetNumberOfBricks();
+  begin = numberOfBricks * info->ThreadID / info->NumberOfThreads;
+  end = numberOfBricks * (info->ThreadID + 1) / info->NumberOfThreads;
+}
+
+//----------------------------------------------------------------------------
+VTK_THREAD_RETURN_TYPE vtkImageBrickStashStashThreadedExecute(void* arg)
+{
+  vtkMultiThreader::ThreadInfo* info =
+    static_cast<vtkMultiThreader::ThreadInfo*>(arg);
+  vtkImageBrickStashThreadStruct* str =
+    static_cast<vtkImageBrickStashThreadStruct*>(info->UserData);
+  vtkIdType begin, end;
+  GetThreadBrickRange(info, str->Grid, begin, end);
+  if (begin >= end)
+    {
+    return VTK_THREAD_RETURN_VALUE;
+    }
+  vtkZLibDataCompressor* compressor = str->Compressors[info->ThreadID];
+  std::vector<unsigned char> buffer(str->Grid->GetMaximumBrickSize());
+  for (vtkIdType brick = begin; brick < end; ++brick)
+    {
+    const size_t size = str->Grid->Gather(brick, &buffer[0]);
+    const vtkTypeUInt64 hash = HashBrick(&buffer[0], size);
+    (*str->BrickHashes)[brick] = hash;
+    // Unmodified bricks are already stored
+    if (str->Bricks->find(hash) != str->Bricks->end())
+      {
+      continue;
+      }
+    vtkUnsignedCharArray* compressedData = compressor->Compress(&buffer[0], size);
+    if (compressedData)
+      {
+      const unsigned char* compressedPtr = compressedData->GetPointer(0);
+      (*str->NewBricks)[brick].assign(
+        compressedPtr, compressedPtr + compressedData->GetNumberOfTuples());
+      compressedData->Delete();
+      }
+    }
+  return VTK_THREAD_RETURN_VALUE;
+}
+
+//----------------------------------------------------------------------------
+VTK_THREAD_RETURN_TYPE vtkImageBrickStashUnstashThreadedExecute(void* arg)
+{
+  vtkMultiThreader::ThreadInfo* info =
+    static_cast<vtkMultiThreader::ThreadInfo*>(arg);
+  vtkImageBrickStashThreadStruct* str =
+    static_cast<vtkImageBrickStashThreadStruct*>(info->UserData);
+  vtkIdType begin, end;
+  GetThreadBrickRange(info, str->Grid, begin, end);
+  if (begin >= end)
+    {
+    return VTK_THREAD_RETURN_VALUE;
+    }
+  vtkZLibDataCompressor* compressor = str->Compressors[info->ThreadID];
+  std::vector<unsigned char> buffer(str->Grid->GetMaximumBrickSize());
+  for (vtkIdType brick = begin; brick < end; ++brick)
+    {
+    const vtkTypeUInt64 hash = (*str->BrickHashes)[brick];
+    if (str->RestoreModifiedBricksOnly)
+      {
+      const size_t size = str->Grid->Gather(brick, &buffer[0]);
+      if (HashBrick(&buffer[0], size) == hash)
+        {
+        continue;
+        }
+      }
+    BrickMapType::const_iterator brickIt = str->Bricks->find(hash);
+    const size_t size = str->Grid->GetBrickSize(brick);
+    if (brickIt == str->Bricks->end() ||
+        compressor->Uncompress(&brickIt->second.CompressedData[0],
+                               brickIt->second.CompressedData.size(),
+                               &buffer[0], size) != size)
+      {
+      ++str->NumberOfFailures[info->ThreadID];
+      continue;
+      }
+    str->Grid->Scatter(brick, &buffer[0]);
+    ++str->NumberOfRestoredBricks[info->ThreadID];
+    }
+  return VTK_THREAD_RETURN_VALUE;
+}
+
+} // end anonymous namespace
+
+//----------------------------------------------------------------------------
+class vtkImageBrickStash::vtkInternal
+{
+public:
+  vtkInternal();
+
+  /// Decrement the reference count of a brick and release it if it is not
+  /// used anymore.
+  void ReleaseBrick(vtkTypeUInt64 hash);
+
+  BrickMapType Bricks;
+  std::map<int, Snapshot> Snapshots;
+  int NextSnapshotId;
+  vtkIdType StashedSize;
+};
+
+//----------------------------------------------------------------------------
+vtkImageBrickStash::vtkInternal::vtkInternal()
+{
+  this->NextSnapshotId = 0;
+  this->StashedSize = 0;
+}
+
+//----------------------------------------------------------------------------
+void vtkImageBrickStash::vtkInternal::ReleaseBrick(vtkTypeUInt64 hash)
+{
+  BrickMapType::iterator brickIt = this->Bricks.find(hash);
+  if (brickIt == this->Bricks.end())
+    {
+    return;
+    }
+  if (--brickIt->second.ReferenceCount <= 0)
+    {
+    this->StashedSize -= static_cast<vtkIdType>(brickIt->second.CompressedData.size());
+    this->Bricks.erase(brickIt);
+    }
+}
+
+//----------------------------------------------------------------------------
+vtkStandardNewMacro(vtkImageBrickStash);
+
+//----------------------------------------------------------------------------
+vtkImageBrickStash::vtkImageBrickStash()
+{
+  this->BrickDimensions[0] = 32;
+  this->BrickDimensions[1] = 32;
+  this->BrickDimensions[2] = 32;
+  this->CompressionLevel = 1; // corresponds to Z_BEST_SPEED
+  this->NumberOfThreads = 0;
+  this->Internal = new vtkInternal;
+}
+
+//----------------------------------------------------------------------------
+vtkImageBrickStash::~vtkImageBrickStash()
+{
+  delete this->Internal;
+}
+
+//----------------------------------------------------------------------------
+int vtkImageBrickStash::GetNumberOfThreadsToUse()const
+{
+  return this->NumberOfThreads > 0 ?
+    this->NumberOfThreads : vtkMultiThreader::GetGlobalDefaultNumberOfThreads();
+}
+
+//----------------------------------------------------------------------------
+int vtkImageBrickStash::Stash(vtkImageData* image)
+{
+  if (!image)
+    {
+    vtkErrorMacro("Cannot stash - no image data");
+    return -1;
+    }
+  vtkDataArray* scalars = image->GetPointData()->GetScalars();
+  if (!scalars)
+    {
+    vtkErrorMacro("Cannot stash - image has no scalars");
+    return -1;
+    }
+  int dimensions[3];
+  image->GetDimensions(dimensions);
+  if (scalars->GetNumberOfTuples() !=
+      static_cast<vtkIdType>(dimensions[0]) * dimensions[1] * dimensions[2])
+    {
+    vtkErrorMacro("Cannot stash - scalars don't match the image dimensions");
+    return -1;
+    }
+
+  Snapshot snapshot;
+  image->GetExtent(snapshot.Extent);
+  image->GetOrigin(snapshot.Origin);
+  image->GetSpacing(snapshot.Spacing);
+  snapshot.ScalarType = scalars->GetDataType();
+  snapshot.NumberOfComponents = scalars->GetNumberOfComponents();
+  for (int i = 0; i < 3; ++i)
+    {
+    snapshot.BrickDimensions[i] = std::max(1,
+      std::min(this->BrickDimensions[i], dimensions[i]));
+    }
+  BrickGrid grid(dimensions, snapshot.BrickDimensions,
+                 scalars->GetDataTypeSize() * snapshot.NumberOfComponents,
+                 static_cast<unsigned char*>(scalars->GetVoidPointer(0)));
+  const vtkIdType numberOfBricks = grid.GetNumberOfBricks();
+  snapshot.BrickHashes.resize(numberOfBricks);
+  std::vector<std::vector<unsigned char> > newBricks(numberOfBricks);
+
+  // Hash all the bricks and compress the ones that are not stored yet
+  vtkImageBrickStashThreadStruct str;
+  str.Grid = &grid;
+  str.Bricks = &this->Internal->Bricks;
+  str.BrickHashes = &snapshot.BrickHashes;
+  str.NewBricks = &newBricks;
+  str.RestoreModifiedBricksOnly = false;
+  const int numberOfThreads = static_cast<int>(std::max(static_cast<vtkIdType>(1),
+    std::min(static_cast<vtkIdType>(this->GetNumberOfThreadsToUse()), numberOfBricks)));
+  for (int thread = 0; thread < numberOfThreads; ++thread)
+    {
+    vtkSmartPointer<vtkZLibDataCompressor> compressor =
+      vtkSmartPointer<vtkZLibDataCompressor>::New();
+    compressor->SetCompressionLevel(this->CompressionLevel);
+    str.Compressors.push_back(compressor);
+    }
+  vtkMultiThreader* threader = vtkMultiThreader::New();
+  threader->SetNumberOfThreads(numberOfThreads);
+  threader->SetSingleMethod(vtkImageBrickStashStashThreadedExecute, &str);
+  threader->SingleMethodExecute();
+  threader->Delete();
+
+  // Store the new bricks and reference all of them
+  for (vtkIdType brick = 0; brick < numberOfBricks; ++brick)
+    {
+    const vtkTypeUInt64 hash = snapshot.BrickHashes[brick];
+    BrickMapType::iterator brickIt = this->Internal->Bricks.find(hash);
+    if (brickIt == this->Internal->Bricks.end())
+      {
+      if (newBricks[brick].empty())
+        {
+        vtkErrorMacro("Cannot stash - failed to compress brick " << brick);
+        for (vtkIdType storedBrick = 0; storedBrick < brick; ++storedBrick)
+          {
+          this->Internal->ReleaseBrick(snapshot.BrickHashes[storedBrick]);
+          }
+        return -1;
+        }
+      brickIt = this->Internal->Bricks.insert(
+        BrickMapType::value_type(hash, Brick())).first;
+      brickIt->second.CompressedData.swap(newBricks[brick]);
+      this->Internal->StashedSize +=
+        static_cast<vtkIdType>(brickIt->second.CompressedData.size());
+      }
+    ++brickIt->second.ReferenceCount;
+    }
+
+  const int snapshotId = this->Internal->NextSnapshotId++;
+  Snapshot& storedSnapshot = this->Internal->Snapshots[snapshotId];
+  storedSnapshot = snapshot;
+  return snapshotId;
+}
+
+//----------------------------------------------------------------------------
+bool vtkImageBrickStash::Unstash(int snapshotId, vtkImageData* image)
+{
+  std::map<int, Snapshot>::iterator snapshotIt =
+    this->Internal->Snapshots.find(snapshotId);
+  if (snapshotIt == this->Internal->Snapshots.end())
+    {
+    vtkErrorMacro("Cannot unstash - no snapshot " << snapshotId);
+    return false;
+    }
+  if (!image)
+    {
+    vtkErrorMacro("Cannot unstash - no image data");
+    return false;
+    }
+  Snapshot& snapshot = snapshotIt->second;
+
+  // Only the modified bricks need to be restored if the image has the same
+  // layout as the snapshot.
+  int extent[6];
+  image->GetExtent(extent);
+  int dimensions[3];
+  image->GetDimensions(dimensions);
+  vtkDataArray* scalars = image->GetPointData()->GetScalars();
+  bool sameLayout = scalars &&
+    std::equal(extent, extent + 6, snapshot.Extent) &&
+    scalars->GetDataType() == snapshot.ScalarType &&
+    scalars->GetNumberOfComponents() == snapshot.NumberOfComponents &&
+    scalars->GetNumberOfTuples() ==
+      static_cast<vtkIdType>(dimensions[0]) * dimensions[1] * dimensions[2];
+  if (!sameLayout)
+    {
+    image->SetExtent(snapshot.Extent);
+    image->AllocateScalars(snapshot.ScalarType, snapshot.NumberOfComponents);
+    image->GetDimensions(dimensions);
+    scalars = image->GetPointData()->GetScalars();
+    }
+  image->SetOrigin(snapshot.Origin);
+  image->SetSpacing(snapshot.Spacing);
+
+  BrickGrid grid(dimensions, snapshot.BrickDimensions,
+                 scalars->GetDataTypeSize() * snapshot.NumberOfComponents,
+                 static_cast<unsigned char*>(scalars->GetVoidPointer(0)));
+  const vtkIdType numberOfBricks = grid.GetNumberOfBricks();
+
+  vtkImageBrickStashThreadStruct str;
+  str.Grid = &grid;
+  str.Bricks = &this->Internal->Bricks;
+  str.BrickHashes = &snapshot.BrickHashes;
+  str.NewBricks = 0;
+  str.RestoreModifiedBricksOnly = sameLayout;
+  const int numberOfThreads = static_cast<int>(std::max(static_cast<vtkIdType>(1),
+    std::min(static_cast<vtkIdType>(this->GetNumberOfThreadsToUse()), numberOfBricks)));
+  for (int thread = 0; thread < numberOfThreads; ++thread)
+    {
+    str.Compressors.push_back(vtkSmartPointer<vtkZLibDataCompressor>::New());
+    }
+  str.NumberOfRestoredBricks.resize(numberOfThreads, 0);
+  str.NumberOfFailures.resize(numberOfThreads, 0);
+  vtkMultiThreader* threader = vtkMultiThreader::New();
+  threader->SetNumberOfThreads(numberOfThreads);
+  threader->SetSingleMethod(vtkImageBrickStashUnstashThreadedExecute, &str);
+  threader->SingleMethodExecute();
+  threader->Delete();
+
+  vtkIdType numberOfRestoredBricks = 0;
+  vtkIdType numberOfFailures = 0;
+  for (int thread = 0; thread < numberOfThreads; ++thread)
+    {
+    numberOfRestoredBricks += str.NumberOfRestoredBricks[thread];
+    numberOfFailures += str.NumberOfFailures[thread];
+    }
+  if (numberOfRestoredBricks > 0)
+    {
+    scalars->Modified();
+    image->Modified();
+    }
+  if (numberOfFailures > 0)
+    {
+    vtkErrorMacro("Cannot unstash - failed to uncompress "
+                  << numberOfFailures << " bricks");
+    return false;
+    }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+void vtkImageBrickStash::RemoveSnapshot(int snapshotId)
+{
+  std::map<int, Snapshot>::iterator snapshotIt =
+    this->Internal->Snapshots.find(snapshotId);
+  if (snapshotIt == this->Internal->Snapshots.end())
+    {
+    return;
+    }
+  const std::vector<vtkTypeUInt64>& hashes = snapshotIt->second.BrickHashes;
+  for (size_t brick = 0; brick < hashes.size(); ++brick)
+    {
+    this->Internal->ReleaseBrick(hashes[brick]);
+    }
+  this->Internal->Snapshots.erase(snapshotIt);
+}
+
+//----------------------------------------------------------------------------
+void vtkImageBrickStash::RemoveAllSnapshots()
+{
+  this->Internal->Snapshots.clear();
+  this->Internal->Bricks.clear();
+  this->Internal->StashedSize = 0;
+}
+
+//----------------------------------------------------------------------------
+int vtkImageBrickStash::GetNumberOfSnapshots()
+{
+  return static_cast<int>(this->Internal->Snapshots.size());
+}
+
+//----------------------------------------------------------------------------
+bool vtkImageBrickStash::HasSnapshot(int snapshotId)
+{
+  return this->Internal->Snapshots.find(snapshotId) !=
+    this->Internal->Snapshots.end();
+}
+
+//----------------------------------------------------------------------------
+vtkIdType vtkImageBrickStash::GetNumberOfStashedBricks()
+{
+  return static_cast<vtkIdType>(this->Internal->Bricks.size());
+}
+
+//----------------------------------------------------------------------------
+vtkIdType vtkImageBrickStash::GetStashedSize()
+{
+  return this->Internal->StashedSize;
+}
+
+//----------------------------------------------------------------------------
+void vtkImageBrickStash::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os,indent);
+
+  os << indent << "BrickDimensions: " << this->BrickDimensions[0] << " "
+     << this->BrickDimensions[1] << " " << this->BrickDimensions[2] << "\n";
+  os << indent << "CompressionLevel: " << this->CompressionLevel << "\n";
+  os << indent << "NumberOfThreads: " << this->NumberOfThreads << "\n";
+  os << indent << "NumberOfSnapshots: " << this->Internal->Snapshots.size() << "\n";
+  os << indent << "NumberOfStashedBricks: " << this->Internal->Bricks.size() << "\n";
+  os << indent << "StashedSize: " << this->Internal->StashedSize << "\n";
+}
@@ -0,0 +1,104 @@
+/*=auto=========================================================================
+
+  Portions (c) Copyright 2005 Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+=========================================================================auto=*/
+///  vtkImageBrickStash - Store snapshots of images as shared compressed bricks
+///
+/// vtkImageBrickStash stores snapshots of the scalars of images (e.g. the
+/// undo/redo states of a label map) in a compressed form. Each image is split
+/// into bricks of BrickDimensions voxels. A brick is identified by a hash of
+/// its content and is compressed and stored only once, whatever the number of
+/// snapshots (or bricks of a snapshot) it belongs to. When an edit only
+/// modifies a few bricks of an image, taking a new snapshot only compresses
+/// and stores these bricks, and restoring a snapshot only decompresses the
+/// bricks that differ from the image.
+/// The bricks are hashed, compressed and decompressed by multiple threads.
+///
+/// \sa vtkImageStash
+
+#ifndef __vtkImageBrickStash_h
+#define __vtkImageBrickStash_h
+
+#include "vtkSlicerEditorLibModuleLogicExport.h"
+
+// VTK includes
+#include <vtkObject.h>
+class vtkImageData;
+
+class VTK_SLICER_EDITORLIB_MODULE_LOGIC_EXPORT vtkImageBrickStash : public vtkObject
+{
+public:
+  static vtkImageBrickStash *New();
+  vtkTypeMacro(vtkImageBrickStash,vtkObject);
+  void PrintSelf(ostream& os, vtkIndent indent);
+
+  ///
+  /// Dimensions of the bricks the images are split into.
+  /// Smaller bricks store smaller differences but cost more bookkeeping.
+  /// 32x32x32 by default. It only applies to the next calls to Stash.
+  vtkSetVector3Macro(BrickDimensions, int);
+  vtkGetVector3Macro(BrickDimensions, int);
+
+  // Description:
+  // Get/Set the compression level.
+  vtkSetClampMacro(CompressionLevel, int, 0, 9);
+  vtkGetMacro(CompressionLevel, int);
+
+  ///
+  /// Number of threads used to hash, compress and decompress the bricks.
+  /// If 0 (default), vtkMultiThreader::GetGlobalDefaultNumberOfThreads()
+  /// is used.
+  vtkSetMacro(NumberOfThreads, int);
+  vtkGetMacro(NumberOfThreads, int);
+
+  ///
+  /// Store a snapshot of the scalars (and geometry) of \a image.
+  /// Return the identifier of the snapshot or -1 on failure.
+  int Stash(vtkImageData* image);
+
+  ///
+  /// Restore the snapshot \a snapshotId into \a image. Only the bricks that
+  /// differ from the snapshot are decompressed, unless the extent or the
+  /// scalar type of \a image differs from the snapshot.
+  /// Return false if there is no such snapshot.
+  bool Unstash(int snapshotId, vtkImageData* image);
+
+  ///
+  /// Remove a snapshot. The bricks only used by this snapshot are released.
+  void RemoveSnapshot(int snapshotId);
+  void RemoveAllSnapshots();
+
+  int GetNumberOfSnapshots();
+  bool HasSnapshot(int snapshotId);
+
+  ///
+  /// Number of distinct bricks stored for all the snapshots.
+  vtkIdType GetNumberOfStashedBricks();
+
+  ///
+  /// Memory used by the compressed bricks of all the snapshots, in bytes.
+  vtkIdType GetStashedSize();
+
+protected:
+  vtkImageBrickStash();
+  ~vtkImageBrickStash();
+
+  int GetNumberOfThreadsToUse()const;
+
+  int BrickDimensions[3];
+  int CompressionLevel;
+  int NumberOfThreads;
+
+  class vtkInternal;
+  vtkInternal* Internal;
+
+private:
+  vtkImageBrickStash(const vtkImageBrickStash&);  /// Not implemented.
+  void operator=(const vtkImageBrickStash&);  /// Not implemented.
+};
+
+#endif
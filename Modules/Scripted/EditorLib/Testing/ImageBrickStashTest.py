@@ -0,0 +1,140 @@
+import unittest
+import vtk
+import slicer
+
+class ImageBrickStashTesting(unittest.TestCase):
+  def setUp(self):
+    pass
+
+  def runTest(self):
+    self.test_ImageBrickStash()
+
+  def createLabelMap(self):
+    image = vtk.vtkImageData()
+    image.SetDimensions(64, 48, 32)
+    image.AllocateScalars(vtk.VTK_SHORT, 1)
+    image.GetPointData().GetScalars().Fill(0)
+    return image
+
+  def paint(self, image, value, extent):
+    for k in range(extent[4], extent[5] + 1):
+      for j in range(extent[2], extent[3] + 1):
+        for i in range(extent[0], extent[1] + 1):
+          image.SetScalarComponentFromDouble(i, j, k, 0, value)
+    image.Modified()
+
+  def assertImagesEqual(self, image1, image2):
+    scalars1 = image1.GetPointData().GetScalars()
+    scalars2 = image2.GetPointData().GetScalars()
+    self.assertEqual(image1.GetDimensions(), image2.GetDimensions())
+    for component in range(scalars1.GetNumberOfComponents()):
+      self.assertEqual(scalars1.GetRange(component), scalars2.GetRange(component))
+    difference = vtk.vtkImageMathematics()
+    difference.SetOperationToSubtract()
+    difference.SetInput1Data(image1)
+    difference.SetInput2Data(image2)
+    difference.Update()
+    self.assertEqual(difference.GetOutput().GetScalarRange(), (0.0, 0.0))
+
+  def test_ImageBrickStash(self):
+    """
+    Check that snapshots share their unmodified bricks and are
+    restored exactly.
+    """
+    stash = slicer.vtkImageBrickStash()
+    stash.SetBrickDimensions(16, 16, 16)
+    image = self.createLabelMap()
+
+    # All the bricks of an empty label map are identical
+    emptySnapshot = stash.Stash(image)
+    self.assertEqual(emptySnapshot, 0)
+    self.assertEqual(stash.GetNumberOfStashedBricks(), 1)
+
+    # A paint stroke only adds the modified bricks
+    self.paint(image, 1, (2, 5, 2, 5, 2, 5))
+    stroke1 = vtk.vtkImageData()
+    stroke1.DeepCopy(image)
+    stroke1Snapshot = stash.Stash(image)
+    self.assertEqual(stash.GetNumberOfStashedBricks(), 2)
+    self.paint(image, 2, (20, 23, 20, 23, 20, 23))
+    stroke2Size = stash.GetStashedSize()
+    stroke2Snapshot = stash.Stash(image)
+    self.assertEqual(stash.GetNumberOfStashedBricks(), 3)
+    self.assertTrue(stash.GetStashedSize() > stroke2Size)
+
+    # Restore the snapshots
+    self.assertTrue(stash.Unstash(stroke1Snapshot, image))
+    self.assertImagesEqual(image, stroke1)
+    self.assertTrue(stash.Unstash(emptySnapshot, image))
+    self.assertEqual(image.GetScalarRange(), (0.0, 0.0))
+
+    # into an image with a different layout
+    otherImage = vtk.vtkImageData()
+    self.assertTrue(stash.Unstash(stroke1Snapshot, otherImage))
+    self.assertImagesEqual(otherImage, stroke1)
+
+    # Removing a snapshot releases the bricks it is the only one to use
+    stash.RemoveSnapshot(stroke2Snapshot)
+    self.assertFalse(stash.HasSnapshot(stroke2Snapshot))
+    self.assertEqual(stash.GetNumberOfStashedBricks(), 2)
+    self.assertFalse(stash.Unstash(stroke2Snapshot, image))
+    stash.RemoveAllSnapshots()
+    self.assertEqual(stash.GetNumberOfSnapshots(), 0)
+    self.assertEqual(stash.GetStashedSize(), 0)
+
+#
+# ImageBrickStashTest
+#
+
+class ImageBrickStashTest:
+  """
+  This class is the 'hook' for slicer to detect and recognize the test
+  as a loadable scripted module (with a hidden interface)
+  """
+  def __init__(self, parent):
+    parent.title = "ImageBrickStashTest"
+    parent.categories = ["Testing"]
+    parent.contributors = ["Slicer developers"]
+    parent.helpText = """
+    Self test for the vtkImageBrickStash undo/redo storage of the editor.
+    No module interface here, only used in SelfTests module
+    """
+    parent.acknowledgementText = """
+    This test was developed as part of the editor undo/redo work
+    """
+
+    # don't show this module
+    parent.hidden = True
+
+    # Add this test to the SelfTest module's list for discovery when the module
+    # is created.  Since this module may be discovered before SelfTests itself,
+    # create the list if it doesn't already exist.
+    try:
+      slicer.selfTests
+    except AttributeError:
+      slicer.selfTests = {}
+    slicer.selfTests['ImageBrickStashTest'] = self.runTest
+
+  def runTest(self):
+    tester = ImageBrickStashTesting()
+    tester.setUp()
+    tester.runTest()
+
+
+#
+# ImageBrickStashTestWidget
+#
+
+class ImageBrickStashTestWidget:
+  def __init__(self, parent = None):
+    self.parent = parent
+
+  def setup(self):
+    # don't display anything for this widget - it will be hidden anyway
+    pass
+
+  def enter(self):
+    pass
+
+  def exit(self):
+    pass